@@ -43,7 +43,7 @@ set "LIB_PATH=%PKG_PATH%\x64"
 
 REM --- 4. COMPILATION ---
 call :Log "INFO" "Cyan" "Compilando App.exe..."
-cl.exe /nologo /EHsc /std:c++17 /D_UNICODE /DUNICODE /I "%INC_PATH%" ^
+cl.exe /nologo /EHsc /std:c++17 /O2 /DNDEBUG /D_UNICODE /DUNICODE /I "%INC_PATH%" ^
     /Fo"%OBJ_DIR%\\" /Fe"%OUT_DIR%\App.exe" "%SRC_FILE%" ^
     /link /LIBPATH:"%LIB_PATH%" WebView2Loader.dll.lib user32.lib gdi32.lib shlwapi.lib shell32.lib ole32.lib comdlg32.lib psapi.lib
 
@@ -60,6 +60,50 @@ if exist "icons" xcopy /E /I /Y "icons" "%OUT_DIR%\icons" >nul 2>&1
 if exist "source" xcopy /E /I /Y "source" "%OUT_DIR%\source" >nul 2>&1
 if exist "public" xcopy /E /I /Y "public" "%OUT_DIR%\public" >nul 2>&1
 
+REM --- 5.0 TEXTURAS REEMPAQUETADAS ---
+call :Log "INFO" "Cyan" "Reempaquetando texturas de escenarios y personajes..."
+cl.exe /nologo /EHsc /std:c++17 /O2 /Fo"%OBJ_DIR%\\" /Fe"%OBJ_DIR%\atlaspack.exe" "source\resource\tools\atlaspack.cpp" >nul
+if %ERRORLEVEL% NEQ 0 ( call :Log "WARNING" "Yellow" "No se pudo compilar atlaspack. Se usaran las texturas originales." & goto :RepackFin )
+"%OBJ_DIR%\atlaspack.exe" --stages "%OUT_DIR%\public"
+if %ERRORLEVEL% NEQ 0 call :Log "WARNING" "Yellow" "Algunos escenarios no se reempaquetaron. Esos usan sus texturas sueltas."
+"%OBJ_DIR%\atlaspack.exe" --sheets "public\images\characters" "%OUT_DIR%\public\images\characters"
+if %ERRORLEVEL% NEQ 0 call :Log "WARNING" "Yellow" "Algunos personajes no se reempaquetaron. Esos conservan su textura."
+:RepackFin
+
+REM --- 5.1 ATLAS COMPILADOS ---
+call :Log "INFO" "Cyan" "Compilando atlas (Sparrow XML / spritemap -> .gatl)..."
+cl.exe /nologo /EHsc /std:c++17 /O2 /Fo"%OBJ_DIR%\\" /Fe"%OBJ_DIR%\atlasc.exe" "source\resource\tools\atlasc.cpp" >nul
+if %ERRORLEVEL% NEQ 0 ( call :Log "WARNING" "Yellow" "No se pudo compilar atlasc. Se usaran los XML." & goto :AtlasFin )
+"%OBJ_DIR%\atlasc.exe" --dir "%OUT_DIR%\public" --verify
+if %ERRORLEVEL% NEQ 0 call :Log "WARNING" "Yellow" "Algunos atlas no se compilaron. Esos se cargaran como XML."
+:AtlasFin
+
+REM --- 5.1a ANIMACIONES DE ADOBE ANIMATE HORNEADAS ---
+call :Log "INFO" "Cyan" "Horneando animaciones de Animate (Animation.json -> .ganm)..."
+cl.exe /nologo /EHsc /std:c++17 /O2 /Fo"%OBJ_DIR%\\" /Fe"%OBJ_DIR%\animbake.exe" "source\resource\tools\animbake.cpp" >nul
+if %ERRORLEVEL% NEQ 0 ( call :Log "WARNING" "Yellow" "No se pudo compilar animbake. Las animaciones de Animate no se reproduciran." & goto :AnimFin )
+"%OBJ_DIR%\animbake.exe" --dir "%OUT_DIR%\public"
+if %ERRORLEVEL% NEQ 0 call :Log "WARNING" "Yellow" "Algunas animaciones no se hornearon. Esas no se reproduciran."
+:AnimFin
+
+REM --- 5.1b TEXTURAS COMPRIMIDAS PARA LA GPU ---
+call :Log "INFO" "Cyan" "Comprimiendo texturas de atlas (PNG -> BC7 / ETC2 .ktx2)..."
+cl.exe /nologo /EHsc /std:c++17 /O2 /Fo"%OBJ_DIR%\\" /Fe"%OBJ_DIR%\ktxc.exe" "source\resource\tools\ktxc.cpp" >nul
+if %ERRORLEVEL% NEQ 0 ( call :Log "WARNING" "Yellow" "No se pudo compilar ktxc. Se subiran los PNG." & goto :KtxFin )
+"%OBJ_DIR%\ktxc.exe" --dir "%OUT_DIR%\public"
+if %ERRORLEVEL% NEQ 0 call :Log "WARNING" "Yellow" "Algunas texturas no se comprimieron. Esas se suben como PNG."
+:KtxFin
+
+REM --- 5.2 PAQUETE DE ASSETS ---
+call :Log "INFO" "Cyan" "Empaquetando public en assets.gpak..."
+cl.exe /nologo /EHsc /std:c++17 /O2 /Fo"%OBJ_DIR%\\" /Fe"%OBJ_DIR%\packc.exe" "source\resource\tools\packc.cpp" >nul
+if %ERRORLEVEL% NEQ 0 ( call :Log "WARNING" "Yellow" "No se pudo compilar packc. Se serviran los archivos sueltos." & goto :PackFin )
+"%OBJ_DIR%\packc.exe" "%OUT_DIR%" "%OUT_DIR%\assets.gpak" public
+if %ERRORLEVEL% NEQ 0 ( call :Log "WARNING" "Yellow" "Fallo el empaquetado. Se serviran los archivos sueltos." & goto :PackFin )
+"%OBJ_DIR%\packc.exe" --verify "%OUT_DIR%\assets.gpak" "%OUT_DIR%" >nul
+if %ERRORLEVEL% NEQ 0 ( call :Log "WARNING" "Yellow" "El paquete no coincide con public. Se descarta." & del /q "%OUT_DIR%\assets.gpak" )
+:PackFin
+
 REM --- 6. PREGUNTA INTERACTIVA PARA EL INSTALADOR ---
 echo.
 call :Log "QUESTION" "Yellow" "Deseas generar el instalador (Setup.exe)? [S/N]"
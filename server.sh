@@ -0,0 +1,10 @@
+#!/bin/sh
+# Servidor de desarrollo nativo (Linux): compila httpd con CMake y sirve la carpeta del juego.
+# Keep-alive, Range, ETag/304 y .br/.gz precomprimidos. En Windows: server.bat.
+#   ./server.sh                  http://127.0.0.1:8080/
+#   PORT=3000 ./server.sh --log  Otro puerto, una línea por petición
+set -e
+cd "$(dirname "$0")"
+cmake -S . -B build >/dev/null
+cmake --build build --target httpd >/dev/null
+exec build/httpd . --port "${PORT:-8080}" "$@"
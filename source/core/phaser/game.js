@@ -31,3 +31,6 @@ const gameConfig = {
 
 // Iniciar el juego
 window.game = new Phaser.Game(gameConfig);
+
+// En escritorio el bucle sigue con requestAnimationFrame, limitado a fpsLimit (windowConfig.json)
+window.Genesis?.pacer.attach(window.game);
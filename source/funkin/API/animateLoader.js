@@ -0,0 +1,270 @@
+/**
+ * animateLoader.js
+ * Texture atlas de Adobe Animate horneados (.ganm, generados por animbake en compile.bat).
+ * Si el Animation.json está en `public/animations.json` se carga la tabla horneada y el
+ * spritemap (con AtlasLoader, así que también su .gatl y su .ktx2); reproducir es buscar el
+ * frame y colocar sus sprites, sin símbolos que resolver.
+ * Sin tabla (ej: en desarrollo con server.bat) no hay nada que reproducir: `load` devuelve false.
+ * Lo usa StageSpritesheet para los elementos de escenario cuyo `namePath` es una carpeta horneada.
+ *
+ * Formato: ver source/resource/core/Animate.h
+ */
+
+import { AtlasLoader } from "./atlasLoader.js";
+
+const MANIFEST_URL = "public/animations.json";
+const HEADER_SIZE = 48, FRAME_SIZE = 4, LIST_SIZE = 8, DRAW_SIZE = 28, SPRITE_SIZE = 4, COLOR_SIZE = 32, LABEL_SIZE = 12;
+
+let baked = new Set();
+const shearWarned = new Set();
+
+/**
+ * Decodifica un .ganm.
+ * @param {ArrayBuffer} buffer
+ * @returns {{ fps: number, frames: Uint32Array, lists: Uint32Array, matrices: Float32Array, sprites: Uint16Array,
+ *             colors: Uint16Array, spriteNames: string[], palette: Array<{ tint: number, alpha: number }>,
+ *             labels: Map<string, { first: number, count: number }> }}
+ */
+function decode(buffer) {
+    const view = new DataView(buffer);
+    const bytes = new Uint8Array(buffer);
+    const magic = String.fromCharCode(bytes[0], bytes[1], bytes[2], bytes[3]);
+    if (buffer.byteLength < HEADER_SIZE || magic !== "GANM" || view.getUint16(4, true) !== 1) {
+        throw new Error("AnimateLoader: archivo .ganm no válido");
+    }
+    const header = view.getUint16(6, true);
+    const fps = view.getFloat32(8, true);
+    const [frameCount, listCount, drawCount, spriteCount, colorCount, labelCount, stringBytes] =
+        [12, 16, 20, 24, 28, 32, 36].map(p => view.getUint32(p, true));
+    const framesAt = header;
+    const listsAt = framesAt + frameCount * FRAME_SIZE;
+    const drawsAt = listsAt + listCount * LIST_SIZE;
+    const spritesAt = drawsAt + drawCount * DRAW_SIZE;
+    const colorsAt = spritesAt + spriteCount * SPRITE_SIZE;
+    const labelsAt = colorsAt + colorCount * COLOR_SIZE;
+    const stringsAt = labelsAt + labelCount * LABEL_SIZE;
+    if (header < HEADER_SIZE || stringsAt + stringBytes !== buffer.byteLength) throw new Error("AnimateLoader: tamaño de .ganm incorrecto");
+
+    const decoder = new TextDecoder();
+    const str = (off) => {
+        let end = stringsAt + off;
+        while (end < buffer.byteLength && bytes[end] !== 0) end++;
+        return decoder.decode(bytes.subarray(stringsAt + off, end));
+    };
+
+    const frames = new Uint32Array(frameCount);
+    for (let i = 0; i < frameCount; i++) frames[i] = view.getUint32(framesAt + i * FRAME_SIZE, true);
+    const lists = new Uint32Array(listCount * 2);
+    for (let i = 0; i < listCount * 2; i++) lists[i] = view.getUint32(listsAt + i * 4, true);
+
+    // Un dibujo: a, b, c, d, tx, ty (matriz afín de Animate), sprite y color
+    const matrices = new Float32Array(drawCount * 6);
+    const sprites = new Uint16Array(drawCount);
+    const colors = new Uint16Array(drawCount);
+    for (let i = 0, p = drawsAt; i < drawCount; i++, p += DRAW_SIZE) {
+        for (let k = 0; k < 6; k++) matrices[i * 6 + k] = view.getFloat32(p + k * 4, true);
+        sprites[i] = view.getUint16(p + 24, true);
+        colors[i] = view.getUint16(p + 26, true);
+        if (sprites[i] >= spriteCount || colors[i] >= colorCount) throw new Error("AnimateLoader: dibujo de .ganm fuera de rango");
+    }
+    for (let i = 0; i < frameCount; i++) {
+        if (frames[i] >= listCount || lists[frames[i] * 2] + lists[frames[i] * 2 + 1] > drawCount) throw new Error("AnimateLoader: frame de .ganm corrupto");
+    }
+
+    const spriteNames = new Array(spriteCount);
+    for (let i = 0; i < spriteCount; i++) spriteNames[i] = str(view.getUint32(spritesAt + i * SPRITE_SIZE, true));
+
+    // Phaser solo multiplica (tint + alpha): los sumandos de color (tinte y brillo de Animate) no se aplican
+    const palette = new Array(colorCount);
+    const channel = (p) => Math.round(Math.min(1, Math.max(0, view.getFloat32(p, true))) * 255);
+    for (let i = 0, p = colorsAt; i < colorCount; i++, p += COLOR_SIZE) {
+        palette[i] = {
+            tint: (channel(p) << 16) | (channel(p + 4) << 8) | channel(p + 8),
+            alpha: Math.min(1, Math.max(0, view.getFloat32(p + 12, true)))
+        };
+    }
+
+    const labels = new Map();
+    for (let i = 0, p = labelsAt; i < labelCount; i++, p += LABEL_SIZE) {
+        labels.set(str(view.getUint32(p, true)), { first: view.getUint32(p + 4, true), count: view.getUint32(p + 8, true) });
+    }
+
+    return { fps, frames, lists, matrices, sprites, colors, spriteNames, palette, labels };
+}
+
+/**
+ * Sprite de un texture atlas de Animate: un contenedor con una imagen por dibujo del frame actual.
+ * Las imágenes se reutilizan entre frames y solo se recolocan cuando cambia el frame.
+ * Phaser no tiene sesgo en las imágenes: de cada matriz se quedan posición, rotación y escala
+ * (el sesgo, raro en los personajes y escenarios, se pierde y se avisa una vez por sprite).
+ */
+export class AnimateSprite extends Phaser.GameObjects.Container {
+    /**
+     * @param {Phaser.Scene} scene
+     * @param {number} x
+     * @param {number} y
+     * @param {string} key - La misma clave que se pasó a AnimateLoader.load.
+     */
+    constructor(scene, x, y, key) {
+        super(scene, x, y);
+        this.textureKey = key;
+        this.table = AnimateLoader.get(scene, key);
+        this.images = [];
+        this.frameIndex = -1;
+        this.range = { first: 0, count: this.table ? this.table.frames.length : 0 };
+        this.looping = true;
+        this.elapsed = 0;
+        this.isPlaying = false;
+        this.timeScale = 1;
+        this.setFrameIndex(0);
+    }
+
+    addedToScene() {
+        this.scene.sys.updateList.add(this);
+    }
+
+    removedFromScene() {
+        this.scene.sys.updateList.remove(this);
+    }
+
+    /**
+     * @param {string} [label] - Etiqueta de la línea principal; sin ella, todos los frames.
+     * @param {boolean} [loop=true]
+     */
+    play(label, loop = true) {
+        if (!this.table) return this;
+        const range = label ? this.table.labels.get(label) : null;
+        if (label && !range) console.warn(`AnimateSprite: "${this.textureKey}" no tiene la etiqueta "${label}"`);
+        this.range = range || { first: 0, count: this.table.frames.length };
+        this.looping = loop;
+        this.elapsed = 0;
+        this.isPlaying = true;
+        this.setFrameIndex(this.range.first);
+        return this;
+    }
+
+    stop() {
+        this.isPlaying = false;
+        return this;
+    }
+
+    preUpdate(time, delta) {
+        if (!this.isPlaying || !this.table || this.range.count === 0) return;
+        this.elapsed += delta * this.timeScale;
+        let step = Math.floor(this.elapsed * this.table.fps / 1000);
+        if (step >= this.range.count) {
+            if (this.looping) step %= this.range.count;
+            else { step = this.range.count - 1; this.isPlaying = false; this.emit("animationcomplete", this); }
+        }
+        this.setFrameIndex(this.range.first + step);
+    }
+
+    /**
+     * Coloca los sprites del frame `index` de la línea principal.
+     * @param {number} index
+     */
+    setFrameIndex(index) {
+        const t = this.table;
+        if (!t || index === this.frameIndex || index < 0 || index >= t.frames.length) return this;
+        this.frameIndex = index;
+        const first = t.lists[t.frames[index] * 2], count = t.lists[t.frames[index] * 2 + 1];
+        const texture = this.scene.textures.get(this.textureKey);
+        for (let i = 0; i < count; i++) {
+            let image = this.images[i];
+            if (!image) {
+                image = this.images[i] = new Phaser.GameObjects.Image(this.scene, 0, 0, this.textureKey).setOrigin(0, 0);
+                this.add(image);
+            }
+            const draw = first + i;
+            const spriteName = t.spriteNames[t.sprites[draw]];
+            const frame = texture.get(spriteName);
+            let [a, b, c, d, tx, ty] = t.matrices.subarray(draw * 6, draw * 6 + 6);
+            if (frame.customData.rotated) {
+                // El spritemap lo guarda girado 90° a la derecha: se deshace antes de la matriz del dibujo
+                [a, b, c, d, tx, ty] = [-c, -d, a, b, c * frame.width + tx, d * frame.width + ty];
+            }
+            const scaleX = Math.hypot(a, b);
+            const warnKey = `${this.textureKey}/${spriteName}`;
+            if (Math.abs(a * c + b * d) > 1e-3 * scaleX * Math.hypot(c, d) && !shearWarned.has(warnKey)) {
+                shearWarned.add(warnKey);
+                console.warn(`AnimateSprite: "${this.textureKey}" usa sesgo en "${spriteName}"; se dibuja sin él`);
+            }
+            const color = t.palette[t.colors[draw]];
+            image.setFrame(frame)
+                .setPosition(tx, ty)
+                .setRotation(Math.atan2(b, a))
+                .setScale(scaleX, scaleX ? (a * d - b * c) / scaleX : 0)
+                .setTint(color.tint)
+                .setAlpha(color.alpha)
+                .setVisible(true);
+        }
+        for (let i = count; i < this.images.length; i++) this.images[i].setVisible(false);
+        return this;
+    }
+}
+
+export const AnimateLoader = {
+    /**
+     * Lee la lista de Animation.json horneados. Sin lista, no hay ninguno.
+     */
+    async init() {
+        try {
+            const res = await fetch(MANIFEST_URL, { cache: "no-cache" });
+            if (res.ok) {
+                const manifest = await res.json();
+                baked = new Set((manifest.animations || []).map(p => `public/${p}`));
+                console.log(`AnimateLoader: ${baked.size} animaciones horneadas disponibles.`);
+            }
+        } catch (e) {
+            baked = new Set();
+        }
+    },
+
+    /**
+     * @param {string} folder - Carpeta del texture atlas (la del Animation.json), sin barra final.
+     * @returns {boolean} Si existe tabla horneada.
+     */
+    isBaked(folder) {
+        return baked.has(`${folder}/Animation.json`);
+    },
+
+    /**
+     * Encola la tabla horneada y el spritemap1 de la carpeta en el loader de la escena.
+     * @param {Phaser.Scene} scene
+     * @param {string} key - Clave de textura (y de la tabla).
+     * @param {string} folder - Carpeta del texture atlas, ej: "public/images/stages/street/spraycanAtlas".
+     * @returns {boolean} false si la carpeta no está horneada (no se encola nada).
+     */
+    load(scene, key, folder) {
+        if (!this.isBaked(folder)) return false;
+        scene.load.binary(`${key}.ganm`, `${folder}/Animation.ganm`);
+        AtlasLoader.load(scene, key, `${folder}/spritemap1.png`, `${folder}/spritemap1.json`);
+        return true;
+    },
+
+    /**
+     * Tabla decodificada (se decodifica una vez y se guarda en la caché binaria de Phaser).
+     * @param {Phaser.Scene} scene
+     * @param {string} key
+     * @returns {ReturnType<typeof decode>|null}
+     */
+    get(scene, key) {
+        const cache = scene.cache.binary;
+        const entry = cache.get(`${key}.ganm`);
+        if (!entry) return null;
+        if (!(entry instanceof ArrayBuffer)) return entry;
+        try {
+            const table = decode(entry);
+            cache.remove(`${key}.ganm`);
+            cache.add(`${key}.ganm`, table);
+            return table;
+        } catch (e) {
+            console.error(`${e.message} (${key})`);
+            return null;
+        }
+    },
+
+    decode
+};
+
+await AnimateLoader.init();
@@ -0,0 +1,343 @@
+/**
+ * atlasLoader.js
+ * Carga de atlas compilados (.gatl, generados por atlasc en compile.bat).
+ * Si un atlas está en `public/atlases.json` se carga la tabla binaria en lugar del XML;
+ * si no (ej: en desarrollo con server.bat), se usa el atlasXML de Phaser de siempre.
+ *
+ * Si ktxc comprimió el PNG (`public/textures.json`, que el host también inyecta como
+ * window.__GENESIS_TEXTURES__) y la GPU lo soporta, se sube el .bc7.ktx2 / .etc2.ktx2 en lugar
+ * del PNG: un cuarto de memoria de vídeo. Si falla, se vuelve a encolar con el PNG.
+ *
+ * Formato: ver source/resource/core/Atlas.h y source/resource/core/Ktx2.h
+ */
+
+const MANIFEST_URL = "public/atlases.json";
+const TEXTURES_URL = "public/textures.json";
+const HEADER_SIZE = 32, FRAME_SIZE = 24, ANIM_SIZE = 12;
+const FLAG_ROTATED = 1, FLAG_TRIMMED = 2;
+
+// Formatos de ktxc por orden de preferencia: extensión WebGL y formato interno de la GPU
+const GPU_FORMATS = [
+    { name: "bc7", extension: "EXT_texture_compression_bptc", internalFormat: 0x8E8C, vkFormat: 145 },
+    { name: "etc2", extension: "WEBGL_compressed_texture_etc", internalFormat: 0x9278, vkFormat: 151 }
+];
+
+let compiled = new Set();
+let textures = {};
+let supported = null;
+
+/**
+ * Decodifica un .gatl.
+ * @param {ArrayBuffer} buffer
+ * @returns {{ image: string, frames: Array<object>, anims: Array<object>, find: (name: string) => number }}
+ */
+function decode(buffer) {
+    const view = new DataView(buffer);
+    const bytes = new Uint8Array(buffer);
+    const magic = String.fromCharCode(bytes[0], bytes[1], bytes[2], bytes[3]);
+    if (buffer.byteLength < HEADER_SIZE || magic !== "GATL" || view.getUint16(4, true) !== 1) {
+        throw new Error("AtlasLoader: archivo .gatl no válido");
+    }
+    const header = view.getUint16(6, true);
+    const frameCount = view.getUint32(8, true);
+    const animCount = view.getUint32(12, true);
+    const slots = view.getUint32(16, true);
+    const stringBytes = view.getUint32(20, true);
+    const framesAt = header;
+    const animsAt = framesAt + frameCount * FRAME_SIZE;
+    const hashAt = animsAt + animCount * ANIM_SIZE;
+    const stringsAt = hashAt + slots * 4;
+    if (stringsAt + stringBytes !== buffer.byteLength) throw new Error("AtlasLoader: tamaño de .gatl incorrecto");
+
+    // Las cadenas se decodifican una vez cada una (están internadas)
+    const decoder = new TextDecoder();
+    const strings = new Map();
+    const str = (off) => {
+        let s = strings.get(off);
+        if (s === undefined) {
+            let end = stringsAt + off;
+            while (bytes[end] !== 0) end++;
+            s = decoder.decode(bytes.subarray(stringsAt + off, end));
+            strings.set(off, s);
+        }
+        return s;
+    };
+
+    const frames = new Array(frameCount);
+    for (let i = 0, p = framesAt; i < frameCount; i++, p += FRAME_SIZE) {
+        const flags = view.getUint16(p + 20, true);
+        frames[i] = {
+            name: str(view.getUint32(p, true)),
+            x: view.getUint16(p + 4, true), y: view.getUint16(p + 6, true),
+            w: view.getUint16(p + 8, true), h: view.getUint16(p + 10, true),
+            frameX: view.getInt16(p + 12, true), frameY: view.getInt16(p + 14, true),
+            frameW: view.getUint16(p + 16, true), frameH: view.getUint16(p + 18, true),
+            rotated: (flags & FLAG_ROTATED) !== 0,
+            trimmed: (flags & FLAG_TRIMMED) !== 0,
+            anim: view.getUint16(p + 22, true)
+        };
+    }
+
+    const anims = new Array(animCount);
+    for (let i = 0, p = animsAt; i < animCount; i++, p += ANIM_SIZE) {
+        anims[i] = { prefix: str(view.getUint32(p, true)), first: view.getUint32(p + 4, true), count: view.getUint32(p + 8, true) };
+    }
+
+    // Misma búsqueda que Atlas::View::Find (FNV-1a + sondeo lineal)
+    const encoder = new TextEncoder();
+    const find = (name) => {
+        if (slots === 0) return -1;
+        let h = 2166136261;
+        for (const b of encoder.encode(name)) { h ^= b; h = Math.imul(h, 16777619) >>> 0; }
+        for (let s = h & (slots - 1), n = 0; n < slots; s = (s + 1) & (slots - 1), n++) {
+            const v = view.getUint32(hashAt + s * 4, true);
+            if (v === 0 || v > frameCount) return -1;
+            if (frames[v - 1].name === name) return v - 1;
+        }
+        return -1;
+    };
+
+    return { image: str(view.getUint32(24, true)), frames, anims, find };
+}
+
+/**
+ * Archivo múltiple de Phaser: imagen + tabla binaria, igual que AtlasXMLFile pero sin XML.
+ */
+class AtlasBinaryFile extends Phaser.Loader.MultiFile {
+    constructor(loader, key, textureURL, atlasURL) {
+        const image = new Phaser.Loader.FileTypes.ImageFile(loader, key, textureURL);
+        const data = new Phaser.Loader.FileTypes.BinaryFile(loader, key, atlasURL);
+        super(loader, "atlasbin", key, [image, data]);
+    }
+
+    addToCache() {
+        if (!this.isReadyToProcess()) return;
+        const [image, data] = this.files;
+        const textures = this.loader.textureManager;
+        try {
+            const atlas = decode(data.data);
+            const texture = textures.create(image.key, image.data);
+            if (texture) {
+                addFrames(texture, atlas);
+                textures.emit(Phaser.Textures.Events.ADD, image.key, texture);
+                textures.emit(Phaser.Textures.Events.ADD_KEY + image.key, texture);
+            }
+        } catch (e) {
+            console.error(`AtlasLoader: ${e.message} (${data.src})`);
+        }
+        this.complete = true;
+    }
+}
+
+/**
+ * Frames y animaciones de un .gatl sobre una textura ya creada.
+ * @param {Phaser.Textures.Texture} texture
+ * @param {ReturnType<typeof decode>} atlas
+ */
+function addFrames(texture, atlas) {
+    const source = texture.source[0];
+    texture.add("__BASE", 0, 0, 0, source.width, source.height);
+    for (const f of atlas.frames) {
+        const frame = texture.add(f.name, 0, f.x, f.y, f.w, f.h);
+        if (!frame) continue; // Nombre repetido: gana el primero, como en atlasXML
+        // Exactamente lo que hace el parser AtlasXML de Phaser: recorte si hay frameX y nada más.
+        // `rotated` se conserva en el .gatl pero AtlasXML lo ignora, así que aquí también
+        // (PicoBullet, CanImpactParticle y los menús de Pico y Darnell lo llevan y se ven igual que con el .xml)
+        if (f.trimmed) frame.setTrim(f.w, f.h, Math.abs(f.frameX), Math.abs(f.frameY), f.frameW, f.frameH);
+        if (f.rotated) frame.customData.rotated = true; // Lo usa AnimateSprite (spritemaps de Animate)
+    }
+    if (!texture.customData) texture.customData = {};
+    texture.customData.animations = Object.fromEntries(atlas.anims.map(a => [a.prefix, {
+        first: a.first,
+        count: a.count,
+        frames: atlas.frames.slice(a.first, a.first + a.count).map(f => f.name)
+    }]));
+}
+
+/**
+ * Lee un .ktx2 de ktxc (un nivel, BC7 o ETC2 RGBA8, opcionalmente con zlib) y devuelve los
+ * datos que espera Phaser para una textura comprimida.
+ * @param {ArrayBuffer} buffer
+ * @param {{ internalFormat: number, vkFormat: number }} format - Formato que se pidió.
+ * @returns {Promise<object>}
+ */
+async function decodeKtx2(buffer, format) {
+    const view = new DataView(buffer);
+    const bytes = new Uint8Array(buffer);
+    const identifier = [0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A];
+    if (buffer.byteLength < 104 || identifier.some((b, i) => bytes[i] !== b)) throw new Error("AtlasLoader: archivo .ktx2 no válido");
+    if (view.getUint32(12, true) !== format.vkFormat) throw new Error("AtlasLoader: formato de .ktx2 inesperado");
+    const width = view.getUint32(20, true), height = view.getUint32(24, true);
+    const scheme = view.getUint32(44, true);
+    const at = Number(view.getBigUint64(80, true)), length = Number(view.getBigUint64(88, true));
+    const raw = Number(view.getBigUint64(96, true));
+    if (at + length > buffer.byteLength || raw !== Math.ceil(width / 4) * Math.ceil(height / 4) * 16) {
+        throw new Error("AtlasLoader: índice de niveles de .ktx2 incorrecto");
+    }
+
+    let data = bytes.subarray(at, at + length);
+    if (scheme === 3) {
+        // zlib: DecompressionStream("deflate") es justo el formato con cabecera zlib
+        const stream = new Blob([data]).stream().pipeThrough(new DecompressionStream("deflate"));
+        data = new Uint8Array(await new Response(stream).arrayBuffer());
+    } else if (scheme !== 0) {
+        throw new Error("AtlasLoader: supercompresión de .ktx2 no soportada");
+    }
+    if (data.byteLength !== raw) throw new Error("AtlasLoader: nivel de .ktx2 incompleto");
+
+    return {
+        compressed: true,
+        generateMipmap: false,
+        format: format.internalFormat,
+        internalFormat: format.internalFormat,
+        width, height,
+        mipmaps: [{ data, width, height }]
+    };
+}
+
+/**
+ * Textura .ktx2 suelta. El inflate es asíncrono, así que se hace en onProcess.
+ */
+class Ktx2File extends Phaser.Loader.File {
+    constructor(loader, key, url, format) {
+        super(loader, { type: "ktx2", cache: loader.textureManager, key, url, responseType: "arraybuffer" });
+        this.format = format;
+    }
+
+    onProcess() {
+        this.state = Phaser.Loader.FILE_PROCESSING;
+        decodeKtx2(this.xhrLoader.response, this.format).then(data => {
+            this.data = data;
+            this.onProcessComplete();
+        }, e => {
+            console.error(`${e.message} (${this.src})`);
+            this.onProcessError();
+        });
+    }
+}
+
+/**
+ * Atlas con la textura comprimida: .ktx2 + (.gatl o XML). Si falla la textura, se encola el
+ * mismo atlas con el PNG.
+ */
+class AtlasCompressedFile extends Phaser.Loader.MultiFile {
+    constructor(loader, key, ktxURL, format, textureURL, xmlURL) {
+        const binary = compiled.has(xmlURL);
+        const texture = new Ktx2File(loader, key, ktxURL, format);
+        const data = binary
+            ? new Phaser.Loader.FileTypes.BinaryFile(loader, key, xmlURL.replace(/\.(xml|json)$/i, ".gatl"))
+            : new Phaser.Loader.FileTypes.XMLFile(loader, key, xmlURL);
+        super(loader, "atlasktx2", key, [texture, data]);
+        this.binary = binary;
+        this.textureURL = textureURL;
+        this.xmlURL = xmlURL;
+    }
+
+    onFileFailed(file) {
+        super.onFileFailed(file);
+        if (file === this.files[0] && !this.fellBack) {
+            this.fellBack = true;
+            console.warn(`AtlasLoader: se usa el PNG de ${this.key}`);
+            loadUncompressed(this.loader, this.key, this.textureURL, this.xmlURL);
+        }
+    }
+
+    addToCache() {
+        if (!this.isReadyToProcess()) return;
+        const [image, data] = this.files;
+        const manager = this.loader.textureManager;
+        try {
+            // create + frames + eventos, como AtlasBinaryFile: addCompressedTexture avisa antes de tener los frames
+            const texture = manager.create(image.key, image.data);
+            if (texture) {
+                if (this.binary) addFrames(texture, decode(data.data));
+                else Phaser.Textures.Parsers.AtlasXML(texture, 0, data.data);
+                manager.emit(Phaser.Textures.Events.ADD, image.key, texture);
+                manager.emit(Phaser.Textures.Events.ADD_KEY + image.key, texture);
+            }
+        } catch (e) {
+            console.error(`AtlasLoader: ${e.message} (${data.src})`);
+        }
+        this.complete = true;
+    }
+}
+
+/**
+ * Formatos comprimidos que acepta la GPU, por orden de preferencia (se pregunta una vez).
+ * @param {Phaser.Loader.LoaderPlugin} loader
+ */
+function gpuFormats(loader) {
+    if (supported) return supported;
+    const gl = loader.systems.game.renderer.gl;
+    supported = gl && typeof DecompressionStream === "function" ? GPU_FORMATS.filter(f => gl.getExtension(f.extension)) : [];
+    console.log(`AtlasLoader: texturas comprimidas ${supported.map(f => f.name).join(", ") || "no soportadas"}.`);
+    return supported;
+}
+
+function loadUncompressed(loader, key, textureURL, xmlURL) {
+    if (compiled.has(xmlURL)) {
+        loader.addFile(new AtlasBinaryFile(loader, key, textureURL, xmlURL.replace(/\.(xml|json)$/i, ".gatl")));
+    } else {
+        loader.atlasXML(key, textureURL, xmlURL);
+    }
+}
+
+export const AtlasLoader = {
+    /**
+     * Lee la lista de atlas compilados y la de texturas comprimidas. Sin listas, todo se
+     * carga como PNG + XML.
+     */
+    async init() {
+        try {
+            const res = await fetch(MANIFEST_URL, { cache: "no-cache" });
+            if (res.ok) {
+                const manifest = await res.json();
+                compiled = new Set((manifest.atlases || []).map(p => `public/${p}`));
+                console.log(`AtlasLoader: ${compiled.size} atlas compilados disponibles.`);
+            }
+        } catch (e) {
+            compiled = new Set();
+        }
+        try {
+            let manifest = window.__GENESIS_TEXTURES__;
+            if (!manifest) {
+                const res = await fetch(TEXTURES_URL, { cache: "no-cache" });
+                if (res.ok) manifest = await res.json();
+            }
+            textures = (manifest && manifest.textures) || {};
+        } catch (e) {
+            textures = {};
+        }
+    },
+
+    /**
+     * @param {string} xmlURL - Ruta del XML o spritemap.
+     * @returns {boolean} Si existe versión compilada.
+     */
+    isCompiled(xmlURL) {
+        return compiled.has(xmlURL);
+    },
+
+    /**
+     * Encola un atlas en el loader de la escena: la textura comprimida si la hay y la GPU la
+     * soporta, si no el PNG; los frames del .gatl si existe, si no del XML.
+     * @param {Phaser.Scene} scene
+     * @param {string} key - Clave de textura.
+     * @param {string} textureURL - PNG del atlas.
+     * @param {string} xmlURL - Sparrow XML original.
+     */
+    load(scene, key, textureURL, xmlURL) {
+        const entry = textures[textureURL.replace(/^public\//, "")];
+        const format = entry && /\.png$/i.test(textureURL) ? gpuFormats(scene.load).find(f => entry[f.name]) : null;
+        if (format) {
+            const ktxURL = textureURL.replace(/\.png$/i, `.${format.name}.ktx2`);
+            scene.load.addFile(new AtlasCompressedFile(scene.load, key, ktxURL, format, textureURL, xmlURL));
+        } else {
+            loadUncompressed(scene.load, key, textureURL, xmlURL);
+        }
+    },
+
+    decode
+};
+
+await AtlasLoader.init();
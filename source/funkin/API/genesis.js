@@ -7,44 +7,251 @@ const userAgent = navigator.userAgent.toLowerCase();
 const isMobile = /android|iphone|ipad|ipod/.test(userAgent);
 const envType = isNative ? "DESKTOP" : (isMobile ? "MOBILE" : "WEB");
 
-const pendingCallbacks = {};
+/**
+ * Cliente RPC del puente nativo (sobre "#1|").
+ * Cada frame es "<id>|<verbo>|<len>|<payload>"; las llamadas hechas en el mismo tick se
+ * agrupan en un único postMessage y las respuestas llegan agrupadas igual. Cada petición va
+ * precedida de la cabecera para que el nativo pueda resincronizar si una llega rota.
+ * id 0 = llamada sin respuesta (o evento, en sentido nativo -> JS).
+ */
+const RPC_MAGIC = "#1|";
+const pendingCalls = new Map();
+const eventListeners = {};
+let nextCallId = 1;
+let outgoing = [];
+
+function flushOutgoing() {
+    const frames = outgoing;
+    outgoing = [];
+    window.chrome.webview.postMessage(RPC_MAGIC + frames.join(RPC_MAGIC));
+}
+
+function enqueue(id, verb, payload) {
+    const body = payload == null ? '' : String(payload);
+    if (outgoing.length === 0) queueMicrotask(flushOutgoing);
+    outgoing.push(`${id}|${verb}|${body.length}|${body}`);
+}
+
+/**
+ * Llama a un verbo nativo y espera su respuesta.
+ * @param {string} verb
+ * @param {string} [payload]
+ * @param {object} [options]
+ * @param {AbortSignal} [options.signal] Cancela la llamada en el lado nativo si aún no terminó.
+ * @returns {Promise<string>} Payload de la respuesta; se rechaza si el nativo responde "err" o "busy".
+ */
+function rpcCall(verb, payload = '', { signal } = {}) {
+    return new Promise((resolve, reject) => {
+        if (signal && signal.aborted) { reject(new Error('aborted')); return; }
+        const id = nextCallId++;
+        if (nextCallId > 0x7fffffff) nextCallId = 1;
+        pendingCalls.set(id, { resolve, reject });
+        enqueue(id, verb, payload);
+        if (signal) {
+            signal.addEventListener('abort', () => {
+                if (!pendingCalls.delete(id)) return;
+                rpcSend("cancel", String(id));
+                reject(new Error('aborted'));
+            }, { once: true });
+        }
+    });
+}
+
+/** Envía un verbo sin esperar respuesta. */
+function rpcSend(verb, payload = '') {
+    enqueue(0, verb, payload);
+}
+
+function parseFrames(msg) {
+    const frames = [];
+    let pos = RPC_MAGIC.length;
+    while (pos < msg.length) {
+        const a = msg.indexOf('|', pos);
+        const b = msg.indexOf('|', a + 1);
+        const c = msg.indexOf('|', b + 1);
+        if (a < 0 || b < 0 || c < 0) break;
+        const len = parseInt(msg.substring(b + 1, c), 10);
+        const start = c + 1;
+        frames.push({ id: parseInt(msg.substring(pos, a), 10), tag: msg.substring(a + 1, b), payload: msg.substr(start, len) });
+        pos = start + len;
+    }
+    return frames;
+}
+
+/**
+ * Cargas en streaming abiertas (streamId -> estado). El nativo solo produce un bloque
+ * por crédito pedido con "streamRead", así que nunca hay más de `window` bloques en vuelo.
+ */
+const openStreams = new Map();
+
+/**
+ * Tiempos de la página pendientes de enviar (nombre -> [inicio, duración, ...] en ms de performance.now()).
+ * Se mandan en lote con "perfFrames" una vez por segundo.
+ */
+const perfSpans = new Map();
+let perfFlushTimer = 0;
+let perfFrameHandle = 0;
+let perfLongTasks = null;
+
+function perfRecord(name, start, duration) {
+    if (!isNative) return;
+    let list = perfSpans.get(name);
+    if (!list) perfSpans.set(name, list = []);
+    list.push(start.toFixed(3), duration.toFixed(3));
+    if (!perfFlushTimer) perfFlushTimer = setTimeout(perfFlush, 1000);
+}
+
+function perfFlush() {
+    clearTimeout(perfFlushTimer);
+    perfFlushTimer = 0;
+    for (const [name, list] of perfSpans) rpcSend("perfFrames", `${name}|${performance.timeOrigin}|${list.join(',')}`);
+    perfSpans.clear();
+}
+
+/**
+ * Limitador de frames dentro de requestAnimationFrame, como fps.limit de Phaser 3.80 pero con la
+ * frecuencia que decide el nativo (fpsLimit, escena, reposo, minimizada) y cambiable en marcha.
+ * Los frames siguen saliendo con el refresco de la pantalla; solo se saltan los que llegan antes
+ * de su plazo. La tolerancia es medio refresco, así que a 60 Hz en una pantalla de 60 Hz no se
+ * salta ninguno por el jitter del vsync. Es FramePacer::Gate (core/FramePacer.h) paso a paso;
+ * pacebench --verify lo comprueba allí con tiempos sintéticos.
+ */
+let frameGate = null;
+const GATE_WINDOW = 240;
+
+function createFrameGate() {
+    const gate = {
+        hz: 0,                  // 0 = sin límite hasta que responda el nativo
+        paused: false,
+        next: 0,
+        last: 0,                // Último frame que se dejó pasar
+        lastRaf: 0,             // Último requestAnimationFrame, pasara o no
+        refresh: 1000 / 60,     // Intervalo del vsync (media móvil)
+        frames: 0,
+        skipped: 0,
+        intervals: [],          // Intervalos entre frames que pasaron (ms), últimos GATE_WINDOW
+        onFrame: null,
+        /** @returns {function(number):void} callback que solo llama a `callback` en los frames que tocan */
+        wrap(callback) {
+            return time => {
+                if (this.lastRaf) {
+                    const raw = time - this.lastRaf;
+                    if (raw > 0 && raw < 250) this.refresh += (raw - this.refresh) / 16;
+                }
+                this.lastRaf = time;
+                if (this.paused) { this.skipped++; return; }
+                if (this.hz > 0) {
+                    const period = 1000 / this.hz;
+                    if (time < this.next - this.refresh / 2) { this.skipped++; return; }
+                    // Plazos absolutos; si se queda atrás más de un periodo, se vuelve a contar desde aquí
+                    this.next = time - this.next > period ? time + period : this.next + period;
+                }
+                if (this.last) {
+                    if (this.intervals.length >= GATE_WINDOW) this.intervals.shift();
+                    this.intervals.push(time - this.last);
+                }
+                this.last = time;
+                this.frames++;
+                callback(time);
+                if (this.onFrame) this.onFrame();
+            };
+        },
+        setRate(hz) {
+            this.paused = hz <= 0;
+            this.hz = Math.max(0, hz);
+            this.next = 0;
+        },
+        stats() {
+            const period = this.hz > 0 ? 1000 / this.hz : this.refresh;
+            const errors = this.intervals.map(i => Math.abs(i - period) * 1000).sort((x, y) => x - y);
+            const at = p => errors.length ? errors[Math.min(errors.length - 1, Math.floor(errors.length * p))] : 0;
+            const sum = this.intervals.reduce((x, y) => x + y, 0);
+            return {
+                frames: this.frames, skipped: this.skipped, refreshMs: this.refresh,
+                p50ErrorUs: at(0.5), p99ErrorUs: at(0.99), maxErrorUs: errors.length ? errors[errors.length - 1] : 0,
+                meanIntervalMs: this.intervals.length ? sum / this.intervals.length : 0
+            };
+        }
+    };
+    return gate;
+}
+
+/**
+ * Último reloj del reproductor de stems ("playerClock" o respuesta de "playerCtl") y cuándo llegó.
+ * Entre avisos (50 ms) la posición se extrapola con la velocidad.
+ */
+let playerClock = { ms: 0, speed: 1, playing: false, ended: false, at: 0 };
+const playerClockListeners = [];
+
+function setPlayerClock(payload) {
+    const [ms, speed, playing, ended] = payload.split('|');
+    playerClock = { ms: Number(ms), speed: Number(speed), playing: playing === '1', ended: ended === '1', at: performance.now() };
+    playerClockListeners.forEach(fn => fn(playerClock));
+    return playerClock;
+}
+
+(eventListeners.playerClock ||= []).push(setPlayerClock);
+
+/** Búsquedas en curso (id -> onHits). */
+const openSearches = new Map();
+let nextSearchId = 1;
+
+(eventListeners.searchHits ||= []).push(payload => {
+    const nl = payload.indexOf('\n');
+    const onHits = openSearches.get(payload.substring(0, nl < 0 ? payload.length : nl));
+    if (!onHits || nl < 0) return;
+    onHits(payload.substring(nl + 1).split('\n').map(line => {
+        const [path, lineNo, column, ...text] = line.split('\t');
+        return { path, line: Number(lineNo), column: Number(column), text: text.join('\t') };
+    }));
+});
+
+function onStreamEvent(name, fn) {
+    (eventListeners[name] ||= []).push(payload => {
+        const bar = payload.indexOf('|');
+        const id = parseInt(bar < 0 ? payload : payload.substring(0, bar), 10);
+        const stream = openStreams.get(id);
+        if (stream) fn(stream, bar < 0 ? '' : payload.substring(bar + 1), id);
+    });
+}
+
+(eventListeners.storageError ||= []).push(payload => {
+    const bar = payload.indexOf('|');
+    console.warn(`[Genesis] No se pudo guardar "${payload.substring(0, bar)}": ${payload.substring(bar + 1)}`);
+});
+
+onStreamEvent('chunk', (stream, text, id) => {
+    if (stream.onChunk) stream.onChunk(text);
+    else stream.parts.push(text);
+    // Devuelve el crédito una vez consumido el bloque
+    if (!stream.ended) rpcSend("streamRead", `${id}|1`);
+});
+onStreamEvent('streamProgress', (stream, data) => {
+    const [done, total] = data.split('|').map(Number);
+    if (stream.onProgress) stream.onProgress(done, total);
+});
+onStreamEvent('streamEnd', (stream, _, id) => {
+    stream.ended = true;
+    openStreams.delete(id);
+    stream.resolve(stream.onChunk ? null : stream.parts.join(''));
+});
 
 if (isNative) {
     window.chrome.webview.addEventListener('message', event => {
         const msg = event.data;
-        
-        if (msg.startsWith("fileSelected:")) {
-            const path = msg.substring(13);
-            if (pendingCallbacks.openFile) pendingCallbacks.openFile(path || null);
-        }
-        else if (msg.startsWith("fileLoaded:")) {
-            const dataStr = msg.substring(11);
-            const pipeIndex = dataStr.indexOf('|');
-            const key = dataStr.substring(0, pipeIndex);
-            const content = dataStr.substring(pipeIndex + 1);
-            
-            if (pendingCallbacks['load_' + key]) {
-                pendingCallbacks['load_' + key](content);
-                delete pendingCallbacks['load_' + key];
-            }
-        }
-        else if (msg.startsWith("dirListed:")) {
-            const dataStr = msg.substring(10);
-            const pipeIndex = dataStr.indexOf('|');
-            const pathKey = dataStr.substring(0, pipeIndex).replace(/\\/g, '/'); 
-            const filesStr = dataStr.substring(pipeIndex + 1);
-            const files = filesStr ? filesStr.split('|') : [];
-            if (pendingCallbacks['list_' + pathKey]) {
-                pendingCallbacks['list_' + pathKey](files);
-                delete pendingCallbacks['list_' + pathKey];
+        if (typeof msg !== 'string' || !msg.startsWith(RPC_MAGIC)) return;
+
+        for (const frame of parseFrames(msg)) {
+            if (frame.id === 0) {
+                const handlers = eventListeners[frame.tag];
+                if (handlers) handlers.forEach(fn => fn(frame.payload));
+                continue;
             }
-        }
-        else if (msg.startsWith("memInfo:")) {
-            const mem = parseInt(msg.substring(8));
-            if (pendingCallbacks.getMemory) pendingCallbacks.getMemory(mem);
-        }
-        else if (msg === "dialogClosed") {
-            if (pendingCallbacks.msgBox) pendingCallbacks.msgBox();
+            const call = pendingCalls.get(frame.id);
+            if (!call) continue;
+            pendingCalls.delete(frame.id);
+            if (frame.tag === 'ok') call.resolve(frame.payload);
+            else call.reject(new Error(frame.payload));
         }
     });
 }
@@ -59,13 +266,13 @@ const Genesis = {
     },
 
     window: {
-        resize: (w, h) => isNative && window.chrome.webview.postMessage(`resize:${w},${h}`),
-        maximize: () => isNative && window.chrome.webview.postMessage("maximize"),
-        minimize: () => isNative && window.chrome.webview.postMessage("minimize"),
-        close: () => isNative && window.chrome.webview.postMessage("close"),
+        resize: (w, h) => isNative && rpcSend("resize", `${w},${h}`),
+        maximize: () => isNative && rpcSend("maximize"),
+        minimize: () => isNative && rpcSend("minimize"),
+        close: () => isNative && rpcSend("close"),
         setTitle: (t) => {
             document.title = t;
-            if (isNative) window.chrome.webview.postMessage(`setTitle:${t}`);
+            if (isNative) rpcSend("setTitle", t);
         }
     },
 
@@ -80,22 +287,20 @@ const Genesis = {
                     return;
                 }
                 let filterStr = filters ? filters.join("|") : "All Files|*.*";
-                pendingCallbacks.openFile = resolve;
-                window.chrome.webview.postMessage(`openFile:${filterStr}`);
+                rpcCall("openFile", filterStr).then(path => resolve(path || null), () => resolve(null));
             });
         },
         messageBox: ({ title, message, type = 0 }) => {
             return new Promise((resolve) => {
                 if (!isNative) { alert(`${title}\n\n${message}`); resolve(); return; }
-                pendingCallbacks.msgBox = resolve;
-                window.chrome.webview.postMessage(`msgBox:${title}|${message}|${type}`);
+                rpcCall("msgBox", `${title}|${message}|${type}`).then(() => resolve(), () => resolve());
             });
         }
     },
 
     shell: {
         openExternal: (url) => {
-            if (isNative) window.chrome.webview.postMessage(`openExternal:${url}`);
+            if (isNative) rpcSend("openExternal", url);
             else window.open(url, '_blank');
         }
     },
@@ -111,43 +316,379 @@ const Genesis = {
             if (isNative) {
                 const details = data.details || "";
                 const state = data.state || "";
-                // Enviar mensaje al C++: "discord:Estado|Detalles"
-                window.chrome.webview.postMessage(`discord:${state}|${details}`);
+                // Payload nativo: "Estado|Detalles"
+                rpcSend("discord", `${state}|${details}`);
             } else {
                 console.log("[Discord Mock] Activity:", data);
             }
         }
     },
 
+    bridge: {
+        call: rpcCall,
+        send: rpcSend,
+        /**
+         * Suscribe a un evento nativo (frames con id 0).
+         * @param {string} name
+         * @param {function(string):void} fn
+         */
+        on: (name, fn) => { (eventListeners[name] ||= []).push(fn); }
+    },
+
     system: {
         getMemoryInfo: () => {
             return new Promise((resolve) => {
                 if (!isNative) { resolve(0); return; }
-                pendingCallbacks.getMemory = resolve;
-                window.chrome.webview.postMessage("getMemory");
+                rpcCall("getMemory").then(mem => resolve(parseInt(mem, 10)), () => resolve(0));
+            });
+        }
+    },
+
+    perf: {
+        /**
+         * Empieza a medir cada frame (entre callbacks de requestAnimationFrame) y las tareas largas
+         * (> 50 ms) del hilo principal. Van a las series "page.frame" y "page.longtask".
+         */
+        start: () => {
+            if (!isNative || perfFrameHandle) return;
+            let last = 0;
+            const tick = (t) => {
+                if (last) perfRecord("frame", last, t - last);
+                last = t;
+                perfFrameHandle = requestAnimationFrame(tick);
+            };
+            perfFrameHandle = requestAnimationFrame(tick);
+            if (typeof PerformanceObserver !== 'undefined' && PerformanceObserver.supportedEntryTypes?.includes('longtask')) {
+                perfLongTasks = new PerformanceObserver(list => {
+                    for (const e of list.getEntries()) perfRecord("longtask", e.startTime, e.duration);
+                });
+                perfLongTasks.observe({ type: 'longtask' });
+            }
+        },
+        stop: () => {
+            if (perfFrameHandle) cancelAnimationFrame(perfFrameHandle);
+            perfFrameHandle = 0;
+            if (perfLongTasks) perfLongTasks.disconnect();
+            perfLongTasks = null;
+            perfFlush();
+        },
+        /**
+         * Registra un tramo propio (ej: carga de una canción) en la serie "page.<name>".
+         * @param {string} name Letras, números, '.', '_' o '-'.
+         * @param {number} start performance.now() al empezar.
+         * @param {number} [end] performance.now() al terminar (por defecto, ahora).
+         */
+        span: (name, start, end = performance.now()) => perfRecord(name, start, end - start),
+        /**
+         * @returns {Promise<object|null>} { uptimeMs, events, series: { nombre: { count, mean, min, p50, p90, p99, max } }, process: {...} }
+         */
+        stats: () => {
+            if (!isNative) return Promise.resolve(null);
+            perfFlush();
+            return rpcCall("perfStats").then(JSON.parse, () => null);
+        },
+        /**
+         * Guarda los últimos eventos (nativos y de la página) como trace de Chrome en AppData.
+         * @returns {Promise<string|null>} Ruta del archivo .json (se abre en chrome://tracing o Perfetto).
+         */
+        exportTrace: () => {
+            if (!isNative) return Promise.resolve(null);
+            perfFlush();
+            return rpcCall("perfTrace").catch(() => null);
+        }
+    },
+
+    pacer: {
+        /**
+         * Limita el bucle de Phaser a la frecuencia del nativo sin salir de requestAnimationFrame:
+         * cada frame sigue alineado con el vsync y los que sobran se saltan (ver createFrameGate).
+         * Los cambios de frecuencia (escena, reposo, minimizada) llegan con "pacerHz". También
+         * avisa de la escena de arriba (para sus frecuencias propias) y del reposo.
+         * Sin nativo, o si el host no tiene marcapasos, el bucle va al refresco de la pantalla.
+         * @param {Phaser.Game} game
+         * @param {object} [options]
+         * @param {number} [options.idleAfterMs=60000] Sin entrada ni sonido sonando durante este tiempo baja a fpsIdle; 0 = nunca.
+         * @returns {Promise<number>} Frecuencia con la que arranca (0 = sin límite).
+         */
+        attach: (game, { idleAfterMs = 60000 } = {}) => {
+            if (!isNative || frameGate) return Promise.resolve(0);
+            const raf = game.loop.raf;
+            const gate = frameGate = createFrameGate();
+            // TimeStep vuelve a llamar a raf.start al despertar: el callback nuevo también pasa por el limitador
+            const start = raf.start;
+            raf.start = function (callback, ...rest) { return start.call(this, gate.wrap(callback), ...rest); };
+            if (raf.isRunning) raf.callback = gate.wrap(raf.callback);
+
+            let lastInput = performance.now();
+            let idle = false;
+            let scene = null;
+            const onInput = () => {
+                lastInput = performance.now();
+                if (idle) { idle = false; rpcSend("pacerIdle", "0"); }
+            };
+            for (const type of ['pointerdown', 'pointermove', 'keydown', 'wheel']) {
+                window.addEventListener(type, onInput, { passive: true, capture: true });
+            }
+
+            gate.onFrame = () => {
+                const top = game.scene.getScenes(true, true)[0];
+                const key = top ? top.sys.settings.key : '';
+                if (key !== scene) { scene = key; rpcSend("pacerScene", key); }
+                if (!idle && idleAfterMs > 0 && performance.now() - lastInput > idleAfterMs
+                    && !game.sound?.sounds?.some(s => s.isPlaying)) {
+                    idle = true;
+                    rpcSend("pacerIdle", "1");
+                }
+            };
+            (eventListeners.pacerHz ||= []).push(payload => {
+                if (frameGate === gate) gate.setRate(Number(payload));
+            });
+
+            return rpcCall("pacerStart").then(hz => {
+                gate.setRate(Number(hz));
+                return Number(hz);
+            }, () => {
+                // Host sin marcapasos: sin límite, al ritmo de requestAnimationFrame
+                gate.onFrame = null;
+                return 0;
+            });
+        },
+        /**
+         * Frecuencia propia de una escena (ej: el editor a 60 mientras el juego va a fpsLimit).
+         * @param {string} scene Clave de la escena; vacía cambia la frecuencia base.
+         * @param {number} hz 0 quita el ajuste de la escena.
+         * @returns {Promise<number>} Frecuencia efectiva tras el cambio.
+         */
+        setRate: (scene, hz) => isNative ? rpcCall("pacerRate", `${scene}|${hz}`).then(Number, () => 0) : Promise.resolve(0),
+        /**
+         * Error = |intervalo entre frames - periodo|, medido en la página con los tiempos de requestAnimationFrame.
+         * @returns {Promise<object|null>} { running, hz, frames, skipped, refreshMs, p50ErrorUs, p99ErrorUs, maxErrorUs, meanIntervalMs }
+         */
+        stats: () => {
+            if (!isNative) return Promise.resolve(null);
+            return rpcCall("pacerStats").then(JSON.parse, () => null)
+                .then(native => native && Object.assign(native, frameGate ? frameGate.stats() : {}));
+        }
+    },
+
+    chart: {
+        /**
+         * Indexa un chart en nativo (una sola vez) para consultarlo por ventanas de tiempo.
+         * Cada open necesita su close: abrir dos veces el mismo chart da el mismo handle, y sigue
+         * vivo hasta el segundo close. Si el archivo cambió en disco, se reindexa con otro handle.
+         * @param {string} path Ruta relativa al juego (ej: "public/songs/Guns/charts/Guns-hard.json").
+         * @returns {Promise<object|null>} { handle, notes, duration, bpm, speed, song, player, enemy, stage, types... }
+         */
+        open: (path) => isNative ? rpcCall("chartOpen", path).then(JSON.parse, () => null) : Promise.resolve(null),
+        /**
+         * Notas que empiezan en [t0, t1). Con `holds`, también las sostenidas que siguen sonando en t0.
+         * @returns {Promise<Array<{time:number, lane:number, sustain:number, type:number}>>} lane 0-3 oponente, 4-7 jugador.
+         */
+        notes: (handle, t0, t1, { holds = false } = {}) => {
+            if (!isNative) return Promise.resolve([]);
+            return rpcCall("chartNotes", `${handle}|${t0}|${t1}|${holds ? 1 : 0}`).then(str => {
+                if (!str) return [];
+                return str.split(';').map(n => {
+                    const [time, lane, sustain, type] = n.split(',').map(Number);
+                    return { time, lane, sustain, type };
+                });
             });
+        },
+        /**
+         * Notas por cubeta entre t0 y t1.
+         * @param {number} [laneMask] 0xFF todas, 0x0F oponente, 0xF0 jugador.
+         * @returns {Promise<Uint32Array>}
+         */
+        density: (handle, t0, t1, buckets, laneMask = 0xFF) => {
+            if (!isNative) return Promise.resolve(new Uint32Array(buckets));
+            return rpcCall("chartDensity", `${handle}|${t0}|${t1}|${buckets}|${laneMask}`)
+                .then(str => Uint32Array.from(str.split(','), Number));
+        },
+        close: (handle) => isNative && rpcSend("chartClose", String(handle))
+    },
+
+    songs: {
+        /**
+         * Índice de public/songs en una sola llamada: dificultades, BPM, notas por carril, duración
+         * y stems de cada canción. Nativo solo vuelve a leer los archivos que cambiaron.
+         * @returns {Promise<object|null>} { files, parsed, reused, removed, ms, library: { version, songs: [...] } }
+         */
+        library: () => isNative ? rpcCall("libraryScan").then(JSON.parse, () => null) : Promise.resolve(null),
+
+        /**
+         * Todo lo que carga una partida de la canción (chart, stage, personajes, noteSkin, atlas,
+         * iconos y audio) con su tamaño, ordenado para precargar. Lo que falta viene con missing: true.
+         * Sin canción devuelve el grafo de todas: { charts, files, bytes, missing: [...], orphans: [...] }.
+         * @param {string} [song] Carpeta de la canción (ej: "Bopeebo").
+         * @param {string} [difficulty] Por defecto "normal".
+         * @returns {Promise<object|null>} { song, difficulty, isChart, bytes, missing, ms,
+         *   assets: [{ path, kind, priority, bytes, missing }] }
+         */
+        assets: (song = "", difficulty = "") => isNative
+            ? rpcCall("songAssets", song ? `${song}|${difficulty}` : "").then(JSON.parse, () => null)
+            : Promise.resolve(null),
+
+        /**
+         * BPM, fase y notas sugeridas a partir del audio (onsets por FFT en nativo, en segundo plano
+         * y cacheados por hash del .ogg). Sin `bpm` lo estima de Inst.ogg.
+         * @param {string} path Carpeta de la canción (ej: "public/songs/Fresh").
+         * @param {{bpm?:number, subdivision?:number}} [opts] subdivision: casillas por pulso (4 = 1/16).
+         * @returns {Promise<object|null>} { bpm, phaseMs, confidence, estimated, durationMs,
+         *   stems: [{ role, file, onsets: [[ms, fuerza]], notes: [[ms, carril, duración]] }] }
+         */
+        analyze: (path, opts = {}) => {
+            if (!isNative) return Promise.resolve(null);
+            return rpcCall("analyzeSong", `${path}|${opts.bpm || 0}|${opts.subdivision || 4}`).then(JSON.parse, () => null);
+        }
+    },
+
+    audio: {
+        /**
+         * Forma de onda de un .ogg (pirámide min/max/RMS calculada en nativo y cacheada en disco).
+         * @param {string} path Relativa al juego (ej: "public/songs/Fresh/song/Inst.ogg").
+         * @returns {Promise<object|null>} { channels, sampleRate, frames, baseBin, levels, levelFor(), tile(), close() }
+         */
+        peaks: (path) => {
+            if (!isNative) return Promise.resolve(null);
+            return rpcCall("peaksOpen", path).then(json => {
+                const info = JSON.parse(json);
+                return {
+                    ...info,
+                    /** Nivel cuyo tamaño de cubeta no pasa de `samplesPerPixel`. */
+                    levelFor: (samplesPerPixel) => {
+                        const level = Math.floor(Math.log2(Math.max(1, samplesPerPixel / info.baseBin)));
+                        return Math.max(0, Math.min(info.levels.length - 1, level));
+                    },
+                    /**
+                     * Cubetas [start, start + count) de un nivel.
+                     * @returns {Promise<{start:number, count:number, data:Int16Array}>} data: [cubeta][canal][min, max, rms], escala 32767.
+                     */
+                    tile: (level, start, count) => rpcCall("peaksTile", `${info.handle}|${level}|${start}|${count}`).then(reply => {
+                        const [first, got, b64] = reply.split('|');
+                        const bin = atob(b64);
+                        const bytes = new Uint8Array(bin.length);
+                        for (let i = 0; i < bin.length; i++) bytes[i] = bin.charCodeAt(i);
+                        return { start: Number(first), count: Number(got), data: new Int16Array(bytes.buffer) };
+                    }),
+                    close: () => rpcSend("peaksClose", String(info.handle))
+                };
+            }, () => null);
         }
     },
 
+    player: {
+        /**
+         * Carga los stems de una canción en el reproductor nativo (parado en 0). Mezcla Inst y voces
+         * y cambia la velocidad sin cambiar el tono; el PCM decodificado queda en caché.
+         * @param {string} path Carpeta de la canción (ej: "public/songs/Fresh").
+         * @returns {Promise<object|null>} { durationMs, sampleRate, channels, decodeMs, stems: ["Inst.ogg", ...] }
+         */
+        load: (path) => isNative ? rpcCall("playerLoad", path).then(JSON.parse, () => null) : Promise.resolve(null),
+        play: () => isNative ? rpcCall("playerCtl", "play").then(setPlayerClock, () => null) : Promise.resolve(null),
+        pause: () => isNative ? rpcCall("playerCtl", "pause").then(setPlayerClock, () => null) : Promise.resolve(null),
+        /** @param {number} ms Posición de la canción; si estaba sonando sigue sonando desde ahí. */
+        seek: (ms) => isNative ? rpcCall("playerCtl", `seek|${ms}`).then(setPlayerClock, () => null) : Promise.resolve(null),
+        /** @param {number} speed 0.25 - 4; el tono no cambia. */
+        setSpeed: (speed) => isNative ? rpcCall("playerCtl", `speed|${speed}`).then(setPlayerClock, () => null) : Promise.resolve(null),
+        /** @param {number} stem Índice en `stems` de load(). @param {number} gain 0 = silenciado, 1 = normal. */
+        setGain: (stem, gain) => isNative ? rpcCall("playerCtl", `gain|${stem}|${gain}`).then(setPlayerClock, () => null) : Promise.resolve(null),
+        /**
+         * Posición de la canción que está sonando, en ms: el reloj nativo (lo que ya salió por el
+         * dispositivo) extrapolado desde el último aviso. Es la que hay que pasar a
+         * Conductor.updateFromSong() en cada frame, en vez de contar el tiempo en la página.
+         * @returns {number}
+         */
+        position: () => {
+            const c = playerClock;
+            return c.playing ? c.ms + (performance.now() - c.at) * c.speed : c.ms;
+        },
+        /** @returns {{ms:number, speed:number, playing:boolean, ended:boolean, at:number}} Último reloj recibido. */
+        clock: () => playerClock,
+        /** @param {(clock:object) => void} fn Cada aviso del reloj (cada 50 ms sonando y en cada cambio). */
+        onClock: (fn) => { playerClockListeners.push(fn); },
+        /**
+         * @returns {Promise<object|null>} { loaded, stems, frames, renderMs, costMsPerSecond, underruns, hops, searches, decodeMs, cacheBytes }
+         */
+        stats: () => isNative ? rpcCall("playerStats").then(JSON.parse, () => null) : Promise.resolve(null),
+        close: () => isNative && rpcSend("playerClose")
+    },
+
     file: {
-        list: (path) => {
+        /**
+         * Lista una carpeta del juego. El nativo la sirve desde su caché, que se mantiene al día sola.
+         * Sin opciones devuelve los nombres de archivo (formato de siempre); con opciones, entradas con metadatos.
+         * @param {string} path Relativa al juego (ej: "public/data/characters").
+         * @param {object} [options]
+         * @param {boolean} [options.recursive] Incluye subcarpetas.
+         * @param {string} [options.glob] Filtro: "*.json", "**\/*.png", "{bf,gf}*.xml"...
+         * @returns {Promise<string[]|Array<{path:string, dir:boolean, size:number, mtime:number}>>}
+         */
+        list: (path, options) => {
             return new Promise((resolve) => {
                 if (!isNative) {
                     console.warn("[Genesis] file.list no soportado en Web.");
                     resolve([]);
                     return;
                 }
-                const pathKey = path.replace(/\\/g, '/');
-                pendingCallbacks['list_' + pathKey] = resolve;
-                window.chrome.webview.postMessage(`listDir:${path}`);
+                if (!options) {
+                    rpcCall("listDir", path).then(files => resolve(files ? files.split('|') : []), () => resolve([]));
+                    return;
+                }
+                const { recursive = false, glob = "" } = options;
+                rpcCall("listTree", `${path}|${recursive ? 1 : 0}|${glob}`).then(text => {
+                    if (!text) { resolve([]); return; }
+                    resolve(text.split('\n').map(line => {
+                        const [kind, size, mtime, ...rest] = line.split('\t');
+                        return { path: rest.join('\t'), dir: kind === 'd', size: Number(size), mtime: Number(mtime) };
+                    }));
+                }, () => resolve([]));
+            });
+        },
+        /**
+         * Avisa de cambios en la carpeta del juego (en lotes).
+         * `kind`: "added" | "removed" | "modified" | "overflow" (se perdieron eventos: volver a listar).
+         * @param {function(Array<{kind:string, path:string}>):void} fn
+         */
+        onChange: (fn) => {
+            if (!isNative) return;
+            if (!eventListeners.fsChange) rpcSend("fsWatch", "1");
+            (eventListeners.fsChange ||= []).push(payload => {
+                const kinds = { a: 'added', r: 'removed', m: 'modified', o: 'overflow' };
+                fn(payload.split('\n').map(line => ({ kind: kinds[line[0]], path: line.substring(2) })));
             });
         }
     },
 
+    search: {
+        /**
+         * Busca en todo el proyecto (source/ y public/: .json, .xml, .js, .css) con el índice de
+         * trigramas nativo. Los resultados llegan por `onHits` a medida que se encuentran, en
+         * cualquier orden entre archivos; la promesa se resuelve al terminar.
+         * @param {string} text Texto o expresión regular (sintaxis de JavaScript).
+         * @param {object} [options]
+         * @param {boolean} [options.regex]
+         * @param {boolean} [options.caseSensitive]
+         * @param {number} [options.max] Máximo de resultados (1000).
+         * @param {function(Array<{path:string, line:number, column:number, text:string}>):void} [options.onHits]
+         * @param {AbortSignal} [options.signal] Cancela la búsqueda.
+         * @returns {Promise<object|null>} { files, candidates, bytes, hits, truncated, indexed, ms };
+         *   se rechaza si la regex no es válida.
+         */
+        query: (text, { regex = false, caseSensitive = false, max = 1000, onHits, signal } = {}) => {
+            if (!isNative) return Promise.resolve(null);
+            const id = String(nextSearchId++);
+            openSearches.set(id, onHits || (() => {}));
+            const flags = (regex ? 'r' : '') + (caseSensitive ? 'c' : '');
+            return rpcCall("search", `${id}|${flags}|${max}|${text}`, { signal })
+                .then(JSON.parse)
+                .finally(() => openSearches.delete(id));
+        }
+    },
+
     storage: {
         save: (key, data) => {
             const content = typeof data === 'object' ? JSON.stringify(data) : data;
-            if (isNative) window.chrome.webview.postMessage(`saveFile:${key}.json|${content}`);
+            if (isNative) rpcSend("saveFile", `${key}.json|${content}`);
             else localStorage.setItem(`genesis_${key}`, content);
         },
         load: (key) => {
@@ -157,16 +698,107 @@ const Genesis = {
                     try { resolve(JSON.parse(data)); } catch(e) { resolve(data); }
                     return;
                 }
-                pendingCallbacks['load_' + key] = (content) => {
+                rpcCall("loadFile", key).then((content) => {
                     if (!content) resolve(null);
                     else {
                         try { resolve(JSON.parse(content)); } catch(e) { resolve(content); }
                     }
-                };
-                window.chrome.webview.postMessage(`loadFile:${key}`);
+                }, () => resolve(null));
             });
+        },
+        /**
+         * Espera a que los guardados pendientes lleguen a disco (se escriben en diferido).
+         * @returns {Promise<void>}
+         */
+        flush: () => isNative ? rpcCall("storageFlush").then(() => {}, () => {}) : Promise.resolve(),
+        /**
+         * Carga una clave en bloques, sin que el nativo llegue a tener el archivo entero en memoria.
+         * @param {string} key
+         * @param {object} [options]
+         * @param {number} [options.chunkSize] Bytes por bloque (256 KB por defecto).
+         * @param {number} [options.window] Bloques en vuelo como máximo.
+         * @param {function(string):void} [options.onChunk] Si se indica, el texto no se acumula.
+         * @param {function(number, number):void} [options.onProgress] (bytesLeídos, bytesTotales).
+         * @returns {Promise<string|null>} Contenido completo (o null si se usó onChunk / no existe).
+         */
+        loadStream: (key, { chunkSize = 256 * 1024, window: credits = 4, onChunk, onProgress } = {}) => {
+            if (!isNative) return Promise.resolve(localStorage.getItem(`genesis_${key}`));
+            return rpcCall("loadStream", `${key}|${chunkSize}`).then(reply => {
+                const id = parseInt(reply, 10);
+                return new Promise(resolve => {
+                    openStreams.set(id, { parts: [], onChunk, onProgress, resolve, ended: false });
+                    rpcCall("streamRead", `${id}|${credits}`).catch(() => {
+                        openStreams.delete(id);
+                        resolve(null);
+                    });
+                });
+            }, () => null);
         }
-    }
+    },
+
+    /**
+     * Diario de ediciones para documentos grandes (charts, proyectos del editor): cada cambio se
+     * guarda como un empalme, no el documento entero, y el historial de deshacer/rehacer persiste.
+     * Offsets y longitudes en unidades de string de JS. Solo en escritorio (en Web resuelve null).
+     */
+    journal: (() => {
+        const state = (reply) => {
+            const [rev, undo, redo] = reply.split('|', 3).map(Number);
+            return { rev, canUndo: undo > 0, canRedo: redo > 0 };
+        };
+        const cleanLabel = (label) => String(label ?? '').replace(/\|/g, '/');
+        const step = (verb, key) => {
+            if (!isNative) return Promise.resolve(null);
+            return rpcCall(verb, key).then(reply => {
+                const parts = reply.split('|');
+                const text = parts.slice(5).join('|');
+                return { ...state(reply), offset: Number(parts[3]), remove: Number(parts[4]), text };
+            }, () => null);
+        };
+        return {
+            /**
+             * Abre (o crea) el documento y lo reconstruye desde el diario.
+             * @param {string} key Ej: "charts/bopeebo-hard".
+             * @returns {Promise<{text:string, rev:number, canUndo:boolean, canRedo:boolean}|null>}
+             */
+            open: (key) => {
+                if (!isNative) return Promise.resolve(null);
+                return rpcCall("journalOpen", key).then(reply => {
+                    const parts = reply.split('|');
+                    return { ...state(reply), text: parts.slice(3).join('|') };
+                }, () => null);
+            },
+            /**
+             * Registra un empalme: en `offset` se quitan `remove` caracteres y se pone `insert`.
+             * Se rechaza con "stale edit" si el texto nativo no coincide con el de la página.
+             * @returns {Promise<{rev:number, canUndo:boolean, canRedo:boolean}>}
+             */
+            edit: (key, offset, remove, insert, label = '') =>
+                rpcCall("journalEdit", `${key}|${offset}|${remove}|${cleanLabel(label)}|${insert}`).then(state),
+            /**
+             * Registra el documento entero; el nativo calcula el cambio y solo escribe eso.
+             * @returns {Promise<{rev:number, canUndo:boolean, canRedo:boolean}>}
+             */
+            commit: (key, text, label = '') => {
+                const content = typeof text === 'object' ? JSON.stringify(text) : text;
+                return rpcCall("journalCommit", `${key}|${cleanLabel(label)}|${content}`).then(state);
+            },
+            /**
+             * Deshace la última edición. Para aplicarla a la copia de la página:
+             * `doc = doc.slice(0, r.offset) + r.text + doc.slice(r.offset + r.remove)`.
+             * @returns {Promise<{rev:number, canUndo:boolean, canRedo:boolean, offset:number, remove:number, text:string}|null>} null si no hay nada.
+             */
+            undo: (key) => step("journalUndo", key),
+            redo: (key) => step("journalRedo", key),
+            /**
+             * Etiquetas del historial, de la más antigua a la más reciente.
+             * @returns {Promise<{rev:number, undo:string[], redo:string[]}|null>}
+             */
+            history: (key) => isNative ? rpcCall("journalHistory", key).then(JSON.parse, () => null) : Promise.resolve(null),
+            /** Fuerza a disco y suelta el documento (se vuelve a abrir en la próxima llamada). */
+            close: (key) => isNative && rpcSend("journalClose", key)
+        };
+    })()
 };
 
 window.Genesis = Genesis;
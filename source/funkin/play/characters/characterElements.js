@@ -2,6 +2,9 @@
  * characterElements.js
  * Se encarga de cargar las texturas/atlas y crear los sprites de los personajes.
  */
+
+import { AtlasLoader } from "../../API/atlasLoader.js";
+
 export class CharacterElements {
   /**
    * @param {Phaser.Scene} scene
@@ -43,7 +46,7 @@ export class CharacterElements {
       const texturePath = `public/images/characters/${imagePath}.png`;
       const atlasPath = `public/images/characters/${imagePath}.xml`;
 
-      this.scene.load.atlasXML(textureKey, texturePath, atlasPath);
+      AtlasLoader.load(this.scene, textureKey, texturePath, atlasPath);
       console.log(`CharacterElements: Registrando carga de Atlas: ${texturePath} como ${textureKey}`);
     };
 
@@ -3,6 +3,9 @@
  * Maneja la lógica de configuración y offsets de las notas.
  * Lee un JSON de configuración y provee los datos a Strumline, NoteSpawner, etc.
  */
+
+import { AtlasLoader } from "../../API/atlasLoader.js";
+
 export class NoteSkin {
     
     constructor(scene, chartData) {
@@ -56,7 +59,7 @@ export class NoteSkin {
         const loadAtlas = (defName, fileName) => {
             const key = `${defName}_${this.skinName}`; // ej: noteStrumline_Funkin
             if (!this.scene.textures.exists(key)) {
-                this.scene.load.atlasXML(key, `${basePath}${fileName}.png`, `${basePath}${fileName}.xml`);
+                AtlasLoader.load(this.scene, key, `${basePath}${fileName}.png`, `${basePath}${fileName}.xml`);
             }
         };
 
@@ -42,7 +42,10 @@ export class StageElements {
             this.spritesheetHandler.preload(item);
         } else if (type === "image") {
             const namePath = item.namePath;
-            if (namePath) {
+            if (namePath && item.atlas) {
+                // Textura compartida generada por atlaspack
+                this.spritesheetHandler.preloadAtlas(item.atlas);
+            } else if (namePath) {
                 const textureKey = `stage_${this.stageDataKey}_${namePath}`;
                 if (!this.scene.textures.exists(textureKey)) {
                     const imagePath = `public/images/stages/${this.stageDataKey}/${namePath}.png`;
@@ -79,9 +82,11 @@ export class StageElements {
 
   _createSingleImage(item) {
       const namePath = item.namePath;
-      const textureKey = `stage_${this.stageDataKey}_${namePath}`;
+      // En un atlas compartido la imagen es el frame "<namePath>"
+      const textureKey = item.atlas ? this.spritesheetHandler.atlasKey(item.atlas) : `stage_${this.stageDataKey}_${namePath}`;
+      const frame = item.atlas ? namePath : undefined;
 
-      if (!this.scene.textures.exists(textureKey)) {
+      if (!this.scene.textures.exists(textureKey) || (frame && !this.scene.textures.get(textureKey).has(frame))) {
           console.warn(`StageElements: No se pudo crear el sprite, textura no encontrada: ${textureKey}`);
           return;
       }
@@ -98,7 +103,8 @@ export class StageElements {
       const sprite = this.scene.add.image(
           item.position[0],
           item.position[1],
-          textureKey
+          textureKey,
+          frame
       );
 
       // Usar el origen por defecto FIJO para imágenes.
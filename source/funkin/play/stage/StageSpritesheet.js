@@ -1,8 +1,13 @@
 /**
  * StageSpritesheet.js
  * Se encarga de precargar y crear los spritesheets animados de un escenario.
+ * Si `namePath` es la carpeta de un texture atlas de Animate horneado (Animation.ganm),
+ * se crea un AnimateSprite y las entradas de `play_list` son etiquetas de su línea principal.
  */
 
+import { AtlasLoader } from "../../API/atlasLoader.js";
+import { AnimateLoader, AnimateSprite } from "../../API/animateLoader.js";
+
 export const SPRITESHEET_ORIGIN = { x: 0.5, y: 0.5 };
 
 export class StageSpritesheet {
@@ -14,6 +19,27 @@ export class StageSpritesheet {
     
     this.createdSprites = [];
     this.beatListenerRegistered = false; 
+    this.queuedAtlases = new Set();
+  }
+
+  /**
+   * Clave de textura de un atlas generado por atlaspack (`<stage>-atlas<N>`).
+   */
+  atlasKey(atlas) {
+    return `stage_${this.stageDataKey}_${atlas}`;
+  }
+
+  /**
+   * Registra la carga de un atlas compartido una sola vez, aunque lo pidan varios elementos.
+   */
+  preloadAtlas(atlas) {
+    const key = this.atlasKey(atlas);
+    if (this.queuedAtlases.has(key) || this.scene.textures.exists(key)) return;
+    this.queuedAtlases.add(key);
+
+    const basePath = `public/images/stages/${this.stageDataKey}/${atlas}`;
+    AtlasLoader.load(this.scene, key, `${basePath}.png`, `${basePath}.xml`);
+    console.log(`StageSpritesheet: Registrando carga de Atlas compartido: ${basePath}.png`);
   }
 
   preload(item) {
@@ -23,31 +49,49 @@ export class StageSpritesheet {
       return;
     }
 
+    if (item.atlas) {
+      this.preloadAtlas(item.atlas);
+      return;
+    }
+
     const textureKey = `stage_${this.stageDataKey}_${namePath}`;
     if (this.scene.textures.exists(textureKey)) {
       return;
     }
 
     const basePath = `public/images/stages/${this.stageDataKey}/${namePath}`;
+    if (AnimateLoader.load(this.scene, textureKey, basePath)) {
+      console.log(`StageSpritesheet: Registrando carga de Animate horneado: ${basePath}`);
+      return;
+    }
+
     const imagePath = `${basePath}.png`;
     const xmlPath = `${basePath}.xml`;
 
-    this.scene.load.atlasXML(textureKey, imagePath, xmlPath);
+    AtlasLoader.load(this.scene, textureKey, imagePath, xmlPath);
     console.log(`StageSpritesheet: Registrando carga de Atlas: ${imagePath}`);
   }
 
   create(item) {
     const namePath = item.namePath;
     const textureKey = `stage_${this.stageDataKey}_${namePath}`;
+    // Con atlas compartido los frames son "<namePath>/<frame>"; las animaciones siguen con la clave lógica
+    const sheetKey = item.atlas ? this.atlasKey(item.atlas) : textureKey;
+    const framePrefix = item.atlas ? `${namePath}/` : "";
 
-    if (!this.scene.textures.exists(textureKey)) {
-      console.warn(`StageSpritesheet: Textura no encontrada para crear sprite: ${textureKey}`);
+    if (!item.atlas && AnimateLoader.get(this.scene, textureKey)) {
+      this.createAnimate(item, textureKey);
+      return;
+    }
+
+    if (!this.scene.textures.exists(sheetKey)) {
+      console.warn(`StageSpritesheet: Textura no encontrada para crear sprite: ${sheetKey}`);
       return;
     }
     
     // --- [NUEVO] Detectar Pixel Art ---
     if (item.isPixel) {
-        const texture = this.scene.textures.get(textureKey);
+        const texture = this.scene.textures.get(sheetKey);
         if (texture) {
             texture.setFilter(Phaser.Textures.FilterMode.NEAREST);
         }
@@ -75,12 +119,12 @@ export class StageSpritesheet {
             continue;
         }
 
-        const frameNames = animData.indices.map(idx => `${animData.prefix}${idx}`);
+        const frameNames = animData.indices.map(idx => `${framePrefix}${animData.prefix}${idx}`);
         
         const phaserFrames = [];
         for (const frame of frameNames) {
-            if (this.scene.textures.get(textureKey).has(frame)) {
-                phaserFrames.push({ key: textureKey, frame: frame });
+            if (this.scene.textures.get(sheetKey).has(frame)) {
+                phaserFrames.push({ key: sheetKey, frame: frame });
             }
         }
 
@@ -96,14 +140,14 @@ export class StageSpritesheet {
 
     const firstAnimName = animNames[0]; 
     const firstAnimData = play_list[firstAnimName];
-    const firstFrame = `${firstAnimData.prefix}${firstAnimData.indices[0]}`;
+    const firstFrame = `${framePrefix}${firstAnimData.prefix}${firstAnimData.indices[0]}`;
 
-    if (!this.scene.textures.get(textureKey).has(firstFrame)) {
+    if (!this.scene.textures.get(sheetKey).has(firstFrame)) {
         console.error(`StageSpritesheet: Frame inicial '${firstFrame}' no existe.`);
         return;
     }
 
-    const sprite = this.scene.add.sprite(item.position[0], item.position[1], textureKey, firstFrame);
+    const sprite = this.scene.add.sprite(item.position[0], item.position[1], sheetKey, firstFrame);
 
     sprite.setOrigin(0, 0); 
     
@@ -157,6 +201,60 @@ export class StageSpritesheet {
     this.createdSprites.push(sprite);
   }
 
+  /**
+   * Crea un AnimateSprite para un texture atlas de Animate horneado.
+   */
+  createAnimate(item, textureKey) {
+    const anim = item.animation || {};
+    const play_list = anim.play_list || {};
+    const play_mode = anim.play_mode || 'None';
+    // La etiqueta es el prefix de la entrada (o su nombre); sin entradas, toda la línea principal
+    const labels = Object.keys(play_list).map(name => (play_list[name] && play_list[name].prefix) || name);
+
+    const sprite = new AnimateSprite(this.scene, item.position[0], item.position[1], textureKey);
+    this.scene.add.existing(sprite);
+
+    const scale = item.scale ?? 1;
+    sprite.setScale(item.flip_x ? -scale : scale, item.flip_y ? -scale : scale);
+    sprite.setDepth(item.layer);
+    sprite.setAlpha(item.opacity ?? 1);
+
+    if (item.scroll_x !== undefined && item.scroll_y !== undefined) {
+        sprite.setScrollFactor(item.scroll_x, item.scroll_y);
+    } else {
+        sprite.setScrollFactor(item.scrollFactor ?? 1);
+    }
+
+    if (item.angle) {
+        sprite.setAngle(item.angle);
+    }
+
+    sprite.setData('baseX', item.position[0]);
+    sprite.setData('baseY', item.position[1]);
+
+    this.cameraManager.assignToGame(sprite);
+
+    if (play_mode === 'Loop') {
+        sprite.play(labels[0], true);
+    } else if (play_mode === 'Beat') {
+        const beatInterval = (anim.beat && anim.beat[0] > 0) ? anim.beat[0] : 1;
+
+        sprite.setData('beat_anim_list', labels.length > 0 ? labels : [undefined]);
+        sprite.setData('beat_anim_interval', beatInterval);
+        sprite.setData('beat_anim_index', 0);
+        sprite.setData('beat_anim_countdown', beatInterval);
+
+        sprite.play(labels[0], false);
+
+        if (this.conductor && !this.beatListenerRegistered) {
+            this.conductor.on('beat', this.onBeatUpdate, this);
+            this.beatListenerRegistered = true;
+        }
+    }
+
+    this.createdSprites.push(sprite);
+  }
+
   onBeatUpdate(beat) {
       if (!this.createdSprites || !this.scene) return;
 
@@ -177,7 +275,9 @@ export class StageSpritesheet {
               
               const nextAnimKey = animList[index];
               
-              if (this.scene && this.scene.anims.exists(nextAnimKey)) {
+              if (sprite instanceof AnimateSprite) {
+                  sprite.play(nextAnimKey, false);
+              } else if (this.scene && this.scene.anims.exists(nextAnimKey)) {
                   sprite.play(nextAnimKey);
               }
 
@@ -197,6 +297,7 @@ export class StageSpritesheet {
 
     this.createdSprites.forEach(s => s.destroy());
     this.createdSprites = [];
+    this.queuedAtlases.clear();
 
     this.conductor = null;
     this.scene = null;
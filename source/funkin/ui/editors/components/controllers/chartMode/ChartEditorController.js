@@ -5,6 +5,8 @@ export default class ChartEditorController {
     constructor(scene) {
         this.scene = scene;
         this.bg = null;
+        this.suggestions = null;
+        this.audio = null;
         this.isInitialized = false;
     }
 
@@ -54,11 +56,42 @@ export default class ChartEditorController {
         }
     }
 
+    /**
+     * Pide al nativo BPM y notas sugeridas para la canción (ver Genesis.songs.analyze).
+     * Quedan en this.suggestions hasta que el editor las pinte; null en el navegador.
+     * @param {string} songPath Carpeta de la canción (ej: "public/songs/Fresh").
+     * @param {{bpm?:number, subdivision?:number}} [opts]
+     */
+    async suggestNotes(songPath, opts = {}) {
+        const analysis = await window.Genesis?.songs.analyze(songPath, opts);
+        if (!analysis) return null;
+        console.log(`[ChartEditor] ${analysis.bpm} BPM (confianza ${analysis.confidence.toFixed(2)}), ` +
+            analysis.stems.map(s => `${s.role}: ${s.notes.length} notas`).join(', '));
+        this.suggestions = analysis;
+        return analysis;
+    }
+
+    /**
+     * Carga los stems en el reproductor nativo (ver Genesis.player). Su reloj manda: el editor lee
+     * la posición con songPosition() en vez de contar el tiempo, también a media velocidad.
+     * @param {string} songPath Carpeta de la canción (ej: "public/songs/Fresh").
+     */
+    async loadAudio(songPath) {
+        this.audio = await window.Genesis?.player.load(songPath) ?? null;
+        return this.audio;
+    }
+
+    /** ms de la canción que está sonando (0 sin audio cargado). */
+    songPosition() {
+        return this.audio ? window.Genesis.player.position() : 0;
+    }
+
     update(time, delta) {
         // Lógica futura del chart editor
     }
 
     destroy() {
         if (this.bg) this.bg.destroy();
+        if (this.audio) window.Genesis.player.close();
     }
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
  * source/funkin/ui/editors/components/controllers/stageMode/StageSpriteController.js
  */
 import Selecting from '../../elements/Selecting.js';
+import { AtlasLoader } from "../../../../../API/atlasLoader.js";
 
 export default class StageSpriteController {
     constructor(scene, actionHistory) {
@@ -141,7 +142,7 @@ export default class StageSpriteController {
             const pngURL = `${this.basePath}${stageName}/${key}.png`;
             const xmlURL = `${this.basePath}${stageName}/${key}.xml`;
             if (!this.scene.textures.exists(key)) {
-                this.scene.load.atlasXML(key, pngURL, xmlURL);
+                AtlasLoader.load(this.scene, key, pngURL, xmlURL);
                 loadCount++;
             }
         });
@@ -0,0 +1,583 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "Json.h"
+
+/**
+ * @namespace Animate
+ * @description Líneas de tiempo de Adobe Animate (Animation.json de un texture atlas) horneadas
+ * en ".ganm": para cada frame de la línea principal, la lista ya aplanada de sprites a dibujar
+ * con su matriz afín y su transformación de color finales. Los símbolos anidados, los bucles
+ * (LP / PO / SF) y los primeros frames (FF) se resuelven al hornear; reproducir es buscar el frame.
+ *
+ * Reglas de resolución (las de Animate):
+ *   - Una capa muestra en el frame f el keyframe con I <= f < I + DU.
+ *   - Las capas se dibujan de la última a la primera; los elementos de un keyframe, en orden.
+ *   - Un gráfico ("G") en el frame f de su keyframe muestra su frame FF + (f - I): en bucle
+ *     (LP), parado en el último (PO) o fijo en FF (SF). Un clip ("MC") va en bucle desde 0
+ *     desde su keyframe.
+ *   - M3D es una matriz 4x4 por columnas; solo cuentan a, b, c, d, tx, ty.
+ *   - Color: alfa (CA), tinte (T), avanzado (AD) y brillo (CBRT), compuestos padre * hijo.
+ *     Los filtros (F) no se hornean.
+ *   - La instancia de escena (STI), si la hay, envuelve la línea principal.
+ *
+ * Formato (little-endian):
+ *   Header (48 bytes)  "GANM", u16 versión, u16 tamaño del header, f32 fps, u32 frames, u32 listas,
+ *                      u32 dibujos, u32 sprites, u32 colores, u32 etiquetas, u32 bytes de cadenas,
+ *                      u32 reservado x2
+ *   Frames (4)         u32 lista del frame (frames iguales comparten lista)
+ *   Listas (8)         u32 primer dibujo, u32 número de dibujos
+ *   Dibujos (28)       f32 a, b, c, d, tx, ty, u16 sprite, u16 color
+ *   Sprites (4)        u32 nombre (como en el spritemap)
+ *   Colores (32)       f32 multiplicadores r, g, b, a, f32 sumandos r, g, b, a (0-255); el 0 es la identidad
+ *   Etiquetas (12)     u32 nombre, u32 primer frame, u32 frames
+ *   Cadenas            UTF-8 terminadas en '\0', sin repetir
+ */
+namespace Animate {
+
+    constexpr uint16_t kVersion = 1;
+    constexpr size_t kHeaderSize = 48, kFrameSize = 4, kListSize = 8, kDrawSize = 28, kSpriteSize = 4, kColorSize = 32, kLabelSize = 12;
+    /** Anidamiento máximo de símbolos (también corta ciclos). */
+    constexpr int kMaxDepth = 64;
+
+    /** x' = a x + c y + tx, y' = b x + d y + ty. */
+    struct Matrix {
+        double a = 1, b = 0, c = 0, d = 1, tx = 0, ty = 0;
+
+        /** Esta matriz aplicada después de `child`. */
+        Matrix Then(const Matrix& child) const {
+            return { a * child.a + c * child.b, b * child.a + d * child.b,
+                     a * child.c + c * child.d, b * child.c + d * child.d,
+                     a * child.tx + c * child.ty + tx, b * child.tx + d * child.ty + ty };
+        }
+    };
+
+    /** color' = color * mul + off, por canal (r, g, b, a; sumandos en 0-255). */
+    struct Color {
+        float mul[4] = { 1, 1, 1, 1 };
+        float off[4] = { 0, 0, 0, 0 };
+
+        Color Then(const Color& child) const {
+            Color o;
+            for (int i = 0; i < 4; i++) { o.mul[i] = mul[i] * child.mul[i]; o.off[i] = mul[i] * child.off[i] + off[i]; }
+            return o;
+        }
+        bool IsIdentity() const {
+            for (int i = 0; i < 4; i++) if (mul[i] != 1 || off[i] != 0) return false;
+            return true;
+        }
+        bool operator==(const Color& o) const { return std::memcmp(this, &o, sizeof(Color)) == 0; }
+    };
+
+    struct Draw {
+        uint32_t sprite = 0;
+        Matrix m;
+        Color color;
+    };
+
+    struct Label {
+        std::string name;
+        uint32_t first = 0, count = 0;
+    };
+
+    /** Un dibujo tal como va en el binario. */
+    struct PackedDraw {
+        float a, b, c, d, tx, ty;
+        uint16_t sprite, color;
+    };
+
+    struct List {
+        uint32_t first = 0, count = 0;
+    };
+
+    /** Tabla horneada (lo que se escribe y se lee). */
+    struct Table {
+        float fps = 24;
+        std::vector<uint32_t> frames;       // Lista de cada frame
+        std::vector<List> lists;
+        std::vector<PackedDraw> draws;
+        std::vector<std::string> sprites;
+        std::vector<Color> colors;          // [0] = identidad
+        std::vector<Label> labels;
+    };
+
+    // --- Lectura del JSON ---
+
+    enum class Loop : uint8_t { Loop, PlayOnce, Single };
+
+    struct Element {
+        bool symbol = false;        // false = sprite del atlas (ASI)
+        bool movieClip = false;
+        Loop loop = Loop::Loop;
+        uint32_t target = 0;        // Símbolo o sprite
+        uint32_t firstFrame = 0;
+        Matrix m;
+        Color color;
+    };
+
+    struct Keyframe {
+        uint32_t start = 0, duration = 0;
+        std::vector<Element> elements;
+    };
+
+    struct Symbol {
+        std::string name;
+        uint32_t length = 0;                    // max(I + DU) de sus capas
+        std::vector<std::vector<Keyframe>> layers;  // En orden de dibujo (la última capa del JSON primero)
+    };
+
+    /** Animation.json ya indexado: símbolos por número y sprites por nombre. */
+    struct Document {
+        float fps = 24;
+        std::vector<Symbol> symbols;
+        uint32_t main = 0;          // Símbolo de la línea principal
+        Element stage;              // Instancia de escena (identidad si no hay STI)
+        std::vector<std::string> sprites;
+        std::vector<Label> labels;
+        size_t missing = 0;         // Instancias de símbolos que no están en SD (se ignoran)
+    };
+
+    namespace Detail {
+        inline Matrix ReadMatrix(const Json::Value& m3d) {
+            Matrix m;
+            if (m3d.Size() >= 14) {
+                m.a = m3d[0].Num(1); m.b = m3d[1].Num(); m.c = m3d[4].Num(); m.d = m3d[5].Num(1);
+                m.tx = m3d[12].Num(); m.ty = m3d[13].Num();
+            }
+            return m;
+        }
+
+        inline float HexByte(std::string_view s, size_t at) {
+            auto nibble = [](char c) { return c >= '0' && c <= '9' ? c - '0' : (c >= 'a' && c <= 'f' ? c - 'a' + 10 : (c >= 'A' && c <= 'F' ? c - 'A' + 10 : 0)); };
+            return at + 1 < s.size() ? (float)(nibble(s[at]) * 16 + nibble(s[at + 1])) : 0.0f;
+        }
+
+        inline Color ReadColor(const Json::Value& c) {
+            Color o;
+            const std::string& mode = c["M"].Str();
+            if (mode == "CA") {
+                o.mul[3] = (float)c["AM"].Num(1);
+            } else if (mode == "T") {
+                float m = (float)c["TM"].Num();
+                std::string_view hex = c["TC"].Str();
+                if (!hex.empty() && hex[0] == '#') hex.remove_prefix(1);
+                for (int i = 0; i < 3; i++) { o.mul[i] = 1 - m; o.off[i] = HexByte(hex, (size_t)i * 2) * m; }
+            } else if (mode == "AD") {
+                const char* mk[] = { "RM", "GM", "BM", "AM" };
+                const char* ok[] = { "RO", "GO", "BO", "AO" };
+                for (int i = 0; i < 4; i++) { o.mul[i] = (float)c[mk[i]].Num(1); o.off[i] = (float)c[ok[i]].Num(); }
+            } else if (mode == "CBRT") {
+                float b = (float)c["BRT"].Num();
+                for (int i = 0; i < 3; i++) { o.mul[i] = 1 - std::fabs(b); o.off[i] = b > 0 ? 255 * b : 0; }
+            }
+            return o;
+        }
+
+        inline uint32_t Length(const std::vector<std::vector<Keyframe>>& layers) {
+            uint32_t n = 0;
+            for (const auto& l : layers) for (const auto& k : l) n = std::max(n, k.start + k.duration);
+            return n;
+        }
+    }
+
+    /**
+     * Indexa un Animation.json. Los nombres de símbolos y sprites se resuelven aquí una vez.
+     */
+    inline bool Parse(std::string_view text, Document& out, std::string* err = nullptr) {
+        out = Document();
+        Json::Value doc;
+        if (!Json::Parse(text, doc, err)) return false;
+        const Json::Value& an = doc["AN"];
+        if (!an["TL"]["L"].IsArray()) { if (err) *err = "missing AN.TL.L"; return false; }
+        out.fps = (float)doc["MD"]["FRT"].Num(24);
+
+        std::unordered_map<std::string, uint32_t> symbolOf, spriteOf;
+        const auto& defs = doc["SD"]["S"].Items();
+        out.symbols.resize(defs.size() + 1);
+        for (size_t i = 0; i < defs.size(); i++) {
+            out.symbols[i].name = defs[i]["SN"].Str();
+            symbolOf.emplace(out.symbols[i].name, (uint32_t)i);
+        }
+        out.main = (uint32_t)defs.size();
+        out.symbols[out.main].name = an["SN"].Str();
+
+        auto element = [&](const Json::Value& e, Element& el) {
+            if (const Json::Value& asi = e["ASI"]; asi.IsObject()) {
+                auto it = spriteOf.find(asi["N"].Str());
+                if (it == spriteOf.end()) {
+                    it = spriteOf.emplace(asi["N"].Str(), (uint32_t)out.sprites.size()).first;
+                    out.sprites.push_back(asi["N"].Str());
+                }
+                el.target = it->second;
+                el.m = Detail::ReadMatrix(asi["M3D"]);
+                return true;
+            }
+            const Json::Value& si = e["SI"];
+            if (!si.IsObject()) return false;
+            auto it = symbolOf.find(si["SN"].Str());
+            if (it == symbolOf.end()) { out.missing++; return false; }
+            el.symbol = true;
+            el.target = it->second;
+            el.movieClip = si["ST"].Str() == "MC";
+            const std::string& lp = si["LP"].Str();
+            el.loop = lp == "PO" ? Loop::PlayOnce : (lp == "SF" ? Loop::Single : Loop::Loop);
+            el.firstFrame = (uint32_t)std::max(0, si["FF"].Int());
+            el.m = Detail::ReadMatrix(si["M3D"]);
+            if (si["C"].IsObject()) el.color = Detail::ReadColor(si["C"]);
+            return true;
+        };
+
+        auto timeline = [&](const Json::Value& tl, Symbol& s) {
+            const auto& layers = tl["L"].Items();
+            for (size_t li = layers.size(); li-- > 0;) {
+                std::vector<Keyframe> keys;
+                for (const auto& fr : layers[li]["FR"].Items()) {
+                    Keyframe k;
+                    k.start = (uint32_t)std::max(0, fr["I"].Int());
+                    k.duration = (uint32_t)std::max(0, fr["DU"].Int());
+                    if (k.duration == 0) continue;
+                    for (const auto& e : fr["E"].Items()) {
+                        Element el;
+                        if (element(e, el)) k.elements.push_back(el);
+                    }
+                    keys.push_back(std::move(k));
+                }
+                std::stable_sort(keys.begin(), keys.end(), [](const Keyframe& a, const Keyframe& b) { return a.start < b.start; });
+                s.layers.push_back(std::move(keys));
+            }
+            s.length = Detail::Length(s.layers);
+        };
+
+        for (size_t i = 0; i < defs.size(); i++) timeline(defs[i]["TL"], out.symbols[i]);
+        timeline(an["TL"], out.symbols[out.main]);
+
+        // Las etiquetas de la línea principal marcan las animaciones que se piden por nombre
+        for (const auto& layer : an["TL"]["L"].Items()) {
+            for (const auto& fr : layer["FR"].Items()) {
+                if (!fr["N"].IsString() || fr["N"].Str().empty()) continue;
+                out.labels.push_back({ fr["N"].Str(), (uint32_t)std::max(0, fr["I"].Int()), (uint32_t)std::max(0, fr["DU"].Int()) });
+            }
+        }
+        std::stable_sort(out.labels.begin(), out.labels.end(), [](const Label& a, const Label& b) { return a.first < b.first; });
+
+        out.stage.symbol = true;
+        out.stage.target = out.main;
+        if (const Json::Value& sti = an["STI"]["SI"]; sti.IsObject()) {
+            out.stage.m = Detail::ReadMatrix(sti["M3D"]);
+            if (sti["C"].IsObject()) out.stage.color = Detail::ReadColor(sti["C"]);
+        }
+        return true;
+    }
+
+    /**
+     * Frame del símbolo hijo que muestra `el` cuando su keyframe lleva `local` frames en pantalla.
+     * @returns {bool} false si el símbolo está vacío.
+     */
+    inline bool ChildFrame(const Element& el, uint32_t length, uint32_t local, uint32_t& frame) {
+        if (length == 0) return false;
+        if (el.movieClip) { frame = local % length; return true; }
+        switch (el.loop) {
+        case Loop::Loop: frame = (uint32_t)(((uint64_t)el.firstFrame + local) % length); break;
+        case Loop::PlayOnce: frame = (uint32_t)std::min<uint64_t>((uint64_t)el.firstFrame + local, length - 1); break;
+        case Loop::Single: frame = std::min(el.firstFrame, length - 1); break;
+        }
+        return true;
+    }
+
+    /** Keyframe de una capa que se ve en `frame`, o nullptr. */
+    inline const Keyframe* KeyAt(const std::vector<Keyframe>& keys, uint32_t frame) {
+        auto it = std::upper_bound(keys.begin(), keys.end(), frame, [](uint32_t f, const Keyframe& k) { return f < k.start; });
+        if (it == keys.begin()) return nullptr;
+        --it;
+        return frame < it->start + it->duration ? &*it : nullptr;
+    }
+
+    /**
+     * @class Baker
+     * @description Aplana símbolos recordando cada (símbolo, frame) ya resuelto: un símbolo que
+     * aparece en cien frames de su padre se resuelve una vez por frame propio, no cien.
+     */
+    class Baker {
+    public:
+        explicit Baker(const Document& doc) : doc(doc) {}
+
+        /** Dibujos de `symbol` en su frame `frame`, en su espacio local. */
+        const std::vector<Draw>& Resolve(uint32_t symbol, uint32_t frame, int depth = 0) {
+            uint64_t key = ((uint64_t)symbol << 32) | frame;
+            auto it = memo.find(key);
+            if (it != memo.end()) return it->second;
+            std::vector<Draw> out;
+            if (depth < kMaxDepth) {
+                for (const auto& layer : doc.symbols[symbol].layers) {
+                    const Keyframe* k = KeyAt(layer, frame);
+                    if (!k) continue;
+                    for (const Element& el : k->elements) {
+                        if (!el.symbol) { out.push_back({ el.target, el.m, el.color }); continue; }
+                        uint32_t child = 0;
+                        if (!ChildFrame(el, doc.symbols[el.target].length, frame - k->start, child)) continue;
+                        for (const Draw& d : Resolve(el.target, child, depth + 1)) {
+                            out.push_back({ d.sprite, el.m.Then(d.m), el.color.Then(d.color) });
+                        }
+                    }
+                }
+            } else {
+                tooDeep = true;
+            }
+            return memo.emplace(key, std::move(out)).first->second;
+        }
+
+        /** Dibujos del frame `frame` de la línea principal, en coordenadas de la escena. */
+        std::vector<Draw> Frame(uint32_t frame) {
+            std::vector<Draw> out;
+            for (const Draw& d : Resolve(doc.main, frame)) out.push_back({ d.sprite, doc.stage.m.Then(d.m), doc.stage.color.Then(d.color) });
+            return out;
+        }
+
+        bool TooDeep() const { return tooDeep; }
+        size_t Resolved() const { return memo.size(); }
+
+    private:
+        const Document& doc;
+        std::unordered_map<uint64_t, std::vector<Draw>> memo;
+        bool tooDeep = false;
+    };
+
+    /**
+     * Hornea todos los frames de la línea principal. Los frames con la misma lista de dibujos
+     * (keyframes con DU > 1, pausas) la comparten.
+     */
+    inline bool Bake(const Document& doc, Table& out, std::string* err = nullptr) {
+        out = Table();
+        out.fps = doc.fps;
+        out.sprites = doc.sprites;
+        out.labels = doc.labels;
+        out.colors.push_back(Color());
+        if (doc.sprites.size() > 0xFFFF) { if (err) *err = "too many sprites"; return false; }
+
+        Baker baker(doc);
+        std::unordered_map<std::string, uint32_t> colorOf, listOf;
+        colorOf.emplace(std::string((const char*)&out.colors[0], sizeof(Color)), 0);
+        uint32_t length = doc.symbols[doc.main].length;
+        out.frames.reserve(length);
+        std::string bytes;
+        std::vector<PackedDraw> packed;
+        for (uint32_t f = 0; f < length; f++) {
+            std::vector<Draw> draws = baker.Frame(f);
+            packed.clear();
+            for (const Draw& d : draws) {
+                std::string ck((const char*)&d.color, sizeof(Color));
+                auto c = colorOf.find(ck);
+                if (c == colorOf.end()) {
+                    if (out.colors.size() > 0xFFFF) { if (err) *err = "too many colors"; return false; }
+                    c = colorOf.emplace(std::move(ck), (uint32_t)out.colors.size()).first;
+                    out.colors.push_back(d.color);
+                }
+                PackedDraw p;
+                p.a = (float)d.m.a; p.b = (float)d.m.b; p.c = (float)d.m.c; p.d = (float)d.m.d;
+                p.tx = (float)d.m.tx; p.ty = (float)d.m.ty;
+                p.sprite = (uint16_t)d.sprite; p.color = (uint16_t)c->second;
+                packed.push_back(p);
+            }
+            bytes.assign((const char*)packed.data(), packed.size() * sizeof(PackedDraw));
+            auto l = listOf.find(bytes);
+            if (l == listOf.end()) {
+                l = listOf.emplace(bytes, (uint32_t)out.lists.size()).first;
+                out.lists.push_back({ (uint32_t)out.draws.size(), (uint32_t)packed.size() });
+                out.draws.insert(out.draws.end(), packed.begin(), packed.end());
+            }
+            out.frames.push_back(l->second);
+        }
+        if (baker.TooDeep()) { if (err) *err = "symbols nested too deep (cycle?)"; return false; }
+        return true;
+    }
+
+    // --- Binario ---
+
+    namespace Detail {
+        inline void Put16(std::string& o, uint32_t v) { o += (char)(v & 0xFF); o += (char)((v >> 8) & 0xFF); }
+        inline void Put32(std::string& o, uint32_t v) { Put16(o, v & 0xFFFF); Put16(o, v >> 16); }
+        inline void PutFloat(std::string& o, float v) { uint32_t u; std::memcpy(&u, &v, 4); Put32(o, u); }
+        inline uint16_t Get16(const unsigned char* p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+        inline uint32_t Get32(const unsigned char* p) { return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24); }
+        inline float GetFloat(const unsigned char* p) { uint32_t u = Get32(p); float v; std::memcpy(&v, &u, 4); return v; }
+    }
+
+    inline bool Write(const Table& t, std::string& out, std::string* err = nullptr) {
+        using namespace Detail;
+        std::string strings;
+        std::unordered_map<std::string, uint32_t> interned;
+        auto intern = [&](const std::string& s) {
+            auto it = interned.find(s);
+            if (it != interned.end()) return it->second;
+            uint32_t off = (uint32_t)strings.size();
+            strings.append(s);
+            strings += '\0';
+            interned.emplace(s, off);
+            return off;
+        };
+        intern(std::string());
+        for (const PackedDraw& d : t.draws) {
+            if (d.sprite >= t.sprites.size() || d.color >= t.colors.size()) { if (err) *err = "draw out of range"; return false; }
+        }
+        for (uint32_t l : t.frames) if (l >= t.lists.size()) { if (err) *err = "frame out of range"; return false; }
+
+        out.clear();
+        out.reserve(kHeaderSize + t.frames.size() * kFrameSize + t.lists.size() * kListSize + t.draws.size() * kDrawSize
+            + t.sprites.size() * kSpriteSize + t.colors.size() * kColorSize + t.labels.size() * kLabelSize);
+        std::string body;
+        for (uint32_t l : t.frames) Put32(body, l);
+        for (const List& l : t.lists) { Put32(body, l.first); Put32(body, l.count); }
+        for (const PackedDraw& d : t.draws) {
+            for (float v : { d.a, d.b, d.c, d.d, d.tx, d.ty }) PutFloat(body, v);
+            Put16(body, d.sprite); Put16(body, d.color);
+        }
+        for (const std::string& s : t.sprites) Put32(body, intern(s));
+        for (const Color& c : t.colors) {
+            for (float v : c.mul) PutFloat(body, v);
+            for (float v : c.off) PutFloat(body, v);
+        }
+        for (const Label& l : t.labels) { Put32(body, intern(l.name)); Put32(body, l.first); Put32(body, l.count); }
+
+        out.append("GANM", 4);
+        Put16(out, kVersion); Put16(out, (uint32_t)kHeaderSize);
+        PutFloat(out, t.fps);
+        Put32(out, (uint32_t)t.frames.size()); Put32(out, (uint32_t)t.lists.size()); Put32(out, (uint32_t)t.draws.size());
+        Put32(out, (uint32_t)t.sprites.size()); Put32(out, (uint32_t)t.colors.size()); Put32(out, (uint32_t)t.labels.size());
+        Put32(out, (uint32_t)strings.size()); Put32(out, 0); Put32(out, 0);
+        out += body;
+        out += strings;
+        return true;
+    }
+
+    /**
+     * @class View
+     * @description Acceso directo a un .ganm en memoria: el frame i es una lista de dibujos
+     * contiguos. El buffer debe seguir vivo mientras se use la vista.
+     */
+    class View {
+    public:
+        bool Open(const void* data, size_t size, std::string* err = nullptr) {
+            using namespace Detail;
+            const unsigned char* base = (const unsigned char*)data;
+            if (size < kHeaderSize || std::memcmp(base, "GANM", 4) != 0) return Fail(err, "not a GANM file");
+            if (Get16(base + 4) != kVersion) return Fail(err, "unsupported GANM version");
+            size_t header = Get16(base + 6);
+            fps = GetFloat(base + 8);
+            frameCount = Get32(base + 12); listCount = Get32(base + 16); drawCount = Get32(base + 20);
+            spriteCount = Get32(base + 24); colorCount = Get32(base + 28); labelCount = Get32(base + 32);
+            stringBytes = Get32(base + 36);
+            if (header < kHeaderSize) return Fail(err, "corrupt header");
+            uint64_t need = (uint64_t)header + (uint64_t)frameCount * kFrameSize + (uint64_t)listCount * kListSize
+                + (uint64_t)drawCount * kDrawSize + (uint64_t)spriteCount * kSpriteSize + (uint64_t)colorCount * kColorSize
+                + (uint64_t)labelCount * kLabelSize + stringBytes;
+            if (need != size) return Fail(err, "size mismatch");
+            frames = base + header;
+            lists = frames + (size_t)frameCount * kFrameSize;
+            draws = lists + (size_t)listCount * kListSize;
+            sprites = draws + (size_t)drawCount * kDrawSize;
+            colors = sprites + (size_t)spriteCount * kSpriteSize;
+            labels = colors + (size_t)colorCount * kColorSize;
+            strings = (const char*)(labels + (size_t)labelCount * kLabelSize);
+            if (stringBytes == 0 || strings[stringBytes - 1] != '\0') return Fail(err, "corrupt string pool");
+            for (uint32_t i = 0; i < frameCount; i++) if (Get32(frames + (size_t)i * kFrameSize) >= listCount) return Fail(err, "corrupt frame");
+            for (uint32_t i = 0; i < listCount; i++) {
+                const unsigned char* l = lists + (size_t)i * kListSize;
+                if ((uint64_t)Get32(l) + Get32(l + 4) > drawCount) return Fail(err, "corrupt list");
+            }
+            for (uint32_t i = 0; i < drawCount; i++) {
+                const unsigned char* d = draws + (size_t)i * kDrawSize;
+                if (Get16(d + 24) >= spriteCount || Get16(d + 26) >= colorCount) return Fail(err, "corrupt draw");
+            }
+            for (uint32_t i = 0; i < spriteCount; i++) if (Get32(sprites + (size_t)i * kSpriteSize) >= stringBytes) return Fail(err, "corrupt sprite name");
+            for (uint32_t i = 0; i < labelCount; i++) {
+                const unsigned char* l = labels + (size_t)i * kLabelSize;
+                if (Get32(l) >= stringBytes) return Fail(err, "corrupt label");
+            }
+            return true;
+        }
+
+        float Fps() const { return fps; }
+        uint32_t FrameCount() const { return frameCount; }
+        uint32_t ListCount() const { return listCount; }
+        uint32_t DrawCount() const { return drawCount; }
+        uint32_t SpriteCount() const { return spriteCount; }
+        uint32_t ColorCount() const { return colorCount; }
+        uint32_t LabelCount() const { return labelCount; }
+
+        uint32_t ListOf(uint32_t frame) const { return Detail::Get32(frames + (size_t)frame * kFrameSize); }
+
+        List GetList(uint32_t i) const {
+            const unsigned char* l = lists + (size_t)i * kListSize;
+            return { Detail::Get32(l), Detail::Get32(l + 4) };
+        }
+
+        /** Dibujos del frame `i`: índices [first, first + count) para GetDraw. */
+        List FrameList(uint32_t i) const { return GetList(ListOf(i)); }
+
+        PackedDraw GetDraw(uint32_t i) const {
+            using namespace Detail;
+            const unsigned char* p = draws + (size_t)i * kDrawSize;
+            return { GetFloat(p), GetFloat(p + 4), GetFloat(p + 8), GetFloat(p + 12), GetFloat(p + 16), GetFloat(p + 20), Get16(p + 24), Get16(p + 26) };
+        }
+
+        std::string_view SpriteName(uint32_t i) const { return String(Detail::Get32(sprites + (size_t)i * kSpriteSize)); }
+
+        Color GetColor(uint32_t i) const {
+            const unsigned char* p = colors + (size_t)i * kColorSize;
+            Color c;
+            for (int k = 0; k < 4; k++) { c.mul[k] = Detail::GetFloat(p + k * 4); c.off[k] = Detail::GetFloat(p + 16 + k * 4); }
+            return c;
+        }
+
+        Label GetLabel(uint32_t i) const {
+            const unsigned char* p = labels + (size_t)i * kLabelSize;
+            return { std::string(String(Detail::Get32(p))), Detail::Get32(p + 4), Detail::Get32(p + 8) };
+        }
+
+        /**
+         * Busca una etiqueta por nombre.
+         * @returns {int64_t} Índice o -1.
+         */
+        int64_t FindLabel(std::string_view name) const {
+            for (uint32_t i = 0; i < labelCount; i++) if (String(Detail::Get32(labels + (size_t)i * kLabelSize)) == name) return i;
+            return -1;
+        }
+
+    private:
+        const unsigned char* frames = nullptr;
+        const unsigned char* lists = nullptr;
+        const unsigned char* draws = nullptr;
+        const unsigned char* sprites = nullptr;
+        const unsigned char* colors = nullptr;
+        const unsigned char* labels = nullptr;
+        const char* strings = nullptr;
+        float fps = 24;
+        uint32_t frameCount = 0, listCount = 0, drawCount = 0, spriteCount = 0, colorCount = 0, labelCount = 0, stringBytes = 0;
+
+        std::string_view String(uint32_t off) const { return std::string_view(strings + off); }
+        static bool Fail(std::string* err, const char* msg) { if (err) *err = msg; return false; }
+    };
+
+    /**
+     * Decodifica un .ganm completo en una tabla.
+     */
+    inline bool Read(const void* data, size_t size, Table& out, std::string* err = nullptr) {
+        View v;
+        if (!v.Open(data, size, err)) return false;
+        out = Table();
+        out.fps = v.Fps();
+        for (uint32_t i = 0; i < v.FrameCount(); i++) out.frames.push_back(v.ListOf(i));
+        for (uint32_t i = 0; i < v.ListCount(); i++) out.lists.push_back(v.GetList(i));
+        for (uint32_t i = 0; i < v.DrawCount(); i++) out.draws.push_back(v.GetDraw(i));
+        for (uint32_t i = 0; i < v.SpriteCount(); i++) out.sprites.emplace_back(v.SpriteName(i));
+        for (uint32_t i = 0; i < v.ColorCount(); i++) out.colors.push_back(v.GetColor(i));
+        for (uint32_t i = 0; i < v.LabelCount(); i++) out.labels.push_back(v.GetLabel(i));
+        return true;
+    }
+}
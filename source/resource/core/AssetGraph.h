@@ -0,0 +1,441 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "AtomicFile.h"
+#include "DirTree.h"
+#include "Json.h"
+#include "SongLibrary.h"
+
+/**
+ * @namespace AssetGraph
+ * @description Grafo de dependencias de una canción: todo lo que la partida carga para una
+ * canción y dificultad, con el tamaño de cada archivo, en el orden en que conviene precargarlo.
+ * Sigue las mismas reglas que el juego (ChartDataHandler, Stage, StageElements, Characters,
+ * NoteSkin, SongPlayer y healthIcon):
+ *
+ *   chart      public/songs/<canción>/charts/<canción>[-<dif>].json (+ Events.json si existe)
+ *   stage      public/data/stages/<stage>.json y stage.json, que se usa (con las imágenes de
+ *              "stage") si el primero no existe
+ *   imágenes   public/images/stages/<stage>/<namePath>.png (+ .xml si es spritesheet), o el atlas
+ *              compartido <atlas>.png + .xml si el elemento lo indica; los grupos se recorren
+ *   personajes public/data/characters/<nombre>.json -> public/images/characters/<image>.png + .xml
+ *              y, del jugador y el oponente, public/images/characters/icons/<healthicon>.png (o face.png)
+ *   noteSkin   public/data/noteSkins/<skin>.json -> public/images/noteSkins/<asset>/<imagen>.png + .xml
+ *   audio      public/songs/<canción>/song/Inst.ogg y Voices.ogg (o Voices-Player/-Opponent)
+ *
+ * Prioridades: 0 datos (JSON que deciden el resto), 1 lo que se ve en el primer frame de juego
+ * (notas, personajes, iconos), 2 escenario, 3 audio. Los .gatl que atlasc deja junto a un atlas y
+ * las voces se listan solo si existen; el resto, si falta, queda en el manifiesto marcado "missing".
+ *
+ * Los nombres se buscan primero tal cual y después sin distinguir mayúsculas, como en Windows.
+ * Los tamaños y fechas salen del DirTreeCache: con el watcher en marcha están siempre al día y los
+ * JSON de datos solo se vuelven a parsear cuando cambia su tamaño o su fecha.
+ */
+namespace AssetGraph {
+
+    using SongLibrary::Stamp;
+
+    enum class Kind : uint8_t { Chart, Events, Stage, Character, NoteSkin, Texture, Frames, Icon, Audio };
+
+    inline const char* KindName(Kind k) {
+        static const char* kNames[] = { "chart", "events", "stage", "character", "noteSkin", "texture", "frames", "icon", "audio" };
+        return kNames[(int)k];
+    }
+
+    struct Node {
+        std::string path;          // Relativa a la raíz, con '/'; tal como está en disco si existe
+        Kind kind = Kind::Chart;
+        uint8_t priority = 0;
+        bool missing = false;
+        uint64_t bytes = 0;
+    };
+
+    struct Manifest {
+        std::string song, difficulty;
+        std::vector<Node> nodes;   // Ordenados por prioridad; dentro de cada una, en orden de descubrimiento
+        uint64_t bytes = 0;        // Suma de los que existen
+        uint32_t missing = 0;
+        bool isChart = false;      // false = el chart no existe o no es un chart
+    };
+
+    struct Stats {
+        uint64_t parsed = 0;       // JSON de datos leídos en esta llamada
+        uint64_t reused = 0;       // Tomados de la caché (mismo tamaño y fecha)
+        double ms = 0.0;
+    };
+
+    /** Grafo de todas las canciones: lo que falta y lo que ninguna usa. */
+    struct Report {
+        std::vector<Manifest> manifests;
+        std::vector<Node> missing;            // Únicos, por ruta
+        std::vector<DirTreeCache::Item> orphans; // Rutas relativas a la raíz
+        uint64_t files = 0, bytes = 0;        // Todo lo alcanzable, sin repetir
+    };
+
+    /** Carpetas donde se buscan huérfanos; solo cuentan .png, .xml, .json y .ogg. */
+    inline const std::vector<std::string>& OrphanScope() {
+        static const std::vector<std::string> kScope = {
+            "public/data/characters", "public/data/stages", "public/data/noteSkins",
+            "public/images/characters", "public/images/stages", "public/images/noteSkins", "public/songs",
+        };
+        return kScope;
+    }
+
+    /**
+     * @class Graph
+     * @description Resuelve manifiestos con una caché de los JSON de datos ya leídos.
+     * No es seguro para hilos: el llamador serializa (en el puente, verbo Serial).
+     */
+    class Graph {
+    public:
+        /**
+         * Manifiesto de precarga de una canción.
+         * @param {DirTreeCache} tree - Raíz del juego (la carpeta que contiene public/).
+         * @param {string} difficulty - "normal" usa <canción>.json; el resto <canción>-<dif>.json.
+         */
+        void Resolve(DirTreeCache& tree, const std::string& song, const std::string& difficulty, Manifest& m, Stats* out = nullptr) {
+            auto t0 = std::chrono::steady_clock::now();
+            Stats st;
+            Walk walk{ tree, m, st, {} };
+            m = Manifest();
+            m.song = song;
+            m.difficulty = difficulty;
+
+            std::string songDir = "public/songs/" + song;
+            std::string lower = SongLibrary::Detail::Lower(difficulty);
+            const Data* chart = Load(walk, songDir + "/charts/" + song + (lower == "normal" ? "" : "-" + difficulty) + ".json", Kind::Chart, 0, true);
+            if (chart) Load(walk, songDir + "/charts/Events.json", Kind::Events, 0, false);
+            m.isChart = chart && chart->ok;
+            if (m.isChart) {
+                const std::string& stageName = chart->stage.empty() ? kDefaultStage : chart->stage;
+                // Stage.js pide siempre los dos: el del chart y stage.json por si aquel no existe
+                std::string stageKey = stageName;
+                const Data* stage = Load(walk, "public/data/stages/" + stageName + ".json", Kind::Stage, 0, true);
+                const Data* fallback = Load(walk, "public/data/stages/" + std::string(kDefaultStage) + ".json", Kind::Stage, 0, true);
+                if (!stage) {
+                    stage = fallback;
+                    stageKey = kDefaultStage;
+                }
+                // Jugador, oponente y gf; los dos primeros ponen los iconos de la barra de vida
+                const Data* characters[3] = {};
+                const std::string* names[3] = { &chart->player, &chart->enemy, &chart->gfVersion };
+                for (int i = 0; i < 3; i++) {
+                    if (!names[i]->empty()) characters[i] = Load(walk, "public/data/characters/" + *names[i] + ".json", Kind::Character, 0, true);
+                }
+                const Data* skin = Load(walk, "public/data/noteSkins/" + chart->noteSkin + ".json", Kind::NoteSkin, 0, true);
+                if (!skin && chart->noteSkin != kDefaultSkin) skin = Load(walk, "public/data/noteSkins/" + std::string(kDefaultSkin) + ".json", Kind::NoteSkin, 0, true);
+
+                if (skin) {
+                    std::string base = "public/images/noteSkins/" + (skin->asset.empty() ? std::string(kDefaultSkin) : skin->asset) + "/";
+                    for (const std::string& image : skin->atlases) AddAtlas(walk, base + image, 1);
+                }
+                for (const Data* c : characters) {
+                    if (!c || c->image.empty()) continue;
+                    std::string image = c->image;
+                    if (image.compare(0, 11, "characters/") == 0) image.erase(0, 11);
+                    AddAtlas(walk, "public/images/characters/" + image, 1);
+                }
+                // Como healthBar: "bf" y "dad" si el personaje no indica icono; si el icono no carga, face.png
+                for (int i = 0; i < 2; i++) {
+                    std::string icon = characters[i] && !characters[i]->icon.empty() ? characters[i]->icon : (i ? "dad" : "bf");
+                    if (!Add(walk, "public/images/characters/icons/" + icon + ".png", Kind::Icon, 1, true)) {
+                        Add(walk, "public/images/characters/icons/face.png", Kind::Icon, 1, true);
+                    }
+                }
+                if (stage) {
+                    std::string base = "public/images/stages/" + stageKey + "/";
+                    for (const StageItem& item : stage->items) {
+                        if (!item.atlas.empty()) AddAtlas(walk, base + item.atlas, 2);
+                        else if (item.sheet) AddAtlas(walk, base + item.name, 2);
+                        else Add(walk, base + item.name + ".png", Kind::Texture, 2, true);
+                    }
+                }
+                Add(walk, songDir + "/song/Inst.ogg", Kind::Audio, 3, true);
+                if (chart->needsVoices) {
+                    Add(walk, songDir + "/song/Voices-Player.ogg", Kind::Audio, 3, false);
+                    Add(walk, songDir + "/song/Voices-Opponent.ogg", Kind::Audio, 3, false);
+                } else {
+                    Add(walk, songDir + "/song/Voices.ogg", Kind::Audio, 3, false);
+                }
+            }
+
+            std::stable_sort(m.nodes.begin(), m.nodes.end(), [](const Node& a, const Node& b) { return a.priority < b.priority; });
+            for (const Node& n : m.nodes) {
+                if (n.missing) m.missing++;
+                else m.bytes += n.bytes;
+            }
+            st.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+            if (out) *out = st;
+        }
+
+        /**
+         * Grafo completo: un manifiesto por chart de public/songs, lo que falta en alguno y los
+         * archivos de OrphanScope que ninguno alcanza.
+         */
+        void Build(DirTreeCache& tree, Report& r, Stats* out = nullptr) {
+            auto t0 = std::chrono::steady_clock::now();
+            Stats st;
+            r = Report();
+            std::vector<DirTreeCache::Item> charts;
+            tree.List("public/songs", true, "*/charts/*.json", charts);
+            std::unordered_set<std::string> reached, missing;
+            for (const auto& item : charts) {
+                size_t slash = item.path.find('/');
+                std::string song = item.path.substr(0, slash);
+                std::string file = item.path.substr(item.path.rfind('/') + 1);
+                std::string stem = file.substr(0, file.size() - 5);
+                if (SongLibrary::Detail::Lower(stem) == "events") continue;
+                Manifest m;
+                Stats one;
+                Resolve(tree, song, SongLibrary::DifficultyOf(song, stem), m, &one);
+                st.parsed += one.parsed;
+                st.reused += one.reused;
+                if (!m.isChart) continue;
+                for (const Node& n : m.nodes) {
+                    std::string key = SongLibrary::Detail::Lower(n.path);
+                    if (n.missing) {
+                        if (missing.insert(key).second) r.missing.push_back(n);
+                    } else if (reached.insert(key).second) {
+                        r.files++;
+                        r.bytes += n.bytes;
+                    }
+                }
+                r.manifests.push_back(std::move(m));
+            }
+            for (const std::string& dir : OrphanScope()) {
+                std::vector<DirTreeCache::Item> items;
+                if (!tree.List(dir, true, {}, items)) continue;
+                for (auto& item : items) {
+                    if (item.isDir || !IsSource(item.path)) continue;
+                    item.path = dir + "/" + item.path;
+                    if (!reached.count(SongLibrary::Detail::Lower(item.path))) r.orphans.push_back(std::move(item));
+                }
+            }
+            st.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+            if (out) *out = st;
+        }
+
+        /** JSON del manifiesto: {"song","difficulty","isChart","bytes","missing","assets":[{"path","kind","priority","bytes","missing"}]} */
+        static void ToJson(const Manifest& m, std::string& j) {
+            j += "{\"song\":"; Json::AppendString(j, m.song);
+            j += ",\"difficulty\":"; Json::AppendString(j, m.difficulty);
+            j += ",\"isChart\":"; j += m.isChart ? "true" : "false";
+            j += ",\"bytes\":"; Json::AppendNumber(j, (double)m.bytes);
+            j += ",\"missing\":"; Json::AppendNumber(j, m.missing);
+            j += ",\"assets\":";
+            AppendNodes(j, m.nodes);
+            j += '}';
+        }
+
+        /** JSON del grafo completo: {"charts","files","bytes","missing":[nodos],"orphans":[{"path","bytes"}]} */
+        static void ToJson(const Report& r, std::string& j) {
+            j += "{\"charts\":"; Json::AppendNumber(j, (double)r.manifests.size());
+            j += ",\"files\":"; Json::AppendNumber(j, (double)r.files);
+            j += ",\"bytes\":"; Json::AppendNumber(j, (double)r.bytes);
+            j += ",\"missing\":";
+            AppendNodes(j, r.missing);
+            j += ",\"orphans\":[";
+            for (size_t i = 0; i < r.orphans.size(); i++) {
+                if (i) j += ',';
+                j += "{\"path\":"; Json::AppendString(j, r.orphans[i].path);
+                j += ",\"bytes\":"; Json::AppendNumber(j, (double)r.orphans[i].size);
+                j += '}';
+            }
+            j += "]}";
+        }
+
+        /** JSON de datos en la caché. */
+        size_t Cached() const { return cache.size(); }
+
+    private:
+        static constexpr const char* kDefaultStage = "stage";
+        static constexpr const char* kDefaultSkin = "Funkin";
+
+        struct StageItem {
+            std::string name, atlas;   // namePath y, si lo hay, el atlas compartido
+            bool sheet = false;
+        };
+
+        /** Lo leído de un JSON de datos; cada tipo rellena sus campos. */
+        struct Data {
+            Stamp stamp;
+            bool ok = false;
+            std::string player, enemy, gfVersion, stage, noteSkin;   // chart
+            bool needsVoices = false;
+            std::vector<StageItem> items;                             // stage
+            std::string image, icon;                                  // personaje
+            std::string asset;                                        // noteSkin
+            std::vector<std::string> atlases;
+        };
+
+        struct Walk {
+            DirTreeCache& tree;
+            Manifest& m;
+            Stats& st;
+            std::unordered_set<std::string> seen;   // Rutas en minúsculas ya añadidas
+        };
+
+        std::unordered_map<std::string, std::shared_ptr<const Data>> cache;
+
+        static bool IsSource(const std::string& path) {
+            using SongLibrary::Detail::EndsWithNoCase;
+            return EndsWithNoCase(path, ".png") || EndsWithNoCase(path, ".xml") || EndsWithNoCase(path, ".json") || EndsWithNoCase(path, ".ogg");
+        }
+
+        /**
+         * Busca `rel` en el árbol: primero el nombre exacto, después sin distinguir mayúsculas.
+         * @returns {bool} false si no existe; si existe, `path` queda con el nombre en disco.
+         */
+        static bool Find(DirTreeCache& tree, const std::string& rel, std::string& path, DirTreeCache::Entry& entry) {
+            if (!DirTreeCache::Normalize(rel, path) || path.empty()) return false;
+            size_t slash = path.rfind('/');
+            std::string parent = slash == std::string::npos ? std::string() : path.substr(0, slash);
+            std::string name = path.substr(slash + 1);
+            auto dir = tree.Get(parent);
+            if (!dir) return false;
+            auto it = dir->find(name);
+            if (it == dir->end()) {
+                std::string lower = SongLibrary::Detail::Lower(name);
+                it = std::find_if(dir->begin(), dir->end(), [&](const auto& e) { return SongLibrary::Detail::Lower(e.first) == lower; });
+                if (it == dir->end()) return false;
+                path = (parent.empty() ? "" : parent + "/") + it->first;
+            }
+            if (it->second.isDir) return false;
+            entry = it->second;
+            return true;
+        }
+
+        /**
+         * Añade un archivo al manifiesto (una sola vez). Uno que no existe se añade como "missing"
+         * solo si es `required`.
+         * @returns {bool} true si existe.
+         */
+        static bool Add(Walk& w, const std::string& rel, Kind kind, uint8_t priority, bool required,
+                        std::string* found = nullptr, DirTreeCache::Entry* entry = nullptr) {
+            Node n;
+            n.kind = kind;
+            n.priority = priority;
+            DirTreeCache::Entry e;
+            bool exists = Find(w.tree, rel, n.path, e);
+            if (!exists) {
+                if (!required) return false;
+                n.path = rel;
+                n.missing = true;
+            }
+            n.bytes = e.size;
+            if (found) *found = n.path;
+            if (entry) *entry = e;
+            if (w.seen.insert(SongLibrary::Detail::Lower(n.path)).second) w.m.nodes.push_back(std::move(n));
+            return exists;
+        }
+
+        /** Atlas Sparrow: PNG + XML y el .gatl compilado si existe. */
+        static void AddAtlas(Walk& w, const std::string& base, uint8_t priority) {
+            Add(w, base + ".png", Kind::Texture, priority, true);
+            Add(w, base + ".xml", Kind::Frames, priority, true);
+            Add(w, base + ".gatl", Kind::Frames, priority, false);
+        }
+
+        /**
+         * Añade un JSON de datos y devuelve lo leído de él (de la caché si no cambió).
+         * @returns {nullptr} si no existe.
+         */
+        const Data* Load(Walk& w, const std::string& rel, Kind kind, uint8_t priority, bool required) {
+            std::string path;
+            DirTreeCache::Entry e;
+            if (!Add(w, rel, kind, priority, required, &path, &e)) return nullptr;
+            Stamp stamp{ e.size, e.mtimeMs };
+            auto it = cache.find(path);
+            if (it != cache.end() && it->second->stamp == stamp) { w.st.reused++; return it->second.get(); }
+            auto data = std::make_shared<Data>();
+            data->stamp = stamp;
+            std::string text;
+            Json::Value doc;
+            if (AtomicFile::ReadAll(w.tree.Root() / std::filesystem::u8path(path), text) && Json::Parse(text, doc)) Parse(kind, doc, *data);
+            w.st.parsed++;
+            const Data* raw = data.get();
+            cache[path] = std::move(data);
+            return raw;
+        }
+
+        static void Parse(Kind kind, const Json::Value& doc, Data& d) {
+            switch (kind) {
+            case Kind::Chart: {
+                // Como ChartIndex: {"song":{...}} o el objeto directamente, con los alias player1/2/3
+                const Json::Value& s = doc["song"].IsObject() ? doc["song"] : doc;
+                d.ok = s["notes"].IsArray();
+                d.player = s["player"].Str(s["player1"].Str());
+                d.enemy = s["enemy"].Str(s["player2"].Str());
+                d.gfVersion = s["gfVersion"].Str(s["player3"].Str());
+                d.stage = s["stage"].Str();
+                d.noteSkin = s["noteSkin"].Str(kDefaultSkin);
+                d.needsVoices = s["needsVoices"].Bool();
+                break;
+            }
+            case Kind::Stage:
+                d.ok = doc["stage"].IsArray();
+                StageItems(doc["stage"], d.items, 0);
+                break;
+            case Kind::Character:
+                d.ok = doc.IsObject();
+                d.image = doc["image"].Str();
+                d.icon = doc["healthicon"].Str();
+                break;
+            case Kind::NoteSkin:
+                d.ok = doc.IsObject();
+                d.asset = doc["asset"].Str(kDefaultSkin);
+                for (const char* part : { "strumline", "notes", "sustain" }) {
+                    const std::string& image = doc[part]["image"].Str();
+                    if (!image.empty()) d.atlases.push_back(image);
+                }
+                break;
+            default:
+                d.ok = doc.IsObject();
+                break;
+            }
+        }
+
+        /** Como StageElements._traverseStageData: elementos con "type" o envueltos en {"clave":{...}}. */
+        static void StageItems(const Json::Value& list, std::vector<StageItem>& out, int depth) {
+            if (depth > 32) return;
+            for (const Json::Value& node : list.Items()) {
+                const Json::Value* item = &node;
+                if (!node.Has("type")) {
+                    if (node.Members().size() != 1) continue;
+                    item = &node.Members()[0].second;
+                }
+                const std::string& type = (*item)["type"].Str();
+                if (type == "group") { StageItems((*item)["children"], out, depth + 1); continue; }
+                if (type != "image" && type != "spritesheet") continue;
+                StageItem s;
+                s.name = (*item)["namePath"].Str();
+                s.atlas = (*item)["atlas"].Str();
+                s.sheet = type == "spritesheet";
+                if (!s.name.empty()) out.push_back(std::move(s));
+            }
+        }
+
+        static void AppendNodes(std::string& j, const std::vector<Node>& nodes) {
+            j += '[';
+            for (size_t i = 0; i < nodes.size(); i++) {
+                const Node& n = nodes[i];
+                if (i) j += ',';
+                j += "{\"path\":"; Json::AppendString(j, n.path);
+                j += ",\"kind\":"; Json::AppendString(j, KindName(n.kind));
+                j += ",\"priority\":"; Json::AppendNumber(j, n.priority);
+                j += ",\"bytes\":"; Json::AppendNumber(j, (double)n.bytes);
+                j += ",\"missing\":"; j += n.missing ? "true" : "false";
+                j += '}';
+            }
+            j += ']';
+        }
+    };
+}
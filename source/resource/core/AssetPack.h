@@ -0,0 +1,406 @@
+#pragma once
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "AtomicFile.h"
+#include "Lz.h"
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#include <io.h>
+#endif
+
+/**
+ * @namespace AssetPack
+ * @description Paquete de assets en un solo archivo (".gpak"), direccionado por contenido:
+ * los archivos idénticos (ej: las canciones repetidas en public/songs y public/assets/audio)
+ * comparten un único blob. Cada blob puede ir comprimido con Lz.
+ *
+ * Formato (little-endian):
+ *   Header (64)      "GPAK", u16 versión, u16 tamaño del header, u32 entradas, u32 blobs,
+ *                    u32 huecos hash, u32 reservado, u64 offset de entradas, u64 de blobs,
+ *                    u64 del hash, u64 de cadenas, u32 bytes de cadenas, u32 reservado
+ *   Datos            blobs alineados a 16 bytes
+ *   Entradas (16)    u64 hash de la ruta, u32 cadena de la ruta, u32 blob
+ *   Blobs (40)       u64 offset, u64 tamaño guardado, u64 tamaño original, u64 hash del
+ *                    contenido, u32 códec, u32 reservado
+ *   Hash (4/hueco)   entrada + 1 (0 = vacío), sondeo lineal sobre el hash de la ruta
+ *   Cadenas          rutas UTF-8 con '/' terminadas en '\0'
+ */
+namespace AssetPack {
+
+    namespace fs = std::filesystem;
+
+    constexpr uint16_t kVersion = 1;
+    constexpr size_t kHeaderSize = 64, kEntrySize = 16, kBlobSize = 40, kAlign = 16;
+
+    enum Codec : uint32_t { Stored = 0, Compressed = 1 };
+
+    /**
+     * FNV-1a de 64 bits. Sirve para rutas y contenido (el contenido además se compara byte a byte).
+     */
+    inline uint64_t Hash64(const void* data, size_t size, uint64_t h = 14695981039346656037ull) {
+        const unsigned char* p = (const unsigned char*)data;
+        for (size_t i = 0; i < size; i++) { h ^= p[i]; h *= 1099511628211ull; }
+        return h;
+    }
+
+    /**
+     * Ruta canónica dentro del paquete: separadores '/', sin '/' inicial ni "./".
+     */
+    inline std::string Normalize(std::string_view path) {
+        std::string out;
+        out.reserve(path.size());
+        for (char c : path) out += (c == '\\') ? '/' : c;
+        while (out.rfind("./", 0) == 0) out.erase(0, 2);
+        size_t start = out.find_first_not_of('/');
+        return start == std::string::npos ? std::string() : out.substr(start);
+    }
+
+    namespace Detail {
+        inline void Put16(std::string& o, uint32_t v) { o += (char)(v & 0xFF); o += (char)((v >> 8) & 0xFF); }
+        inline void Put32(std::string& o, uint32_t v) { Put16(o, v & 0xFFFF); Put16(o, v >> 16); }
+        inline void Put64(std::string& o, uint64_t v) { Put32(o, (uint32_t)v); Put32(o, (uint32_t)(v >> 32)); }
+        inline uint16_t Get16(const unsigned char* p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+        inline uint32_t Get32(const unsigned char* p) { return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24); }
+        inline uint64_t Get64(const unsigned char* p) { return (uint64_t)Get32(p) | ((uint64_t)Get32(p + 4) << 32); }
+
+        inline bool Seek(std::FILE* f, uint64_t pos) {
+#ifdef _WIN32
+            return _fseeki64(f, (long long)pos, SEEK_SET) == 0;
+#else
+            return fseeko(f, (off_t)pos, SEEK_SET) == 0;
+#endif
+        }
+    }
+
+    /**
+     * Extensiones de texto que vale la pena comprimir. Imágenes y audio ya vienen comprimidos.
+     */
+    inline bool IsCompressible(const std::string& path) {
+        static const char* exts[] = { ".json", ".xml", ".js", ".txt", ".html", ".css", ".frag", ".vert", ".glsl", ".svg", ".lua", ".hx", ".csv", ".gatl" };
+        size_t dot = path.rfind('.');
+        if (dot == std::string::npos) return false;
+        std::string ext = path.substr(dot);
+        for (auto& c : ext) c = (char)std::tolower((unsigned char)c);
+        for (const char* e : exts) if (ext == e) return true;
+        return false;
+    }
+
+    /**
+     * @class Writer
+     * @description Construye un paquete escribiendo los blobs según llegan; el índice va al final.
+     */
+    class Writer {
+    public:
+        struct Stats {
+            uint64_t files = 0;       // Entradas
+            uint64_t blobs = 0;       // Contenidos distintos
+            uint64_t rawBytes = 0;    // Suma de todos los archivos
+            uint64_t uniqueBytes = 0; // Suma de los contenidos distintos
+            uint64_t storedBytes = 0; // Lo que ocupan en el paquete (tras comprimir)
+        };
+
+        ~Writer() { if (file) { std::fclose(file); std::error_code ec; fs::remove(temp, ec); } }
+
+        /**
+         * Abre el paquete de salida (se escribe a un temporal y se renombra en Finish).
+         */
+        bool Open(const fs::path& out, std::string* err = nullptr) {
+            target = out;
+            temp = out; temp += ".tmp";
+            std::error_code ec;
+            if (out.has_parent_path()) fs::create_directories(out.parent_path(), ec);
+#ifdef _WIN32
+            file = _wfopen(temp.c_str(), L"w+b");
+#else
+            file = std::fopen(temp.c_str(), "w+b");
+#endif
+            if (!file) { if (err) *err = "cannot create " + temp.u8string(); return false; }
+            std::string header(kHeaderSize, '\0');
+            offset = 0;
+            return WriteRaw(header.data(), header.size(), err);
+        }
+
+        /**
+         * Añade un archivo. Si ya existía la misma ruta, la nueva la reemplaza.
+         * @param {bool} compress - Intentar comprimir (solo se queda si ahorra al menos un 10%).
+         */
+        bool Add(std::string_view path, const std::string& data, bool compress, std::string* err = nullptr) {
+            std::string key = Normalize(path);
+            if (key.empty()) { if (err) *err = "empty path"; return false; }
+            uint64_t hash = Hash64(data.data(), data.size());
+            stats.files++;
+            stats.rawBytes += data.size();
+
+            uint32_t blob = UINT32_MAX;
+            auto range = byContent.equal_range(hash);
+            for (auto it = range.first; it != range.second; ++it) {
+                if (blobs[it->second].raw == data.size() && SameContent(blobs[it->second], data)) { blob = it->second; break; }
+            }
+            if (blob == UINT32_MAX) {
+                Blob b;
+                b.raw = data.size();
+                b.hash = hash;
+                const std::string* payload = &data;
+                if (compress && data.size() >= 64) {
+                    packed.clear();
+                    Lz::Compress(data.data(), data.size(), packed);
+                    if (packed.size() * 10 <= data.size() * 9) { b.codec = Compressed; payload = &packed; }
+                }
+                if (!Pad(err)) return false;
+                b.offset = offset;
+                b.stored = payload->size();
+                if (!WriteRaw(payload->data(), payload->size(), err)) return false;
+                blob = (uint32_t)blobs.size();
+                blobs.push_back(b);
+                byContent.emplace(hash, blob);
+                stats.blobs++;
+                stats.uniqueBytes += b.raw;
+                stats.storedBytes += b.stored;
+            }
+
+            auto existing = byPath.find(key);
+            if (existing != byPath.end()) entries[existing->second].blob = blob;
+            else { byPath.emplace(key, (uint32_t)entries.size()); entries.push_back({ key, blob }); }
+            return true;
+        }
+
+        /**
+         * Añade todo el contenido de `dir` bajo el prefijo `prefix` (ej: "public").
+         */
+        bool AddDirectory(const fs::path& dir, const std::string& prefix, std::string* err = nullptr) {
+            std::vector<fs::path> files;
+            std::error_code ec;
+            for (auto it = fs::recursive_directory_iterator(dir, ec); !ec && it != fs::recursive_directory_iterator(); it.increment(ec)) {
+                if (it->is_regular_file(ec)) files.push_back(it->path());
+            }
+            if (ec) { if (err) *err = ec.message(); return false; }
+            std::sort(files.begin(), files.end()); // Paquetes reproducibles
+            std::string data;
+            for (const auto& f : files) {
+                if (!AtomicFile::ReadAll(f, data)) { if (err) *err = "cannot read " + f.u8string(); return false; }
+                std::string rel = f.lexically_relative(dir).generic_u8string();
+                std::string key = prefix.empty() ? rel : prefix + "/" + rel;
+                if (!Add(key, data, IsCompressible(key), err)) return false;
+            }
+            return true;
+        }
+
+        /**
+         * Escribe el índice, sincroniza y renombra el temporal sobre el destino.
+         */
+        bool Finish(std::string* err = nullptr) {
+            using namespace Detail;
+            if (!file) return false;
+            std::string strings;
+            std::string entryTable, blobTable;
+            uint32_t slots = 1;
+            while (slots < entries.size() * 2) slots <<= 1;
+            std::vector<uint32_t> hash(slots, 0);
+            for (uint32_t i = 0; i < entries.size(); i++) {
+                uint64_t h = Hash64(entries[i].path.data(), entries[i].path.size());
+                Put64(entryTable, h);
+                Put32(entryTable, (uint32_t)strings.size());
+                Put32(entryTable, entries[i].blob);
+                strings.append(entries[i].path);
+                strings += '\0';
+                for (uint32_t s = (uint32_t)h & (slots - 1);; s = (s + 1) & (slots - 1)) {
+                    if (hash[s] == 0) { hash[s] = i + 1; break; }
+                }
+            }
+            for (const Blob& b : blobs) {
+                Put64(blobTable, b.offset); Put64(blobTable, b.stored); Put64(blobTable, b.raw);
+                Put64(blobTable, b.hash); Put32(blobTable, b.codec); Put32(blobTable, 0);
+            }
+            std::string hashTable;
+            for (uint32_t v : hash) Put32(hashTable, v);
+
+            if (!Pad(err)) return false;
+            uint64_t entriesAt = offset;
+            uint64_t blobsAt = entriesAt + entryTable.size();
+            uint64_t hashAt = blobsAt + blobTable.size();
+            uint64_t stringsAt = hashAt + hashTable.size();
+            if (!WriteRaw(entryTable.data(), entryTable.size(), err) || !WriteRaw(blobTable.data(), blobTable.size(), err)
+                || !WriteRaw(hashTable.data(), hashTable.size(), err) || !WriteRaw(strings.data(), strings.size(), err)) return false;
+
+            std::string header;
+            header.append("GPAK", 4);
+            Put16(header, kVersion); Put16(header, (uint32_t)kHeaderSize);
+            Put32(header, (uint32_t)entries.size()); Put32(header, (uint32_t)blobs.size());
+            Put32(header, slots); Put32(header, 0);
+            Put64(header, entriesAt); Put64(header, blobsAt); Put64(header, hashAt); Put64(header, stringsAt);
+            Put32(header, (uint32_t)strings.size()); Put32(header, 0);
+            if (!Detail::Seek(file, 0) || std::fwrite(header.data(), 1, header.size(), file) != header.size()
+                || std::fflush(file) != 0) { if (err) *err = "write failed"; return false; }
+#ifdef _WIN32
+            bool synced = FlushFileBuffers((HANDLE)_get_osfhandle(_fileno(file))) != 0;
+#else
+            bool synced = ::fsync(fileno(file)) == 0;
+#endif
+            std::fclose(file);
+            file = nullptr;
+            std::error_code ec;
+            if (!synced) { if (err) *err = "fsync failed"; fs::remove(temp, ec); return false; }
+            fs::rename(temp, target, ec);
+            if (ec) { if (err) *err = ec.message(); fs::remove(temp, ec); return false; }
+            return true;
+        }
+
+        const Stats& GetStats() const { return stats; }
+
+    private:
+        struct Blob { uint64_t offset = 0, stored = 0, raw = 0, hash = 0; uint32_t codec = Stored; };
+        struct Entry { std::string path; uint32_t blob; };
+
+        fs::path target, temp;
+        std::FILE* file = nullptr;
+        uint64_t offset = 0;
+        std::vector<Blob> blobs;
+        std::vector<Entry> entries;
+        std::unordered_multimap<uint64_t, uint32_t> byContent;
+        std::unordered_map<std::string, uint32_t> byPath;
+        std::string packed, readBack;
+        Stats stats;
+
+        bool WriteRaw(const void* data, size_t size, std::string* err) {
+            if (size && std::fwrite(data, 1, size, file) != size) { if (err) *err = "write failed"; return false; }
+            offset += size;
+            return true;
+        }
+
+        bool Pad(std::string* err) {
+            static const char zeros[kAlign] = {};
+            size_t pad = (size_t)((kAlign - offset % kAlign) % kAlign);
+            return WriteRaw(zeros, pad, err);
+        }
+
+        /**
+         * Confirma una coincidencia de hash releyendo el blob ya escrito.
+         */
+        bool SameContent(const Blob& b, const std::string& data) {
+            readBack.resize((size_t)b.stored);
+            bool ok = Detail::Seek(file, b.offset) && (readBack.empty() || std::fread(&readBack[0], 1, readBack.size(), file) == readBack.size());
+            if (!Detail::Seek(file, offset) || !ok) return false;
+            if (b.codec == Stored) return readBack == data;
+            std::string raw;
+            return Lz::Decompress(readBack.data(), readBack.size(), (size_t)b.raw, raw) && raw == data;
+        }
+    };
+
+    /**
+     * Un asset dentro del paquete (apunta a la memoria mapeada).
+     */
+    struct Asset {
+        const char* data = nullptr;
+        uint64_t stored = 0;
+        uint64_t size = 0;      // Tamaño original
+        uint64_t hash = 0;      // Hash del contenido (sirve de ETag)
+        uint32_t codec = Stored;
+    };
+
+    /**
+     * @class Reader
+     * @description Acceso de solo lectura a un paquete mapeado en memoria. Thread-safe tras Open.
+     */
+    class Reader {
+    public:
+        bool Open(const fs::path& path, std::string* err = nullptr) {
+            using namespace Detail;
+            Close();
+            if (!file.Open(path)) { if (err) *err = "cannot open " + path.u8string(); return false; }
+            base = (const unsigned char*)file.Data();
+            uint64_t size = file.Size();
+            if (!base || size < kHeaderSize || std::memcmp(base, "GPAK", 4) != 0) return Fail(err, "not a GPAK file");
+            if (Get16(base + 4) != kVersion) return Fail(err, "unsupported GPAK version");
+            entryCount = Get32(base + 8); blobCount = Get32(base + 12); slots = Get32(base + 16);
+            uint64_t entriesAt = Get64(base + 24), blobsAt = Get64(base + 32), hashAt = Get64(base + 40), stringsAt = Get64(base + 48);
+            stringBytes = Get32(base + 56);
+            if (slots == 0 || (slots & (slots - 1)) != 0 || slots < entryCount
+                || entriesAt + (uint64_t)entryCount * kEntrySize > size || blobsAt + (uint64_t)blobCount * kBlobSize > size
+                || hashAt + (uint64_t)slots * 4 > size || stringsAt + stringBytes != size
+                || (stringBytes && base[size - 1] != 0)) return Fail(err, "corrupt index");
+            entries = base + entriesAt; blobs = base + blobsAt; hash = base + hashAt; strings = (const char*)base + stringsAt;
+            for (uint32_t i = 0; i < blobCount; i++) {
+                const unsigned char* b = blobs + (size_t)i * kBlobSize;
+                if (Get64(b) + Get64(b + 8) > size || Get32(b + 32) > Compressed) return Fail(err, "corrupt blob table");
+            }
+            for (uint32_t i = 0; i < entryCount; i++) {
+                const unsigned char* e = entries + (size_t)i * kEntrySize;
+                if (Get32(e + 8) >= stringBytes || Get32(e + 12) >= blobCount) return Fail(err, "corrupt entry table");
+            }
+            return true;
+        }
+
+        void Close() { file.Close(); base = nullptr; entryCount = blobCount = slots = stringBytes = 0; }
+
+        bool IsOpen() const { return base != nullptr; }
+        uint32_t EntryCount() const { return entryCount; }
+        uint32_t BlobCount() const { return blobCount; }
+        uint64_t FileSize() const { return file.Size(); }
+
+        /**
+         * Busca una ruta ("public/images/x.png").
+         */
+        bool Find(std::string_view path, Asset& out) const {
+            if (!base) return false;
+            std::string key;
+            if (!path.empty() && (path[0] == '/' || path.find('\\') != std::string_view::npos || path.rfind("./", 0) == 0)) { key = Normalize(path); path = key; }
+            uint64_t h = Hash64(path.data(), path.size());
+            for (uint32_t s = (uint32_t)h & (slots - 1), n = 0; n < slots; s = (s + 1) & (slots - 1), n++) {
+                uint32_t v = Detail::Get32(hash + (size_t)s * 4);
+                if (v == 0 || v > entryCount) return false;
+                const unsigned char* e = entries + (size_t)(v - 1) * kEntrySize;
+                if (Detail::Get64(e) != h || Path(v - 1) != path) continue;
+                out = GetBlob(Detail::Get32(e + 12));
+                return true;
+            }
+            return false;
+        }
+
+        std::string_view Path(uint32_t entry) const { return std::string_view(strings + Detail::Get32(entries + (size_t)entry * kEntrySize + 8)); }
+
+        Asset EntryAsset(uint32_t entry) const { return GetBlob(Detail::Get32(entries + (size_t)entry * kEntrySize + 12)); }
+
+        /**
+         * Copia (y descomprime si hace falta) el contenido de un asset.
+         */
+        static bool Read(const Asset& a, std::string& out) {
+            if (a.codec == Compressed) return Lz::Decompress(a.data, (size_t)a.stored, (size_t)a.size, out);
+            out.assign(a.data, (size_t)a.size);
+            return true;
+        }
+
+        bool Read(std::string_view path, std::string& out) const {
+            Asset a;
+            return Find(path, a) && Read(a, out);
+        }
+
+    private:
+        MappedFile file;
+        const unsigned char* base = nullptr;
+        const unsigned char* entries = nullptr;
+        const unsigned char* blobs = nullptr;
+        const unsigned char* hash = nullptr;
+        const char* strings = nullptr;
+        uint32_t entryCount = 0, blobCount = 0, slots = 0, stringBytes = 0;
+
+        Asset GetBlob(uint32_t i) const {
+            using namespace Detail;
+            const unsigned char* b = blobs + (size_t)i * kBlobSize;
+            Asset a;
+            a.data = (const char*)base + Get64(b);
+            a.stored = Get64(b + 8); a.size = Get64(b + 16); a.hash = Get64(b + 24); a.codec = Get32(b + 32);
+            return a;
+        }
+
+        bool Fail(std::string* err, const char* msg) { if (err) *err = msg; Close(); return false; }
+    };
+}
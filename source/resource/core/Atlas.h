@@ -0,0 +1,462 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "Json.h"
+
+/**
+ * @namespace Atlas
+ * @description Atlas de frames (Sparrow XML de Adobe Animate y spritemap JSON) y su forma
+ * compilada ".gatl": tabla binaria de frames con nombres internados, animaciones agrupadas por
+ * prefijo y una tabla hash para buscar frames por nombre sin decodificar nada.
+ *
+ * Formato (little-endian):
+ *   Header (32 bytes)  "GATL", u16 versión, u16 tamaño del header, u32 frames, u32 animaciones,
+ *                      u32 huecos hash, u32 bytes de cadenas, u32 cadena de imagen, u32 reservado
+ *   Frames (24 bytes)  u32 nombre, u16 x, y, w, h, i16 frameX, frameY, u16 frameW, frameH,
+ *                      u16 flags, u16 animación
+ *   Animaciones (12)   u32 prefijo, u32 primer frame, u32 número de frames
+ *   Hash (4 por hueco) índice de frame + 1 (0 = vacío), FNV-1a del nombre, sondeo lineal
+ *   Cadenas            UTF-8 terminadas en '\0', sin repetir
+ */
+namespace Atlas {
+
+    constexpr uint16_t kVersion = 1;
+    constexpr size_t kHeaderSize = 32, kFrameSize = 24, kAnimSize = 12;
+    constexpr uint16_t kRotated = 1, kTrimmed = 2;
+
+    struct Frame {
+        std::string name;
+        int32_t x = 0, y = 0, w = 0, h = 0;
+        int32_t frameX = 0, frameY = 0, frameW = 0, frameH = 0; // Recorte (solo si trimmed)
+        bool rotated = false, trimmed = false;
+        uint32_t anim = 0;
+    };
+
+    struct Anim {
+        std::string prefix;
+        uint32_t first = 0, count = 0;
+    };
+
+    struct Table {
+        std::string image;
+        std::vector<Frame> frames;
+        std::vector<Anim> anims;
+    };
+
+    inline uint32_t Hash(std::string_view s) {
+        uint32_t h = 2166136261u;
+        for (unsigned char c : s) { h ^= c; h *= 16777619u; }
+        return h;
+    }
+
+    /**
+     * Prefijo de animación: el nombre sin los dígitos finales ("BF idle0004" -> "BF idle").
+     */
+    inline std::string_view PrefixOf(std::string_view name) {
+        size_t n = name.size();
+        while (n > 0 && name[n - 1] >= '0' && name[n - 1] <= '9') n--;
+        return name.substr(0, n);
+    }
+
+    /**
+     * Agrupa los frames por prefijo (en orden de primera aparición, manteniendo el orden
+     * original dentro de cada grupo) y rellena `anims`.
+     */
+    inline void Group(Table& t) {
+        std::unordered_map<std::string_view, uint32_t> groupOf;
+        std::vector<uint32_t> key(t.frames.size());
+        std::vector<std::string> prefixes;
+        for (size_t i = 0; i < t.frames.size(); i++) {
+            std::string_view p = PrefixOf(t.frames[i].name);
+            auto it = groupOf.find(p);
+            if (it == groupOf.end()) { it = groupOf.emplace(p, (uint32_t)prefixes.size()).first; prefixes.emplace_back(p); }
+            key[i] = it->second;
+        }
+        std::vector<uint32_t> order(t.frames.size());
+        for (uint32_t i = 0; i < order.size(); i++) order[i] = i;
+        std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return key[a] < key[b]; });
+
+        std::vector<Frame> sorted;
+        sorted.reserve(t.frames.size());
+        t.anims.assign(prefixes.size(), Anim());
+        for (size_t g = 0; g < prefixes.size(); g++) t.anims[g].prefix = prefixes[g];
+        for (uint32_t idx : order) {
+            Anim& a = t.anims[key[idx]];
+            if (a.count == 0) a.first = (uint32_t)sorted.size();
+            a.count++;
+            sorted.push_back(std::move(t.frames[idx]));
+            sorted.back().anim = key[idx];
+        }
+        t.frames.swap(sorted);
+    }
+
+    // --- Sparrow XML ---
+
+    namespace Detail {
+        inline void AppendUtf8(std::string& out, uint32_t cp) {
+            if (cp < 0x80) out += (char)cp;
+            else if (cp < 0x800) { out += (char)(0xC0 | (cp >> 6)); out += (char)(0x80 | (cp & 0x3F)); }
+            else if (cp < 0x10000) { out += (char)(0xE0 | (cp >> 12)); out += (char)(0x80 | ((cp >> 6) & 0x3F)); out += (char)(0x80 | (cp & 0x3F)); }
+            else { out += (char)(0xF0 | (cp >> 18)); out += (char)(0x80 | ((cp >> 12) & 0x3F)); out += (char)(0x80 | ((cp >> 6) & 0x3F)); out += (char)(0x80 | (cp & 0x3F)); }
+        }
+
+        /**
+         * Decodifica las entidades XML de un valor de atributo.
+         */
+        inline std::string Unescape(std::string_view v) {
+            if (v.find('&') == std::string_view::npos) return std::string(v);
+            std::string out;
+            out.reserve(v.size());
+            for (size_t i = 0; i < v.size(); i++) {
+                if (v[i] != '&') { out += v[i]; continue; }
+                size_t semi = v.find(';', i);
+                if (semi == std::string_view::npos) { out += v[i]; continue; }
+                std::string_view ent = v.substr(i + 1, semi - i - 1);
+                if (ent == "amp") out += '&';
+                else if (ent == "lt") out += '<';
+                else if (ent == "gt") out += '>';
+                else if (ent == "quot") out += '"';
+                else if (ent == "apos") out += '\'';
+                else if (ent.size() > 1 && ent[0] == '#') {
+                    bool hex = ent[1] == 'x' || ent[1] == 'X';
+                    uint32_t cp = (uint32_t)std::strtoul(std::string(ent.substr(hex ? 2 : 1)).c_str(), nullptr, hex ? 16 : 10);
+                    AppendUtf8(out, cp ? cp : 0xFFFD);
+                }
+                else { out.append(v.substr(i, semi - i + 1)); }
+                i = semi;
+            }
+            return out;
+        }
+
+        /**
+         * Recorre los atributos `nombre="valor"` de una etiqueta hasta '>' .
+         * @returns {size_t} Posición tras el cierre de la etiqueta.
+         */
+        template <typename Fn>
+        inline size_t ForEachAttribute(std::string_view text, size_t pos, Fn&& fn) {
+            while (pos < text.size()) {
+                while (pos < text.size() && (text[pos] == ' ' || text[pos] == '\t' || text[pos] == '\r' || text[pos] == '\n')) pos++;
+                if (pos >= text.size()) break;
+                if (text[pos] == '>') return pos + 1;
+                if (text[pos] == '/' && pos + 1 < text.size() && text[pos + 1] == '>') return pos + 2;
+                size_t eq = text.find('=', pos);
+                if (eq == std::string_view::npos) break;
+                std::string_view name = text.substr(pos, eq - pos);
+                while (!name.empty() && (name.back() == ' ' || name.back() == '\t')) name.remove_suffix(1);
+                size_t q = eq + 1;
+                while (q < text.size() && (text[q] == ' ' || text[q] == '\t')) q++;
+                if (q >= text.size() || (text[q] != '"' && text[q] != '\'')) break;
+                size_t close = text.find(text[q], q + 1);
+                if (close == std::string_view::npos) break;
+                fn(name, text.substr(q + 1, close - q - 1));
+                pos = close + 1;
+            }
+            return std::string_view::npos;
+        }
+
+        inline int32_t ToInt(std::string_view v) {
+            // Algunos exportadores escriben decimales ("12.5"); Phaser usa parseInt, que trunca
+            bool neg = !v.empty() && v[0] == '-';
+            if (neg || (!v.empty() && v[0] == '+')) v.remove_prefix(1);
+            int64_t n = 0;
+            for (char c : v) { if (c < '0' || c > '9') break; n = n * 10 + (c - '0'); if (n > 0x7FFFFFFF) break; }
+            return (int32_t)(neg ? -n : n);
+        }
+    }
+
+    /**
+     * Parsea un TextureAtlas de Sparrow (los .xml de Adobe Animate).
+     */
+    inline bool ParseSparrow(std::string_view text, Table& out, std::string* err = nullptr) {
+        out = Table();
+        size_t root = text.find("<TextureAtlas");
+        if (root == std::string_view::npos) { if (err) *err = "missing <TextureAtlas>"; return false; }
+        size_t pos = Detail::ForEachAttribute(text, root + 13, [&](std::string_view k, std::string_view v) {
+            if (k == "imagePath") out.image = Detail::Unescape(v);
+        });
+        while (pos != std::string_view::npos) {
+            size_t tag = text.find("<SubTexture", pos);
+            if (tag == std::string_view::npos) break;
+            Frame f;
+            bool hasFrameX = false;
+            pos = Detail::ForEachAttribute(text, tag + 11, [&](std::string_view k, std::string_view v) {
+                if (k == "name") f.name = Detail::Unescape(v);
+                else if (k == "x") f.x = Detail::ToInt(v);
+                else if (k == "y") f.y = Detail::ToInt(v);
+                else if (k == "width") f.w = Detail::ToInt(v);
+                else if (k == "height") f.h = Detail::ToInt(v);
+                else if (k == "frameX") { f.frameX = Detail::ToInt(v); hasFrameX = true; }
+                else if (k == "frameY") f.frameY = Detail::ToInt(v);
+                else if (k == "frameWidth") f.frameW = Detail::ToInt(v);
+                else if (k == "frameHeight") f.frameH = Detail::ToInt(v);
+                else if (k == "rotated") f.rotated = v == "true";
+            });
+            if (pos == std::string_view::npos) { if (err) *err = "unterminated <SubTexture> at offset " + std::to_string(tag); return false; }
+            f.trimmed = hasFrameX;
+            out.frames.push_back(std::move(f));
+        }
+        Group(out);
+        return true;
+    }
+
+    /**
+     * Parsea un spritemap de Adobe Animate ("ATLAS.SPRITES[].SPRITE").
+     */
+    inline bool ParseSpritemap(std::string_view text, Table& out, std::string* err = nullptr) {
+        out = Table();
+        Json::Value doc;
+        if (!Json::Parse(text, doc, err)) return false;
+        const Json::Value& sprites = doc["ATLAS"]["SPRITES"];
+        if (!sprites.IsArray()) { if (err) *err = "missing ATLAS.SPRITES"; return false; }
+        out.image = doc["meta"]["image"].Str();
+        out.frames.reserve(sprites.Size());
+        for (const auto& item : sprites.Items()) {
+            const Json::Value& s = item["SPRITE"];
+            if (!s.IsObject()) continue;
+            Frame f;
+            f.name = s["name"].Str();
+            f.x = s["x"].Int(); f.y = s["y"].Int(); f.w = s["w"].Int(); f.h = s["h"].Int();
+            f.rotated = s["rotated"].Bool(false);
+            out.frames.push_back(std::move(f));
+        }
+        Group(out);
+        return true;
+    }
+
+    namespace Detail {
+        inline void Escape(std::string& out, std::string_view v) {
+            for (char c : v) {
+                switch (c) {
+                case '&': out += "&amp;"; break;
+                case '<': out += "&lt;"; break;
+                case '>': out += "&gt;"; break;
+                case '"': out += "&quot;"; break;
+                default: out += c;
+                }
+            }
+        }
+    }
+
+    /**
+     * Escribe la tabla como TextureAtlas de Sparrow (lo que leen ParseSparrow y el atlasXML de Phaser).
+     */
+    inline void WriteSparrow(const Table& t, std::string& out) {
+        out += "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n<TextureAtlas imagePath=\"";
+        Detail::Escape(out, t.image);
+        out += "\">\n";
+        for (const Frame& f : t.frames) {
+            out += "\t<SubTexture name=\"";
+            Detail::Escape(out, f.name);
+            out += "\" x=\"" + std::to_string(f.x) + "\" y=\"" + std::to_string(f.y);
+            out += "\" width=\"" + std::to_string(f.w) + "\" height=\"" + std::to_string(f.h) + "\"";
+            if (f.trimmed) {
+                out += " frameX=\"" + std::to_string(f.frameX) + "\" frameY=\"" + std::to_string(f.frameY);
+                out += "\" frameWidth=\"" + std::to_string(f.frameW) + "\" frameHeight=\"" + std::to_string(f.frameH) + "\"";
+            }
+            if (f.rotated) out += " rotated=\"true\"";
+            out += "/>\n";
+        }
+        out += "</TextureAtlas>\n";
+    }
+
+    /**
+     * Escribe la tabla como spritemap de Adobe Animate. `width` x `height` es el tamaño de la imagen.
+     */
+    inline void WriteSpritemap(const Table& t, int width, int height, std::string& out) {
+        out += "{\"ATLAS\":{\"SPRITES\":[\n";
+        for (size_t i = 0; i < t.frames.size(); i++) {
+            const Frame& f = t.frames[i];
+            out += i ? ",\n" : "";
+            out += "{\"SPRITE\":{\"name\":";
+            Json::AppendString(out, f.name);
+            out += ",\"x\":" + std::to_string(f.x) + ",\"y\":" + std::to_string(f.y);
+            out += ",\"w\":" + std::to_string(f.w) + ",\"h\":" + std::to_string(f.h);
+            out += f.rotated ? ",\"rotated\":true}}" : ",\"rotated\":false}}";
+        }
+        out += "\n]},\n\"meta\":{\"app\":\"atlaspack\",\"version\":\"1\",\"image\":";
+        Json::AppendString(out, t.image);
+        out += ",\"format\":\"RGBA8888\",\"size\":{\"w\":" + std::to_string(width) + ",\"h\":" + std::to_string(height);
+        out += "},\"resolution\":\"1\"}\n}\n";
+    }
+
+    // --- Binario ---
+
+    namespace Detail {
+        inline void Put16(std::string& o, uint32_t v) { o += (char)(v & 0xFF); o += (char)((v >> 8) & 0xFF); }
+        inline void Put32(std::string& o, uint32_t v) { Put16(o, v & 0xFFFF); Put16(o, v >> 16); }
+        inline uint16_t Get16(const unsigned char* p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+        inline uint32_t Get32(const unsigned char* p) { return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24); }
+
+        inline bool FitsU16(int32_t v) { return v >= 0 && v <= 0xFFFF; }
+        inline bool FitsI16(int32_t v) { return v >= -0x8000 && v <= 0x7FFF; }
+    }
+
+    /**
+     * Serializa una tabla ya agrupada (ver Group).
+     * @returns {bool} false si algún valor no cabe en el formato.
+     */
+    inline bool Write(const Table& t, std::string& out, std::string* err = nullptr) {
+        using namespace Detail;
+        // Cadenas internadas
+        std::string strings;
+        std::unordered_map<std::string, uint32_t> interned;
+        auto intern = [&](const std::string& s) {
+            auto it = interned.find(s);
+            if (it != interned.end()) return it->second;
+            uint32_t off = (uint32_t)strings.size();
+            strings.append(s);
+            strings += '\0';
+            interned.emplace(s, off);
+            return off;
+        };
+        uint32_t image = intern(t.image);
+
+        uint32_t slots = 0;
+        if (!t.frames.empty()) { slots = 1; while (slots < t.frames.size() * 2) slots <<= 1; }
+        std::vector<uint32_t> hash(slots, 0);
+
+        std::string frames;
+        frames.reserve(t.frames.size() * kFrameSize);
+        for (size_t i = 0; i < t.frames.size(); i++) {
+            const Frame& f = t.frames[i];
+            if (!FitsU16(f.x) || !FitsU16(f.y) || !FitsU16(f.w) || !FitsU16(f.h) || !FitsI16(f.frameX) || !FitsI16(f.frameY)
+                || !FitsU16(f.frameW) || !FitsU16(f.frameH) || f.anim > 0xFFFF) {
+                if (err) *err = "frame out of range: " + f.name;
+                return false;
+            }
+            Put32(frames, intern(f.name));
+            Put16(frames, (uint32_t)f.x); Put16(frames, (uint32_t)f.y); Put16(frames, (uint32_t)f.w); Put16(frames, (uint32_t)f.h);
+            Put16(frames, (uint32_t)(uint16_t)(int16_t)f.frameX); Put16(frames, (uint32_t)(uint16_t)(int16_t)f.frameY);
+            Put16(frames, (uint32_t)f.frameW); Put16(frames, (uint32_t)f.frameH);
+            Put16(frames, (f.rotated ? kRotated : 0) | (f.trimmed ? kTrimmed : 0));
+            Put16(frames, f.anim);
+
+            // Ante nombres repetidos gana el primero, como en Phaser
+            for (uint32_t s = Hash(f.name) & (slots - 1);; s = (s + 1) & (slots - 1)) {
+                if (hash[s] == 0) { hash[s] = (uint32_t)i + 1; break; }
+                if (t.frames[hash[s] - 1].name == f.name) break;
+            }
+        }
+
+        std::string anims;
+        for (const Anim& a : t.anims) { Put32(anims, intern(a.prefix)); Put32(anims, a.first); Put32(anims, a.count); }
+
+        out.clear();
+        out.reserve(kHeaderSize + frames.size() + anims.size() + slots * 4 + strings.size());
+        out.append("GATL", 4);
+        Put16(out, kVersion); Put16(out, (uint32_t)kHeaderSize);
+        Put32(out, (uint32_t)t.frames.size()); Put32(out, (uint32_t)t.anims.size());
+        Put32(out, slots); Put32(out, (uint32_t)strings.size()); Put32(out, image); Put32(out, 0);
+        out += frames;
+        out += anims;
+        for (uint32_t h : hash) Put32(out, h);
+        out += strings;
+        return true;
+    }
+
+    /**
+     * @class View
+     * @description Acceso directo a un .gatl en memoria, sin copiar ni decodificar.
+     * El buffer debe seguir vivo mientras se use la vista.
+     */
+    class View {
+    public:
+        bool Open(const void* data, size_t size, std::string* err = nullptr) {
+            using namespace Detail;
+            base = (const unsigned char*)data;
+            if (size < kHeaderSize || std::memcmp(base, "GATL", 4) != 0) return Fail(err, "not a GATL file");
+            if (Get16(base + 4) != kVersion) return Fail(err, "unsupported GATL version");
+            size_t header = Get16(base + 6);
+            frameCount = Get32(base + 8); animCount = Get32(base + 12);
+            slots = Get32(base + 16); stringBytes = Get32(base + 20); image = Get32(base + 24);
+            if (header < kHeaderSize || (slots & (slots - 1)) != 0 || (frameCount && slots < frameCount)) return Fail(err, "corrupt header");
+            uint64_t need = (uint64_t)header + (uint64_t)frameCount * kFrameSize + (uint64_t)animCount * kAnimSize + (uint64_t)slots * 4 + stringBytes;
+            if (need != size) return Fail(err, "size mismatch");
+            frames = base + header;
+            anims = frames + (size_t)frameCount * kFrameSize;
+            hash = anims + (size_t)animCount * kAnimSize;
+            strings = (const char*)(hash + (size_t)slots * 4);
+            if (stringBytes == 0 || strings[stringBytes - 1] != '\0' || image >= stringBytes) return Fail(err, "corrupt string pool");
+            for (uint32_t i = 0; i < frameCount; i++) if (Get32(frames + i * kFrameSize) >= stringBytes) return Fail(err, "corrupt frame name");
+            for (uint32_t i = 0; i < animCount; i++) {
+                const unsigned char* a = anims + i * kAnimSize;
+                if (Get32(a) >= stringBytes || (uint64_t)Get32(a + 4) + Get32(a + 8) > frameCount) return Fail(err, "corrupt animation");
+            }
+            return true;
+        }
+
+        uint32_t FrameCount() const { return frameCount; }
+        uint32_t AnimCount() const { return animCount; }
+        std::string_view Image() const { return String(image); }
+
+        Frame GetFrame(uint32_t i) const {
+            using namespace Detail;
+            const unsigned char* p = frames + (size_t)i * kFrameSize;
+            Frame f;
+            f.name = std::string(String(Get32(p)));
+            f.x = Get16(p + 4); f.y = Get16(p + 6); f.w = Get16(p + 8); f.h = Get16(p + 10);
+            f.frameX = (int16_t)Get16(p + 12); f.frameY = (int16_t)Get16(p + 14);
+            f.frameW = Get16(p + 16); f.frameH = Get16(p + 18);
+            uint16_t flags = Get16(p + 20);
+            f.rotated = (flags & kRotated) != 0; f.trimmed = (flags & kTrimmed) != 0;
+            f.anim = Get16(p + 22);
+            return f;
+        }
+
+        std::string_view FrameName(uint32_t i) const { return String(Detail::Get32(frames + (size_t)i * kFrameSize)); }
+
+        Anim GetAnim(uint32_t i) const {
+            using namespace Detail;
+            const unsigned char* p = anims + (size_t)i * kAnimSize;
+            Anim a;
+            a.prefix = std::string(String(Get32(p)));
+            a.first = Get32(p + 4); a.count = Get32(p + 8);
+            return a;
+        }
+
+        /**
+         * Busca un frame por nombre.
+         * @returns {int64_t} Índice o -1.
+         */
+        int64_t Find(std::string_view name) const {
+            if (slots == 0) return -1;
+            for (uint32_t s = Hash(name) & (slots - 1), n = 0; n < slots; s = (s + 1) & (slots - 1), n++) {
+                uint32_t v = Detail::Get32(hash + (size_t)s * 4);
+                if (v == 0 || v > frameCount) return -1;
+                if (FrameName(v - 1) == name) return (int64_t)v - 1;
+            }
+            return -1;
+        }
+
+    private:
+        const unsigned char* base = nullptr;
+        const unsigned char* frames = nullptr;
+        const unsigned char* anims = nullptr;
+        const unsigned char* hash = nullptr;
+        const char* strings = nullptr;
+        uint32_t frameCount = 0, animCount = 0, slots = 0, stringBytes = 0, image = 0;
+
+        std::string_view String(uint32_t off) const { return std::string_view(strings + off); }
+        static bool Fail(std::string* err, const char* msg) { if (err) *err = msg; return false; }
+    };
+
+    /**
+     * Decodifica un .gatl completo en una tabla.
+     */
+    inline bool Read(const void* data, size_t size, Table& out, std::string* err = nullptr) {
+        View v;
+        if (!v.Open(data, size, err)) return false;
+        out = Table();
+        out.image = std::string(v.Image());
+        out.frames.reserve(v.FrameCount());
+        for (uint32_t i = 0; i < v.FrameCount(); i++) out.frames.push_back(v.GetFrame(i));
+        for (uint32_t i = 0; i < v.AnimCount(); i++) out.anims.push_back(v.GetAnim(i));
+        return true;
+    }
+}
@@ -0,0 +1,352 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "Atlas.h"
+#include "MaxRects.h"
+#include "Png.h"
+
+/**
+ * @namespace AtlasPacker
+ * @description Reempaquetado de texturas: recorta los bordes transparentes de cada frame, junta
+ * los frames con los mismos píxeles y los coloca con MaxRects en una o varias texturas nuevas.
+ *
+ * Un frame recortado sigue midiendo lo mismo para Phaser: se escribe con frameX/frameY negativos
+ * (desplazamiento del recorte) y frameWidth/frameHeight del frame original, que es como
+ * setTrim coloca los píxeles. Render reproduce esa colocación para comprobar el resultado.
+ *
+ * Cada fuente entra entera en una textura de salida (sus frames comparten clave de textura en la
+ * página). Las fuentes con frames rotados o fuera de la imagen se dejan como están.
+ */
+namespace AtlasPacker {
+
+    struct Options {
+        int maxSize = 4096;   // Lado máximo de una textura de salida
+        int padding = 2;      // Píxeles transparentes entre frames (evita sangrado con filtrado lineal)
+        bool trim = true;     // Los spritemap de Animate colocan cada sprite por su esquina: sin recorte
+        bool dedupe = true;
+    };
+
+    /** Una textura de entrada: Sparrow, spritemap o imagen suelta (un frame con nombre vacío). */
+    struct Source {
+        std::string prefix;   // Los frames salen como "prefix/nombre" ("prefix" si el nombre está vacío)
+        Png::Image image;
+        Atlas::Table table;
+    };
+
+    /** Una textura de salida. */
+    struct Sheet {
+        Png::Image image;
+        Atlas::Table table;            // Frames en coordenadas de `image`, con prefijo
+        std::vector<size_t> sources;   // Índices en el vector de fuentes
+        uint64_t frames = 0, unique = 0;
+    };
+
+    inline std::string FrameName(const std::string& prefix, const std::string& name) {
+        if (prefix.empty()) return name;
+        return name.empty() ? prefix : prefix + "/" + name;
+    }
+
+    namespace Detail {
+        /** Recorte de un frame dentro de su fuente y los píxeles que lo identifican. */
+        struct Piece {
+            size_t source = 0, frame = 0;
+            MaxRects::Rect src;        // Región recortada en la imagen de la fuente
+            int offsetX = 0, offsetY = 0, logicalW = 0, logicalH = 0;
+            bool keepOriginal = false; // Sin recorte: se copian frameX... tal cual
+            uint64_t hash = 0;
+            size_t unique = 0;         // Pieza con los mismos píxeles (ella misma si es la primera)
+        };
+
+        inline bool Transparent(const uint8_t* px) { return px[3] == 0; }
+
+        inline uint64_t HashRegion(const Png::Image& img, const MaxRects::Rect& r) {
+            uint64_t h = 1469598103934665603ull ^ ((uint64_t)r.w << 32 | (uint32_t)r.h);
+            for (int y = 0; y < r.h; y++) {
+                const uint8_t* p = img.Row((uint32_t)(r.y + y)) + (size_t)r.x * 4;
+                for (int i = 0; i < r.w * 4; i++) h = (h ^ p[i]) * 1099511628211ull;
+            }
+            return h;
+        }
+
+        inline bool SameRegion(const Png::Image& a, const MaxRects::Rect& ra, const Png::Image& b, const MaxRects::Rect& rb) {
+            if (ra.w != rb.w || ra.h != rb.h) return false;
+            for (int y = 0; y < ra.h; y++) {
+                if (std::memcmp(a.Row((uint32_t)(ra.y + y)) + (size_t)ra.x * 4, b.Row((uint32_t)(rb.y + y)) + (size_t)rb.x * 4, (size_t)ra.w * 4) != 0) return false;
+            }
+            return true;
+        }
+
+        /** Caja de los píxeles con alfa > 0 dentro de `r`. Vacía = 1x1 en la esquina. */
+        inline MaxRects::Rect Opaque(const Png::Image& img, const MaxRects::Rect& r) {
+            int x0 = r.w, y0 = r.h, x1 = -1, y1 = -1;
+            for (int y = 0; y < r.h; y++) {
+                const uint8_t* p = img.Row((uint32_t)(r.y + y)) + (size_t)r.x * 4;
+                int first = -1, last = -1;
+                for (int x = 0; x < r.w; x++) if (!Transparent(p + x * 4)) { first = x; break; }
+                if (first < 0) continue;
+                for (int x = r.w - 1; x >= first; x--) if (!Transparent(p + x * 4)) { last = x; break; }
+                x0 = std::min(x0, first); x1 = std::max(x1, last);
+                y0 = std::min(y0, y); y1 = y;
+            }
+            if (x1 < 0) return { r.x, r.y, 1, 1 };
+            return { r.x + x0, r.y + y0, x1 - x0 + 1, y1 - y0 + 1 };
+        }
+
+        /**
+         * Coloca `rects` (w, h ya con padding) en un Bin de w x h. Orden: lado mayor descendente.
+         */
+        inline bool Fit(std::vector<MaxRects::Rect>& rects, const std::vector<size_t>& order, MaxRects::Bin& bin) {
+            for (size_t i : order) {
+                MaxRects::Rect at;
+                if (!bin.Insert(rects[i].w, rects[i].h, at)) return false;
+                rects[i].x = at.x; rects[i].y = at.y;
+            }
+            return true;
+        }
+    }
+
+    /**
+     * Empaqueta las fuentes.
+     * @param {vector<size_t>} skipped - Fuentes que se quedan como estaban (rotadas, frames fuera
+     *   de la imagen o demasiado grandes para una textura).
+     */
+    inline void Pack(const std::vector<Source>& sources, const Options& opt, std::vector<Sheet>& sheets, std::vector<size_t>& skipped) {
+        using namespace Detail;
+        sheets.clear();
+        skipped.clear();
+        const int pad = std::max(0, opt.padding);
+
+        // 1. Recortes y deduplicado, fuente a fuente
+        std::vector<std::vector<Piece>> pieces(sources.size());
+        std::vector<std::vector<size_t>> uniques(sources.size());   // Piezas que ocupan sitio
+        std::vector<uint64_t> area(sources.size(), 0);
+        std::vector<bool> ok(sources.size(), true);
+        for (size_t s = 0; s < sources.size(); s++) {
+            const Source& src = sources[s];
+            const Png::Image& img = src.image;
+            std::unordered_map<uint64_t, std::vector<size_t>> seen;
+            for (size_t f = 0; f < src.table.frames.size() && ok[s]; f++) {
+                const Atlas::Frame& fr = src.table.frames[f];
+                MaxRects::Rect r{ fr.x, fr.y, fr.w, fr.h };
+                if (fr.rotated || r.w <= 0 || r.h <= 0 || r.x < 0 || r.y < 0 || r.x + r.w > (int)img.width || r.y + r.h > (int)img.height) {
+                    ok[s] = false;
+                    break;
+                }
+                Piece p;
+                p.source = s; p.frame = f;
+                p.offsetX = fr.trimmed ? std::abs(fr.frameX) : 0;
+                p.offsetY = fr.trimmed ? std::abs(fr.frameY) : 0;
+                p.logicalW = fr.trimmed ? fr.frameW : fr.w;
+                p.logicalH = fr.trimmed ? fr.frameH : fr.h;
+                p.src = opt.trim ? Opaque(img, r) : r;
+                p.keepOriginal = p.src.x == r.x && p.src.y == r.y && p.src.w == r.w && p.src.h == r.h;
+                p.hash = HashRegion(img, p.src);
+                p.unique = pieces[s].size();
+                if (opt.dedupe) {
+                    for (size_t other : seen[p.hash]) {
+                        if (SameRegion(img, pieces[s][other].src, img, p.src)) { p.unique = other; break; }
+                    }
+                }
+                if (p.unique == pieces[s].size()) {
+                    seen[p.hash].push_back(p.unique);
+                    uniques[s].push_back(p.unique);
+                    area[s] += (uint64_t)(p.src.w + pad) * (p.src.h + pad);
+                }
+                pieces[s].push_back(p);
+            }
+            if (ok[s] && pieces[s].empty()) ok[s] = false;
+        }
+
+        // 2. Reparto: fuentes grandes primero, cada una entera en la primera textura donde quepa
+        std::vector<size_t> order;
+        for (size_t s = 0; s < sources.size(); s++) {
+            if (ok[s]) order.push_back(s); else skipped.push_back(s);
+        }
+        std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return area[a] > area[b]; });
+        auto sortBySide = [](std::vector<MaxRects::Rect>& rects) {
+            std::vector<size_t> idx(rects.size());
+            for (size_t i = 0; i < idx.size(); i++) idx[i] = i;
+            std::stable_sort(idx.begin(), idx.end(), [&](size_t a, size_t b) {
+                int ma = std::max(rects[a].w, rects[a].h), mb = std::max(rects[b].w, rects[b].h);
+                return ma != mb ? ma > mb : std::min(rects[a].w, rects[a].h) > std::min(rects[b].w, rects[b].h);
+            });
+            return idx;
+        };
+        struct Open { MaxRects::Bin bin; std::vector<size_t> sources; };
+        std::vector<Open> open;
+        for (size_t s : order) {
+            std::vector<MaxRects::Rect> rects;
+            for (size_t u : uniques[s]) rects.push_back({ 0, 0, pieces[s][u].src.w + pad, pieces[s][u].src.h + pad });
+            std::vector<size_t> idx = sortBySide(rects);
+            bool placed = false;
+            for (Open& o : open) {
+                MaxRects::Bin trial = o.bin;
+                if (Fit(rects, idx, trial)) { o.bin = trial; o.sources.push_back(s); placed = true; break; }
+            }
+            if (placed) continue;
+            // El padding de la última fila/columna se puede salir de la textura
+            MaxRects::Bin fresh(opt.maxSize + pad, opt.maxSize + pad);
+            if (!Fit(rects, idx, fresh)) { skipped.push_back(s); continue; }
+            open.push_back({ fresh, { s } });
+        }
+        std::sort(skipped.begin(), skipped.end());
+
+        // 3. Cada textura se vuelve a empaquetar en el tamaño más pequeño que se encuentre
+        for (const Open& o : open) {
+            std::vector<std::pair<size_t, size_t>> ids;   // (fuente, pieza única)
+            std::vector<MaxRects::Rect> rects;
+            uint64_t total = 0;
+            for (size_t s : o.sources) {
+                for (size_t u : uniques[s]) {
+                    ids.push_back({ s, u });
+                    rects.push_back({ 0, 0, pieces[s][u].src.w + pad, pieces[s][u].src.h + pad });
+                    total += (uint64_t)rects.back().w * rects.back().h;
+                }
+            }
+            std::vector<size_t> idx = sortBySide(rects);
+            int minW = 0, minH = 0;
+            for (const auto& r : rects) { minW = std::max(minW, r.w); minH = std::max(minH, r.h); }
+            int limit = opt.maxSize + pad;
+            int bestW = 0, bestH = 0;
+            uint64_t bestArea = UINT64_MAX;
+            std::vector<MaxRects::Rect> best;
+            // Anchos candidatos desde la raíz del área; para cada uno, la altura mínima que entra
+            int side = std::max({ minW, (int)std::ceil(std::sqrt((double)total)), 1 });
+            for (int w = std::min(side, limit); ; w = std::min(limit, w + std::max(16, w / 16))) {
+                w = std::max(w, minW);
+                int lo = std::max(minH, (int)(total / (uint64_t)w)), hi = limit;
+                std::vector<MaxRects::Rect> trial = rects;
+                MaxRects::Bin probe(w, hi);
+                if (Fit(trial, idx, probe)) {
+                    // Búsqueda binaria de la altura
+                    std::vector<MaxRects::Rect> fit = trial;
+                    int fitH = probe.Bottom();
+                    hi = fitH;
+                    while (lo < hi) {
+                        int mid = lo + (hi - lo) / 2;
+                        std::vector<MaxRects::Rect> t2 = rects;
+                        MaxRects::Bin b2(w, mid);
+                        if (Fit(t2, idx, b2)) { hi = mid; fit = t2; fitH = b2.Bottom(); if (fitH < mid) hi = fitH; }
+                        else lo = mid + 1;
+                    }
+                    int usedW = 0;
+                    for (const auto& r : fit) usedW = std::max(usedW, r.x + r.w);
+                    uint64_t a = (uint64_t)std::min(usedW - pad, opt.maxSize) * std::min(fitH - pad, opt.maxSize);
+                    if (a < bestArea) { bestArea = a; best = fit; bestW = usedW; bestH = fitH; }
+                    // Más ancho ya no puede bajar del área que queda
+                    if ((uint64_t)w * minH >= bestArea) break;
+                }
+                if (w >= limit) break;
+            }
+            if (best.empty()) {
+                // No debería pasar: el reparto ya cupo en limit x limit
+                MaxRects::Bin b(limit, limit);
+                best = rects;
+                Fit(best, idx, b);
+                bestW = b.Right(); bestH = b.Bottom();
+            }
+
+            Sheet sheet;
+            sheet.sources = o.sources;
+            int outW = std::max(1, std::min(bestW - pad, opt.maxSize)), outH = std::max(1, std::min(bestH - pad, opt.maxSize));
+            sheet.image.Resize((uint32_t)outW, (uint32_t)outH);
+            std::unordered_map<uint64_t, MaxRects::Rect> at;   // (fuente << 32 | pieza) -> destino
+            for (size_t i = 0; i < ids.size(); i++) {
+                auto [s, u] = ids[i];
+                const Piece& p = pieces[s][u];
+                MaxRects::Rect dst{ best[i].x, best[i].y, p.src.w, p.src.h };
+                at[(uint64_t)s << 32 | u] = dst;
+                const Png::Image& img = sources[s].image;
+                for (int y = 0; y < p.src.h; y++) {
+                    uint8_t* row = sheet.image.Row((uint32_t)(dst.y + y)) + (size_t)dst.x * 4;
+                    std::memcpy(row, img.Row((uint32_t)(p.src.y + y)) + (size_t)p.src.x * 4, (size_t)p.src.w * 4);
+                    // El color bajo alfa 0 no se ve: a cero comprime mejor
+                    for (int x = 0; x < p.src.w; x++) if (Detail::Transparent(row + x * 4)) std::memset(row + x * 4, 0, 4);
+                }
+                sheet.unique++;
+            }
+            for (size_t s : o.sources) {
+                for (const Piece& p : pieces[s]) {
+                    const Atlas::Frame& fr = sources[s].table.frames[p.frame];
+                    const MaxRects::Rect& dst = at[(uint64_t)s << 32 | p.unique];
+                    Atlas::Frame out = fr;
+                    out.name = FrameName(sources[s].prefix, fr.name);
+                    out.x = dst.x; out.y = dst.y; out.w = dst.w; out.h = dst.h;
+                    if (!p.keepOriginal) {
+                        out.trimmed = true;
+                        out.frameX = -(p.offsetX + (p.src.x - fr.x));
+                        out.frameY = -(p.offsetY + (p.src.y - fr.y));
+                        out.frameW = p.logicalW;
+                        out.frameH = p.logicalH;
+                    }
+                    sheet.table.frames.push_back(std::move(out));
+                    sheet.frames++;
+                }
+            }
+            Atlas::Group(sheet.table);
+            sheets.push_back(std::move(sheet));
+        }
+    }
+
+    /**
+     * Dibuja un frame como lo coloca Phaser: lienzo de `w` x `h` con los píxeles del frame en
+     * (|frameX|, |frameY|) si está recortado. Los píxeles con alfa 0 quedan a cero (no se ven).
+     */
+    inline void Render(const Png::Image& img, const Atlas::Frame& f, int w, int h, std::vector<uint8_t>& out) {
+        out.assign((size_t)w * h * 4, 0);
+        int ox = f.trimmed ? std::abs(f.frameX) : 0, oy = f.trimmed ? std::abs(f.frameY) : 0;
+        for (int y = 0; y < f.h; y++) {
+            int cy = oy + y, sy = f.y + y;
+            if (cy < 0 || cy >= h || sy < 0 || sy >= (int)img.height) continue;
+            for (int x = 0; x < f.w; x++) {
+                int cx = ox + x, sx = f.x + x;
+                if (cx < 0 || cx >= w || sx < 0 || sx >= (int)img.width) continue;
+                const uint8_t* p = img.Row((uint32_t)sy) + (size_t)sx * 4;
+                if (p[3]) std::memcpy(out.data() + ((size_t)cy * w + cx) * 4, p, 4);
+            }
+        }
+    }
+
+    /** Tamaño con el que Phaser muestra el frame (incluye lo que sobresale del recorte). */
+    inline void CanvasOf(const Atlas::Frame& f, int& w, int& h) {
+        if (!f.trimmed) { w = f.w; h = f.h; return; }
+        w = std::max(f.frameW, std::abs(f.frameX) + f.w);
+        h = std::max(f.frameH, std::abs(f.frameY) + f.h);
+    }
+
+    /**
+     * Comprueba que cada frame de `src` se ve igual desde la textura empaquetada.
+     */
+    inline bool Verify(const Source& src, const Png::Image& packed, const Atlas::Table& table, std::string* err = nullptr) {
+        std::unordered_map<std::string, const Atlas::Frame*> byName;
+        for (const Atlas::Frame& f : table.frames) byName.emplace(f.name, &f);   // Gana el primero
+        std::unordered_set<std::string> checked;
+        std::vector<uint8_t> a, b;
+        for (const Atlas::Frame& f : src.table.frames) {
+            std::string name = FrameName(src.prefix, f.name);
+            if (!checked.insert(name).second) continue;
+            auto it = byName.find(name);
+            if (it == byName.end()) { if (err) *err = "missing frame " + name; return false; }
+            const Atlas::Frame& g = *it->second;
+            int w, h, pw, ph;
+            CanvasOf(f, w, h);
+            CanvasOf(g, pw, ph);
+            bool sameSize = (f.trimmed ? f.frameW : f.w) == (g.trimmed ? g.frameW : g.w) && (f.trimmed ? f.frameH : f.h) == (g.trimmed ? g.frameH : g.h);
+            if (!sameSize || pw > w || ph > h) {
+                if (err) *err = "frame size changed: " + name;
+                return false;
+            }
+            Render(src.image, f, w, h, a);
+            Render(packed, g, w, h, b);
+            if (a != b) { if (err) *err = "pixels differ: " + name; return false; }
+        }
+        return true;
+    }
+}
@@ -0,0 +1,194 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <system_error>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+/**
+ * @namespace AtomicFile
+ * @description Escritura atómica por pasos: escribir a temporal, sincronizar, renombrar sobre
+ * el destino y sincronizar el directorio. Los pasos están separados para poder agrupar
+ * los fsync de varios archivos en un mismo commit.
+ */
+namespace AtomicFile {
+
+    namespace fs = std::filesystem;
+
+    /**
+     * Archivo temporal abierto junto al destino (".<nombre>.tmp").
+     */
+    struct Temp {
+        fs::path target;
+        fs::path path;
+#ifdef _WIN32
+        HANDLE handle = INVALID_HANDLE_VALUE;
+#else
+        int fd = -1;
+#endif
+        bool IsOpen() const {
+#ifdef _WIN32
+            return handle != INVALID_HANDLE_VALUE;
+#else
+            return fd >= 0;
+#endif
+        }
+    };
+
+    inline std::string LastError() {
+#ifdef _WIN32
+        return "win32 error " + std::to_string(GetLastError());
+#else
+        return std::strerror(errno);
+#endif
+    }
+
+    inline void CloseTemp(Temp& t) {
+#ifdef _WIN32
+        if (t.handle != INVALID_HANDLE_VALUE) CloseHandle(t.handle);
+        t.handle = INVALID_HANDLE_VALUE;
+#else
+        if (t.fd >= 0) ::close(t.fd);
+        t.fd = -1;
+#endif
+    }
+
+    /**
+     * Descarta un temporal que no llegó a renombrarse.
+     */
+    inline void Abort(Temp& t) {
+        CloseTemp(t);
+        std::error_code ec;
+        if (!t.path.empty()) fs::remove(t.path, ec);
+    }
+
+    /**
+     * Crea los directorios necesarios y escribe `data` completo en un temporal.
+     * @returns {bool} false con `err` relleno si falla; el temporal se elimina.
+     */
+    inline bool WriteTemp(const fs::path& target, const char* data, size_t size, Temp& t, std::string& err) {
+        t.target = target;
+        t.path = target.parent_path() / ("." + target.filename().string() + ".tmp");
+        std::error_code ec;
+        if (target.has_parent_path()) fs::create_directories(target.parent_path(), ec);
+        if (ec) { err = ec.message(); return false; }
+#ifdef _WIN32
+        t.handle = CreateFileW(t.path.c_str(), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (t.handle == INVALID_HANDLE_VALUE) { err = LastError(); return false; }
+        while (size > 0) {
+            DWORD chunk = size > (1u << 30) ? (1u << 30) : (DWORD)size, written = 0;
+            if (!WriteFile(t.handle, data, chunk, &written, NULL)) { err = LastError(); Abort(t); return false; }
+            data += written; size -= written;
+        }
+#else
+        t.fd = ::open(t.path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (t.fd < 0) { err = LastError(); return false; }
+        while (size > 0) {
+            ssize_t n = ::write(t.fd, data, size);
+            if (n < 0) { if (errno == EINTR) continue; err = LastError(); Abort(t); return false; }
+            data += n; size -= (size_t)n;
+        }
+#endif
+        return true;
+    }
+
+    /**
+     * Fuerza los datos del temporal a disco.
+     */
+    inline bool Sync(Temp& t, std::string& err) {
+#ifdef _WIN32
+        if (!FlushFileBuffers(t.handle)) { err = LastError(); return false; }
+#else
+        if (::fsync(t.fd) != 0) { err = LastError(); return false; }
+#endif
+        return true;
+    }
+
+    /**
+     * Cierra el temporal y lo renombra sobre el destino (reemplazo atómico).
+     */
+    inline bool Commit(Temp& t, std::string& err) {
+        CloseTemp(t);
+#ifdef _WIN32
+        if (!MoveFileExW(t.path.c_str(), t.target.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)) {
+            err = LastError(); Abort(t); return false;
+        }
+#else
+        if (::rename(t.path.c_str(), t.target.c_str()) != 0) { err = LastError(); Abort(t); return false; }
+#endif
+        return true;
+    }
+
+    /**
+     * Persiste las entradas del directorio (el rename). En Windows lo cubre MOVEFILE_WRITE_THROUGH.
+     */
+    inline bool SyncDir(const fs::path& dir, std::string& err) {
+#ifdef _WIN32
+        (void)dir; (void)err;
+        return true;
+#else
+        int fd = ::open(dir.empty() ? "." : dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (fd < 0) { err = LastError(); return false; }
+        bool ok = ::fsync(fd) == 0;
+        if (!ok) err = LastError();
+        ::close(fd);
+        return ok;
+#endif
+    }
+
+    /**
+     * Escritura atómica de un solo archivo.
+     */
+    inline bool Write(const fs::path& target, const std::string& data, std::string& err) {
+        Temp t;
+        if (!WriteTemp(target, data.data(), data.size(), t, err)) return false;
+        if (!Sync(t, err)) { Abort(t); return false; }
+        if (!Commit(t, err)) return false;
+        return SyncDir(target.parent_path(), err);
+    }
+
+    /**
+     * Lee un archivo completo.
+     * @returns {bool} false si no existe o no se puede leer.
+     */
+    inline bool ReadAll(const fs::path& path, std::string& out) {
+#ifdef _WIN32
+        HANDLE h = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+        if (h == INVALID_HANDLE_VALUE) return false;
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(h, &size)) { CloseHandle(h); return false; }
+        out.resize((size_t)size.QuadPart);
+        size_t got = 0;
+        while (got < out.size()) {
+            DWORD chunk = (out.size() - got) > (1u << 30) ? (1u << 30) : (DWORD)(out.size() - got), n = 0;
+            if (!ReadFile(h, &out[got], chunk, &n, NULL) || n == 0) break;
+            got += n;
+        }
+        CloseHandle(h);
+        out.resize(got);
+        return true;
+#else
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return false;
+        out.clear();
+        char buf[64 * 1024];
+        while (true) {
+            ssize_t n = ::read(fd, buf, sizeof(buf));
+            if (n < 0) { if (errno == EINTR) continue; ::close(fd); return false; }
+            if (n == 0) break;
+            out.append(buf, (size_t)n);
+        }
+        ::close(fd);
+        return true;
+#endif
+    }
+}
@@ -0,0 +1,554 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "Png.h"
+#include "TaskPool.h"
+
+// Búsqueda de índices BC7 con SSE2 en cualquier x64. GENESIS_BC_SCALAR la desactiva.
+#if !defined(GENESIS_BC_SCALAR) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define GENESIS_BC_SSE2 1
+#include <emmintrin.h>
+#endif
+
+/**
+ * @namespace BlockTexture
+ * @description Compresión por bloques de 4x4 para la GPU, en CPU y sin dependencias:
+ *
+ * - BC7 (EXT_texture_compression_bptc, escritorio): modo 6, un subconjunto RGBA con extremos
+ *   de 7 bits + bit p e índices de 4 bits. Extremos por eje principal y ajuste por mínimos
+ *   cuadrados; la búsqueda de índices (16 píxeles x 16 colores) va con SSE2.
+ * - ETC2 RGBA8 (WEBGL_compressed_texture_etc, móviles e integradas): color en modos
+ *   individual/diferencial de ETC1 (sin desbordes, así que nunca cae en T/H/planar) y alfa EAC.
+ *
+ * Las dos salidas son 16 bytes por bloque (1 byte por píxel, un cuarto de RGBA8). Los píxeles se
+ * codifican con alfa premultiplicado, que es como los mezcla Phaser (las texturas comprimidas no
+ * pasan por UNPACK_PREMULTIPLY_ALPHA). Los decodificadores solo cubren lo que escriben los
+ * codificadores: sirven para medir la calidad (PSNR) y verificar la salida.
+ */
+namespace BlockTexture {
+
+    enum class Format : uint8_t { BC7, ETC2 };
+
+    constexpr size_t kBlockBytes = 16;
+
+    inline const char* Name(Format f) { return f == Format::BC7 ? "bc7" : "etc2"; }
+
+    /** Bloques por fila / columna. */
+    inline uint32_t Blocks(uint32_t pixels) { return (pixels + 3) / 4; }
+
+    /** RGBA con el color multiplicado por alfa (lo que se ve en pantalla). */
+    inline void Premultiply(Png::Image& img) {
+        for (size_t i = 0; i < img.rgba.size(); i += 4) {
+            uint32_t a = img.rgba[i + 3];
+            if (a == 255) continue;
+            for (int c = 0; c < 3; c++) img.rgba[i + c] = (uint8_t)((img.rgba[i + c] * a + 127) / 255);
+        }
+    }
+
+    /**
+     * PSNR en dB entre dos imágenes del mismo tamaño (los cuatro canales). 99 si son idénticas.
+     */
+    inline double Psnr(const Png::Image& a, const Png::Image& b) {
+        if (a.width != b.width || a.height != b.height || a.rgba.empty()) return 0.0;
+        uint64_t sum = 0;
+        for (size_t i = 0; i < a.rgba.size(); i++) {
+            int d = (int)a.rgba[i] - (int)b.rgba[i];
+            sum += (uint64_t)(d * d);
+        }
+        if (sum == 0) return 99.0;
+        double mse = (double)sum / (double)a.rgba.size();
+        return 10.0 * std::log10(255.0 * 255.0 / mse);
+    }
+
+    namespace Detail {
+
+        /** Píxeles de un bloque (fila a fila); fuera de la imagen se repite el borde. */
+        inline void Load(const Png::Image& img, uint32_t bx, uint32_t by, uint8_t px[16][4]) {
+            for (uint32_t y = 0; y < 4; y++) {
+                uint32_t sy = std::min(by * 4 + y, img.height - 1);
+                const uint8_t* row = img.Row(sy);
+                for (uint32_t x = 0; x < 4; x++) {
+                    uint32_t sx = std::min(bx * 4 + x, img.width - 1);
+                    std::memcpy(px[y * 4 + x], row + (size_t)sx * 4, 4);
+                }
+            }
+        }
+
+        inline int Clamp255(int v) { return v < 0 ? 0 : (v > 255 ? 255 : v); }
+
+        // --- BC7, modo 6 ---
+
+        static const int kWeights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+        /** 128 bits escritos desde el bit menos significativo. */
+        struct Bits128 {
+            uint64_t lo = 0, hi = 0;
+            int pos = 0;
+            void Put(uint32_t v, int n) {
+                for (int i = 0; i < n; i++, pos++) {
+                    uint64_t bit = (v >> i) & 1;
+                    if (pos < 64) lo |= bit << pos; else hi |= bit << (pos - 64);
+                }
+            }
+            uint32_t Get(int n) {
+                uint32_t v = 0;
+                for (int i = 0; i < n; i++, pos++) v |= (uint32_t)((pos < 64 ? lo >> pos : hi >> (pos - 64)) & 1) << i;
+                return v;
+            }
+        };
+
+        /** Extremo de 8 bits por canal como (valor de 7 bits << 1) | p, con p compartido. */
+        inline void QuantizeEndpoint(const float e[4], int out[4]) {
+            float best = 1e30f;
+            for (int p = 0; p < 2; p++) {
+                int v[4];
+                float err = 0;
+                for (int c = 0; c < 4; c++) {
+                    int q = (int)std::lround((e[c] - p) * 0.5f);
+                    q = q < 0 ? 0 : (q > 127 ? 127 : q);
+                    v[c] = q * 2 + p;
+                    err += (v[c] - e[c]) * (v[c] - e[c]);
+                }
+                if (err < best) { best = err; std::memcpy(out, v, sizeof(v)); }
+            }
+        }
+
+        /**
+         * Índice más cercano de la paleta interpolada para cada píxel.
+         * @returns {uint32_t} Error cuadrático total.
+         */
+        inline uint32_t AssignBc7(const uint8_t px[16][4], const int e0[4], const int e1[4], uint8_t idx[16]) {
+            int pal[16][4];
+            for (int i = 0; i < 16; i++) {
+                for (int c = 0; c < 4; c++) pal[i][c] = ((64 - kWeights4[i]) * e0[c] + kWeights4[i] * e1[c] + 32) >> 6;
+            }
+#if defined(GENESIS_BC_SSE2)
+            // Dos píxeles por registro como RGBA de 16 bits: madd da R²+G² y B²+A² por píxel
+            __m128i pix[8];
+            for (int k = 0; k < 8; k++) {
+                const uint8_t* a = px[k * 2];
+                const uint8_t* b = px[k * 2 + 1];
+                pix[k] = _mm_setr_epi16(a[0], a[1], a[2], a[3], b[0], b[1], b[2], b[3]);
+            }
+            __m128i best[4], bestIdx[4];
+            for (int q = 0; q < 4; q++) { best[q] = _mm_set1_epi32(0x7FFFFFFF); bestIdx[q] = _mm_setzero_si128(); }
+            for (int i = 0; i < 16; i++) {
+                __m128i p = _mm_setr_epi16((short)pal[i][0], (short)pal[i][1], (short)pal[i][2], (short)pal[i][3],
+                                           (short)pal[i][0], (short)pal[i][1], (short)pal[i][2], (short)pal[i][3]);
+                __m128i id = _mm_set1_epi32(i);
+                for (int q = 0; q < 4; q++) {
+                    // Píxeles 4q..4q+3: [RG0, BA0, RG1, BA1] + [RG2, BA2, RG3, BA3] -> error por píxel
+                    __m128i d0 = _mm_sub_epi16(pix[q * 2], p), d1 = _mm_sub_epi16(pix[q * 2 + 1], p);
+                    __m128i s0 = _mm_madd_epi16(d0, d0), s1 = _mm_madd_epi16(d1, d1);
+                    __m128i even = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(s0), _mm_castsi128_ps(s1), _MM_SHUFFLE(2, 0, 2, 0)));
+                    __m128i odd = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(s0), _mm_castsi128_ps(s1), _MM_SHUFFLE(3, 1, 3, 1)));
+                    __m128i err = _mm_add_epi32(even, odd);
+                    __m128i less = _mm_cmplt_epi32(err, best[q]);
+                    best[q] = _mm_or_si128(_mm_and_si128(less, err), _mm_andnot_si128(less, best[q]));
+                    bestIdx[q] = _mm_or_si128(_mm_and_si128(less, id), _mm_andnot_si128(less, bestIdx[q]));
+                }
+            }
+            alignas(16) int32_t e[16], ix[16];
+            for (int q = 0; q < 4; q++) {
+                _mm_store_si128((__m128i*)(e + q * 4), best[q]);
+                _mm_store_si128((__m128i*)(ix + q * 4), bestIdx[q]);
+            }
+            uint32_t total = 0;
+            for (int k = 0; k < 16; k++) { idx[k] = (uint8_t)ix[k]; total += (uint32_t)e[k]; }
+            return total;
+#else
+            uint32_t total = 0;
+            for (int k = 0; k < 16; k++) {
+                uint32_t best = UINT32_MAX;
+                for (int i = 0; i < 16; i++) {
+                    uint32_t err = 0;
+                    for (int c = 0; c < 4; c++) { int d = px[k][c] - pal[i][c]; err += (uint32_t)(d * d); }
+                    if (err < best) { best = err; idx[k] = (uint8_t)i; }
+                }
+                total += best;
+            }
+            return total;
+#endif
+        }
+
+        inline void WriteBc7(const int e0in[4], const int e1in[4], const uint8_t idxIn[16], uint8_t out[16]) {
+            int e0[4], e1[4];
+            uint8_t idx[16];
+            std::memcpy(e0, e0in, sizeof(e0)); std::memcpy(e1, e1in, sizeof(e1)); std::memcpy(idx, idxIn, 16);
+            // El índice del píxel 0 se guarda con 3 bits: su bit alto tiene que ser 0
+            if (idx[0] & 8) {
+                std::swap(e0, e1);
+                for (int k = 0; k < 16; k++) idx[k] = (uint8_t)(15 - idx[k]);
+            }
+            Bits128 b;
+            b.Put(1u << 6, 7);
+            for (int c = 0; c < 4; c++) { b.Put((uint32_t)e0[c] >> 1, 7); b.Put((uint32_t)e1[c] >> 1, 7); }
+            b.Put((uint32_t)e0[0] & 1, 1);
+            b.Put((uint32_t)e1[0] & 1, 1);
+            b.Put(idx[0], 3);
+            for (int k = 1; k < 16; k++) b.Put(idx[k], 4);
+            for (int i = 0; i < 8; i++) { out[i] = (uint8_t)(b.lo >> (i * 8)); out[8 + i] = (uint8_t)(b.hi >> (i * 8)); }
+        }
+
+        inline void EncodeBc7(const uint8_t px[16][4], uint8_t out[16]) {
+            bool flat = true;
+            for (int k = 1; k < 16 && flat; k++) flat = std::memcmp(px[k], px[0], 4) == 0;
+
+            // Media y covarianza
+            float mean[4] = { 0, 0, 0, 0 };
+            for (int k = 0; k < 16; k++) for (int c = 0; c < 4; c++) mean[c] += px[k][c];
+            for (int c = 0; c < 4; c++) mean[c] /= 16.0f;
+            float e0f[4], e1f[4];
+            if (flat) {
+                for (int c = 0; c < 4; c++) e0f[c] = e1f[c] = mean[c];
+            } else {
+                float cov[4][4] = {};
+                for (int k = 0; k < 16; k++) {
+                    float d[4];
+                    for (int c = 0; c < 4; c++) d[c] = px[k][c] - mean[c];
+                    for (int i = 0; i < 4; i++) for (int j = 0; j < 4; j++) cov[i][j] += d[i] * d[j];
+                }
+                // Eje principal por iteración de potencia, empezando por la diagonal del rango
+                float axis[4] = { 1, 1, 1, 1 };
+                for (int c = 0; c < 4; c++) {
+                    int lo = 255, hi = 0;
+                    for (int k = 0; k < 16; k++) { lo = std::min(lo, (int)px[k][c]); hi = std::max(hi, (int)px[k][c]); }
+                    axis[c] = (float)(hi - lo) + 0.001f;
+                }
+                for (int it = 0; it < 8; it++) {
+                    float n[4] = {};
+                    for (int i = 0; i < 4; i++) for (int j = 0; j < 4; j++) n[i] += cov[i][j] * axis[j];
+                    float len = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2] + n[3] * n[3]);
+                    if (len < 1e-6f) break;
+                    for (int c = 0; c < 4; c++) axis[c] = n[c] / len;
+                }
+                float len = std::sqrt(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2] + axis[3] * axis[3]);
+                for (int c = 0; c < 4; c++) axis[c] /= len;
+                float tmin = 1e30f, tmax = -1e30f;
+                for (int k = 0; k < 16; k++) {
+                    float t = 0;
+                    for (int c = 0; c < 4; c++) t += (px[k][c] - mean[c]) * axis[c];
+                    tmin = std::min(tmin, t); tmax = std::max(tmax, t);
+                }
+                for (int c = 0; c < 4; c++) {
+                    e0f[c] = std::min(255.0f, std::max(0.0f, mean[c] + tmin * axis[c]));
+                    e1f[c] = std::min(255.0f, std::max(0.0f, mean[c] + tmax * axis[c]));
+                }
+            }
+
+            int e0[4], e1[4], b0[4], b1[4];
+            uint8_t idx[16], bestIdx[16];
+            QuantizeEndpoint(e0f, e0);
+            QuantizeEndpoint(e1f, e1);
+            uint32_t best = AssignBc7(px, e0, e1, bestIdx);
+            std::memcpy(b0, e0, sizeof(b0)); std::memcpy(b1, e1, sizeof(b1));
+
+            // Mínimos cuadrados con los índices actuales: mejores extremos para esa asignación
+            std::memcpy(idx, bestIdx, 16);
+            for (int it = 0; it < 2 && best > 0; it++) {
+                float a = 0, bb = 0, c2 = 0, d0[4] = {}, d1[4] = {};
+                for (int k = 0; k < 16; k++) {
+                    float w = kWeights4[idx[k]] / 64.0f, iw = 1.0f - w;
+                    a += iw * iw; bb += iw * w; c2 += w * w;
+                    for (int c = 0; c < 4; c++) { d0[c] += iw * px[k][c]; d1[c] += w * px[k][c]; }
+                }
+                float det = a * c2 - bb * bb;
+                if (std::fabs(det) < 1e-6f) break;
+                for (int c = 0; c < 4; c++) {
+                    e0f[c] = std::min(255.0f, std::max(0.0f, (c2 * d0[c] - bb * d1[c]) / det));
+                    e1f[c] = std::min(255.0f, std::max(0.0f, (a * d1[c] - bb * d0[c]) / det));
+                }
+                QuantizeEndpoint(e0f, e0);
+                QuantizeEndpoint(e1f, e1);
+                uint32_t err = AssignBc7(px, e0, e1, idx);
+                if (err >= best) break;
+                best = err;
+                std::memcpy(bestIdx, idx, 16);
+                std::memcpy(b0, e0, sizeof(b0)); std::memcpy(b1, e1, sizeof(b1));
+            }
+            WriteBc7(b0, b1, bestIdx, out);
+        }
+
+        /** Solo modo 6. @returns {bool} false con otros modos. */
+        inline bool DecodeBc7(const uint8_t in[16], uint8_t px[16][4]) {
+            Bits128 b;
+            for (int i = 0; i < 8; i++) { b.lo |= (uint64_t)in[i] << (i * 8); b.hi |= (uint64_t)in[8 + i] << (i * 8); }
+            if (b.Get(7) != (1u << 6)) return false;
+            int e0[4], e1[4];
+            for (int c = 0; c < 4; c++) { e0[c] = (int)b.Get(7) << 1; e1[c] = (int)b.Get(7) << 1; }
+            int p0 = (int)b.Get(1), p1 = (int)b.Get(1);
+            for (int c = 0; c < 4; c++) { e0[c] |= p0; e1[c] |= p1; }
+            for (int k = 0; k < 16; k++) {
+                int i = (int)b.Get(k == 0 ? 3 : 4);
+                for (int c = 0; c < 4; c++) px[k][c] = (uint8_t)(((64 - kWeights4[i]) * e0[c] + kWeights4[i] * e1[c] + 32) >> 6);
+            }
+            return true;
+        }
+
+        // --- ETC2 RGBA8: color ETC1 + alfa EAC ---
+
+        static const int kEtcModifiers[8][2] = { { 2, 8 }, { 5, 17 }, { 9, 29 }, { 13, 42 }, { 18, 60 }, { 24, 80 }, { 33, 106 }, { 47, 183 } };
+
+        static const int kEacModifiers[16][8] = {
+            { -3, -6, -9, -15, 2, 5, 8, 14 }, { -3, -7, -10, -13, 2, 6, 9, 12 }, { -2, -5, -8, -13, 1, 4, 7, 12 }, { -2, -4, -6, -13, 1, 3, 5, 12 },
+            { -3, -6, -8, -12, 2, 5, 7, 11 }, { -3, -7, -9, -11, 2, 6, 8, 10 }, { -4, -7, -8, -11, 3, 6, 7, 10 }, { -3, -5, -8, -11, 2, 4, 7, 10 },
+            { -2, -6, -8, -10, 1, 5, 7, 9 }, { -2, -5, -8, -10, 1, 4, 7, 9 }, { -2, -4, -8, -10, 1, 3, 7, 9 }, { -2, -5, -7, -10, 1, 4, 6, 9 },
+            { -3, -4, -7, -10, 2, 3, 6, 9 }, { -1, -2, -3, -10, 0, 1, 2, 9 }, { -4, -6, -8, -9, 3, 5, 7, 8 }, { -3, -5, -7, -9, 2, 4, 6, 8 }
+        };
+
+        inline int EtcModifier(int table, int idx) {
+            int m = kEtcModifiers[table][idx & 1];
+            return idx & 2 ? -m : m;
+        }
+
+        /** Pertenece al segundo subbloque (ETC1: 2x4 lado a lado, o 4x2 si flip). */
+        inline bool Second(int k, bool flip) { return flip ? (k >> 2) >= 2 : (k & 3) >= 2; }
+
+        /**
+         * Mejor tabla de modificadores para un subbloque con color base `base`.
+         * @returns {uint32_t} Error cuadrático RGB.
+         */
+        inline uint32_t FitSubblock(const uint8_t px[16][4], bool flip, bool second, const int base[3], int& table, uint8_t idx[16]) {
+            uint32_t best = UINT32_MAX;
+            uint8_t trial[16];
+            for (int t = 0; t < 8; t++) {
+                uint32_t total = 0;
+                for (int k = 0; k < 16 && total < best; k++) {
+                    if (Second(k, flip) != second) continue;
+                    uint32_t bestPx = UINT32_MAX;
+                    for (int i = 0; i < 4; i++) {
+                        int m = EtcModifier(t, i);
+                        uint32_t err = 0;
+                        for (int c = 0; c < 3; c++) { int d = Clamp255(base[c] + m) - px[k][c]; err += (uint32_t)(d * d); }
+                        if (err < bestPx) { bestPx = err; trial[k] = (uint8_t)i; }
+                    }
+                    total += bestPx;
+                }
+                if (total < best) {
+                    best = total;
+                    table = t;
+                    for (int k = 0; k < 16; k++) if (Second(k, flip) == second) idx[k] = trial[k];
+                }
+            }
+            return best;
+        }
+
+        inline void EncodeEtcColor(const uint8_t px[16][4], uint8_t out[8]) {
+            uint32_t best = UINT32_MAX;
+            for (int f = 0; f < 2; f++) {
+                bool flip = f == 1;
+                float avg[2][3] = {};
+                for (int k = 0; k < 16; k++) for (int c = 0; c < 3; c++) avg[Second(k, flip)][c] += px[k][c] / 8.0f;
+
+                // Diferencial (5 bits + delta de 3) si las medias están cerca; si no, individual (4 bits)
+                int q5[2][3], q4[2][3];
+                bool diff = true;
+                for (int s = 0; s < 2; s++) for (int c = 0; c < 3; c++) {
+                    q5[s][c] = std::min(31, (int)std::lround(avg[s][c] * 31.0f / 255.0f));
+                    q4[s][c] = std::min(15, (int)std::lround(avg[s][c] * 15.0f / 255.0f));
+                }
+                for (int c = 0; c < 3; c++) { int d = q5[1][c] - q5[0][c]; if (d < -4 || d > 3) diff = false; }
+                int base[2][3];
+                for (int s = 0; s < 2; s++) for (int c = 0; c < 3; c++) {
+                    base[s][c] = diff ? (q5[s][c] << 3) | (q5[s][c] >> 2) : (q4[s][c] << 4) | q4[s][c];
+                }
+                int tables[2];
+                uint8_t idx[16] = {};
+                uint32_t err = FitSubblock(px, flip, false, base[0], tables[0], idx);
+                if (err >= best) continue;
+                err += FitSubblock(px, flip, true, base[1], tables[1], idx);
+                if (err >= best) continue;
+                best = err;
+
+                for (int c = 0; c < 3; c++) {
+                    out[c] = diff ? (uint8_t)((q5[0][c] << 3) | ((q5[1][c] - q5[0][c]) & 7)) : (uint8_t)((q4[0][c] << 4) | q4[1][c]);
+                }
+                out[3] = (uint8_t)((tables[0] << 5) | (tables[1] << 2) | (diff ? 2 : 0) | (flip ? 1 : 0));
+                uint32_t msb = 0, lsb = 0;
+                for (int k = 0; k < 16; k++) {
+                    int bit = (k & 3) * 4 + (k >> 2);   // Los índices van por columnas
+                    msb |= (uint32_t)(idx[k] >> 1) << bit;
+                    lsb |= (uint32_t)(idx[k] & 1) << bit;
+                }
+                out[4] = (uint8_t)(msb >> 8); out[5] = (uint8_t)msb;
+                out[6] = (uint8_t)(lsb >> 8); out[7] = (uint8_t)lsb;
+            }
+        }
+
+        inline int EacValue(int base, int mult, int table, int i) { return Clamp255(base + kEacModifiers[table][i] * mult); }
+
+        inline void EncodeEacAlpha(const uint8_t px[16][4], uint8_t out[8]) {
+            int lo = 255, hi = 0;
+            for (int k = 0; k < 16; k++) { lo = std::min(lo, (int)px[k][3]); hi = std::max(hi, (int)px[k][3]); }
+            int bestBase = lo, bestMult = 1, bestTable = 13;
+            uint8_t bestIdx[16];
+            std::fill(bestIdx, bestIdx + 16, (uint8_t)4);   // Tabla 13, índice 4: modificador 0
+            if (lo != hi) {
+                uint32_t best = UINT32_MAX;
+                uint8_t idx[16];
+                auto tryFit = [&](int t, int m, int base) {
+                    uint32_t total = 0;
+                    for (int k = 0; k < 16 && total < best; k++) {
+                        uint32_t bestPx = UINT32_MAX;
+                        for (int i = 0; i < 8; i++) {
+                            int d = EacValue(base, m, t, i) - px[k][3];
+                            if ((uint32_t)(d * d) < bestPx) { bestPx = (uint32_t)(d * d); idx[k] = (uint8_t)i; }
+                        }
+                        total += bestPx;
+                    }
+                    if (total < best) {
+                        best = total;
+                        bestBase = base; bestMult = m; bestTable = t;
+                        std::memcpy(bestIdx, idx, 16);
+                    }
+                };
+                auto center = [&](int t, int m) {
+                    int mn = kEacModifiers[t][3], mx = kEacModifiers[t][7];
+                    return std::min(255, std::max(0, (int)std::lround(((lo - mn * m) + (hi - mx * m)) / 2.0)));
+                };
+                // Primero cada tabla con el multiplicador y la base que encajan el rango; luego se
+                // afina alrededor de la mejor
+                for (int t = 0; t < 16 && best; t++) {
+                    int m = (int)std::lround((double)(hi - lo) / (kEacModifiers[t][7] - kEacModifiers[t][3]));
+                    m = std::min(15, std::max(1, m));
+                    tryFit(t, m, center(t, m));
+                }
+                int t = bestTable, m0 = bestMult;
+                for (int m = std::max(1, m0 - 1); m <= std::min(15, m0 + 1) && best; m++) {
+                    int c = center(t, m);
+                    for (int base = std::max(0, c - 2); base <= std::min(255, c + 2) && best; base++) tryFit(t, m, base);
+                }
+            }
+            out[0] = (uint8_t)bestBase;
+            out[1] = (uint8_t)((bestMult << 4) | bestTable);
+            uint64_t bits = 0;
+            for (int k = 0; k < 16; k++) {
+                int slot = (k & 3) * 4 + (k >> 2);   // Por columnas, el primero en los bits altos
+                bits |= (uint64_t)bestIdx[k] << (45 - slot * 3);
+            }
+            for (int i = 0; i < 6; i++) out[2 + i] = (uint8_t)(bits >> (40 - i * 8));
+        }
+
+        inline void EncodeEtc2(const uint8_t px[16][4], uint8_t out[16]) {
+            EncodeEacAlpha(px, out);
+            EncodeEtcColor(px, out + 8);
+        }
+
+        /** Modos individual y diferencial sin desborde (lo que escribe EncodeEtcColor). */
+        inline bool DecodeEtc2(const uint8_t in[16], uint8_t px[16][4]) {
+            const uint8_t* a = in;
+            int base = a[0], mult = a[1] >> 4, table = a[1] & 15;
+            uint64_t bits = 0;
+            for (int i = 0; i < 6; i++) bits = (bits << 8) | a[2 + i];
+            const uint8_t* c = in + 8;
+            bool diff = (c[3] & 2) != 0, flip = (c[3] & 1) != 0;
+            int base0[3], base1[3];
+            for (int ch = 0; ch < 3; ch++) {
+                if (diff) {
+                    int b5 = c[ch] >> 3, d = c[ch] & 7;
+                    if (d >= 4) d -= 8;
+                    int b5s = b5 + d;
+                    if (b5s < 0 || b5s > 31) return false;   // T/H/planar
+                    base0[ch] = (b5 << 3) | (b5 >> 2);
+                    base1[ch] = (b5s << 3) | (b5s >> 2);
+                } else {
+                    int h = c[ch] >> 4, l = c[ch] & 15;
+                    base0[ch] = (h << 4) | h;
+                    base1[ch] = (l << 4) | l;
+                }
+            }
+            int tables[2] = { c[3] >> 5, (c[3] >> 2) & 7 };
+            uint32_t msb = ((uint32_t)c[4] << 8) | c[5], lsb = ((uint32_t)c[6] << 8) | c[7];
+            for (int k = 0; k < 16; k++) {
+                int slot = (k & 3) * 4 + (k >> 2);
+                int i = (int)(((msb >> slot) & 1) << 1 | ((lsb >> slot) & 1));
+                bool second = Second(k, flip);
+                const int* b = second ? base1 : base0;
+                int m = EtcModifier(tables[second], i);
+                for (int ch = 0; ch < 3; ch++) px[k][ch] = (uint8_t)Clamp255(b[ch] + m);
+                px[k][3] = (uint8_t)EacValue(base, mult, table, (int)((bits >> (45 - slot * 3)) & 7));
+            }
+            return true;
+        }
+
+        /**
+         * Reparte `count` trabajos entre el pool y el hilo que llama (mismo esquema que
+         * SongLibrary: los ayudantes que arranquen tarde no tocan nada del llamador).
+         */
+        inline void ParallelFor(size_t count, const std::function<void(size_t)>& fn, TaskPool* pool) {
+            if (count == 0) return;
+            struct Shared {
+                std::function<void(size_t)> fn;
+                std::atomic<size_t> next{0};
+                size_t done = 0;
+                std::mutex mtx;
+                std::condition_variable cv;
+            };
+            auto shared = std::make_shared<Shared>();
+            shared->fn = fn;
+            auto work = [shared, count] {
+                size_t ran = 0;
+                for (size_t i; (i = shared->next.fetch_add(1)) < count; ran++) shared->fn(i);
+                if (!ran) return;
+                std::lock_guard<std::mutex> lock(shared->mtx);
+                shared->done += ran;
+                shared->cv.notify_all();
+            };
+            size_t helpers = pool ? std::min(pool->Size(), count - 1) : 0;
+            for (size_t i = 0; i < helpers; i++) pool->Submit(work);
+            work();
+            std::unique_lock<std::mutex> lock(shared->mtx);
+            shared->cv.wait(lock, [&] { return shared->done >= count; });
+        }
+    }
+
+    /**
+     * Codifica la imagen (ya premultiplicada) en bloques de 16 bytes, fila de bloques a fila de bloques.
+     * @param {TaskPool*} pool - Si se indica, las filas de bloques se reparten entre sus hilos.
+     */
+    inline void Encode(const Png::Image& img, Format format, std::vector<uint8_t>& out, TaskPool* pool = nullptr) {
+        uint32_t bw = Blocks(img.width), bh = Blocks(img.height);
+        out.assign((size_t)bw * bh * kBlockBytes, 0);
+        if (img.width == 0 || img.height == 0) return;
+        Detail::ParallelFor(bh, [&](size_t by) {
+            uint8_t px[16][4];
+            for (uint32_t bx = 0; bx < bw; bx++) {
+                Detail::Load(img, bx, (uint32_t)by, px);
+                uint8_t* dst = out.data() + ((size_t)by * bw + bx) * kBlockBytes;
+                if (format == Format::BC7) Detail::EncodeBc7(px, dst);
+                else Detail::EncodeEtc2(px, dst);
+            }
+        }, pool);
+    }
+
+    /**
+     * Decodifica a RGBA (para medir calidad).
+     * @returns {bool} false si algún bloque usa un modo que estos codificadores no escriben.
+     */
+    inline bool Decode(const std::vector<uint8_t>& blocks, uint32_t width, uint32_t height, Format format, Png::Image& out) {
+        uint32_t bw = Blocks(width), bh = Blocks(height);
+        if (blocks.size() != (size_t)bw * bh * kBlockBytes) return false;
+        out.Resize(width, height);
+        uint8_t px[16][4];
+        for (uint32_t by = 0; by < bh; by++) {
+            for (uint32_t bx = 0; bx < bw; bx++) {
+                const uint8_t* src = blocks.data() + ((size_t)by * bw + bx) * kBlockBytes;
+                if (!(format == Format::BC7 ? Detail::DecodeBc7(src, px) : Detail::DecodeEtc2(src, px))) return false;
+                for (uint32_t y = 0; y < 4 && by * 4 + y < height; y++) {
+                    for (uint32_t x = 0; x < 4 && bx * 4 + x < width; x++) {
+                        std::memcpy(out.Row(by * 4 + y) + (size_t)(bx * 4 + x) * 4, px[y * 4 + x], 4);
+                    }
+                }
+            }
+        }
+        return true;
+    }
+}
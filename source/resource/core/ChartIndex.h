@@ -0,0 +1,273 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "Json.h"
+#include "MappedFile.h"
+
+/**
+ * @class ChartIndex
+ * @description Chart (formato Psych Engine) indexado en columnas ordenadas por tiempo.
+ * Se parsea una vez y responde consultas por ventana de tiempo con búsqueda binaria,
+ * sin volver a recorrer las secciones vacías del JSON.
+ *
+ * Carriles absolutos: 0-3 = oponente, 4-7 = jugador (ya resuelto `mustHitSection`,
+ * igual que hace Parser.parseNotes en la página).
+ */
+class ChartIndex {
+public:
+    // Columnas (struct-of-arrays), todas del mismo tamaño y ordenadas por `time`
+    std::vector<double> time;       // ms
+    std::vector<float> sustain;     // ms
+    std::vector<uint8_t> lane;      // 0-7 absoluto
+    std::vector<uint16_t> type;     // Índice en `types` (0 = nota normal)
+    std::vector<uint16_t> section;  // Sección original
+
+    std::vector<std::string> types{ "" };
+
+    // Metadatos de song.*
+    std::string song, player, enemy, gfVersion, stage, noteSkin;
+    double bpm = 0.0, speed = 1.0;
+    size_t sectionCount = 0;
+
+    size_t Count() const { return time.size(); }
+    /** Fin de la última nota en sonar: una sostenida larga puede acabar después de la última en empezar. */
+    double Duration() const { return duration; }
+
+    /**
+     * Carga un chart desde disco.
+     */
+    bool Load(const std::filesystem::path& path, std::string* err = nullptr) {
+        MappedFile f;
+        if (!f.Open(path)) { if (err) *err = "cannot open"; return false; }
+        return Parse(std::string_view(f.Data() ? f.Data() : "", f.Size()), err);
+    }
+
+    /**
+     * Construye el índice desde el texto JSON.
+     */
+    bool Parse(std::string_view text, std::string* err = nullptr) {
+        Json::Value doc;
+        if (!Json::Parse(text, doc, err)) return false;
+        const Json::Value& s = doc["song"].IsObject() ? doc["song"] : doc;
+        const Json::Value& notes = s["notes"];
+        if (!notes.IsArray()) { if (err) *err = "missing song.notes"; return false; }
+
+        song = s["song"].Str(); player = s["player"].Str(s["player1"].Str());
+        enemy = s["enemy"].Str(s["player2"].Str()); gfVersion = s["gfVersion"].Str(s["player3"].Str());
+        stage = s["stage"].Str(); noteSkin = s["noteSkin"].Str("Funkin");
+        bpm = s["bpm"].Num(0.0); speed = s["speed"].Num(1.0);
+        sectionCount = notes.Size();
+
+        Clear();
+        size_t estimate = 0;
+        for (const auto& sec : notes.Items()) estimate += sec["sectionNotes"].Size();
+        Reserve(estimate);
+
+        std::unordered_map<std::string, uint16_t> typeIds;
+        for (size_t si = 0; si < notes.Size(); si++) {
+            const Json::Value& sec = notes[si];
+            bool mustHit = sec["mustHitSection"].Bool(false);
+            for (const auto& n : sec["sectionNotes"].Items()) {
+                if (!n.IsArray() || n.Size() < 2 || !n[0].IsNumber() || !n[1].IsNumber()) continue;
+                int raw = n[1].Int();
+                if (raw < 0 || raw > 7) continue;
+                bool isPlayer = mustHit ? raw < 4 : raw >= 4;
+                time.push_back(n[0].Num());
+                sustain.push_back((float)n[2].Num(0.0));
+                lane.push_back((uint8_t)((raw % 4) + (isPlayer ? 4 : 0)));
+                section.push_back((uint16_t)std::min<size_t>(si, 0xFFFF));
+                type.push_back(TypeId(n[3], typeIds));
+            }
+        }
+        SortByTime();
+        return true;
+    }
+
+    /**
+     * Primer índice con time >= t.
+     */
+    size_t LowerBound(double t) const { return (size_t)(std::lower_bound(time.begin(), time.end(), t) - time.begin()); }
+
+    /**
+     * Rango [first, last) de notas que empiezan en [t0, t1).
+     * Con `includeHolds`, amplía hacia atrás lo bastante para cubrir sostenidas que empezaron
+     * antes de t0; el llamador descarta las que terminan antes (ver Overlaps).
+     */
+    std::pair<size_t, size_t> Range(double t0, double t1, bool includeHolds = false) const {
+        size_t first = LowerBound(includeHolds ? t0 - maxSustain : t0), last = LowerBound(t1);
+        return { first, last };
+    }
+
+    /**
+     * La nota `i` suena en algún momento de [t0, ...).
+     */
+    bool Overlaps(size_t i, double t0) const { return time[i] >= t0 || time[i] + sustain[i] >= t0; }
+
+    /**
+     * Cuenta notas por cubeta entre t0 y t1.
+     * @param {uint8_t} laneMask - Bits de carriles a contar (0xFF = todos, 0x0F = oponente, 0xF0 = jugador).
+     */
+    void Density(double t0, double t1, size_t buckets, std::vector<uint32_t>& out, uint8_t laneMask = 0xFF) const {
+        out.assign(buckets, 0);
+        if (buckets == 0 || t1 <= t0) return;
+        double scale = (double)buckets / (t1 - t0);
+        for (size_t i = LowerBound(t0), end = LowerBound(t1); i < end; i++) {
+            if (!(laneMask & (1u << lane[i]))) continue;
+            size_t b = (size_t)((time[i] - t0) * scale);
+            out[b < buckets ? b : buckets - 1]++;
+        }
+    }
+
+    /**
+     * Memoria aproximada de las columnas (bytes).
+     */
+    size_t MemoryBytes() const {
+        return time.capacity() * sizeof(double) + sustain.capacity() * sizeof(float) + lane.capacity()
+            + type.capacity() * sizeof(uint16_t) + section.capacity() * sizeof(uint16_t);
+    }
+
+private:
+    double maxSustain = 0.0;
+    double duration = 0.0;
+
+    void Clear() { time.clear(); sustain.clear(); lane.clear(); type.clear(); section.clear(); types.assign(1, ""); maxSustain = 0.0; duration = 0.0; }
+    void Reserve(size_t n) { time.reserve(n); sustain.reserve(n); lane.reserve(n); type.reserve(n); section.reserve(n); }
+
+    uint16_t TypeId(const Json::Value& v, std::unordered_map<std::string, uint16_t>& ids) {
+        std::string name;
+        if (v.IsString()) name = v.Str();
+        else if (v.IsNumber() && v.Num() != 0.0) name = std::to_string(v.Int());
+        if (name.empty()) return 0;
+        auto it = ids.find(name);
+        if (it != ids.end()) return it->second;
+        if (types.size() >= 0xFFFF) return 0;
+        uint16_t id = (uint16_t)types.size();
+        types.push_back(name);
+        ids.emplace(name, id);
+        return id;
+    }
+
+    void SortByTime() {
+        for (size_t i = 0; i < time.size(); i++) {
+            if (sustain[i] > maxSustain) maxSustain = sustain[i];
+            if (time[i] + sustain[i] > duration) duration = time[i] + sustain[i];
+        }
+        if (std::is_sorted(time.begin(), time.end())) return;
+        std::vector<uint32_t> order(time.size());
+        std::iota(order.begin(), order.end(), 0u);
+        std::stable_sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b) { return time[a] < time[b]; });
+        Permute(time, order); Permute(sustain, order); Permute(lane, order); Permute(type, order); Permute(section, order);
+    }
+
+    template <typename T>
+    static void Permute(std::vector<T>& col, const std::vector<uint32_t>& order) {
+        std::vector<T> out(col.size());
+        for (size_t i = 0; i < order.size(); i++) out[i] = col[order[i]];
+        col.swap(out);
+    }
+};
+
+/**
+ * @class ChartRegistry
+ * @description Charts abiertos por la página, por handle. Los índices son inmutables una vez
+ * construidos, así que las consultas se hacen sin bloquear más que la búsqueda del handle.
+ * - Cada Open cuenta una referencia y cada Close la suelta: dos vistas con el mismo chart
+ *   comparten handle y la primera en cerrar no se lo quita a la otra.
+ * - Si el archivo cambió (fecha o tamaño) desde que se indexó, Open lo vuelve a indexar con
+ *   un handle nuevo; quien tenga el viejo sigue viendo su versión hasta cerrarlo.
+ */
+class ChartRegistry {
+public:
+    /**
+     * Abre (o reutiliza si ya estaba abierto y no ha cambiado) el chart de `path`.
+     * @returns {uint32_t} Handle, 0 si falla. Cada handle devuelto se cierra con un Close.
+     */
+    uint32_t Open(const std::filesystem::path& path, std::string* err = nullptr) {
+        std::string key = path.lexically_normal().u8string();
+        Stamp stamp = StampOf(path);
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            if (uint32_t id = Reuse(key, stamp)) return id;
+        }
+        auto chart = std::make_shared<ChartIndex>();
+        if (!chart->Load(path, err)) return 0;
+        std::lock_guard<std::mutex> lock(mtx);
+        // Otro hilo pudo indexar el mismo archivo mientras tanto
+        if (uint32_t id = Reuse(key, stamp)) return id;
+        uint32_t id = nextId++;
+        if (nextId == 0) nextId = 1;
+        Entry& e = charts[id];
+        e.chart = chart; e.key = key; e.stamp = stamp; e.refs = 1;
+        byPath[key] = id;
+        return id;
+    }
+
+    std::shared_ptr<const ChartIndex> Get(uint32_t id) {
+        std::lock_guard<std::mutex> lock(mtx);
+        auto it = charts.find(id);
+        return it == charts.end() ? nullptr : it->second.chart;
+    }
+
+    /**
+     * Suelta una referencia; el índice se libera con la última.
+     */
+    void Close(uint32_t id) {
+        std::lock_guard<std::mutex> lock(mtx);
+        auto it = charts.find(id);
+        if (it == charts.end() || --it->second.refs > 0) return;
+        auto p = byPath.find(it->second.key);
+        if (p != byPath.end() && p->second == id) byPath.erase(p);
+        charts.erase(it);
+    }
+
+    size_t OpenCount() {
+        std::lock_guard<std::mutex> lock(mtx);
+        return charts.size();
+    }
+
+private:
+    struct Stamp {
+        uintmax_t size = 0;
+        std::filesystem::file_time_type mtime{};
+        bool operator==(const Stamp& o) const { return size == o.size && mtime == o.mtime; }
+    };
+
+    struct Entry {
+        std::shared_ptr<const ChartIndex> chart;
+        std::string key;
+        Stamp stamp;
+        uint32_t refs = 0;
+    };
+
+    std::mutex mtx;
+    std::unordered_map<uint32_t, Entry> charts;
+    std::unordered_map<std::string, uint32_t> byPath; // Solo la versión más reciente de cada archivo
+    uint32_t nextId = 1;
+
+    static Stamp StampOf(const std::filesystem::path& path) {
+        Stamp s;
+        std::error_code ec;
+        s.size = std::filesystem::file_size(path, ec);
+        if (ec) s.size = 0;
+        s.mtime = std::filesystem::last_write_time(path, ec);
+        return s;
+    }
+
+    /** Con el mutex tomado: suma una referencia al handle vigente de `key` si sigue al día. */
+    uint32_t Reuse(const std::string& key, const Stamp& stamp) {
+        auto it = byPath.find(key);
+        if (it == byPath.end()) return 0;
+        auto c = charts.find(it->second);
+        if (c == charts.end() || !(c->second.stamp == stamp)) return 0;
+        c->second.refs++;
+        return it->second;
+    }
+};
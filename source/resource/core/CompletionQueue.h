@@ -0,0 +1,59 @@
+#pragma once
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+/**
+ * @class CompletionQueue
+ * @description Cola multi-productor / consumidor único para devolver resultados al hilo de UI.
+ * Solo se despierta al consumidor cuando la cola pasa de vacía a no vacía, así que una ráfaga
+ * de completados cuesta un único mensaje de ventana.
+ * @template T - Tipo del completado.
+ */
+template <typename T>
+class CompletionQueue {
+public:
+    using WakeFn = std::function<void()>;
+
+    /**
+     * @param {WakeFn} wake - Despierta al consumidor (ej: PostMessage al HWND). Puede llamarse desde cualquier hilo.
+     */
+    explicit CompletionQueue(WakeFn wake = nullptr) : wake(std::move(wake)) {}
+
+    void SetWake(WakeFn fn) { wake = std::move(fn); }
+
+    void Push(T item) {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            items.push_back(std::move(item));
+        }
+        if (!signaled.exchange(true, std::memory_order_acq_rel) && wake) wake();
+    }
+
+    /**
+     * Consume todos los completados pendientes. Solo desde el hilo consumidor.
+     * @param {Fn} fn - Invocable void(T&).
+     * @returns {size_t} Número de elementos procesados.
+     */
+    template <typename Fn>
+    size_t Drain(Fn&& fn) {
+        signaled.store(false, std::memory_order_release);
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            draining.swap(items);
+        }
+        size_t n = draining.size();
+        for (auto& item : draining) fn(item);
+        draining.clear(); // Conserva la capacidad para el siguiente drenado
+        return n;
+    }
+
+private:
+    std::mutex mtx;
+    std::vector<T> items;
+    std::vector<T> draining;
+    std::atomic<bool> signaled{false};
+    WakeFn wake;
+};
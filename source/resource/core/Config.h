@@ -0,0 +1,79 @@
+#pragma once
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include "AtomicFile.h"
+#include "Json.h"
+#include "Utf.h"
+
+namespace fs = std::filesystem;
+
+/**
+ * @struct AppConfig
+ * @description Configuración global de la ventana y la aplicación.
+ */
+struct AppConfig {
+    std::wstring title = L"Genesis Engine";
+    std::wstring icon = L"";
+    std::wstring appID = L"com.genesis.engine";
+    int width = 1280; int height = 720; 
+    int minWidth = 800; int minHeight = 600;
+    
+    // Frecuencia del bucle de Phaser (FramePacer); fpsIdle = tope sin entrada del usuario (0 = sin tope)
+    int fpsLimit = 300; 
+    int fpsIdle = 30;
+
+    // Ventana de coalescencia de los guardados (ms)
+    int saveCoalesceMs = 250;
+
+    // Paquete de assets junto al exe (vacío = servir la carpeta suelta)
+    std::wstring assetPack = L"assets.gpak";
+
+    bool startMaximized = false; bool resizable = true; bool fullscreen = false;
+    bool frame = true; bool alwaysOnTop = false; bool singleInstance = true; bool devTools = true;
+};
+
+/**
+ * @class ConfigLoader
+ * @description Carga la configuración desde windowConfig.json. Portable: el parseo no
+ * toca la API de Windows, así que se puede medir y probar fuera de la ventana.
+ */
+class ConfigLoader {
+public:
+    /**
+     * Aplica un windowConfig.json sobre la configuración. Las claves ausentes o de otro
+     * tipo conservan el valor por defecto.
+     * @returns {bool} false si el texto no es un objeto JSON válido (la config no cambia).
+     */
+    static bool Parse(std::string_view json, AppConfig& c) {
+        Json::Value root;
+        if (!Json::Parse(json, root) || !root.IsObject()) return false;
+
+        const std::string& t = root["title"].Str(); if (!t.empty()) c.title = Utf::ToWide(t);
+        const std::string& i = root["icon"].Str(); if (!i.empty()) c.icon = Utf::ToWide(i);
+        const std::string& id = root["appID"].Str(); if (!id.empty()) c.appID = Utf::ToWide(id);
+        if (root.Has("assetPack")) c.assetPack = Utf::ToWide(root["assetPack"].Str());
+
+        c.width = root["width"].Int(c.width); c.height = root["height"].Int(c.height);
+        c.minWidth = root["minWidth"].Int(c.minWidth); c.minHeight = root["minHeight"].Int(c.minHeight);
+        c.fpsLimit = root["fpsLimit"].Int(c.fpsLimit);
+        c.fpsIdle = root["fpsIdle"].Int(c.fpsIdle);
+        c.saveCoalesceMs = root["saveCoalesceMs"].Int(c.saveCoalesceMs);
+
+        c.startMaximized = root["startMaximized"].Bool(c.startMaximized); c.resizable = root["resizable"].Bool(c.resizable);
+        c.fullscreen = root["fullscreen"].Bool(c.fullscreen); c.frame = root["frame"].Bool(c.frame);
+        c.alwaysOnTop = root["alwaysOnTop"].Bool(c.alwaysOnTop); c.singleInstance = root["singleInstance"].Bool(c.singleInstance);
+        c.devTools = root["devTools"].Bool(c.devTools);
+        return true;
+    }
+
+    /**
+     * Lee <exeDir>/windowConfig.json. Si falta o está roto se usan los valores por defecto.
+     */
+    static AppConfig Load(const fs::path& exeDir) {
+        AppConfig c;
+        std::string json;
+        if (AtomicFile::ReadAll(exeDir / "windowConfig.json", json)) Parse(json, c);
+        return c;
+    }
+};
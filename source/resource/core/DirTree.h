@@ -0,0 +1,351 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "DirWatcher.h"
+#include "Glob.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#include "Utf.h"
+#else
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#endif
+
+/**
+ * @class DirTreeCache
+ * @description Caché del árbol de carpetas bajo una raíz. Cada carpeta se lee del disco la primera
+ * vez que se pide y queda guardada como instantánea inmutable; un DirWatcher la mantiene al día
+ * aplicando los cambios con copia-en-escritura (Apply), así que repetir un listado es una búsqueda
+ * en un hash en lugar de recorrer el disco.
+ *
+ * Sin watcher activo (SetLive(false)) no se guarda nada y cada listado lee el disco como antes.
+ */
+class DirTreeCache {
+public:
+    struct Entry {
+        bool isDir = false;
+        bool isLink = false;   // Los enlaces a carpetas no se recorren en listados recursivos
+        uint64_t size = 0;
+        int64_t mtimeMs = 0;   // Unix, milisegundos
+    };
+
+    /** Contenido de una carpeta, ordenado por nombre. Nunca se modifica una vez publicado. */
+    using Dir = std::map<std::string, Entry>;
+
+    struct Item {
+        std::string path;      // Relativa a la carpeta pedida, con '/'
+        bool isDir = false;
+        uint64_t size = 0;
+        int64_t mtimeMs = 0;
+    };
+
+    struct Stats {
+        uint64_t hits = 0;      // Carpetas servidas desde la caché
+        uint64_t scans = 0;     // Carpetas leídas del disco
+        uint64_t patches = 0;   // Cambios del watcher aplicados sobre una carpeta en caché
+        uint64_t drops = 0;     // Carpetas descartadas (borradas, movidas o desbordamiento)
+    };
+
+    explicit DirTreeCache(std::filesystem::path root = {}) : root(std::move(root)) {}
+
+    DirTreeCache(const DirTreeCache&) = delete;
+    DirTreeCache& operator=(const DirTreeCache&) = delete;
+
+    void SetRoot(const std::filesystem::path& newRoot) {
+        std::unique_lock<std::shared_mutex> lock(mtx);
+        root = newRoot;
+        ClearLocked();
+    }
+
+    const std::filesystem::path& Root() const { return root; }
+
+    /**
+     * Activa o desactiva el guardado. Debe activarse solo con un watcher vigilando la raíz:
+     * sin él, la caché no se enteraría de los cambios.
+     */
+    void SetLive(bool on) {
+        std::unique_lock<std::shared_mutex> lock(mtx);
+        live = on;
+        if (!on) ClearLocked();
+    }
+
+    /**
+     * Normaliza una ruta de la página a la clave interna ("" = raíz, "a/b").
+     * @returns {bool} false si contiene "..", unidad o ruta absoluta de sistema.
+     */
+    static bool Normalize(std::string_view path, std::string& out) {
+        out.clear();
+        size_t i = 0;
+        if (path.size() >= 2 && path[1] == ':') return false;
+        while (i <= path.size()) {
+            size_t j = i;
+            while (j < path.size() && path[j] != '/' && path[j] != '\\') j++;
+            std::string_view part = path.substr(i, j - i);
+            if (part == "..") return false;
+            if (!part.empty() && part != ".") {
+                if (!out.empty()) out += '/';
+                out.append(part);
+            }
+            i = j + 1;
+        }
+        return true;
+    }
+
+    /**
+     * Contenido de una carpeta (clave normalizada). Lee del disco si no estaba en caché.
+     * @returns {nullptr} si la carpeta no existe.
+     */
+    std::shared_ptr<const Dir> Get(const std::string& rel) {
+        uint64_t seen;
+        {
+            std::shared_lock<std::shared_mutex> lock(mtx);
+            auto it = dirs.find(rel);
+            if (it != dirs.end()) { Bump(stats.hits); return it->second; }
+            seen = generation;
+        }
+        auto dir = std::make_shared<Dir>();
+        if (!Scan(rel, *dir)) return nullptr;
+        Bump(stats.scans);
+        std::unique_lock<std::shared_mutex> lock(mtx);
+        // Si entró algún cambio mientras se leía, la lectura puede estar atrasada: se usa pero no se guarda
+        if (live && generation == seen) {
+            auto res = dirs.emplace(rel, dir);
+            if (!res.second) return res.first->second;
+            keys.insert(rel);
+        }
+        return dir;
+    }
+
+    /**
+     * Lista una carpeta.
+     * @param {string} relDir - Ruta relativa a la raíz ('/' o '\\').
+     * @param {bool} recursive - Incluye subcarpetas (sin seguir enlaces).
+     * @param {string} glob - Filtro (ver Glob::MatchEntry) sobre la ruta relativa a `relDir`. Vacío = todo.
+     * @param {function} cancelled - Se consulta entre carpetas; si devuelve true se corta el listado.
+     * @returns {bool} false si la ruta no es válida, no existe o se canceló.
+     */
+    bool List(std::string_view relDir, bool recursive, std::string_view glob, std::vector<Item>& out,
+              const std::function<bool()>& cancelled = nullptr) {
+        std::string base;
+        if (!Normalize(relDir, base)) return false;
+        std::vector<std::string> pending{ std::string() };
+        bool first = true;
+        while (!pending.empty()) {
+            if (cancelled && cancelled()) return false;
+            std::string sub = std::move(pending.back());
+            pending.pop_back();
+            auto dir = Get(base.empty() ? sub : sub.empty() ? base : base + "/" + sub);
+            if (!dir) { if (first) return false; continue; }
+            first = false;
+            size_t mark = pending.size();
+            for (const auto& [name, e] : *dir) {
+                std::string path = sub.empty() ? name : sub + "/" + name;
+                if (recursive && e.isDir && !e.isLink) pending.push_back(path);
+                if (Glob::MatchEntry(glob, path)) out.push_back({ std::move(path), e.isDir, e.size, e.mtimeMs });
+            }
+            // Las subcarpetas se visitan en orden alfabético
+            std::reverse(pending.begin() + mark, pending.end());
+        }
+        return true;
+    }
+
+    /**
+     * Aplica un lote de cambios del watcher. Las carpetas en caché afectadas se reemplazan por
+     * copias con la entrada actualizada; las carpetas borradas o movidas se olvidan con todo su subárbol.
+     */
+    void Apply(const std::vector<DirWatcher::Change>& changes) {
+        // Los stat se hacen antes de tomar el cerrojo
+        struct Patch { std::string parent, name; bool exists; Entry entry; bool hintDir; };
+        std::vector<Patch> patches;
+        patches.reserve(changes.size());
+        bool overflow = false;
+        for (const auto& c : changes) {
+            if (c.kind == DirWatcher::Kind::Overflow) { overflow = true; break; }
+            size_t slash = c.path.rfind('/');
+            Patch p;
+            p.parent = slash == std::string::npos ? std::string() : c.path.substr(0, slash);
+            p.name = slash == std::string::npos ? c.path : c.path.substr(slash + 1);
+            p.exists = c.kind != DirWatcher::Kind::Removed && StatPath(Full(c.path), p.entry);
+            p.hintDir = c.isDir;
+            patches.push_back(std::move(p));
+        }
+
+        std::unique_lock<std::shared_mutex> lock(mtx);
+        generation++;
+        if (overflow) { Bump(stats.drops, dirs.size()); ClearLocked(); return; }
+        for (auto& p : patches) {
+            std::string path = p.parent.empty() ? p.name : p.parent + "/" + p.name;
+            bool wasDir = p.hintDir;
+            auto it = dirs.find(p.parent);
+            if (it != dirs.end()) {
+                const Dir& old = *it->second;
+                auto e = old.find(p.name);
+                if (e != old.end()) wasDir = wasDir || e->second.isDir;
+                bool same = p.exists ? (e != old.end() && SameEntry(e->second, p.entry)) : e == old.end();
+                if (!same) {
+                    auto copy = std::make_shared<Dir>(old);
+                    if (p.exists) (*copy)[p.name] = p.entry;
+                    else copy->erase(p.name);
+                    it->second = std::move(copy);
+                    Bump(stats.patches);
+                }
+            }
+            // Una carpeta que desaparece o cambia de tipo se vuelve a leer entera cuando se pida
+            if (!p.exists || p.hintDir || wasDir != p.entry.isDir) DropSubtreeLocked(path);
+        }
+    }
+
+    /** Olvida todo; la siguiente petición de cada carpeta vuelve a leer el disco. */
+    void Clear() {
+        std::unique_lock<std::shared_mutex> lock(mtx);
+        generation++;
+        ClearLocked();
+    }
+
+    Stats GetStats() const {
+        Stats s;
+        s.hits = stats.hits.load(std::memory_order_relaxed);
+        s.scans = stats.scans.load(std::memory_order_relaxed);
+        s.patches = stats.patches.load(std::memory_order_relaxed);
+        s.drops = stats.drops.load(std::memory_order_relaxed);
+        return s;
+    }
+
+    size_t CachedDirs() const {
+        std::shared_lock<std::shared_mutex> lock(mtx);
+        return dirs.size();
+    }
+
+private:
+    /**
+     * Contadores atómicos: Get los suma con el lock compartido (varios lectores a la vez) o sin
+     * lock. Solo son estadística, así que basta con relaxed; GetStats no toma el lock y cada
+     * valor es exacto aunque los cuatro no salgan del mismo instante.
+     */
+    struct Counters {
+        std::atomic<uint64_t> hits{0}, scans{0}, patches{0}, drops{0};
+    };
+
+    static void Bump(std::atomic<uint64_t>& c, uint64_t n = 1) { c.fetch_add(n, std::memory_order_relaxed); }
+
+    std::filesystem::path root;
+    mutable std::shared_mutex mtx;
+    std::unordered_map<std::string, std::shared_ptr<const Dir>> dirs;
+    std::set<std::string> keys; // Las mismas claves, ordenadas para descartar subárboles por prefijo
+    uint64_t generation = 0;
+    bool live = false;
+    Counters stats;
+
+    std::filesystem::path Full(const std::string& rel) const {
+        return rel.empty() ? root : root / std::filesystem::u8path(rel);
+    }
+
+    static bool SameEntry(const Entry& a, const Entry& b) {
+        return a.isDir == b.isDir && a.isLink == b.isLink && a.size == b.size && a.mtimeMs == b.mtimeMs;
+    }
+
+    void ClearLocked() {
+        dirs.clear();
+        keys.clear();
+    }
+
+    void DropSubtreeLocked(const std::string& path) {
+        auto drop = [&](std::set<std::string>::iterator k) {
+            dirs.erase(*k);
+            Bump(stats.drops);
+            return keys.erase(k);
+        };
+        auto self = keys.find(path);
+        if (self != keys.end()) drop(self);
+        std::string prefix = path + "/";
+        for (auto k = keys.lower_bound(prefix); k != keys.end() && k->compare(0, prefix.size(), prefix) == 0; ) k = drop(k);
+    }
+
+#ifdef _WIN32
+    static int64_t ToUnixMs(const FILETIME& ft) {
+        uint64_t t = ((uint64_t)ft.dwHighDateTime << 32) | ft.dwLowDateTime;
+        return (int64_t)(t / 10000) - 11644473600000LL;
+    }
+
+    bool Scan(const std::string& rel, Dir& out) const {
+        std::wstring pattern = Full(rel).wstring() + L"\\*";
+        WIN32_FIND_DATAW fd;
+        HANDLE h = FindFirstFileExW(pattern.c_str(), FindExInfoBasic, &fd, FindExSearchNameMatch, NULL, FIND_FIRST_EX_LARGE_FETCH);
+        if (h == INVALID_HANDLE_VALUE) return false;
+        do {
+            if (fd.cFileName[0] == L'.' && (!fd.cFileName[1] || (fd.cFileName[1] == L'.' && !fd.cFileName[2]))) continue;
+            Entry e;
+            e.isDir = (fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+            e.isLink = (fd.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) != 0;
+            e.size = e.isDir ? 0 : (((uint64_t)fd.nFileSizeHigh << 32) | fd.nFileSizeLow);
+            e.mtimeMs = ToUnixMs(fd.ftLastWriteTime);
+            out.emplace(Utf::ToUtf8(fd.cFileName), e);
+        } while (FindNextFileW(h, &fd));
+        FindClose(h);
+        return true;
+    }
+
+    static bool StatPath(const std::filesystem::path& path, Entry& e) {
+        WIN32_FILE_ATTRIBUTE_DATA a;
+        if (!GetFileAttributesExW(path.c_str(), GetFileExInfoStandard, &a)) return false;
+        e.isDir = (a.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+        e.isLink = (a.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) != 0;
+        e.size = e.isDir ? 0 : (((uint64_t)a.nFileSizeHigh << 32) | a.nFileSizeLow);
+        e.mtimeMs = ToUnixMs(a.ftLastWriteTime);
+        return true;
+    }
+#else
+    static void FromStat(const struct stat& st, Entry& e) {
+        e.isDir = S_ISDIR(st.st_mode);
+        e.size = e.isDir ? 0 : (uint64_t)st.st_size;
+        e.mtimeMs = (int64_t)st.st_mtim.tv_sec * 1000 + st.st_mtim.tv_nsec / 1000000;
+    }
+
+    bool Scan(const std::string& rel, Dir& out) const {
+        int fd = ::open(Full(rel).c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (fd < 0) return false;
+        DIR* d = ::fdopendir(fd);
+        if (!d) { ::close(fd); return false; }
+        while (dirent* de = ::readdir(d)) {
+            const char* n = de->d_name;
+            if (n[0] == '.' && (!n[1] || (n[1] == '.' && !n[2]))) continue;
+            struct stat st;
+            if (::fstatat(fd, n, &st, AT_SYMLINK_NOFOLLOW) != 0) continue;
+            Entry e;
+            if (S_ISLNK(st.st_mode)) {
+                e.isLink = true;
+                if (::fstatat(fd, n, &st, 0) != 0) continue; // Enlace roto
+            }
+            FromStat(st, e);
+            out.emplace(n, e);
+        }
+        ::closedir(d);
+        return true;
+    }
+
+    static bool StatPath(const std::filesystem::path& path, Entry& e) {
+        struct stat st;
+        if (::lstat(path.c_str(), &st) != 0) return false;
+        if (S_ISLNK(st.st_mode)) {
+            e.isLink = true;
+            if (::stat(path.c_str(), &st) != 0) return false;
+        }
+        FromStat(st, e);
+        return true;
+    }
+#endif
+};
@@ -0,0 +1,272 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#include "Utf.h"
+#else
+#include <cerrno>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+/**
+ * @class DirWatcher
+ * @description Vigila un árbol de carpetas y entrega los cambios en lotes desde un hilo propio.
+ * Backend: inotify en Linux (un watch por carpeta, mantenido al crear/mover/borrar carpetas)
+ * y ReadDirectoryChangesW recursivo en Windows.
+ *
+ * Los cambios de un mismo lote se funden por ruta (varias escrituras = un Modified).
+ * Si el sistema pierde eventos (cola llena) llega un Overflow: hay que releer todo.
+ */
+class DirWatcher {
+public:
+    enum class Kind : uint8_t { Added, Removed, Modified, Overflow };
+
+    struct Change {
+        Kind kind;
+        std::string path;   // Relativa a la raíz, con '/', UTF-8
+        bool isDir = false; // Fiable en Added; en Removed solo en Linux
+    };
+
+    using Callback = std::function<void(std::vector<Change>& changes)>;
+
+    ~DirWatcher() { Stop(); }
+
+    /**
+     * Empieza a vigilar `root`. El callback se llama desde el hilo del watcher.
+     * @param {milliseconds} settle - Tiempo que se siguen juntando eventos antes de entregar un lote.
+     */
+    bool Start(const std::filesystem::path& root, Callback cb, std::chrono::milliseconds settle = std::chrono::milliseconds(15)) {
+        Stop();
+        this->root = root;
+        this->callback = std::move(cb);
+        this->settle = settle;
+        if (!OpenBackend()) { CloseBackend(); return false; }
+        running = true;
+        worker = std::thread(&DirWatcher::Loop, this);
+        return true;
+    }
+
+    void Stop() {
+        if (!running.exchange(false)) return;
+#ifdef _WIN32
+        SetEvent(stopEvent);
+        CancelIoEx(dirHandle, NULL);
+#else
+        uint64_t one = 1;
+        (void)!::write(stopFd, &one, sizeof(one));
+#endif
+        if (worker.joinable()) worker.join();
+        CloseBackend();
+    }
+
+    bool IsRunning() const { return running; }
+
+private:
+    std::filesystem::path root;
+    Callback callback;
+    std::chrono::milliseconds settle{15};
+    std::atomic<bool> running{false};
+    std::thread worker;
+
+    // --- Fusión de eventos por lote ---
+
+    std::vector<Change> batch;
+    std::unordered_map<std::string, size_t> batchIndex;
+
+    void Push(Kind kind, std::string path, bool isDir) {
+        if (kind == Kind::Overflow) { batch.push_back({ kind, std::string(), false }); return; }
+        auto it = batchIndex.find(path);
+        if (it == batchIndex.end()) {
+            batchIndex.emplace(path, batch.size());
+            batch.push_back({ kind, std::move(path), isDir });
+            return;
+        }
+        Change& c = batch[it->second];
+        if (kind == Kind::Removed) c.kind = Kind::Removed;
+        else if (kind == Kind::Added) c.kind = (c.kind == Kind::Removed) ? Kind::Modified : Kind::Added;
+        else if (c.kind == Kind::Removed) c.kind = Kind::Modified; // Reemplazado
+        c.isDir = c.isDir || isDir;
+    }
+
+    void Deliver() {
+        if (batch.empty()) return;
+        if (callback) callback(batch);
+        batch.clear();
+        batchIndex.clear();
+    }
+
+    static std::string Join(const std::string& dir, const std::string& name) { return dir.empty() ? name : dir + "/" + name; }
+
+#ifdef _WIN32
+    HANDLE dirHandle = INVALID_HANDLE_VALUE;
+    HANDLE stopEvent = NULL;
+    HANDLE ioEvent = NULL;
+
+    bool OpenBackend() {
+        dirHandle = CreateFileW(root.c_str(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+            NULL, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, NULL);
+        stopEvent = CreateEventW(NULL, TRUE, FALSE, NULL);
+        ioEvent = CreateEventW(NULL, TRUE, FALSE, NULL);
+        return dirHandle != INVALID_HANDLE_VALUE && stopEvent && ioEvent;
+    }
+
+    void CloseBackend() {
+        if (dirHandle != INVALID_HANDLE_VALUE) CloseHandle(dirHandle);
+        if (stopEvent) CloseHandle(stopEvent);
+        if (ioEvent) CloseHandle(ioEvent);
+        dirHandle = INVALID_HANDLE_VALUE; stopEvent = ioEvent = NULL;
+    }
+
+    void Loop() {
+        std::vector<DWORD> buffer(16 * 1024); // Alineado a DWORD como pide la API
+        const DWORD filter = FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME | FILE_NOTIFY_CHANGE_SIZE | FILE_NOTIFY_CHANGE_LAST_WRITE;
+        while (running) {
+            OVERLAPPED ov = {};
+            ov.hEvent = ioEvent;
+            ResetEvent(ioEvent);
+            if (!ReadDirectoryChangesW(dirHandle, buffer.data(), (DWORD)(buffer.size() * sizeof(DWORD)), TRUE, filter, NULL, &ov, NULL)) break;
+            // Con eventos ya en el lote, espera solo `settle` antes de entregarlos
+            HANDLE waits[2] = { ioEvent, stopEvent };
+            DWORD r = WaitForMultipleObjects(2, waits, FALSE, batch.empty() ? INFINITE : (DWORD)settle.count());
+            if (r == WAIT_TIMEOUT) {
+                Deliver();
+                r = WaitForMultipleObjects(2, waits, FALSE, INFINITE);
+            }
+            if (r != WAIT_OBJECT_0) { CancelIoEx(dirHandle, &ov); DWORD n; GetOverlappedResult(dirHandle, &ov, &n, TRUE); break; }
+            DWORD bytes = 0;
+            if (!GetOverlappedResult(dirHandle, &ov, &bytes, FALSE)) break;
+            if (bytes == 0) { Push(Kind::Overflow, std::string(), false); continue; }
+            for (DWORD off = 0;;) {
+                auto* info = (FILE_NOTIFY_INFORMATION*)((char*)buffer.data() + off);
+                std::string path = Utf::ToUtf8(std::wstring_view(info->FileName, info->FileNameLength / sizeof(WCHAR)));
+                for (auto& c : path) if (c == '\\') c = '/';
+                switch (info->Action) {
+                case FILE_ACTION_ADDED:
+                case FILE_ACTION_RENAMED_NEW_NAME: {
+                    DWORD attr = GetFileAttributesW((root / std::filesystem::u8path(path)).c_str());
+                    Push(Kind::Added, path, attr != INVALID_FILE_ATTRIBUTES && (attr & FILE_ATTRIBUTE_DIRECTORY));
+                    break;
+                }
+                case FILE_ACTION_REMOVED:
+                case FILE_ACTION_RENAMED_OLD_NAME: Push(Kind::Removed, path, false); break;
+                case FILE_ACTION_MODIFIED: Push(Kind::Modified, path, false); break;
+                }
+                if (!info->NextEntryOffset) break;
+                off += info->NextEntryOffset;
+            }
+        }
+        Deliver();
+    }
+#else
+    int inotifyFd = -1;
+    int stopFd = -1;
+    std::unordered_map<int, std::string> dirOf; // wd -> carpeta relativa
+    std::unordered_map<std::string, int> wdOf;
+
+    static constexpr uint32_t kMask = IN_CREATE | IN_DELETE | IN_MODIFY | IN_CLOSE_WRITE | IN_MOVED_FROM | IN_MOVED_TO
+        | IN_ATTRIB | IN_DELETE_SELF | IN_ONLYDIR | IN_EXCL_UNLINK;
+
+    bool OpenBackend() {
+        inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        stopFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (inotifyFd < 0 || stopFd < 0) return false;
+        return AddTree(std::string());
+    }
+
+    void CloseBackend() {
+        if (inotifyFd >= 0) ::close(inotifyFd);
+        if (stopFd >= 0) ::close(stopFd);
+        inotifyFd = stopFd = -1;
+        dirOf.clear(); wdOf.clear();
+    }
+
+    bool AddWatch(const std::string& rel) {
+        std::filesystem::path full = rel.empty() ? root : root / std::filesystem::u8path(rel);
+        int wd = inotify_add_watch(inotifyFd, full.c_str(), kMask);
+        if (wd < 0) return false;
+        dirOf[wd] = rel;
+        wdOf[rel] = wd;
+        return true;
+    }
+
+    /**
+     * Añade watches a `rel` y todas sus subcarpetas.
+     */
+    bool AddTree(const std::string& rel) {
+        if (!AddWatch(rel)) return false;
+        std::error_code ec;
+        std::filesystem::path full = rel.empty() ? root : root / std::filesystem::u8path(rel);
+        for (auto it = std::filesystem::recursive_directory_iterator(full, std::filesystem::directory_options::skip_permission_denied, ec);
+             !ec && it != std::filesystem::recursive_directory_iterator(); it.increment(ec)) {
+            if (it->is_directory(ec) && !it->is_symlink(ec)) AddWatch(it->path().lexically_relative(root).generic_u8string());
+        }
+        return true;
+    }
+
+    /**
+     * Olvida los watches de `rel` y de todo lo que cuelga de ella (carpeta movida o borrada).
+     */
+    void RemoveTree(const std::string& rel) {
+        std::string prefix = rel + "/";
+        for (auto it = wdOf.begin(); it != wdOf.end(); ) {
+            if (it->first == rel || it->first.compare(0, prefix.size(), prefix) == 0) {
+                inotify_rm_watch(inotifyFd, it->second);
+                dirOf.erase(it->second);
+                it = wdOf.erase(it);
+            } else ++it;
+        }
+    }
+
+    void Loop() {
+        alignas(inotify_event) char buffer[64 * 1024];
+        pollfd fds[2] = { { inotifyFd, POLLIN, 0 }, { stopFd, POLLIN, 0 } };
+        while (running) {
+            int r = ::poll(fds, 2, batch.empty() ? -1 : (int)settle.count());
+            if (r < 0) { if (errno == EINTR) continue; break; }
+            if (r == 0) { Deliver(); continue; }
+            if (fds[1].revents) break;
+            while (true) {
+                ssize_t n = ::read(inotifyFd, buffer, sizeof(buffer));
+                if (n <= 0) break;
+                for (char* p = buffer; p < buffer + n; ) {
+                    auto* ev = (inotify_event*)p;
+                    p += sizeof(inotify_event) + ev->len;
+                    Handle(*ev);
+                }
+            }
+        }
+        Deliver();
+    }
+
+    void Handle(const inotify_event& ev) {
+        if (ev.mask & IN_Q_OVERFLOW) { Push(Kind::Overflow, std::string(), false); return; }
+        auto dir = dirOf.find(ev.wd);
+        if (dir == dirOf.end()) return;
+        if (ev.mask & IN_IGNORED) { wdOf.erase(dir->second); dirOf.erase(dir); return; }
+        if (ev.len == 0) return; // Eventos sobre la propia carpeta (DELETE_SELF): llegan también por el padre
+        std::string path = Join(dir->second, ev.name);
+        bool isDir = (ev.mask & IN_ISDIR) != 0;
+        if (ev.mask & (IN_CREATE | IN_MOVED_TO)) {
+            if (isDir) AddTree(path);
+            Push(Kind::Added, path, isDir);
+        } else if (ev.mask & (IN_DELETE | IN_MOVED_FROM)) {
+            if (isDir) RemoveTree(path);
+            Push(Kind::Removed, path, isDir);
+        } else if (ev.mask & (IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB)) {
+            Push(Kind::Modified, path, isDir);
+        }
+    }
+#endif
+};
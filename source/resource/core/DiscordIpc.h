@@ -0,0 +1,550 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "Json.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+/**
+ * @namespace DiscordIpc
+ * @description Cliente del IPC local de Discord (Rich Presence).
+ * Cada mensaje va en un frame: opcode (u32 LE) + longitud (u32 LE) + JSON.
+ * El transporte es intercambiable: named pipe `\\.\pipe\discord-ipc-N` en Windows
+ * y socket Unix `discord-ipc-N` en Linux/macOS, así el cliente se puede probar sin Discord.
+ */
+namespace DiscordIpc {
+
+    enum Op : uint32_t { Handshake = 0, Frame = 1, Close = 2, Ping = 3, Pong = 4 };
+
+    enum class IoResult : uint8_t { Ok, Timeout, Closed };
+
+    constexpr uint32_t kMaxFrame = 64 * 1024;
+
+    /**
+     * @class Transport
+     * @description Canal de bytes hacia el cliente de Discord. Read/Write son bloqueantes y
+     * completos (todo o nada); Read respeta un plazo. Abort se puede llamar desde otro hilo
+     * para desbloquear una operación en curso.
+     */
+    class Transport {
+    public:
+        virtual ~Transport() = default;
+        virtual bool Connect() = 0;
+        virtual void Close() = 0;
+        virtual void Abort() = 0;
+        virtual bool IsOpen() const = 0;
+        virtual bool Write(const void* data, size_t n) = 0;
+        virtual IoResult Read(void* data, size_t n, int timeoutMs) = 0;
+    };
+
+#ifdef _WIN32
+    /**
+     * @class PipeTransport
+     * @description Named pipe en modo overlapped, para poder leer con plazo y cancelar.
+     */
+    class PipeTransport : public Transport {
+    public:
+        PipeTransport() { event = CreateEventW(NULL, TRUE, FALSE, NULL); }
+        ~PipeTransport() override { Close(); if (event) CloseHandle(event); }
+
+        bool Connect() override {
+            Close();
+            for (int i = 0; i < 10; i++) {
+                std::wstring name = L"\\\\.\\pipe\\discord-ipc-" + std::to_wstring(i);
+                HANDLE h = CreateFileW(name.c_str(), GENERIC_READ | GENERIC_WRITE, 0, NULL, OPEN_EXISTING, FILE_FLAG_OVERLAPPED, NULL);
+                if (h != INVALID_HANDLE_VALUE) { std::lock_guard<std::mutex> lock(handleMutex); pipe = h; return true; }
+            }
+            return false;
+        }
+
+        void Close() override {
+            std::lock_guard<std::mutex> lock(handleMutex);
+            if (pipe != INVALID_HANDLE_VALUE) { CloseHandle(pipe); pipe = INVALID_HANDLE_VALUE; }
+        }
+
+        void Abort() override {
+            std::lock_guard<std::mutex> lock(handleMutex);
+            if (pipe != INVALID_HANDLE_VALUE) CancelIoEx(pipe, NULL);
+        }
+
+        bool IsOpen() const override { return pipe != INVALID_HANDLE_VALUE; }
+
+        bool Write(const void* data, size_t n) override {
+            const char* p = (const char*)data;
+            while (n > 0) {
+                DWORD done = 0;
+                if (Transfer(false, (void*)p, (DWORD)std::min<size_t>(n, 1u << 20), done, INFINITE) != IoResult::Ok || done == 0) return false;
+                p += done; n -= done;
+            }
+            return true;
+        }
+
+        IoResult Read(void* data, size_t n, int timeoutMs) override {
+            char* p = (char*)data;
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+            while (n > 0) {
+                auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+                if (left < 0) return IoResult::Timeout;
+                DWORD done = 0;
+                IoResult r = Transfer(true, p, (DWORD)n, done, (DWORD)left);
+                if (r != IoResult::Ok) return r;
+                if (done == 0) return IoResult::Closed;
+                p += done; n -= done;
+            }
+            return IoResult::Ok;
+        }
+
+    private:
+        HANDLE pipe = INVALID_HANDLE_VALUE;
+        HANDLE event = NULL;
+        std::mutex handleMutex; // Close/Abort desde hilos distintos; Read/Write solo desde el dueño
+
+        IoResult Transfer(bool read, void* buf, DWORD n, DWORD& done, DWORD timeoutMs) {
+            if (pipe == INVALID_HANDLE_VALUE) return IoResult::Closed;
+            OVERLAPPED ov = {};
+            ov.hEvent = event;
+            ResetEvent(event);
+            BOOL ok = read ? ReadFile(pipe, buf, n, NULL, &ov) : WriteFile(pipe, buf, n, NULL, &ov);
+            if (!ok && GetLastError() != ERROR_IO_PENDING) return IoResult::Closed;
+            if (WaitForSingleObject(event, timeoutMs) == WAIT_TIMEOUT) {
+                CancelIoEx(pipe, &ov);
+                GetOverlappedResult(pipe, &ov, &done, TRUE);
+                return IoResult::Timeout;
+            }
+            return GetOverlappedResult(pipe, &ov, &done, FALSE) ? IoResult::Ok : IoResult::Closed;
+        }
+    };
+#else
+    /**
+     * @class SocketTransport
+     * @description Socket Unix. Busca `discord-ipc-0..9` en $XDG_RUNTIME_DIR, $TMPDIR, $TMP,
+     * $TEMP y /tmp, incluidas las subcarpetas que usan los paquetes Flatpak y Snap.
+     */
+    class SocketTransport : public Transport {
+    public:
+        ~SocketTransport() override { Close(); }
+
+        static std::vector<std::string> CandidatePaths() {
+            std::vector<std::string> dirs;
+            for (const char* var : { "XDG_RUNTIME_DIR", "TMPDIR", "TMP", "TEMP" }) {
+                const char* v = std::getenv(var);
+                if (v && *v && std::find(dirs.begin(), dirs.end(), v) == dirs.end()) dirs.push_back(v);
+            }
+            if (std::find(dirs.begin(), dirs.end(), "/tmp") == dirs.end()) dirs.push_back("/tmp");
+            std::vector<std::string> out;
+            for (int i = 0; i < 10; i++)
+                for (const auto& d : dirs)
+                    for (const char* sub : { "/", "/app/com.discordapp.Discord/", "/snap.discord/" })
+                        out.push_back(d + sub + "discord-ipc-" + std::to_string(i));
+            return out;
+        }
+
+        bool Connect() override {
+            Close();
+            for (const auto& path : CandidatePaths()) {
+                sockaddr_un addr = {};
+                if (path.size() >= sizeof(addr.sun_path)) continue;
+                addr.sun_family = AF_UNIX;
+                std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+                int s = ::socket(AF_UNIX, SOCK_STREAM, 0);
+                if (s < 0) return false;
+                ::fcntl(s, F_SETFD, FD_CLOEXEC);
+                if (::connect(s, (sockaddr*)&addr, sizeof(addr)) == 0) { std::lock_guard<std::mutex> lock(handleMutex); fd = s; return true; }
+                ::close(s);
+            }
+            return false;
+        }
+
+        void Close() override {
+            std::lock_guard<std::mutex> lock(handleMutex);
+            if (fd >= 0) { ::close(fd); fd = -1; }
+        }
+
+        void Abort() override {
+            std::lock_guard<std::mutex> lock(handleMutex);
+            if (fd >= 0) ::shutdown(fd, SHUT_RDWR);
+        }
+
+        bool IsOpen() const override { return fd >= 0; }
+
+        bool Write(const void* data, size_t n) override {
+            const char* p = (const char*)data;
+            while (n > 0) {
+#ifdef MSG_NOSIGNAL
+                ssize_t w = ::send(fd, p, n, MSG_NOSIGNAL);
+#else
+                ssize_t w = ::send(fd, p, n, 0);
+#endif
+                if (w < 0 && errno == EINTR) continue;
+                if (w <= 0) return false;
+                p += w; n -= (size_t)w;
+            }
+            return true;
+        }
+
+        IoResult Read(void* data, size_t n, int timeoutMs) override {
+            char* p = (char*)data;
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+            while (n > 0) {
+                auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+                if (left < 0) return IoResult::Timeout;
+                pollfd pfd = { fd, POLLIN, 0 };
+                int r = ::poll(&pfd, 1, (int)left);
+                if (r < 0 && errno == EINTR) continue;
+                if (r < 0) return IoResult::Closed;
+                if (r == 0) return IoResult::Timeout;
+                ssize_t got = ::recv(fd, p, n, 0);
+                if (got < 0 && errno == EINTR) continue;
+                if (got <= 0) return IoResult::Closed;
+                p += got; n -= (size_t)got;
+            }
+            return IoResult::Ok;
+        }
+
+    private:
+        int fd = -1;
+        std::mutex handleMutex; // Close/Abort desde hilos distintos; Read/Write solo desde el dueño
+    };
+#endif
+
+    inline std::unique_ptr<Transport> MakeDefaultTransport() {
+#ifdef _WIN32
+        return std::make_unique<PipeTransport>();
+#else
+        return std::make_unique<SocketTransport>();
+#endif
+    }
+
+    inline void AppendFrame(std::string& out, uint32_t op, std::string_view json) {
+        uint32_t len = (uint32_t)json.size();
+        for (int i = 0; i < 4; i++) out += (char)((op >> (8 * i)) & 0xFF);
+        for (int i = 0; i < 4; i++) out += (char)((len >> (8 * i)) & 0xFF);
+        out.append(json.data(), json.size());
+    }
+
+    inline bool WriteFrame(Transport& t, uint32_t op, std::string_view json) {
+        std::string buf;
+        buf.reserve(8 + json.size());
+        AppendFrame(buf, op, json);
+        return t.Write(buf.data(), buf.size());
+    }
+
+    /**
+     * Lee un frame completo. Solo devuelve Timeout si no llegó ni un byte de la cabecera;
+     * un frame cortado a medias o demasiado grande deja el canal inservible (Closed).
+     */
+    inline IoResult ReadFrame(Transport& t, uint32_t& op, std::string& json, int timeoutMs) {
+        unsigned char head[8];
+        IoResult r = t.Read(head, 1, timeoutMs);
+        if (r != IoResult::Ok) return r;
+        if (t.Read(head + 1, 7, timeoutMs) != IoResult::Ok) return IoResult::Closed;
+        op = head[0] | (head[1] << 8) | (head[2] << 16) | ((uint32_t)head[3] << 24);
+        uint32_t len = head[4] | (head[5] << 8) | (head[6] << 16) | ((uint32_t)head[7] << 24);
+        if (len > kMaxFrame) return IoResult::Closed;
+        json.resize(len);
+        if (len && t.Read(&json[0], len, timeoutMs) != IoResult::Ok) return IoResult::Closed;
+        return IoResult::Ok;
+    }
+
+    struct Activity {
+        std::string details, state, largeImage, largeText;
+
+        bool operator==(const Activity& o) const {
+            return details == o.details && state == o.state && largeImage == o.largeImage && largeText == o.largeText;
+        }
+        bool operator!=(const Activity& o) const { return !(*this == o); }
+    };
+
+    struct Button { std::string label, url; };
+
+    struct Options {
+        std::string clientId;
+        std::vector<Button> buttons;
+        int64_t startTime = 0;          // Epoch en segundos; 0 = sin marca de tiempo
+        uint32_t pid = 0;
+        int rateLimit = 5;              // SET_ACTIVITY permitidos por ventana
+        std::chrono::milliseconds rateWindow{20000};
+        std::chrono::milliseconds backoffMin{1000};
+        std::chrono::milliseconds backoffMax{60000};
+        int replyTimeoutMs = 5000;
+    };
+
+    struct Stats {
+        uint64_t wakeups = 0;       // Veces que el hilo salió de la espera
+        uint64_t sent = 0;          // SET_ACTIVITY enviados y confirmados
+        uint64_t coalesced = 0;     // Actualizaciones reemplazadas antes de enviarse
+        uint64_t unchanged = 0;     // SetActivity idénticos al último estado, ignorados
+        uint64_t connects = 0;
+        uint64_t failedConnects = 0;
+        uint64_t disconnects = 0;
+        uint64_t errors = 0;        // Respuestas con "evt":"ERROR"
+        uint64_t pings = 0;
+        double lastLatencyMs = 0;   // Desde el SetActivity hasta la confirmación de Discord
+        std::string lastError;
+    };
+
+    /**
+     * @class Client
+     * @description Hilo de Rich Presence dirigido por eventos. Duerme en una condition_variable
+     * hasta que hay algo que hacer; nunca consulta en bucle. SetActivity solo guarda el último
+     * estado: si el límite de Discord (5 cada 20 s) no deja enviar, las llamadas intermedias se
+     * funden y se manda el estado más reciente en cuanto se libera un hueco. Las caídas se
+     * reintentan con espera exponencial y al reconectar se reenvía el estado vigente.
+     */
+    class Client {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        Client(std::unique_ptr<Transport> transport, Options options)
+            : transport(std::move(transport)), options(std::move(options)) {
+            backoff = this->options.backoffMin;
+            BuildTemplate();
+        }
+
+        ~Client() { Stop(); }
+
+        void Start() {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (worker.joinable()) return;
+            stopping = false;
+            connectPending = true;
+            worker = std::thread(&Client::Loop, this);
+        }
+
+        void Stop() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!worker.joinable()) return;
+                stopping = true;
+            }
+            wake.notify_all();
+            transport->Abort();
+            worker.join();
+            transport->Close();
+        }
+
+        void SetActivity(Activity a) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!dirty && hasSent && a == lastSent) { stats.unchanged++; return; }
+                if (dirty) {
+                    if (a == pending) return;
+                    stats.coalesced++;
+                }
+                pending = std::move(a);
+                pendingSince = Clock::now();
+                dirty = true;
+            }
+            wake.notify_one();
+        }
+
+        Stats GetStats() const {
+            std::lock_guard<std::mutex> lock(mutex);
+            return stats;
+        }
+
+        bool IsConnected() const {
+            std::lock_guard<std::mutex> lock(mutex);
+            return connected;
+        }
+
+        /**
+         * JSON de SET_ACTIVITY. La parte fija (pid, botones, marca de inicio) se genera una vez.
+         */
+        std::string BuildPayload(const Activity& a, uint64_t nonce) const {
+            std::string out;
+            out.reserve(head.size() + tail.size() + a.details.size() + a.state.size() + a.largeImage.size() + a.largeText.size() + 96);
+            out += head;
+            out += "\"details\":"; Json::AppendString(out, a.details);
+            out += ",\"state\":"; Json::AppendString(out, a.state);
+            out += ",\"assets\":{\"large_image\":"; Json::AppendString(out, a.largeImage);
+            out += ",\"large_text\":"; Json::AppendString(out, a.largeText);
+            out += '}';
+            out += tail;
+            out += std::to_string(nonce);
+            out += "\"}";
+            return out;
+        }
+
+    private:
+        std::unique_ptr<Transport> transport;
+        Options options;
+        std::string head, tail;
+
+        mutable std::mutex mutex;
+        std::condition_variable wake;
+        std::thread worker;
+        bool stopping = false;
+        bool connectPending = false;
+        bool connected = false;
+        bool dirty = false;
+        bool hasSent = false;
+        Activity pending, lastSent;
+        Clock::time_point pendingSince;
+        Clock::time_point retryAt;
+        std::chrono::milliseconds backoff;
+        std::deque<Clock::time_point> sentAt;
+        uint64_t nonce = 0;
+        Stats stats;
+
+        void BuildTemplate() {
+            head = "{\"cmd\":\"SET_ACTIVITY\",\"args\":{\"pid\":" + std::to_string(options.pid) + ",\"activity\":{";
+            if (options.startTime > 0) tail += ",\"timestamps\":{\"start\":" + std::to_string(options.startTime) + "}";
+            if (!options.buttons.empty()) {
+                tail += ",\"buttons\":[";
+                for (size_t i = 0; i < options.buttons.size(); i++) {
+                    if (i) tail += ',';
+                    tail += "{\"label\":"; Json::AppendString(tail, options.buttons[i].label);
+                    tail += ",\"url\":"; Json::AppendString(tail, options.buttons[i].url);
+                    tail += '}';
+                }
+                tail += ']';
+            }
+            tail += "}},\"nonce\":\"";
+        }
+
+        template <typename Pred>
+        void Sleep(std::unique_lock<std::mutex>& lock, Clock::time_point until, Pred ready) {
+            if (until == Clock::time_point::max()) wake.wait(lock, ready);
+            else wake.wait_until(lock, until, ready);
+            stats.wakeups++;
+        }
+
+        void Loop() {
+            std::unique_lock<std::mutex> lock(mutex);
+            while (!stopping) {
+                if (!dirty && !connectPending) {
+                    Sleep(lock, Clock::time_point::max(), [&] { return stopping || dirty; });
+                    continue;
+                }
+                auto now = Clock::now();
+
+                if (!transport->IsOpen()) {
+                    if (!connectPending && now < retryAt) {
+                        Sleep(lock, retryAt, [&] { return stopping; });
+                        continue;
+                    }
+                    connectPending = false;
+                    lock.unlock();
+                    bool ok = OpenSession();
+                    lock.lock();
+                    if (!ok) {
+                        stats.failedConnects++;
+                        retryAt = Clock::now() + backoff;
+                        backoff = std::min(backoff * 2, options.backoffMax);
+                        continue;
+                    }
+                    stats.connects++;
+                    connected = true;
+                    backoff = options.backoffMin;
+                    continue;
+                }
+                connectPending = false;
+                if (!dirty) continue;
+
+                // Ventana deslizante: como mucho rateLimit envíos en rateWindow
+                while (!sentAt.empty() && now - sentAt.front() >= options.rateWindow) sentAt.pop_front();
+                if ((int)sentAt.size() >= options.rateLimit) {
+                    Sleep(lock, sentAt.front() + options.rateWindow, [&] { return stopping; });
+                    continue;
+                }
+
+                Activity a = pending;
+                auto since = pendingSince;
+                uint64_t id = ++nonce;
+                dirty = false;
+                sentAt.push_back(now);
+                std::string payload = BuildPayload(a, id);
+                lock.unlock();
+                std::string error;
+                bool ok = Exchange(payload, id, error);
+                lock.lock();
+                if (!ok) {
+                    // Se reintenta el último estado (este u otro más nuevo) tras reconectar
+                    if (!dirty) { pending = std::move(a); pendingSince = since; dirty = true; }
+                    transport->Close();
+                    connected = false;
+                    stats.disconnects++;
+                    retryAt = Clock::now() + backoff;
+                    backoff = std::min(backoff * 2, options.backoffMax);
+                    continue;
+                }
+                if (!error.empty()) { stats.errors++; stats.lastError = std::move(error); }
+                else stats.sent++;
+                lastSent = std::move(a);
+                hasSent = true;
+                stats.lastLatencyMs = std::chrono::duration<double, std::milli>(Clock::now() - since).count();
+            }
+            connected = false;
+        }
+
+        /**
+         * Lee frames hasta que llega la respuesta esperada. Contesta a los PING y corta con CLOSE.
+         * @returns {bool} false si el canal se cerró o no respondió a tiempo.
+         */
+        bool AwaitReply(std::string_view nonceOrEvt, bool byNonce, std::string& error) {
+            auto deadline = Clock::now() + std::chrono::milliseconds(options.replyTimeoutMs);
+            std::string json;
+            for (;;) {
+                int left = (int)std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now()).count();
+                if (left <= 0) return false;
+                uint32_t op = 0;
+                if (ReadFrame(*transport, op, json, left) != IoResult::Ok) return false;
+                if (op == Ping) {
+                    { std::lock_guard<std::mutex> lock(mutex); stats.pings++; }
+                    if (!WriteFrame(*transport, Pong, json)) return false;
+                    continue;
+                }
+                if (op == Close) {
+                    Json::Value v;
+                    if (Json::Parse(json, v)) error = v["message"].Str();
+                    return false;
+                }
+                if (op != Frame) continue;
+                Json::Value v;
+                if (!Json::Parse(json, v)) continue;
+                bool match = byNonce ? v["nonce"].Str() == nonceOrEvt : v["evt"].Str() == nonceOrEvt;
+                if (!match) continue;
+                if (v["evt"].Str() == "ERROR") error = v["data"]["message"].Str("error");
+                return true;
+            }
+        }
+
+        bool OpenSession() {
+            if (!transport->Connect()) return false;
+            std::string hello = "{\"v\":1,\"client_id\":";
+            Json::AppendString(hello, options.clientId);
+            hello += '}';
+            std::string error;
+            if (WriteFrame(*transport, Handshake, hello) && AwaitReply("READY", false, error)) return true;
+            transport->Close();
+            return false;
+        }
+
+        bool Exchange(const std::string& payload, uint64_t id, std::string& error) {
+            if (!WriteFrame(*transport, Frame, payload)) return false;
+            return AwaitReply(std::to_string(id), true, error);
+        }
+    };
+}
@@ -0,0 +1,151 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include "MappedFile.h"
+#include "Utf.h"
+
+/**
+ * @class Utf8ChunkReader
+ * @description Lee un archivo UTF-8 proyectado en bloques de tamaño acotado, sin partir
+ * secuencias multibyte, y devuelve cada bloque ya convertido a wchar_t.
+ * Las páginas ya entregadas se liberan, así que la memoria residente es ~ un bloque.
+ */
+class Utf8ChunkReader {
+public:
+    bool Open(const std::filesystem::path& path) {
+        offset = 0;
+        if (!file.Open(path)) return false;
+        file.AdviseSequential();
+        // Salta el BOM si lo hay
+        if (file.Size() >= 3 && (unsigned char)file.Data()[0] == 0xEF && (unsigned char)file.Data()[1] == 0xBB && (unsigned char)file.Data()[2] == 0xBF) offset = 3;
+        return true;
+    }
+
+    /**
+     * Convierte el siguiente bloque (como mucho `maxBytes` de origen) y lo añade a `out`.
+     * @returns {size_t} Bytes de origen consumidos (0 al llegar al final).
+     */
+    size_t Next(std::wstring& out, size_t maxBytes) {
+        size_t remaining = file.Size() - offset;
+        if (remaining == 0) return 0;
+        size_t take = remaining < maxBytes ? remaining : maxBytes;
+        if (take < remaining) {
+            size_t cut = Utf::CompletePrefix(file.Data() + offset, take);
+            if (cut > 0) take = cut;
+        }
+        Utf::AppendUtf8ToWide(out, file.Data() + offset, take);
+        file.Release(offset, take);
+        offset += take;
+        return take;
+    }
+
+    size_t Offset() const { return offset; }
+    size_t Size() const { return file.Size(); }
+    bool Done() const { return offset >= file.Size(); }
+
+private:
+    MappedFile file;
+    size_t offset = 0;
+};
+
+/**
+ * @class StreamRegistry
+ * @description Lecturas en streaming abiertas por la página. El control de flujo es por créditos:
+ * la página pide N bloques con Read() y no se produce nada más hasta que vuelve a pedir,
+ * así que como mucho hay N bloques en vuelo por stream.
+ */
+class StreamRegistry {
+public:
+    /**
+     * Recibe cada bloque producido: (streamId, bytes leídos hasta ahora, total, bloque, es el último).
+     * El bloque ya viene con la cabecera "<streamId>|" delante del texto, listo para enviarse.
+     */
+    using EmitFn = std::function<void(uint32_t id, size_t done, size_t total, std::wstring&& chunk, bool last)>;
+
+    static constexpr size_t kDefaultChunk = 256 * 1024;
+    static constexpr size_t kMinChunk = 4 * 1024;
+    static constexpr size_t kMaxChunk = 8 * 1024 * 1024;
+
+    /**
+     * Abre un stream.
+     * @returns {uint32_t} Id del stream, 0 si el archivo no se pudo abrir.
+     */
+    uint32_t Open(const std::filesystem::path& path, size_t chunkBytes, size_t& totalBytes) {
+        auto s = std::make_shared<Session>();
+        if (!s->reader.Open(path)) return 0;
+        if (chunkBytes == 0) chunkBytes = kDefaultChunk;
+        s->chunk = chunkBytes < kMinChunk ? kMinChunk : (chunkBytes > kMaxChunk ? kMaxChunk : chunkBytes);
+        totalBytes = s->reader.Size();
+        std::lock_guard<std::mutex> lock(mtx);
+        uint32_t id = nextId++;
+        if (nextId == 0) nextId = 1;
+        sessions[id] = s;
+        return id;
+    }
+
+    /**
+     * Produce hasta `credits` bloques. El stream se cierra solo tras emitir el último.
+     * Seguro desde varios hilos: las lecturas de un mismo stream se serializan, y un Close
+     * durante un Read corta la entrega tras el bloque en curso.
+     * @returns {bool} false si el stream no existe.
+     */
+    bool Read(uint32_t id, size_t credits, const EmitFn& emit) {
+        std::shared_ptr<Session> s = Find(id);
+        if (!s) return false;
+        std::lock_guard<std::mutex> lock(s->mtx);
+        for (size_t i = 0; i < credits && !s->closed.load(std::memory_order_acquire); i++) {
+            std::wstring chunk;
+            chunk.reserve(s->chunk + 12);
+            chunk += std::to_wstring(id); chunk += L'|';
+            s->reader.Next(chunk, s->chunk);
+            bool last = s->reader.Done();
+            if (last) Close(id);
+            emit(id, s->reader.Offset(), s->reader.Size(), std::move(chunk), last);
+        }
+        return true;
+    }
+
+    void Close(uint32_t id) {
+        std::lock_guard<std::mutex> lock(mtx);
+        auto it = sessions.find(id);
+        if (it == sessions.end()) return;
+        it->second->closed.store(true, std::memory_order_release);
+        sessions.erase(it);
+    }
+
+    void CloseAll() {
+        std::lock_guard<std::mutex> lock(mtx);
+        for (auto& [id, s] : sessions) s->closed.store(true, std::memory_order_release);
+        sessions.clear();
+    }
+
+    size_t OpenCount() {
+        std::lock_guard<std::mutex> lock(mtx);
+        return sessions.size();
+    }
+
+private:
+    struct Session {
+        std::mutex mtx;
+        Utf8ChunkReader reader;
+        size_t chunk = kDefaultChunk;
+        std::atomic<bool> closed{false};
+    };
+
+    std::mutex mtx;
+    std::unordered_map<uint32_t, std::shared_ptr<Session>> sessions;
+    uint32_t nextId = 1;
+
+    std::shared_ptr<Session> Find(uint32_t id) {
+        std::lock_guard<std::mutex> lock(mtx);
+        auto it = sessions.find(id);
+        return it == sessions.end() ? nullptr : it->second;
+    }
+};
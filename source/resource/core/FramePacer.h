@@ -0,0 +1,126 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+/**
+ * @class FramePacer
+ * @description Frecuencia del bucle de Phaser. Los frames los sigue dando requestAnimationFrame
+ * en la página; aquí se decide a cuántos por segundo se limitan y se avisa de cada cambio.
+ *
+ * - Frecuencia efectiva: minimizada > reposo > escena actual > base (fpsLimit). 0 = en pausa.
+ * - `Gate` es el limitador que aplica la página dentro de requestAnimationFrame
+ *   (createFrameGate en funkin/API/genesis.js hace exactamente lo mismo); está aquí para poder
+ *   comprobarlo con tiempos sintéticos en pacebench.
+ *
+ * Solo desde el hilo de UI (los handlers del puente y WM_SIZE).
+ */
+class FramePacer {
+public:
+    /** Nueva frecuencia efectiva (Hz, 0 = en pausa). */
+    using ChangeFn = std::function<void(double hz)>;
+
+    /**
+     * @class Gate
+     * @description Deja pasar los frames de requestAnimationFrame que tocan a `hz`. Plazos
+     * absolutos (inicio + n * periodo) con una tolerancia de medio refresco: a 60 Hz en una
+     * pantalla de 60 Hz no se salta ninguno por el jitter del vsync, y a 60 Hz en una de 144 Hz
+     * salen 60 de media, cada uno alineado con un refresco. Si se queda atrás más de un periodo
+     * (pestaña oculta, parón), vuelve a contar desde el frame actual en vez de recuperar de golpe.
+     */
+    class Gate {
+    public:
+        struct Stats {
+            uint64_t frames = 0;                 // Frames que pasaron
+            uint64_t skipped = 0;                // Frames de requestAnimationFrame descartados
+            double refreshMs = 1000.0 / 60;      // Intervalo del vsync estimado
+        };
+
+        /** hz <= 0 = en pausa (no pasa ninguno). */
+        void SetRate(double hz) {
+            paused = hz <= 0;
+            rate = std::max(0.0, hz);
+            next = 0;
+        }
+
+        /**
+         * @param {double} timeMs Marca de tiempo del frame de requestAnimationFrame.
+         * @returns {bool} true si el bucle de Phaser avanza en este frame.
+         */
+        bool Admit(double timeMs) {
+            if (lastRaf > 0) {
+                double raw = timeMs - lastRaf;
+                if (raw > 0 && raw < 250) stats.refreshMs += (raw - stats.refreshMs) / 16;
+            }
+            lastRaf = timeMs;
+            if (paused) { stats.skipped++; return false; }
+            if (rate > 0) {
+                double period = 1000.0 / rate;
+                if (timeMs < next - stats.refreshMs / 2) { stats.skipped++; return false; }
+                next = timeMs - next > period ? timeMs + period : next + period;
+            }
+            stats.frames++;
+            return true;
+        }
+
+        const Stats& GetStats() const { return stats; }
+
+    private:
+        double rate = 0;                         // 0 = sin límite
+        bool paused = false;
+        double next = 0;
+        double lastRaf = 0;
+        Stats stats;
+    };
+
+    /** Se llama cada vez que cambia la frecuencia efectiva. */
+    void SetOnChange(ChangeFn fn) { onChange = std::move(fn); }
+
+    /** Frecuencia base (fpsLimit). */
+    void SetRate(double hz) { Change([&] { baseHz = Clamp(hz); }); }
+
+    /** Frecuencia propia de una escena; hz <= 0 la quita. */
+    void SetSceneRate(const std::string& scene, double hz) {
+        Change([&] { if (hz > 0) sceneHz[scene] = Clamp(hz); else sceneHz.erase(scene); });
+    }
+
+    /** Escena que se está mostrando (la de arriba). */
+    void SetScene(const std::string& scene) { Change([&] { currentScene = scene; }); }
+
+    /** Tope en reposo (sin entrada del usuario); 0 = sin tope. */
+    void SetIdleRate(double hz) { Change([&] { idleHz = hz > 0 ? Clamp(hz) : 0; }); }
+    void SetIdle(bool on) { Change([&] { idle = on; }); }
+
+    /** Frecuencia con la ventana minimizada; 0 = en pausa. */
+    void SetMinimizedRate(double hz) { Change([&] { minimizedHz = hz > 0 ? Clamp(hz) : 0; }); }
+    void SetMinimized(bool on) { Change([&] { minimized = on; }); }
+
+    double Rate() const {
+        if (minimized) return minimizedHz;
+        auto it = sceneHz.find(currentScene);
+        double hz = it != sceneHz.end() ? it->second : baseHz;
+        if (idle && idleHz > 0) hz = std::min(hz, idleHz);
+        return hz;
+    }
+
+private:
+    ChangeFn onChange;
+    double baseHz = 60, idleHz = 0, minimizedHz = 0;
+    std::map<std::string, double> sceneHz;
+    std::string currentScene;
+    bool idle = false, minimized = false;
+
+    static double Clamp(double hz) { return std::min(1000.0, std::max(1.0, hz)); }
+
+    template <typename F>
+    void Change(F&& f) {
+        double before = Rate();
+        f();
+        double after = Rate();
+        if (after != before && onChange) onChange(after);
+    }
+};
@@ -0,0 +1,95 @@
+#pragma once
+#include <string>
+#include <string_view>
+
+/**
+ * @namespace Glob
+ * @description Patrones estilo shell sobre rutas con '/':
+ *   *      cualquier cosa dentro de un componente
+ *   **     cualquier cosa, cruzando '/' ("**\/" también acepta cero carpetas)
+ *   ?      un carácter (no '/')
+ *   [abc]  [a-z] [!0-9]  clases de caracteres
+ *   {a,b}  alternativas (sin anidar)
+ */
+namespace Glob {
+
+    namespace Detail {
+        inline bool MatchClass(std::string_view p, size_t& i, char c) {
+            // p[i] == '['
+            size_t j = i + 1;
+            bool negate = j < p.size() && (p[j] == '!' || p[j] == '^');
+            if (negate) j++;
+            bool found = false, first = true;
+            for (; j < p.size() && (p[j] != ']' || first); j++, first = false) {
+                if (j + 2 < p.size() && p[j + 1] == '-' && p[j + 2] != ']') {
+                    if (c >= p[j] && c <= p[j + 2]) found = true;
+                    j += 2;
+                } else if (p[j] == c) found = true;
+            }
+            if (j >= p.size()) { i = p.size(); return false; } // Clase sin cerrar: no coincide
+            i = j + 1;
+            return found != negate;
+        }
+
+        inline bool Match(std::string_view p, std::string_view s) {
+            size_t pi = 0, si = 0;
+            while (pi < p.size()) {
+                char pc = p[pi];
+                if (pc == '*') {
+                    bool dbl = pi + 1 < p.size() && p[pi + 1] == '*';
+                    size_t after = pi + (dbl ? 2 : 1);
+                    while (after < p.size() && p[after] == '*') after++;
+                    std::string_view rest = p.substr(after);
+                    if (dbl) {
+                        // "**/" también cubre cero carpetas
+                        if (!rest.empty() && rest[0] == '/' && Match(rest.substr(1), s.substr(si))) return true;
+                        for (size_t k = si; k <= s.size(); k++) if (Match(rest, s.substr(k))) return true;
+                        return false;
+                    }
+                    for (size_t k = si; ; k++) {
+                        if (Match(rest, s.substr(k))) return true;
+                        if (k == s.size() || s[k] == '/') return false;
+                    }
+                }
+                if (pc == '{') {
+                    size_t close = p.find('}', pi);
+                    if (close != std::string_view::npos) {
+                        std::string_view rest = p.substr(close + 1);
+                        for (size_t start = pi + 1; ; ) {
+                            size_t comma = p.find(',', start);
+                            if (comma == std::string_view::npos || comma > close) comma = close;
+                            std::string alt(p.substr(start, comma - start));
+                            alt.append(rest);
+                            if (Match(alt, s.substr(si))) return true;
+                            if (comma == close) return false;
+                            start = comma + 1;
+                        }
+                    }
+                }
+                if (si >= s.size()) return false;
+                if (pc == '?') { if (s[si] == '/') return false; pi++; }
+                else if (pc == '[') { if (s[si] == '/' || !MatchClass(p, pi, s[si])) return false; }
+                else { if (pc != s[si]) return false; pi++; }
+                si++;
+            }
+            return si == s.size();
+        }
+    }
+
+    /**
+     * @returns {bool} Si `path` coincide con `pattern` completo. Patrón vacío = todo.
+     */
+    inline bool Match(std::string_view pattern, std::string_view path) {
+        return pattern.empty() || Detail::Match(pattern, path);
+    }
+
+    /**
+     * Un patrón sin '/' se compara solo con el nombre; con '/', con la ruta relativa entera.
+     */
+    inline bool MatchEntry(std::string_view pattern, std::string_view relPath) {
+        if (pattern.empty()) return true;
+        if (pattern.find('/') != std::string_view::npos) return Detail::Match(pattern, relPath);
+        size_t slash = relPath.rfind('/');
+        return Detail::Match(pattern, slash == std::string_view::npos ? relPath : relPath.substr(slash + 1));
+    }
+}
@@ -0,0 +1,323 @@
+#pragma once
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/**
+ * @namespace Http
+ * @description Piezas de HTTP/1.1 que comparten el host de WebView2 (AssetHost) y el servidor de
+ * desarrollo (HttpServer): tabla MIME, Range, rutas de la URL, fechas, ETag y el parser de
+ * peticiones. Sin E/S: todo trabaja sobre cadenas.
+ */
+namespace Http {
+
+    /**
+     * Content-Type por extensión (la de server.js más lo que sirve AssetHost).
+     */
+    inline const char* MimeOf(std::string_view path) {
+        size_t dot = path.rfind('.');
+        size_t slash = path.find_last_of("/\\");
+        if (dot == std::string_view::npos || (slash != std::string_view::npos && dot < slash)) return "application/octet-stream";
+        std::string ext(path.substr(dot));
+        for (auto& c : ext) c = (char)std::tolower((unsigned char)c);
+        static const std::pair<const char*, const char*> kTable[] = {
+            { ".html", "text/html; charset=utf-8" },
+            { ".js", "text/javascript; charset=utf-8" },
+            { ".mjs", "text/javascript; charset=utf-8" },
+            { ".css", "text/css; charset=utf-8" },
+            { ".json", "application/json" },
+            { ".xml", "application/xml" },
+            { ".txt", "text/plain; charset=utf-8" },
+            { ".png", "image/png" },
+            { ".jpg", "image/jpeg" },
+            { ".jpeg", "image/jpeg" },
+            { ".webp", "image/webp" },
+            { ".gif", "image/gif" },
+            { ".svg", "image/svg+xml" },
+            { ".ico", "image/x-icon" },
+            { ".ktx2", "image/ktx2" },
+            { ".ogg", "audio/ogg" },
+            { ".mp3", "audio/mpeg" },
+            { ".wav", "audio/wav" },
+            { ".mp4", "video/mp4" },
+            { ".webm", "video/webm" },
+            { ".ttf", "font/ttf" },
+            { ".otf", "font/otf" },
+            { ".woff", "font/woff" },
+            { ".woff2", "font/woff2" },
+            { ".eot", "application/vnd.ms-fontobject" },
+            { ".wasm", "application/wasm" },
+        };
+        for (const auto& m : kTable) if (ext == m.first) return m.second;
+        return "application/octet-stream";
+    }
+
+    enum class Range { Full, Partial, Unsatisfiable };
+
+    /**
+     * Interpreta "bytes=a-b" / "bytes=a-" / "bytes=-n" (un solo rango).
+     * @returns {Range} Full si no hay Range o no se entiende (se responde el archivo entero),
+     * Unsatisfiable si empieza fuera del archivo (416).
+     */
+    inline Range ParseRange(std::string_view header, uint64_t size, uint64_t& first, uint64_t& last) {
+        if (header.compare(0, 6, "bytes=") != 0 || header.find(',') != std::string_view::npos) return Range::Full;
+        size_t dash = header.find('-', 6);
+        if (dash == std::string_view::npos) return Range::Full;
+        auto number = [](std::string_view s, uint64_t& v) {
+            if (s.empty() || s.size() > 19) return false;
+            v = 0;
+            for (char c : s) {
+                if (c < '0' || c > '9') return false;
+                v = v * 10 + (uint64_t)(c - '0');
+            }
+            return true;
+        };
+        std::string_view a = header.substr(6, dash - 6), b = header.substr(dash + 1);
+        if (a.empty()) {
+            uint64_t n;
+            if (!number(b, n)) return Range::Full;
+            if (n == 0 || size == 0) return Range::Unsatisfiable;
+            first = n >= size ? 0 : size - n; last = size - 1;
+            return Range::Partial;
+        }
+        if (!number(a, first)) return Range::Full;
+        if (b.empty()) last = UINT64_MAX;
+        else if (!number(b, last)) return Range::Full;
+        if (last < first) return Range::Full;
+        if (first >= size) return Range::Unsatisfiable;
+        if (last >= size) last = size - 1;
+        return Range::Partial;
+    }
+
+    /**
+     * "/public/a%20b.png?v=2" -> "public/a b.png". Una ruta vacía o que acaba en '/' sirve su
+     * index.html. La ruta resultante todavía hay que pasarla por Paths::ResolveUnder.
+     * @returns {bool} false si el %XX está mal o decodifica un byte nulo.
+     */
+    inline bool DecodeTarget(std::string_view target, std::string& out) {
+        size_t cut = target.find_first_of("?#");
+        if (cut != std::string_view::npos) target = target.substr(0, cut);
+        while (!target.empty() && target.front() == '/') target.remove_prefix(1);
+        out.clear();
+        out.reserve(target.size() + 10);
+        for (size_t i = 0; i < target.size(); i++) {
+            char c = target[i];
+            if (c == '%') {
+                if (i + 2 >= target.size() || !std::isxdigit((unsigned char)target[i + 1]) || !std::isxdigit((unsigned char)target[i + 2])) return false;
+                char hex[3] = { target[i + 1], target[i + 2], 0 };
+                c = (char)std::strtol(hex, nullptr, 16);
+                i += 2;
+            }
+            if (c == '\0') return false;
+            out += c;
+        }
+        if (out.empty() || out.back() == '/') out += "index.html";
+        return true;
+    }
+
+    namespace Detail {
+        /** Días desde 1970-01-01 (algoritmo days_from_civil de H. Hinnant). */
+        inline int64_t DaysFromCivil(int64_t y, unsigned m, unsigned d) {
+            y -= m <= 2;
+            int64_t era = (y >= 0 ? y : y - 399) / 400;
+            unsigned yoe = (unsigned)(y - era * 400);
+            unsigned doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+            unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+            return era * 146097 + (int64_t)doe - 719468;
+        }
+
+        static const char* const kDays[7] = { "Thu", "Fri", "Sat", "Sun", "Mon", "Tue", "Wed" };
+        static const char* const kMonths[12] = { "Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec" };
+    }
+
+    /**
+     * Fecha HTTP (IMF-fixdate): "Sun, 06 Nov 1994 08:49:37 GMT".
+     */
+    inline std::string FormatDate(int64_t unixSeconds) {
+        int64_t days = unixSeconds >= 0 ? unixSeconds / 86400 : (unixSeconds - 86399) / 86400;
+        int64_t secs = unixSeconds - days * 86400;
+        // civil_from_days
+        int64_t z = days + 719468;
+        int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+        unsigned doe = (unsigned)(z - era * 146097);
+        unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+        unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+        unsigned mp = (5 * doy + 2) / 153;
+        unsigned d = doy - (153 * mp + 2) / 5 + 1;
+        unsigned m = mp < 10 ? mp + 3 : mp - 9;
+        int64_t y = (int64_t)yoe + era * 400 + (m <= 2);
+        char buf[40];
+        std::snprintf(buf, sizeof(buf), "%s, %02u %s %04lld %02d:%02d:%02d GMT", Detail::kDays[((days % 7) + 7) % 7], d, Detail::kMonths[m - 1],
+            (long long)y, (int)(secs / 3600), (int)(secs / 60 % 60), (int)(secs % 60));
+        return buf;
+    }
+
+    /**
+     * Lee una fecha IMF-fixdate (la única que generan los navegadores en If-Modified-Since).
+     */
+    inline bool ParseDate(std::string_view s, int64_t& out) {
+        // "Sun, 06 Nov 1994 08:49:37 GMT"
+        if (s.size() != 29 || s[3] != ',' || s.substr(26) != "GMT") return false;
+        auto num = [&](size_t at, size_t n, int& v) {
+            v = 0;
+            for (size_t i = 0; i < n; i++) {
+                char c = s[at + i];
+                if (c < '0' || c > '9') return false;
+                v = v * 10 + (c - '0');
+            }
+            return true;
+        };
+        int d, y, hh, mm, ss;
+        if (!num(5, 2, d) || !num(12, 4, y) || !num(17, 2, hh) || !num(20, 2, mm) || !num(23, 2, ss)) return false;
+        unsigned m = 0;
+        for (unsigned i = 0; i < 12; i++) if (s.substr(8, 3) == Detail::kMonths[i]) m = i + 1;
+        if (!m || d < 1 || d > 31 || hh > 23 || mm > 59 || ss > 60) return false;
+        out = Detail::DaysFromCivil(y, m, (unsigned)d) * 86400 + hh * 3600 + mm * 60 + ss;
+        return true;
+    }
+
+    /**
+     * Comparación débil de If-None-Match ("*", lista separada por comas, prefijos W/).
+     */
+    inline bool EtagMatches(std::string_view header, std::string_view etag) {
+        auto strip = [](std::string_view t) {
+            if (t.size() >= 2 && t[0] == 'W' && t[1] == '/') t.remove_prefix(2);
+            return t;
+        };
+        etag = strip(etag);
+        size_t at = 0;
+        while (at < header.size()) {
+            size_t comma = header.find(',', at);
+            std::string_view item = header.substr(at, comma == std::string_view::npos ? std::string_view::npos : comma - at);
+            while (!item.empty() && (item.front() == ' ' || item.front() == '\t')) item.remove_prefix(1);
+            while (!item.empty() && (item.back() == ' ' || item.back() == '\t')) item.remove_suffix(1);
+            if (item == "*" || strip(item) == etag) return true;
+            if (comma == std::string_view::npos) break;
+            at = comma + 1;
+        }
+        return false;
+    }
+
+    /**
+     * Si Accept-Encoding admite `coding` ("br", "gzip"): aparece y no con q=0.
+     */
+    inline bool AcceptsEncoding(std::string_view header, std::string_view coding) {
+        size_t at = 0;
+        while (at < header.size()) {
+            size_t comma = header.find(',', at);
+            std::string_view item = header.substr(at, comma == std::string_view::npos ? std::string_view::npos : comma - at);
+            while (!item.empty() && item.front() == ' ') item.remove_prefix(1);
+            size_t semi = item.find(';');
+            std::string_view name = item.substr(0, semi);
+            while (!name.empty() && name.back() == ' ') name.remove_suffix(1);
+            if (name == coding || name == "*") {
+                if (semi == std::string_view::npos) return true;
+                std::string_view q = item.substr(semi + 1);
+                while (!q.empty() && q.front() == ' ') q.remove_prefix(1);
+                if (q.compare(0, 2, "q=") != 0) return true;
+                return std::strtod(std::string(q.substr(2)).c_str(), nullptr) > 0.0;
+            }
+            if (comma == std::string_view::npos) break;
+            at = comma + 1;
+        }
+        return false;
+    }
+
+    inline const char* Reason(int status) {
+        switch (status) {
+        case 200: return "OK";
+        case 206: return "Partial Content";
+        case 301: return "Moved Permanently";
+        case 304: return "Not Modified";
+        case 400: return "Bad Request";
+        case 403: return "Forbidden";
+        case 404: return "Not Found";
+        case 405: return "Method Not Allowed";
+        case 416: return "Range Not Satisfiable";
+        case 431: return "Request Header Fields Too Large";
+        case 500: return "Internal Server Error";
+        case 505: return "HTTP Version Not Supported";
+        default: return "Unknown";
+        }
+    }
+
+    /** Petición parseada. Las vistas apuntan al buffer de entrada. */
+    struct Request {
+        std::string_view method, target;
+        int minor = 1;                       // HTTP/1.<minor>
+        std::vector<std::pair<std::string_view, std::string_view>> headers;
+        size_t length = 0;                   // Bytes consumidos (línea + cabeceras)
+
+        /** Cabecera por nombre, sin distinguir mayúsculas. Vacía si no está. */
+        std::string_view Header(std::string_view name) const {
+            for (const auto& h : headers) {
+                if (h.first.size() != name.size()) continue;
+                bool eq = true;
+                for (size_t i = 0; i < name.size() && eq; i++) eq = std::tolower((unsigned char)h.first[i]) == std::tolower((unsigned char)name[i]);
+                if (eq) return h.second;
+            }
+            return {};
+        }
+
+        /** HTTP/1.1 mantiene la conexión salvo "Connection: close"; 1.0 solo con "keep-alive". */
+        bool KeepAlive() const {
+            std::string v(Header("Connection"));
+            for (auto& c : v) c = (char)std::tolower((unsigned char)c);
+            if (minor >= 1) return v.find("close") == std::string::npos;
+            return v.find("keep-alive") != std::string::npos;
+        }
+    };
+
+    enum class Parse { Incomplete, Ok, Bad, TooLarge, BadVersion };
+
+    /**
+     * Parsea línea de petición + cabeceras de `data`. Los cuerpos no se admiten (solo GET/HEAD
+     * llegan al servidor): una petición con Content-Length > 0 o chunked es Bad.
+     * @param {size_t} maxHeader - Tamaño máximo de línea + cabeceras.
+     */
+    inline Parse ParseRequest(const char* data, size_t size, Request& out, size_t maxHeader = 16384) {
+        std::string_view in(data, size);
+        // Líneas vacías sueltas entre peticiones (RFC 9112 2.2)
+        size_t start = 0;
+        while (start + 1 < in.size() && in[start] == '\r' && in[start + 1] == '\n') start += 2;
+        size_t end = in.find("\r\n\r\n", start);
+        if (end == std::string_view::npos) return in.size() - start > maxHeader ? Parse::TooLarge : Parse::Incomplete;
+        if (end - start > maxHeader) return Parse::TooLarge;
+
+        std::string_view head = in.substr(start, end - start);
+        size_t eol = head.find("\r\n");
+        std::string_view line = head.substr(0, eol);
+        size_t sp1 = line.find(' '), sp2 = line.rfind(' ');
+        if (sp1 == std::string_view::npos || sp2 == sp1) return Parse::Bad;
+        out.method = line.substr(0, sp1);
+        out.target = line.substr(sp1 + 1, sp2 - sp1 - 1);
+        std::string_view version = line.substr(sp2 + 1);
+        if (out.method.empty() || out.target.empty() || version.size() != 8 || version.compare(0, 5, "HTTP/") != 0) return Parse::Bad;
+        if (version[5] != '1' || version[6] != '.' || (version[7] != '0' && version[7] != '1')) return Parse::BadVersion;
+        out.minor = version[7] - '0';
+
+        out.headers.clear();
+        size_t at = eol == std::string_view::npos ? head.size() : eol + 2;
+        while (at < head.size()) {
+            size_t next = head.find("\r\n", at);
+            if (next == std::string_view::npos) next = head.size();
+            std::string_view h = head.substr(at, next - at);
+            size_t colon = h.find(':');
+            if (colon == std::string_view::npos || colon == 0 || h[0] == ' ' || h[0] == '\t') return Parse::Bad;
+            std::string_view value = h.substr(colon + 1);
+            while (!value.empty() && (value.front() == ' ' || value.front() == '\t')) value.remove_prefix(1);
+            while (!value.empty() && (value.back() == ' ' || value.back() == '\t')) value.remove_suffix(1);
+            out.headers.emplace_back(h.substr(0, colon), value);
+            at = next + 2;
+        }
+        std::string_view cl = out.Header("Content-Length");
+        if ((!cl.empty() && cl != "0") || !out.Header("Transfer-Encoding").empty()) return Parse::Bad;
+        out.length = end + 4;
+        return Parse::Ok;
+    }
+}
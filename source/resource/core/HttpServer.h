@@ -0,0 +1,490 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "Http.h"
+#include "Paths.h"
+
+#if defined(__linux__)
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * @class HttpServer
+ * @description Servidor de archivos estáticos para desarrollo en Linux (sustituye a server.js /
+ * `python -m http.server`). Un hilo por núcleo, cada uno con su epoll y su socket de escucha
+ * (SO_REUSEPORT: el kernel reparte las conexiones). Las cabeceras van con send y el cuerpo con
+ * sendfile, sin copiar el archivo a memoria.
+ *
+ * - Keep-alive y peticiones encadenadas (pipelining) sobre la misma conexión.
+ * - Range de un trozo (206 / 416) e If-Range: el audio de public/songs se busca sin bajarlo entero.
+ * - ETag (mtime + tamaño) y Last-Modified; If-None-Match / If-Modified-Since responden 304.
+ *   Cache-Control: no-cache, así que cada recarga revalida pero no vuelve a bajar nada.
+ * - Si el navegador lo acepta y existe `archivo.br` / `archivo.gz` no más antiguo que el
+ *   original, se sirve ese con Content-Encoding (no con Range: el rango es del original).
+ * - Rutas con Http::DecodeTarget + Paths::ResolveUnder, igual que AssetHost.
+ */
+class HttpServer {
+public:
+    struct Options {
+        std::filesystem::path root = ".";
+        std::string host = "127.0.0.1";
+        uint16_t port = 8080;            // 0 = uno libre (ver Port())
+        size_t threads = 0;              // 0 = núcleos disponibles
+        int idleSeconds = 15;            // Conexiones sin actividad se cierran
+        size_t maxHeader = 16384;
+        bool log = false;                // Una línea por petición en stdout
+    };
+
+    struct Stats {
+        uint64_t connections = 0, requests = 0, bytes = 0;
+        uint64_t notModified = 0, partial = 0, precompressed = 0, errors = 0;
+    };
+
+    HttpServer() = default;
+    ~HttpServer() { Stop(); }
+
+    HttpServer(const HttpServer&) = delete;
+    HttpServer& operator=(const HttpServer&) = delete;
+
+    /**
+     * Abre los sockets y arranca los hilos.
+     * @returns {bool} false si no se puede escuchar en host:port.
+     */
+    bool Start(const Options& options, std::string* err = nullptr) {
+        Stop();
+        opt = options;
+        port = opt.port;
+        size_t n = opt.threads ? opt.threads : std::max(1u, std::thread::hardware_concurrency());
+        auto fail = [&](const std::string& what) {
+            if (err) *err = what + ": " + std::strerror(errno);
+            Stop();
+            return false;
+        };
+        for (size_t i = 0; i < n; i++) {
+            workers.push_back(std::make_unique<Worker>());
+            Worker* w = workers.back().get();
+            w->listenFd = Listen(opt.host, port);
+            if (w->listenFd < 0) return fail("listen " + opt.host + ":" + std::to_string(port));
+            if (port == 0) {
+                sockaddr_in addr{};
+                socklen_t len = sizeof(addr);
+                getsockname(w->listenFd, (sockaddr*)&addr, &len);
+                port = ntohs(addr.sin_port);
+            }
+            w->epfd = epoll_create1(EPOLL_CLOEXEC);
+            w->wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+            if (w->epfd < 0 || w->wakeFd < 0) return fail("epoll");
+            Watch(w->epfd, w->listenFd, EPOLLIN, EPOLL_CTL_ADD);
+            Watch(w->epfd, w->wakeFd, EPOLLIN, EPOLL_CTL_ADD);
+        }
+        for (auto& w : workers) w->thread = std::thread(&HttpServer::Loop, this, w.get());
+        return true;
+    }
+
+    /** Puerto en el que escucha (el elegido por el sistema si se pidió 0). */
+    uint16_t Port() const { return port; }
+
+    void Stop() {
+        for (auto& w : workers) {
+            uint64_t one = 1;
+            if (w->wakeFd >= 0 && ::write(w->wakeFd, &one, sizeof(one)) < 0) {}
+        }
+        for (auto& w : workers) {
+            if (w->thread.joinable()) w->thread.join();
+            for (auto& c : w->conns) CloseFile(*c.second), ::close(c.first);
+            w->conns.clear();
+            for (int fd : { w->listenFd, w->epfd, w->wakeFd }) if (fd >= 0) ::close(fd);
+        }
+        workers.clear();
+        port = opt.port;
+    }
+
+    Stats GetStats() const {
+        Stats s;
+        s.connections = counters.connections.load(std::memory_order_relaxed);
+        s.requests = counters.requests.load(std::memory_order_relaxed);
+        s.bytes = counters.bytes.load(std::memory_order_relaxed);
+        s.notModified = counters.notModified.load(std::memory_order_relaxed);
+        s.partial = counters.partial.load(std::memory_order_relaxed);
+        s.precompressed = counters.precompressed.load(std::memory_order_relaxed);
+        s.errors = counters.errors.load(std::memory_order_relaxed);
+        return s;
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Connection {
+        std::string in;                  // Lo recibido y aún no procesado (desde inPos)
+        size_t inPos = 0;
+        std::string out;                 // Cabeceras (o respuesta corta) pendientes de enviar
+        size_t outPos = 0;
+        int file = -1;                   // Cuerpo pendiente: sendfile desde fileOffset
+        off_t fileOffset = 0;
+        uint64_t fileLeft = 0;
+        bool closeAfter = false;         // No se atienden más peticiones (Connection: close, error)
+        bool peerClosed = false;         // El cliente cerró su lado de escritura
+        bool writing = false;            // Esperando EPOLLOUT
+        Clock::time_point lastActive;
+    };
+
+    struct Worker {
+        int listenFd = -1, epfd = -1, wakeFd = -1;
+        std::thread thread;
+        std::unordered_map<int, std::unique_ptr<Connection>> conns;
+        int64_t dateSecond = -1;         // Cabecera Date, una vez por segundo
+        std::string date;
+    };
+
+    struct Counters {
+        std::atomic<uint64_t> connections{ 0 }, requests{ 0 }, bytes{ 0 };
+        std::atomic<uint64_t> notModified{ 0 }, partial{ 0 }, precompressed{ 0 }, errors{ 0 };
+    };
+
+    Options opt;
+    uint16_t port = 0;
+    std::vector<std::unique_ptr<Worker>> workers;
+    Counters counters;
+
+    static int Listen(const std::string& host, uint16_t port) {
+        int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0) return -1;
+        int one = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one));
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        if (inet_pton(AF_INET, host.c_str(), &addr.sin_addr) != 1 ||
+            ::bind(fd, (sockaddr*)&addr, sizeof(addr)) < 0 || ::listen(fd, SOMAXCONN) < 0) {
+            int e = errno;
+            ::close(fd);
+            errno = e;
+            return -1;
+        }
+        return fd;
+    }
+
+    static void Watch(int epfd, int fd, uint32_t events, int op) {
+        epoll_event ev{};
+        ev.events = events;
+        ev.data.fd = fd;
+        epoll_ctl(epfd, op, fd, &ev);
+    }
+
+    static void CloseFile(Connection& c) {
+        if (c.file >= 0) { ::close(c.file); c.file = -1; }
+        c.fileLeft = 0;
+    }
+
+    void Loop(Worker* w) {
+        epoll_event events[256];
+        auto lastSweep = Clock::now();
+        for (;;) {
+            int n = epoll_wait(w->epfd, events, 256, 1000);
+            if (n < 0 && errno != EINTR) break;
+            for (int i = 0; i < n; i++) {
+                int fd = events[i].data.fd;
+                if (fd == w->wakeFd) return;
+                if (fd == w->listenFd) { Accept(w); continue; }
+                auto it = w->conns.find(fd);
+                if (it == w->conns.end()) continue;
+                Connection& c = *it->second;
+                bool alive = true;
+                if (events[i].events & (EPOLLERR | EPOLLHUP)) alive = false;
+                else if (events[i].events & EPOLLIN) alive = OnReadable(w, fd, c);
+                else if (events[i].events & EPOLLOUT) alive = Pump(w, fd, c);
+                if (!alive) Close(w, fd);
+            }
+            auto now = Clock::now();
+            if (now - lastSweep >= std::chrono::seconds(1)) {
+                lastSweep = now;
+                std::vector<int> idle;
+                for (auto& c : w->conns) if (now - c.second->lastActive > std::chrono::seconds(opt.idleSeconds)) idle.push_back(c.first);
+                for (int fd : idle) Close(w, fd);
+            }
+        }
+    }
+
+    void Accept(Worker* w) {
+        for (;;) {
+            int fd = ::accept4(w->listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0) return; // EAGAIN, o sin descriptores: se reintenta en el próximo evento
+            int one = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            auto c = std::make_unique<Connection>();
+            c->lastActive = Clock::now();
+            w->conns[fd] = std::move(c);
+            Watch(w->epfd, fd, EPOLLIN | EPOLLRDHUP, EPOLL_CTL_ADD);
+            counters.connections.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    void Close(Worker* w, int fd) {
+        auto it = w->conns.find(fd);
+        if (it == w->conns.end()) return;
+        CloseFile(*it->second);
+        epoll_ctl(w->epfd, EPOLL_CTL_DEL, fd, nullptr);
+        ::close(fd);
+        w->conns.erase(it);
+    }
+
+    bool OnReadable(Worker* w, int fd, Connection& c) {
+        char buf[16384];
+        for (;;) {
+            ssize_t got = ::recv(fd, buf, sizeof(buf), 0);
+            if (got > 0) {
+                c.in.append(buf, (size_t)got);
+                c.lastActive = Clock::now();
+                if ((size_t)got < sizeof(buf)) break;
+                continue;
+            }
+            if (got == 0) {
+                // El cliente cerró su lado: se responde lo que ya mandó y se cierra
+                c.peerClosed = true;
+                break;
+            }
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            return false;
+        }
+        return Pump(w, fd, c);
+    }
+
+    /**
+     * Envía lo pendiente y procesa las peticiones completas que haya en el buffer.
+     * @returns {bool} false si hay que cerrar la conexión.
+     */
+    bool Pump(Worker* w, int fd, Connection& c) {
+        for (;;) {
+            if (!Flush(fd, c)) return false;
+            if (c.outPos < c.out.size() || c.fileLeft > 0) {
+                if (!c.writing) { c.writing = true; Watch(w->epfd, fd, EPOLLOUT, EPOLL_CTL_MOD); }
+                return true;
+            }
+            if (c.writing) { c.writing = false; Watch(w->epfd, fd, EPOLLIN | EPOLLRDHUP, EPOLL_CTL_MOD); }
+            if (c.closeAfter) return false;
+
+            Http::Request req;
+            Http::Parse r = Http::ParseRequest(c.in.data() + c.inPos, c.in.size() - c.inPos, req, opt.maxHeader);
+            if (r == Http::Parse::Incomplete) {
+                if (c.inPos > 0) { c.in.erase(0, c.inPos); c.inPos = 0; }
+                return !c.peerClosed;
+            }
+            if (r != Http::Parse::Ok) {
+                int status = r == Http::Parse::TooLarge ? 431 : r == Http::Parse::BadVersion ? 505 : 400;
+                c.closeAfter = true;
+                Error(w, c, status, nullptr);
+                c.inPos = c.in.size();
+                continue;
+            }
+            Handle(w, c, req);
+            c.inPos += req.length;
+            counters.requests.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    /** @returns {bool} false si el socket falló. */
+    bool Flush(int fd, Connection& c) {
+        while (c.outPos < c.out.size()) {
+            int flags = MSG_NOSIGNAL | (c.fileLeft > 0 ? MSG_MORE : 0);
+            ssize_t sent = ::send(fd, c.out.data() + c.outPos, c.out.size() - c.outPos, flags);
+            if (sent < 0) {
+                if (errno == EINTR) continue;
+                return errno == EAGAIN || errno == EWOULDBLOCK;
+            }
+            c.outPos += (size_t)sent;
+            c.lastActive = Clock::now();
+            counters.bytes.fetch_add((uint64_t)sent, std::memory_order_relaxed);
+        }
+        c.out.clear();
+        c.outPos = 0;
+        while (c.fileLeft > 0) {
+            size_t chunk = (size_t)std::min<uint64_t>(c.fileLeft, 1u << 30);
+            ssize_t sent = ::sendfile(fd, c.file, &c.fileOffset, chunk);
+            if (sent < 0) {
+                if (errno == EINTR) continue;
+                return errno == EAGAIN || errno == EWOULDBLOCK;
+            }
+            if (sent == 0) return false; // El archivo se acortó mientras se enviaba
+            c.fileLeft -= (uint64_t)sent;
+            c.lastActive = Clock::now();
+            counters.bytes.fetch_add((uint64_t)sent, std::memory_order_relaxed);
+        }
+        CloseFile(c);
+        return true;
+    }
+
+    const std::string& Date(Worker* w) {
+        int64_t now = (int64_t)std::time(nullptr);
+        if (now != w->dateSecond) { w->dateSecond = now; w->date = Http::FormatDate(now); }
+        return w->date;
+    }
+
+    void Begin(Worker* w, Connection& c, int status) {
+        c.out += "HTTP/1.1 ";
+        c.out += std::to_string(status);
+        c.out += ' ';
+        c.out += Http::Reason(status);
+        c.out += "\r\nServer: genesis-httpd\r\nDate: ";
+        c.out += Date(w);
+        c.out += "\r\n";
+    }
+
+    void End(Connection& c, uint64_t length) {
+        c.out += "Content-Length: ";
+        c.out += std::to_string(length);
+        c.out += c.closeAfter ? "\r\nConnection: close\r\n\r\n" : "\r\nConnection: keep-alive\r\n\r\n";
+    }
+
+    void Error(Worker* w, Connection& c, int status, const Http::Request* req, const std::string& extra = "") {
+        static const char kBody[] = "Archivo no encontrado";
+        std::string body = status == 404 ? kBody : std::to_string(status) + " " + Http::Reason(status);
+        Begin(w, c, status);
+        c.out += "Content-Type: text/plain; charset=utf-8\r\n";
+        c.out += extra;
+        End(c, body.size());
+        if (!req || req->method != "HEAD") c.out += body;
+        counters.errors.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void Log(const Http::Request& req, int status, uint64_t length) {
+        if (opt.log) std::printf("%.*s %.*s %d %llu\n", (int)req.method.size(), req.method.data(), (int)req.target.size(), req.target.data(), status, (unsigned long long)length);
+    }
+
+    /** Etiqueta fuerte: mtime en ns + tamaño (+ codificación si es un .br/.gz). */
+    static std::string Etag(const struct stat& st, const char* coding) {
+        char buf[64];
+        uint64_t ns = (uint64_t)st.st_mtim.tv_sec * 1000000000ull + (uint64_t)st.st_mtim.tv_nsec;
+        std::snprintf(buf, sizeof(buf), "\"%llx-%llx%s%s\"", (unsigned long long)ns, (unsigned long long)st.st_size, coding ? "-" : "", coding ? coding : "");
+        return buf;
+    }
+
+    static bool NotOlder(const struct stat& a, const struct stat& b) {
+        return a.st_mtim.tv_sec > b.st_mtim.tv_sec || (a.st_mtim.tv_sec == b.st_mtim.tv_sec && a.st_mtim.tv_nsec >= b.st_mtim.tv_nsec);
+    }
+
+    void Handle(Worker* w, Connection& c, const Http::Request& req) {
+        c.closeAfter = c.closeAfter || !req.KeepAlive();
+        bool head = req.method == "HEAD";
+        if (req.method != "GET" && !head) {
+            Log(req, 405, 0);
+            return Error(w, c, 405, &req, "Allow: GET, HEAD\r\n");
+        }
+        std::string rel;
+        std::filesystem::path path;
+        if (!Http::DecodeTarget(req.target, rel)) { Log(req, 400, 0); return Error(w, c, 400, &req); }
+        if (!Paths::ResolveUnder(opt.root, rel, path)) { Log(req, 404, 0); return Error(w, c, 404, &req); }
+
+        std::string file = path.string();
+        int fd = ::open(file.c_str(), O_RDONLY | O_CLOEXEC);
+        struct stat st;
+        if (fd < 0 || fstat(fd, &st) < 0) {
+            int status = errno == EACCES ? 403 : 404;
+            if (fd >= 0) ::close(fd);
+            Log(req, status, 0);
+            return Error(w, c, status, &req);
+        }
+        if (S_ISDIR(st.st_mode)) {
+            // "/carpeta" -> "/carpeta/": las rutas relativas de su index.html resuelven bien
+            ::close(fd);
+            std::string_view target = req.target.substr(0, req.target.find_first_of("?#"));
+            Log(req, 301, 0);
+            return Error(w, c, 301, &req, "Location: " + std::string(target) + "/\r\n");
+        }
+        if (!S_ISREG(st.st_mode)) { ::close(fd); Log(req, 404, 0); return Error(w, c, 404, &req); }
+
+        const char* mime = Http::MimeOf(rel);
+        std::string_view rangeHeader = req.Header("Range");
+        const char* coding = nullptr;
+        bool vary = false;
+        std::string_view accept = req.Header("Accept-Encoding");
+        // Hermano precomprimido: el más pequeño que acepte el navegador (br antes que gzip). Si
+        // existe, la respuesta depende de Accept-Encoding aunque esta vez no se use (Vary)
+        static const std::pair<const char*, const char*> kSiblings[] = { { "br", ".br" }, { "gzip", ".gz" } };
+        struct stat original = st;
+        for (const auto& s : kSiblings) {
+            struct stat sst;
+            if (::stat((file + s.second).c_str(), &sst) != 0 || !S_ISREG(sst.st_mode) || !NotOlder(sst, original)) continue;
+            vary = true;
+            if (coding || !rangeHeader.empty() || !Http::AcceptsEncoding(accept, s.first)) continue;
+            int sfd = ::open((file + s.second).c_str(), O_RDONLY | O_CLOEXEC);
+            if (sfd < 0) continue;
+            ::close(fd);
+            fd = sfd;
+            st = sst;
+            coding = s.first;
+        }
+
+        std::string etag = Etag(st, coding);
+        std::string lastModified = Http::FormatDate((int64_t)st.st_mtim.tv_sec);
+        std::string common = "Last-Modified: " + lastModified + "\r\nETag: " + etag +
+            "\r\nCache-Control: no-cache\r\nAccess-Control-Allow-Origin: *\r\nAccept-Ranges: bytes\r\n";
+        if (vary) common += "Vary: Accept-Encoding\r\n";
+
+        std::string_view inm = req.Header("If-None-Match"), ims = req.Header("If-Modified-Since");
+        int64_t since;
+        bool notModified = !inm.empty() ? Http::EtagMatches(inm, etag)
+            : (!ims.empty() && Http::ParseDate(ims, since) && (int64_t)st.st_mtim.tv_sec <= since);
+        if (notModified) {
+            ::close(fd);
+            Begin(w, c, 304);
+            c.out += common;
+            c.out += c.closeAfter ? "Connection: close\r\n\r\n" : "Connection: keep-alive\r\n\r\n";
+            counters.notModified.fetch_add(1, std::memory_order_relaxed);
+            return Log(req, 304, 0);
+        }
+
+        uint64_t size = (uint64_t)st.st_size, first = 0, last = size ? size - 1 : 0;
+        Http::Range range = Http::Range::Full;
+        std::string_view ifRange = req.Header("If-Range");
+        if (!rangeHeader.empty() && (ifRange.empty() || ifRange == etag || ifRange == lastModified)) {
+            range = Http::ParseRange(rangeHeader, size, first, last);
+        }
+        if (range == Http::Range::Unsatisfiable) {
+            ::close(fd);
+            Log(req, 416, 0);
+            return Error(w, c, 416, &req, "Content-Range: bytes */" + std::to_string(size) + "\r\n");
+        }
+
+        bool partial = range == Http::Range::Partial;
+        uint64_t length = size == 0 ? 0 : last - first + 1;
+        Begin(w, c, partial ? 206 : 200);
+        c.out += "Content-Type: ";
+        c.out += mime;
+        c.out += "\r\n";
+        if (coding) { c.out += "Content-Encoding: "; c.out += coding; c.out += "\r\n"; }
+        if (partial) c.out += "Content-Range: bytes " + std::to_string(first) + "-" + std::to_string(last) + "/" + std::to_string(size) + "\r\n";
+        c.out += common;
+        End(c, length);
+        if (partial) counters.partial.fetch_add(1, std::memory_order_relaxed);
+        if (coding) counters.precompressed.fetch_add(1, std::memory_order_relaxed);
+        Log(req, partial ? 206 : 200, length);
+
+        if (head || length == 0) { ::close(fd); return; }
+        c.file = fd;
+        c.fileOffset = (off_t)first;
+        c.fileLeft = length;
+    }
+};
+#endif
@@ -0,0 +1,650 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "AssetPack.h"
+#include "AtomicFile.h"
+#include "WriteBehindStore.h"
+
+#ifndef _WIN32
+#include <sys/types.h>
+#endif
+
+/**
+ * @namespace Journal
+ * @description Diario de ediciones por clave para los documentos del editor (charts, proyectos).
+ * En vez de reescribir el documento entero en cada guardado, cada cambio se añade al final
+ * del archivo como un empalme (offset, texto quitado, texto puesto), así que lo escrito crece
+ * con el tamaño de la edición y no con el del documento. Guardar el texto quitado deja el
+ * deshacer/rehacer listo y persistente.
+ *
+ * Cuando la cola de registros supera al último compactado, el archivo se reescribe (atómico)
+ * como una instantánea del texto más el historial de deshacer/rehacer que se conserva.
+ * Al abrir se reconstruye el estado y se descarta la cola rota de un corte a mitad de escritura.
+ *
+ * Formato (little-endian):
+ *   [0]  "GJNL" | u16 versión | u16 reservado                          (8 bytes)
+ *   [8]  registros: u32 bytes del cuerpo | u32 CRC-32 del cuerpo | cuerpo
+ *   cuerpo: u8 tipo | u64 revisión | ...
+ *     Snapshot             cadena texto                                (siempre el primero)
+ *     Edit                 u64 offset | cadena quitado | cadena puesto | cadena etiqueta
+ *     Undo, Redo           nada más
+ *     UndoEntry, RedoEntry como Edit pero sin aplicar: historial conservado al compactar
+ *   cadena = u32 bytes | bytes
+ */
+namespace Journal {
+
+    constexpr uint16_t kVersion = 1;
+    constexpr size_t kHeaderSize = 8;
+    constexpr size_t kRecordHeader = 8;
+    /** Entradas de deshacer que se conservan por documento. */
+    constexpr size_t kHistoryLimit = 256;
+    /** La cola de registros no se compacta por debajo de esto. */
+    constexpr uint64_t kCompactMinBytes = 256 * 1024;
+
+    enum class Record : uint8_t { Snapshot = 1, Edit = 2, Undo = 3, Redo = 4, UndoEntry = 5, RedoEntry = 6 };
+
+    namespace Detail {
+        using AssetPack::Detail::Put32;
+        using AssetPack::Detail::Put64;
+        using AssetPack::Detail::Get16;
+        using AssetPack::Detail::Get32;
+        using AssetPack::Detail::Get64;
+
+        /** CRC-32 (IEEE, el de zip) por tabla. */
+        inline uint32_t Crc32(const void* data, size_t n) {
+            static const struct Table {
+                uint32_t v[256];
+                Table() {
+                    for (uint32_t i = 0; i < 256; i++) {
+                        uint32_t c = i;
+                        for (int k = 0; k < 8; k++) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                        v[i] = c;
+                    }
+                }
+            } table;
+            const unsigned char* p = (const unsigned char*)data;
+            uint32_t crc = 0xFFFFFFFFu;
+            for (size_t i = 0; i < n; i++) crc = table.v[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+            return crc ^ 0xFFFFFFFFu;
+        }
+
+        inline void PutStr(std::string& o, std::string_view s) { Put32(o, (uint32_t)s.size()); o.append(s.data(), s.size()); }
+
+        /** Lectura acotada de un cuerpo; cualquier desborde deja `ok` en false. */
+        struct Reader {
+            const unsigned char* p;
+            size_t n, at = 0;
+            bool ok = true;
+
+            Reader(const char* data, size_t size) : p((const unsigned char*)data), n(size) {}
+
+            bool Has(size_t k) { if (n - at < k) ok = false; return ok; }
+            uint8_t U8() { return Has(1) ? p[at++] : 0; }
+            uint32_t U32() { if (!Has(4)) return 0; uint32_t v = Get32(p + at); at += 4; return v; }
+            uint64_t U64() { if (!Has(8)) return 0; uint64_t v = Get64(p + at); at += 8; return v; }
+            void Str(std::string& out) {
+                uint32_t len = U32();
+                if (!Has(len)) return;
+                out.assign((const char*)p + at, len);
+                at += len;
+            }
+        };
+
+        /**
+         * Archivo abierto para añadir al final. Open recorta a `keep` bytes (la parte sana).
+         */
+        class AppendFile {
+        public:
+            ~AppendFile() { Close(); }
+
+            bool Open(const std::filesystem::path& path, uint64_t keep, std::string& err) {
+                Close();
+#ifdef _WIN32
+                handle = CreateFileW(path.c_str(), GENERIC_WRITE, FILE_SHARE_READ, NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+                if (handle == INVALID_HANDLE_VALUE) { err = AtomicFile::LastError(); return false; }
+#else
+                fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+                if (fd < 0) { err = AtomicFile::LastError(); return false; }
+#endif
+                if (!Truncate(keep, err)) { Close(); return false; }
+                return true;
+            }
+
+            bool IsOpen() const {
+#ifdef _WIN32
+                return handle != INVALID_HANDLE_VALUE;
+#else
+                return fd >= 0;
+#endif
+            }
+
+            /** Deja el archivo en `size` bytes y el cursor al final. */
+            bool Truncate(uint64_t size, std::string& err) {
+#ifdef _WIN32
+                LARGE_INTEGER at; at.QuadPart = (LONGLONG)size;
+                if (!SetFilePointerEx(handle, at, NULL, FILE_BEGIN) || !SetEndOfFile(handle)) { err = AtomicFile::LastError(); return false; }
+#else
+                if (::ftruncate(fd, (off_t)size) != 0 || ::lseek(fd, (off_t)size, SEEK_SET) < 0) { err = AtomicFile::LastError(); return false; }
+#endif
+                return true;
+            }
+
+            bool Write(const char* data, size_t size, std::string& err) {
+#ifdef _WIN32
+                while (size > 0) {
+                    DWORD chunk = size > (1u << 30) ? (1u << 30) : (DWORD)size, written = 0;
+                    if (!WriteFile(handle, data, chunk, &written, NULL)) { err = AtomicFile::LastError(); return false; }
+                    data += written; size -= written;
+                }
+#else
+                while (size > 0) {
+                    ssize_t n = ::write(fd, data, size);
+                    if (n < 0) { if (errno == EINTR) continue; err = AtomicFile::LastError(); return false; }
+                    data += n; size -= (size_t)n;
+                }
+#endif
+                return true;
+            }
+
+            bool Sync(std::string& err) {
+#ifdef _WIN32
+                if (!FlushFileBuffers(handle)) { err = AtomicFile::LastError(); return false; }
+#elif defined(__APPLE__)
+                if (::fsync(fd) != 0) { err = AtomicFile::LastError(); return false; }
+#else
+                if (::fdatasync(fd) != 0) { err = AtomicFile::LastError(); return false; }
+#endif
+                return true;
+            }
+
+            void Close() {
+#ifdef _WIN32
+                if (handle != INVALID_HANDLE_VALUE) CloseHandle(handle);
+                handle = INVALID_HANDLE_VALUE;
+#else
+                if (fd >= 0) ::close(fd);
+                fd = -1;
+#endif
+            }
+
+        private:
+#ifdef _WIN32
+            HANDLE handle = INVALID_HANDLE_VALUE;
+#else
+            int fd = -1;
+#endif
+        };
+    }
+
+    /**
+     * Un empalme: en `offset` se quita `removed` y se pone `inserted`. Offsets en bytes UTF-8.
+     */
+    struct Change {
+        uint64_t offset = 0;
+        std::string removed, inserted, label;
+
+        /** El empalme que lo deshace. */
+        Change Inverse() const { return Change{ offset, inserted, removed, label }; }
+    };
+
+    /**
+     * @class Document
+     * @description Texto de un documento con su revisión y sus pilas de deshacer/rehacer.
+     * Solo estado en memoria; Log lo persiste y lo reconstruye aplicando los mismos pasos.
+     */
+    class Document {
+    public:
+        explicit Document(size_t historyLimit = kHistoryLimit) : historyLimit(historyLimit) {}
+
+        const std::string& Text() const { return text; }
+        uint64_t Rev() const { return rev; }
+        const std::deque<Change>& UndoStack() const { return undo; }
+        const std::deque<Change>& RedoStack() const { return redo; }
+
+        /** true si `c.removed` está de verdad en `c.offset`. */
+        bool Fits(const Change& c) const {
+            return c.offset <= text.size() && c.removed.size() <= text.size() - c.offset
+                && text.compare((size_t)c.offset, c.removed.size(), c.removed) == 0;
+        }
+
+        /** Edición nueva: entra en el historial y vacía el rehacer. Debe cumplir Fits. */
+        void Apply(Change c) {
+            Splice(c);
+            redo.clear();
+            undo.push_back(std::move(c));
+            if (undo.size() > historyLimit) undo.pop_front();
+            rev++;
+        }
+
+        /** @returns {bool} false si no hay nada que deshacer; si no, el empalme aplicado en `applied`. */
+        bool Undo(Change* applied = nullptr) {
+            if (undo.empty()) return false;
+            Change c = std::move(undo.back());
+            undo.pop_back();
+            Change inv = c.Inverse();
+            Splice(inv);
+            if (applied) *applied = std::move(inv);
+            redo.push_back(std::move(c));
+            rev++;
+            return true;
+        }
+
+        bool Redo(Change* applied = nullptr) {
+            if (redo.empty()) return false;
+            Change c = std::move(redo.back());
+            redo.pop_back();
+            Splice(c);
+            if (applied) *applied = c;
+            undo.push_back(std::move(c));
+            if (undo.size() > historyLimit) undo.pop_front();
+            rev++;
+            return true;
+        }
+
+        void Reset(std::string t, uint64_t r) { text = std::move(t); rev = r; undo.clear(); redo.clear(); }
+
+        /** Historial leído de una instantánea, del más antiguo al más reciente. */
+        void PushHistory(bool toRedo, Change c) {
+            std::deque<Change>& stack = toRedo ? redo : undo;
+            stack.push_back(std::move(c));
+            if (!toRedo && undo.size() > historyLimit) undo.pop_front();
+        }
+
+    private:
+        std::string text;
+        uint64_t rev = 0;
+        std::deque<Change> undo, redo;
+        size_t historyLimit;
+
+        void Splice(const Change& c) { text.replace((size_t)c.offset, c.removed.size(), c.inserted); }
+    };
+
+    /**
+     * Empalme mínimo que convierte `from` en `to`: prefijo y sufijo comunes fuera, sin cortar
+     * secuencias UTF-8 (los offsets tienen que poder pasarse a unidades de la página).
+     */
+    inline Change Diff(std::string_view from, std::string_view to) {
+        size_t limit = from.size() < to.size() ? from.size() : to.size();
+        // Por bloques con memcmp primero: en un documento grande casi todo es prefijo o sufijo común
+        size_t pre = 0;
+        while (pre + 64 <= limit && std::memcmp(from.data() + pre, to.data() + pre, 64) == 0) pre += 64;
+        while (pre < limit && from[pre] == to[pre]) pre++;
+        auto cont = [](char ch) { return ((unsigned char)ch & 0xC0) == 0x80; };
+        while (pre > 0 && ((pre < from.size() && cont(from[pre])) || (pre < to.size() && cont(to[pre])))) pre--;
+        size_t suf = 0;
+        while (suf + 64 <= limit - pre && std::memcmp(from.data() + from.size() - suf - 64, to.data() + to.size() - suf - 64, 64) == 0) suf += 64;
+        while (suf < limit - pre && from[from.size() - 1 - suf] == to[to.size() - 1 - suf]) suf++;
+        while (suf > 0 && (cont(from[from.size() - suf]) || cont(to[to.size() - suf]))) suf--;
+        Change c;
+        c.offset = pre;
+        c.removed.assign(from.substr(pre, from.size() - pre - suf));
+        c.inserted.assign(to.substr(pre, to.size() - pre - suf));
+        return c;
+    }
+
+    /**
+     * @class Log
+     * @description Diario de un documento en disco: Document + archivo de registros.
+     * Cada operación añade un registro con una sola escritura; Sync lo fuerza a disco.
+     */
+    class Log {
+    public:
+        struct Stats {
+            uint64_t edits = 0;        // Ediciones registradas
+            uint64_t undos = 0;
+            uint64_t redos = 0;
+            uint64_t compactions = 0;
+            uint64_t appended = 0;     // Bytes añadidos en registros
+            uint64_t compacted = 0;    // Bytes escritos al compactar
+            uint64_t recovered = 0;    // Bytes de cola rota descartados al abrir
+        };
+
+        explicit Log(size_t historyLimit = kHistoryLimit) : doc(historyLimit) {}
+
+        /**
+         * Abre (o crea) el diario y reconstruye el documento. Una cola incompleta o con CRC
+         * incorrecto se descarta y el archivo se recorta a la última edición sana.
+         * @returns {bool} false si el archivo no es un diario o no se puede escribir.
+         */
+        bool Open(const std::filesystem::path& p, std::string& err) {
+            path = p;
+            file.Close();
+            doc.Reset({}, 0);
+            size = base = 0;
+            dirty = false;
+            std::string data;
+            if (!AtomicFile::ReadAll(path, data)) data.clear();
+
+            static const char kMagic[4] = { 'G', 'J', 'N', 'L' };
+            if (data.size() >= kHeaderSize) {
+                if (std::memcmp(data.data(), kMagic, 4) != 0 || Detail::Get16((const unsigned char*)data.data() + 4) != kVersion) {
+                    err = "not a journal";
+                    return false;
+                }
+            } else if (std::memcmp(data.data(), kMagic, data.size() < 4 ? data.size() : 4) != 0) {
+                err = "not a journal";
+                return false;
+            }
+
+            // Registros sanos: el primero tiene que ser la instantánea
+            size_t at = kHeaderSize, good = 0;
+            bool leading = true;
+            while (data.size() >= kHeaderSize && data.size() - at >= kRecordHeader) {
+                const unsigned char* h = (const unsigned char*)data.data() + at;
+                uint32_t len = Detail::Get32(h), crc = Detail::Get32(h + 4);
+                if (data.size() - at - kRecordHeader < len) break;
+                const char* body = data.data() + at + kRecordHeader;
+                if (Detail::Crc32(body, len) != crc) break;
+                Record type;
+                if (!Replay(body, len, good == 0, leading, type)) break;
+                at += kRecordHeader + len;
+                good = at;
+                if (leading && type != Record::Snapshot && type != Record::UndoEntry && type != Record::RedoEntry) leading = false;
+                if (leading) base = at;
+            }
+
+            if (good == 0) {
+                // Sin instantánea válida: diario nuevo (o uno que no llegó a crearse)
+                stats.recovered += data.size();
+                doc.Reset({}, 0);
+                return Compact(err);
+            }
+            stats.recovered += data.size() - good;
+            size = good;
+            return file.Open(path, size, err);
+        }
+
+        const Document& Doc() const { return doc; }
+        const std::filesystem::path& Path() const { return path; }
+        const Stats& GetStats() const { return stats; }
+        /** Bytes del archivo y de su parte compactada (instantánea + historial). */
+        uint64_t Size() const { return size; }
+        uint64_t BaseSize() const { return base; }
+        bool IsDirty() const { return dirty; }
+
+        /**
+         * Registra un empalme. `c.removed` tiene que coincidir con el texto actual.
+         * Un empalme vacío no escribe nada.
+         */
+        bool Apply(Change c, std::string& err) {
+            if (!doc.Fits(c)) { err = "stale edit"; return false; }
+            if (c.removed.empty() && c.inserted.empty()) return true;
+            scratch.clear();
+            scratch += (char)Record::Edit;
+            Detail::Put64(scratch, doc.Rev() + 1);
+            PutChange(scratch, c);
+            if (!Append(err)) return false;
+            doc.Apply(std::move(c));
+            stats.edits++;
+            return MaybeCompact(err);
+        }
+
+        /**
+         * Registra el cambio del texto entero a `text` como el empalme mínimo.
+         * @param {bool*} changed - false si el texto era el mismo.
+         */
+        bool Commit(std::string_view text, std::string_view label, std::string& err, bool* changed = nullptr) {
+            Change c = Diff(doc.Text(), text);
+            c.label.assign(label);
+            if (changed) *changed = !(c.removed.empty() && c.inserted.empty());
+            return Apply(std::move(c), err);
+        }
+
+        /** @param {Change*} applied - El empalme que se aplicó al texto (para repetirlo en la página). */
+        bool Undo(std::string& err, Change* applied = nullptr) { return Step(Record::Undo, err, applied); }
+        bool Redo(std::string& err, Change* applied = nullptr) { return Step(Record::Redo, err, applied); }
+
+        /**
+         * Reescribe el archivo como instantánea + historial (temporal + rename) y sigue añadiendo al nuevo.
+         */
+        bool Compact(std::string& err) {
+            file.Close();
+            std::string out("GJNL", 4);
+            out += (char)(kVersion & 0xFF); out += (char)(kVersion >> 8);
+            out += '\0'; out += '\0';
+            scratch.clear();
+            scratch += (char)Record::Snapshot;
+            Detail::Put64(scratch, doc.Rev());
+            Detail::PutStr(scratch, doc.Text());
+            Frame(out, scratch);
+            for (int r = 0; r < 2; r++) {
+                for (const Change& c : r ? doc.RedoStack() : doc.UndoStack()) {
+                    scratch.clear();
+                    scratch += (char)(r ? Record::RedoEntry : Record::UndoEntry);
+                    Detail::Put64(scratch, 0);
+                    PutChange(scratch, c);
+                    Frame(out, scratch);
+                }
+            }
+            if (!AtomicFile::Write(path, out, err)) return false;
+            size = base = out.size();
+            dirty = false;
+            stats.compactions++;
+            stats.compacted += out.size();
+            return file.Open(path, size, err);
+        }
+
+        /** Fuerza a disco lo añadido desde el último Sync. */
+        bool Sync(std::string& err) {
+            if (!dirty) return true;
+            if (!file.Sync(err)) return false;
+            dirty = false;
+            return true;
+        }
+
+        void Close() { std::string err; Sync(err); file.Close(); }
+
+    private:
+        std::filesystem::path path;
+        Document doc;
+        Detail::AppendFile file;
+        uint64_t size = 0, base = 0;
+        bool dirty = false;
+        std::string scratch, frame;
+        Stats stats;
+
+        static void PutChange(std::string& o, const Change& c) {
+            Detail::Put64(o, c.offset);
+            Detail::PutStr(o, c.removed);
+            Detail::PutStr(o, c.inserted);
+            Detail::PutStr(o, c.label);
+        }
+
+        static bool ReadChange(Detail::Reader& r, Change& c) {
+            c.offset = r.U64();
+            r.Str(c.removed);
+            r.Str(c.inserted);
+            r.Str(c.label);
+            return r.ok;
+        }
+
+        static void Frame(std::string& out, const std::string& body) {
+            Detail::Put32(out, (uint32_t)body.size());
+            Detail::Put32(out, Detail::Crc32(body.data(), body.size()));
+            out += body;
+        }
+
+        /**
+         * Aplica un registro leído del disco. Uno que no encaja con el estado (revisión u offset)
+         * se trata como corrupto, igual que un CRC incorrecto.
+         */
+        bool Replay(const char* body, size_t len, bool first, bool leading, Record& type) {
+            Detail::Reader r(body, len);
+            type = (Record)r.U8();
+            uint64_t rev = r.U64();
+            if (!r.ok || first != (type == Record::Snapshot)) return false;
+            switch (type) {
+                case Record::Snapshot: {
+                    std::string text;
+                    r.Str(text);
+                    if (!r.ok) return false;
+                    doc.Reset(std::move(text), rev);
+                    return true;
+                }
+                case Record::Edit: {
+                    Change c;
+                    if (!ReadChange(r, c) || rev != doc.Rev() + 1 || !doc.Fits(c)) return false;
+                    doc.Apply(std::move(c));
+                    return true;
+                }
+                case Record::UndoEntry:
+                case Record::RedoEntry: {
+                    Change c;
+                    if (!leading || !ReadChange(r, c)) return false;
+                    doc.PushHistory(type == Record::RedoEntry, std::move(c));
+                    return true;
+                }
+                case Record::Undo: return rev == doc.Rev() + 1 && doc.Undo();
+                case Record::Redo: return rev == doc.Rev() + 1 && doc.Redo();
+                default: return false;
+            }
+        }
+
+        bool Step(Record type, std::string& err, Change* applied) {
+            bool can = type == Record::Undo ? !doc.UndoStack().empty() : !doc.RedoStack().empty();
+            if (!can) { err = type == Record::Undo ? "nothing to undo" : "nothing to redo"; return false; }
+            scratch.clear();
+            scratch += (char)type;
+            Detail::Put64(scratch, doc.Rev() + 1);
+            if (!Append(err)) return false;
+            if (type == Record::Undo) { doc.Undo(applied); stats.undos++; }
+            else { doc.Redo(applied); stats.redos++; }
+            return MaybeCompact(err);
+        }
+
+        /** Añade `scratch` como registro con una sola escritura; si falla, recorta lo que hubiera entrado. */
+        bool Append(std::string& err) {
+            if (!file.IsOpen()) { err = "journal closed"; return false; }
+            frame.clear();
+            Frame(frame, scratch);
+            if (!file.Write(frame.data(), frame.size(), err)) {
+                std::string ignored;
+                file.Truncate(size, ignored);
+                return false;
+            }
+            size += frame.size();
+            dirty = true;
+            stats.appended += frame.size();
+            return true;
+        }
+
+        /** La cola se compacta cuando ya pesa más que la parte compactada. */
+        bool MaybeCompact(std::string& err) {
+            uint64_t tail = size - base;
+            if (tail < kCompactMinBytes || tail < base) return true;
+            return Compact(err);
+        }
+    };
+
+    /**
+     * @class Store
+     * @description Diarios abiertos por clave bajo una carpeta (`root/<clave>.gjnl`), con
+     * sincronización agrupada: un registro se fuerza a disco como mucho `syncWindow` después
+     * de escribirse (0 = en cada operación). Un cierre de la app no pierde nada; un corte de
+     * luz, como mucho la ventana.
+     */
+    class Store {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        Store(std::filesystem::path root, std::chrono::milliseconds syncWindow = std::chrono::milliseconds(0))
+            : root(std::move(root)), syncWindow(syncWindow) {}
+
+        ~Store() { CloseAll(); }
+
+        Store(const Store&) = delete;
+        Store& operator=(const Store&) = delete;
+
+        std::filesystem::path PathOf(const std::string& key) const { return root / std::filesystem::u8path(key + ".gjnl"); }
+
+        /**
+         * Ejecuta `fn(Log&)` con el diario de `key` abierto (lo abre si hace falta) y aplica
+         * la política de sincronización después.
+         * @returns {bool} Lo que devuelva `fn`; false con `err` si la clave no vale o no se pudo abrir.
+         */
+        template <typename Fn>
+        bool With(const std::string& key, std::string& err, Fn&& fn) {
+            if (!WriteBehindStore::IsValidKey(key)) { err = "invalid key"; return false; }
+            std::lock_guard<std::mutex> lock(mtx);
+            std::unique_ptr<Log>& log = logs[key];
+            if (!log) {
+                auto opened = std::make_unique<Log>();
+                if (!opened->Open(PathOf(key), err)) { logs.erase(key); return false; }
+                log = std::move(opened);
+            }
+            bool ok = fn(*log);
+            if (log->IsDirty()) {
+                Clock::time_point now = Clock::now();
+                if (syncWindow.count() <= 0 || now - lastSync >= syncWindow) {
+                    std::string e;
+                    SyncLocked(e);
+                    lastSync = now;
+                }
+            }
+            return ok;
+        }
+
+        /** Fuerza a disco todos los diarios abiertos. */
+        bool Sync(std::string& err) {
+            std::lock_guard<std::mutex> lock(mtx);
+            lastSync = Clock::now();
+            return SyncLocked(err);
+        }
+
+        /** Sincroniza y cierra un diario; la próxima operación lo vuelve a abrir desde disco. */
+        void Close(const std::string& key) {
+            std::lock_guard<std::mutex> lock(mtx);
+            auto it = logs.find(key);
+            if (it == logs.end()) return;
+            Retire(*it->second);
+            logs.erase(it);
+        }
+
+        void CloseAll() {
+            std::lock_guard<std::mutex> lock(mtx);
+            for (auto& kv : logs) Retire(*kv.second);
+            logs.clear();
+        }
+
+        /** Suma de los diarios abiertos y de los ya cerrados. */
+        Log::Stats GetStats() {
+            std::lock_guard<std::mutex> lock(mtx);
+            Log::Stats total = closed;
+            for (auto& kv : logs) Add(total, kv.second->GetStats());
+            return total;
+        }
+
+    private:
+        std::filesystem::path root;
+        std::chrono::milliseconds syncWindow;
+        std::mutex mtx;
+        std::map<std::string, std::unique_ptr<Log>> logs;
+        Clock::time_point lastSync;
+        Log::Stats closed;
+
+        static void Add(Log::Stats& a, const Log::Stats& b) {
+            a.edits += b.edits; a.undos += b.undos; a.redos += b.redos; a.compactions += b.compactions;
+            a.appended += b.appended; a.compacted += b.compacted; a.recovered += b.recovered;
+        }
+
+        bool SyncLocked(std::string& err) {
+            bool ok = true;
+            for (auto& kv : logs) if (!kv.second->Sync(err)) ok = false;
+            return ok;
+        }
+
+        void Retire(Log& log) {
+            log.Close();
+            Add(closed, log.GetStats());
+        }
+    };
+}
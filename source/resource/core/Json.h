@@ -0,0 +1,284 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/**
+ * @namespace Json
+ * @description Parser JSON (RFC 8259) con DOM propio, sin dependencias.
+ * Pensado para los datos del juego: charts, personajes, escenarios y atlas.
+ */
+namespace Json {
+
+    enum class Type : uint8_t { Null, Bool, Number, String, Array, Object };
+
+    /**
+     * @class Value
+     * @description Nodo del DOM. Los accesos a claves o índices inexistentes devuelven un
+     * Null compartido, así que se pueden encadenar sin comprobar cada paso.
+     */
+    class Value {
+    public:
+        using Member = std::pair<std::string, Value>;
+
+        Type type = Type::Null;
+
+        bool IsNull() const { return type == Type::Null; }
+        bool IsBool() const { return type == Type::Bool; }
+        bool IsNumber() const { return type == Type::Number; }
+        bool IsString() const { return type == Type::String; }
+        bool IsArray() const { return type == Type::Array; }
+        bool IsObject() const { return type == Type::Object; }
+
+        double Num(double def = 0.0) const { return type == Type::Number ? num : def; }
+        int Int(int def = 0) const { return type == Type::Number ? (int)num : def; }
+        bool Bool(bool def = false) const { return type == Type::Bool ? flag : def; }
+        const std::string& Str() const { static const std::string empty; return type == Type::String ? str : empty; }
+        std::string Str(const std::string& def) const { return type == Type::String ? str : def; }
+
+        size_t Size() const { return type == Type::Array ? items.size() : (type == Type::Object ? members.size() : 0); }
+        const std::vector<Value>& Items() const { static const std::vector<Value> none; return type == Type::Array ? items : none; }
+        const std::vector<Member>& Members() const { static const std::vector<Member> none; return type == Type::Object ? members : none; }
+
+        const Value& operator[](size_t i) const { return (type == Type::Array && i < items.size()) ? items[i] : Null(); }
+        const Value& operator[](int i) const { return i < 0 ? Null() : (*this)[(size_t)i]; }
+        const Value& operator[](std::string_view key) const {
+            if (type == Type::Object) for (const auto& m : members) if (m.first == key) return m.second;
+            return Null();
+        }
+        const Value& operator[](const char* key) const { return (*this)[std::string_view(key)]; }
+        bool Has(std::string_view key) const {
+            if (type == Type::Object) for (const auto& m : members) if (m.first == key) return true;
+            return false;
+        }
+
+        static const Value& Null() { static const Value v; return v; }
+
+    private:
+        friend class Parser;
+        double num = 0.0;
+        bool flag = false;
+        std::string str;
+        std::vector<Value> items;
+        std::vector<Member> members;
+    };
+
+    /**
+     * @class Parser
+     * @description Descenso recursivo con límite de profundidad.
+     */
+    class Parser {
+    public:
+        explicit Parser(std::string_view text) : s(text.data()), end(text.data() + text.size()), begin(text.data()) {}
+
+        bool Parse(Value& out, std::string* err) {
+            SkipBom();
+            SkipWs();
+            if (!ParseValue(out, 0)) { if (err) *err = error + " at offset " + std::to_string(p()); return false; }
+            SkipWs();
+            if (s != end) { if (err) *err = "trailing characters at offset " + std::to_string(p()); return false; }
+            return true;
+        }
+
+    private:
+        static constexpr int kMaxDepth = 512;
+        const char* s;
+        const char* end;
+        const char* begin;
+        std::string error;
+
+        size_t p() const { return (size_t)(s - begin); }
+        bool Fail(const char* msg) { error = msg; return false; }
+
+        void SkipBom() { if (end - s >= 3 && (unsigned char)s[0] == 0xEF && (unsigned char)s[1] == 0xBB && (unsigned char)s[2] == 0xBF) s += 3; }
+        void SkipWs() { while (s < end && (*s == ' ' || *s == '\n' || *s == '\r' || *s == '\t')) s++; }
+
+        bool Literal(const char* lit, size_t n) {
+            if ((size_t)(end - s) < n || std::memcmp(s, lit, n) != 0) return Fail("invalid literal");
+            s += n; return true;
+        }
+
+        bool ParseValue(Value& v, int depth) {
+            if (depth > kMaxDepth) return Fail("nesting too deep");
+            if (s >= end) return Fail("unexpected end");
+            switch (*s) {
+            case '{': return ParseObject(v, depth);
+            case '[': return ParseArray(v, depth);
+            case '"': v.type = Type::String; return ParseString(v.str);
+            case 't': v.type = Type::Bool; v.flag = true; return Literal("true", 4);
+            case 'f': v.type = Type::Bool; v.flag = false; return Literal("false", 5);
+            case 'n': v.type = Type::Null; return Literal("null", 4);
+            default: return ParseNumber(v);
+            }
+        }
+
+        bool ParseObject(Value& v, int depth) {
+            v.type = Type::Object; s++;
+            SkipWs();
+            if (s < end && *s == '}') { s++; return true; }
+            while (true) {
+                SkipWs();
+                if (s >= end || *s != '"') return Fail("expected key");
+                v.members.emplace_back();
+                Value::Member& m = v.members.back();
+                if (!ParseString(m.first)) return false;
+                SkipWs();
+                if (s >= end || *s != ':') return Fail("expected ':'");
+                s++; SkipWs();
+                if (!ParseValue(m.second, depth + 1)) return false;
+                SkipWs();
+                if (s < end && *s == ',') { s++; continue; }
+                if (s < end && *s == '}') { s++; return true; }
+                return Fail("expected ',' or '}'");
+            }
+        }
+
+        bool ParseArray(Value& v, int depth) {
+            v.type = Type::Array; s++;
+            SkipWs();
+            if (s < end && *s == ']') { s++; return true; }
+            while (true) {
+                SkipWs();
+                v.items.emplace_back();
+                if (!ParseValue(v.items.back(), depth + 1)) return false;
+                SkipWs();
+                if (s < end && *s == ',') { s++; continue; }
+                if (s < end && *s == ']') { s++; return true; }
+                return Fail("expected ',' or ']'");
+            }
+        }
+
+        static int Hex(char c) {
+            if (c >= '0' && c <= '9') return c - '0';
+            if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+            if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+            return -1;
+        }
+
+        bool ReadHex4(uint32_t& cp) {
+            if (end - s < 4) return Fail("bad \\u escape");
+            cp = 0;
+            for (int i = 0; i < 4; i++) { int h = Hex(s[i]); if (h < 0) return Fail("bad \\u escape"); cp = (cp << 4) | (uint32_t)h; }
+            s += 4; return true;
+        }
+
+        static void AppendUtf8(std::string& out, uint32_t cp) {
+            if (cp < 0x80) out += (char)cp;
+            else if (cp < 0x800) { out += (char)(0xC0 | (cp >> 6)); out += (char)(0x80 | (cp & 0x3F)); }
+            else if (cp < 0x10000) { out += (char)(0xE0 | (cp >> 12)); out += (char)(0x80 | ((cp >> 6) & 0x3F)); out += (char)(0x80 | (cp & 0x3F)); }
+            else { out += (char)(0xF0 | (cp >> 18)); out += (char)(0x80 | ((cp >> 12) & 0x3F)); out += (char)(0x80 | ((cp >> 6) & 0x3F)); out += (char)(0x80 | (cp & 0x3F)); }
+        }
+
+        bool ParseString(std::string& out) {
+            s++; // comilla inicial
+            const char* run = s;
+            while (true) {
+                // Copia por tramos: la mayoría de cadenas no tienen escapes
+                while (s < end && *s != '"' && *s != '\\' && (unsigned char)*s >= 0x20) s++;
+                out.append(run, (size_t)(s - run));
+                if (s >= end) return Fail("unterminated string");
+                if (*s == '"') { s++; return true; }
+                if ((unsigned char)*s < 0x20) return Fail("control character in string");
+                s++; // '\\'
+                if (s >= end) return Fail("unterminated string");
+                char e = *s++;
+                switch (e) {
+                case '"': out += '"'; break;
+                case '\\': out += '\\'; break;
+                case '/': out += '/'; break;
+                case 'b': out += '\b'; break;
+                case 'f': out += '\f'; break;
+                case 'n': out += '\n'; break;
+                case 'r': out += '\r'; break;
+                case 't': out += '\t'; break;
+                case 'u': {
+                    uint32_t cp;
+                    if (!ReadHex4(cp)) return false;
+                    if (cp >= 0xD800 && cp <= 0xDBFF && end - s >= 6 && s[0] == '\\' && s[1] == 'u') {
+                        s += 2;
+                        uint32_t lo;
+                        if (!ReadHex4(lo)) return false;
+                        if (lo >= 0xDC00 && lo <= 0xDFFF) cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+                        else { AppendUtf8(out, 0xFFFD); cp = lo; }
+                    }
+                    if (cp >= 0xD800 && cp <= 0xDFFF) cp = 0xFFFD;
+                    AppendUtf8(out, cp);
+                    break;
+                }
+                default: return Fail("bad escape");
+                }
+                run = s;
+            }
+        }
+
+        bool ParseNumber(Value& v) {
+            const char* start = s;
+            if (s < end && *s == '-') s++;
+            if (s >= end || !(*s >= '0' && *s <= '9')) return Fail("invalid value");
+            // Parte entera rápida para los casos comunes (índices, carriles, tiempos enteros)
+            uint64_t whole = 0; int digits = 0;
+            while (s < end && *s >= '0' && *s <= '9') { if (digits < 18) whole = whole * 10 + (uint64_t)(*s - '0'); digits++; s++; }
+            bool simple = digits <= 18;
+            if (s < end && (*s == '.' || *s == 'e' || *s == 'E')) {
+                simple = false;
+                if (*s == '.') { s++; if (s >= end || !(*s >= '0' && *s <= '9')) return Fail("invalid number"); while (s < end && *s >= '0' && *s <= '9') s++; }
+                if (s < end && (*s == 'e' || *s == 'E')) {
+                    s++;
+                    if (s < end && (*s == '+' || *s == '-')) s++;
+                    if (s >= end || !(*s >= '0' && *s <= '9')) return Fail("invalid number");
+                    while (s < end && *s >= '0' && *s <= '9') s++;
+                }
+            }
+            v.type = Type::Number;
+            if (simple) { v.num = (double)whole; if (*start == '-') v.num = -v.num; return true; }
+            std::string tmp(start, (size_t)(s - start)); // strtod necesita terminador
+            v.num = std::strtod(tmp.c_str(), nullptr);
+            return true;
+        }
+    };
+
+    /**
+     * Parsea un documento completo.
+     * @returns {bool} false con `err` relleno si el JSON no es válido.
+     */
+    inline bool Parse(std::string_view text, Value& out, std::string* err = nullptr) {
+        out = Value();
+        return Parser(text).Parse(out, err);
+    }
+
+    /**
+     * Añade `s` a `out` como cadena JSON entre comillas.
+     */
+    inline void AppendString(std::string& out, std::string_view s) {
+        static const char* hex = "0123456789abcdef";
+        out += '"';
+        for (char c : s) {
+            unsigned char u = (unsigned char)c;
+            if (c == '"') out += "\\\"";
+            else if (c == '\\') out += "\\\\";
+            else if (c == '\n') out += "\\n";
+            else if (c == '\r') out += "\\r";
+            else if (c == '\t') out += "\\t";
+            else if (u < 0x20) { out += "\\u00"; out += hex[u >> 4]; out += hex[u & 15]; }
+            else out += c;
+        }
+        out += '"';
+    }
+
+    /**
+     * Añade un número con la representación más corta que conserva el valor hasta ~1e-9.
+     */
+    inline void AppendNumber(std::string& out, double v) {
+        if (!std::isfinite(v)) { out += "null"; return; }
+        if (v < 9e15 && v > -9e15 && v == (double)(int64_t)v) { out += std::to_string((int64_t)v); return; } // Rango antes del cast
+        char buf[32];
+        std::snprintf(buf, sizeof(buf), "%.10g", v);
+        out += buf;
+    }
+}
@@ -0,0 +1,144 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "BlockTexture.h"
+#include "Png.h"
+
+/**
+ * @namespace Ktx2
+ * @description Contenedor KTX 2.0 para las texturas de BlockTexture: un nivel, una capa, DFD
+ * básico (modelo BC7 o ETC2, alfa premultiplicado) y el nivel opcionalmente comprimido con zlib
+ * (supercompressionScheme 3), que deja las zonas transparentes casi a cero en disco.
+ *
+ * Lo lee tal cual cualquier herramienta KTX2 (ktx info, validadores); la página lo lee con
+ * atlasLoader.js (cabecera + inflate con DecompressionStream).
+ */
+namespace Ktx2 {
+
+    constexpr uint32_t kVkBc7Unorm = 145;           // VK_FORMAT_BC7_UNORM_BLOCK
+    constexpr uint32_t kVkEtc2Rgba8Unorm = 151;     // VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK
+    constexpr uint32_t kSuperNone = 0, kSuperZlib = 3;
+
+    static const uint8_t kIdentifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+    struct Texture {
+        BlockTexture::Format format = BlockTexture::Format::BC7;
+        uint32_t width = 0, height = 0;
+        std::vector<uint8_t> blocks;   // BlockTexture::Blocks(width) * Blocks(height) * 16
+    };
+
+    inline uint32_t VkFormat(BlockTexture::Format f) { return f == BlockTexture::Format::BC7 ? kVkBc7Unorm : kVkEtc2Rgba8Unorm; }
+
+    namespace Detail {
+        inline void Put32(std::string& o, uint32_t v) { for (int i = 0; i < 4; i++) o += (char)((v >> (i * 8)) & 0xFF); }
+        inline void Put64(std::string& o, uint64_t v) { for (int i = 0; i < 8; i++) o += (char)((v >> (i * 8)) & 0xFF); }
+        inline void Set64(std::string& o, size_t at, uint64_t v) { for (int i = 0; i < 8; i++) o[at + i] = (char)((v >> (i * 8)) & 0xFF); }
+        inline void Set32(std::string& o, size_t at, uint32_t v) { for (int i = 0; i < 4; i++) o[at + i] = (char)((v >> (i * 8)) & 0xFF); }
+        inline uint32_t Get32(const uint8_t* p) { return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24); }
+        inline uint64_t Get64(const uint8_t* p) { return (uint64_t)Get32(p) | ((uint64_t)Get32(p + 4) << 32); }
+
+        /** Muestra del DFD: 16 bytes. */
+        inline void Sample(std::string& o, uint32_t bitOffset, uint32_t bitLength, uint32_t channel) {
+            Put32(o, bitOffset | ((bitLength - 1) << 16) | (channel << 24));
+            Put32(o, 0);             // samplePosition
+            Put32(o, 0);             // sampleLower
+            Put32(o, 0xFFFFFFFFu);   // sampleUpper
+        }
+
+        /** Data Format Descriptor básico (Khronos Data Format 1.3, versión 2). */
+        inline std::string Dfd(BlockTexture::Format f, bool supercompressed) {
+            bool bc7 = f == BlockTexture::Format::BC7;
+            uint32_t samples = bc7 ? 1 : 2;
+            std::string d;
+            Put32(d, 4 + 24 + 16 * samples);                              // dfdTotalSize
+            Put32(d, 0);                                                  // vendorId = 0, descriptorType = 0
+            Put32(d, 2 | ((24 + 16 * samples) << 16));                    // versionNumber, descriptorBlockSize
+            // colorModel (BC7 = 134, ETC2 = 161), primaries BT709, transfer lineal, alfa premultiplicado
+            Put32(d, (bc7 ? 134u : 161u) | (1u << 8) | (1u << 16) | (1u << 24));
+            Put32(d, 3 | (3 << 8));                                       // Bloques de 4x4
+            Put32(d, supercompressed ? 0 : 16);                           // bytesPlane0 (0 si va comprimido)
+            Put32(d, 0);
+            if (bc7) {
+                Sample(d, 0, 128, 0);                                     // KHR_DF_CHANNEL_BC7_DATA
+            } else {
+                Sample(d, 0, 64, 15);                                     // KHR_DF_CHANNEL_ETC2_ALPHA
+                Sample(d, 64, 64, 2);                                     // KHR_DF_CHANNEL_ETC2_COLOR
+            }
+            return d;
+        }
+    }
+
+    /**
+     * @param {bool} zlib - Comprime el nivel (supercompressionScheme 3).
+     */
+    inline void Write(const Texture& tex, bool zlib, std::string& out) {
+        using namespace Detail;
+        out.assign((const char*)kIdentifier, 12);
+        Put32(out, VkFormat(tex.format));
+        Put32(out, 1);                          // typeSize
+        Put32(out, tex.width);
+        Put32(out, tex.height);
+        Put32(out, 0);                          // pixelDepth
+        Put32(out, 0);                          // layerCount
+        Put32(out, 1);                          // faceCount
+        Put32(out, 1);                          // levelCount
+        Put32(out, zlib ? kSuperZlib : kSuperNone);
+        size_t index = out.size();
+        out.append(32 + 24, '\0');              // Índice + un nivel; se rellenan al final
+
+        uint32_t dfdAt = (uint32_t)out.size();
+        std::string dfd = Dfd(tex.format, zlib);
+        out += dfd;
+
+        uint32_t kvdAt = (uint32_t)out.size();
+        static const char kKey[] = "KTXwriter";
+        static const char kWriter[] = "GenesisIDE ktxc";
+        Put32(out, (uint32_t)(sizeof(kKey) + sizeof(kWriter)));
+        out.append(kKey, sizeof(kKey));
+        out.append(kWriter, sizeof(kWriter));
+        while (out.size() % 4) out += '\0';
+        uint32_t kvdLength = (uint32_t)out.size() - kvdAt;
+
+        // Sin supercompresión los niveles van alineados al bloque (16); con zlib, a 1
+        if (!zlib) while (out.size() % 16) out += '\0';
+        size_t levelAt = out.size();
+        if (zlib) Png::Detail::Deflate(tex.blocks.data(), tex.blocks.size(), out);
+        else out.append((const char*)tex.blocks.data(), tex.blocks.size());
+
+        Set32(out, index, dfdAt);
+        Set32(out, index + 4, (uint32_t)dfd.size());
+        Set32(out, index + 8, kvdAt);
+        Set32(out, index + 12, kvdLength);
+        // sgd: 0, 0 (ya a cero)
+        Set64(out, index + 32, levelAt);
+        Set64(out, index + 40, out.size() - levelAt);
+        Set64(out, index + 48, tex.blocks.size());
+    }
+
+    /**
+     * Lee lo que escribe Write (un nivel, BC7 o ETC2 RGBA8, sin comprimir o con zlib).
+     */
+    inline bool Read(const void* data, size_t size, Texture& out, std::string* err = nullptr) {
+        using namespace Detail;
+        auto fail = [&](const char* what) { if (err) *err = what; return false; };
+        const uint8_t* p = (const uint8_t*)data;
+        if (size < 80 + 24 || std::memcmp(p, kIdentifier, 12) != 0) return fail("not a ktx2");
+        uint32_t vk = Get32(p + 12), super = Get32(p + 44);
+        if (vk == kVkBc7Unorm) out.format = BlockTexture::Format::BC7;
+        else if (vk == kVkEtc2Rgba8Unorm) out.format = BlockTexture::Format::ETC2;
+        else return fail("unsupported vkFormat");
+        out.width = Get32(p + 20);
+        out.height = Get32(p + 24);
+        if (Get32(p + 40) != 1) return fail("expected one level");
+        if (super != kSuperNone && super != kSuperZlib) return fail("unsupported supercompression");
+        uint64_t at = Get64(p + 80), length = Get64(p + 88), raw = Get64(p + 96);
+        size_t expected = (size_t)BlockTexture::Blocks(out.width) * BlockTexture::Blocks(out.height) * BlockTexture::kBlockBytes;
+        if (at > size || length > size - at || raw != expected) return fail("bad level index");
+        if (super == kSuperZlib) return Png::Detail::Inflate(p + at, (size_t)length, out.blocks, expected, err) || fail("bad zlib level");
+        if (length != expected) return fail("bad level size");
+        out.blocks.assign(p + at, p + at + length);
+        return true;
+    }
+}
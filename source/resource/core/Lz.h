@@ -0,0 +1,120 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+/**
+ * @namespace Lz
+ * @description Compresión LZ77 por bloques (secuencias estilo LZ4: token, literales, offset de
+ * 16 bits y longitud de coincidencia). Pensada para los JSON/XML del juego: descomprime a
+ * velocidad de memcpy y no necesita dependencias.
+ *
+ * Secuencia: token (4 bits literales | 4 bits coincidencia - 4), [extensión de literales con
+ * bytes 255], literales, offset u16, [extensión de coincidencia]. La última secuencia solo
+ * lleva literales.
+ */
+namespace Lz {
+
+    namespace Detail {
+        constexpr size_t kMinMatch = 4;
+        constexpr size_t kLastLiterals = 5;  // Los últimos bytes siempre van como literales
+        constexpr size_t kMaxOffset = 65535;
+        constexpr int kHashBits = 16;
+
+        inline uint32_t Read32(const unsigned char* p) { uint32_t v; std::memcpy(&v, p, 4); return v; }
+        inline uint32_t HashOf(uint32_t v) { return (v * 2654435761u) >> (32 - kHashBits); }
+
+        inline void PutLength(std::string& out, size_t len) {
+            while (len >= 255) { out += (char)255; len -= 255; }
+            out += (char)len;
+        }
+    }
+
+    /**
+     * Comprime `size` bytes de `src` y los añade a `out`.
+     */
+    inline void Compress(const void* src, size_t size, std::string& out) {
+        using namespace Detail;
+        const unsigned char* in = (const unsigned char*)src;
+        const unsigned char* anchor = in;
+        const unsigned char* end = in + size;
+        out.reserve(out.size() + size / 2 + 16);
+
+        auto emit = [&](const unsigned char* lit, size_t litLen, size_t offset, size_t matchLen) {
+            size_t ml = matchLen ? matchLen - kMinMatch : 0;
+            out += (char)(((litLen < 15 ? litLen : 15) << 4) | (ml < 15 ? ml : 15));
+            if (litLen >= 15) PutLength(out, litLen - 15);
+            out.append((const char*)lit, litLen);
+            if (!matchLen) return;
+            out += (char)(offset & 0xFF); out += (char)(offset >> 8);
+            if (ml >= 15) PutLength(out, ml - 15);
+        };
+
+        if (size > kMinMatch + kLastLiterals) {
+            std::vector<uint32_t> table((size_t)1 << kHashBits, 0); // Posición + 1
+            const unsigned char* limit = end - kLastLiterals - kMinMatch;
+            const unsigned char* p = in;
+            while (p <= limit) {
+                uint32_t h = HashOf(Read32(p));
+                const unsigned char* ref = table[h] ? in + table[h] - 1 : nullptr;
+                table[h] = (uint32_t)(p - in) + 1;
+                if (!ref || (size_t)(p - ref) > kMaxOffset || Read32(ref) != Read32(p)) { p++; continue; }
+
+                const unsigned char* m = p + kMinMatch;
+                const unsigned char* r = ref + kMinMatch;
+                const unsigned char* matchEnd = end - kLastLiterals;
+                while (m < matchEnd && *m == *r) { m++; r++; }
+                emit(anchor, (size_t)(p - anchor), (size_t)(p - ref), (size_t)(m - p));
+                // Registra algunas posiciones dentro de la coincidencia para las siguientes búsquedas
+                for (const unsigned char* q = p + 1; q < m && q <= limit; q += 2) table[HashOf(Read32(q))] = (uint32_t)(q - in) + 1;
+                p = anchor = m;
+            }
+        }
+        emit(anchor, (size_t)(end - anchor), 0, 0);
+    }
+
+    /**
+     * Descomprime un bloque completo. Comprueba todos los límites.
+     * @param {size_t} rawSize - Tamaño original (se guarda fuera del bloque).
+     * @returns {bool} false si el bloque está corrupto.
+     */
+    inline bool Decompress(const void* src, size_t size, size_t rawSize, std::string& out) {
+        using namespace Detail;
+        const unsigned char* in = (const unsigned char*)src;
+        const unsigned char* end = in + size;
+        out.resize(rawSize);
+        unsigned char* dst = (unsigned char*)&out[0];
+        size_t pos = 0;
+
+        auto readLength = [&](size_t& len) {
+            unsigned char b;
+            do { if (in >= end) return false; b = *in++; len += b; } while (b == 255);
+            return true;
+        };
+
+        while (in < end) {
+            unsigned char token = *in++;
+            size_t lit = token >> 4;
+            if (lit == 15 && !readLength(lit)) return false;
+            if ((size_t)(end - in) < lit || rawSize - pos < lit) return false;
+            std::memcpy(dst + pos, in, lit);
+            in += lit; pos += lit;
+            if (in == end) break; // Última secuencia
+
+            if (end - in < 2) return false;
+            size_t offset = (size_t)in[0] | ((size_t)in[1] << 8);
+            in += 2;
+            size_t ml = token & 15;
+            if (ml == 15 && !readLength(ml)) return false;
+            ml += kMinMatch;
+            if (offset == 0 || offset > pos || rawSize - pos < ml) return false;
+            // Copia byte a byte cuando se solapa (offset < longitud repite el patrón)
+            const unsigned char* from = dst + pos - offset;
+            if (offset >= ml) std::memcpy(dst + pos, from, ml);
+            else for (size_t i = 0; i < ml; i++) dst[pos + i] = from[i];
+            pos += ml;
+        }
+        return pos == rawSize;
+    }
+}
@@ -0,0 +1,116 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <utility>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/**
+ * @class MappedFile
+ * @description Proyección de solo lectura de un archivo completo en memoria
+ * (CreateFileMapping en Windows, mmap en POSIX). Las páginas se cargan bajo demanda.
+ */
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile() { Close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& o) noexcept { *this = std::move(o); }
+    MappedFile& operator=(MappedFile&& o) noexcept {
+        if (this != &o) {
+            Close();
+            ptr = o.ptr; len = o.len; o.ptr = nullptr; o.len = 0;
+#ifdef _WIN32
+            hFile = o.hFile; hMap = o.hMap; o.hFile = INVALID_HANDLE_VALUE; o.hMap = NULL;
+#endif
+        }
+        return *this;
+    }
+
+    /**
+     * Proyecta el archivo. Un archivo vacío se abre con éxito y Size() == 0.
+     * @returns {bool} false si no existe o no se puede leer.
+     */
+    bool Open(const std::filesystem::path& path) {
+        Close();
+#ifdef _WIN32
+        hFile = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+        if (hFile == INVALID_HANDLE_VALUE) return false;
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(hFile, &size)) { Close(); return false; }
+        len = (size_t)size.QuadPart;
+        if (len == 0) return true;
+        hMap = CreateFileMappingW(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (!hMap) { Close(); return false; }
+        ptr = (const char*)MapViewOfFile(hMap, FILE_MAP_READ, 0, 0, 0);
+        if (!ptr) { Close(); return false; }
+#else
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) { ::close(fd); return false; }
+        len = (size_t)st.st_size;
+        if (len > 0) {
+            void* p = mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p == MAP_FAILED) { ::close(fd); len = 0; return false; }
+            ptr = (const char*)p;
+        }
+        ::close(fd);
+#endif
+        return true;
+    }
+
+    void Close() {
+#ifdef _WIN32
+        if (ptr) UnmapViewOfFile(ptr);
+        if (hMap) CloseHandle(hMap);
+        if (hFile != INVALID_HANDLE_VALUE) CloseHandle(hFile);
+        hMap = NULL; hFile = INVALID_HANDLE_VALUE;
+#else
+        if (ptr) munmap((void*)ptr, len);
+#endif
+        ptr = nullptr; len = 0;
+    }
+
+    /**
+     * Indica al sistema que `[offset, offset+bytes)` se va a leer en orden o ya no se necesita.
+     * En Windows no hace nada: el gestor de memoria recorta el working set por su cuenta.
+     */
+    void AdviseSequential() const {
+#ifndef _WIN32
+        if (ptr) madvise((void*)ptr, len, MADV_SEQUENTIAL);
+#endif
+    }
+
+    void Release(size_t offset, size_t bytes) const {
+#ifndef _WIN32
+        static const size_t page = (size_t)sysconf(_SC_PAGESIZE);
+        size_t start = offset / page * page;
+        size_t end = (offset + bytes) / page * page;
+        if (ptr && end > start) madvise((void*)(ptr + start), end - start, MADV_DONTNEED);
+#else
+        (void)offset; (void)bytes;
+#endif
+    }
+
+    const char* Data() const { return ptr; }
+    size_t Size() const { return len; }
+
+private:
+    const char* ptr = nullptr;
+    size_t len = 0;
+#ifdef _WIN32
+    HANDLE hFile = INVALID_HANDLE_VALUE;
+    HANDLE hMap = NULL;
+#endif
+};
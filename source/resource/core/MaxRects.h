@@ -0,0 +1,101 @@
+#pragma once
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @namespace MaxRects
+ * @description Empaquetado de rectángulos en una textura (MaxRects, regla "best short side fit",
+ * sin rotar). Se guarda la lista de huecos libres máximos; cada inserción parte los huecos que
+ * pisa y descarta los que quedan contenidos en otros.
+ */
+namespace MaxRects {
+
+    struct Rect {
+        int x = 0, y = 0, w = 0, h = 0;
+
+        bool Contains(const Rect& o) const { return o.x >= x && o.y >= y && o.x + o.w <= x + w && o.y + o.h <= y + h; }
+        bool Overlaps(const Rect& o) const { return o.x < x + w && o.x + o.w > x && o.y < y + h && o.y + o.h > y; }
+    };
+
+    /**
+     * @class Bin
+     * @description Una textura de `width` x `height`. Se puede copiar para probar una inserción
+     * en grupo y descartarla si no cabe entera.
+     */
+    class Bin {
+    public:
+        Bin(int width = 0, int height = 0) : width(width), height(height) {
+            if (width > 0 && height > 0) free.push_back({ 0, 0, width, height });
+        }
+
+        int Width() const { return width; }
+        int Height() const { return height; }
+        uint64_t UsedArea() const { return used; }
+        /** Esquina inferior derecha de lo ocupado (para recortar la textura final). */
+        int Right() const { return right; }
+        int Bottom() const { return bottom; }
+
+        /**
+         * Coloca un rectángulo de w x h.
+         * @returns {bool} false si no hay hueco.
+         */
+        bool Insert(int w, int h, Rect& out) {
+            int bestShort = INT_MAX, bestLong = INT_MAX;
+            bool found = false;
+            for (const Rect& f : free) {
+                if (f.w < w || f.h < h) continue;
+                int dw = f.w - w, dh = f.h - h;
+                int s = std::min(dw, dh), l = std::max(dw, dh);
+                if (s < bestShort || (s == bestShort && l < bestLong)) {
+                    bestShort = s; bestLong = l;
+                    out = { f.x, f.y, w, h };
+                    found = true;
+                }
+            }
+            if (!found) return false;
+            Place(out);
+            return true;
+        }
+
+    private:
+        int width, height;
+        uint64_t used = 0;
+        int right = 0, bottom = 0;
+        std::vector<Rect> free;
+
+        void Place(const Rect& r) {
+            std::vector<Rect> fresh;
+            for (size_t i = 0; i < free.size();) {
+                const Rect f = free[i];
+                if (!f.Overlaps(r)) { i++; continue; }
+                // Hasta cuatro huecos máximos alrededor del rectángulo colocado
+                if (r.x > f.x) fresh.push_back({ f.x, f.y, r.x - f.x, f.h });
+                if (r.x + r.w < f.x + f.w) fresh.push_back({ r.x + r.w, f.y, f.x + f.w - r.x - r.w, f.h });
+                if (r.y > f.y) fresh.push_back({ f.x, f.y, f.w, r.y - f.y });
+                if (r.y + r.h < f.y + f.h) fresh.push_back({ f.x, r.y + r.h, f.w, f.y + f.h - r.y - r.h });
+                free[i] = free.back();
+                free.pop_back();
+            }
+            // Solo los huecos nuevos pueden estar contenidos en otros (o contener a uno viejo no,
+            // porque nacen dentro de un hueco que acaba de partirse)
+            std::vector<Rect> keep;
+            keep.reserve(fresh.size());
+            for (size_t i = 0; i < fresh.size(); i++) {
+                bool inside = false;
+                for (const Rect& f : free) if (f.Contains(fresh[i])) { inside = true; break; }
+                for (size_t j = 0; j < fresh.size() && !inside; j++) {
+                    if (j == i || !fresh[j].Contains(fresh[i])) continue;
+                    // Iguales: se queda el primero
+                    inside = !(fresh[i].Contains(fresh[j]) && i < j);
+                }
+                if (!inside) keep.push_back(fresh[i]);
+            }
+            free.insert(free.end(), keep.begin(), keep.end());
+            used += (uint64_t)r.w * r.h;
+            right = std::max(right, r.x + r.w);
+            bottom = std::max(bottom, r.y + r.h);
+        }
+    };
+}
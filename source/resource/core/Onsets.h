@@ -0,0 +1,705 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "AssetPack.h"
+#include "AtomicFile.h"
+#include "MappedFile.h"
+#include "Vorbis.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define GENESIS_ONSETS_SSE2 1
+#endif
+
+/**
+ * @namespace Onsets
+ * @description Análisis de ritmo de las pistas de una canción para sugerir notas y BPM en el editor.
+ *
+ * Cada .ogg se decodifica una vez y se reduce a 100 frames por segundo (ventana Hann de ~46 ms,
+ * FFT real con mariposas SSE2):
+ *   - curva de flujo espectral de banda ancha (30 Hz - 16 kHz): de ella sale el tempo y la fase
+ *   - onsets de la voz: flujo SuperFlux (100 Hz - 5 kHz, máximo en frecuencia contra el frame t-2,
+ *     que ignora el vibrato), umbral adaptativo y puerta de silencio; con la altura (HPS) y la
+ *     duración aproximada de cada uno
+ * El resultado se guarda en disco (.gons) con el hash del .ogg. La cuantización a la rejilla del
+ * BPM y la elección de carril se hacen al pedir las sugerencias, que es barato.
+ *
+ * Formato (little-endian):
+ *   [0]  "GONS" | u16 versión | u16 reservado | u32 sampleRate | u32 fps | u64 muestras
+ *        | u64 hash del .ogg | u32 frames de la curva | u32 onsets            (40 bytes)
+ *   curva: u16 por frame (0..65535 = 0..1)
+ *   onsets: f32 tiempo ms | f32 fuerza | f32 altura Hz (0 = sin altura) | f32 duración ms
+ */
+namespace Onsets {
+
+    constexpr uint16_t kVersion = 1;
+    constexpr size_t kHeaderSize = 40;
+    constexpr int kFps = 100;
+
+    namespace Detail {
+        using AssetPack::Detail::Put16;
+        using AssetPack::Detail::Put32;
+        using AssetPack::Detail::Put64;
+        using AssetPack::Detail::Get16;
+        using AssetPack::Detail::Get32;
+        using AssetPack::Detail::Get64;
+
+        constexpr double kPi = 3.14159265358979323846;
+
+        inline void PutFloat(std::string& o, float v) { uint32_t u; std::memcpy(&u, &v, 4); Put32(o, u); }
+        inline float GetFloat(const unsigned char* p) { uint32_t u = Get32(p); float v; std::memcpy(&v, &u, 4); return v; }
+
+        /** Percentil `p` (0..1) de una copia de `v`. */
+        inline float Percentile(std::vector<float> v, double p) {
+            if (v.empty()) return 0.0f;
+            size_t k = std::min(v.size() - 1, (size_t)(p * (double)v.size()));
+            std::nth_element(v.begin(), v.begin() + (ptrdiff_t)k, v.end());
+            return v[k];
+        }
+
+        /** Valor de `v` en una posición fraccionaria (interpolación lineal, 0 fuera). */
+        inline float At(const std::vector<float>& v, double x) {
+            if (x < 0) return 0.0f;
+            size_t i = (size_t)x;
+            if (i + 1 >= v.size()) return i < v.size() ? v[i] : 0.0f;
+            float f = (float)(x - (double)i);
+            return v[i] + (v[i + 1] - v[i]) * f;
+        }
+
+        /**
+         * Suavizado binomial [1 4 6 4 1] / 16. Los picos del flujo duran un frame; sin suavizar,
+         * leerlos en posiciones fraccionarias pierde más o menos energía según caiga la rejilla.
+         */
+        inline std::vector<float> Smooth(const std::vector<float>& v) {
+            static const float k[5] = { 1 / 16.0f, 4 / 16.0f, 6 / 16.0f, 4 / 16.0f, 1 / 16.0f };
+            std::vector<float> out(v.size(), 0.0f);
+            for (size_t t = 0; t < v.size(); t++) {
+                float s = 0;
+                for (int j = -2; j <= 2; j++) {
+                    if ((ptrdiff_t)t + j >= 0 && t + j < v.size()) s += k[j + 2] * v[t + j];
+                }
+                out[t] = s;
+            }
+            return out;
+        }
+
+        /** Fase (frames, pasos de medio frame) que más energía de `x` recoge con un periodo dado. */
+        inline double Align(const std::vector<float>& x, double period, double& score) {
+            double phase = 0;
+            score = -1;
+            int steps = std::max(1, (int)std::ceil(period * 2));
+            for (int p = 0; p < steps; p++) {
+                double ph = p * 0.5, s = 0;
+                for (double at = ph; at < (double)x.size(); at += period) s += At(x, at);
+                if (s > score) { score = s; phase = ph; }
+            }
+            return phase;
+        }
+    }
+
+    /**
+     * @class Fft
+     * @description FFT compleja radix-2 en sitio, con las partes real e imaginaria en arrays
+     * separados. Los giros de cada etapa están contiguos, así que las etapas con 4 o más
+     * mariposas por grupo van de cuatro en cuatro con SSE2.
+     */
+    class Fft {
+    public:
+        /** @param {size_t} points - Potencia de dos. */
+        void Init(size_t points) {
+            n = points;
+            int bits = 0;
+            while (((size_t)1 << bits) < n) bits++;
+            rev.resize(n);
+            for (size_t i = 0; i < n; i++) {
+                size_t r = 0;
+                for (int b = 0; b < bits; b++) if ((i >> b) & 1) r |= (size_t)1 << (bits - 1 - b);
+                rev[i] = (uint32_t)r;
+            }
+            // La etapa de semitamaño h usa cr/ci[h + j], j < h
+            cr.assign(std::max<size_t>(n, 2), 0.0f);
+            ci.assign(std::max<size_t>(n, 2), 0.0f);
+            for (size_t h = 1; h < n; h <<= 1) {
+                for (size_t j = 0; j < h; j++) {
+                    double a = -Detail::kPi * (double)j / (double)h;
+                    cr[h + j] = (float)std::cos(a);
+                    ci[h + j] = (float)std::sin(a);
+                }
+            }
+        }
+
+        size_t Size() const { return n; }
+
+        void Forward(float* re, float* im) const { Run<true>(re, im); }
+        /** Mismo resultado sin SIMD (para comprobar la versión rápida). */
+        void ForwardScalar(float* re, float* im) const { Run<false>(re, im); }
+
+    private:
+        size_t n = 0;
+        std::vector<uint32_t> rev;
+        std::vector<float> cr, ci;
+
+        template <bool Simd>
+        void Run(float* re, float* im) const {
+            for (size_t i = 0; i < n; i++) {
+                size_t r = rev[i];
+                if (r > i) { std::swap(re[i], re[r]); std::swap(im[i], im[r]); }
+            }
+            for (size_t h = 1; h < n; h <<= 1) {
+                const float* wr = cr.data() + h;
+                const float* wi = ci.data() + h;
+                for (size_t base = 0; base < n; base += 2 * h) {
+                    float* ar = re + base; float* ai = im + base;
+                    float* br = ar + h; float* bi = ai + h;
+                    size_t j = 0;
+#ifdef GENESIS_ONSETS_SSE2
+                    if constexpr (Simd) {
+                        for (; j + 4 <= h; j += 4) {
+                            __m128 xr = _mm_loadu_ps(br + j), xi = _mm_loadu_ps(bi + j);
+                            __m128 c = _mm_loadu_ps(wr + j), s = _mm_loadu_ps(wi + j);
+                            __m128 tr = _mm_sub_ps(_mm_mul_ps(xr, c), _mm_mul_ps(xi, s));
+                            __m128 ti = _mm_add_ps(_mm_mul_ps(xr, s), _mm_mul_ps(xi, c));
+                            __m128 yr = _mm_loadu_ps(ar + j), yi = _mm_loadu_ps(ai + j);
+                            _mm_storeu_ps(br + j, _mm_sub_ps(yr, tr));
+                            _mm_storeu_ps(bi + j, _mm_sub_ps(yi, ti));
+                            _mm_storeu_ps(ar + j, _mm_add_ps(yr, tr));
+                            _mm_storeu_ps(ai + j, _mm_add_ps(yi, ti));
+                        }
+                    }
+#endif
+                    for (; j < h; j++) {
+                        float tr = br[j] * wr[j] - bi[j] * wi[j];
+                        float ti = br[j] * wi[j] + bi[j] * wr[j];
+                        br[j] = ar[j] - tr; bi[j] = ai[j] - ti;
+                        ar[j] += tr; ai[j] += ti;
+                    }
+                }
+            }
+        }
+    };
+
+    /**
+     * @class RealFft
+     * @description Magnitudes del espectro de una señal real de n muestras con una FFT compleja
+     * de n/2 (muestras pares e impares como parte real e imaginaria).
+     */
+    class RealFft {
+    public:
+        void Init(size_t size) {
+            n = size;
+            half.Init(n / 2);
+            zr.assign(n / 2, 0.0f); zi.assign(n / 2, 0.0f);
+            tr.resize(n / 2); ti.resize(n / 2);
+            for (size_t k = 0; k < n / 2; k++) {
+                double a = -2.0 * Detail::kPi * (double)k / (double)n;
+                tr[k] = (float)std::cos(a); ti[k] = (float)std::sin(a);
+            }
+        }
+
+        size_t Size() const { return n; }
+
+        /** |X[k]| para k = 0..n/2 (n/2 + 1 valores). */
+        void Magnitudes(const float* x, float* mag, bool simd = true) {
+            size_t m = n / 2;
+            for (size_t i = 0; i < m; i++) { zr[i] = x[2 * i]; zi[i] = x[2 * i + 1]; }
+            if (simd) half.Forward(zr.data(), zi.data());
+            else half.ForwardScalar(zr.data(), zi.data());
+            mag[0] = std::fabs(zr[0] + zi[0]);
+            mag[m] = std::fabs(zr[0] - zi[0]);
+            for (size_t k = 1; k < m; k++) {
+                // X[k] = E[k] + W^k O[k], con E y O los espectros de pares e impares
+                float ar = zr[k], ai = zi[k], br = zr[m - k], bi = -zi[m - k];
+                float er = 0.5f * (ar + br), ei = 0.5f * (ai + bi);
+                float or_ = 0.5f * (ai - bi), oi = -0.5f * (ar - br);
+                float xr = er + tr[k] * or_ - ti[k] * oi;
+                float xi = ei + tr[k] * oi + ti[k] * or_;
+                mag[k] = std::sqrt(xr * xr + xi * xi);
+            }
+        }
+
+    private:
+        size_t n = 0;
+        Fft half;
+        std::vector<float> zr, zi, tr, ti;
+    };
+
+    /** Un onset de la voz, sin cuantizar. */
+    struct Onset {
+        float timeMs = 0;
+        float strength = 0;     // Cuánto supera el umbral (relativo a la canción)
+        float pitchHz = 0;      // 0 = sin altura clara
+        float sustainMs = 0;    // Cuánto se mantiene la energía
+    };
+
+    /** Lo que se guarda de cada .ogg. */
+    struct Analysis {
+        uint32_t sampleRate = 0;
+        uint64_t frames = 0;
+        uint64_t hash = 0;
+        std::vector<float> curve;       // Flujo de banda ancha, kFps por segundo, 0..1
+        std::vector<Onset> onsets;
+
+        double DurationMs() const { return sampleRate ? 1000.0 * (double)frames / sampleRate : 0.0; }
+    };
+
+    struct Tempo {
+        double bpm = 0;
+        double phaseMs = 0;     // Primer pulso, en [0, 60000 / bpm)
+        double confidence = 0;  // 0..1: cuánto destaca el BPM elegido sobre el resto
+    };
+
+    /** Nota sugerida, ya en la rejilla. */
+    struct Note {
+        double timeMs = 0;
+        int lane = 0;           // 0 izquierda, 1 abajo, 2 arriba, 3 derecha
+        double sustainMs = 0;
+        float strength = 0;
+    };
+
+    /**
+     * Elige los onsets de la curva de voz. Pico local en ±30 ms que supere la media de su
+     * entorno (-100 / +70 ms) más un margen proporcional al flujo típico de la canción, con
+     * al menos 50 ms entre onsets y energía por encima de la puerta de silencio que no esté cayendo.
+     */
+    inline std::vector<Onset> PickOnsets(const std::vector<float>& flux, const std::vector<float>& rms, const std::vector<float>& pitch) {
+        constexpr int kPeak = 3, kBefore = 10, kAfter = 7, kMinGap = 5;
+        constexpr float kSilenceDb = -30.0f;
+        constexpr float kDelta = 0.6f;          // Margen sobre la media local, en medianas del flujo activo
+        constexpr int kLatencyFrames = 1;       // El pico del flujo llega ~1 frame después del ataque
+        std::vector<Onset> out;
+        size_t T = flux.size();
+        if (T < 2 * kPeak + 1) return out;
+
+        float loud = Detail::Percentile(rms, 0.95);
+        float gate = loud * std::pow(10.0f, kSilenceDb / 20.0f);
+        std::vector<float> active;
+        for (size_t t = 0; t < T; t++) if (rms[t] >= gate && flux[t] > 0) active.push_back(flux[t]);
+        float typical = Detail::Percentile(active, 0.5);
+        if (typical <= 0) return out;
+        float delta = kDelta * typical;
+
+        // Media móvil con suma prefija
+        std::vector<double> prefix(T + 1, 0.0);
+        for (size_t t = 0; t < T; t++) prefix[t + 1] = prefix[t] + flux[t];
+
+        int last = -kMinGap;
+        std::vector<size_t> picked;
+        for (size_t t = kPeak; t + kPeak < T; t++) {
+            float v = flux[t];
+            bool peak = true;
+            for (size_t k = t - kPeak; k <= t + kPeak && peak; k++) peak = flux[k] <= v;
+            if (!peak) continue;
+            size_t a = t >= (size_t)kBefore ? t - kBefore : 0, b = std::min(T, t + kAfter + 1);
+            float mean = (float)((prefix[b] - prefix[a]) / (double)(b - a));
+            if (v < mean + delta) continue;
+            float energy = 0, before = 0;
+            for (size_t k = t + 1; k < std::min(T, t + 4); k++) energy = std::max(energy, rms[k]);
+            for (size_t k = t >= 5 ? t - 5 : 0; k < t; k++) before = std::max(before, rms[k]);
+            // Sin energía, o cayendo: el final de una nota también mueve el espectro
+            if (energy < gate || energy < 0.5f * before) continue;
+            if ((int)t - last < kMinGap) {
+                // Dos picos muy juntos: se queda el más fuerte
+                if (!picked.empty() && v > flux[picked.back()]) { picked.back() = t; last = (int)t; }
+                continue;
+            }
+            picked.push_back(t);
+            last = (int)t;
+        }
+
+        for (size_t i = 0; i < picked.size(); i++) {
+            size_t t = picked[i];
+            size_t end = i + 1 < picked.size() ? picked[i + 1] : T;
+            Onset o;
+            o.timeMs = (float)((double)((int)t - kLatencyFrames) * 1000.0 / kFps);
+            if (o.timeMs < 0) o.timeMs = 0;
+            size_t a = t >= (size_t)kBefore ? t - kBefore : 0, b = std::min(T, t + kAfter + 1);
+            float mean = (float)((prefix[b] - prefix[a]) / (double)(b - a));
+            o.strength = (flux[t] - mean) / typical;
+            // Altura: mediana de los primeros 60 ms con energía
+            std::vector<float> ps;
+            for (size_t k = t; k < std::min(end, t + 6); k++) if (pitch[k] > 0 && rms[k] >= gate) ps.push_back(pitch[k]);
+            o.pitchHz = ps.empty() ? 0.0f : Detail::Percentile(ps, 0.5);
+            // Duración: mientras la energía siga por encima de la mitad del pico del ataque
+            float peakRms = 0;
+            for (size_t k = t; k < std::min(end, t + 4); k++) peakRms = std::max(peakRms, rms[k]);
+            size_t e = t;
+            while (e + 1 < end && rms[e + 1] >= 0.5f * peakRms) e++;
+            o.sustainMs = (float)((double)(e - t) * 1000.0 / kFps);
+            out.push_back(o);
+        }
+        return out;
+    }
+
+    /**
+     * @class Analyzer
+     * @description Recibe el PCM del decodificador por tramos (como Peaks::Builder) y saca
+     * las curvas a kFps frames por segundo. El frame t está centrado en t / kFps segundos.
+     */
+    class Analyzer {
+    public:
+        Analyzer(int channels, uint32_t sampleRate) : channels(std::max(1, channels)), rate(std::max(1u, sampleRate)) {
+            size = rate >= 32000 ? 2048 : 1024;
+            fft.Init(size);
+            window.resize(size);
+            for (size_t i = 0; i < size; i++) window[i] = (float)(0.5 - 0.5 * std::cos(2.0 * Detail::kPi * (double)i / (double)size));
+            frame.resize(size);
+            bins = size / 2 + 1;
+            mag.resize(bins); cur.assign(bins, 0.0f); prev.assign(bins, 0.0f);
+            hist[0].assign(bins, 0.0f); hist[1].assign(bins, 0.0f);
+            double binHz = (double)rate / (double)size;
+            auto bin = [&](double hz) { return std::min(bins - 1, (size_t)std::lround(hz / binHz)); };
+            fullLo = std::max<size_t>(1, bin(30)); fullHi = bin(16000);
+            vocalLo = std::max<size_t>(1, bin(100)); vocalHi = bin(5000);
+            pitchLo = std::max<size_t>(2, bin(80)); pitchHi = std::min(bin(1000), (bins - 2) / 3);
+            this->binHz = (float)binHz;
+            // Medio frame de silencio delante: el frame 0 queda centrado en la muestra 0
+            buf.assign(size / 2, 0.0f);
+            bufStart = -(int64_t)(size / 2);
+        }
+
+        void Push(const float* const* pcm, size_t count) {
+            size_t old = buf.size();
+            buf.resize(old + count);
+            float scale = 1.0f / (float)channels;
+            for (size_t i = 0; i < count; i++) {
+                float s = 0;
+                for (int c = 0; c < channels; c++) s += pcm[c][i];
+                buf[old + i] = s * scale;
+            }
+            total += count;
+            Drain(UINT64_MAX);
+        }
+
+        Analysis Finish(uint64_t contentHash) {
+            buf.resize(buf.size() + size / 2, 0.0f);
+            Drain(total * kFps / rate + 1);
+            Analysis a;
+            a.sampleRate = rate;
+            a.frames = total;
+            a.hash = contentHash;
+            float top = Detail::Percentile(full, 0.99);
+            a.curve.resize(full.size());
+            for (size_t t = 0; t < full.size(); t++) a.curve[t] = top > 0 ? std::min(1.0f, full[t] / top) : 0.0f;
+            a.onsets = PickOnsets(vocal, rms, pitch);
+            return a;
+        }
+
+        uint64_t Frames() const { return total; }
+
+    private:
+        int channels;
+        uint32_t rate;
+        size_t size, bins;
+        RealFft fft;
+        std::vector<float> window, frame, mag, cur, prev, hist[2];
+        size_t fullLo, fullHi, vocalLo, vocalHi, pitchLo, pitchHi;
+        float binHz;
+        std::vector<float> buf;         // Mezcla mono pendiente; buf[0] es la muestra bufStart
+        int64_t bufStart;
+        uint64_t total = 0, next = 0;
+        std::vector<float> full, vocal, rms, pitch;
+
+        int64_t Center(uint64_t t) const { return (int64_t)((t * rate + kFps / 2) / kFps); }
+
+        void Drain(uint64_t limit) {
+            while (next < limit) {
+                int64_t begin = Center(next) - (int64_t)(size / 2);
+                if (begin + (int64_t)size > bufStart + (int64_t)buf.size()) break;
+                Process(buf.data() + (begin - bufStart));
+                next++;
+                // Se descarta lo ya consumido de vez en cuando, no en cada frame
+                int64_t keep = Center(next) - (int64_t)(size / 2);
+                if (keep - bufStart > 65536) {
+                    buf.erase(buf.begin(), buf.begin() + (keep - bufStart));
+                    bufStart = keep;
+                }
+            }
+        }
+
+        void Process(const float* x) {
+            // Energía del cuarto central de la ventana: más corta que la FFT, marca bien ataques y finales
+            double sq = 0;
+            for (size_t i = 0; i < size; i++) frame[i] = x[i] * window[i];
+            for (size_t i = size * 3 / 8; i < size * 5 / 8; i++) sq += (double)x[i] * x[i];
+            fft.Magnitudes(frame.data(), mag.data());
+            // Magnitud en unidades de amplitud (un seno de amplitud A da ~A) y compresión logarítmica
+            float scale = 100.0f * 4.0f / (float)size;
+            for (size_t k = 0; k < bins; k++) cur[k] = std::log1p(scale * mag[k]);
+
+            size_t t = full.size();
+            float f = 0;
+            if (t > 0) for (size_t k = fullLo; k <= fullHi; k++) f += std::max(0.0f, cur[k] - prev[k]);
+            float v = 0;
+            std::vector<float>& ref = hist[t & 1];  // Frame t-2, con máximo en frecuencia
+            if (t > 1) for (size_t k = vocalLo; k <= vocalHi; k++) v += std::max(0.0f, cur[k] - ref[k]);
+            for (size_t k = 0; k < bins; k++) {
+                float m = cur[k];
+                if (k > 0) m = std::max(m, cur[k - 1]);
+                if (k + 1 < bins) m = std::max(m, cur[k + 1]);
+                ref[k] = m;
+            }
+
+            float r = (float)std::sqrt(sq / (double)(size / 4));
+            float hz = 0;
+            if (r > 1e-4f) {
+                // Producto armónico (suma de logaritmos de 1f, 2f y 3f) con interpolación parabólica
+                auto score = [&](size_t k) { return cur[k] + cur[2 * k] + cur[3 * k]; };
+                size_t best = pitchLo;
+                float bestScore = score(pitchLo);
+                for (size_t k = pitchLo + 1; k <= pitchHi; k++) {
+                    float s = score(k);
+                    if (s > bestScore) { bestScore = s; best = k; }
+                }
+                float offset = 0;
+                if (best > pitchLo && best < pitchHi) {
+                    float l = score(best - 1), rr = score(best + 1), d = l - 2 * bestScore + rr;
+                    if (d < 0) offset = 0.5f * (l - rr) / d;
+                }
+                hz = ((float)best + offset) * binHz;
+            }
+
+            full.push_back(f);
+            vocal.push_back(v);
+            rms.push_back(r);
+            pitch.push_back(hz);
+            std::swap(cur, prev);
+        }
+    };
+
+    /**
+     * Tempo de una curva de flujo. Autocorrelación de la curva sin su media local, peine de
+     * cuatro armónicos por BPM candidato y, alrededor del mejor, búsqueda fina (0,01 BPM) del
+     * BPM y la fase que más energía recogen en los pulsos a lo largo de toda la canción.
+     * El peine se pondera con un prior log-normal (150 BPM, una octava de desviación): entre un
+     * tempo y su mitad el peine casi empata, y los charts del juego van de 95 a 190 BPM.
+     * Si un BPM entero recoge casi lo mismo (98%), se prefiere: las canciones se hacen en un
+     * DAW con BPM redondo.
+     */
+    inline Tempo EstimateTempo(const std::vector<float>& curve, double minBpm = 70, double maxBpm = 210) {
+        Tempo out;
+        size_t T = curve.size();
+        if (T < (size_t)kFps * 4) return out;
+
+        // Sin la media local (±250 ms) y rectificada: solo cuenta lo que sobresale
+        constexpr int kMean = 25;
+        constexpr double kPriorBpm = 150.0, kPriorOctaves = 1.0;
+        std::vector<double> prefix(T + 1, 0.0);
+        for (size_t t = 0; t < T; t++) prefix[t + 1] = prefix[t] + curve[t];
+        std::vector<float> x(T);
+        for (size_t t = 0; t < T; t++) {
+            size_t a = t >= (size_t)kMean ? t - kMean : 0, b = std::min(T, t + kMean + 1);
+            x[t] = std::max(0.0f, curve[t] - (float)((prefix[b] - prefix[a]) / (double)(b - a)));
+        }
+
+        size_t maxLag = std::min(T - 1, (size_t)std::ceil(4.0 * 60.0 * kFps / minBpm) + 2);
+        std::vector<float> ac(maxLag + 1, 0.0f);
+        for (size_t lag = 1; lag <= maxLag; lag++) {
+            double s = 0;
+            const float* a = x.data();
+            const float* b = x.data() + lag;
+            size_t n = T - lag;
+            for (size_t i = 0; i < n; i++) s += (double)a[i] * b[i];
+            ac[lag] = (float)(s / (double)n);
+        }
+
+        auto comb = [&](double bpm) {
+            double lag = 60.0 * kFps / bpm, s = 0;
+            for (int m = 1; m <= 4; m++) s += Detail::At(ac, lag * m);
+            return s;
+        };
+        double bestBpm = 0, bestScore = -1, sum = 0;
+        int count = 0;
+        for (double bpm = minBpm; bpm <= maxBpm + 1e-9; bpm += 0.5) {
+            double octaves = std::log2(bpm / kPriorBpm) / kPriorOctaves;
+            double s = comb(bpm) * std::exp(-0.5 * octaves * octaves);
+            sum += s; count++;
+            if (s > bestScore) { bestScore = s; bestBpm = bpm; }
+        }
+        if (bestScore <= 0) return out;
+
+        // Energía en los pulsos de toda la canción para un BPM, con la mejor fase
+        std::vector<float> xs = Detail::Smooth(x);
+        double fineBpm = bestBpm, finePhase = 0, fineScore = -1;
+        for (int i = -100; i <= 100; i++) {
+            double bpm = bestBpm + i * 0.01, s = 0;
+            double ph = Detail::Align(xs, 60.0 * kFps / bpm, s);
+            if (s > fineScore) { fineScore = s; fineBpm = bpm; finePhase = ph; }
+        }
+        double round = std::round(fineBpm), roundScore = 0;
+        if (std::fabs(round - fineBpm) > 1e-9) {
+            double roundPhase = Detail::Align(xs, 60.0 * kFps / round, roundScore);
+            if (roundScore >= 0.98 * fineScore) { fineBpm = round; finePhase = roundPhase; }
+        }
+
+        out.bpm = fineBpm;
+        out.phaseMs = finePhase * 1000.0 / kFps;
+        double mean = sum / count;
+        out.confidence = std::max(0.0, std::min(1.0, (bestScore - mean) / bestScore));
+        return out;
+    }
+
+    /** Fase (ms, en [0, pulso)) que más energía recoge para un BPM ya conocido. */
+    inline double EstimatePhase(const std::vector<float>& curve, double bpm) {
+        if (bpm <= 0 || curve.empty()) return 0.0;
+        double score = 0;
+        return Detail::Align(Detail::Smooth(curve), 60.0 * kFps / bpm, score) * 1000.0 / kFps;
+    }
+
+    /**
+     * Lleva los onsets a la rejilla (`subdivision` partes por pulso; 4 = semicorcheas) y elige
+     * carril por altura: la misma nota que la anterior (±1 semitono) repite carril; si no, el
+     * cuartil de altura de la pista da abajo < izquierda < derecha < arriba, y si cambia la
+     * altura pero tocaría el mismo carril, se mueve uno en la dirección del cambio.
+     * Las duraciones de menos de dos pasos quedan en 0 (nota corta).
+     */
+    inline std::vector<Note> Suggest(const std::vector<Onset>& onsets, double bpm, double phaseMs, int subdivision = 4) {
+        static const int kByPitch[4] = { 1, 0, 3, 2 };
+        std::vector<Note> out;
+        if (bpm <= 0 || subdivision <= 0) return out;
+        double step = 60000.0 / bpm / subdivision;
+        std::vector<float> pitches;
+        for (const Onset& o : onsets) if (o.pitchHz > 0) pitches.push_back(o.pitchHz);
+        float q1 = Detail::Percentile(pitches, 0.25), q2 = Detail::Percentile(pitches, 0.5), q3 = Detail::Percentile(pitches, 0.75);
+        auto rankOf = [&](float hz) { return hz < q1 ? 0 : hz < q2 ? 1 : hz < q3 ? 2 : 3; };
+
+        int64_t lastSlot = INT64_MIN;
+        float lastPitch = 0;
+        int lastRank = 1;
+        for (const Onset& o : onsets) {
+            int64_t slot = (int64_t)std::llround(((double)o.timeMs - phaseMs) / step);
+            double t = phaseMs + (double)slot * step;
+            if (t < 0) continue;
+            if (slot == lastSlot) {
+                // Dos onsets en la misma casilla: se queda el más fuerte
+                if (o.strength > out.back().strength) out.back().strength = o.strength;
+                continue;
+            }
+            int rank = lastRank;
+            if (o.pitchHz > 0) {
+                double semis = lastPitch > 0 ? 12.0 * std::log2(o.pitchHz / lastPitch) : 99.0;
+                if (std::fabs(semis) >= 1.0) {
+                    rank = rankOf(o.pitchHz);
+                    if (rank == lastRank && lastPitch > 0) rank = semis > 0 ? (rank < 3 ? rank + 1 : rank - 1) : (rank > 0 ? rank - 1 : rank + 1);
+                }
+                lastPitch = o.pitchHz;
+            }
+            Note n;
+            n.timeMs = t;
+            n.lane = kByPitch[rank];
+            double steps = std::floor((double)o.sustainMs / step);
+            n.sustainMs = steps >= 2 ? steps * step : 0.0;
+            n.strength = o.strength;
+            out.push_back(n);
+            lastSlot = slot;
+            lastRank = rank;
+        }
+        return out;
+    }
+
+    inline std::string Serialize(const Analysis& a) {
+        std::string o;
+        o.reserve(kHeaderSize + a.curve.size() * 2 + a.onsets.size() * 16);
+        o.append("GONS", 4);
+        Detail::Put16(o, kVersion); Detail::Put16(o, 0);
+        Detail::Put32(o, a.sampleRate); Detail::Put32(o, kFps);
+        Detail::Put64(o, a.frames); Detail::Put64(o, a.hash);
+        Detail::Put32(o, (uint32_t)a.curve.size()); Detail::Put32(o, (uint32_t)a.onsets.size());
+        for (float v : a.curve) Detail::Put16(o, (uint32_t)std::lround(std::min(1.0f, std::max(0.0f, v)) * 65535.0f));
+        for (const Onset& n : a.onsets) {
+            Detail::PutFloat(o, n.timeMs); Detail::PutFloat(o, n.strength);
+            Detail::PutFloat(o, n.pitchHz); Detail::PutFloat(o, n.sustainMs);
+        }
+        return o;
+    }
+
+    inline bool Parse(const char* bytes, size_t size, Analysis& a, uint64_t expectHash = 0) {
+        const unsigned char* p = (const unsigned char*)bytes;
+        if (size < kHeaderSize || std::memcmp(p, "GONS", 4) != 0 || Detail::Get16(p + 4) != kVersion) return false;
+        if (Detail::Get32(p + 12) != (uint32_t)kFps) return false;
+        uint64_t hash = Detail::Get64(p + 24);
+        uint32_t curveLen = Detail::Get32(p + 32), count = Detail::Get32(p + 36);
+        if ((expectHash && hash != expectHash) || kHeaderSize + 2ull * curveLen + 16ull * count != size) return false;
+        a.sampleRate = Detail::Get32(p + 8);
+        a.frames = Detail::Get64(p + 16);
+        a.hash = hash;
+        p += kHeaderSize;
+        a.curve.resize(curveLen);
+        for (uint32_t i = 0; i < curveLen; i++, p += 2) a.curve[i] = (float)Detail::Get16(p) / 65535.0f;
+        a.onsets.resize(count);
+        for (uint32_t i = 0; i < count; i++, p += 16) {
+            Onset& n = a.onsets[i];
+            n.timeMs = Detail::GetFloat(p); n.strength = Detail::GetFloat(p + 4);
+            n.pitchHz = Detail::GetFloat(p + 8); n.sustainMs = Detail::GetFloat(p + 12);
+        }
+        return true;
+    }
+
+    /**
+     * Decodifica un .ogg ya en memoria y lo analiza.
+     * @returns {bool} false si no es Vorbis (ver `err`).
+     */
+    inline bool Build(const char* ogg, size_t size, uint64_t hash, Analysis& out, std::string* err = nullptr) {
+        Vorbis::Decoder dec;
+        if (!dec.Open(ogg, size, err)) return false;
+        Analyzer a(dec.Channels(), dec.SampleRate());
+        dec.Decode([&a](const float* const* pcm, size_t frames) { a.Push(pcm, frames); });
+        if (a.Frames() == 0) { if (err) *err = "no audio"; return false; }
+        out = a.Finish(hash);
+        return true;
+    }
+
+    /**
+     * @class Cache
+     * @description Análisis por hash del .ogg en `dir/<hash>.gons`. Si el audio no cambió no se
+     * vuelve a decodificar; sin carpeta (o sin permiso de escritura) solo se calcula.
+     */
+    class Cache {
+    public:
+        explicit Cache(std::filesystem::path dir = {}) : dir(std::move(dir)) {}
+
+        void SetDir(const std::filesystem::path& d) { std::lock_guard<std::mutex> lock(mtx); dir = d; }
+
+        /**
+         * @param {bool*} built - Si se indica, true cuando hubo que decodificar.
+         */
+        bool Get(const std::filesystem::path& ogg, Analysis& out, std::string* err = nullptr, bool* built = nullptr) {
+            if (built) *built = false;
+            MappedFile src;
+            if (!src.Open(ogg)) { if (err) *err = "cannot read"; return false; }
+            uint64_t hash = AssetPack::Hash64(src.Data(), src.Size());
+            std::filesystem::path base;
+            { std::lock_guard<std::mutex> lock(mtx); base = dir; }
+            std::filesystem::path cached = base.empty() ? std::filesystem::path() : base / (Hex(hash) + ".gons");
+            if (!cached.empty()) {
+                MappedFile f;
+                if (f.Open(cached) && Parse(f.Data(), f.Size(), out, hash)) return true;
+            }
+            if (!Build(src.Data(), src.Size(), hash, out, err)) return false;
+            if (built) *built = true;
+            if (!cached.empty()) {
+                std::error_code ec;
+                std::string e;
+                std::filesystem::create_directories(base, ec);
+                AtomicFile::Write(cached, Serialize(out), e);
+            }
+            return true;
+        }
+
+        static std::string Hex(uint64_t v) {
+            static const char digits[] = "0123456789abcdef";
+            std::string s(16, '0');
+            for (int i = 15; i >= 0; i--, v >>= 4) s[i] = digits[v & 15];
+            return s;
+        }
+
+    private:
+        std::mutex mtx;
+        std::filesystem::path dir;
+    };
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <filesystem>
+#include <string>
+
+/**
+ * @namespace Paths
+ * @description Resolución de rutas pedidas desde la página o la red, siempre dentro de una raíz.
+ */
+namespace Paths {
+
+    namespace fs = std::filesystem;
+
+    /**
+     * Resuelve `relative` (separadores '/' o '\\') bajo `root`.
+     * Rechaza rutas absolutas, unidades y cualquier componente "..".
+     * @returns {bool} false si la ruta se sale de la raíz.
+     */
+    inline bool ResolveUnder(const fs::path& root, const fs::path& relative, fs::path& out) {
+        fs::path rel = relative;
+        if (rel.has_root_name() || rel.has_root_directory()) {
+            // "/index.html" de una URL se interpreta relativo a la raíz, pero no "C:\\..."
+            if (rel.has_root_name()) return false;
+            rel = rel.relative_path();
+        }
+        fs::path clean;
+        for (const auto& part : rel) {
+            if (part == "..") return false;
+            if (part.empty() || part == ".") continue;
+            clean /= part;
+        }
+        out = root / clean;
+        return true;
+    }
+
+    /**
+     * Variante para cadenas de la página: normaliza '\\' a '/' antes de resolver.
+     */
+    template <typename CharT>
+    inline bool ResolveUnder(const fs::path& root, std::basic_string<CharT> relative, fs::path& out) {
+        for (auto& c : relative) if (c == (CharT)'\\') c = (CharT)'/';
+        return ResolveUnder(root, fs::path(relative), out);
+    }
+}
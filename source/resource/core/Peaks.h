@@ -0,0 +1,374 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "AssetPack.h"
+#include "AtomicFile.h"
+#include "MappedFile.h"
+#include "Vorbis.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define GENESIS_PEAKS_SSE2 1
+#endif
+
+/**
+ * @namespace Peaks
+ * @description Pirámide de picos (min/max/RMS) del audio de una canción para dibujar la forma
+ * de onda a cualquier zoom. El nivel 0 resume kBaseBin muestras por cubeta; cada nivel
+ * siguiente junta dos cubetas del anterior. Se guarda en disco (.gpks) con el hash del .ogg,
+ * así que cada archivo se decodifica una sola vez, y se lee con memoria mapeada.
+ *
+ * Formato (little-endian):
+ *   [0]  "GPKS" | u16 versión | u16 canales | u32 sampleRate | u32 kBaseBin | u64 muestras
+ *        | u64 hash del .ogg | u32 niveles | u32 reservado            (40 bytes)
+ *   [40] por nivel: u32 cubetas | u32 reservado | u64 offset          (16 bytes cada uno)
+ *   datos: por nivel, por cubeta, por canal: i16 min | i16 max | i16 rms (escala 32767)
+ */
+namespace Peaks {
+
+    constexpr uint32_t kBaseBin = 256;
+    constexpr uint16_t kVersion = 1;
+    constexpr size_t kHeaderSize = 40;
+
+    namespace Detail {
+        using AssetPack::Detail::Put16;
+        using AssetPack::Detail::Put32;
+        using AssetPack::Detail::Put64;
+        using AssetPack::Detail::Get16;
+        using AssetPack::Detail::Get32;
+        using AssetPack::Detail::Get64;
+
+        inline int16_t Quantize(float v) {
+            float s = v * 32767.0f;
+            s = s < -32767.0f ? -32767.0f : (s > 32767.0f ? 32767.0f : s);
+            return (int16_t)std::lround(s);
+        }
+    }
+
+    /** Resumen de un tramo de muestras. */
+    struct Bin {
+        float min = 0, max = 0;
+        double sumSq = 0;
+        uint32_t count = 0;
+
+        void Merge(const Bin& o) {
+            if (!o.count) return;
+            if (!count) { *this = o; return; }
+            min = std::min(min, o.min); max = std::max(max, o.max);
+            sumSq += o.sumSq; count += o.count;
+        }
+    };
+
+    /**
+     * Min, max y suma de cuadrados de `n` muestras. Con SSE2, cuatro carriles en paralelo.
+     */
+    inline Bin Reduce(const float* p, size_t n) {
+        Bin b;
+        if (!n) return b;
+        size_t i = 0;
+        float mn = p[0], mx = p[0];
+        double sq = 0;
+#ifdef GENESIS_PEAKS_SSE2
+        if (n >= 8) {
+            __m128 vmin = _mm_loadu_ps(p), vmax = vmin, vsq = _mm_setzero_ps();
+            for (; i + 4 <= n; i += 4) {
+                __m128 v = _mm_loadu_ps(p + i);
+                vmin = _mm_min_ps(vmin, v);
+                vmax = _mm_max_ps(vmax, v);
+                vsq = _mm_add_ps(vsq, _mm_mul_ps(v, v));
+            }
+            alignas(16) float lo[4], hi[4], s[4];
+            _mm_store_ps(lo, vmin); _mm_store_ps(hi, vmax); _mm_store_ps(s, vsq);
+            mn = std::min(std::min(lo[0], lo[1]), std::min(lo[2], lo[3]));
+            mx = std::max(std::max(hi[0], hi[1]), std::max(hi[2], hi[3]));
+            sq = (double)s[0] + s[1] + s[2] + s[3];
+        }
+#endif
+        for (const float* q = p + i; q != p + n; q++) {
+            float v = *q;
+            mn = std::min(mn, v); mx = std::max(mx, v);
+            sq += (double)v * v;
+        }
+        b.min = mn; b.max = mx; b.sumSq = sq; b.count = (uint32_t)n;
+        return b;
+    }
+
+    /**
+     * @class Builder
+     * @description Recibe el PCM del decodificador por tramos y arma la pirámide.
+     */
+    class Builder {
+    public:
+        Builder(int channels, uint32_t sampleRate) : channels(channels), rate(sampleRate), pending(channels), base(channels) {
+            for (auto& p : pending) p.reserve(kBaseBin);
+        }
+
+        void Push(const float* const* pcm, size_t frames) {
+            for (int c = 0; c < channels; c++) {
+                const float* src = pcm[c];
+                size_t left = frames;
+                std::vector<float>& buf = pending[c];
+                std::vector<Bin>& out = base[c];
+                // Completa la cubeta a medias; después, cubetas enteras directamente desde el tramo
+                if (!buf.empty()) {
+                    size_t take = std::min(left, (size_t)kBaseBin - buf.size());
+                    buf.insert(buf.end(), src, src + take);
+                    src += take; left -= take;
+                    if (buf.size() == kBaseBin) { out.push_back(Reduce(buf.data(), kBaseBin)); buf.clear(); }
+                }
+                for (; left >= kBaseBin; src += kBaseBin, left -= kBaseBin) out.push_back(Reduce(src, kBaseBin));
+                buf.insert(buf.end(), src, src + left);
+            }
+            total += frames;
+        }
+
+        /**
+         * Cierra la última cubeta y serializa el archivo .gpks.
+         */
+        std::string Finish(uint64_t contentHash) {
+            for (int c = 0; c < channels; c++) {
+                if (!pending[c].empty()) base[c].push_back(Reduce(pending[c].data(), pending[c].size()));
+                pending[c].clear();
+            }
+            std::vector<std::vector<Bin>> levels;
+            // Nivel 0 entrelazado por canal: [cubeta][canal]
+            size_t bins = base[0].size();
+            std::vector<Bin> level(bins * channels);
+            for (size_t b = 0; b < bins; b++) for (int c = 0; c < channels; c++) level[b * channels + c] = base[c][b];
+            levels.push_back(std::move(level));
+            while (bins > 1) {
+                const std::vector<Bin>& prev = levels.back();
+                size_t next = (bins + 1) / 2;
+                std::vector<Bin> up(next * channels);
+                for (size_t b = 0; b < next; b++) {
+                    for (int c = 0; c < channels; c++) {
+                        Bin m = prev[(2 * b) * channels + c];
+                        if (2 * b + 1 < bins) m.Merge(prev[(2 * b + 1) * channels + c]);
+                        up[b * channels + c] = m;
+                    }
+                }
+                levels.push_back(std::move(up));
+                bins = next;
+            }
+
+            std::string o;
+            o.append("GPKS", 4);
+            Detail::Put16(o, kVersion); Detail::Put16(o, (uint32_t)channels);
+            Detail::Put32(o, rate); Detail::Put32(o, kBaseBin);
+            Detail::Put64(o, total); Detail::Put64(o, contentHash);
+            Detail::Put32(o, (uint32_t)levels.size()); Detail::Put32(o, 0);
+            uint64_t offset = kHeaderSize + 16 * levels.size();
+            for (const auto& l : levels) {
+                Detail::Put32(o, (uint32_t)(l.size() / channels)); Detail::Put32(o, 0);
+                Detail::Put64(o, offset);
+                offset += l.size() * 6;
+            }
+            for (const auto& l : levels) {
+                for (const Bin& b : l) {
+                    float rms = b.count ? (float)std::sqrt(b.sumSq / b.count) : 0.0f;
+                    Detail::Put16(o, (uint16_t)Detail::Quantize(b.min));
+                    Detail::Put16(o, (uint16_t)Detail::Quantize(b.max));
+                    Detail::Put16(o, (uint16_t)Detail::Quantize(rms));
+                }
+            }
+            return o;
+        }
+
+        uint64_t Frames() const { return total; }
+
+    private:
+        int channels;
+        uint32_t rate;
+        uint64_t total = 0;
+        std::vector<std::vector<float>> pending;
+        std::vector<std::vector<Bin>> base; // Nivel 0 por canal
+    };
+
+    /**
+     * @class Pyramid
+     * @description Pirámide abierta desde su archivo .gpks (memoria mapeada, solo lectura).
+     */
+    class Pyramid {
+    public:
+        bool Open(const std::filesystem::path& path, uint64_t expectHash = 0) {
+            if (!file.Open(path)) return false;
+            return Parse(file.Data(), file.Size(), expectHash);
+        }
+
+        /** Sobre un buffer ajeno (ya en memoria); tiene que seguir vivo. */
+        bool Parse(const char* bytes, size_t size, uint64_t expectHash = 0) {
+            const unsigned char* p = (const unsigned char*)bytes;
+            if (size < kHeaderSize || std::memcmp(p, "GPKS", 4) != 0 || Detail::Get16(p + 4) != kVersion) return false;
+            channels = Detail::Get16(p + 6);
+            rate = Detail::Get32(p + 8);
+            baseBin = Detail::Get32(p + 12);
+            frames = Detail::Get64(p + 16);
+            hash = Detail::Get64(p + 24);
+            uint32_t count = Detail::Get32(p + 32);
+            if (!channels || (expectHash && hash != expectHash) || count > 64 || kHeaderSize + 16ull * count > size) return false;
+            levels.clear();
+            for (uint32_t i = 0; i < count; i++) {
+                const unsigned char* e = p + kHeaderSize + 16 * i;
+                Level l;
+                l.bins = Detail::Get32(e);
+                uint64_t off = Detail::Get64(e + 8);
+                if (off + (uint64_t)l.bins * channels * 6 > size) return false;
+                l.data = bytes + off;
+                levels.push_back(l);
+            }
+            return true;
+        }
+
+        int Channels() const { return channels; }
+        uint32_t SampleRate() const { return rate; }
+        uint32_t BaseBin() const { return baseBin; }
+        uint64_t Frames() const { return frames; }
+        uint64_t Hash() const { return hash; }
+        size_t Levels() const { return levels.size(); }
+        uint32_t Bins(size_t level) const { return level < levels.size() ? levels[level].bins : 0; }
+
+        /** Muestras por cubeta en `level`. */
+        uint64_t FramesPerBin(size_t level) const { return (uint64_t)baseBin << level; }
+
+        /**
+         * Cubetas [start, start + count) de un nivel, recortadas al final.
+         * @returns {const char*} int16 LE min/max/rms por canal (6 * canales bytes por cubeta). nullptr si está fuera.
+         */
+        const char* Tile(size_t level, uint32_t start, uint32_t& count) const {
+            if (level >= levels.size() || start >= levels[level].bins) { count = 0; return nullptr; }
+            count = std::min(count, levels[level].bins - start);
+            return levels[level].data + (size_t)start * channels * 6;
+        }
+
+        /** Valor cuantizado: campo 0 = min, 1 = max, 2 = rms. */
+        int16_t Value(size_t level, uint32_t bin, int channel, int field) const {
+            const unsigned char* p = (const unsigned char*)levels[level].data + ((size_t)bin * channels + channel) * 6 + field * 2;
+            return (int16_t)Detail::Get16(p);
+        }
+
+    private:
+        struct Level { uint32_t bins = 0; const char* data = nullptr; };
+        MappedFile file;
+        int channels = 0;
+        uint32_t rate = 0, baseBin = 0;
+        uint64_t frames = 0, hash = 0;
+        std::vector<Level> levels;
+    };
+
+    /**
+     * Decodifica un .ogg ya en memoria y devuelve el archivo .gpks.
+     * @returns {bool} false si no es Vorbis (ver `err`).
+     */
+    inline bool Build(const char* ogg, size_t size, uint64_t hash, std::string& out, std::string* err = nullptr) {
+        Vorbis::Decoder dec;
+        if (!dec.Open(ogg, size, err)) return false;
+        Builder b(dec.Channels(), dec.SampleRate());
+        dec.Decode([&b](const float* const* pcm, size_t frames) { b.Push(pcm, frames); });
+        if (b.Frames() == 0) { if (err) *err = "no audio"; return false; }
+        out = b.Finish(hash);
+        return true;
+    }
+
+    /**
+     * @class Registry
+     * @description Pirámides abiertas por la página, por handle. La caché en disco vive en
+     * `cacheDir/<hash>.gpks`; si el .ogg no cambió (mismo hash) no se vuelve a decodificar.
+     */
+    class Registry {
+    public:
+        explicit Registry(std::filesystem::path cacheDir = {}) : cacheDir(std::move(cacheDir)) {}
+
+        void SetCacheDir(const std::filesystem::path& dir) { std::lock_guard<std::mutex> lock(mtx); cacheDir = dir; }
+
+        /**
+         * Abre (o construye) la pirámide de un .ogg.
+         * @param {bool*} built - Si se indica, true cuando hubo que decodificar.
+         * @returns {uint32_t} Handle, 0 si falla.
+         */
+        uint32_t Open(const std::filesystem::path& ogg, std::string* err = nullptr, bool* built = nullptr) {
+            if (built) *built = false;
+            std::error_code ec;
+            std::string key = ogg.lexically_normal().u8string();
+            uint64_t size = std::filesystem::file_size(ogg, ec);
+            auto stamp = std::filesystem::last_write_time(ogg, ec).time_since_epoch().count();
+            if (ec) { if (err) *err = "not found"; return 0; }
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                auto it = byPath.find(key);
+                if (it != byPath.end() && it->second.size == size && it->second.stamp == (int64_t)stamp && open.count(it->second.handle)) return it->second.handle;
+            }
+
+            MappedFile src;
+            if (!src.Open(ogg)) { if (err) *err = "cannot read"; return 0; }
+            uint64_t hash = AssetPack::Hash64(src.Data(), src.Size());
+            std::filesystem::path dir;
+            { std::lock_guard<std::mutex> lock(mtx); dir = cacheDir; }
+            auto pyramid = std::make_shared<Pyramid>();
+            std::filesystem::path cached = dir.empty() ? std::filesystem::path() : dir / (Hex(hash) + ".gpks");
+            if (cached.empty() || !pyramid->Open(cached, hash)) {
+                std::string bytes, e;
+                if (!Build(src.Data(), src.Size(), hash, bytes, &e)) { if (err) *err = e; return 0; }
+                if (built) *built = true;
+                pyramid = std::make_shared<Pyramid>();
+                bool stored = false;
+                if (!cached.empty()) {
+                    std::filesystem::create_directories(dir, ec);
+                    stored = AtomicFile::Write(cached, bytes, e) && pyramid->Open(cached, hash);
+                }
+                // Sin caché en disco (o sin permiso de escritura) se queda en memoria
+                if (!stored) {
+                    auto owned = std::make_shared<std::string>(std::move(bytes));
+                    auto mem = std::make_shared<Pyramid>();
+                    if (!mem->Parse(owned->data(), owned->size(), hash)) { if (err) *err = "bad pyramid"; return 0; }
+                    std::lock_guard<std::mutex> lock(mtx);
+                    return Add(key, size, (int64_t)stamp, std::move(mem), std::move(owned));
+                }
+            }
+            std::lock_guard<std::mutex> lock(mtx);
+            return Add(key, size, (int64_t)stamp, std::move(pyramid), nullptr);
+        }
+
+        std::shared_ptr<const Pyramid> Get(uint32_t handle) {
+            std::lock_guard<std::mutex> lock(mtx);
+            auto it = open.find(handle);
+            return it == open.end() ? nullptr : it->second.pyramid;
+        }
+
+        void Close(uint32_t handle) {
+            std::lock_guard<std::mutex> lock(mtx);
+            open.erase(handle);
+        }
+
+        static std::string Hex(uint64_t v) {
+            static const char digits[] = "0123456789abcdef";
+            std::string s(16, '0');
+            for (int i = 15; i >= 0; i--, v >>= 4) s[i] = digits[v & 15];
+            return s;
+        }
+
+    private:
+        struct Entry { std::shared_ptr<const Pyramid> pyramid; std::shared_ptr<std::string> memory; };
+        struct Known { uint32_t handle; uint64_t size; int64_t stamp; };
+
+        std::mutex mtx;
+        std::filesystem::path cacheDir;
+        std::unordered_map<uint32_t, Entry> open;
+        std::unordered_map<std::string, Known> byPath;
+        uint32_t nextId = 1;
+
+        uint32_t Add(const std::string& key, uint64_t size, int64_t stamp, std::shared_ptr<const Pyramid> p, std::shared_ptr<std::string> memory) {
+            uint32_t id = nextId++;
+            open[id] = { std::move(p), std::move(memory) };
+            byPath[key] = { id, size, stamp };
+            return id;
+        }
+    };
+}
@@ -0,0 +1,913 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "AssetPack.h"
+#include "MappedFile.h"
+#include "Stretch.h"
+#include "Vorbis.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#include <mmsystem.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define GENESIS_PLAYBACK_SSE2 1
+#endif
+
+/**
+ * @namespace Playback
+ * @description Reproducción de los stems de una canción (Inst, Voices...) a velocidad variable
+ * sin cambiar el tono, para el editor de charts.
+ *
+ * - Cada .ogg se decodifica una vez a PCM de 16 bits en memoria (PcmCache, por hash del archivo).
+ * - Los stems se mezclan muestra a muestra ANTES de estirar, con un solo Stretch::Wsola: todos
+ *   comparten el mismo mapa de tiempo y no pueden desincronizarse entre sí.
+ * - El reloj de la canción sale de lo que el sink ya ha hecho sonar (no de lo escrito), pasado
+ *   por las marcas (salida -> fuente, velocidad) de cada bloque. Es el único reloj: la página
+ *   lo lee en vez de contar el tiempo por su cuenta.
+ * - Sinks: waveOut en Windows; NullSink (a tiempo real o sin esperas) y WavSink en cualquier
+ *   sistema, para pruebas y para renderizar a archivo.
+ */
+namespace Playback {
+
+    /** Audio decodificado: int16 intercalado. */
+    struct Pcm {
+        uint32_t rate = 0;
+        uint32_t channels = 0;
+        uint64_t frames = 0;
+        uint64_t hash = 0;
+        std::vector<int16_t> samples;
+
+        size_t Bytes() const { return samples.size() * sizeof(int16_t); }
+        double DurationMs() const { return rate ? (double)frames * 1000.0 / rate : 0.0; }
+    };
+
+    namespace Detail {
+        inline int16_t ToS16(float v) {
+            float s = v * 32767.0f;
+            s = s < -32768.0f ? -32768.0f : (s > 32767.0f ? 32767.0f : s);
+            return (int16_t)std::lrint(s);
+        }
+
+        /** dst[i] += src[i] * scale. Con SSE2, ocho muestras por vuelta. */
+        inline void Accumulate(const int16_t* src, size_t n, float scale, float* dst) {
+            size_t i = 0;
+#ifdef GENESIS_PLAYBACK_SSE2
+            __m128 k = _mm_set1_ps(scale);
+            for (; i + 8 <= n; i += 8) {
+                __m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+                __m128 lo = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16));
+                __m128 hi = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16));
+                _mm_storeu_ps(dst + i, _mm_add_ps(_mm_loadu_ps(dst + i), _mm_mul_ps(lo, k)));
+                _mm_storeu_ps(dst + i + 4, _mm_add_ps(_mm_loadu_ps(dst + i + 4), _mm_mul_ps(hi, k)));
+            }
+#endif
+            for (; i < n; i++) dst[i] += (float)src[i] * scale;
+        }
+    }
+
+    /**
+     * Decodifica un .ogg ya en memoria.
+     * @returns {bool} false si no es Vorbis (ver `err`).
+     */
+    inline bool Decode(const char* ogg, size_t size, Pcm& out, std::string* err = nullptr) {
+        Vorbis::Decoder dec;
+        if (!dec.Open(ogg, size, err)) return false;
+        out.rate = dec.SampleRate();
+        out.channels = (uint32_t)dec.Channels();
+        out.samples.clear();
+        if (dec.Frames() > 0) out.samples.reserve((size_t)dec.Frames() * out.channels);
+        const uint32_t C = out.channels;
+        dec.Decode([&out, C](const float* const* pcm, size_t frames) {
+            size_t at = out.samples.size();
+            out.samples.resize(at + frames * C);
+            int16_t* dst = out.samples.data() + at;
+            for (size_t i = 0; i < frames; i++) {
+                for (uint32_t c = 0; c < C; c++) dst[i * C + c] = Detail::ToS16(pcm[c][i]);
+            }
+        });
+        out.frames = C ? out.samples.size() / C : 0;
+        if (out.frames == 0) { if (err) *err = "no audio"; return false; }
+        return true;
+    }
+
+    /** Cambia la frecuencia de muestreo (interpolación lineal). Solo para stems que no casan con el primero. */
+    inline Pcm Resample(const Pcm& in, uint32_t rate) {
+        Pcm out;
+        out.rate = rate;
+        out.channels = in.channels;
+        out.hash = in.hash;
+        if (!in.rate || !in.frames) return out;
+        out.frames = (uint64_t)((double)in.frames * rate / in.rate);
+        out.samples.resize((size_t)out.frames * in.channels);
+        const uint32_t C = in.channels;
+        double step = (double)in.rate / rate;
+        for (uint64_t i = 0; i < out.frames; i++) {
+            double x = (double)i * step;
+            uint64_t a = (uint64_t)x;
+            uint64_t b = std::min(a + 1, in.frames - 1);
+            float f = (float)(x - (double)a);
+            for (uint32_t c = 0; c < C; c++) {
+                float va = in.samples[a * C + c], vb = in.samples[b * C + c];
+                out.samples[i * C + c] = (int16_t)std::lrint(va + (vb - va) * f);
+            }
+        }
+        return out;
+    }
+
+    /**
+     * @class PcmCache
+     * @description PCM por hash del .ogg, compartido entre cargas. Por encima de `budget` bytes
+     * suelta lo menos usado que no esté sonando.
+     */
+    class PcmCache {
+    public:
+        explicit PcmCache(size_t budget = (size_t)512 << 20) : budget(budget) {}
+
+        /**
+         * @param {bool*} decoded - Si se indica, true cuando hubo que decodificar (o remuestrear).
+         * @param {uint32_t} rate - Si no es 0 y el .ogg va a otra frecuencia, devuelve (y guarda)
+         * la versión remuestreada, para no repetir el remuestreo en cada carga.
+         */
+        std::shared_ptr<const Pcm> Get(const std::filesystem::path& ogg, std::string* err = nullptr, bool* decoded = nullptr, uint32_t rate = 0) {
+            if (decoded) *decoded = false;
+            MappedFile src;
+            if (!src.Open(ogg)) { if (err) *err = "cannot read"; return nullptr; }
+            uint64_t hash = AssetPack::Hash64(src.Data(), src.Size());
+            uint64_t resampledKey = AssetPack::Hash64(&rate, sizeof(rate), hash);
+            std::shared_ptr<const Pcm> pcm;
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                if (rate) {
+                    auto it = entries.find(resampledKey);
+                    if (it != entries.end()) { it->second.lastUse = ++tick; return it->second.pcm; }
+                }
+                auto it = entries.find(hash);
+                if (it != entries.end()) { it->second.lastUse = ++tick; pcm = it->second.pcm; }
+            }
+            if (!pcm) {
+                auto fresh = std::make_shared<Pcm>();
+                if (!Decode(src.Data(), src.Size(), *fresh, err)) return nullptr;
+                fresh->hash = hash;
+                if (decoded) *decoded = true;
+                pcm = Put(hash, std::move(fresh));
+            }
+            if (!rate || pcm->rate == rate) return pcm;
+            auto resampled = std::make_shared<Pcm>(Resample(*pcm, rate));
+            resampled->hash = hash;
+            if (decoded) *decoded = true;
+            return Put(resampledKey, std::move(resampled));
+        }
+
+        size_t Bytes() const { std::lock_guard<std::mutex> lock(mtx); return bytes; }
+        size_t Count() const { std::lock_guard<std::mutex> lock(mtx); return entries.size(); }
+
+        void Clear() {
+            std::lock_guard<std::mutex> lock(mtx);
+            entries.clear();
+            bytes = 0;
+        }
+
+    private:
+        struct Entry {
+            std::shared_ptr<const Pcm> pcm;
+            uint64_t lastUse = 0;
+        };
+
+        std::shared_ptr<const Pcm> Put(uint64_t key, std::shared_ptr<const Pcm> pcm) {
+            std::lock_guard<std::mutex> lock(mtx);
+            auto& e = entries[key];
+            if (!e.pcm) { e.pcm = std::move(pcm); bytes += e.pcm->Bytes(); }
+            e.lastUse = ++tick;
+            auto out = e.pcm;
+            Trim();
+            return out;
+        }
+
+        void Trim() {
+            while (bytes > budget) {
+                auto victim = entries.end();
+                for (auto it = entries.begin(); it != entries.end(); ++it) {
+                    if (it->second.pcm.use_count() > 1) continue;
+                    if (victim == entries.end() || it->second.lastUse < victim->second.lastUse) victim = it;
+                }
+                if (victim == entries.end()) return;
+                bytes -= victim->second.pcm->Bytes();
+                entries.erase(victim);
+            }
+        }
+
+        mutable std::mutex mtx;
+        std::unordered_map<uint64_t, Entry> entries;
+        size_t bytes = 0, budget;
+        uint64_t tick = 0;
+    };
+
+    /**
+     * @class Sink
+     * @description Salida de audio. Write lo llama solo el hilo del reproductor; Played puede
+     * llamarse desde cualquiera.
+     */
+    class Sink {
+    public:
+        virtual ~Sink() = default;
+        virtual bool Open(uint32_t rate, uint32_t channels, std::string* err) = 0;
+        /** Espera hasta que quepan `frames` (o pase `timeoutMs`). @returns {size_t} Frames que caben. */
+        virtual size_t Wait(size_t frames, uint32_t timeoutMs) = 0;
+        virtual void Write(const float* interleaved, size_t frames) = 0;
+        /** Frames que ya han sonado desde Open o desde el último Stop. */
+        virtual uint64_t Played() = 0;
+        /** Descarta lo encolado y vuelve a contar desde 0 (pausa, seek). */
+        virtual void Stop() = 0;
+        virtual void Close() = 0;
+    };
+
+    /**
+     * @class NullSink
+     * @description Sink sin dispositivo. A tiempo real consume `rate` frames por segundo con
+     * `bufferMs` de cola, como una tarjeta; si no, se lo traga todo al momento (render offline).
+     */
+    class NullSink : public Sink {
+    public:
+        explicit NullSink(bool realtime = true, uint32_t bufferMs = 80) : realtime(realtime), bufferMs(bufferMs) {}
+
+        bool Open(uint32_t r, uint32_t c, std::string*) override {
+            std::lock_guard<std::mutex> lock(mtx);
+            rate = r; channels = c;
+            capacity = std::max<size_t>(1, (size_t)rate * bufferMs / 1000);
+            written = 0; started = false;
+            return true;
+        }
+
+        size_t Wait(size_t frames, uint32_t timeoutMs) override {
+            if (!realtime) return std::max(frames, capacity);
+            auto until = Clock::now() + std::chrono::milliseconds(timeoutMs);
+            for (;;) {
+                Clock::time_point wake;
+                {
+                    std::lock_guard<std::mutex> lock(mtx);
+                    size_t room = capacity - (size_t)std::min<uint64_t>(capacity, written - PlayedLocked());
+                    if (room >= frames || !rate || Clock::now() >= until) return room;
+                    auto need = std::chrono::duration<double>((double)(frames - room) / rate);
+                    wake = std::min(until, Clock::now() + std::chrono::duration_cast<Clock::duration>(need));
+                }
+                std::this_thread::sleep_until(wake);
+            }
+        }
+
+        void Write(const float*, size_t frames) override {
+            std::lock_guard<std::mutex> lock(mtx);
+            auto now = Clock::now();
+            if (!started) { start = now; started = true; }
+            else if (realtime && PlayedLocked() >= written) {
+                // Se quedó sin datos: como un dispositivo, sigue desde ahora en vez de "recuperar" el hueco
+                start = now - std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>((double)written / rate));
+            }
+            written += frames;
+        }
+
+        uint64_t Played() override {
+            std::lock_guard<std::mutex> lock(mtx);
+            return PlayedLocked();
+        }
+
+        void Stop() override {
+            std::lock_guard<std::mutex> lock(mtx);
+            written = 0;
+            started = false;
+        }
+
+        void Close() override { Stop(); }
+
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        uint64_t PlayedLocked() const {
+            if (!realtime) return written;
+            if (!started) return 0;
+            double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+            return std::min<uint64_t>(written, (uint64_t)(seconds * rate));
+        }
+
+        bool realtime;
+        uint32_t bufferMs;
+        uint32_t rate = 0, channels = 0;
+        size_t capacity = 1;
+        uint64_t written = 0;
+        bool started = false;
+        Clock::time_point start;
+        std::mutex mtx;
+    };
+
+    /**
+     * @class WavSink
+     * @description Escribe la salida a un .wav de 16 bits, sin esperas (render offline).
+     */
+    class WavSink : public Sink {
+    public:
+        explicit WavSink(std::filesystem::path path) : path(std::move(path)) {}
+        ~WavSink() override { Close(); }
+
+        bool Open(uint32_t r, uint32_t c, std::string* err) override {
+            Close();
+            file.open(path, std::ios::binary | std::ios::trunc);
+            if (!file) { if (err) *err = "cannot write " + path.u8string(); return false; }
+            rate = r; channels = c; written = 0;
+            std::string header(44, '\0');
+            file.write(header.data(), (std::streamsize)header.size());
+            return true;
+        }
+
+        size_t Wait(size_t frames, uint32_t) override { return frames; }
+
+        void Write(const float* interleaved, size_t frames) override {
+            if (!file.is_open()) return;
+            buf.resize(frames * channels);
+            for (size_t i = 0; i < buf.size(); i++) buf[i] = Detail::ToS16(interleaved[i]);
+            file.write((const char*)buf.data(), (std::streamsize)(buf.size() * sizeof(int16_t)));
+            written += frames;
+        }
+
+        uint64_t Played() override { return written; }
+        void Stop() override {}
+
+        void Close() override {
+            if (!file.is_open()) return;
+            uint32_t data = (uint32_t)(written * channels * 2);
+            std::string h;
+            auto put16 = [&h](uint16_t v) { h += (char)(v & 0xFF); h += (char)(v >> 8); };
+            auto put32 = [&h](uint32_t v) { for (int i = 0; i < 4; i++) h += (char)((v >> (8 * i)) & 0xFF); };
+            h += "RIFF"; put32(36 + data); h += "WAVEfmt "; put32(16);
+            put16(1); put16((uint16_t)channels); put32(rate); put32(rate * channels * 2);
+            put16((uint16_t)(channels * 2)); put16(16);
+            h += "data"; put32(data);
+            file.seekp(0);
+            file.write(h.data(), (std::streamsize)h.size());
+            file.close();
+        }
+
+        uint64_t Frames() const { return written; }
+
+    private:
+        std::filesystem::path path;
+        std::ofstream file;
+        uint32_t rate = 0, channels = 0;
+        uint64_t written = 0;
+        std::vector<int16_t> buf;
+    };
+
+#ifdef _WIN32
+    /**
+     * @class WaveOutSink
+     * @description Salida por waveOut: kBuffers bloques de 16 bits en cola con aviso por evento.
+     * waveOutGetPosition da lo que de verdad ha sonado, con la latencia del mezclador incluida.
+     */
+    class WaveOutSink : public Sink {
+    public:
+        static constexpr size_t kBuffers = 8;
+        static constexpr size_t kMaxFrames = 1024;
+
+        ~WaveOutSink() override { Close(); }
+
+        bool Open(uint32_t r, uint32_t c, std::string* err) override {
+            Close();
+            channels = c;
+            WAVEFORMATEX fmt = {};
+            fmt.wFormatTag = WAVE_FORMAT_PCM;
+            fmt.nChannels = (WORD)c;
+            fmt.nSamplesPerSec = r;
+            fmt.wBitsPerSample = 16;
+            fmt.nBlockAlign = (WORD)(c * 2);
+            fmt.nAvgBytesPerSec = r * c * 2;
+            event = CreateEventW(NULL, FALSE, FALSE, NULL);
+            MMRESULT res = waveOutOpen(&device, WAVE_MAPPER, &fmt, (DWORD_PTR)event, 0, CALLBACK_EVENT);
+            if (res != MMSYSERR_NOERROR) {
+                if (err) *err = "waveOutOpen failed (" + std::to_string(res) + ")";
+                CloseHandle(event);
+                event = NULL;
+                device = NULL;
+                return false;
+            }
+            for (size_t i = 0; i < kBuffers; i++) {
+                data[i].assign(kMaxFrames * c, 0);
+                headers[i] = {};
+                headers[i].lpData = (LPSTR)data[i].data();
+                headers[i].dwBufferLength = (DWORD)(kMaxFrames * c * 2);
+                waveOutPrepareHeader(device, &headers[i], sizeof(WAVEHDR));
+            }
+            return true;
+        }
+
+        size_t Wait(size_t frames, uint32_t timeoutMs) override {
+            DWORD until = GetTickCount() + timeoutMs;
+            for (;;) {
+                size_t room = Free() * kMaxFrames;
+                if (room >= frames || !device) return room;
+                DWORD now = GetTickCount();
+                if ((int32_t)(until - now) <= 0) return room;
+                WaitForSingleObject(event, until - now);
+            }
+        }
+
+        void Write(const float* interleaved, size_t frames) override {
+            while (frames && device) {
+                WAVEHDR* h = nullptr;
+                for (auto& hdr : headers) if (!(hdr.dwFlags & WHDR_INQUEUE)) { h = &hdr; break; }
+                if (!h) return;
+                size_t n = std::min(frames, kMaxFrames);
+                int16_t* dst = (int16_t*)h->lpData;
+                for (size_t i = 0; i < n * channels; i++) dst[i] = Detail::ToS16(interleaved[i]);
+                h->dwBufferLength = (DWORD)(n * channels * 2);
+                waveOutWrite(device, h, sizeof(WAVEHDR));
+                interleaved += n * channels;
+                frames -= n;
+            }
+        }
+
+        uint64_t Played() override {
+            if (!device) return 0;
+            MMTIME t = {};
+            t.wType = TIME_SAMPLES;
+            waveOutGetPosition(device, &t, sizeof(t));
+            if (t.wType == TIME_SAMPLES) return t.u.sample;
+            if (t.wType == TIME_BYTES) return t.u.cb / (channels * 2);
+            return 0;
+        }
+
+        void Stop() override {
+            if (device) waveOutReset(device);
+        }
+
+        void Close() override {
+            if (!device) return;
+            waveOutReset(device);
+            for (auto& h : headers) waveOutUnprepareHeader(device, &h, sizeof(WAVEHDR));
+            waveOutClose(device);
+            CloseHandle(event);
+            device = NULL;
+            event = NULL;
+        }
+
+    private:
+        size_t Free() const {
+            size_t n = 0;
+            for (const auto& h : headers) if (!(h.dwFlags & WHDR_INQUEUE)) n++;
+            return n;
+        }
+
+        HWAVEOUT device = NULL;
+        HANDLE event = NULL;
+        uint32_t channels = 2;
+        WAVEHDR headers[kBuffers] = {};
+        std::vector<int16_t> data[kBuffers];
+    };
+#endif
+
+    /**
+     * @class Player
+     * @description Stems de una canción mezclados, estirados y enviados a un sink desde un hilo
+     * propio. Todos los métodos son seguros desde cualquier hilo.
+     */
+    class Player {
+    public:
+        /** Frames por escritura al sink (~12 ms a 44,1 kHz). */
+        static constexpr size_t kBlock = 512;
+
+        struct Clock {
+            double ms = 0;          // Posición de la canción que está sonando
+            double speed = 1.0;
+            bool playing = false;
+            bool ended = false;     // Llegó al final y se paró solo
+        };
+
+        struct Stats {
+            uint64_t frames = 0;        // Frames de salida renderizados
+            double renderMs = 0;        // Tiempo gastado en mezclar + estirar
+            uint64_t underruns = 0;     // Escrituras con el sink ya vacío
+            uint64_t hops = 0, searches = 0;
+            double decodeMs = 0;        // De la última carga (0 si todo venía de la caché)
+            size_t stems = 0;
+            /** ms de CPU por segundo de audio de salida. */
+            double CostPerSecond(uint32_t rate) const { return frames ? renderMs * rate / (double)frames : 0.0; }
+        };
+
+        /** Desde el hilo del reproductor (o el que llame a Play / Pause / Seek / SetSpeed). */
+        using ClockFn = std::function<void(const Clock&)>;
+
+        explicit Player(PcmCache& cache) : cache(cache) {}
+        ~Player() { Close(); }
+
+        Player(const Player&) = delete;
+        Player& operator=(const Player&) = delete;
+
+        /**
+         * Carga los stems (para lo que sonara). El primero fija la frecuencia de muestreo; los que
+         * no casan se remuestrean. La salida es estéreo si algún stem lo es.
+         */
+        bool Load(const std::vector<std::filesystem::path>& files, std::string* err = nullptr) {
+            std::vector<std::shared_ptr<const Pcm>> pcms;
+            std::vector<std::string> names;
+            auto t0 = std::chrono::steady_clock::now();
+            bool anyDecoded = false;
+            for (const auto& f : files) {
+                bool decoded = false;
+                auto pcm = cache.Get(f, err, &decoded, pcms.empty() ? 0 : pcms[0]->rate);
+                if (!pcm) return false;
+                anyDecoded |= decoded;
+                pcms.push_back(std::move(pcm));
+                names.push_back(f.filename().u8string());
+            }
+            double decodeMs = anyDecoded ? std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count() : 0.0;
+            if (!Load(pcms, names, err)) return false;
+            std::lock_guard<std::mutex> lock(mtx);
+            stats.decodeMs = decodeMs;
+            return true;
+        }
+
+        /** Igual, con PCM ya en memoria (herramientas y pruebas). */
+        bool Load(const std::vector<std::shared_ptr<const Pcm>>& pcms, const std::vector<std::string>& names, std::string* err = nullptr) {
+            StopThread();
+            std::vector<Stem> loaded;
+            for (size_t i = 0; i < pcms.size(); i++) {
+                auto pcm = pcms[i];
+                if (!pcm || !pcm->frames || !pcm->rate) continue;
+                if (!loaded.empty() && pcm->rate != loaded[0].pcm->rate) {
+                    pcm = std::make_shared<Pcm>(Resample(*pcm, loaded[0].pcm->rate));
+                }
+                loaded.push_back({ std::move(pcm), i < names.size() ? names[i] : std::string(), 1.0f });
+            }
+            if (loaded.empty()) { if (err) *err = "no stems"; return false; }
+
+            std::lock_guard<std::mutex> lock(mtx);
+            CloseSinkLocked();
+            stems = std::move(loaded);
+            rate = stems[0].pcm->rate;
+            channels = 1;
+            total = 0;
+            for (const auto& s : stems) {
+                channels = std::max(channels, std::min<uint32_t>(2, s.pcm->channels));
+                total = std::max(total, s.pcm->frames);
+            }
+            wsola = std::make_unique<Stretch::Wsola>(channels, rate, simd);
+            wsola->SetSpeed(speed);
+            wsola->Reset(0);
+            pausedAt = 0;
+            ended = false;
+            stats = Stats();
+            stats.stems = stems.size();
+            return true;
+        }
+
+        /** Para y suelta los stems (el PCM sigue en la caché). */
+        void Close() {
+            StopThread();
+            std::lock_guard<std::mutex> lock(mtx);
+            CloseSinkLocked();
+            stems.clear();
+            wsola.reset();
+            total = 0;
+        }
+
+        bool Loaded() const { std::lock_guard<std::mutex> lock(mtx); return !stems.empty(); }
+        size_t StemCount() const { std::lock_guard<std::mutex> lock(mtx); return stems.size(); }
+        std::string StemName(size_t i) const { std::lock_guard<std::mutex> lock(mtx); return i < stems.size() ? stems[i].name : std::string(); }
+        uint32_t Rate() const { std::lock_guard<std::mutex> lock(mtx); return rate; }
+        uint32_t Channels() const { std::lock_guard<std::mutex> lock(mtx); return channels; }
+        double DurationMs() const { std::lock_guard<std::mutex> lock(mtx); return rate ? (double)total * 1000.0 / rate : 0.0; }
+
+        /** Sink para las siguientes reproducciones (por defecto waveOut en Windows, NullSink fuera). */
+        void SetSink(std::unique_ptr<Sink> s) {
+            StopThread();
+            std::lock_guard<std::mutex> lock(mtx);
+            CloseSinkLocked();
+            sink = std::move(s);
+        }
+
+        /** false usa los productos escalares en el estirado (para comparar en los benchmarks). */
+        void SetSimd(bool on) {
+            std::lock_guard<std::mutex> lock(mtx);
+            simd = on;
+            if (wsola) {
+                double at = wsola->Position();
+                wsola = std::make_unique<Stretch::Wsola>(channels, rate, simd);
+                wsola->SetSpeed(speed);
+                wsola->Reset(at);
+            }
+        }
+
+        /** Llamado cada `intervalMs` mientras suena y en cada cambio de estado. */
+        void SetListener(ClockFn fn, uint32_t intervalMs = 50) {
+            std::lock_guard<std::mutex> lock(listenerMtx);
+            listener = std::move(fn);
+            listenInterval = std::chrono::milliseconds(std::max<uint32_t>(1, intervalMs));
+        }
+
+        bool Play(std::string* err = nullptr) {
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                if (stems.empty()) { if (err) *err = "nothing loaded"; return false; }
+                if (playing) return true;
+            }
+            StopThread();   // Recoge el hilo si terminó solo al llegar al final
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                if (stems.empty() || playing) return !stems.empty();
+                if (!sink) {
+#ifdef _WIN32
+                    sink = std::make_unique<WaveOutSink>();
+#else
+                    sink = std::make_unique<NullSink>(true);
+#endif
+                }
+                if (!sinkOpen) {
+                    if (!sink->Open(rate, channels, err)) return false;
+                    sinkOpen = true;
+                }
+                if (ended || pausedAt >= (double)total) pausedAt = 0;
+                ended = false;
+                StartLocked(pausedAt);
+            }
+            Notify();
+            return true;
+        }
+
+        void Pause() {
+            StopThread();
+            Notify();
+        }
+
+        /** Salta a `ms` de la canción; si estaba sonando sigue sonando desde ahí. */
+        void Seek(double ms) {
+            bool wasPlaying = StopThread();
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                double at = rate ? ms * rate / 1000.0 : 0.0;
+                pausedAt = std::max(0.0, std::min(at, (double)total));
+                ended = false;
+                if (wsola) wsola->Reset(pausedAt);
+                if (wasPlaying) StartLocked(pausedAt);
+            }
+            Notify();
+        }
+
+        /** Velocidad (0,25 - 4). Lo ya encolado en el sink (~90 ms) sale a la anterior; el reloj lo sabe. */
+        void SetSpeed(double s) {
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                speed = std::min(Stretch::kMaxSpeed, std::max(Stretch::kMinSpeed, s));
+                if (wsola) wsola->SetSpeed(speed);
+            }
+            Notify();
+        }
+
+        double Speed() const { std::lock_guard<std::mutex> lock(mtx); return speed; }
+
+        /** Volumen de un stem (0 = silenciado). */
+        void SetGain(size_t stem, float gain) {
+            std::lock_guard<std::mutex> lock(mtx);
+            if (stem < stems.size()) stems[stem].gain = std::max(0.0f, gain);
+        }
+
+        /** Reloj autoritativo de la canción. */
+        Clock Now() {
+            std::lock_guard<std::mutex> lock(mtx);
+            return NowLocked();
+        }
+
+        Stats GetStats() const {
+            std::lock_guard<std::mutex> lock(mtx);
+            Stats s = stats;
+            if (wsola) { s.hops = wsola->Hops(); s.searches = wsola->Searches(); }
+            return s;
+        }
+
+        /**
+         * Render offline, sin sink ni hilo (herramientas y pruebas). Avanza la misma posición que Play.
+         * No usar mientras suena.
+         */
+        void Render(float* out, size_t frames) {
+            std::lock_guard<std::mutex> lock(mtx);
+            if (!wsola) { std::fill(out, out + frames * channels, 0.0f); return; }
+            auto t0 = std::chrono::steady_clock::now();
+            RenderLocked(out, frames, false);
+            stats.renderMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+            stats.frames += frames;
+        }
+
+        /** Frame de la fuente que sale en la siguiente muestra de Render. */
+        double SourcePosition() const {
+            std::lock_guard<std::mutex> lock(mtx);
+            return wsola ? wsola->Position() : 0.0;
+        }
+
+    private:
+        struct Stem {
+            std::shared_ptr<const Pcm> pcm;
+            std::string name;
+            float gain = 1.0f;
+        };
+
+        /** Desde la salida `out` suena la fuente `src`, avanzando `speed` frames por frame. */
+        struct Marker {
+            uint64_t out = 0;
+            double src = 0;
+            double speed = 1.0;
+        };
+
+        /** Mezcla de los stems en [first, first + count), intercalada; ceros fuera de la canción. */
+        void Mix(int64_t first, size_t count, float* out) const {
+            const uint32_t C = channels;
+            std::fill(out, out + count * C, 0.0f);
+            for (const Stem& s : stems) {
+                if (s.gain <= 0) continue;
+                const Pcm& p = *s.pcm;
+                int64_t a = std::max<int64_t>(first, 0);
+                int64_t b = std::min<int64_t>(first + (int64_t)count, (int64_t)p.frames);
+                if (a >= b) continue;
+                const uint32_t sc = p.channels;
+                const int16_t* src = p.samples.data() + (size_t)a * sc;
+                float* dst = out + (size_t)(a - first) * C;
+                size_t n = (size_t)(b - a);
+                float k = s.gain / 32768.0f;
+                if (sc == C) {
+                    Detail::Accumulate(src, n * C, k, dst);
+                } else {
+                    for (size_t i = 0; i < n; i++) {
+                        for (uint32_t c = 0; c < C; c++) dst[i * C + c] += (float)src[i * sc + std::min(c, sc - 1)] * k;
+                    }
+                }
+            }
+        }
+
+        void RenderLocked(float* out, size_t frames, bool track) {
+            auto src = [this](int64_t first, size_t count, float* dst) { Mix(first, count, dst); };
+            while (frames) {
+                size_t n = std::min(frames, wsola->Available(src));
+                if (track) {
+                    Marker m{ written, wsola->Position(), wsola->BlockSpeed() };
+                    if (!markers.empty() && markers.back().speed == m.speed
+                        && std::fabs(markers.back().src + (double)(m.out - markers.back().out) * m.speed - m.src) < 1e-6) {
+                        // Sigue la misma recta: no hace falta otra marca
+                    } else {
+                        markers.push_back(m);
+                    }
+                    double end = m.src + (double)n * m.speed;
+                    if (!endOut && end >= (double)total) endOut = m.out + (uint64_t)std::ceil(std::max(0.0, (double)total - m.src) / m.speed);
+                    written += n;
+                }
+                wsola->Render(out, n, src);
+                out += n * channels;
+                frames -= n;
+            }
+        }
+
+        Clock NowLocked() {
+            Clock c;
+            c.speed = speed;
+            c.ended = ended;
+            c.playing = playing;
+            double at = pausedAt;
+            if (playing && !markers.empty()) {
+                uint64_t played = sink->Played();
+                while (markers.size() > 1 && markers[1].out <= played) markers.pop_front();
+                const Marker& m = markers.front();
+                at = m.src + ((double)played - (double)m.out) * m.speed;
+                if (played < m.out) at = m.src;
+            }
+            at = std::max(0.0, std::min(at, (double)total));
+            c.ms = rate ? at * 1000.0 / rate : 0.0;
+            return c;
+        }
+
+        /** El hilo anterior ya debe estar recogido (StopThread). */
+        void StartLocked(double at) {
+            sink->Stop();
+            wsola->Reset(at);
+            markers.clear();
+            markers.push_back({ 0, at, wsola->BlockSpeed() });
+            written = 0;
+            endOut = 0;
+            playing = true;
+            running = true;
+            thread = std::thread([this] { Loop(); });
+        }
+
+        /** @returns {bool} Si estaba sonando. Deja pausedAt en lo que sonaba al parar. */
+        bool StopThread() {
+            std::unique_lock<std::mutex> lock(mtx);
+            bool was = playing;
+            if (playing) {
+                pausedAt = rate ? NowLocked().ms * rate / 1000.0 : 0.0;
+                playing = false;
+            }
+            running = false;
+            lock.unlock();
+            if (thread.joinable() && thread.get_id() != std::this_thread::get_id()) thread.join();
+            lock.lock();
+            if (was && sink) {
+                sink->Stop();
+                if (wsola) wsola->Reset(pausedAt);
+            }
+            return was;
+        }
+
+        void CloseSinkLocked() {
+            if (sink && sinkOpen) sink->Close();
+            sinkOpen = false;
+        }
+
+        void Loop() {
+            std::vector<float> buf;
+            auto lastNotify = std::chrono::steady_clock::now();
+            for (;;) {
+                size_t room = sink->Wait(kBlock, 20);
+                if (!running) break;
+                if (room >= kBlock) {
+                    std::unique_lock<std::mutex> lock(mtx);
+                    if (!running) break;
+                    buf.resize(kBlock * channels);
+                    uint64_t before = written;
+                    if (before && sink->Played() >= before) stats.underruns++;
+                    auto t0 = std::chrono::steady_clock::now();
+                    RenderLocked(buf.data(), kBlock, true);
+                    stats.renderMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+                    stats.frames += kBlock;
+                    lock.unlock();
+                    sink->Write(buf.data(), kBlock);
+                }
+                bool finished = false;
+                {
+                    std::lock_guard<std::mutex> lock(mtx);
+                    if (endOut && sink->Played() >= endOut) {
+                        // Llegó al final: se para solo, con el reloj en la duración
+                        finished = true;
+                        playing = false;
+                        running = false;
+                        ended = true;
+                        pausedAt = (double)total;
+                        sink->Stop();
+                        wsola->Reset(pausedAt);
+                    }
+                }
+                auto now = std::chrono::steady_clock::now();
+                if (finished || now - lastNotify >= ListenInterval()) {
+                    lastNotify = now;
+                    Notify();
+                }
+                if (finished) break;
+            }
+        }
+
+        std::chrono::milliseconds ListenInterval() {
+            std::lock_guard<std::mutex> lock(listenerMtx);
+            return listenInterval;
+        }
+
+        void Notify() {
+            ClockFn fn;
+            {
+                std::lock_guard<std::mutex> lock(listenerMtx);
+                fn = listener;
+            }
+            if (fn) fn(Now());
+        }
+
+        PcmCache& cache;
+        mutable std::mutex mtx;
+        std::vector<Stem> stems;
+        std::unique_ptr<Stretch::Wsola> wsola;
+        std::unique_ptr<Sink> sink;
+        bool sinkOpen = false;
+        bool simd = true;
+        uint32_t rate = 0, channels = 2;
+        uint64_t total = 0;
+        double speed = 1.0;
+        double pausedAt = 0;
+        bool playing = false, ended = false;
+        std::atomic<bool> running{ false };
+        std::thread thread;
+        std::deque<Marker> markers;
+        uint64_t written = 0, endOut = 0;
+        Stats stats;
+
+        std::mutex listenerMtx;
+        ClockFn listener;
+        std::chrono::milliseconds listenInterval{ 50 };
+    };
+}
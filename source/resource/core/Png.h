@@ -0,0 +1,717 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @namespace Png
+ * @description Lectura y escritura de PNG sin dependencias (inflate/deflate propios), para las
+ * herramientas que reempaquetan texturas.
+ *
+ * Decode acepta todos los tipos de color y profundidades de PNG sin entrelazar y devuelve RGBA de
+ * 8 bits. Encode escribe RGBA de 8 bits con filtro adaptativo por fila, o paleta indexada si la
+ * imagen tiene 256 colores o menos; el deflate usa LZ77 con cadenas hash y Huffman dinámico.
+ */
+namespace Png {
+
+    struct Image {
+        uint32_t width = 0, height = 0;
+        std::vector<uint8_t> rgba;   // width * height * 4, fila a fila
+
+        void Resize(uint32_t w, uint32_t h) { width = w; height = h; rgba.assign((size_t)w * h * 4, 0); }
+        uint8_t* Row(uint32_t y) { return rgba.data() + (size_t)y * width * 4; }
+        const uint8_t* Row(uint32_t y) const { return rgba.data() + (size_t)y * width * 4; }
+    };
+
+    namespace Detail {
+        inline uint32_t Get32(const uint8_t* p) { return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3]; }
+        inline void Put32(std::string& o, uint32_t v) {
+            o += (char)(v >> 24); o += (char)((v >> 16) & 0xFF); o += (char)((v >> 8) & 0xFF); o += (char)(v & 0xFF);
+        }
+
+        inline uint32_t Crc32(const void* data, size_t n, uint32_t crc = 0) {
+            static const std::array<uint32_t, 256> table = [] {
+                std::array<uint32_t, 256> t{};
+                for (uint32_t i = 0; i < 256; i++) {
+                    uint32_t c = i;
+                    for (int k = 0; k < 8; k++) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                    t[i] = c;
+                }
+                return t;
+            }();
+            const uint8_t* p = (const uint8_t*)data;
+            crc = ~crc;
+            for (size_t i = 0; i < n; i++) crc = table[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+            return ~crc;
+        }
+
+        inline uint32_t Adler32(const uint8_t* p, size_t n) {
+            uint32_t a = 1, b = 0;
+            while (n) {
+                size_t k = std::min<size_t>(n, 5552);  // Sin desbordar antes del módulo
+                n -= k;
+                while (k--) { a += *p++; b += a; }
+                a %= 65521; b %= 65521;
+            }
+            return (b << 16) | a;
+        }
+
+        // Tablas de longitudes y distancias de deflate (RFC 1951)
+        constexpr uint16_t kLenBase[29] = { 3,4,5,6,7,8,9,10,11,13,15,17,19,23,27,31,35,43,51,59,67,83,99,115,131,163,195,227,258 };
+        constexpr uint8_t kLenExtra[29] = { 0,0,0,0,0,0,0,0,1,1,1,1,2,2,2,2,3,3,3,3,4,4,4,4,5,5,5,5,0 };
+        constexpr uint16_t kDistBase[30] = { 1,2,3,4,5,7,9,13,17,25,33,49,65,97,129,193,257,385,513,769,1025,1537,2049,3073,4097,6145,8193,12289,16385,24577 };
+        constexpr uint8_t kDistExtra[30] = { 0,0,0,0,1,1,2,2,3,3,4,4,5,5,6,6,7,7,8,8,9,9,10,10,11,11,12,12,13,13 };
+        constexpr uint8_t kCodeLengthOrder[19] = { 16,17,18,0,8,7,9,6,10,5,11,4,12,3,13,2,14,1,15 };
+
+        inline uint32_t Reverse(uint32_t code, int len) {
+            uint32_t r = 0;
+            for (int i = 0; i < len; i++) { r = (r << 1) | (code & 1); code >>= 1; }
+            return r;
+        }
+
+        // --- Inflate ---
+
+        class BitReader {
+        public:
+            BitReader(const uint8_t* p, size_t n) : p(p), n(n) {}
+
+            /** Garantiza `k` bits (<= 32) en el buffer; false si se acabó la entrada. */
+            bool Need(int k) {
+                while (count < k) {
+                    if (pos >= n) return false;
+                    bits |= (uint64_t)p[pos++] << count;
+                    count += 8;
+                }
+                return true;
+            }
+            uint32_t Peek(int k) const { return (uint32_t)(bits & ((1ull << k) - 1)); }
+            void Drop(int k) { bits >>= k; count -= k; }
+            bool Get(int k, uint32_t& v) {
+                if (!Need(k)) return false;
+                v = Peek(k); Drop(k);
+                return true;
+            }
+            /** Llena lo que pueda sin fallar (para decodificar Huffman cerca del final). */
+            void Fill() { while (count <= 56 && pos < n) { bits |= (uint64_t)p[pos++] << count; count += 8; } }
+            void AlignToByte() { Drop(count & 7); }
+            int Available() const { return count; }
+
+            /** Bytes sin comprimir (bloque almacenado) tras alinear. */
+            bool Copy(std::vector<uint8_t>& out, size_t len) {
+                while (len && count >= 8) { out.push_back((uint8_t)bits); Drop(8); len--; }
+                if (len > n - pos) return false;
+                out.insert(out.end(), p + pos, p + pos + len);
+                pos += len;
+                return true;
+            }
+
+        private:
+            const uint8_t* p;
+            size_t n, pos = 0;
+            uint64_t bits = 0;
+            int count = 0;
+        };
+
+        /**
+         * Tabla de decodificación directa: 2^maxLen entradas (símbolo << 4 | longitud),
+         * indexadas por los bits siguientes en orden LSB.
+         */
+        class Decoder {
+        public:
+            bool Build(const uint8_t* lengths, int n) {
+                maxLen = 0;
+                uint16_t counts[16] = {};
+                for (int i = 0; i < n; i++) { counts[lengths[i]]++; maxLen = std::max<int>(maxLen, lengths[i]); }
+                counts[0] = 0;
+                // Código incompleto de un solo símbolo: válido en distancias
+                if (maxLen == 0) { table.assign(2, 0); maxLen = 1; return true; }
+                int left = 1;
+                for (int l = 1; l <= 15; l++) { left <<= 1; left -= counts[l]; if (left < 0) return false; }
+                uint16_t next[16] = {};
+                for (int l = 1, code = 0; l <= 15; l++) { code = (code + counts[l - 1]) << 1; next[l] = (uint16_t)code; }
+                table.assign((size_t)1 << maxLen, 0);
+                for (int s = 0; s < n; s++) {
+                    int l = lengths[s];
+                    if (!l) continue;
+                    uint32_t r = Reverse(next[l]++, l);
+                    for (uint32_t i = r; i < table.size(); i += 1u << l) table[i] = (uint32_t)(s << 4 | l);
+                }
+                return true;
+            }
+
+            int Decode(BitReader& br) const {
+                if (!br.Need(maxLen)) br.Fill();
+                uint32_t e = table[br.Peek(maxLen)];
+                int l = (int)(e & 15);
+                if (l == 0 || l > br.Available()) return -1;
+                br.Drop(l);
+                return (int)(e >> 4);
+            }
+
+        private:
+            std::vector<uint32_t> table;
+            int maxLen = 0;
+        };
+
+        /**
+         * Descomprime un flujo zlib completo.
+         * @param {size_t} expected - Tamaño esperado de la salida (reserva y límite).
+         */
+        inline bool Inflate(const uint8_t* src, size_t n, std::vector<uint8_t>& out, size_t expected, std::string* err) {
+            auto fail = [&](const char* what) { if (err) *err = what; return false; };
+            if (n < 6 || (src[0] & 0x0F) != 8 || ((src[0] << 8) | src[1]) % 31 != 0 || (src[1] & 0x20)) return fail("bad zlib header");
+            out.clear();
+            out.reserve(expected);
+            BitReader br(src + 2, n - 2);
+            Decoder lit, dist;
+            uint32_t last = 0;
+            while (!last) {
+                uint32_t type;
+                if (!br.Get(1, last) || !br.Get(2, type)) return fail("truncated deflate");
+                if (type == 0) {
+                    br.AlignToByte();
+                    uint32_t len, nlen;
+                    if (!br.Get(16, len) || !br.Get(16, nlen) || (len ^ 0xFFFF) != nlen) return fail("bad stored block");
+                    if (!br.Copy(out, len)) return fail("truncated stored block");
+                    continue;
+                }
+                if (type == 1) {
+                    uint8_t l[288 + 30];
+                    std::fill(l, l + 144, 8); std::fill(l + 144, l + 256, 9); std::fill(l + 256, l + 280, 7); std::fill(l + 280, l + 288, 8);
+                    std::fill(l + 288, l + 318, 5);
+                    lit.Build(l, 288); dist.Build(l + 288, 30);
+                } else if (type == 2) {
+                    uint32_t hlit, hdist, hclen;
+                    if (!br.Get(5, hlit) || !br.Get(5, hdist) || !br.Get(4, hclen)) return fail("truncated deflate");
+                    hlit += 257; hdist += 1; hclen += 4;
+                    uint8_t cl[19] = {};
+                    for (uint32_t i = 0; i < hclen; i++) { uint32_t v; if (!br.Get(3, v)) return fail("truncated deflate"); cl[kCodeLengthOrder[i]] = (uint8_t)v; }
+                    Decoder clDec;
+                    if (!clDec.Build(cl, 19)) return fail("bad code lengths");
+                    uint8_t lengths[320] = {};
+                    for (uint32_t i = 0; i < hlit + hdist;) {
+                        int sym = clDec.Decode(br);
+                        if (sym < 0) return fail("bad code lengths");
+                        if (sym < 16) { lengths[i++] = (uint8_t)sym; continue; }
+                        uint32_t rep, value = 0;
+                        if (sym == 16) { if (!i || !br.Get(2, rep)) return fail("bad code lengths"); rep += 3; value = lengths[i - 1]; }
+                        else if (sym == 17) { if (!br.Get(3, rep)) return fail("bad code lengths"); rep += 3; }
+                        else { if (!br.Get(7, rep)) return fail("bad code lengths"); rep += 11; }
+                        if (i + rep > hlit + hdist) return fail("bad code lengths");
+                        while (rep--) lengths[i++] = (uint8_t)value;
+                    }
+                    if (!lit.Build(lengths, (int)hlit) || !dist.Build(lengths + hlit, (int)hdist)) return fail("bad huffman table");
+                } else {
+                    return fail("bad block type");
+                }
+                for (;;) {
+                    int sym = lit.Decode(br);
+                    if (sym < 0) return fail("bad literal");
+                    if (sym < 256) { out.push_back((uint8_t)sym); continue; }
+                    if (sym == 256) break;
+                    sym -= 257;
+                    if (sym >= 29) return fail("bad length");
+                    uint32_t extra = 0, dextra = 0;
+                    if (!br.Get(kLenExtra[sym], extra)) return fail("truncated deflate");
+                    size_t len = kLenBase[sym] + extra;
+                    int ds = dist.Decode(br);
+                    if (ds < 0 || ds >= 30) return fail("bad distance");
+                    if (!br.Get(kDistExtra[ds], dextra)) return fail("truncated deflate");
+                    size_t d = kDistBase[ds] + dextra;
+                    if (d > out.size()) return fail("distance too far");
+                    if (out.size() + len > expected) return fail("too much data");
+                    size_t from = out.size() - d;
+                    out.resize(out.size() + len);
+                    uint8_t* o = out.data() + out.size() - len;
+                    const uint8_t* s = out.data() + from;
+                    // Solapado a propósito cuando d < len (repetición)
+                    for (size_t k = 0; k < len; k++) o[k] = s[k];
+                }
+                if (out.size() > expected) return fail("too much data");
+            }
+            return true;
+        }
+
+        // --- Deflate ---
+
+        class BitWriter {
+        public:
+            explicit BitWriter(std::string& out) : out(out) {}
+            void Put(uint32_t v, int n) {
+                bits |= (uint64_t)v << count;
+                count += n;
+                while (count >= 8) { out += (char)(bits & 0xFF); bits >>= 8; count -= 8; }
+            }
+            void Flush() { if (count) { out += (char)(bits & 0xFF); bits = 0; count = 0; } }
+
+        private:
+            std::string& out;
+            uint64_t bits = 0;
+            int count = 0;
+        };
+
+        /**
+         * Longitudes de Huffman limitadas a `maxLen` bits para las frecuencias dadas.
+         * Árbol de Huffman normal y, si se pasa del límite, se reajusta el reparto por
+         * longitudes (como miniz) y se reasigna por orden de frecuencia.
+         */
+        inline void BuildLengths(const uint32_t* freq, int n, int maxLen, uint8_t* lengths) {
+            std::fill(lengths, lengths + n, 0);
+            std::vector<int> syms;
+            for (int i = 0; i < n; i++) if (freq[i]) syms.push_back(i);
+            if (syms.empty()) return;
+            // Un solo símbolo: se le da pareja para que el código quede completo (zlib rechaza
+            // códigos incompletos salvo en distancias)
+            if (syms.size() == 1) { lengths[syms[0]] = 1; lengths[syms[0] ? 0 : 1] = 1; return; }
+            std::stable_sort(syms.begin(), syms.end(), [&](int a, int b) { return freq[a] < freq[b]; });
+
+            // Huffman con dos colas (hojas ordenadas + nodos internos en orden de creación)
+            size_t m = syms.size();
+            std::vector<uint64_t> weight(2 * m);
+            std::vector<int> parent(2 * m, -1);
+            for (size_t i = 0; i < m; i++) weight[i] = freq[syms[i]];
+            size_t leaf = 0, inner = m, next = m;
+            auto take = [&] {
+                if (leaf < m && (inner >= next || weight[leaf] <= weight[inner])) return leaf++;
+                return inner++;
+            };
+            while (next < 2 * m - 1) {
+                size_t a = take(), b = take();
+                weight[next] = weight[a] + weight[b];
+                parent[a] = parent[b] = (int)next;
+                next++;
+            }
+            std::vector<int> depth(2 * m, 0);
+            for (size_t i = 2 * m - 2; i-- > 0;) depth[i] = depth[parent[i]] + 1;
+
+            std::vector<int> count(std::max(maxLen, 64) + 1, 0);
+            for (size_t i = 0; i < m; i++) count[std::min(depth[i], maxLen)]++;
+            uint64_t total = 0;
+            for (int l = 1; l <= maxLen; l++) total += (uint64_t)count[l] << (maxLen - l);
+            while (total > (1ull << maxLen)) {
+                count[maxLen]--;
+                for (int l = maxLen - 1; l > 0; l--) {
+                    if (count[l]) { count[l]--; count[l + 1] += 2; break; }
+                }
+                total--;
+            }
+            // Los más frecuentes (al final de syms) reciben las longitudes más cortas
+            size_t s = 0;
+            for (int l = maxLen; l >= 1; l--) for (int k = 0; k < count[l]; k++) lengths[syms[s++]] = (uint8_t)l;
+        }
+
+        inline void CanonicalCodes(const uint8_t* lengths, int n, uint16_t* codes) {
+            uint16_t counts[16] = {}, next[16] = {};
+            for (int i = 0; i < n; i++) counts[lengths[i]]++;
+            counts[0] = 0;
+            for (int l = 1, code = 0; l <= 15; l++) { code = (code + counts[l - 1]) << 1; next[l] = (uint16_t)code; }
+            for (int i = 0; i < n; i++) codes[i] = lengths[i] ? (uint16_t)Reverse(next[lengths[i]]++, lengths[i]) : 0;
+        }
+
+        inline int LengthSymbol(int len) {
+            int s = 0;
+            while (s < 28 && kLenBase[s + 1] <= len) s++;
+            return s;
+        }
+
+        inline int DistanceSymbol(int d) {
+            int s = 0;
+            while (s < 29 && kDistBase[s + 1] <= d) s++;
+            return s;
+        }
+
+        /**
+         * Símbolos LZ77 de un bloque: literal (len = 0) o coincidencia (len, dist).
+         */
+        struct Token { uint16_t len, dist; uint8_t lit; };
+
+        inline void WriteBlock(BitWriter& bw, const std::vector<Token>& tokens, bool last) {
+            static const auto lenSym = [] { std::array<uint8_t, 259> t{}; for (int l = 3; l <= 258; l++) t[l] = (uint8_t)LengthSymbol(l); return t; }();
+            static const auto distSymLow = [] { std::array<uint8_t, 513> t{}; for (int d = 1; d <= 512; d++) t[d] = (uint8_t)DistanceSymbol(d); return t; }();
+            auto distSym = [](int d) { return d <= 512 ? distSymLow[d] : (uint8_t)DistanceSymbol(d); };
+
+            uint32_t lf[286] = {}, df[30] = {};
+            for (const Token& t : tokens) {
+                if (!t.len) lf[t.lit]++;
+                else { lf[257 + lenSym[t.len]]++; df[distSym(t.dist)]++; }
+            }
+            lf[256] = 1;
+            uint8_t ll[286], dl[30];
+            BuildLengths(lf, 286, 15, ll);
+            BuildLengths(df, 30, 15, dl);
+            // Un decodificador necesita al menos un código de distancia
+            int used = 0;
+            for (int i = 0; i < 30; i++) used += dl[i] != 0;
+            if (used == 0) dl[0] = 1;
+            int hlit = 286, hdist = 30;
+            while (hlit > 257 && !ll[hlit - 1]) hlit--;
+            while (hdist > 1 && !dl[hdist - 1]) hdist--;
+
+            // Longitudes con RLE (16 = repetir la anterior, 17/18 = ceros)
+            std::vector<uint8_t> all(ll, ll + hlit);
+            all.insert(all.end(), dl, dl + hdist);
+            std::vector<std::pair<uint8_t, uint8_t>> rle;  // (símbolo, extra)
+            for (size_t i = 0; i < all.size();) {
+                size_t run = 1;
+                while (i + run < all.size() && all[i + run] == all[i]) run++;
+                if (all[i] == 0 && run >= 3) {
+                    size_t r = std::min<size_t>(run, 138);
+                    rle.push_back(r >= 11 ? std::make_pair((uint8_t)18, (uint8_t)(r - 11)) : std::make_pair((uint8_t)17, (uint8_t)(r - 3)));
+                    i += r;
+                } else if (all[i] != 0 && run >= 4) {
+                    rle.push_back({ all[i], 0 });
+                    size_t r = std::min<size_t>(run - 1, 6);
+                    rle.push_back({ 16, (uint8_t)(r - 3) });
+                    i += 1 + r;
+                } else {
+                    rle.push_back({ all[i], 0 });
+                    i++;
+                }
+            }
+            uint32_t cf[19] = {};
+            for (auto& r : rle) cf[r.first]++;
+            uint8_t cl[19];
+            BuildLengths(cf, 19, 7, cl);
+            int hclen = 19;
+            while (hclen > 4 && !cl[kCodeLengthOrder[hclen - 1]]) hclen--;
+
+            uint16_t lc[286], dc[30], cc[19];
+            CanonicalCodes(ll, 286, lc);
+            CanonicalCodes(dl, 30, dc);
+            CanonicalCodes(cl, 19, cc);
+
+            bw.Put(last ? 1 : 0, 1);
+            bw.Put(2, 2);
+            bw.Put((uint32_t)(hlit - 257), 5);
+            bw.Put((uint32_t)(hdist - 1), 5);
+            bw.Put((uint32_t)(hclen - 4), 4);
+            for (int i = 0; i < hclen; i++) bw.Put(cl[kCodeLengthOrder[i]], 3);
+            for (auto& r : rle) {
+                bw.Put(cc[r.first], cl[r.first]);
+                if (r.first == 16) bw.Put(r.second, 2);
+                else if (r.first == 17) bw.Put(r.second, 3);
+                else if (r.first == 18) bw.Put(r.second, 7);
+            }
+            for (const Token& t : tokens) {
+                if (!t.len) { bw.Put(lc[t.lit], ll[t.lit]); continue; }
+                int ls = lenSym[t.len], ds = distSym(t.dist);
+                bw.Put(lc[257 + ls], ll[257 + ls]);
+                if (kLenExtra[ls]) bw.Put(t.len - kLenBase[ls], kLenExtra[ls]);
+                bw.Put(dc[ds], dl[ds]);
+                if (kDistExtra[ds]) bw.Put(t.dist - kDistBase[ds], kDistExtra[ds]);
+            }
+            bw.Put(lc[256], ll[256]);
+        }
+
+        /**
+         * Comprime `data` como flujo zlib (LZ77 con cadenas hash y coincidencia perezosa).
+         * @param {int} chain - Candidatos máximos por posición: más = mejor ratio y más lento.
+         */
+        inline void Deflate(const uint8_t* data, size_t n, std::string& out, int chain = 32) {
+            constexpr int kWindow = 32768, kHashBits = 15, kMinMatch = 3, kMaxMatch = 258, kNice = 128;
+            constexpr size_t kBlockTokens = 1 << 16;
+            out += (char)0x78; out += (char)0x9C;
+            BitWriter bw(out);
+            std::vector<int32_t> head((size_t)1 << kHashBits, -1), prev(kWindow, -1);
+            auto hash = [&](size_t i) { return ((uint32_t)data[i] << 10 ^ (uint32_t)data[i + 1] << 5 ^ data[i + 2]) & ((1u << kHashBits) - 1); };
+            auto insert = [&](size_t i) {
+                if (i + kMinMatch > n) return;
+                uint32_t h = hash(i);
+                prev[i & (kWindow - 1)] = head[h];
+                head[h] = (int32_t)i;
+            };
+            auto longest = [&](size_t i, int& bestDist) {
+                int best = 0;
+                if (i + kMinMatch > n) return 0;
+                int limit = (int)std::min<size_t>(kMaxMatch, n - i);
+                int32_t cand = head[hash(i)];
+                for (int tries = chain; cand >= 0 && tries > 0; tries--) {
+                    size_t d = i - (size_t)cand;
+                    if (d == 0 || d > (size_t)kWindow - 1) break;
+                    const uint8_t* a = data + i;
+                    const uint8_t* b = data + cand;
+                    if (b[best] == a[best] && b[0] == a[0]) {
+                        int l = 0;
+                        while (l < limit && a[l] == b[l]) l++;
+                        if (l > best) { best = l; bestDist = (int)d; if (l >= kNice || l == limit) break; }
+                    }
+                    int32_t p = prev[(size_t)cand & (kWindow - 1)];
+                    if (p >= cand) break;
+                    cand = p;
+                }
+                return best >= kMinMatch ? best : 0;
+            };
+
+            std::vector<Token> tokens;
+            tokens.reserve(kBlockTokens);
+            size_t i = 0;
+            while (i < n) {
+                int dist = 0, len = longest(i, dist);
+                if (len && len < kNice && i + 1 < n) {
+                    // Perezosa: si empezar un byte después da más, este va como literal
+                    insert(i);
+                    int dist2 = 0, len2 = longest(i + 1, dist2);
+                    if (len2 > len) { tokens.push_back({ 0, 0, data[i] }); i++; len = len2; dist = dist2; }
+                    else {
+                        tokens.push_back({ (uint16_t)len, (uint16_t)dist, 0 });
+                        for (size_t k = 1; k < (size_t)len; k++) insert(i + k);
+                        i += len;
+                        if (tokens.size() >= kBlockTokens) { WriteBlock(bw, tokens, false); tokens.clear(); }
+                        continue;
+                    }
+                }
+                if (len) {
+                    tokens.push_back({ (uint16_t)len, (uint16_t)dist, 0 });
+                    for (size_t k = 0; k < (size_t)len; k++) insert(i + k);
+                    i += len;
+                } else {
+                    tokens.push_back({ 0, 0, data[i] });
+                    insert(i);
+                    i++;
+                }
+                if (tokens.size() >= kBlockTokens) { WriteBlock(bw, tokens, false); tokens.clear(); }
+            }
+            WriteBlock(bw, tokens, true);
+            bw.Flush();
+            Put32(out, Adler32(data, n));
+        }
+
+        inline void Chunk(std::string& out, const char* type, const std::string& body) {
+            Put32(out, (uint32_t)body.size());
+            size_t at = out.size();
+            out.append(type, 4);
+            out += body;
+            Put32(out, Crc32(out.data() + at, out.size() - at));
+        }
+
+        inline uint8_t Paeth(int a, int b, int c) {
+            int p = a + b - c, pa = std::abs(p - a), pb = std::abs(p - b), pc = std::abs(p - c);
+            return (uint8_t)(pa <= pb && pa <= pc ? a : pb <= pc ? b : c);
+        }
+    }
+
+    /**
+     * Decodifica un PNG (sin entrelazar) a RGBA de 8 bits.
+     */
+    inline bool Decode(const void* data, size_t size, Image& out, std::string* err = nullptr) {
+        using namespace Detail;
+        auto fail = [&](const std::string& what) { if (err) *err = what; return false; };
+        const uint8_t* p = (const uint8_t*)data;
+        static const uint8_t kSig[8] = { 0x89, 'P', 'N', 'G', 0x0D, 0x0A, 0x1A, 0x0A };
+        if (size < 8 || std::memcmp(p, kSig, 8) != 0) return fail("not a png");
+
+        uint32_t w = 0, h = 0;
+        int depth = 0, type = -1;
+        std::vector<uint8_t> idat, palette, trns;
+        bool ended = false;
+        for (size_t pos = 8; pos + 12 <= size && !ended;) {
+            uint32_t len = Get32(p + pos);
+            if (len > size - pos - 12) return fail("truncated chunk");
+            const uint8_t* ct = p + pos + 4;
+            const uint8_t* body = ct + 4;
+            if (Crc32(ct, len + 4) != Get32(body + len)) return fail("bad crc in " + std::string((const char*)ct, 4));
+            if (!std::memcmp(ct, "IHDR", 4)) {
+                if (len != 13) return fail("bad IHDR");
+                w = Get32(body); h = Get32(body + 4); depth = body[8]; type = body[9];
+                if (body[10] || body[11]) return fail("unknown compression or filter");
+                if (body[12]) return fail("interlaced png not supported");
+            }
+            else if (!std::memcmp(ct, "PLTE", 4)) palette.assign(body, body + len);
+            else if (!std::memcmp(ct, "tRNS", 4)) trns.assign(body, body + len);
+            else if (!std::memcmp(ct, "IDAT", 4)) idat.insert(idat.end(), body, body + len);
+            else if (!std::memcmp(ct, "IEND", 4)) ended = true;
+            pos += 12 + (size_t)len;
+        }
+        int channels = type == 0 ? 1 : type == 2 ? 3 : type == 3 ? 1 : type == 4 ? 2 : type == 6 ? 4 : 0;
+        bool depthOk = depth == 8 || (depth == 16 && type != 3) || ((depth == 1 || depth == 2 || depth == 4) && (type == 0 || type == 3));
+        if (!w || !h || !channels || !depthOk) return fail("unsupported png format");
+        if ((uint64_t)w * h > (1ull << 28)) return fail("image too large");
+        if (type == 3 && (palette.empty() || palette.size() % 3)) return fail("missing palette");
+
+        size_t rowBytes = ((size_t)w * channels * depth + 7) / 8;
+        size_t bpp = std::max<size_t>(1, (size_t)channels * depth / 8);
+        std::vector<uint8_t> raw;
+        if (!Inflate(idat.data(), idat.size(), raw, h * (rowBytes + 1), err)) return false;
+        if (raw.size() != h * (rowBytes + 1)) return fail("wrong image data size");
+
+        // Quita los filtros en el sitio
+        std::vector<uint8_t> zero(rowBytes, 0);
+        for (uint32_t y = 0; y < h; y++) {
+            uint8_t* row = raw.data() + y * (rowBytes + 1);
+            uint8_t filter = row[0];
+            uint8_t* cur = row + 1;
+            const uint8_t* up = y ? cur - (rowBytes + 1) : zero.data();
+            switch (filter) {
+            case 0: break;
+            case 1: for (size_t i = bpp; i < rowBytes; i++) cur[i] = (uint8_t)(cur[i] + cur[i - bpp]); break;
+            case 2: for (size_t i = 0; i < rowBytes; i++) cur[i] = (uint8_t)(cur[i] + up[i]); break;
+            case 3:
+                for (size_t i = 0; i < rowBytes; i++) cur[i] = (uint8_t)(cur[i] + (((i >= bpp ? cur[i - bpp] : 0) + up[i]) >> 1));
+                break;
+            case 4:
+                for (size_t i = 0; i < rowBytes; i++) {
+                    int a = i >= bpp ? cur[i - bpp] : 0, c = i >= bpp ? up[i - bpp] : 0;
+                    cur[i] = (uint8_t)(cur[i] + Paeth(a, up[i], c));
+                }
+                break;
+            default: return fail("bad filter type");
+            }
+        }
+
+        out.Resize(w, h);
+        auto sample = [&](const uint8_t* row, size_t i) -> uint32_t {
+            // Muestra i de la fila con la profundidad original
+            if (depth == 8) return row[i];
+            if (depth == 16) return (uint32_t)row[2 * i] << 8 | row[2 * i + 1];
+            size_t bit = i * depth;
+            return (row[bit >> 3] >> (8 - depth - (bit & 7))) & ((1u << depth) - 1);
+        };
+        auto to8 = [&](uint32_t v) -> uint8_t {
+            if (depth == 8) return (uint8_t)v;
+            if (depth == 16) return (uint8_t)(v >> 8);
+            return (uint8_t)(v * 255 / ((1u << depth) - 1));
+        };
+        uint32_t key[3] = { UINT32_MAX, UINT32_MAX, UINT32_MAX };
+        if (type == 0 && trns.size() >= 2) key[0] = (uint32_t)trns[0] << 8 | trns[1];
+        if (type == 2 && trns.size() >= 6) for (int c = 0; c < 3; c++) key[c] = (uint32_t)trns[2 * c] << 8 | trns[2 * c + 1];
+        size_t colors = palette.size() / 3;
+        for (uint32_t y = 0; y < h; y++) {
+            const uint8_t* row = raw.data() + y * (rowBytes + 1) + 1;
+            uint8_t* o = out.Row(y);
+            for (uint32_t x = 0; x < w; x++, o += 4) {
+                size_t s = (size_t)x * channels;
+                switch (type) {
+                case 0: { uint32_t v = sample(row, s); o[0] = o[1] = o[2] = to8(v); o[3] = v == key[0] ? 0 : 255; break; }
+                case 2: {
+                    uint32_t r = sample(row, s), g = sample(row, s + 1), b = sample(row, s + 2);
+                    o[0] = to8(r); o[1] = to8(g); o[2] = to8(b);
+                    o[3] = r == key[0] && g == key[1] && b == key[2] ? 0 : 255;
+                    break;
+                }
+                case 3: {
+                    uint32_t idx = sample(row, s);
+                    if (idx >= colors) return fail("palette index out of range");
+                    o[0] = palette[idx * 3]; o[1] = palette[idx * 3 + 1]; o[2] = palette[idx * 3 + 2];
+                    o[3] = idx < trns.size() ? trns[idx] : 255;
+                    break;
+                }
+                case 4: o[0] = o[1] = o[2] = to8(sample(row, s)); o[3] = to8(sample(row, s + 1)); break;
+                default: for (int c = 0; c < 4; c++) o[c] = to8(sample(row, s + c)); break;
+                }
+            }
+        }
+        return true;
+    }
+
+    /**
+     * Codifica RGBA de 8 bits. Con 256 colores o menos se escribe con paleta (los píxeles
+     * transparentes conservan su color, así que la imagen decodificada es idéntica).
+     * @param {int} chain - Esfuerzo del compresor (candidatos por posición).
+     */
+    inline void Encode(const Image& img, std::string& out, int chain = 32) {
+        using namespace Detail;
+        static const char kSig[8] = { (char)0x89, 'P', 'N', 'G', 0x0D, 0x0A, 0x1A, 0x0A };
+        out.append(kSig, 8);
+
+        // ¿Cabe en una paleta?
+        std::unordered_map<uint32_t, uint8_t> index;
+        std::vector<uint32_t> colors;
+        bool indexed = true;
+        size_t pixels = (size_t)img.width * img.height;
+        for (size_t i = 0; i < pixels && indexed; i++) {
+            uint32_t c;
+            std::memcpy(&c, img.rgba.data() + i * 4, 4);
+            if (index.count(c)) continue;
+            if (colors.size() == 256) { indexed = false; break; }
+            index.emplace(c, (uint8_t)colors.size());
+            colors.push_back(c);
+        }
+        if (pixels == 0) indexed = false;
+
+        std::string ihdr;
+        Put32(ihdr, img.width); Put32(ihdr, img.height);
+        ihdr += (char)8; ihdr += (char)(indexed ? 3 : 6);
+        ihdr.append(3, '\0');
+        Chunk(out, "IHDR", ihdr);
+
+        std::vector<uint8_t> raw, plain;
+        if (indexed) {
+            // Las entradas opacas van al final para recortar tRNS
+            std::vector<size_t> order(colors.size());
+            for (size_t i = 0; i < order.size(); i++) order[i] = i;
+            std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+                return (colors[a] >> 24) != 0xFF && (colors[b] >> 24) == 0xFF;
+            });
+            std::vector<uint8_t> remap(colors.size());
+            std::string plte, trns;
+            for (size_t k = 0; k < order.size(); k++) {
+                uint32_t c = colors[order[k]];
+                remap[order[k]] = (uint8_t)k;
+                plte += (char)(c & 0xFF); plte += (char)((c >> 8) & 0xFF); plte += (char)((c >> 16) & 0xFF);
+                if ((c >> 24) != 0xFF) trns += (char)(c >> 24);
+            }
+            Chunk(out, "PLTE", plte);
+            if (!trns.empty()) Chunk(out, "tRNS", trns);
+            raw.resize((size_t)img.height * (img.width + 1));
+            for (uint32_t y = 0; y < img.height; y++) {
+                uint8_t* o = raw.data() + (size_t)y * (img.width + 1);
+                o[0] = 0;
+                const uint8_t* r = img.Row(y);
+                for (uint32_t x = 0; x < img.width; x++) {
+                    uint32_t c;
+                    std::memcpy(&c, r + x * 4, 4);
+                    o[1 + x] = remap[index[c]];
+                }
+            }
+        } else {
+            // Filtro adaptativo: el de menor suma de valores absolutos por fila. En sprites con
+            // colores planos y mucho transparente suele ganar no filtrar: se comprimen las dos
+            // versiones y se queda la menor
+            size_t rowBytes = (size_t)img.width * 4;
+            plain.resize((size_t)img.height * (rowBytes + 1));
+            for (uint32_t y = 0; y < img.height; y++) {
+                plain[(size_t)y * (rowBytes + 1)] = 0;
+                std::memcpy(plain.data() + (size_t)y * (rowBytes + 1) + 1, img.Row(y), rowBytes);
+            }
+            raw.resize(plain.size());
+            std::vector<uint8_t> zero(rowBytes, 0), trial(rowBytes);
+            for (uint32_t y = 0; y < img.height; y++) {
+                const uint8_t* cur = img.Row(y);
+                const uint8_t* up = y ? img.Row(y - 1) : zero.data();
+                uint8_t* o = raw.data() + (size_t)y * (rowBytes + 1);
+                uint64_t best = UINT64_MAX;
+                for (int f = 0; f < 5; f++) {
+                    uint64_t sum = 0;
+                    for (size_t i = 0; i < rowBytes; i++) {
+                        int a = i >= 4 ? cur[i - 4] : 0, b = up[i], c = i >= 4 ? up[i - 4] : 0;
+                        uint8_t v = cur[i];
+                        switch (f) {
+                        case 1: v = (uint8_t)(v - a); break;
+                        case 2: v = (uint8_t)(v - b); break;
+                        case 3: v = (uint8_t)(v - ((a + b) >> 1)); break;
+                        case 4: v = (uint8_t)(v - Paeth(a, b, c)); break;
+                        default: break;
+                        }
+                        trial[i] = v;
+                        sum += v < 128 ? v : 256 - v;
+                    }
+                    if (sum < best) { best = sum; o[0] = (uint8_t)f; std::memcpy(o + 1, trial.data(), rowBytes); }
+                }
+            }
+        }
+        std::string z;
+        Deflate(raw.data(), raw.size(), z, chain);
+        if (!indexed) {
+            std::string zPlain;
+            Deflate(plain.data(), plain.size(), zPlain, chain);
+            if (zPlain.size() < z.size()) z.swap(zPlain);
+        }
+        Chunk(out, "IDAT", z);
+        Chunk(out, "IEND", std::string());
+    }
+}
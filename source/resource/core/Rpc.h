@@ -0,0 +1,425 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+
+/**
+ * @file Rpc.h
+ * @description Protocolo RPC del puente JS <-> nativo. Independiente de la plataforma.
+ *
+ * Sobre (versión 1), tanto para peticiones como para respuestas:
+ *   "#1|" { "<id>|<tag>|<len>|<payload>" }*
+ *
+ * Antes de cada frame puede repetirse la cabecera "#1|" (la página la repite en cada petición):
+ * si un frame llega mal formado se responde "err" a su id y el parseo sigue en la siguiente
+ * cabecera, así que un frame roto no deja sin respuesta a los que vienen detrás.
+ *
+ * - id: número decimal de 32 bits. 0 = sin respuesta (peticiones) o evento (respuestas).
+ * - tag: verbo en las peticiones; "ok" / "err" en las respuestas.
+ * - len: longitud del payload en unidades de código (UTF-16 en JS y Windows).
+ *
+ * Al ir prefijado por longitud, el payload no necesita escapes y el parseo se hace
+ * con vistas sobre el mensaje original, sin copias.
+ * Los mensajes sin sobre ("verbo:payload") se siguen aceptando como formato legado.
+ */
+
+/**
+ * @struct RpcRequest
+ * @description Petición decodificada. Las vistas apuntan al mensaje original.
+ */
+struct RpcRequest {
+    uint32_t id = 0;
+    std::wstring_view verb;
+    std::wstring_view payload;
+    bool legacy = false;
+    const std::atomic<bool>* cancel = nullptr; // Solo en peticiones asíncronas
+
+    /** Los handlers largos lo consultan para abandonar peticiones canceladas. */
+    bool Cancelled() const { return cancel && cancel->load(std::memory_order_relaxed); }
+};
+
+/**
+ * @enum RpcMode
+ * @description Dónde se ejecuta un handler.
+ * Inline: en el hilo de UI (ventanas, diálogos, COM del WebView).
+ * Pool: en un hilo del pool, en paralelo (E/S bloqueante).
+ * Serial: en el pool pero de uno en uno y en orden de llegada (escrituras).
+ */
+enum class RpcMode { Inline, Pool, Serial };
+
+/**
+ * @namespace RpcCodec
+ * @description Codificación y decodificación del sobre RPC.
+ */
+namespace RpcCodec {
+
+    constexpr std::wstring_view kMagic = L"#1|";
+    constexpr std::wstring_view kOk = L"ok";
+    constexpr std::wstring_view kErr = L"err";
+
+    inline bool IsEnvelope(std::wstring_view msg) {
+        return msg.size() >= kMagic.size() && msg.substr(0, kMagic.size()) == kMagic;
+    }
+
+    /**
+     * Lee un entero decimal sin signo hasta el separador indicado y avanza la vista.
+     * @returns {bool} false si no hay dígitos, el separador no aparece o el valor pasa de `max`.
+     */
+    inline bool ReadNumber(std::wstring_view& s, uint64_t& value, wchar_t sep = L'|', uint64_t max = UINT64_MAX) {
+        size_t i = 0; value = 0;
+        while (i < s.size() && s[i] >= L'0' && s[i] <= L'9') {
+            uint64_t digit = (uint64_t)(s[i] - L'0');
+            if (value > (max - digit) / 10) return false;
+            value = value * 10 + digit; i++;
+        }
+        if (i == 0 || i >= s.size() || s[i] != sep) return false;
+        s.remove_prefix(i + 1);
+        return true;
+    }
+
+    /**
+     * Parsea un entero con signo (para payloads como "1280,720").
+     */
+    inline int ParseInt(std::wstring_view s, int def = 0) {
+        size_t i = 0; bool neg = false; long long v = 0;
+        while (i < s.size() && (s[i] == L' ' || s[i] == L'\t')) i++;
+        if (i < s.size() && (s[i] == L'-' || s[i] == L'+')) { neg = s[i] == L'-'; i++; }
+        size_t start = i;
+        while (i < s.size() && s[i] >= L'0' && s[i] <= L'9' && v < 0x7FFFFFFF) { v = v * 10 + (s[i] - L'0'); i++; }
+        if (i == start) return def;
+        return (int)(neg ? -v : v);
+    }
+
+    /**
+     * Parsea un número decimal (ej: tiempos en ms "10378.3779").
+     */
+    inline double ParseDouble(std::wstring_view s, double def = 0.0) {
+        char buf[64]; size_t n = 0;
+        for (wchar_t c : s) {
+            if (n + 1 >= sizeof(buf) || c > 0x7F) break;
+            buf[n++] = (char)c;
+        }
+        buf[n] = 0;
+        char* endp = nullptr;
+        double v = std::strtod(buf, &endp);
+        return endp == buf ? def : v;
+    }
+
+    /**
+     * Extrae el siguiente campo separado por `sep` y lo elimina de `rest`.
+     */
+    inline std::wstring_view NextToken(std::wstring_view& rest, wchar_t sep = L'|') {
+        size_t p = rest.find(sep);
+        std::wstring_view tok = rest.substr(0, p);
+        rest = (p == std::wstring_view::npos) ? std::wstring_view() : rest.substr(p + 1);
+        return tok;
+    }
+
+    /**
+     * Decodifica el siguiente frame del sobre y avanza `rest`.
+     * Si el frame está mal formado devuelve false con `*malformed` = true, deja en `out.id` el id
+     * si llegó a leerse (0 si no) y salta a la siguiente cabecera "#1|" (o al final).
+     * @returns {bool} false al terminar o si el frame está mal formado.
+     */
+    inline bool NextFrame(std::wstring_view& rest, RpcRequest& out, bool* malformed = nullptr) {
+        if (malformed) *malformed = false;
+        out.id = 0;
+        while (IsEnvelope(rest)) rest.remove_prefix(kMagic.size());
+        if (rest.empty()) return false;
+        uint64_t id = 0, len = 0;
+        bool ok = ReadNumber(rest, id, L'|', UINT32_MAX);
+        if (ok) {
+            out.id = (uint32_t)id;
+            size_t bar = rest.find(L'|');
+            ok = bar != std::wstring_view::npos && bar != 0;
+            if (ok) {
+                out.verb = rest.substr(0, bar);
+                rest.remove_prefix(bar + 1);
+                ok = ReadNumber(rest, len) && len <= rest.size();
+            }
+        }
+        if (!ok) {
+            if (malformed) *malformed = true;
+            size_t next = rest.find(kMagic);
+            rest = next == std::wstring_view::npos ? std::wstring_view() : rest.substr(next);
+            return false;
+        }
+        out.payload = rest.substr(0, (size_t)len);
+        out.legacy = false;
+        rest.remove_prefix((size_t)len);
+        return true;
+    }
+
+    /**
+     * Interpreta un mensaje legado "verbo:payload" (o solo "verbo").
+     */
+    inline RpcRequest ParseLegacy(std::wstring_view msg) {
+        RpcRequest r; r.legacy = true;
+        size_t colon = msg.find(L':');
+        r.verb = msg.substr(0, colon);
+        if (colon != std::wstring_view::npos) r.payload = msg.substr(colon + 1);
+        return r;
+    }
+
+    inline void AppendNumber(std::wstring& out, uint64_t v) {
+        wchar_t buf[20]; int n = 0;
+        do { buf[n++] = (wchar_t)(L'0' + v % 10); v /= 10; } while (v);
+        while (n) out += buf[--n];
+    }
+
+    /**
+     * Añade un número decimal con hasta 10 cifras significativas.
+     */
+    inline void AppendDouble(std::wstring& out, double v) {
+        if (v > -9e15 && v < 9e15 && v == (double)(long long)v) { // El rango antes del cast (NaN no pasa)
+            if (v < 0) { out += L'-'; v = -v; }
+            AppendNumber(out, (uint64_t)v);
+            return;
+        }
+        char buf[32];
+        int n = std::snprintf(buf, sizeof(buf), "%.10g", v);
+        for (int i = 0; i < n; i++) out += (wchar_t)buf[i];
+    }
+
+    /**
+     * Añade bytes en base64 (para datos binarios que viajan como texto; en la página, atob()).
+     */
+    inline void AppendBase64(std::wstring& out, const void* data, size_t size) {
+        static const char kAlphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+        const unsigned char* p = (const unsigned char*)data;
+        out.reserve(out.size() + (size + 2) / 3 * 4);
+        size_t i = 0;
+        for (; i + 3 <= size; i += 3) {
+            uint32_t v = ((uint32_t)p[i] << 16) | ((uint32_t)p[i + 1] << 8) | p[i + 2];
+            out += (wchar_t)kAlphabet[v >> 18]; out += (wchar_t)kAlphabet[(v >> 12) & 63];
+            out += (wchar_t)kAlphabet[(v >> 6) & 63]; out += (wchar_t)kAlphabet[v & 63];
+        }
+        if (i < size) {
+            uint32_t v = (uint32_t)p[i] << 16;
+            if (i + 1 < size) v |= (uint32_t)p[i + 1] << 8;
+            out += (wchar_t)kAlphabet[v >> 18]; out += (wchar_t)kAlphabet[(v >> 12) & 63];
+            out += i + 1 < size ? (wchar_t)kAlphabet[(v >> 6) & 63] : L'=';
+            out += L'=';
+        }
+    }
+
+    /**
+     * Añade un frame "<id>|<tag>|<len>|<payload>" a `out` (sin la cabecera del sobre).
+     */
+    inline void AppendFrame(std::wstring& out, uint32_t id, std::wstring_view tag, std::wstring_view payload) {
+        AppendNumber(out, id); out += L'|';
+        out.append(tag.data(), tag.size()); out += L'|';
+        AppendNumber(out, payload.size()); out += L'|';
+        out.append(payload.data(), payload.size());
+    }
+
+    /**
+     * Construye un sobre completo con un único frame (útil para eventos y respuestas asíncronas).
+     */
+    inline void AppendEnvelope(std::wstring& out, uint32_t id, std::wstring_view tag, std::wstring_view payload) {
+        out.append(kMagic.data(), kMagic.size());
+        AppendFrame(out, id, tag, payload);
+    }
+}
+
+/**
+ * @namespace RpcTrace
+ * @description Trazas de mensajes del puente para reproducirlas fuera de la app (tools/rpcbench).
+ * Cada registro es "<bytes>\n<mensaje en UTF-8>\n"; el prefijo de longitud deja que el mensaje
+ * lleve saltos de línea sin escapes. La app graba una si GENESIS_RPC_TRACE apunta a un archivo.
+ */
+namespace RpcTrace {
+
+    inline void AppendRecord(std::string& out, std::string_view utf8) {
+        out += std::to_string(utf8.size());
+        out += '\n';
+        out.append(utf8.data(), utf8.size());
+        out += '\n';
+    }
+
+    /**
+     * Lee el siguiente registro y avanza `rest`.
+     * @returns {bool} false al terminar o si el registro está truncado.
+     */
+    inline bool NextRecord(std::string_view& rest, std::string_view& msg) {
+        size_t nl = rest.find('\n');
+        if (nl == std::string_view::npos || nl == 0 || nl > 19) return false;
+        uint64_t len = 0;
+        for (size_t i = 0; i < nl; i++) {
+            if (rest[i] < '0' || rest[i] > '9') return false;
+            len = len * 10 + (uint64_t)(rest[i] - '0');
+        }
+        if (len + 1 > rest.size() - nl - 1) return false;
+        msg = rest.substr(nl + 1, (size_t)len);
+        rest.remove_prefix(nl + 1 + (size_t)len + 1);
+        return true;
+    }
+}
+
+/**
+ * @class RpcDispatcher
+ * @description Despachador por tabla. Las rutas se guardan ordenadas en un array fijo
+ * y se buscan por búsqueda binaria; los buffers de respuesta se reutilizan entre mensajes,
+ * así que en régimen estable no hay reservas de memoria por mensaje.
+ * @template Ctx - Contexto que reciben los handlers (ventana, WebView, configuración...).
+ */
+template <typename Ctx>
+class RpcDispatcher {
+public:
+    /**
+     * Firma de un handler. Escribe el resultado (o el mensaje de error) en `out`.
+     * @returns {bool} true = "ok", false = "err".
+     */
+    using Handler = bool (*)(Ctx& ctx, const RpcRequest& req, std::wstring& out);
+
+    struct Route {
+        std::wstring_view verb;
+        Handler fn = nullptr;
+        std::wstring_view legacyReply; // Prefijo de la respuesta legada ("" = sin respuesta)
+        bool legacyEcho = false;        // La respuesta legada repite el payload ("clave|contenido")
+        RpcMode mode = RpcMode::Inline;
+    };
+
+    /**
+     * Recibe las peticiones de rutas no Inline. Debe copiar lo que necesite del mensaje.
+     * @returns {bool} false si la petición se rechaza (se responde "err" con `err`).
+     */
+    using DeferFn = std::function<bool(Ctx& ctx, const Route& route, const RpcRequest& req, std::wstring& err)>;
+
+    /**
+     * Recibe el tiempo de cada handler (steady_clock en ns): cuándo llegó la petición, cuándo empezó
+     * y cuándo terminó. En rutas Inline llegada = inicio. Puede llamarse desde los workers.
+     */
+    using ObserverFn = void (*)(const Route& route, uint64_t queuedNs, uint64_t startNs, uint64_t endNs);
+
+    static constexpr size_t kMaxRoutes = 64;
+
+    /**
+     * Registra un verbo. Se llama una sola vez al arrancar; las vistas deben ser literales.
+     */
+    bool Register(std::wstring_view verb, Handler fn, std::wstring_view legacyReply = {}, bool legacyEcho = false, RpcMode mode = RpcMode::Inline) {
+        if (count >= kMaxRoutes || Find(verb)) return false;
+        size_t i = count++;
+        while (i > 0 && routes[i - 1].verb > verb) { routes[i] = routes[i - 1]; i--; }
+        routes[i] = Route{ verb, fn, legacyReply, legacyEcho, mode };
+        return true;
+    }
+
+    /**
+     * Instala el ejecutor de rutas asíncronas. Sin él, todas las rutas se ejecutan Inline.
+     */
+    void SetDefer(DeferFn fn) { defer = std::move(fn); }
+
+    void SetObserver(ObserverFn fn) { observer = fn; }
+    ObserverFn Observer() const { return observer; }
+
+    size_t Size() const { return count; }
+    const Route& At(size_t i) const { return routes[i]; }
+
+    /** Posición de la ruta en la tabla (estable una vez registradas todas), para indexar datos propios. */
+    size_t IndexOf(const Route& r) const { return (size_t)(&r - routes); }
+
+    static uint64_t NowNs() {
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    const Route* Find(std::wstring_view verb) const {
+        size_t lo = 0, hi = count;
+        while (lo < hi) {
+            size_t mid = (lo + hi) / 2;
+            int c = routes[mid].verb.compare(verb);
+            if (c == 0) return &routes[mid];
+            if (c < 0) lo = mid + 1; else hi = mid;
+        }
+        return nullptr;
+    }
+
+    /**
+     * Procesa un mensaje completo (sobre o legado) y entrega las respuestas a `post`.
+     * Un sobre con N peticiones produce como mucho un único mensaje de respuesta.
+     * @param {Post} post - Invocable con la firma void(const std::wstring& reply).
+     * @returns {size_t} Número de peticiones procesadas.
+     */
+    template <typename Post>
+    size_t Dispatch(Ctx& ctx, std::wstring_view msg, Post&& post) {
+        if (!RpcCodec::IsEnvelope(msg)) {
+            RpcRequest req = RpcCodec::ParseLegacy(msg);
+            const Route* r = Find(req.verb);
+            if (!r) return 0;
+            if (Defer(ctx, *r, req) != DeferResult::Inline) return 1; // Legado: sin formato de error
+            bool ok = Invoke(ctx, *r, req);
+            if (ok && !r->legacyReply.empty()) {
+                batch.clear();
+                batch.append(r->legacyReply.data(), r->legacyReply.size());
+                if (r->legacyEcho) { batch.append(req.payload.data(), req.payload.size()); batch += L'|'; }
+                batch += scratch;
+                post(batch);
+            }
+            return 1;
+        }
+
+        std::wstring_view rest = msg.substr(RpcCodec::kMagic.size());
+        batch.assign(RpcCodec::kMagic.data(), RpcCodec::kMagic.size());
+        size_t processed = 0, replies = 0;
+        RpcRequest req;
+        for (;;) {
+            bool malformed = false;
+            if (!RpcCodec::NextFrame(rest, req, &malformed)) {
+                if (!malformed) break;
+                if (req.id == 0) continue;
+                RpcCodec::AppendFrame(batch, req.id, RpcCodec::kErr, L"malformed frame");
+                replies++;
+                continue;
+            }
+            processed++;
+            const Route* r = Find(req.verb);
+            bool ok = false;
+            DeferResult deferred = r ? Defer(ctx, *r, req) : DeferResult::Inline;
+            if (deferred == DeferResult::Accepted) continue;
+            if (deferred == DeferResult::Rejected) ok = false;
+            else if (r) ok = Invoke(ctx, *r, req);
+            else { scratch.assign(L"unknown verb: "); scratch.append(req.verb.data(), req.verb.size()); }
+            if (req.id == 0) continue;
+            RpcCodec::AppendFrame(batch, req.id, ok ? RpcCodec::kOk : RpcCodec::kErr, scratch);
+            replies++;
+        }
+        if (replies) post(batch);
+        return processed;
+    }
+
+private:
+    Route routes[kMaxRoutes];
+    size_t count = 0;
+    std::wstring scratch; // Resultado del handler en curso
+    std::wstring batch;   // Respuesta agrupada del mensaje en curso
+    DeferFn defer;
+    ObserverFn observer = nullptr;
+
+    enum class DeferResult { Inline, Accepted, Rejected };
+
+    /**
+     * Entrega la petición al ejecutor si la ruta no es Inline.
+     * Si se rechaza, `scratch` contiene el motivo.
+     */
+    DeferResult Defer(Ctx& ctx, const Route& r, const RpcRequest& req) {
+        if (r.mode == RpcMode::Inline || !defer) return DeferResult::Inline;
+        scratch.clear();
+        return defer(ctx, r, req, scratch) ? DeferResult::Accepted : DeferResult::Rejected;
+    }
+
+    bool Invoke(Ctx& ctx, const Route& r, const RpcRequest& req) {
+        scratch.clear();
+        uint64_t start = observer ? NowNs() : 0;
+        bool ok;
+        try { ok = r.fn(ctx, req, scratch); }
+        catch (...) { scratch.assign(L"exception"); ok = false; }
+        if (observer) observer(r, start, start, NowNs());
+        return ok;
+    }
+};
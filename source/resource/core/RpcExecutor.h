@@ -0,0 +1,168 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include "Rpc.h"
+#include "TaskPool.h"
+#include "CompletionQueue.h"
+
+/**
+ * @class RpcExecutor
+ * @description Ejecuta fuera del hilo de UI las rutas Pool / Serial de un RpcDispatcher.
+ * Copia el payload, lanza el handler en el TaskPool y devuelve el resultado por una
+ * CompletionQueue; el hilo de UI agrupa todos los completados en un único mensaje.
+ * Limita las peticiones en vuelo y permite cancelar por id o todas a la vez.
+ * @template Ctx - Debe poder leerse desde varios hilos a la vez en las rutas asíncronas.
+ */
+template <typename Ctx>
+class RpcExecutor {
+public:
+    using Dispatcher = RpcDispatcher<Ctx>;
+    using Route = typename Dispatcher::Route;
+    using PostFn = std::function<void(const std::wstring& reply)>;
+
+    /**
+     * @param {TaskPool} pool - Pool donde corren los handlers.
+     * @param {size_t} maxInFlight - Peticiones simultáneas permitidas; el resto se rechaza con "busy".
+     * @param {std::function} wake - Despierta al hilo de UI (ej: PostMessage). Llamado desde los workers.
+     */
+    RpcExecutor(TaskPool& pool, size_t maxInFlight, std::function<void()> wake)
+        : pool(pool), serial(pool), maxInFlight(maxInFlight), completions(std::move(wake)) {}
+
+    /**
+     * Instala el ejecutor en el despachador.
+     */
+    void Attach(Dispatcher& d) {
+        dispatcher = &d;
+        d.SetDefer([this](Ctx& ctx, const Route& r, const RpcRequest& req, std::wstring& err) {
+            return Submit(ctx, r, req, err);
+        });
+    }
+
+    /**
+     * Marca como canceladas las peticiones con ese id. Su respuesta se descarta.
+     */
+    void Cancel(uint32_t id) {
+        if (id == 0) return;
+        for (auto& kv : live) if (kv.second->id == id) kv.second->cancelled.store(true, std::memory_order_relaxed);
+    }
+
+    /**
+     * Cancela todo lo que esté en vuelo (ej: la página navegó y sus llamadas ya no existen).
+     */
+    void CancelAll() {
+        for (auto& kv : live) kv.second->cancelled.store(true, std::memory_order_relaxed);
+    }
+
+    /**
+     * Cancela solo lo que esté en vuelo en rutas de ese modo (ej: al cerrar, las lecturas de
+     * RpcMode::Pool se abandonan y las escrituras de RpcMode::Serial terminan).
+     */
+    void CancelAll(RpcMode mode) {
+        for (auto& kv : live) if (kv.second->route->mode == mode) kv.second->cancelled.store(true, std::memory_order_relaxed);
+    }
+
+    size_t InFlight() const { return live.size(); }
+
+    /**
+     * Encola un evento (frame con id 0) desde cualquier hilo. Sale en el próximo drenado,
+     * en orden respecto a los demás completados.
+     */
+    void Emit(std::wstring_view tag, std::wstring payload) {
+        auto job = std::make_shared<Job>();
+        job->verb.assign(tag.data(), tag.size());
+        job->result = std::move(payload);
+        job->ok = true;
+        completions.Push(std::move(job));
+    }
+
+    /**
+     * Entrega los completados. Solo desde el hilo de UI.
+     * @returns {size_t} Número de peticiones completadas.
+     */
+    size_t Drain(const PostFn& post) {
+        batch.assign(RpcCodec::kMagic.data(), RpcCodec::kMagic.size());
+        size_t frames = 0;
+        size_t n = completions.Drain([&](std::shared_ptr<Job>& job) {
+            if (!job->route) { // Evento
+                RpcCodec::AppendFrame(batch, 0, job->verb, job->result);
+                frames++;
+                return;
+            }
+            live.erase(job->seq);
+            if (job->cancelled.load(std::memory_order_relaxed)) return;
+            if (job->legacy) {
+                if (!job->ok || job->route->legacyReply.empty()) return;
+                legacyReply.assign(job->route->legacyReply.data(), job->route->legacyReply.size());
+                if (job->route->legacyEcho) { legacyReply += job->payload; legacyReply += L'|'; }
+                legacyReply += job->result;
+                post(legacyReply);
+                return;
+            }
+            if (job->id == 0) return;
+            RpcCodec::AppendFrame(batch, job->id, job->ok ? RpcCodec::kOk : RpcCodec::kErr, job->result);
+            frames++;
+        });
+        if (frames) post(batch);
+        return n;
+    }
+
+private:
+    struct Job {
+        uint64_t seq = 0;
+        uint32_t id = 0;
+        bool legacy = false;
+        const Route* route = nullptr;
+        uint64_t queuedNs = 0;
+        std::wstring verb;
+        std::wstring payload;
+        std::wstring result;
+        bool ok = false;
+        std::atomic<bool> cancelled{false};
+    };
+
+    TaskPool& pool;
+    SerialQueue serial;
+    Dispatcher* dispatcher = nullptr;
+    size_t maxInFlight;
+    uint64_t nextSeq = 1;
+    std::unordered_map<uint64_t, std::shared_ptr<Job>> live; // Solo se toca desde el hilo de UI
+    CompletionQueue<std::shared_ptr<Job>> completions;
+    std::wstring batch;
+    std::wstring legacyReply;
+
+    bool Submit(Ctx& ctx, const Route& r, const RpcRequest& req, std::wstring& err) {
+        if (live.size() >= maxInFlight) { err = L"busy"; return false; }
+        auto job = std::make_shared<Job>();
+        job->seq = nextSeq++;
+        job->id = req.id;
+        job->legacy = req.legacy;
+        job->route = &r;
+        if (dispatcher && dispatcher->Observer()) job->queuedNs = Dispatcher::NowNs();
+        job->verb.assign(req.verb.data(), req.verb.size());
+        job->payload.assign(req.payload.data(), req.payload.size());
+        live.emplace(job->seq, job);
+
+        Ctx* c = &ctx;
+        auto run = [this, c, job]() {
+            if (!job->cancelled.load(std::memory_order_relaxed)) {
+                RpcRequest copy;
+                copy.id = job->id; copy.legacy = job->legacy;
+                copy.verb = job->verb; copy.payload = job->payload;
+                copy.cancel = &job->cancelled;
+                auto observer = job->queuedNs ? dispatcher->Observer() : nullptr;
+                uint64_t start = observer ? Dispatcher::NowNs() : 0;
+                try { job->ok = job->route->fn(*c, copy, job->result); }
+                catch (...) { job->result = L"exception"; job->ok = false; }
+                if (observer) observer(*job->route, job->queuedNs, start, Dispatcher::NowNs());
+            }
+            completions.Push(job);
+        };
+        if (r.mode == RpcMode::Serial) serial.Submit(std::move(run));
+        else pool.Submit(std::move(run));
+        return true;
+    }
+};
@@ -0,0 +1,559 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <regex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "AssetPack.h"
+#include "AtomicFile.h"
+#include "DirTree.h"
+#include "MappedFile.h"
+#include "TaskPool.h"
+
+/**
+ * @namespace Search
+ * @description Búsqueda en todo el proyecto con índice de trigramas. Cada archivo de texto
+ * (.json, .xml, .js, .css) guarda el conjunto de trigramas que contiene, con las letras ASCII en
+ * minúsculas; una búsqueda toma los trigramas que cualquier coincidencia tiene que contener y solo
+ * lee los archivos que los tienen todos. El resultado es el mismo que recorrer todos los archivos.
+ *
+ * Literal: todos los trigramas del texto. Regex (ECMAScript): los de los tramos literales
+ * obligatorios (fuera de grupos, clases y cuantificadores que permiten cero); una alternancia "|"
+ * de primer nivel une los candidatos de cada rama. Una rama (o un literal) con menos de tres
+ * caracteres obligatorios lee todos los archivos.
+ *
+ * Un resultado por línea, con la primera coincidencia. Las regex sobre líneas de más de
+ * kLongLine bytes se evalúan por tramos solapados (un resultado por tramo).
+ *
+ * El índice se actualiza con el tamaño y la fecha de cada archivo (solo se releen los que
+ * cambiaron) y se guarda en disco:
+ *
+ * Formato (little-endian):
+ *   [0]  "GSRX" | u16 versión | u16 tamaño de cabecera | u32 archivos | u32 reservado   (16 bytes)
+ *   por archivo: u16 bytes de ruta | ruta UTF-8 | u64 tamaño | u64 mtime (ms) | u32 trigramas
+ *                | u32 trigrama x N (ordenados)
+ */
+namespace Search {
+
+    constexpr uint16_t kVersion = 1;
+    constexpr size_t kHeaderSize = 16;
+    constexpr size_t kLongLine = 16 * 1024;
+    constexpr size_t kSnippet = 200;   // Bytes máximos del texto de cada resultado
+
+    namespace Detail {
+        using AssetPack::Detail::Put16;
+        using AssetPack::Detail::Put32;
+        using AssetPack::Detail::Put64;
+        using AssetPack::Detail::Get16;
+        using AssetPack::Detail::Get32;
+        using AssetPack::Detail::Get64;
+
+        inline unsigned char Fold(unsigned char c) { return (c >= 'A' && c <= 'Z') ? (unsigned char)(c - 'A' + 'a') : c; }
+
+        inline uint32_t Gram(const unsigned char* p) { return ((uint32_t)Fold(p[0]) << 16) | ((uint32_t)Fold(p[1]) << 8) | Fold(p[2]); }
+
+        inline bool EndsWithNoCase(std::string_view s, std::string_view suffix) {
+            if (s.size() < suffix.size()) return false;
+            for (size_t i = 0; i < suffix.size(); i++) if (Fold((unsigned char)s[s.size() - suffix.size() + i]) != (unsigned char)suffix[i]) return false;
+            return true;
+        }
+
+        /**
+         * Reparte `count` trabajos entre el pool y el hilo que llama (que también trabaja), como
+         * SongLibrary: es seguro llamarlo desde un hilo del mismo pool.
+         */
+        inline void ForEach(size_t count, TaskPool* pool, const std::function<void(size_t)>& fn) {
+            if (!count) return;
+            struct Shared {
+                std::function<void(size_t)> fn;
+                std::atomic<size_t> next{0};
+                size_t done = 0;
+                std::mutex mtx;
+                std::condition_variable cv;
+            };
+            auto shared = std::make_shared<Shared>();
+            shared->fn = fn;
+            auto work = [shared, count] {
+                size_t ran = 0;
+                for (size_t i; (i = shared->next.fetch_add(1)) < count; ran++) shared->fn(i);
+                if (!ran) return;
+                std::lock_guard<std::mutex> lock(shared->mtx);
+                shared->done += ran;
+                shared->cv.notify_all();
+            };
+            size_t helpers = pool ? std::min(pool->Size(), count - 1) : 0;
+            for (size_t i = 0; i < helpers; i++) pool->Submit(work);
+            work();
+            std::unique_lock<std::mutex> lock(shared->mtx);
+            shared->cv.wait(lock, [&] { return shared->done >= count; });
+        }
+    }
+
+    /** Extensiones que se indexan. */
+    inline bool IsText(std::string_view path) {
+        return Detail::EndsWithNoCase(path, ".json") || Detail::EndsWithNoCase(path, ".xml") ||
+               Detail::EndsWithNoCase(path, ".js") || Detail::EndsWithNoCase(path, ".css");
+    }
+
+    /**
+     * Trigramas distintos de un texto (letras ASCII en minúsculas), ordenados. Usa un mapa de
+     * bits de 2 MB por hilo en lugar de ordenar todos los trigramas del archivo.
+     */
+    inline void Trigrams(const char* data, size_t size, std::vector<uint32_t>& out) {
+        out.clear();
+        if (size < 3) return;
+        thread_local std::vector<uint64_t> seen((size_t)1 << 18);
+        const unsigned char* p = (const unsigned char*)data;
+        for (size_t i = 0; i + 3 <= size; i++) {
+            uint32_t g = Detail::Gram(p + i);
+            uint64_t bit = 1ull << (g & 63);
+            uint64_t& word = seen[g >> 6];
+            if (word & bit) continue;
+            word |= bit;
+            out.push_back(g);
+        }
+        for (uint32_t g : out) seen[g >> 6] = 0;
+        std::sort(out.begin(), out.end());
+    }
+
+    /**
+     * Tramos literales que toda coincidencia de la regex contiene.
+     * @returns {bool} false si la regex tiene una alternancia de primer nivel (no hay ninguno seguro).
+     */
+    inline bool RequiredLiterals(std::string_view re, std::vector<std::string>& out) {
+        out.clear();
+        std::string run;
+        auto flush = [&] { if (run.size() >= 3) out.push_back(run); run.clear(); };
+        auto optional = [&](size_t next) {
+            // Un cuantificador que admite cero repeticiones anula el átomo anterior
+            return next < re.size() && (re[next] == '*' || re[next] == '?' || re[next] == '{');
+        };
+        auto skipClass = [&](size_t i) {
+            // i apunta a '['; devuelve la posición del ']' que la cierra
+            size_t j = i + 1;
+            if (j < re.size() && re[j] == '^') j++;
+            if (j < re.size() && re[j] == ']') j++;
+            for (; j < re.size() && re[j] != ']'; j++) if (re[j] == '\\') j++;
+            return j;
+        };
+        int depth = 0;
+        for (size_t i = 0; i < re.size(); i++) {
+            char c = re[i];
+            if (depth > 0) {
+                if (c == '\\') i++;
+                else if (c == '[') i = skipClass(i);
+                else if (c == '(') depth++;
+                else if (c == ')') depth--;
+                continue;
+            }
+            switch (c) {
+            case '|': out.clear(); return false;
+            case '(': flush(); depth = 1; continue;
+            case '[': flush(); i = skipClass(i); continue;
+            case '.': case '^': case '$': case '*': case '+': case '?': flush(); continue;
+            case '{': flush(); while (i < re.size() && re[i] != '}') i++; continue;
+            case '\\': {
+                if (i + 1 >= re.size()) { flush(); continue; }
+                char e = re[++i];
+                bool punct = !((e >= 'a' && e <= 'z') || (e >= 'A' && e <= 'Z') || (e >= '0' && e <= '9'));
+                if (!punct) {
+                    // Clases (\d \w \s...), referencias y códigos: cortan el tramo
+                    flush();
+                    if (e == 'x') i += 2;
+                    else if (e == 'u') i += 4;
+                    else if (e == 'c') i += 1;
+                    continue;
+                }
+                c = e;
+                break;
+            }
+            default: break;
+            }
+            if (optional(i + 1)) { flush(); continue; }
+            run += c;
+            if (i + 1 < re.size() && re[i + 1] == '+') flush();
+        }
+        flush();
+        return true;
+    }
+
+    /** Ramas de la alternancia de primer nivel ("a|b(c|d)" -> "a", "b(c|d)"). */
+    inline std::vector<std::string_view> Branches(std::string_view re) {
+        std::vector<std::string_view> out;
+        int depth = 0;
+        size_t from = 0;
+        for (size_t i = 0; i < re.size(); i++) {
+            char c = re[i];
+            if (c == '\\') i++;
+            else if (c == '[') { for (i++; i < re.size() && re[i] != ']'; i++) if (re[i] == '\\') i++; }
+            else if (c == '(') depth++;
+            else if (c == ')') depth--;
+            else if (c == '|' && depth == 0) { out.push_back(re.substr(from, i - from)); from = i + 1; }
+        }
+        out.push_back(re.substr(std::min(from, re.size())));
+        return out;
+    }
+
+    struct Query {
+        std::string text;
+        bool regex = false;
+        bool caseSensitive = false;
+        size_t maxHits = 1000;
+        bool scanAll = false;      // Sin índice: lee todos los archivos (para comparar)
+    };
+
+    struct Hit {
+        std::string path;          // Relativa a la raíz, con '/'
+        uint32_t line = 0;         // Desde 1
+        uint32_t column = 0;       // Byte desde 1
+        std::string text;          // La línea (o un trozo de kSnippet bytes alrededor de la coincidencia)
+    };
+
+    struct QueryStats {
+        uint64_t files = 0;        // Archivos en el índice
+        uint64_t candidates = 0;   // Archivos leídos
+        uint64_t bytes = 0;        // Bytes leídos
+        uint64_t hits = 0;
+        bool truncated = false;    // Se alcanzó maxHits o se canceló
+        double ms = 0.0;
+    };
+
+    struct UpdateStats {
+        uint64_t files = 0;
+        uint64_t indexed = 0;      // Leídos en esta actualización
+        uint64_t reused = 0;
+        uint64_t removed = 0;
+        double ms = 0.0;
+    };
+
+    /**
+     * @class Index
+     * @description Índice de los archivos de texto bajo unas carpetas. Update es exclusivo;
+     * las búsquedas pueden ir en paralelo entre sí y con otras búsquedas.
+     */
+    class Index {
+    public:
+        using HitSink = std::function<void(std::vector<Hit>& hits)>;
+
+        /**
+         * Pone el índice al día con el árbol: solo relee los archivos nuevos o con otro tamaño o fecha.
+         * @param {vector<string>} roots - Carpetas relativas a la raíz de `tree` (ej: "source", "public").
+         * @returns {bool} true si algo cambió (hay que volver a guardar).
+         */
+        bool Update(DirTreeCache& tree, const std::vector<std::string>& roots, TaskPool* pool = nullptr, UpdateStats* out = nullptr) {
+            auto t0 = std::chrono::steady_clock::now();
+            UpdateStats st;
+            std::vector<File> next;
+            for (const std::string& rootDir : roots) {
+                std::vector<DirTreeCache::Item> items;
+                if (!tree.List(rootDir, true, {}, items)) continue;
+                for (auto& item : items) {
+                    if (item.isDir || !IsText(item.path)) continue;
+                    File f;
+                    f.path = rootDir + "/" + item.path;
+                    f.size = item.size;
+                    f.mtimeMs = item.mtimeMs;
+                    next.push_back(std::move(f));
+                }
+            }
+
+            std::unique_lock<std::shared_mutex> lock(mtx);
+            root = tree.Root();
+            std::unordered_map<std::string, size_t> old;
+            for (size_t i = 0; i < files.size(); i++) old[files[i].path] = i;
+            std::vector<size_t> fresh;
+            for (size_t i = 0; i < next.size(); i++) {
+                auto it = old.find(next[i].path);
+                if (it != old.end() && files[it->second].size == next[i].size && files[it->second].mtimeMs == next[i].mtimeMs) {
+                    next[i].grams = std::move(files[it->second].grams);
+                    st.reused++;
+                } else {
+                    fresh.push_back(i);
+                }
+            }
+            Detail::ForEach(fresh.size(), pool, [&](size_t k) {
+                File& f = next[fresh[k]];
+                MappedFile m;
+                if (m.Open(root / std::filesystem::u8path(f.path)) && m.Data()) Trigrams(m.Data(), m.Size(), f.grams);
+            });
+            st.files = next.size();
+            st.indexed = fresh.size();
+            st.removed = files.size() - st.reused - std::count_if(fresh.begin(), fresh.end(), [&](size_t i) { return old.count(next[i].path) > 0; });
+            bool changed = st.indexed || st.removed || !postingsReady;
+            files = std::move(next);
+            if (changed) BuildPostings();
+            st.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+            if (out) *out = st;
+            return st.indexed || st.removed;
+        }
+
+        /**
+         * Busca en paralelo. `sink` recibe los resultados de cada archivo en cuanto están (de uno
+         * en uno, desde cualquier hilo); el orden entre archivos no está definido.
+         * @returns {bool} false si la regex no es válida (`err` dice por qué).
+         */
+        bool Run(const Query& q, const HitSink& sink, TaskPool* pool = nullptr, const std::function<bool()>& cancelled = nullptr,
+                 QueryStats* out = nullptr, std::string* err = nullptr) const {
+            auto t0 = std::chrono::steady_clock::now();
+            QueryStats st;
+            std::unique_ptr<std::regex> re;
+            if (q.regex) {
+                try {
+                    auto flags = std::regex::ECMAScript | std::regex::optimize;
+                    if (!q.caseSensitive) flags |= std::regex::icase;
+                    re = std::make_unique<std::regex>(q.text, flags);
+                } catch (const std::regex_error& e) {
+                    if (err) *err = e.what();
+                    return false;
+                }
+            }
+            std::string needle = q.text;
+            if (!q.regex && !q.caseSensitive) for (char& c : needle) c = (char)Detail::Fold((unsigned char)c);
+
+            std::shared_lock<std::shared_mutex> lock(mtx);
+            std::vector<uint32_t> candidates;
+            Candidates(q, candidates);
+            st.files = files.size();
+            st.candidates = candidates.size();
+
+            std::atomic<uint64_t> hits{0}, bytes{0};
+            std::atomic<bool> stop{false};
+            std::mutex sinkMtx;
+            Detail::ForEach(candidates.size(), pool, [&](size_t k) {
+                if (stop.load(std::memory_order_relaxed)) return;
+                if (cancelled && cancelled()) { stop = true; return; }
+                const File& f = files[candidates[k]];
+                MappedFile m;
+                if (!m.Open(root / std::filesystem::u8path(f.path)) || !m.Data()) return;
+                bytes += m.Size();
+                std::vector<Hit> found;
+                Scan(f.path, std::string_view(m.Data(), m.Size()), q, needle, re.get(), found);
+                if (found.empty()) return;
+                std::lock_guard<std::mutex> guard(sinkMtx);
+                uint64_t have = hits.load();
+                if (have >= q.maxHits) { stop = true; return; }
+                if (have + found.size() > q.maxHits) { found.resize((size_t)(q.maxHits - have)); stop = true; }
+                hits += found.size();
+                sink(found);
+            });
+            st.hits = hits;
+            st.bytes = bytes;
+            st.truncated = stop;
+            st.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+            if (out) *out = st;
+            return true;
+        }
+
+        /** Archivos que una búsqueda leería (índices internos, ordenados). */
+        void Candidates(const Query& q, std::vector<uint32_t>& out) const {
+            out.clear();
+            std::vector<std::vector<std::string>> branches;
+            if (q.scanAll) {
+                branches.emplace_back();
+            } else if (q.regex) {
+                // Una alternancia de primer nivel es la unión de los candidatos de cada rama
+                for (std::string_view b : Branches(q.text)) {
+                    branches.emplace_back();
+                    RequiredLiterals(b, branches.back());
+                }
+            } else {
+                branches.push_back({ q.text });
+            }
+            std::vector<uint32_t> part, merged;
+            for (const auto& literals : branches) {
+                if (!Intersect(literals, part)) {
+                    out.resize(files.size());
+                    for (size_t i = 0; i < files.size(); i++) out[i] = (uint32_t)i;
+                    return;
+                }
+                merged.clear();
+                std::set_union(out.begin(), out.end(), part.begin(), part.end(), std::back_inserter(merged));
+                out.swap(merged);
+            }
+        }
+
+        size_t Files() const { std::shared_lock<std::shared_mutex> lock(mtx); return files.size(); }
+
+        /** Trigramas guardados (suma de todos los archivos). */
+        uint64_t Grams() const {
+            std::shared_lock<std::shared_mutex> lock(mtx);
+            uint64_t n = 0;
+            for (const File& f : files) n += f.grams.size();
+            return n;
+        }
+
+        bool Save(const std::filesystem::path& path, std::string& err) const {
+            std::string o;
+            {
+                std::shared_lock<std::shared_mutex> lock(mtx);
+                o.append("GSRX", 4);
+                Detail::Put16(o, kVersion); Detail::Put16(o, (uint32_t)kHeaderSize);
+                Detail::Put32(o, (uint32_t)files.size()); Detail::Put32(o, 0);
+                for (const File& f : files) {
+                    Detail::Put16(o, (uint32_t)f.path.size());
+                    o += f.path;
+                    Detail::Put64(o, f.size); Detail::Put64(o, (uint64_t)f.mtimeMs);
+                    Detail::Put32(o, (uint32_t)f.grams.size());
+                    for (uint32_t g : f.grams) Detail::Put32(o, g);
+                }
+            }
+            return AtomicFile::Write(path, o, err);
+        }
+
+        /**
+         * Recupera un índice guardado. Uno ilegible o de otra versión se ignora (el próximo
+         * Update lee todo). La raíz la fija el siguiente Update.
+         */
+        bool Load(const std::filesystem::path& path) {
+            MappedFile m;
+            if (!m.Open(path) || m.Size() < kHeaderSize) return false;
+            const unsigned char* p = (const unsigned char*)m.Data();
+            const unsigned char* end = p + m.Size();
+            if (std::memcmp(p, "GSRX", 4) != 0 || Detail::Get16(p + 4) != kVersion) return false;
+            uint32_t count = Detail::Get32(p + 8);
+            p += Detail::Get16(p + 6);
+            std::vector<File> loaded;
+            for (uint32_t i = 0; i < count; i++) {
+                if (end - p < 2) return false;
+                size_t len = Detail::Get16(p);
+                if ((size_t)(end - p) < 2 + len + 20) return false;
+                File f;
+                f.path.assign((const char*)p + 2, len);
+                p += 2 + len;
+                f.size = Detail::Get64(p);
+                f.mtimeMs = (int64_t)Detail::Get64(p + 8);
+                uint32_t n = Detail::Get32(p + 16);
+                p += 20;
+                if ((size_t)(end - p) / 4 < n) return false;
+                f.grams.resize(n);
+                for (uint32_t k = 0; k < n; k++) f.grams[k] = Detail::Get32(p + 4 * k);
+                p += 4 * (size_t)n;
+                loaded.push_back(std::move(f));
+            }
+            std::unique_lock<std::shared_mutex> lock(mtx);
+            files = std::move(loaded);
+            BuildPostings();
+            return true;
+        }
+
+    private:
+        struct File {
+            std::string path;
+            uint64_t size = 0;
+            int64_t mtimeMs = 0;
+            std::vector<uint32_t> grams;
+        };
+
+        mutable std::shared_mutex mtx;
+        std::filesystem::path root;
+        std::vector<File> files;
+        std::unordered_map<uint32_t, std::vector<uint32_t>> postings;   // Trigrama -> archivos (ordenados)
+        bool postingsReady = false;
+
+        /**
+         * Archivos que contienen todos los trigramas de `literals`.
+         * @returns {bool} false si no hay ningún trigrama (no se puede filtrar).
+         */
+        bool Intersect(const std::vector<std::string>& literals, std::vector<uint32_t>& out) const {
+            out.clear();
+            std::vector<uint32_t> grams;
+            for (const std::string& lit : literals) {
+                for (size_t i = 0; i + 3 <= lit.size(); i++) grams.push_back(Detail::Gram((const unsigned char*)lit.data() + i));
+            }
+            std::sort(grams.begin(), grams.end());
+            grams.erase(std::unique(grams.begin(), grams.end()), grams.end());
+            if (grams.empty()) return false;
+            std::vector<const std::vector<uint32_t>*> lists;
+            for (uint32_t g : grams) {
+                auto it = postings.find(g);
+                if (it == postings.end()) return true;
+                lists.push_back(&it->second);
+            }
+            std::sort(lists.begin(), lists.end(), [](auto* a, auto* b) { return a->size() < b->size(); });
+            out = *lists[0];
+            std::vector<uint32_t> tmp;
+            for (size_t i = 1; i < lists.size() && !out.empty(); i++) {
+                tmp.clear();
+                std::set_intersection(out.begin(), out.end(), lists[i]->begin(), lists[i]->end(), std::back_inserter(tmp));
+                out.swap(tmp);
+            }
+            return true;
+        }
+
+        void BuildPostings() {
+            postings.clear();
+            for (size_t i = 0; i < files.size(); i++) {
+                for (uint32_t g : files[i].grams) postings[g].push_back((uint32_t)i);
+            }
+            postingsReady = true;
+        }
+
+        static void AddHit(const std::string& path, std::string_view text, size_t lineStart, size_t lineEnd, uint32_t line,
+                           size_t at, std::vector<Hit>& out) {
+            Hit h;
+            h.path = path;
+            h.line = line;
+            h.column = (uint32_t)(at - lineStart + 1);
+            size_t from = lineStart, to = lineEnd;
+            if (to - from > kSnippet) {
+                from = std::max(lineStart, at > kSnippet / 2 ? at - kSnippet / 2 : 0);
+                to = std::min(lineEnd, from + kSnippet);
+            }
+            h.text.assign(text.substr(from, to - from));
+            if (!h.text.empty() && h.text.back() == '\r') h.text.pop_back();
+            out.push_back(std::move(h));
+        }
+
+        static void Scan(const std::string& path, std::string_view text, const Query& q, const std::string& needle,
+                         const std::regex* re, std::vector<Hit>& out) {
+            std::string folded;
+            std::string_view hay = text;
+            if (!re && !q.caseSensitive) {
+                folded.resize(text.size());
+                for (size_t i = 0; i < text.size(); i++) folded[i] = (char)Detail::Fold((unsigned char)text[i]);
+                hay = folded;
+            }
+            uint32_t line = 1;
+            size_t start = 0;
+            while (start <= text.size()) {
+                size_t nl = text.find('\n', start);
+                size_t end = nl == std::string_view::npos ? text.size() : nl;
+                if (!re) {
+                    if (!needle.empty()) {
+                        size_t at = hay.substr(start, end - start).find(needle);
+                        if (at != std::string_view::npos) AddHit(path, text, start, end, line, start + at, out);
+                    }
+                } else {
+                    // Las líneas largas, por tramos de kLongLine con un solape de kSnippet
+                    for (size_t from = start; from < end || from == start; ) {
+                        size_t to = end - from > kLongLine ? from + kLongLine : end;
+                        std::cmatch mr;
+                        if (std::regex_search(text.data() + from, text.data() + to, mr, *re)) {
+                            AddHit(path, text, start, end, line, from + (size_t)mr.position(0), out);
+                            if (to == end) break;
+                            from = std::max(from + (size_t)mr.position(0) + 1, to - kSnippet);
+                        } else {
+                            if (to == end) break;
+                            from = to - kSnippet;
+                        }
+                    }
+                }
+                if (nl == std::string_view::npos) break;
+                start = nl + 1;
+                line++;
+            }
+        }
+    };
+}
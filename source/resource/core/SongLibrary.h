@@ -0,0 +1,396 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "AtomicFile.h"
+#include "ChartIndex.h"
+#include "DirTree.h"
+#include "Json.h"
+#include "MappedFile.h"
+#include "TaskPool.h"
+#include "Vorbis.h"
+
+/**
+ * @namespace SongLibrary
+ * @description Índice de metadatos de las canciones (public/songs/<canción>/charts/<chart>.json y
+ * song/<stem>.ogg) para el navegador de canciones y el freeplay: dificultades, BPM, velocidad, notas
+ * por carril, duración y stems, sin que la página tenga que cargar cada chart.
+ *
+ * El índice se guarda en disco (JSON) con el tamaño y la fecha de cada archivo; al volver a
+ * escanear solo se parsea lo nuevo o lo modificado. Los charts y las cabeceras de audio se leen
+ * en paralelo en un TaskPool.
+ *
+ * Dificultad por nombre de archivo, sin distinguir mayúsculas: "<canción>.json" = normal,
+ * "<canción>-<dif>.json" = dif ("darnell-easy.json" y "Darnell-hard.json" son de "Darnell").
+ * Los .json que no son charts (Events.json, stages...) se listan aparte como extras.
+ */
+namespace SongLibrary {
+
+    /** Tamaño y fecha con los que se decide si hay que volver a leer un archivo. */
+    struct Stamp {
+        uint64_t size = 0;
+        int64_t mtimeMs = 0;
+
+        bool operator==(const Stamp& o) const { return size == o.size && mtimeMs == o.mtimeMs; }
+    };
+
+    struct Chart {
+        std::string file;          // Nombre dentro de charts/
+        std::string difficulty;    // En minúsculas
+        std::string song, player, enemy, gfVersion, stage, noteSkin;
+        double bpm = 0.0, speed = 1.0, lengthMs = 0.0;
+        uint32_t notes = 0, sections = 0;
+        std::array<uint32_t, 8> lanes{};  // 0-3 oponente, 4-7 jugador
+        bool isChart = false;      // false = otro .json (eventos, stage...)
+        Stamp stamp;
+    };
+
+    struct Stem {
+        std::string file;          // Nombre dentro de song/
+        int channels = 0;
+        uint32_t rate = 0;
+        double seconds = 0.0;
+        bool ok = false;
+        Stamp stamp;
+    };
+
+    struct Song {
+        std::string id;            // Nombre de la carpeta
+        std::vector<Chart> charts; // Ordenados: easy, normal, hard, erect, nightmare y el resto
+        std::vector<Chart> extras;
+        std::vector<Stem> stems;
+    };
+
+    struct ScanStats {
+        uint64_t files = 0;        // Archivos considerados
+        uint64_t parsed = 0;       // Leídos en este escaneo
+        uint64_t reused = 0;       // Sin cambios, tomados del índice
+        uint64_t removed = 0;      // Estaban en el índice y ya no existen
+        double ms = 0.0;
+    };
+
+    namespace Detail {
+        inline std::string Lower(std::string_view s) {
+            std::string out(s);
+            for (char& c : out) if (c >= 'A' && c <= 'Z') c = (char)(c - 'A' + 'a');
+            return out;
+        }
+
+        inline bool EndsWithNoCase(std::string_view s, std::string_view suffix) {
+            return s.size() >= suffix.size() && Lower(s.substr(s.size() - suffix.size())) == suffix;
+        }
+
+        inline int DifficultyRank(const std::string& d) {
+            static const char* kOrder[] = { "easy", "normal", "hard", "erect", "nightmare" };
+            for (int i = 0; i < 5; i++) if (d == kOrder[i]) return i;
+            return 5;
+        }
+    }
+
+    /**
+     * Dificultad de `<stem>.json` dentro de la canción `songId`.
+     */
+    inline std::string DifficultyOf(std::string_view songId, std::string_view stem) {
+        std::string id = Detail::Lower(songId), s = Detail::Lower(stem);
+        if (s == id) return "normal";
+        if (s.size() > id.size() + 1 && s.compare(0, id.size(), id) == 0 && s[id.size()] == '-') return s.substr(id.size() + 1);
+        return s;
+    }
+
+    /** Parsea un .json de charts/. Uno que no es chart queda con isChart = false. */
+    inline void ReadChart(const std::filesystem::path& path, Chart& c) {
+        ChartIndex chart;
+        c.isChart = chart.Load(path);
+        if (!c.isChart) return;
+        c.song = chart.song; c.player = chart.player; c.enemy = chart.enemy; c.gfVersion = chart.gfVersion;
+        c.stage = chart.stage; c.noteSkin = chart.noteSkin;
+        c.bpm = chart.bpm; c.speed = chart.speed; c.lengthMs = chart.Duration();
+        c.notes = (uint32_t)chart.Count(); c.sections = (uint32_t)chart.sectionCount;
+        c.lanes.fill(0);
+        for (uint8_t l : chart.lane) c.lanes[l & 7]++;
+    }
+
+    /** Cabecera de un .ogg de song/ (sin decodificar). */
+    inline void ReadStem(const std::filesystem::path& path, Stem& s) {
+        MappedFile f;
+        Vorbis::Info info;
+        s.ok = f.Open(path) && f.Data() && Vorbis::ReadInfo(f.Data(), f.Size(), info);
+        if (!s.ok) return;
+        s.channels = info.channels; s.rate = info.rate; s.seconds = info.Seconds();
+    }
+
+    /**
+     * @class Index
+     * @description Las canciones de una carpeta. Scan lo pone al día; Load/Save lo persisten.
+     * No es seguro para hilos: el llamador serializa (en el puente, verbo Serial).
+     */
+    class Index {
+    public:
+        const std::vector<Song>& Songs() const { return songs; }
+
+        /**
+         * Relee la carpeta `songsDir` (relativa a la raíz de `tree`) y parsea solo lo que cambió.
+         * @param {TaskPool*} pool - Si se indica, los archivos se leen en paralelo en él; el hilo
+         *   que llama también trabaja, así que es seguro llamarlo desde un hilo del mismo pool.
+         * @returns {bool} false si la carpeta no existe.
+         */
+        bool Scan(DirTreeCache& tree, const std::string& songsDir, TaskPool* pool = nullptr, ScanStats* out = nullptr) {
+            auto t0 = std::chrono::steady_clock::now();
+            ScanStats st;
+            std::vector<DirTreeCache::Item> items;
+            if (!tree.List(songsDir, true, {}, items)) return false;
+
+            // Lo que ya estaba, por "<canción>/<carpeta>/<archivo>"
+            std::unordered_map<std::string, const Chart*> oldCharts;
+            std::unordered_map<std::string, const Stem*> oldStems;
+            for (const Song& s : songs) {
+                for (auto* list : { &s.charts, &s.extras }) for (const Chart& c : *list) oldCharts[s.id + "/charts/" + c.file] = &c;
+                for (const Stem& m : s.stems) oldStems[s.id + "/song/" + m.file] = &m;
+            }
+
+            std::vector<Song> next;
+            std::unordered_map<std::string, size_t> byId;
+            std::vector<std::vector<Chart>> jsons;          // Por canción, antes de separar charts y extras
+            std::vector<std::pair<size_t, size_t>> freshCharts, freshStems; // (canción, posición) a leer
+            uint64_t changed = 0;
+            for (const auto& item : items) {
+                if (item.isDir) continue;
+                size_t a = item.path.find('/');
+                size_t b = a == std::string::npos ? a : item.path.find('/', a + 1);
+                if (b == std::string::npos || item.path.find('/', b + 1) != std::string::npos) continue;
+                std::string id = item.path.substr(0, a), folder = item.path.substr(a + 1, b - a - 1), file = item.path.substr(b + 1);
+                bool isJson = folder == "charts" && Detail::EndsWithNoCase(file, ".json");
+                bool isOgg = folder == "song" && Detail::EndsWithNoCase(file, ".ogg");
+                if (!isJson && !isOgg) continue;
+                st.files++;
+                auto found = byId.find(id);
+                size_t si = found != byId.end() ? found->second : next.size();
+                if (si == next.size()) { byId[id] = si; next.emplace_back(); next.back().id = id; jsons.emplace_back(); }
+                Stamp stamp{ item.size, item.mtimeMs };
+                if (isJson) {
+                    auto old = oldCharts.find(item.path);
+                    if (old != oldCharts.end() && old->second->stamp == stamp) { jsons[si].push_back(*old->second); st.reused++; continue; }
+                    if (old != oldCharts.end()) changed++;
+                    Chart c; c.file = file; c.stamp = stamp;
+                    c.difficulty = DifficultyOf(id, file.substr(0, file.size() - 5));
+                    freshCharts.emplace_back(si, jsons[si].size());
+                    jsons[si].push_back(std::move(c));
+                } else {
+                    auto old = oldStems.find(item.path);
+                    if (old != oldStems.end() && old->second->stamp == stamp) { next[si].stems.push_back(*old->second); st.reused++; continue; }
+                    if (old != oldStems.end()) changed++;
+                    Stem m; m.file = file; m.stamp = stamp;
+                    freshStems.emplace_back(si, next[si].stems.size());
+                    next[si].stems.push_back(std::move(m));
+                }
+            }
+
+            // Los vectores ya no crecen: los trabajos escriben directamente en su entrada
+            std::vector<std::function<void()>> jobs;
+            std::filesystem::path base = tree.Root() / std::filesystem::u8path(songsDir);
+            for (auto [si, i] : freshCharts) {
+                Chart* target = &jsons[si][i];
+                std::filesystem::path p = base / std::filesystem::u8path(next[si].id) / "charts" / std::filesystem::u8path(target->file);
+                jobs.push_back([target, p] { ReadChart(p, *target); });
+            }
+            for (auto [si, i] : freshStems) {
+                Stem* target = &next[si].stems[i];
+                std::filesystem::path p = base / std::filesystem::u8path(next[si].id) / "song" / std::filesystem::u8path(target->file);
+                jobs.push_back([target, p] { ReadStem(p, *target); });
+            }
+            st.parsed = jobs.size();
+            Run(std::move(jobs), pool);
+
+            for (size_t si = 0; si < next.size(); si++) {
+                Song& s = next[si];
+                for (Chart& c : jsons[si]) (c.isChart ? s.charts : s.extras).push_back(std::move(c));
+                std::sort(s.charts.begin(), s.charts.end(), [](const Chart& x, const Chart& y) {
+                    int rx = Detail::DifficultyRank(x.difficulty), ry = Detail::DifficultyRank(y.difficulty);
+                    return rx != ry ? rx < ry : x.difficulty < y.difficulty;
+                });
+                std::sort(s.extras.begin(), s.extras.end(), [](const Chart& x, const Chart& y) { return x.file < y.file; });
+                std::sort(s.stems.begin(), s.stems.end(), [](const Stem& x, const Stem& y) { return x.file < y.file; });
+            }
+            std::sort(next.begin(), next.end(), [](const Song& x, const Song& y) { return Detail::Lower(x.id) < Detail::Lower(y.id); });
+
+            st.removed = oldCharts.size() + oldStems.size() - st.reused - changed;
+            songs = std::move(next);
+            st.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+            if (out) *out = st;
+            return true;
+        }
+
+        /**
+         * JSON del índice. Es lo que recibe la página y también lo que se guarda en disco.
+         * {"version":1,"songs":[{"id","name","bpm","seconds","difficulties":[...],"events",
+         *   "charts":[{"difficulty","file","song","player","enemy","gfVersion","stage","noteSkin",
+         *              "bpm","speed","lengthMs","notes","sections","lanes":[8],"size","mtime"}],
+         *   "stems":[{"file","channels","rate","seconds","ok","size","mtime"}],
+         *   "extras":[{"file","size","mtime"}]}]}
+         */
+        void ToJson(std::string& j) const {
+            j += "{\"version\":1,\"songs\":[";
+            for (size_t si = 0; si < songs.size(); si++) {
+                const Song& s = songs[si];
+                if (si) j += ',';
+                const Chart* main = nullptr;
+                for (const Chart& c : s.charts) if (!main || c.difficulty == "normal") main = &c;
+                double seconds = 0.0;
+                bool events = false;
+                for (const Stem& m : s.stems) seconds = std::max(seconds, m.seconds);
+                for (const Chart& e : s.extras) if (Detail::Lower(e.file) == "events.json") events = true;
+                j += "{\"id\":"; Json::AppendString(j, s.id);
+                j += ",\"name\":"; Json::AppendString(j, main && !main->song.empty() ? main->song : s.id);
+                j += ",\"bpm\":"; Json::AppendNumber(j, main ? main->bpm : 0.0);
+                j += ",\"seconds\":"; Json::AppendNumber(j, seconds);
+                j += ",\"events\":"; j += events ? "true" : "false";
+                j += ",\"difficulties\":[";
+                for (size_t i = 0; i < s.charts.size(); i++) { if (i) j += ','; Json::AppendString(j, s.charts[i].difficulty); }
+                j += "],\"charts\":[";
+                for (size_t i = 0; i < s.charts.size(); i++) {
+                    const Chart& c = s.charts[i];
+                    if (i) j += ',';
+                    j += "{\"difficulty\":"; Json::AppendString(j, c.difficulty);
+                    j += ",\"file\":"; Json::AppendString(j, c.file);
+                    j += ",\"song\":"; Json::AppendString(j, c.song);
+                    j += ",\"player\":"; Json::AppendString(j, c.player);
+                    j += ",\"enemy\":"; Json::AppendString(j, c.enemy);
+                    j += ",\"gfVersion\":"; Json::AppendString(j, c.gfVersion);
+                    j += ",\"stage\":"; Json::AppendString(j, c.stage);
+                    j += ",\"noteSkin\":"; Json::AppendString(j, c.noteSkin);
+                    j += ",\"bpm\":"; Json::AppendNumber(j, c.bpm);
+                    j += ",\"speed\":"; Json::AppendNumber(j, c.speed);
+                    j += ",\"lengthMs\":"; Json::AppendNumber(j, c.lengthMs);
+                    j += ",\"notes\":"; Json::AppendNumber(j, c.notes);
+                    j += ",\"sections\":"; Json::AppendNumber(j, c.sections);
+                    j += ",\"lanes\":[";
+                    for (int l = 0; l < 8; l++) { if (l) j += ','; Json::AppendNumber(j, c.lanes[l]); }
+                    j += ']';
+                    AppendStamp(j, c.stamp);
+                    j += '}';
+                }
+                j += "],\"stems\":[";
+                for (size_t i = 0; i < s.stems.size(); i++) {
+                    const Stem& m = s.stems[i];
+                    if (i) j += ',';
+                    j += "{\"file\":"; Json::AppendString(j, m.file);
+                    j += ",\"channels\":"; Json::AppendNumber(j, m.channels);
+                    j += ",\"rate\":"; Json::AppendNumber(j, m.rate);
+                    j += ",\"seconds\":"; Json::AppendNumber(j, m.seconds);
+                    j += ",\"ok\":"; j += m.ok ? "true" : "false";
+                    AppendStamp(j, m.stamp);
+                    j += '}';
+                }
+                j += "],\"extras\":[";
+                for (size_t i = 0; i < s.extras.size(); i++) {
+                    if (i) j += ',';
+                    j += "{\"file\":"; Json::AppendString(j, s.extras[i].file);
+                    AppendStamp(j, s.extras[i].stamp);
+                    j += '}';
+                }
+                j += "]}";
+            }
+            j += "]}";
+        }
+
+        /**
+         * Recupera un índice guardado con Save. Uno ilegible o de otra versión se ignora
+         * (el próximo Scan parsea todo).
+         */
+        bool Load(const std::filesystem::path& file) {
+            std::string text;
+            Json::Value doc;
+            if (!AtomicFile::ReadAll(file, text) || !Json::Parse(text, doc) || doc["version"].Int() != 1) return false;
+            std::vector<Song> loaded;
+            for (const auto& sv : doc["songs"].Items()) {
+                Song s;
+                s.id = sv["id"].Str();
+                if (s.id.empty()) continue;
+                for (const auto& cv : sv["charts"].Items()) {
+                    Chart c;
+                    c.isChart = true;
+                    c.file = cv["file"].Str(); c.difficulty = cv["difficulty"].Str();
+                    c.song = cv["song"].Str(); c.player = cv["player"].Str(); c.enemy = cv["enemy"].Str();
+                    c.gfVersion = cv["gfVersion"].Str(); c.stage = cv["stage"].Str(); c.noteSkin = cv["noteSkin"].Str();
+                    c.bpm = cv["bpm"].Num(); c.speed = cv["speed"].Num(1.0); c.lengthMs = cv["lengthMs"].Num();
+                    c.notes = (uint32_t)cv["notes"].Num(); c.sections = (uint32_t)cv["sections"].Num();
+                    for (int l = 0; l < 8; l++) c.lanes[l] = (uint32_t)cv["lanes"][l].Num();
+                    c.stamp = ReadStamp(cv);
+                    s.charts.push_back(std::move(c));
+                }
+                for (const auto& mv : sv["stems"].Items()) {
+                    Stem m;
+                    m.file = mv["file"].Str(); m.channels = mv["channels"].Int(); m.rate = (uint32_t)mv["rate"].Num();
+                    m.seconds = mv["seconds"].Num(); m.ok = mv["ok"].Bool(); m.stamp = ReadStamp(mv);
+                    s.stems.push_back(std::move(m));
+                }
+                for (const auto& ev : sv["extras"].Items()) {
+                    Chart e;
+                    e.file = ev["file"].Str(); e.stamp = ReadStamp(ev);
+                    s.extras.push_back(std::move(e));
+                }
+                loaded.push_back(std::move(s));
+            }
+            songs = std::move(loaded);
+            return true;
+        }
+
+        bool Save(const std::filesystem::path& file, std::string& err) const {
+            std::string j;
+            ToJson(j);
+            return AtomicFile::Write(file, j, err);
+        }
+
+    private:
+        std::vector<Song> songs;
+
+        static void AppendStamp(std::string& j, const Stamp& s) {
+            j += ",\"size\":"; Json::AppendNumber(j, (double)s.size);
+            j += ",\"mtime\":"; Json::AppendNumber(j, (double)s.mtimeMs);
+        }
+
+        static Stamp ReadStamp(const Json::Value& v) { return Stamp{ (uint64_t)v["size"].Num(), (int64_t)v["mtime"].Num() }; }
+
+        /**
+         * Reparte los trabajos entre el pool y el hilo que llama, que toma trabajos igual que
+         * los demás y al acabar espera solo a los que ya estaban en marcha.
+         */
+        static void Run(std::vector<std::function<void()>> jobs, TaskPool* pool) {
+            if (jobs.empty()) return;
+            // Compartido con los ayudantes: uno que arranque tarde no toca nada del llamador
+            struct Shared {
+                std::vector<std::function<void()>> jobs;
+                std::atomic<size_t> next{0};
+                size_t done = 0;
+                std::mutex mtx;
+                std::condition_variable cv;
+            };
+            auto shared = std::make_shared<Shared>();
+            shared->jobs = std::move(jobs);
+            size_t total = shared->jobs.size();
+            auto work = [shared, total] {
+                size_t ran = 0;
+                for (size_t i; (i = shared->next.fetch_add(1)) < total; ran++) shared->jobs[i]();
+                if (!ran) return;
+                std::lock_guard<std::mutex> lock(shared->mtx);
+                shared->done += ran;
+                shared->cv.notify_all();
+            };
+            size_t helpers = pool ? std::min(pool->Size(), total - 1) : 0;
+            for (size_t i = 0; i < helpers; i++) pool->Submit(work);
+            work();
+            std::unique_lock<std::mutex> lock(shared->mtx);
+            shared->cv.wait(lock, [&] { return shared->done >= total; });
+        }
+    };
+}
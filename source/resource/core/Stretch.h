@@ -0,0 +1,256 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define GENESIS_STRETCH_SSE2 1
+#endif
+
+/**
+ * @namespace Stretch
+ * @description Cambio de velocidad sin cambiar el tono (WSOLA). La salida se arma con ventanas
+ * Hann solapadas al 50%; cada ventana se toma de la fuente cerca de donde "debería" estar según
+ * la velocidad, desplazada hasta ±10 ms para que continúe lo más parecido posible a la anterior
+ * (correlación normalizada, primero diezmada x4 y después afinada a resolución completa).
+ *
+ * El desplazamiento no se acumula: cada ventana se busca alrededor de su posición nominal, así
+ * que la posición de la fuente que suena en cada muestra de salida es la nominal ± 10 ms durante
+ * toda la canción. A velocidad 1 no se busca y la salida es la fuente tal cual.
+ */
+namespace Stretch {
+
+    constexpr double kMinSpeed = 0.25;
+    constexpr double kMaxSpeed = 4.0;
+
+    namespace Detail {
+        inline float DotScalar(const float* a, const float* b, size_t n) {
+            float s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+            size_t i = 0;
+            for (; i + 4 <= n; i += 4) {
+                s0 += a[i] * b[i]; s1 += a[i + 1] * b[i + 1];
+                s2 += a[i + 2] * b[i + 2]; s3 += a[i + 3] * b[i + 3];
+            }
+            for (; i < n; i++) s0 += a[i] * b[i];
+            return (s0 + s1) + (s2 + s3);
+        }
+
+        /** Producto escalar. Con SSE2, ocho productos por vuelta en dos acumuladores. */
+        inline float Dot(const float* a, const float* b, size_t n) {
+#ifdef GENESIS_STRETCH_SSE2
+            __m128 acc0 = _mm_setzero_ps(), acc1 = _mm_setzero_ps();
+            size_t i = 0;
+            for (; i + 8 <= n; i += 8) {
+                acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+                acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+            }
+            alignas(16) float s[4];
+            _mm_store_ps(s, _mm_add_ps(acc0, acc1));
+            float sum = (s[0] + s[1]) + (s[2] + s[3]);
+            for (; i < n; i++) sum += a[i] * b[i];
+            return sum;
+#else
+            return DotScalar(a, b, n);
+#endif
+        }
+    }
+
+    /**
+     * @class Wsola
+     * @description Estirador de audio intercalado. La fuente se lee por posición absoluta (frames),
+     * así que puede ser una mezcla que se calcula al vuelo.
+     */
+    class Wsola {
+    public:
+        /** Rellena `count` frames intercalados desde el frame `first` de la fuente; ceros fuera. */
+        using Source = std::function<void(int64_t first, size_t count, float* out)>;
+
+        /**
+         * @param {uint32_t} channels - Canales de la fuente y de la salida.
+         * @param {uint32_t} rate - Frecuencia de muestreo: fija la ventana (~23 ms) y la búsqueda (±10 ms).
+         * @param {bool} simd - false fuerza los productos escalares sin SSE2 (para comparar).
+         */
+        Wsola(uint32_t channels, uint32_t rate, bool simd = true) : channels(std::max<uint32_t>(1, channels)), simd(simd) {
+            window = 256;
+            while (window * 2 <= (uint32_t)std::lround(rate * 0.03)) window *= 2;
+            hop = window / 2;
+            search = std::max<uint32_t>(kDecimate, (uint32_t)(rate * 0.010) / kDecimate * kDecimate);
+            hann.resize(window);
+            for (uint32_t i = 0; i < window; i++) hann[i] = (float)(0.5 - 0.5 * std::cos(2.0 * 3.14159265358979323846 * i / window));
+            acc.assign((size_t)window * this->channels, 0.0f);
+            block.assign((size_t)hop * this->channels, 0.0f);
+            frame.resize((size_t)window * this->channels);
+            Reset(0);
+        }
+
+        /** Vacía el estado: la siguiente muestra de salida es el frame `position` de la fuente. */
+        void Reset(double position) {
+            std::fill(acc.begin(), acc.end(), 0.0f);
+            havePrev = false;
+            origin = position;
+            resetPending = true;
+            blockPos = hop;
+        }
+
+        /** Velocidad (0,25 - 4). Se aplica a partir del siguiente salto (~11 ms). */
+        void SetSpeed(double s) { speed = std::min(kMaxSpeed, std::max(kMinSpeed, s)); }
+        double Speed() const { return speed; }
+
+        /** Frame de la fuente (nominal) que suena en la siguiente muestra de salida. */
+        double Position() const {
+            if (resetPending) return origin;
+            return blockClock + blockPos * blockSpeed;
+        }
+
+        uint32_t Window() const { return window; }
+        uint32_t Hop() const { return hop; }
+        uint32_t Search() const { return search; }
+
+        /** Saltos hechos y saltos en los que se buscó el desplazamiento. */
+        uint64_t Hops() const { return hops; }
+        uint64_t Searches() const { return searches; }
+
+        /** Velocidad a la que sale el bloque actual (el cambio de SetSpeed llega en el siguiente). */
+        double BlockSpeed() const { return resetPending ? speed : blockSpeed; }
+
+        /**
+         * Frames que quedan del bloque actual; si no queda ninguno, calcula el siguiente. Hasta ese
+         * número, la posición avanza en línea recta desde Position() a BlockSpeed() frames por frame.
+         */
+        size_t Available(const Source& src) {
+            if (resetPending) {
+                // La primera ventana solo aporta su mitad de bajada a la salida: se calcula y se descarta
+                clock = origin - hop * speed;
+                Step(src);
+                resetPending = false;
+                blockPos = hop;
+            }
+            if (blockPos == hop) Step(src);
+            return hop - blockPos;
+        }
+
+        void Render(float* out, size_t frames, const Source& src) {
+            while (frames) {
+                size_t n = std::min(frames, Available(src));
+                std::copy(block.begin() + (ptrdiff_t)blockPos * channels, block.begin() + (ptrdiff_t)(blockPos + n) * channels, out);
+                out += n * channels;
+                frames -= n;
+                blockPos += (uint32_t)n;
+            }
+        }
+
+    private:
+        static constexpr uint32_t kDecimate = 4;
+
+        void Step(const Source& src) {
+            // Ventana k: su centro (salida k*hop + hop) debe sonar a la posición nominal de ese instante
+            double nominal = clock + hop * speed - hop;
+            int64_t base = (int64_t)std::floor(nominal + 0.5);
+            int64_t at = base;
+            if (havePrev && !(speed == 1.0 && prev + hop == base)) {
+                at = base + Seek(src, base, prev + hop);
+                searches++;
+            }
+            src(at, window, frame.data());
+            const uint32_t C = channels;
+            for (uint32_t i = 0; i < window; i++) {
+                float w = hann[i];
+                for (uint32_t c = 0; c < C; c++) acc[(size_t)i * C + c] += w * frame[(size_t)i * C + c];
+            }
+            std::copy(acc.begin(), acc.begin() + (ptrdiff_t)hop * C, block.begin());
+            std::copy(acc.begin() + (ptrdiff_t)hop * C, acc.end(), acc.begin());
+            std::fill(acc.end() - (ptrdiff_t)hop * C, acc.end(), 0.0f);
+
+            blockClock = clock;
+            blockSpeed = speed;
+            clock += hop * speed;
+            prev = at;
+            havePrev = true;
+            blockPos = 0;
+            hops++;
+        }
+
+        /**
+         * Desplazamiento en [-search, search] alrededor de `base` cuyo comienzo más se parece a la
+         * continuación natural de la ventana anterior (`natural`, `hop` frames de solape).
+         */
+        int32_t Seek(const Source& src, int64_t base, int64_t natural) {
+            const uint32_t C = channels, L = hop;
+            int64_t lo = std::min(base - (int64_t)search, natural);
+            int64_t hi = std::max(base + (int64_t)search + L, natural + L);
+            size_t n = (size_t)(hi - lo);
+            span.resize(n * C);
+            src(lo, n, span.data());
+            mono.resize(n);
+            for (size_t i = 0; i < n; i++) {
+                float s = 0;
+                for (uint32_t c = 0; c < C; c++) s += span[i * C + c];
+                mono[i] = s;
+            }
+            const float* target = mono.data() + (natural - lo);
+            const float* first = mono.data() + (base - (int64_t)search - lo);
+            auto dot = simd ? Detail::Dot : Detail::DotScalar;
+
+            // Diezmado x4 (media de cada cuatro): objetivo y candidatos desde base - search
+            const uint32_t D = kDecimate, Ld = L / D, span4 = 2 * search / D;
+            targetDec.resize(Ld);
+            for (uint32_t j = 0; j < Ld; j++) {
+                const float* p = target + (size_t)j * D;
+                targetDec[j] = (p[0] + p[1]) + (p[2] + p[3]);
+            }
+            size_t candCount = span4 + Ld;
+            candDec.resize(candCount);
+            energy.resize(candCount + 1);
+            energy[0] = 0;
+            for (size_t j = 0; j < candCount; j++) {
+                const float* p = first + j * D;
+                float v = (p[0] + p[1]) + (p[2] + p[3]);
+                candDec[j] = v;
+                energy[j + 1] = energy[j] + (double)v * v;
+            }
+            double floor = 1e-9 * (energy[candCount] + 1e-12);
+            int32_t best = 0;
+            double bestScore = -1e300;
+            for (uint32_t m = 0; m <= span4; m++) {
+                double e = energy[m + Ld] - energy[m];
+                double c = dot(targetDec.data(), candDec.data() + m, Ld);
+                double score = c / std::sqrt(e + floor);
+                int32_t delta = (int32_t)(m * D) - (int32_t)search;
+                if (score > bestScore || (score == bestScore && std::abs(delta) < std::abs(best))) { bestScore = score; best = delta; }
+            }
+            if (bestScore <= 0 && energy[candCount] <= 1e-12) return 0;
+
+            // Afinado a resolución completa alrededor del mejor
+            int32_t from = std::max(-(int32_t)search, best - (int32_t)D + 1);
+            int32_t to = std::min((int32_t)search, best + (int32_t)D - 1);
+            int32_t fine = best;
+            double fineScore = -1e300;
+            for (int32_t d = from; d <= to; d++) {
+                const float* cand = mono.data() + (base + d - lo);
+                double e = dot(cand, cand, L);
+                double c = dot(target, cand, L);
+                double score = c / std::sqrt(e + 1e-9);
+                if (score > fineScore) { fineScore = score; fine = d; }
+            }
+            return fine;
+        }
+
+        uint32_t channels, window = 0, hop = 0, search = 0;
+        bool simd;
+        double speed = 1.0;
+        double origin = 0;          // Posición pedida en Reset, hasta el primer Render
+        double clock = 0;           // Posición nominal de la fuente al empezar el siguiente bloque
+        double blockClock = 0, blockSpeed = 1.0;
+        uint32_t blockPos = 0;      // Frames ya entregados del bloque actual
+        bool resetPending = true;
+        bool havePrev = false;
+        int64_t prev = 0;
+        uint64_t hops = 0, searches = 0;
+        std::vector<float> hann, acc, block, frame, span, mono, targetDec, candDec;
+        std::vector<double> energy;
+    };
+}
@@ -0,0 +1,189 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @class TaskPool
+ * @description Pool de hilos con robo de trabajo. Cada hilo tiene su propia cola: consume
+ * por el final (LIFO, caché caliente) y, si se queda sin trabajo, roba por el principio de
+ * las colas de los demás. Las tareas externas se reparten en round-robin.
+ */
+class TaskPool {
+public:
+    using Task = std::function<void()>;
+    using ThreadHook = std::function<void()>;
+
+    /**
+     * @param {size_t} threads - Número de hilos (0 = núcleos disponibles, mínimo 2).
+     * @param {ThreadHook} onStart - Se ejecuta al arrancar cada hilo (ej: CoInitializeEx).
+     * @param {ThreadHook} onExit - Se ejecuta al terminar cada hilo.
+     */
+    explicit TaskPool(size_t threads = 0, ThreadHook onStart = nullptr, ThreadHook onExit = nullptr)
+        : onStart(std::move(onStart)), onExit(std::move(onExit)) {
+        if (threads == 0) threads = std::thread::hardware_concurrency();
+        if (threads < 2) threads = 2;
+        for (size_t i = 0; i < threads; i++) queues.emplace_back(new WorkQueue());
+        for (size_t i = 0; i < threads; i++) workers.emplace_back(&TaskPool::WorkerLoop, this, i);
+    }
+
+    ~TaskPool() { Shutdown(); }
+
+    TaskPool(const TaskPool&) = delete;
+    TaskPool& operator=(const TaskPool&) = delete;
+
+    /**
+     * Encola una tarea. Desde un hilo del pool va a su propia cola; desde fuera, en round-robin.
+     * Después de Shutdown no hace nada.
+     */
+    void Submit(Task task) {
+        if (stopping.load(std::memory_order_acquire)) return;
+        size_t idx = (CurrentIndex() != kNoWorker && CurrentPool() == this)
+            ? CurrentIndex()
+            : next.fetch_add(1, std::memory_order_relaxed) % queues.size();
+        outstanding.fetch_add(1, std::memory_order_relaxed);
+        {
+            std::lock_guard<std::mutex> lock(queues[idx]->mtx);
+            queues[idx]->tasks.push_back(std::move(task));
+        }
+        pending.fetch_add(1, std::memory_order_release);
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+        }
+        wake.notify_one();
+    }
+
+    /**
+     * Espera a que no quede nada en cola ni ejecutándose, incluidas las tareas que encolen
+     * otras tareas (y las de las SerialQueue montadas encima). Para cerrar recursos que usan
+     * las tareas antes de Shutdown. No se llama desde un hilo del pool.
+     */
+    void WaitIdle() {
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        idle.wait(lock, [this] { return stopping || outstanding.load(std::memory_order_acquire) == 0; });
+    }
+
+    /**
+     * Detiene el pool: cada hilo termina la tarea que esté ejecutando y sale aunque siga
+     * llegando trabajo. Las tareas aún en cola se descartan.
+     */
+    void Shutdown() {
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            if (stopping) return;
+            stopping = true;
+        }
+        wake.notify_all();
+        idle.notify_all();
+        for (auto& t : workers) if (t.joinable()) t.join();
+    }
+
+    size_t Size() const { return queues.size(); }
+
+private:
+    struct WorkQueue {
+        std::mutex mtx;
+        std::deque<Task> tasks;
+    };
+
+    static constexpr size_t kNoWorker = (size_t)-1;
+
+    std::vector<std::unique_ptr<WorkQueue>> queues;
+    std::vector<std::thread> workers;
+    std::atomic<size_t> next{0};
+    std::atomic<size_t> pending{0};
+    std::atomic<size_t> outstanding{0}; // Encoladas + en ejecución
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    std::condition_variable idle;
+    std::atomic<bool> stopping{false}; // Se escribe con sleepMutex tomado
+    ThreadHook onStart, onExit;
+
+    static size_t& CurrentIndex() { static thread_local size_t idx = kNoWorker; return idx; }
+    static TaskPool*& CurrentPool() { static thread_local TaskPool* pool = nullptr; return pool; }
+
+    bool TryPop(size_t self, Task& out) {
+        {
+            WorkQueue& own = *queues[self];
+            std::lock_guard<std::mutex> lock(own.mtx);
+            if (!own.tasks.empty()) { out = std::move(own.tasks.back()); own.tasks.pop_back(); return true; }
+        }
+        for (size_t i = 1; i < queues.size(); i++) {
+            WorkQueue& victim = *queues[(self + i) % queues.size()];
+            std::unique_lock<std::mutex> lock(victim.mtx, std::try_to_lock);
+            if (lock.owns_lock() && !victim.tasks.empty()) {
+                out = std::move(victim.tasks.front()); victim.tasks.pop_front(); return true;
+            }
+        }
+        return false;
+    }
+
+    void WorkerLoop(size_t self) {
+        CurrentIndex() = self; CurrentPool() = this;
+        if (onStart) onStart();
+        Task task;
+        while (true) {
+            if (!stopping.load(std::memory_order_acquire) && pending.load(std::memory_order_acquire) > 0 && TryPop(self, task)) {
+                pending.fetch_sub(1, std::memory_order_relaxed);
+                try { task(); } catch (...) {}
+                task = nullptr;
+                if (outstanding.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    std::lock_guard<std::mutex> lock(sleepMutex);
+                    idle.notify_all();
+                }
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(sleepMutex);
+            if (stopping) break;
+            // El try_lock del robo puede fallar con trabajo pendiente: se reintenta sin dormir mucho
+            if (pending.load(std::memory_order_acquire) > 0) { lock.unlock(); std::this_thread::yield(); continue; }
+            wake.wait(lock, [this] { return stopping || pending.load(std::memory_order_acquire) > 0; });
+            if (stopping) break;
+        }
+        if (onExit) onExit();
+    }
+};
+
+/**
+ * @class SerialQueue
+ * @description Ejecuta sus tareas de una en una y en orden FIFO sobre un TaskPool
+ * (ej: escrituras a disco que no deben reordenarse).
+ */
+class SerialQueue {
+public:
+    explicit SerialQueue(TaskPool& pool) : pool(pool) {}
+
+    void Submit(TaskPool::Task task) {
+        bool schedule = false;
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            tasks.push_back(std::move(task));
+            if (!running) { running = true; schedule = true; }
+        }
+        if (schedule) pool.Submit([this] { Drain(); });
+    }
+
+private:
+    TaskPool& pool;
+    std::mutex mtx;
+    std::deque<TaskPool::Task> tasks;
+    bool running = false;
+
+    void Drain() {
+        while (true) {
+            TaskPool::Task task;
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                if (tasks.empty()) { running = false; return; }
+                task = std::move(tasks.front()); tasks.pop_front();
+            }
+            try { task(); } catch (...) {}
+        }
+    }
+};
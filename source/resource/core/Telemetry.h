@@ -0,0 +1,608 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "Json.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#include <tlhelp32.h>
+#else
+#include <dirent.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+/**
+ * @namespace Telemetry
+ * @description Medición de rendimiento del proceso: histogramas de latencia, un registro circular
+ * de eventos (lo último que pasó, para reportes de tirones) y muestreo de recursos.
+ * Grabar no toma locks: contadores atómicos y un anillo con secuencia por casilla.
+ * Todo se exporta como JSON de trace-events de Chrome (chrome://tracing, Perfetto).
+ */
+namespace Telemetry {
+
+    /** Reloj monotónico en nanosegundos; todas las marcas de tiempo usan este. */
+    inline uint64_t NowNs() {
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    namespace Detail {
+        inline int HighBit(uint64_t v) {
+#ifdef _MSC_VER
+            unsigned long i;
+            _BitScanReverse64(&i, v);
+            return (int)i;
+#else
+            return 63 - __builtin_clzll(v);
+#endif
+        }
+
+        inline void AppendMicros(std::string& out, uint64_t ns) {
+            char buf[32];
+            std::snprintf(buf, sizeof(buf), "%llu.%03u", (unsigned long long)(ns / 1000), (unsigned)(ns % 1000));
+            out += buf;
+        }
+
+        inline void AppendMs(std::string& out, uint64_t ns) {
+            char buf[32];
+            std::snprintf(buf, sizeof(buf), "%.3f", ns / 1e6);
+            out += buf;
+        }
+    }
+
+    /**
+     * @class Histogram
+     * @description Histograma log-lineal estilo HDR para valores en nanosegundos.
+     * 64 subcubetas por potencia de dos: error relativo < 1.6% hasta ~18 minutos.
+     * Record es wait-free (un fetch_add); las lecturas pueden ir a la vez que las escrituras.
+     */
+    class Histogram {
+    public:
+        static constexpr int kSubBits = 7;
+        static constexpr uint64_t kSub = 1ull << kSubBits;   // Valores < kSub son exactos
+        static constexpr uint64_t kHalf = kSub / 2;
+        static constexpr int kMaxBits = 40;                   // Por encima se satura
+        static constexpr size_t kBuckets = kSub + (kMaxBits - kSubBits) * kHalf;
+
+        Histogram() { Reset(); }
+
+        static size_t IndexOf(uint64_t v) {
+            if (v < kSub) return (size_t)v;
+            if (v >> kMaxBits) return kBuckets - 1;
+            int shift = Detail::HighBit(v) - (kSubBits - 1);
+            return (size_t)(kSub + (shift - 1) * kHalf + ((v >> shift) - kHalf));
+        }
+
+        /** Límite inferior del rango de una cubeta y su ancho. */
+        static uint64_t LowerBound(size_t i, uint64_t* width = nullptr) {
+            if (i < kSub) { if (width) *width = 1; return i; }
+            size_t k = i - kSub;
+            int shift = (int)(k / kHalf) + 1;
+            if (width) *width = 1ull << shift;
+            return (kHalf + k % kHalf) << shift;
+        }
+
+        void Record(uint64_t v) {
+            counts[IndexOf(v)].fetch_add(1, std::memory_order_relaxed);
+            total.fetch_add(1, std::memory_order_relaxed);
+            sum.fetch_add(v, std::memory_order_relaxed);
+            uint64_t cur = lo.load(std::memory_order_relaxed);
+            while (v < cur && !lo.compare_exchange_weak(cur, v, std::memory_order_relaxed)) {}
+            cur = hi.load(std::memory_order_relaxed);
+            while (v > cur && !hi.compare_exchange_weak(cur, v, std::memory_order_relaxed)) {}
+        }
+
+        uint64_t Count() const { return total.load(std::memory_order_relaxed); }
+        uint64_t Min() const { return Count() ? lo.load(std::memory_order_relaxed) : 0; }
+        uint64_t Max() const { return hi.load(std::memory_order_relaxed); }
+        double Mean() const { uint64_t n = Count(); return n ? (double)sum.load(std::memory_order_relaxed) / n : 0.0; }
+
+        /**
+         * Valor del percentil `q` (0..1): punto medio de la cubeta que lo contiene, acotado a [Min, Max].
+         */
+        uint64_t Percentile(double q) const {
+            uint64_t n = 0;
+            for (size_t i = 0; i < kBuckets; i++) n += counts[i].load(std::memory_order_relaxed);
+            if (n == 0) return 0;
+            uint64_t rank = (uint64_t)std::max(1.0, std::ceil(std::min(1.0, std::max(0.0, q)) * (double)n));
+            uint64_t seen = 0;
+            for (size_t i = 0; i < kBuckets; i++) {
+                seen += counts[i].load(std::memory_order_relaxed);
+                if (seen >= rank) {
+                    uint64_t width, v = LowerBound(i, &width);
+                    v += width / 2;
+                    return std::min(std::max(v, Min()), Max());
+                }
+            }
+            return Max();
+        }
+
+        void Reset() {
+            for (auto& c : counts) c.store(0, std::memory_order_relaxed);
+            total.store(0, std::memory_order_relaxed);
+            sum.store(0, std::memory_order_relaxed);
+            lo.store(UINT64_MAX, std::memory_order_relaxed);
+            hi.store(0, std::memory_order_relaxed);
+        }
+
+    private:
+        std::atomic<uint64_t> counts[kBuckets];
+        std::atomic<uint64_t> total, sum, lo, hi;
+    };
+
+    enum class Phase : uint8_t { Complete, Counter, Instant };
+
+    struct Event {
+        uint64_t ts = 0;      // NowNs()
+        uint64_t dur = 0;     // Complete
+        double value = 0;     // Counter
+        uint32_t name = 0;
+        uint32_t tid = 0;
+        Phase phase = Phase::Complete;
+    };
+
+    /**
+     * @class EventRing
+     * @description Registro circular multi-productor que se sobrescribe (guarda los últimos N eventos).
+     * Cada casilla lleva una secuencia tipo seqlock; Snapshot descarta las que se estaban
+     * escribiendo o ya fueron pisadas, nunca devuelve un evento a medias.
+     */
+    class EventRing {
+    public:
+        explicit EventRing(size_t capacity = 1u << 15) {
+            size_t n = 1;
+            while (n < capacity) n <<= 1;
+            mask = n - 1;
+            slots.reset(new Slot[n]);
+        }
+
+        size_t Capacity() const { return mask + 1; }
+        uint64_t Written() const { return head.load(std::memory_order_relaxed); }
+
+        void Push(const Event& e) {
+            uint64_t idx = head.fetch_add(1, std::memory_order_relaxed);
+            Slot& s = slots[idx & mask];
+            s.seq.store(idx * 2 + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            uint64_t bits;
+            std::memcpy(&bits, &e.value, sizeof(bits));
+            s.w[0].store(e.ts, std::memory_order_relaxed);
+            s.w[1].store(e.phase == Phase::Counter ? bits : e.dur, std::memory_order_relaxed);
+            s.w[2].store((uint64_t)e.name | ((uint64_t)e.phase << 32), std::memory_order_relaxed);
+            s.w[3].store(e.tid, std::memory_order_relaxed);
+            s.seq.store(idx * 2 + 2, std::memory_order_release);
+        }
+
+        /**
+         * Copia los eventos retenidos, del más antiguo al más reciente.
+         * @returns {size_t} Eventos descartados por estar a medio escribir o pisados.
+         */
+        size_t Snapshot(std::vector<Event>& out) const {
+            uint64_t end = head.load(std::memory_order_acquire);
+            uint64_t begin = end > Capacity() ? end - Capacity() : 0;
+            size_t skipped = 0;
+            out.reserve(out.size() + (size_t)(end - begin));
+            for (uint64_t idx = begin; idx < end; idx++) {
+                const Slot& s = slots[idx & mask];
+                uint64_t s1 = s.seq.load(std::memory_order_acquire);
+                uint64_t w[4];
+                for (int i = 0; i < 4; i++) w[i] = s.w[i].load(std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_acquire);
+                uint64_t s2 = s.seq.load(std::memory_order_relaxed);
+                if (s1 != idx * 2 + 2 || s2 != s1) { skipped++; continue; }
+                Event e;
+                e.ts = w[0];
+                e.phase = (Phase)(w[2] >> 32);
+                e.name = (uint32_t)w[2];
+                e.tid = (uint32_t)w[3];
+                if (e.phase == Phase::Counter) std::memcpy(&e.value, &w[1], sizeof(e.value));
+                else e.dur = w[1];
+                out.push_back(e);
+            }
+            return skipped;
+        }
+
+    private:
+        struct Slot {
+            std::atomic<uint64_t> seq{0};
+            std::atomic<uint64_t> w[4] = {};
+        };
+        std::unique_ptr<Slot[]> slots;
+        size_t mask = 0;
+        std::atomic<uint64_t> head{0};
+    };
+
+    /** Id corto del hilo actual (2, 3...). El 1 queda para la página. */
+    inline uint32_t CurrentThread() {
+        static std::atomic<uint32_t> next{2};
+        thread_local uint32_t id = next.fetch_add(1, std::memory_order_relaxed);
+        return id;
+    }
+
+    /**
+     * @struct ResourceSample
+     * @description Foto de los recursos del proceso. cpuNs es tiempo de CPU acumulado (usuario + sistema).
+     */
+    struct ResourceSample {
+        uint64_t at = 0;
+        uint64_t rssBytes = 0;
+        uint64_t cpuNs = 0;
+        uint32_t threads = 0;
+        uint32_t handles = 0;   // HANDLEs en Windows, descriptores abiertos en POSIX
+        double cpuPercent = 0;  // Respecto a la muestra anterior (100 = un núcleo entero)
+        bool ok = false;
+    };
+
+    inline bool SampleProcess(ResourceSample& s) {
+        s.at = NowNs();
+#ifdef _WIN32
+        HANDLE self = GetCurrentProcess();
+        PROCESS_MEMORY_COUNTERS pmc;
+        if (!GetProcessMemoryInfo(self, &pmc, sizeof(pmc))) return s.ok = false;
+        s.rssBytes = pmc.WorkingSetSize;
+        FILETIME created, exited, kernel, user;
+        if (GetProcessTimes(self, &created, &exited, &kernel, &user)) {
+            auto ticks = [](const FILETIME& f) { return ((uint64_t)f.dwHighDateTime << 32) | f.dwLowDateTime; };
+            s.cpuNs = (ticks(kernel) + ticks(user)) * 100;
+        }
+        DWORD handles = 0;
+        if (GetProcessHandleCount(self, &handles)) s.handles = handles;
+        HANDLE snap = CreateToolhelp32Snapshot(TH32CS_SNAPTHREAD, 0);
+        if (snap != INVALID_HANDLE_VALUE) {
+            DWORD pid = GetCurrentProcessId();
+            THREADENTRY32 te = { sizeof(te) };
+            uint32_t n = 0;
+            for (BOOL more = Thread32First(snap, &te); more; more = Thread32Next(snap, &te)) if (te.th32OwnerProcessID == pid) n++;
+            CloseHandle(snap);
+            s.threads = n;
+        }
+#else
+        rusage ru = {};
+        if (getrusage(RUSAGE_SELF, &ru) == 0) {
+            s.cpuNs = ((uint64_t)ru.ru_utime.tv_sec + (uint64_t)ru.ru_stime.tv_sec) * 1000000000ull
+                + ((uint64_t)ru.ru_utime.tv_usec + (uint64_t)ru.ru_stime.tv_usec) * 1000ull;
+        }
+        if (FILE* f = std::fopen("/proc/self/statm", "r")) {
+            unsigned long long size = 0, resident = 0;
+            if (std::fscanf(f, "%llu %llu", &size, &resident) == 2) s.rssBytes = resident * (uint64_t)sysconf(_SC_PAGESIZE);
+            std::fclose(f);
+        } else {
+            s.rssBytes = (uint64_t)ru.ru_maxrss * 1024; // Sin /proc: el pico es lo mejor que hay
+        }
+        if (FILE* f = std::fopen("/proc/self/stat", "r")) {
+            char buf[1024];
+            size_t n = std::fread(buf, 1, sizeof(buf) - 1, f);
+            std::fclose(f);
+            buf[n] = 0;
+            // Tras el nombre (que puede tener espacios y paréntesis) vienen los campos 3..; num_threads es el 20
+            if (const char* p = std::strrchr(buf, ')')) {
+                int field = 2;
+                for (p++; *p && field < 20; p++) if (*p == ' ') field++;
+                s.threads = (uint32_t)std::strtoul(p, nullptr, 10);
+            }
+        }
+        if (DIR* d = opendir("/proc/self/fd")) {
+            uint32_t n = 0;
+            while (dirent* e = readdir(d)) if (e->d_name[0] != '.') n++;
+            closedir(d);
+            s.handles = n > 0 ? n - 1 : 0; // Sin contar el del propio opendir
+        }
+#endif
+        return s.ok = true;
+    }
+
+    /**
+     * @class Hub
+     * @description Punto central: nombres internados, series con histograma y el anillo de eventos.
+     * Las series se crean al arrancar (o la primera vez que aparece un nombre) y sus punteros son estables;
+     * en caliente solo se graba.
+     */
+    class Hub {
+    public:
+        static constexpr uint32_t kPageThread = 1;
+        static constexpr size_t kMaxSeries = 256;
+
+        struct Series {
+            uint32_t name = 0;
+            std::string label;
+            Histogram hist;
+        };
+
+        explicit Hub(size_t ringCapacity = 1u << 15)
+            : ring(ringCapacity), originNs(NowNs()),
+              originEpochNs((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count()) {
+            threadNames[kPageThread] = "page";
+        }
+
+        uint32_t Intern(std::string_view name) {
+            std::lock_guard<std::mutex> lock(mutex);
+            return InternLocked(name);
+        }
+
+        /**
+         * Serie con ese nombre (la crea si hace falta). nullptr si ya hay kMaxSeries.
+         */
+        Series* Get(std::string_view label) {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (auto& s : series) if (s->label == label) return s.get();
+            if (series.size() >= kMaxSeries) return nullptr;
+            auto s = std::make_unique<Series>();
+            s->label.assign(label.data(), label.size());
+            s->name = InternLocked(label);
+            series.push_back(std::move(s));
+            return series.back().get();
+        }
+
+        void NameThread(std::string_view name, uint32_t tid = CurrentThread()) {
+            std::lock_guard<std::mutex> lock(mutex);
+            threadNames[tid].assign(name.data(), name.size());
+        }
+
+        /** Tramo con duración: va al histograma de la serie y al anillo. */
+        void Complete(Series& s, uint64_t startNs, uint64_t endNs, uint32_t tid = CurrentThread()) {
+            uint64_t dur = endNs > startNs ? endNs - startNs : 0;
+            s.hist.Record(dur);
+            Event e;
+            e.ts = startNs; e.dur = dur; e.name = s.name; e.tid = tid; e.phase = Phase::Complete;
+            ring.Push(e);
+        }
+
+        void Counter(uint32_t name, double value, uint64_t ts = NowNs()) {
+            Event e;
+            e.ts = ts; e.value = value; e.name = name; e.phase = Phase::Counter;
+            ring.Push(e);
+        }
+
+        void Instant(uint32_t name, uint64_t ts = NowNs(), uint32_t tid = CurrentThread()) {
+            Event e;
+            e.ts = ts; e.name = name; e.tid = tid; e.phase = Phase::Instant;
+            ring.Push(e);
+        }
+
+        /** Convierte una marca de la página (performance.timeOrigin + now(), en ms) al reloj de NowNs. */
+        uint64_t FromEpochMs(double epochMs) const {
+            double delta = epochMs * 1e6 - (double)originEpochNs;
+            double ns = (double)originNs + delta;
+            return ns <= 0 ? 0 : (uint64_t)ns;
+        }
+
+        uint64_t Origin() const { return originNs; }
+        const EventRing& Ring() const { return ring; }
+
+        /**
+         * Resumen para la página: {"uptimeMs","events","series":{nombre:{count,mean,min,p50,p90,p99,max}},"process":{...}}.
+         * Los tiempos van en milisegundos.
+         */
+        std::string StatsJson(const ResourceSample* process = nullptr) {
+            std::string out = "{\"uptimeMs\":";
+            Detail::AppendMs(out, NowNs() - originNs);
+            out += ",\"events\":" + std::to_string(ring.Written()) + ",\"series\":{";
+            std::lock_guard<std::mutex> lock(mutex);
+            bool first = true;
+            for (const auto& s : series) {
+                if (s->hist.Count() == 0) continue;
+                if (!first) out += ',';
+                first = false;
+                Json::AppendString(out, s->label);
+                out += ":";
+                AppendSummary(out, s->hist);
+            }
+            out += '}';
+            if (process && process->ok) {
+                out += ",\"process\":{\"rssBytes\":" + std::to_string(process->rssBytes);
+                out += ",\"cpuPercent\":"; Json::AppendNumber(out, std::round(process->cpuPercent * 10) / 10);
+                out += ",\"threads\":" + std::to_string(process->threads);
+                out += ",\"handles\":" + std::to_string(process->handles) + "}";
+            }
+            out += '}';
+            return out;
+        }
+
+        /**
+         * JSON de trace-events de Chrome con los eventos retenidos en el anillo.
+         * Los resúmenes de cada serie van en "otherData".
+         */
+        void WriteTrace(std::string& out) {
+            std::vector<Event> events;
+            ring.Snapshot(events);
+            std::stable_sort(events.begin(), events.end(), [](const Event& a, const Event& b) { return a.ts < b.ts; });
+
+            std::vector<std::string> names;
+            std::unordered_map<uint32_t, std::string> threadsCopy;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                names = this->names;
+                threadsCopy = threadNames;
+            }
+            out.reserve(out.size() + events.size() * 96 + 256);
+            out += "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+            out += "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"Genesis\"}}";
+            for (const auto& kv : threadsCopy) {
+                out += ",{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" + std::to_string(kv.first) + ",\"args\":{\"name\":";
+                Json::AppendString(out, kv.second);
+                out += "}}";
+            }
+            static const std::string unknown = "?";
+            for (const auto& e : events) {
+                const std::string& name = e.name < names.size() ? names[e.name] : unknown;
+                uint64_t ts = e.ts > originNs ? e.ts - originNs : 0;
+                out += ",{\"name\":";
+                Json::AppendString(out, name);
+                switch (e.phase) {
+                case Phase::Complete:
+                    out += e.tid == kPageThread ? ",\"cat\":\"page\",\"ph\":\"X\",\"ts\":" : ",\"cat\":\"native\",\"ph\":\"X\",\"ts\":";
+                    Detail::AppendMicros(out, ts);
+                    out += ",\"dur\":";
+                    Detail::AppendMicros(out, e.dur);
+                    break;
+                case Phase::Counter:
+                    out += ",\"cat\":\"process\",\"ph\":\"C\",\"ts\":";
+                    Detail::AppendMicros(out, ts);
+                    out += ",\"args\":{\"value\":";
+                    Json::AppendNumber(out, e.value);
+                    out += '}';
+                    break;
+                case Phase::Instant:
+                    out += ",\"cat\":\"native\",\"ph\":\"i\",\"s\":\"t\",\"ts\":";
+                    Detail::AppendMicros(out, ts);
+                    break;
+                }
+                out += ",\"pid\":1,\"tid\":" + std::to_string(e.phase == Phase::Counter ? 0 : e.tid) + "}";
+            }
+            out += "],\"otherData\":{\"series\":{";
+            std::lock_guard<std::mutex> lock(mutex);
+            bool first = true;
+            for (const auto& s : series) {
+                if (s->hist.Count() == 0) continue;
+                if (!first) out += ',';
+                first = false;
+                Json::AppendString(out, s->label);
+                out += ':';
+                AppendSummary(out, s->hist);
+            }
+            out += "}}}";
+        }
+
+    private:
+        EventRing ring;
+        uint64_t originNs;
+        uint64_t originEpochNs;
+        std::mutex mutex;
+        std::vector<std::string> names;
+        std::unordered_map<std::string, uint32_t> nameIds;
+        std::unordered_map<uint32_t, std::string> threadNames;
+        std::vector<std::unique_ptr<Series>> series;
+
+        uint32_t InternLocked(std::string_view name) {
+            auto it = nameIds.find(std::string(name));
+            if (it != nameIds.end()) return it->second;
+            uint32_t id = (uint32_t)names.size();
+            names.emplace_back(name);
+            nameIds.emplace(names.back(), id);
+            return id;
+        }
+
+        static void AppendSummary(std::string& out, const Histogram& h) {
+            out += "{\"count\":" + std::to_string(h.Count());
+            out += ",\"mean\":"; Detail::AppendMs(out, (uint64_t)h.Mean());
+            out += ",\"min\":"; Detail::AppendMs(out, h.Min());
+            out += ",\"p50\":"; Detail::AppendMs(out, h.Percentile(0.50));
+            out += ",\"p90\":"; Detail::AppendMs(out, h.Percentile(0.90));
+            out += ",\"p99\":"; Detail::AppendMs(out, h.Percentile(0.99));
+            out += ",\"max\":"; Detail::AppendMs(out, h.Max());
+            out += '}';
+        }
+    };
+
+    /**
+     * @class Scope
+     * @description Mide el bloque donde vive y lo graba al salir.
+     */
+    class Scope {
+    public:
+        Scope(Hub& hub, Hub::Series* s) : hub(hub), s(s), start(s ? NowNs() : 0) {}
+        ~Scope() { if (s) hub.Complete(*s, start, NowNs()); }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    private:
+        Hub& hub;
+        Hub::Series* s;
+        uint64_t start;
+    };
+
+    /**
+     * @class Sampler
+     * @description Hilo que cada `interval` toma una ResourceSample y la graba como contadores
+     * (process.rssMB, process.cpu, process.threads, process.handles). Espera en una
+     * condition_variable, así que Stop no tiene que esperar al siguiente tick.
+     */
+    class Sampler {
+    public:
+        explicit Sampler(Hub& hub) : hub(hub) {}
+        ~Sampler() { Stop(); }
+
+        void Start(std::chrono::milliseconds interval = std::chrono::milliseconds(250)) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (worker.joinable()) return;
+            this->interval = interval;
+            stopping = false;
+            rss = hub.Intern("process.rssMB");
+            cpu = hub.Intern("process.cpu");
+            threads = hub.Intern("process.threads");
+            handles = hub.Intern("process.handles");
+            worker = std::thread(&Sampler::Loop, this);
+        }
+
+        void Stop() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!worker.joinable()) return;
+                stopping = true;
+            }
+            wake.notify_all();
+            worker.join();
+        }
+
+        /** Última muestra (o una tomada ahora si el hilo no corre todavía). */
+        ResourceSample Latest() {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!latest.ok) SampleProcess(latest);
+            return latest;
+        }
+
+        uint64_t Samples() const { return samples.load(std::memory_order_relaxed); }
+
+    private:
+        Hub& hub;
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::thread worker;
+        bool stopping = false;
+        std::chrono::milliseconds interval{250};
+        ResourceSample latest;
+        std::atomic<uint64_t> samples{0};
+        uint32_t rss = 0, cpu = 0, threads = 0, handles = 0;
+
+        void Loop() {
+            hub.NameThread("sampler");
+            ResourceSample prev;
+            SampleProcess(prev);
+            std::unique_lock<std::mutex> lock(mutex);
+            while (!wake.wait_for(lock, interval, [&] { return stopping; })) {
+                lock.unlock();
+                ResourceSample s;
+                SampleProcess(s);
+                if (s.ok && prev.ok && s.at > prev.at) s.cpuPercent = 100.0 * (double)(s.cpuNs - std::min(s.cpuNs, prev.cpuNs)) / (double)(s.at - prev.at);
+                if (s.ok) {
+                    hub.Counter(rss, (double)s.rssBytes / 1048576.0, s.at);
+                    hub.Counter(cpu, s.cpuPercent, s.at);
+                    hub.Counter(threads, s.threads, s.at);
+                    hub.Counter(handles, s.handles, s.at);
+                }
+                prev = s;
+                samples.fetch_add(1, std::memory_order_relaxed);
+                lock.lock();
+                latest = s;
+            }
+        }
+    };
+}
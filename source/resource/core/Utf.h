@@ -0,0 +1,508 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Rutas vectoriales: SSE2 en cualquier x64; AVX2 si el compilador lo tiene activado
+// (-mavx2 / /arch:AVX2, opción GENESIS_AVX2 de CMake). GENESIS_UTF_SCALAR las desactiva.
+#if !defined(GENESIS_UTF_SCALAR) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define GENESIS_UTF_SSE2 1
+#include <emmintrin.h>
+#if defined(__AVX2__)
+#define GENESIS_UTF_AVX2 1
+#include <immintrin.h>
+#endif
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+/**
+ * @namespace Utf
+ * @description Conversión UTF-8 <-> wchar_t portable. En Windows wchar_t es UTF-16;
+ * en Linux es UTF-32. Las secuencias inválidas se sustituyen por U+FFFD.
+ *
+ * Los tramos ASCII se procesan de 16 en 16 bytes (SSE2) o de 32 en 32 (AVX2); el resto
+ * va code point a code point. WideLength/Utf8Length predicen el tamaño exacto de la salida,
+ * así que las funciones Append* reservan una sola vez y escriben directamente en el buffer
+ * del llamador (que puede reutilizarse entre mensajes). Los núcleos son plantillas sobre el
+ * tipo de unidad (wchar_t, char16_t o char32_t) para poder probar la ruta UTF-16 fuera de Windows.
+ */
+namespace Utf {
+
+    constexpr char32_t kReplacement = 0xFFFD;
+
+    namespace detail {
+
+        /** Marca de secuencia inválida (distinta de un U+FFFD legítimo en la entrada). */
+        constexpr char32_t kInvalid = 0xFFFFFFFF;
+
+        inline unsigned Ctz(uint32_t v) {
+#if defined(_MSC_VER) && !defined(__clang__)
+            unsigned long i; _BitScanForward(&i, v); return (unsigned)i;
+#else
+            return (unsigned)__builtin_ctz(v);
+#endif
+        }
+
+        /** Sin POPCNT (x64 base) __builtin_popcount acaba en una llamada a libgcc: mejor SWAR. */
+        inline unsigned Popcount(uint32_t v) {
+#if defined(__POPCNT__)
+            return (unsigned)__builtin_popcount(v);
+#else
+            v = v - ((v >> 1) & 0x55555555u);
+            v = (v & 0x33333333u) + ((v >> 2) & 0x33333333u);
+            return (unsigned)((((v + (v >> 4)) & 0x0F0F0F0Fu) * 0x01010101u) >> 24);
+#endif
+        }
+
+        /**
+         * Decodifica una secuencia multibyte que empieza en `s[i]` (>= 0x80) y avanza `i`.
+         * Inválida: avanza lo mismo que DecodeUtf8 y devuelve kInvalid.
+         */
+        inline char32_t DecodeMulti(const unsigned char* s, size_t n, size_t& i) {
+            unsigned char c = s[i];
+            // Casos frecuentes (latín y CJK) sin bucle
+            if (c >= 0xC2 && c <= 0xDF && i + 1 < n && (s[i + 1] & 0xC0) == 0x80) {
+                char32_t cp = ((char32_t)(c & 0x1F) << 6) | (s[i + 1] & 0x3F);
+                i += 2; return cp;
+            }
+            if (c >= 0xE0 && c <= 0xEF && i + 2 < n && (s[i + 1] & 0xC0) == 0x80 && (s[i + 2] & 0xC0) == 0x80) {
+                char32_t cp = ((char32_t)(c & 0x0F) << 12) | ((char32_t)(s[i + 1] & 0x3F) << 6) | (s[i + 2] & 0x3F);
+                i += 3;
+                return (cp < 0x800 || (cp >= 0xD800 && cp <= 0xDFFF)) ? kInvalid : cp;
+            }
+            int len = (c >= 0xF0 && c <= 0xF4) ? 4 : (c >= 0xE0 && c <= 0xEF) ? 3 : (c >= 0xC2 && c <= 0xDF) ? 2 : 0;
+            if (len == 0 || i + len > n) { i++; return kInvalid; }
+            char32_t cp = c & (0x7F >> len);
+            for (int k = 1; k < len; k++) {
+                unsigned char cc = s[i + k];
+                if ((cc & 0xC0) != 0x80) { i += k; return kInvalid; }
+                cp = (cp << 6) | (cc & 0x3F);
+            }
+            // Rechaza formas demasiado largas y valores fuera de rango
+            i += len;
+            return (len == 4 && (cp < 0x10000 || cp > 0x10FFFF)) ? kInvalid : cp;
+        }
+
+        /** Unidades (UTF-16 o UTF-32 según W) que ocupa un code point ya decodificado. */
+        template <typename W>
+        inline size_t WideUnits(char32_t cp) {
+            if (cp == kInvalid) return 1;
+            return (sizeof(W) == 2 && cp >= 0x10000) ? 2 : 1;
+        }
+
+        template <typename W>
+        inline W* PutWide(W* d, char32_t cp) {
+            if (cp == kInvalid) { *d++ = (W)kReplacement; return d; }
+            if constexpr (sizeof(W) == 2) {
+                if (cp >= 0x10000) {
+                    cp -= 0x10000;
+                    *d++ = (W)(0xD800 + (cp >> 10));
+                    *d++ = (W)(0xDC00 + (cp & 0x3FF));
+                    return d;
+                }
+            }
+            *d++ = (W)cp;
+            return d;
+        }
+
+        /**
+         * Lee el code point de `w[i]` (pares de sustitutos en UTF-16) y avanza `i`.
+         * Sustitutos sueltos y valores fuera de Unicode devuelven kInvalid.
+         */
+        template <typename W>
+        inline char32_t DecodeWide(const W* w, size_t n, size_t& i) {
+            char32_t cp = (char32_t)(uint32_t)w[i++];
+            if constexpr (sizeof(W) == 2) {
+                cp &= 0xFFFF;
+                if (cp >= 0xD800 && cp <= 0xDBFF && i < n && (uint16_t)w[i] >= 0xDC00 && (uint16_t)w[i] <= 0xDFFF)
+                    return 0x10000 + ((cp - 0xD800) << 10) + ((char32_t)(uint16_t)w[i++] - 0xDC00);
+            }
+            return ((cp >= 0xD800 && cp <= 0xDFFF) || cp > 0x10FFFF) ? kInvalid : cp;
+        }
+
+        inline size_t Utf8Units(char32_t cp) {
+            if (cp == kInvalid) return 3;
+            return cp < 0x80 ? 1 : cp < 0x800 ? 2 : cp < 0x10000 ? 3 : 4;
+        }
+
+        inline char* PutUtf8(char* d, char32_t cp) {
+            if (cp == kInvalid) cp = kReplacement;
+            if (cp < 0x80) { *d++ = (char)cp; }
+            else if (cp < 0x800) { *d++ = (char)(0xC0 | (cp >> 6)); *d++ = (char)(0x80 | (cp & 0x3F)); }
+            else if (cp < 0x10000) { *d++ = (char)(0xE0 | (cp >> 12)); *d++ = (char)(0x80 | ((cp >> 6) & 0x3F)); *d++ = (char)(0x80 | (cp & 0x3F)); }
+            else { *d++ = (char)(0xF0 | (cp >> 18)); *d++ = (char)(0x80 | ((cp >> 12) & 0x3F)); *d++ = (char)(0x80 | ((cp >> 6) & 0x3F)); *d++ = (char)(0x80 | (cp & 0x3F)); }
+            return d;
+        }
+
+        /**
+         * Cuántos bytes ASCII seguidos hay desde `s` (mira como mucho un bloque vectorial).
+         * 0 si no hay bloque completo; el llamador sigue entonces byte a byte.
+         */
+        inline size_t AsciiRun(const unsigned char* s, size_t left) {
+#if defined(GENESIS_UTF_AVX2)
+            if (left >= 32) {
+                uint32_t m = (uint32_t)_mm256_movemask_epi8(_mm256_loadu_si256((const __m256i*)s));
+                return m ? Ctz(m) : 32;
+            }
+#endif
+#if defined(GENESIS_UTF_SSE2)
+            if (left >= 16) {
+                uint32_t m = (uint32_t)_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)s));
+                return m ? Ctz(m) : 16;
+            }
+#endif
+            (void)s; (void)left;
+            return 0;
+        }
+
+        /** Ensancha `k` bytes ASCII a unidades W. */
+        template <typename W>
+        inline void WidenAscii(const unsigned char* s, size_t k, W* d) {
+            size_t off = 0;
+#if defined(GENESIS_UTF_SSE2)
+            for (; off + 16 <= k; off += 16) {
+                __m128i v = _mm_loadu_si128((const __m128i*)(s + off)), z = _mm_setzero_si128();
+                __m128i lo = _mm_unpacklo_epi8(v, z), hi = _mm_unpackhi_epi8(v, z);
+                if constexpr (sizeof(W) == 2) {
+                    _mm_storeu_si128((__m128i*)(d + off), lo);
+                    _mm_storeu_si128((__m128i*)(d + off + 8), hi);
+                } else {
+                    _mm_storeu_si128((__m128i*)(d + off), _mm_unpacklo_epi16(lo, z));
+                    _mm_storeu_si128((__m128i*)(d + off + 4), _mm_unpackhi_epi16(lo, z));
+                    _mm_storeu_si128((__m128i*)(d + off + 8), _mm_unpacklo_epi16(hi, z));
+                    _mm_storeu_si128((__m128i*)(d + off + 12), _mm_unpackhi_epi16(hi, z));
+                }
+            }
+#endif
+            for (; off < k; off++) d[off] = (W)s[off];
+        }
+
+        /**
+         * Cuántas unidades ASCII seguidas hay desde `w` (un bloque de 16 como mucho). `w[0]` ya es ASCII.
+         */
+        template <typename W>
+        inline size_t WideAsciiRun(const W* w, size_t left) {
+#if defined(GENESIS_UTF_SSE2)
+            if (left >= 16) {
+                // Texto con acentos tiene tramos cortos: mirar 4 unidades antes de cargar el bloque
+                if (((uint32_t)w[1] | (uint32_t)w[2] | (uint32_t)w[3]) >= 0x80) {
+                    size_t k = 1;
+                    while ((uint32_t)w[k] < 0x80) k++;
+                    return k;
+                }
+                __m128i any;
+                uint32_t m;
+                if constexpr (sizeof(W) == 2) {
+                    __m128i high = _mm_set1_epi16((short)0xFF80), z = _mm_setzero_si128();
+                    __m128i a = _mm_cmpeq_epi16(_mm_and_si128(_mm_loadu_si128((const __m128i*)w), high), z);
+                    __m128i b = _mm_cmpeq_epi16(_mm_and_si128(_mm_loadu_si128((const __m128i*)(w + 8)), high), z);
+                    any = _mm_packs_epi16(a, b); // 0xFF por unidad ASCII
+                } else {
+                    __m128i high = _mm_set1_epi32((int)0xFFFFFF80), z = _mm_setzero_si128();
+                    __m128i a = _mm_cmpeq_epi32(_mm_and_si128(_mm_loadu_si128((const __m128i*)w), high), z);
+                    __m128i b = _mm_cmpeq_epi32(_mm_and_si128(_mm_loadu_si128((const __m128i*)(w + 4)), high), z);
+                    __m128i c = _mm_cmpeq_epi32(_mm_and_si128(_mm_loadu_si128((const __m128i*)(w + 8)), high), z);
+                    __m128i e = _mm_cmpeq_epi32(_mm_and_si128(_mm_loadu_si128((const __m128i*)(w + 12)), high), z);
+                    any = _mm_packs_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, e));
+                }
+                m = (uint32_t)_mm_movemask_epi8(any) ^ 0xFFFFu;
+                return m ? Ctz(m) : 16;
+            }
+#endif
+            (void)w; (void)left;
+            return 0;
+        }
+
+        /** Estrecha `k` unidades ASCII a bytes. */
+        template <typename W>
+        inline void NarrowAscii(const W* w, size_t k, char* d) {
+#if defined(GENESIS_UTF_SSE2)
+            if (k == 16) {
+                __m128i v;
+                if constexpr (sizeof(W) == 2) {
+                    v = _mm_packus_epi16(_mm_loadu_si128((const __m128i*)w), _mm_loadu_si128((const __m128i*)(w + 8)));
+                } else {
+                    __m128i a = _mm_packs_epi32(_mm_loadu_si128((const __m128i*)w), _mm_loadu_si128((const __m128i*)(w + 4)));
+                    __m128i b = _mm_packs_epi32(_mm_loadu_si128((const __m128i*)(w + 8)), _mm_loadu_si128((const __m128i*)(w + 12)));
+                    v = _mm_packus_epi16(a, b);
+                }
+                _mm_storeu_si128((__m128i*)d, v);
+                return;
+            }
+#endif
+            for (size_t j = 0; j < k; j++) d[j] = (char)w[j];
+        }
+
+        /**
+         * Bytes UTF-8 de un bloque de 8 unidades sin sustitutos (UTF-16) o sin valores fuera de
+         * Unicode (UTF-32). SIZE_MAX si el bloque tiene que ir por la ruta escalar.
+         */
+        template <typename W>
+        inline size_t Utf8LengthBlock(const W* w) {
+#if defined(GENESIS_UTF_SSE2)
+            if constexpr (sizeof(W) == 2) {
+                __m128i v = _mm_loadu_si128((const __m128i*)w), z = _mm_setzero_si128();
+                // Sustitutos: (u - 0x5800) cae en [0x8000, 0x8800), lo más negativo de int16
+                __m128i surrogate = _mm_cmplt_epi16(_mm_sub_epi16(v, _mm_set1_epi16(0x5800)), _mm_set1_epi16((short)0x8800));
+                if (_mm_movemask_epi8(surrogate)) return SIZE_MAX;
+                uint32_t one = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(v, _mm_set1_epi16((short)0xFF80)), z));
+                uint32_t two = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(v, _mm_set1_epi16((short)0xF800)), z));
+                // 3 bytes por unidad menos uno por cada "< 0x80" y otro por cada "< 0x800"
+                return 24 - (Popcount(one) + Popcount(two)) / 2;
+            } else {
+                // En UTF-32 un sustituto suelto también ocupa 3 bytes (U+FFFD): solo se descartan
+                // negativos y valores > U+10FFFF
+                __m128i a = _mm_loadu_si128((const __m128i*)w), b = _mm_loadu_si128((const __m128i*)(w + 4));
+                __m128i max = _mm_set1_epi32(0x10FFFF), z = _mm_setzero_si128();
+                __m128i bad = _mm_or_si128(_mm_or_si128(_mm_cmpgt_epi32(a, max), _mm_cmplt_epi32(a, z)),
+                                           _mm_or_si128(_mm_cmpgt_epi32(b, max), _mm_cmplt_epi32(b, z)));
+                if (_mm_movemask_epi8(bad)) return SIZE_MAX;
+                // Cada comparación verdadera vale -1: restarlas suma un byte por umbral superado
+                __m128i l1 = _mm_set1_epi32(0x7F), l2 = _mm_set1_epi32(0x7FF), l3 = _mm_set1_epi32(0xFFFF);
+                __m128i cnt = _mm_add_epi32(_mm_add_epi32(_mm_cmpgt_epi32(a, l1), _mm_cmpgt_epi32(b, l1)),
+                                            _mm_add_epi32(_mm_cmpgt_epi32(a, l2), _mm_cmpgt_epi32(b, l2)));
+                cnt = _mm_add_epi32(cnt, _mm_add_epi32(_mm_cmpgt_epi32(a, l3), _mm_cmpgt_epi32(b, l3)));
+                cnt = _mm_add_epi32(cnt, _mm_shuffle_epi32(cnt, 0x4E));
+                cnt = _mm_add_epi32(cnt, _mm_shuffle_epi32(cnt, 0xB1));
+                return (size_t)(8 - _mm_cvtsi128_si32(cnt));
+            }
+#else
+            (void)w;
+            return SIZE_MAX;
+#endif
+        }
+
+        /**
+         * Unidades que produciría `s[0..n)` si fuera UTF-8 válido: bytes que no son de
+         * continuación, más uno por cada inicio de 4 bytes en UTF-16 (par de sustitutos).
+         * No valida; el conversor comprueba después que la entrada lo era.
+         */
+        template <typename W>
+        inline size_t CountIfValid(const unsigned char* s, size_t n) {
+            size_t i = 0, units = 0;
+#if defined(GENESIS_UTF_SSE2)
+            const __m128i cont = _mm_set1_epi8((char)0xBF), four = _mm_set1_epi8((char)0xEF);
+            for (; i + 16 <= n; i += 16) {
+                __m128i v = _mm_loadu_si128((const __m128i*)(s + i));
+                // Con signo: continuación = [0x80, 0xBF] = [-128, -65]; inicio de 4 bytes = [0xF0, 0xFF] = [-16, -1]
+                units += Popcount((uint32_t)_mm_movemask_epi8(_mm_cmpgt_epi8(v, cont)));
+                if constexpr (sizeof(W) == 2) {
+                    __m128i lead4 = _mm_and_si128(_mm_cmpgt_epi8(v, four), _mm_cmplt_epi8(v, _mm_setzero_si128()));
+                    units += Popcount((uint32_t)_mm_movemask_epi8(lead4));
+                }
+            }
+#endif
+            for (; i < n; i++) {
+                units += (s[i] & 0xC0) != 0x80;
+                if (sizeof(W) == 2 && s[i] >= 0xF0) units++;
+            }
+            return units;
+        }
+
+        /**
+         * Utf8ToWide en un buffer de `cap` unidades. Se detiene (false) en la primera secuencia
+         * inválida o si no cabe; con entrada válida y cap = CountIfValid escribe exactamente cap.
+         */
+        template <typename W>
+        inline bool Utf8ToWideStrict(const unsigned char* u, size_t n, W* d, size_t cap) {
+            W* end = d + cap;
+            size_t i = 0;
+            while (i < n) {
+                if (u[i] < 0x80) {
+                    size_t run = AsciiRun(u + i, n - i);
+                    if (run == 0) run = 1;
+                    if ((size_t)(end - d) < run) return false;
+                    WidenAscii(u + i, run, d);
+                    i += run; d += run;
+                    continue;
+                }
+                char32_t cp = DecodeMulti(u, n, i);
+                if (cp == kInvalid || (size_t)(end - d) < WideUnits<W>(cp)) return false;
+                d = PutWide(d, cp);
+            }
+            return d == end;
+        }
+    }
+
+    inline void AppendCodePoint(std::wstring& out, char32_t cp) {
+        wchar_t buf[2];
+        out.append(buf, (size_t)(detail::PutWide(buf, cp) - buf));
+    }
+
+    /**
+     * Decodifica un code point UTF-8 en `s[i..n)` y avanza `i`.
+     */
+    inline char32_t DecodeUtf8(const unsigned char* s, size_t n, size_t& i) {
+        if (s[i] < 0x80) return s[i++];
+        char32_t cp = detail::DecodeMulti(s, n, i);
+        return cp == detail::kInvalid ? kReplacement : cp;
+    }
+
+    /**
+     * Unidades que produce `s[0..n)`, contando las sustituciones por U+FFFD.
+     * @template W - wchar_t (por defecto), char16_t o char32_t.
+     */
+    template <typename W = wchar_t>
+    inline size_t WideLength(const char* s, size_t n) {
+        const unsigned char* u = (const unsigned char*)s;
+        size_t i = 0, units = 0;
+        while (i < n) {
+            if (u[i] < 0x80) {
+                size_t run = detail::AsciiRun(u + i, n - i);
+                if (run == 0) run = 1;
+                i += run; units += run;
+                continue;
+            }
+            units += detail::WideUnits<W>(detail::DecodeMulti(u, n, i));
+        }
+        return units;
+    }
+
+    /**
+     * Inverso de WideLength: bytes de `s[0..n)` que ocupan las primeras `units` unidades.
+     * Si `units` cae en medio de un par sustituto, se queda antes del code point.
+     */
+    template <typename W = wchar_t>
+    inline size_t Utf8Offset(const char* s, size_t n, size_t units) {
+        const unsigned char* u = (const unsigned char*)s;
+        size_t i = 0;
+        while (i < n && units > 0) {
+            if (u[i] < 0x80) {
+                size_t run = detail::AsciiRun(u + i, n - i);
+                if (run == 0) run = 1;
+                if (run > units) run = units;
+                i += run; units -= run;
+                continue;
+            }
+            size_t at = i;
+            size_t need = detail::WideUnits<W>(detail::DecodeMulti(u, n, i));
+            if (need > units) return at;
+            units -= need;
+        }
+        return i;
+    }
+
+    /**
+     * Bytes UTF-8 que produce `w[0..n)`, contando las sustituciones por U+FFFD.
+     */
+    template <typename W>
+    inline size_t Utf8Length(const W* w, size_t n) {
+        size_t i = 0, bytes = 0;
+#if defined(GENESIS_UTF_SSE2)
+        // Bloques de 8 unidades sin ramas por carácter; los que tienen sustitutos o valores
+        // fuera de Unicode van code point a code point (un par puede sobrepasar el bloque)
+        while (i + 8 <= n) {
+            size_t block = detail::Utf8LengthBlock(w + i);
+            if (block != SIZE_MAX) { i += 8; bytes += block; continue; }
+            for (size_t end = i + 8; i < end;) bytes += detail::Utf8Units(detail::DecodeWide(w, n, i));
+        }
+#endif
+        while (i < n) bytes += detail::Utf8Units(detail::DecodeWide(w, n, i));
+        return bytes;
+    }
+
+    /**
+     * true si `s[0..n)` es UTF-8 bien formado (sin formas largas, sustitutos ni valores > U+10FFFF).
+     */
+    inline bool IsValidUtf8(const char* s, size_t n) {
+        const unsigned char* u = (const unsigned char*)s;
+        size_t i = 0;
+        while (i < n) {
+            if (u[i] < 0x80) { size_t run = detail::AsciiRun(u + i, n - i); i += run ? run : 1; continue; }
+            if (detail::DecodeMulti(u, n, i) == detail::kInvalid) return false;
+        }
+        return true;
+    }
+
+    /**
+     * Convierte `s[0..n)` en `dst`, que debe tener sitio para WideLength<W>(s, n) unidades.
+     * @returns {size_t} Unidades escritas.
+     */
+    template <typename W>
+    inline size_t Utf8ToWide(const char* s, size_t n, W* dst) {
+        const unsigned char* u = (const unsigned char*)s;
+        W* d = dst;
+        size_t i = 0;
+        while (i < n) {
+            if (u[i] < 0x80) {
+                size_t run = detail::AsciiRun(u + i, n - i);
+                if (run == 0) { *d++ = (W)u[i++]; continue; }
+                detail::WidenAscii(u + i, run, d);
+                i += run; d += run;
+                continue;
+            }
+            d = detail::PutWide(d, detail::DecodeMulti(u, n, i));
+        }
+        return (size_t)(d - dst);
+    }
+
+    /**
+     * Convierte `w[0..n)` en `dst`, que debe tener sitio para Utf8Length(w, n) bytes.
+     * @returns {size_t} Bytes escritos.
+     */
+    template <typename W>
+    inline size_t WideToUtf8(const W* w, size_t n, char* dst) {
+        char* d = dst;
+        size_t i = 0;
+        while (i < n) {
+            if ((uint32_t)w[i] < 0x80) {
+                size_t run = detail::WideAsciiRun(w + i, n - i);
+                if (run == 0) { *d++ = (char)w[i++]; continue; }
+                detail::NarrowAscii(w + i, run, d);
+                i += run; d += run;
+                continue;
+            }
+            d = detail::PutUtf8(d, detail::DecodeWide(w, n, i));
+        }
+        return (size_t)(d - dst);
+    }
+
+    /**
+     * Añade `s[0..n)` (UTF-8) al final de `out` sin vaciarlo. Reserva exactamente lo necesario:
+     * el tamaño sale de contar bytes (vectorial) y la conversión confirma que la entrada era
+     * válida; si no lo era, se recalcula con las sustituciones y se convierte de nuevo.
+     */
+    template <typename W>
+    inline void AppendUtf8ToWide(std::basic_string<W>& out, const char* s, size_t n) {
+        const unsigned char* u = (const unsigned char*)s;
+        size_t old = out.size(), guess = detail::CountIfValid<W>(u, n);
+        out.resize(old + guess);
+        if (detail::Utf8ToWideStrict(u, n, &out[0] + old, guess)) return;
+        out.resize(old + WideLength<W>(s, n));
+        Utf8ToWide(s, n, &out[0] + old);
+    }
+
+    /**
+     * Añade `w[0..n)` al final de `out` como UTF-8. Reserva exactamente lo necesario.
+     */
+    template <typename W>
+    inline void AppendWideToUtf8(std::string& out, const W* w, size_t n) {
+        size_t old = out.size();
+        out.resize(old + Utf8Length(w, n));
+        WideToUtf8(w, n, &out[0] + old);
+    }
+
+    inline void AppendUtf8ToWide(std::wstring& out, std::string_view s) { AppendUtf8ToWide(out, s.data(), s.size()); }
+    inline void AppendWideToUtf8(std::string& out, std::wstring_view w) { AppendWideToUtf8(out, w.data(), w.size()); }
+
+    inline std::wstring ToWide(std::string_view s) { std::wstring w; AppendUtf8ToWide(w, s.data(), s.size()); return w; }
+    inline std::string ToUtf8(std::wstring_view w) { std::string s; AppendWideToUtf8(s, w.data(), w.size()); return s; }
+
+    /**
+     * Longitud del mayor prefijo de `s[0..n)` que no corta una secuencia multibyte.
+     * Sirve para trocear UTF-8 en bloques que se puedan decodificar por separado.
+     */
+    inline size_t CompletePrefix(const char* s, size_t n) {
+        const unsigned char* u = (const unsigned char*)s;
+        size_t back = 0;
+        while (back < 4 && back < n && (u[n - 1 - back] & 0xC0) == 0x80) back++;
+        if (back == n) return n;
+        unsigned char lead = u[n - 1 - back];
+        size_t need = (lead >= 0xF0) ? 4 : (lead >= 0xE0) ? 3 : (lead >= 0xC0) ? 2 : 1;
+        return (back + 1 < need) ? n - 1 - back : n;
+    }
+}
@@ -0,0 +1,118 @@
+#pragma once
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include "AtomicFile.h"
+#include "Utf.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#include <shlobj.h>
+#endif
+
+namespace fs = std::filesystem;
+
+/**
+ * @namespace Utils
+ * @description Utilidades generales para conversión de tipos y manejo de archivos del sistema.
+ * Portable: lo que depende de la ventana (diálogos) vive en nativeWindow/Utils.h.
+ */
+namespace Utils {
+
+    /**
+     * Convierte UTF-8 a std::wstring (Wide Char).
+     * @param {std::string_view} str - La cadena a convertir.
+     * @returns {std::wstring} La cadena convertida.
+     */
+    inline std::wstring ToWString(std::string_view str) {
+        return Utf::ToWide(str);
+    }
+
+    /**
+     * Convierte Wide Char a std::string (UTF-8).
+     * @param {std::wstring_view} wstr - La cadena ancha a convertir.
+     * @returns {std::string} La cadena UTF-8.
+     */
+    inline std::string ToString(std::wstring_view wstr) {
+        return Utf::ToUtf8(wstr);
+    }
+
+    /**
+     * Añade `str` (UTF-8) al final de `out`. Para buffers que se reutilizan entre mensajes.
+     */
+    inline void AppendWString(std::wstring& out, std::string_view str) {
+        Utf::AppendUtf8ToWide(out, str.data(), str.size());
+    }
+
+    /**
+     * Añade `wstr` como UTF-8 al final de `out`.
+     */
+    inline void AppendString(std::string& out, std::wstring_view wstr) {
+        Utf::AppendWideToUtf8(out, wstr.data(), wstr.size());
+    }
+
+    /**
+     * Carpeta de datos del usuario: AppData/Roaming en Windows, ~/Library/Application Support
+     * en macOS y $XDG_DATA_HOME (o ~/.local/share) en Linux. GENESIS_APPDATA la sustituye
+     * (instalaciones portables, benchmarks).
+     * @returns {fs::path} Vacía si no se pudo resolver.
+     */
+    inline fs::path AppDataDir() {
+#ifdef _WIN32
+        wchar_t over[MAX_PATH];
+        DWORD n = GetEnvironmentVariableW(L"GENESIS_APPDATA", over, MAX_PATH);
+        if (n > 0 && n < MAX_PATH) return fs::path(over);
+        PWSTR path = NULL;
+        if (FAILED(SHGetKnownFolderPath(FOLDERID_RoamingAppData, 0, NULL, &path))) return fs::path();
+        fs::path appDataPath(path); CoTaskMemFree(path);
+        return appDataPath;
+#else
+        if (const char* over = std::getenv("GENESIS_APPDATA"); over && *over) return fs::path(over);
+        const char* home = std::getenv("HOME");
+#ifdef __APPLE__
+        return home && *home ? fs::path(home) / "Library" / "Application Support" : fs::path();
+#else
+        if (const char* xdg = std::getenv("XDG_DATA_HOME"); xdg && *xdg) return fs::path(xdg);
+        return home && *home ? fs::path(home) / ".local" / "share" : fs::path();
+#endif
+#endif
+    }
+
+    /**
+     * Ruta de un archivo dentro de la carpeta de datos de la aplicación (AppDataDir()/<appID>).
+     * @returns {fs::path} Ruta completa, vacía si no se pudo resolver la carpeta de datos.
+     */
+    inline fs::path AppDataPath(const std::wstring& appID, const std::wstring& filename) {
+        fs::path root = AppDataDir();
+        if (root.empty()) return fs::path();
+        return root / appID / filename;
+    }
+
+    /**
+     * Guarda contenido en la carpeta de datos de la aplicación (temporal + rename).
+     * @param {std::wstring} appID - ID de la aplicación (nombre de la carpeta).
+     * @param {std::wstring} filename - Nombre del archivo.
+     * @param {std::wstring} content - Contenido a guardar.
+     * @returns {bool} false si no se pudo escribir.
+     */
+    inline bool SaveToAppData(const std::wstring& appID, const std::wstring& filename, const std::wstring& content) {
+        fs::path fullPath = AppDataPath(appID, filename);
+        if (fullPath.empty()) return false;
+        std::string err;
+        return AtomicFile::Write(fullPath, ToString(content), err);
+    }
+
+    /**
+     * Carga contenido desde la carpeta de datos de la aplicación.
+     * @param {std::wstring} appID - ID de la aplicación.
+     * @param {std::wstring} filename - Nombre del archivo a leer.
+     * @returns {std::wstring} Contenido del archivo o cadena vacía si falla.
+     */
+    inline std::wstring LoadFromAppData(const std::wstring& appID, const std::wstring& filename) {
+        fs::path fullPath = AppDataPath(appID, filename);
+        std::string content;
+        if (fullPath.empty() || !AtomicFile::ReadAll(fullPath, content)) return L"";
+        return ToWString(content);
+    }
+}
@@ -0,0 +1,960 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+/**
+ * @namespace Vorbis
+ * @description Decodificador Ogg Vorbis I sin dependencias, sobre un buffer en memoria
+ * (normalmente un MappedFile). Entrega PCM float planar por paquete.
+ *
+ * Cubre lo que producen libvorbis y los codificadores actuales: floor 1, residuos 0/1/2,
+ * acoplamiento polar y ventanas de dos tamaños. El floor 0 (obsoleto desde 2000) se rechaza.
+ * No recorta muestras al principio del stream (granule inicial != 0); el final sí se ajusta
+ * al granule de la última página.
+ */
+namespace Vorbis {
+
+    namespace Detail {
+
+        constexpr double kPi = 3.14159265358979323846;
+
+        inline int ILog(uint32_t v) { int n = 0; while (v) { n++; v >>= 1; } return n; }
+
+        inline uint32_t BitReverse(uint32_t n) {
+            n = ((n & 0xAAAAAAAAu) >> 1) | ((n & 0x55555555u) << 1);
+            n = ((n & 0xCCCCCCCCu) >> 2) | ((n & 0x33333333u) << 2);
+            n = ((n & 0xF0F0F0F0u) >> 4) | ((n & 0x0F0F0F0Fu) << 4);
+            n = ((n & 0xFF00FF00u) >> 8) | ((n & 0x00FF00FFu) << 8);
+            return (n >> 16) | (n << 16);
+        }
+
+        inline float Float32Unpack(uint32_t x) {
+            double mantissa = (double)(x & 0x1FFFFF);
+            int exponent = (int)((x & 0x7FE00000u) >> 21);
+            if (x & 0x80000000u) mantissa = -mantissa;
+            return (float)std::ldexp(mantissa, exponent - 788);
+        }
+
+        /** Mayor r tal que r^dims <= entries. */
+        inline uint32_t Lookup1Values(uint32_t entries, uint32_t dims) {
+            uint32_t r = (uint32_t)std::floor(std::exp(std::log((double)entries) / dims));
+            while (std::pow((double)(r + 1), (double)dims) <= entries) r++;
+            while (r > 0 && std::pow((double)r, (double)dims) > entries) r--;
+            return r;
+        }
+
+        /**
+         * Lector de bits LSB-first de un paquete. Leer más allá del final activa `eop`
+         * y devuelve ceros, que es lo que pide la especificación.
+         */
+        struct BitReader {
+            const uint8_t* p = nullptr;
+            size_t size = 0, pos = 0;
+            uint64_t acc = 0;
+            int bits = 0;
+            bool eop = false;
+
+            BitReader(const uint8_t* data, size_t len) : p(data), size(len) {}
+
+            void Fill() {
+                while (bits <= 56 && pos < size) { acc |= (uint64_t)p[pos++] << bits; bits += 8; }
+            }
+
+            uint32_t Read(int n) {
+                if (n == 0) return 0;
+                if (bits < n) Fill();
+                if (bits < n) { eop = true; acc = 0; bits = 0; return 0; }
+                uint32_t v = (uint32_t)(acc & ((n == 32) ? 0xFFFFFFFFull : ((1ull << n) - 1)));
+                acc >>= n;
+                bits -= n;
+                return v;
+            }
+
+            bool Flag() { return Read(1) != 0; }
+
+            void Skip(int n) { acc >>= n; bits -= n; }
+        };
+
+        // 10^(-140 dB / 20) ... 1.0 en 256 pasos (tabla floor1_inverse_dB_table de la especificación)
+        inline const float* InverseDbTable() {
+            static const float* table = [] {
+                static float t[256];
+                for (int i = 0; i < 256; i++) t[i] = (float)std::exp(std::log(1.0649863e-07) * (255 - i) / 255.0);
+                return t;
+            }();
+            return table;
+        }
+    }
+
+    /**
+     * @struct Codebook
+     * @description Libro de códigos: Huffman (tabla rápida de 10 bits + búsqueda binaria para
+     * códigos largos) y, si tiene, la tabla VQ ya expandida a floats (entries x dimensions).
+     */
+    struct Codebook {
+        static constexpr int kFastBits = 10;
+
+        uint32_t dimensions = 0, entries = 0;
+        std::vector<uint8_t> lengths;        // 0 = entrada sin usar
+        std::vector<uint32_t> sortedCodes;   // Códigos alineados a la izquierda (MSB primero), ordenados
+        std::vector<uint32_t> sortedEntries;
+        std::vector<uint8_t> sortedLengths;
+        std::vector<int16_t> fast;           // Índice en sorted* por los kFastBits siguientes bits, -1 = largo
+        int singleEntry = -1;                // Libro con una sola entrada usada: se consume su longitud sin mirar
+        std::vector<float> vq;
+
+        bool Parse(Detail::BitReader& br, std::string& err) {
+            if (br.Read(24) != 0x564342) { err = "bad codebook sync"; return false; }
+            dimensions = br.Read(16);
+            entries = br.Read(24);
+            if (entries == 0 || entries > (1u << 20)) { err = "bad codebook size"; return false; }
+            lengths.assign(entries, 0);
+            if (!br.Flag()) {
+                bool sparse = br.Flag();
+                for (uint32_t i = 0; i < entries; i++) {
+                    if (!sparse || br.Flag()) lengths[i] = (uint8_t)(br.Read(5) + 1);
+                }
+            } else {
+                uint32_t current = 0;
+                int length = (int)br.Read(5) + 1;
+                while (current < entries) {
+                    uint32_t number = br.Read(Detail::ILog(entries - current));
+                    if (current + number > entries || length > 32) { err = "bad ordered codebook"; return false; }
+                    for (uint32_t i = 0; i < number; i++) lengths[current + i] = (uint8_t)length;
+                    current += number;
+                    length++;
+                }
+            }
+            uint32_t lookupType = br.Read(4);
+            if (lookupType == 1 || lookupType == 2) {
+                float minimum = Detail::Float32Unpack(br.Read(32));
+                float delta = Detail::Float32Unpack(br.Read(32));
+                int valueBits = (int)br.Read(4) + 1;
+                bool sequence = br.Flag();
+                uint32_t lookupValues = lookupType == 1 ? Detail::Lookup1Values(entries, dimensions) : entries * dimensions;
+                std::vector<uint32_t> mult(lookupValues);
+                for (auto& m : mult) m = br.Read(valueBits);
+                if (br.eop) { err = "truncated codebook"; return false; }
+                vq.assign((size_t)entries * dimensions, 0.0f);
+                for (uint32_t e = 0; e < entries; e++) {
+                    float last = 0;
+                    uint32_t divisor = 1;
+                    for (uint32_t d = 0; d < dimensions; d++) {
+                        uint32_t off = lookupType == 1 ? (e / divisor) % lookupValues : e * dimensions + d;
+                        float v = mult[off] * delta + minimum + last;
+                        vq[(size_t)e * dimensions + d] = v;
+                        if (sequence) last = v;
+                        if (lookupType == 1) divisor *= lookupValues;
+                    }
+                }
+            } else if (lookupType != 0) { err = "bad lookup type"; return false; }
+            if (br.eop) { err = "truncated codebook"; return false; }
+            return BuildHuffman(err);
+        }
+
+        /**
+         * Decodifica una entrada. @returns {int} -1 si se acabó el paquete o el código no existe.
+         */
+        int Decode(Detail::BitReader& br) const {
+            if (br.bits < 32) br.Fill();
+            if (singleEntry >= 0) {
+                int len = lengths[singleEntry];
+                if (br.bits < len) { br.eop = true; return -1; }
+                br.Skip(len);
+                return singleEntry;
+            }
+            int idx = fast.empty() ? -1 : fast[br.acc & ((1u << kFastBits) - 1)];
+            if (idx < 0) {
+                uint32_t code = Detail::BitReverse((uint32_t)br.acc);
+                size_t lo = 0, hi = sortedCodes.size();
+                while (hi - lo > 1) {
+                    size_t mid = (lo + hi) / 2;
+                    if (sortedCodes[mid] <= code) lo = mid; else hi = mid;
+                }
+                if (sortedCodes.empty()) return -1;
+                int len = sortedLengths[lo];
+                uint32_t mask = len == 32 ? 0xFFFFFFFFu : ~(0xFFFFFFFFu >> len);
+                if ((code & mask) != sortedCodes[lo]) { br.eop = true; return -1; }
+                idx = (int)lo;
+            }
+            int len = sortedLengths[idx];
+            if (br.bits < len) { br.eop = true; br.bits = 0; br.acc = 0; return -1; }
+            br.Skip(len);
+            return (int)sortedEntries[idx];
+        }
+
+        const float* Vector(int entry) const { return vq.data() + (size_t)entry * dimensions; }
+
+    private:
+        bool BuildHuffman(std::string& err) {
+            std::vector<uint32_t> codes(entries, 0);
+            uint32_t used = 0, first = UINT32_MAX;
+            for (uint32_t i = 0; i < entries; i++) if (lengths[i]) { used++; if (first == UINT32_MAX) first = i; }
+            if (used == 0) return true;
+            if (used == 1) { singleEntry = (int)first; return true; }
+
+            // Asignación de la especificación: cada entrada toma el código libre más bajo de su longitud
+            uint32_t available[33] = {};
+            for (int i = 1; i <= lengths[first]; i++) available[i] = 1u << (32 - i);
+            codes[first] = 0;
+            for (uint32_t i = first + 1; i < entries; i++) {
+                int len = lengths[i];
+                if (!len) continue;
+                int z = len;
+                while (z > 0 && !available[z]) z--;
+                if (z == 0) { err = "overspecified huffman tree"; return false; }
+                uint32_t res = available[z];
+                available[z] = 0;
+                codes[i] = res;
+                for (int y = len; y > z; y--) available[y] = res + (1u << (32 - y));
+            }
+
+            std::vector<uint32_t> order;
+            order.reserve(used);
+            for (uint32_t i = 0; i < entries; i++) if (lengths[i]) order.push_back(i);
+            std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return codes[a] < codes[b]; });
+            for (uint32_t e : order) {
+                sortedCodes.push_back(codes[e]);
+                sortedEntries.push_back(e);
+                sortedLengths.push_back(lengths[e]);
+            }
+            fast.assign(1u << kFastBits, -1);
+            for (size_t i = 0; i < sortedCodes.size(); i++) {
+                int len = sortedLengths[i];
+                if (len > kFastBits) continue;
+                uint32_t rev = Detail::BitReverse(sortedCodes[i]); // Código en los `len` bits bajos, LSB primero
+                for (uint32_t k = rev; k < (1u << kFastBits); k += 1u << len) fast[k] = (int16_t)i;
+            }
+            return true;
+        }
+    };
+
+    struct Floor1 {
+        std::vector<uint8_t> partitionClass;
+        uint8_t classDim[16] = {}, classSub[16] = {};
+        int16_t classMaster[16] = {};
+        int16_t subBooks[16][8] = {};
+        int multiplier = 1;
+        std::vector<int> x;                 // Posiciones (las dos primeras: 0 y 2^rangebits)
+        std::vector<int> order;             // Índices de x ordenados por posición
+        std::vector<int> low, high;         // Vecinos para la predicción
+    };
+
+    struct Residue {
+        int type = 0;
+        uint32_t begin = 0, end = 0, partitionSize = 1;
+        int classifications = 1;
+        int classbook = 0;
+        std::vector<std::array<int16_t, 8>> books;
+    };
+
+    struct Mapping {
+        std::vector<std::pair<int, int>> coupling; // (magnitud, ángulo)
+        std::vector<uint8_t> mux;
+        std::vector<int> submapFloor, submapResidue;
+    };
+
+    struct Mode {
+        bool blockFlag = false;
+        int mapping = 0;
+    };
+
+    /**
+     * IMDCT de tamaño n (n/2 coeficientes -> n muestras) vía DCT-IV sobre una FFT compleja de n/4.
+     */
+    class Imdct {
+    public:
+        void Init(int size) {
+            n = size;
+            int m = n / 2, p = n / 4;
+            twiddleRe.resize(p); twiddleIm.resize(p);
+            for (int k = 0; k < p; k++) {
+                double a = -Detail::kPi * (k + 0.125) / m;
+                twiddleRe[k] = (float)std::cos(a); twiddleIm[k] = (float)std::sin(a);
+            }
+            fftRe.resize(p / 2); fftIm.resize(p / 2);
+            for (int k = 0; k < p / 2; k++) {
+                double a = -2.0 * Detail::kPi * k / p;
+                fftRe[k] = (float)std::cos(a); fftIm[k] = (float)std::sin(a);
+            }
+            bitrev.resize(p);
+            int bits = Detail::ILog((uint32_t)p) - 1;
+            for (int k = 0; k < p; k++) bitrev[k] = (int)(Detail::BitReverse((uint32_t)k) >> (32 - bits));
+            re.resize(p); im.resize(p); u.resize(m);
+        }
+
+        int Size() const { return n; }
+
+        /** `in`: n/2 coeficientes. `out`: n muestras. */
+        void Run(const float* in, float* out) {
+            int m = n / 2, p = n / 4;
+            for (int k = 0; k < p; k++) {
+                float a = in[2 * k], b = in[m - 1 - 2 * k];
+                int j = bitrev[k];
+                re[j] = a * twiddleRe[k] - b * twiddleIm[k];
+                im[j] = a * twiddleIm[k] + b * twiddleRe[k];
+            }
+            for (int len = 2; len <= p; len <<= 1) {
+                int half = len >> 1, step = p / len;
+                for (int s = 0; s < p; s += len) {
+                    for (int k = 0; k < half; k++) {
+                        float wr = fftRe[k * step], wi = fftIm[k * step];
+                        int a = s + k, b = a + half;
+                        float tr = re[b] * wr - im[b] * wi;
+                        float ti = re[b] * wi + im[b] * wr;
+                        re[b] = re[a] - tr; im[b] = im[a] - ti;
+                        re[a] += tr; im[a] += ti;
+                    }
+                }
+            }
+            for (int j = 0; j < p; j++) {
+                float yr = re[j] * twiddleRe[j] - im[j] * twiddleIm[j];
+                float yi = re[j] * twiddleIm[j] + im[j] * twiddleRe[j];
+                u[2 * j] = yr;
+                u[m - 1 - 2 * j] = -yi;
+            }
+            // Despliegue DCT-IV -> IMDCT (simetrías de la base coseno)
+            int h = m / 2;
+            for (int i = 0; i < h; i++) out[i] = u[i + h];
+            for (int i = h; i < 3 * h; i++) out[i] = -u[3 * h - 1 - i];
+            for (int i = 3 * h; i < 2 * m; i++) out[i] = -u[i - 3 * h];
+        }
+
+    private:
+        int n = 0;
+        std::vector<float> twiddleRe, twiddleIm, fftRe, fftIm, re, im, u;
+        std::vector<int> bitrev;
+    };
+
+    /**
+     * Paquetes de un stream lógico dentro de un Ogg en memoria. Los paquetes que caben en una
+     * página se devuelven sin copiar; los que cruzan páginas se juntan en un buffer.
+     */
+    class OggReader {
+    public:
+        struct Packet {
+            const uint8_t* data = nullptr;
+            size_t size = 0;
+            int64_t granule = -1; // Granule de la página si es el último paquete que termina en ella
+        };
+
+        void Open(const uint8_t* bytes, size_t length) { data = bytes; size = length; pos = 0; segIndex = segCount = 0; serial = 0; locked = false; }
+
+        uint32_t Serial() const { return serial; }
+
+        bool Next(Packet& pkt) {
+            scratch.clear();
+            bool continued = false;
+            while (true) {
+                if (segIndex >= segCount) {
+                    bool fresh = continued;
+                    if (!LoadPage()) return false;
+                    // Continuación de un paquete que no vimos empezar: se descarta
+                    if ((pageFlags & 1) && !fresh) SkipContinuation();
+                    if (segIndex >= segCount) continue;
+                }
+                size_t len = 0;
+                bool complete = false;
+                while (segIndex < segCount) {
+                    uint8_t lace = lacing[segIndex++];
+                    len += lace;
+                    if (lace < 255) { complete = true; break; }
+                }
+                const uint8_t* start = body + bodyPos;
+                bodyPos += len;
+                if (complete) {
+                    pkt.granule = -1;
+                    bool lastOnPage = true;
+                    for (size_t i = segIndex; i < segCount; i++) if (lacing[i] < 255) { lastOnPage = false; break; }
+                    if (lastOnPage) pkt.granule = pageGranule;
+                    if (!continued) { pkt.data = start; pkt.size = len; return true; }
+                    scratch.insert(scratch.end(), start, start + len);
+                    pkt.data = scratch.data(); pkt.size = scratch.size();
+                    return true;
+                }
+                scratch.insert(scratch.end(), start, start + len);
+                continued = true;
+            }
+        }
+
+        /**
+         * Granule de la última página del stream (= muestras totales). -1 si no se encuentra.
+         */
+        int64_t LastGranule() const {
+            if (size < 27) return -1;
+            for (size_t i = size - 27 + 1; i-- > 0; ) {
+                if (std::memcmp(data + i, "OggS", 4) != 0 || data[i + 4] != 0) continue;
+                if (Get32(data + i + 14) != serial) continue;
+                int64_t g = (int64_t)Get64(data + i + 6);
+                if (g != -1) return g;
+            }
+            return -1;
+        }
+
+    private:
+        const uint8_t* data = nullptr;
+        size_t size = 0, pos = 0;
+        const uint8_t* lacing = nullptr;
+        const uint8_t* body = nullptr;
+        size_t segCount = 0, segIndex = 0, bodyPos = 0;
+        int64_t pageGranule = -1;
+        uint8_t pageFlags = 0;
+        uint32_t serial = 0;
+        bool locked = false;
+        std::vector<uint8_t> scratch;
+
+        static uint32_t Get32(const uint8_t* p) { return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24); }
+        static uint64_t Get64(const uint8_t* p) { return (uint64_t)Get32(p) | ((uint64_t)Get32(p + 4) << 32); }
+
+        bool LoadPage() {
+            while (pos + 27 <= size) {
+                const uint8_t* h = data + pos;
+                if (std::memcmp(h, "OggS", 4) != 0 || h[4] != 0) { pos++; continue; } // Resincroniza
+                size_t nseg = h[26];
+                if (pos + 27 + nseg > size) return false;
+                size_t bodyLen = 0;
+                for (size_t i = 0; i < nseg; i++) bodyLen += h[27 + i];
+                if (pos + 27 + nseg + bodyLen > size) return false;
+                uint32_t s = Get32(h + 14);
+                size_t next = pos + 27 + nseg + bodyLen;
+                if (!locked) { serial = s; locked = true; }
+                if (s != serial) { pos = next; continue; }
+                pageFlags = h[5];
+                pageGranule = (int64_t)Get64(h + 6);
+                lacing = h + 27;
+                body = h + 27 + nseg;
+                segCount = nseg; segIndex = 0; bodyPos = 0;
+                pos = next;
+                return true;
+            }
+            return false;
+        }
+
+        void SkipContinuation() {
+            while (segIndex < segCount) {
+                uint8_t lace = lacing[segIndex++];
+                bodyPos += lace;
+                if (lace < 255) break;
+            }
+        }
+    };
+
+    /** Lo que dice la cabecera de identificación, más la duración según el granule final. */
+    struct Info {
+        int channels = 0;
+        uint32_t rate = 0;
+        int64_t frames = -1;
+
+        double Seconds() const { return rate && frames > 0 ? (double)frames / rate : 0.0; }
+    };
+
+    /**
+     * Lee canales, frecuencia y duración sin cargar el setup ni decodificar: solo toca la
+     * primera página y las últimas (con un MappedFile, el resto ni se lee del disco).
+     */
+    inline bool ReadInfo(const void* bytes, size_t length, Info& info, std::string* err = nullptr) {
+        OggReader ogg;
+        OggReader::Packet pkt;
+        ogg.Open((const uint8_t*)bytes, length);
+        if (!ogg.Next(pkt) || pkt.size < 30 || pkt.data[0] != 1 || std::memcmp(pkt.data + 1, "vorbis", 6) != 0) {
+            if (err) *err = "not a vorbis stream";
+            return false;
+        }
+        const uint8_t* p = pkt.data;
+        info.channels = p[11];
+        info.rate = (uint32_t)p[12] | ((uint32_t)p[13] << 8) | ((uint32_t)p[14] << 16) | ((uint32_t)p[15] << 24);
+        if (info.channels == 0 || info.rate == 0) { if (err) *err = "bad identification header"; return false; }
+        info.frames = ogg.LastGranule();
+        return true;
+    }
+
+    /**
+     * @class Decoder
+     * @description Decodifica un Ogg Vorbis completo en memoria. El buffer tiene que seguir vivo
+     * mientras se use el decodificador.
+     */
+    class Decoder {
+    public:
+        /**
+         * Lee las tres cabeceras.
+         * @returns {bool} false si no es Vorbis I o usa algo no soportado (ver `err`).
+         */
+        bool Open(const void* bytes, size_t length, std::string* err = nullptr) {
+            std::string e;
+            ogg.Open((const uint8_t*)bytes, length);
+            bool ok = ReadHeaders(e);
+            if (!ok && err) *err = e;
+            if (ok) totalFrames = ogg.LastGranule();
+            return ok;
+        }
+
+        int Channels() const { return channels; }
+        uint32_t SampleRate() const { return rate; }
+
+        /** Muestras por canal según el granule final. -1 si el archivo no lo indica. */
+        int64_t Frames() const { return totalFrames; }
+
+        double Seconds() const { return rate && totalFrames > 0 ? (double)totalFrames / rate : 0.0; }
+
+        /**
+         * Decodifica todo el audio. `onPcm(const float* const* canales, size_t muestras)` recibe
+         * cada tramo; los punteros solo son válidos durante la llamada.
+         * @returns {uint64_t} Muestras por canal entregadas.
+         */
+        template <typename Fn>
+        uint64_t Decode(Fn&& onPcm) {
+            uint64_t produced = 0;
+            OggReader::Packet pkt;
+            bool havePrev = false;
+            int prevN = 0;
+            std::vector<const float*> ptrs(channels);
+            while (ogg.Next(pkt)) {
+                int n;
+                if (!DecodePacket(pkt.data, pkt.size, n)) continue;
+                if (havePrev) {
+                    int count = prevN / 4 + n / 4;
+                    int shift = n / 4 - prevN / 4; // Índice en el bloque actual = j + shift
+                    for (int c = 0; c < channels; c++) {
+                        float* o = out[c].data();
+                        const float* cur = pcm[c].data();
+                        const float* prev = overlap[c].data(); // Mitad derecha del bloque anterior
+                        for (int j = 0; j < count; j++) {
+                            int idx = j + shift;
+                            float v = j < prevN / 2 ? prev[j] : 0.0f;
+                            if (idx >= 0) v += cur[idx];
+                            o[j] = v;
+                        }
+                        ptrs[c] = o;
+                    }
+                    uint64_t deliver = (uint64_t)count;
+                    if (totalFrames >= 0 && produced + deliver > (uint64_t)totalFrames) deliver = (uint64_t)totalFrames > produced ? (uint64_t)totalFrames - produced : 0;
+                    if (deliver) onPcm((const float* const*)ptrs.data(), (size_t)deliver);
+                    produced += deliver;
+                }
+                for (int c = 0; c < channels; c++) std::memcpy(overlap[c].data(), pcm[c].data() + n / 2, sizeof(float) * (n / 2));
+                prevN = n;
+                havePrev = true;
+            }
+            return produced;
+        }
+
+    private:
+        OggReader ogg;
+        int channels = 0;
+        uint32_t rate = 0;
+        int blocksize[2] = {};
+        int64_t totalFrames = -1;
+        std::vector<Codebook> books;
+        std::vector<Floor1> floors;
+        std::vector<Residue> residues;
+        std::vector<Mapping> mappings;
+        std::vector<Mode> modes;
+        Imdct mdct[2];
+        std::vector<float> slope[2];              // Subida de la ventana para cada tamaño (n/2 muestras)
+        std::vector<std::vector<float>> pcm, overlap, out, residue;
+        std::vector<std::vector<int>> floorY;
+        std::vector<float> interleaved;
+        std::vector<int> curve;
+        std::vector<std::vector<uint8_t>> classes;
+
+        bool ReadHeaders(std::string& err) {
+            OggReader::Packet pkt;
+            // Identificación
+            if (!ogg.Next(pkt) || pkt.size < 30 || pkt.data[0] != 1 || std::memcmp(pkt.data + 1, "vorbis", 6) != 0) { err = "not a vorbis stream"; return false; }
+            {
+                Detail::BitReader br(pkt.data + 7, pkt.size - 7);
+                if (br.Read(32) != 0) { err = "unsupported vorbis version"; return false; }
+                channels = (int)br.Read(8);
+                rate = br.Read(32);
+                br.Read(32); br.Read(32); br.Read(32);
+                blocksize[0] = 1 << br.Read(4);
+                blocksize[1] = 1 << br.Read(4);
+                if (!br.Flag() || channels == 0 || rate == 0 || blocksize[0] < 64 || blocksize[1] < blocksize[0] || blocksize[1] > 8192) {
+                    err = "bad identification header"; return false;
+                }
+            }
+            // Comentarios: no se usan
+            if (!ogg.Next(pkt) || pkt.size < 7 || pkt.data[0] != 3) { err = "missing comment header"; return false; }
+            if (!ogg.Next(pkt) || pkt.size < 7 || pkt.data[0] != 5 || std::memcmp(pkt.data + 1, "vorbis", 6) != 0) { err = "missing setup header"; return false; }
+            Detail::BitReader br(pkt.data + 7, pkt.size - 7);
+            if (!ReadSetup(br, err)) return false;
+
+            for (int i = 0; i < 2; i++) {
+                mdct[i].Init(blocksize[i]);
+                int half = blocksize[i] / 2;
+                slope[i].resize(half);
+                for (int k = 0; k < half; k++) {
+                    double s = std::sin((k + 0.5) / half * Detail::kPi / 2);
+                    slope[i][k] = (float)std::sin(Detail::kPi / 2 * s * s);
+                }
+            }
+            pcm.assign(channels, std::vector<float>(blocksize[1]));
+            overlap.assign(channels, std::vector<float>(blocksize[1] / 2));
+            out.assign(channels, std::vector<float>(blocksize[1] / 2));
+            residue.assign(channels, std::vector<float>(blocksize[1] / 2));
+            floorY.assign(channels, std::vector<int>());
+            curve.resize(blocksize[1] / 2);
+            classes.assign(channels, std::vector<uint8_t>());
+            return true;
+        }
+
+        bool ReadSetup(Detail::BitReader& br, std::string& err) {
+            books.resize(br.Read(8) + 1);
+            for (auto& b : books) if (!b.Parse(br, err)) return false;
+
+            int timeCount = (int)br.Read(6) + 1;
+            for (int i = 0; i < timeCount; i++) if (br.Read(16) != 0) { err = "bad time domain transform"; return false; }
+
+            floors.resize(br.Read(6) + 1);
+            for (auto& f : floors) {
+                if (br.Read(16) != 1) { err = "floor type 0 not supported"; return false; }
+                f.partitionClass.resize(br.Read(5));
+                int maxClass = -1;
+                for (auto& c : f.partitionClass) { c = (uint8_t)br.Read(4); maxClass = std::max(maxClass, (int)c); }
+                for (int c = 0; c <= maxClass; c++) {
+                    f.classDim[c] = (uint8_t)(br.Read(3) + 1);
+                    f.classSub[c] = (uint8_t)br.Read(2);
+                    f.classMaster[c] = f.classSub[c] ? (int16_t)br.Read(8) : (int16_t)-1;
+                    for (int s = 0; s < (1 << f.classSub[c]); s++) f.subBooks[c][s] = (int16_t)((int)br.Read(8) - 1);
+                }
+                f.multiplier = (int)br.Read(2) + 1;
+                int rangeBits = (int)br.Read(4);
+                f.x = { 0, 1 << rangeBits };
+                for (auto c : f.partitionClass) {
+                    for (int d = 0; d < f.classDim[c]; d++) f.x.push_back((int)br.Read(rangeBits));
+                }
+                if (f.x.size() > 65) { err = "too many floor points"; return false; }
+                for (int c = 0; c <= maxClass; c++) {
+                    if (f.classMaster[c] >= (int)books.size()) { err = "bad floor book"; return false; }
+                    for (int s = 0; s < (1 << f.classSub[c]); s++) if (f.subBooks[c][s] >= (int)books.size()) { err = "bad floor book"; return false; }
+                }
+                size_t values = f.x.size();
+                f.order.resize(values);
+                for (size_t i = 0; i < values; i++) f.order[i] = (int)i;
+                std::stable_sort(f.order.begin(), f.order.end(), [&](int a, int b) { return f.x[a] < f.x[b]; });
+                f.low.assign(values, 0); f.high.assign(values, 1);
+                for (size_t i = 2; i < values; i++) {
+                    int lo = -1, hi = -1;
+                    for (size_t j = 0; j < i; j++) {
+                        if (f.x[j] < f.x[i] && (lo < 0 || f.x[j] > f.x[lo])) lo = (int)j;
+                        if (f.x[j] > f.x[i] && (hi < 0 || f.x[j] < f.x[hi])) hi = (int)j;
+                    }
+                    if (lo < 0 || hi < 0) { err = "bad floor points"; return false; }
+                    f.low[i] = lo; f.high[i] = hi;
+                }
+            }
+
+            residues.resize(br.Read(6) + 1);
+            for (auto& r : residues) {
+                r.type = (int)br.Read(16);
+                if (r.type > 2) { err = "bad residue type"; return false; }
+                r.begin = br.Read(24);
+                r.end = br.Read(24);
+                r.partitionSize = br.Read(24) + 1;
+                r.classifications = (int)br.Read(6) + 1;
+                r.classbook = (int)br.Read(8);
+                if (r.classbook >= (int)books.size()) { err = "bad residue classbook"; return false; }
+                std::vector<int> cascade(r.classifications);
+                for (auto& c : cascade) {
+                    int low = (int)br.Read(3);
+                    int high = br.Flag() ? (int)br.Read(5) : 0;
+                    c = high * 8 + low;
+                }
+                r.books.resize(r.classifications);
+                for (int c = 0; c < r.classifications; c++) {
+                    for (int pass = 0; pass < 8; pass++) {
+                        int16_t b = -1;
+                        if (cascade[c] & (1 << pass)) {
+                            b = (int16_t)br.Read(8);
+                            if (b >= (int)books.size() || books[b].vq.empty()) { err = "bad residue book"; return false; }
+                        }
+                        r.books[c][pass] = b;
+                    }
+                }
+            }
+
+            mappings.resize(br.Read(6) + 1);
+            for (auto& m : mappings) {
+                if (br.Read(16) != 0) { err = "bad mapping type"; return false; }
+                int submaps = br.Flag() ? (int)br.Read(4) + 1 : 1;
+                if (br.Flag()) {
+                    int steps = (int)br.Read(8) + 1;
+                    int bits = Detail::ILog((uint32_t)channels - 1);
+                    for (int s = 0; s < steps; s++) {
+                        int mag = (int)br.Read(bits), ang = (int)br.Read(bits);
+                        if (mag == ang || mag >= channels || ang >= channels) { err = "bad coupling"; return false; }
+                        m.coupling.push_back({ mag, ang });
+                    }
+                }
+                if (br.Read(2) != 0) { err = "bad mapping reserved bits"; return false; }
+                m.mux.assign(channels, 0);
+                if (submaps > 1) for (auto& x : m.mux) { x = (uint8_t)br.Read(4); if (x >= submaps) { err = "bad mapping mux"; return false; } }
+                m.submapFloor.resize(submaps); m.submapResidue.resize(submaps);
+                for (int s = 0; s < submaps; s++) {
+                    br.Read(8);
+                    m.submapFloor[s] = (int)br.Read(8);
+                    m.submapResidue[s] = (int)br.Read(8);
+                    if (m.submapFloor[s] >= (int)floors.size() || m.submapResidue[s] >= (int)residues.size()) { err = "bad submap"; return false; }
+                }
+            }
+
+            modes.resize(br.Read(6) + 1);
+            for (auto& md : modes) {
+                md.blockFlag = br.Flag();
+                if (br.Read(16) != 0 || br.Read(16) != 0) { err = "bad mode"; return false; }
+                md.mapping = (int)br.Read(8);
+                if (md.mapping >= (int)mappings.size()) { err = "bad mode mapping"; return false; }
+            }
+            if (!br.Flag() || br.eop) { err = "bad setup framing"; return false; }
+            return true;
+        }
+
+        // --- Floor 1 ---
+
+        bool DecodeFloor(const Floor1& f, Detail::BitReader& br, std::vector<int>& y) {
+            if (!br.Flag()) return false;
+            static const int kRanges[4] = { 256, 128, 86, 64 };
+            int range = kRanges[f.multiplier - 1];
+            int bits = Detail::ILog((uint32_t)range - 1);
+            y.assign(f.x.size(), 0);
+            y[0] = (int)br.Read(bits);
+            y[1] = (int)br.Read(bits);
+            size_t offset = 2;
+            for (auto c : f.partitionClass) {
+                int cdim = f.classDim[c], cbits = f.classSub[c], csub = (1 << cbits) - 1;
+                int cval = 0;
+                if (cbits) cval = books[f.classMaster[c]].Decode(br);
+                for (int j = 0; j < cdim; j++) {
+                    int book = f.subBooks[c][cval & csub];
+                    cval >>= cbits;
+                    y[offset + j] = book >= 0 ? std::max(0, books[book].Decode(br)) : 0;
+                }
+                offset += cdim;
+            }
+            return !br.eop;
+        }
+
+        static int RenderPoint(int x0, int y0, int x1, int y1, int x) {
+            int dy = y1 - y0, adx = x1 - x0;
+            int off = std::abs(dy) * (x - x0) / adx;
+            return dy < 0 ? y0 - off : y0 + off;
+        }
+
+        static void RenderLine(int x0, int y0, int x1, int y1, int* v, int n) {
+            int dy = y1 - y0, adx = x1 - x0, ady = std::abs(dy);
+            int base = dy / adx;
+            int sy = dy < 0 ? base - 1 : base + 1;
+            int x = x0, y = y0, err = 0;
+            ady -= std::abs(base) * adx;
+            if (x1 > n) x1 = n;
+            if (x < x1) v[x] = y;
+            for (x = x0 + 1; x < x1; x++) {
+                err += ady;
+                if (err >= adx) { err -= adx; y += sy; } else y += base;
+                v[x] = y;
+            }
+        }
+
+        void SynthesizeFloor(const Floor1& f, std::vector<int>& y, float* vec, int half) {
+            static const int kRanges[4] = { 256, 128, 86, 64 };
+            int range = kRanges[f.multiplier - 1];
+            size_t values = f.x.size();
+            bool step2[65];
+            step2[0] = step2[1] = true;
+            for (size_t i = 2; i < values; i++) {
+                int lo = f.low[i], hi = f.high[i];
+                int predicted = RenderPoint(f.x[lo], y[lo], f.x[hi], y[hi], f.x[i]);
+                int val = y[i];
+                int highroom = range - predicted, lowroom = predicted;
+                int room = (highroom < lowroom ? highroom : lowroom) * 2;
+                if (val) {
+                    step2[lo] = step2[hi] = step2[i] = true;
+                    if (val >= room) y[i] = highroom > lowroom ? val - lowroom + predicted : predicted - val + highroom - 1;
+                    else y[i] = (val & 1) ? predicted - (val + 1) / 2 : predicted + val / 2;
+                } else {
+                    step2[i] = false;
+                    y[i] = predicted;
+                }
+                y[i] = std::min(std::max(y[i], 0), range - 1);
+            }
+            int* c = curve.data();
+            int lx = 0, ly = y[f.order[0]] * f.multiplier, hx = 0, hy = ly;
+            for (size_t k = 1; k < values; k++) {
+                int i = f.order[k];
+                if (!step2[i]) continue;
+                hy = y[i] * f.multiplier;
+                hx = f.x[i];
+                if (hx > lx) RenderLine(lx, ly, hx, hy, c, half);
+                lx = hx; ly = hy;
+            }
+            for (int i = std::max(lx, 0); i < half; i++) c[i] = ly;
+            const float* db = Detail::InverseDbTable();
+            for (int i = 0; i < half; i++) vec[i] *= db[std::min(std::max(c[i], 0), 255)];
+        }
+
+        // --- Residuo ---
+
+        void DecodeResidue(const Residue& r, Detail::BitReader& br, int half, const std::vector<int>& chans, const bool* skip) {
+            int nch = (int)chans.size();
+            uint32_t actual = r.type == 2 ? (uint32_t)(half * nch) : (uint32_t)half;
+            uint32_t begin = std::min(r.begin, actual), end = std::min(r.end, actual);
+            if (end <= begin) return;
+            uint32_t psize = r.partitionSize;
+            int toRead = (int)((end - begin) / psize);
+            const Codebook& cb = books[r.classbook];
+            int perWord = (int)cb.dimensions;
+            if (perWord == 0 || toRead == 0) return;
+
+            // Tipo 2: un solo vector entrelazado con todos los canales del submapa
+            std::vector<float*> vecs;
+            int vecCount;
+            bool anyDecode = false;
+            for (int j = 0; j < nch; j++) anyDecode = anyDecode || !skip[j];
+            if (!anyDecode) return;
+            if (r.type == 2) {
+                interleaved.assign((size_t)half * nch, 0.0f);
+                vecs.push_back(interleaved.data());
+                vecCount = 1;
+            } else {
+                for (int j = 0; j < nch; j++) vecs.push_back(residue[chans[j]].data());
+                vecCount = nch;
+            }
+            for (int v = 0; v < vecCount; v++) classes[v].assign((size_t)toRead + perWord, 0);
+
+            for (int pass = 0; pass < 8; pass++) {
+                int p = 0;
+                while (p < toRead) {
+                    if (pass == 0) {
+                        for (int v = 0; v < vecCount; v++) {
+                            if (r.type != 2 && skip[v]) continue;
+                            int temp = cb.Decode(br);
+                            if (temp < 0) goto done;
+                            for (int i = perWord - 1; i >= 0; i--) {
+                                classes[v][p + i] = (uint8_t)(temp % r.classifications);
+                                temp /= r.classifications;
+                            }
+                        }
+                    }
+                    for (int i = 0; i < perWord && p < toRead; i++, p++) {
+                        for (int v = 0; v < vecCount; v++) {
+                            if (r.type != 2 && skip[v]) continue;
+                            int book = r.books[classes[v][p]][pass];
+                            if (book < 0) continue;
+                            const Codebook& b = books[book];
+                            float* out = vecs[v] + begin + (size_t)p * psize;
+                            int dims = (int)b.dimensions;
+                            if (r.type == 0) {
+                                int step = (int)psize / dims;
+                                for (int s = 0; s < step; s++) {
+                                    int e = b.Decode(br);
+                                    if (e < 0) goto done;
+                                    const float* vq = b.Vector(e);
+                                    for (int d = 0; d < dims; d++) out[s + d * step] += vq[d];
+                                }
+                            } else {
+                                for (uint32_t s = 0; s < psize; ) {
+                                    int e = b.Decode(br);
+                                    if (e < 0) goto done;
+                                    const float* vq = b.Vector(e);
+                                    for (int d = 0; d < dims && s < psize; d++, s++) out[s] += vq[d];
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        done:
+            if (r.type == 2) {
+                for (int j = 0; j < nch; j++) {
+                    float* dst = residue[chans[j]].data();
+                    for (int i = 0; i < half; i++) dst[i] = interleaved[(size_t)i * nch + j];
+                }
+            }
+        }
+
+        // --- Paquete de audio ---
+
+        /**
+         * Decodifica un paquete en pcm[] (ventana ya aplicada, n muestras por canal).
+         * @param {int&} n - Tamaño de bloque del paquete.
+         */
+        bool DecodePacket(const uint8_t* data, size_t size, int& n) {
+            if (size == 0 || (data[0] & 1)) return false;
+            Detail::BitReader br(data, size);
+            br.Read(1);
+            int modeIndex = (int)br.Read(Detail::ILog((uint32_t)modes.size() - 1));
+            if (br.eop || modeIndex >= (int)modes.size()) return false;
+            const Mode& mode = modes[modeIndex];
+            const Mapping& map = mappings[mode.mapping];
+            n = blocksize[mode.blockFlag ? 1 : 0];
+            int half = n / 2;
+            bool prevLong = true, nextLong = true;
+            if (mode.blockFlag) { prevLong = br.Flag(); nextLong = br.Flag(); }
+
+            // Floors
+            bool nonzero[256];
+            for (int c = 0; c < channels; c++) {
+                const Floor1& f = floors[map.submapFloor[map.mux[c]]];
+                nonzero[c] = DecodeFloor(f, br, floorY[c]);
+                std::fill(residue[c].begin(), residue[c].begin() + half, 0.0f);
+            }
+            bool doDecode[256];
+            for (int c = 0; c < channels; c++) doDecode[c] = nonzero[c];
+            for (auto& cp : map.coupling) {
+                if (doDecode[cp.first] || doDecode[cp.second]) doDecode[cp.first] = doDecode[cp.second] = true;
+            }
+
+            // Residuos por submapa
+            for (size_t s = 0; s < map.submapResidue.size(); s++) {
+                std::vector<int> chans;
+                bool skip[256];
+                for (int c = 0; c < channels; c++) {
+                    if (map.mux[c] != s) continue;
+                    skip[chans.size()] = !doDecode[c];
+                    chans.push_back(c);
+                }
+                if (!chans.empty()) DecodeResidue(residues[map.submapResidue[s]], br, half, chans, skip);
+            }
+
+            // Acoplamiento inverso
+            for (size_t i = map.coupling.size(); i-- > 0; ) {
+                float* mag = residue[map.coupling[i].first].data();
+                float* ang = residue[map.coupling[i].second].data();
+                for (int k = 0; k < half; k++) {
+                    float m = mag[k], a = ang[k];
+                    if (m > 0) {
+                        if (a > 0) { ang[k] = m - a; }
+                        else { ang[k] = m; mag[k] = m + a; }
+                    } else {
+                        if (a > 0) { ang[k] = m + a; }
+                        else { ang[k] = m; mag[k] = m - a; }
+                    }
+                }
+            }
+
+            // Curva del floor x residuo, IMDCT y ventana
+            int lw = mode.blockFlag && !prevLong ? 0 : (mode.blockFlag ? 1 : 0);
+            int rw = mode.blockFlag && !nextLong ? 0 : (mode.blockFlag ? 1 : 0);
+            int leftN = blocksize[lw] / 2, rightN = blocksize[rw] / 2;
+            int leftStart = n / 4 - leftN / 2, rightStart = n * 3 / 4 - rightN / 2;
+            for (int c = 0; c < channels; c++) {
+                float* o = pcm[c].data();
+                if (!nonzero[c]) { std::fill(o, o + n, 0.0f); continue; }
+                SynthesizeFloor(floors[map.submapFloor[map.mux[c]]], floorY[c], residue[c].data(), half);
+                mdct[mode.blockFlag ? 1 : 0].Run(residue[c].data(), o);
+                const float* ls = slope[lw].data();
+                const float* rs = slope[rw].data();
+                for (int i = 0; i < leftStart; i++) o[i] = 0;
+                for (int i = 0; i < leftN; i++) o[leftStart + i] *= ls[i];
+                for (int i = 0; i < rightN; i++) o[rightStart + i] *= rs[rightN - 1 - i];
+                for (int i = rightStart + rightN; i < n; i++) o[i] = 0;
+            }
+            return true;
+        }
+    };
+}
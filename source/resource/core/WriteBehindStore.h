@@ -0,0 +1,264 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "AtomicFile.h"
+
+/**
+ * @class WriteBehindStore
+ * @description Caché de escritura diferida para los guardados de la página.
+ * - Guarda solo el último payload por clave: los autoguardados repetidos dentro de la
+ *   ventana de coalescencia se funden en una sola escritura.
+ * - Un hilo propio vuelca en lotes: temporales de todas las claves -> fsync de todos ->
+ *   rename de todos -> un fsync por directorio. Un corte a mitad deja el archivo viejo o el
+ *   nuevo, nunca uno a medias.
+ * - Las lecturas se sirven desde la caché sucia antes de que el volcado llegue a disco.
+ */
+class WriteBehindStore {
+public:
+    using Clock = std::chrono::steady_clock;
+    using ErrorFn = std::function<void(const std::string& key, const std::string& error)>;
+
+    /** Puntos de WriteBatch tras cada paso: temporales escritos, sincronizados, cada rename, fsync del directorio. */
+    enum class Phase { Written, Synced, Renamed, DirSynced };
+    using PhaseFn = std::function<void(Phase phase)>;
+
+    struct Stats {
+        uint64_t puts = 0;       // Guardados recibidos
+        uint64_t coalesced = 0;  // Guardados absorbidos por otro posterior
+        uint64_t commits = 0;    // Archivos escritos
+        uint64_t batches = 0;    // Volcados (lotes de fsync)
+        uint64_t bytes = 0;      // Bytes escritos
+    };
+
+    /**
+     * @param {fs::path} root - Carpeta base de las claves.
+     * @param {milliseconds} window - Tiempo máximo que un guardado espera a ser absorbido.
+     * @param {ErrorFn} onError - Se llama desde el hilo de volcado si una clave no se pudo escribir.
+     */
+    WriteBehindStore(std::filesystem::path root, std::chrono::milliseconds window, ErrorFn onError = nullptr)
+        : root(std::move(root)), window(window), onError(std::move(onError)) {
+        worker = std::thread(&WriteBehindStore::FlushLoop, this);
+    }
+
+    ~WriteBehindStore() { Stop(); }
+
+    WriteBehindStore(const WriteBehindStore&) = delete;
+    WriteBehindStore& operator=(const WriteBehindStore&) = delete;
+
+    /**
+     * Una clave válida es una ruta relativa sin ".." ni componentes raíz.
+     */
+    static bool IsValidKey(const std::string& key) {
+        if (key.empty()) return false;
+        std::filesystem::path p = std::filesystem::u8path(key);
+        if (p.is_absolute() || p.has_root_name() || p.has_root_directory()) return false;
+        for (const auto& part : p) if (part == "..") return false;
+        return true;
+    }
+
+    /**
+     * Clave de los guardados de la página: saveFile llega como "nombre.json" y loadFile/loadStream
+     * como "nombre"; las dos formas nombran el mismo archivo.
+     */
+    static std::string PageKey(std::string key) {
+        static constexpr char kExt[] = ".json";
+        constexpr size_t n = sizeof(kExt) - 1;
+        if (key.size() < n || key.compare(key.size() - n, n, kExt) != 0) key += kExt;
+        return key;
+    }
+
+    /**
+     * Registra un guardado. Devuelve enseguida; el volcado ocurre en segundo plano.
+     * @returns {bool} false si la clave no es válida o el store está detenido.
+     */
+    bool Put(const std::string& key, std::string data) {
+        if (!IsValidKey(key)) return false;
+        std::lock_guard<std::mutex> lock(mtx);
+        if (stopping) return false;
+        stats.puts++;
+        Entry& e = entries[key];
+        if (e.dirty) stats.coalesced++;
+        else { e.dirty = true; e.since = Clock::now(); }
+        e.data = std::make_shared<const std::string>(std::move(data));
+        e.version++;
+        wake.notify_one();
+        return true;
+    }
+
+    /**
+     * Lee una clave: primero la caché sucia, si no el disco.
+     * @returns {bool} false si no existe.
+     */
+    bool Get(const std::string& key, std::string& out) {
+        if (!IsValidKey(key)) return false;
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            auto it = entries.find(key);
+            if (it != entries.end()) { out = *it->second.data; return true; }
+        }
+        return AtomicFile::ReadAll(PathOf(key), out);
+    }
+
+    std::filesystem::path PathOf(const std::string& key) const { return root / std::filesystem::u8path(key); }
+
+    bool IsDirty(const std::string& key) {
+        std::lock_guard<std::mutex> lock(mtx);
+        return entries.count(key) != 0;
+    }
+
+    /**
+     * Vuelca todo lo pendiente y espera a que se haya intentado escribir.
+     */
+    void Flush() {
+        std::unique_lock<std::mutex> lock(mtx);
+        if (workerExited) return;
+        uint64_t ticket = ++flushRequested;
+        wake.notify_one();
+        idle.wait(lock, [&] { return flushServed >= ticket || workerExited; });
+    }
+
+    /**
+     * Vuelca lo pendiente y detiene el hilo. Los Put posteriores se rechazan.
+     */
+    void Stop() {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            if (stopping) return;
+            stopping = true;
+        }
+        wake.notify_one();
+        if (worker.joinable()) worker.join();
+    }
+
+    /**
+     * Se llama desde el hilo de volcado en cada Phase. Para las pruebas de cortes (savebench);
+     * se instala antes del primer Put.
+     */
+    void SetPhaseHook(PhaseFn fn) { phaseHook = std::move(fn); }
+
+    Stats GetStats() {
+        std::lock_guard<std::mutex> lock(mtx);
+        return stats;
+    }
+
+private:
+    struct Entry {
+        std::shared_ptr<const std::string> data;
+        Clock::time_point since;
+        uint64_t version = 0;
+        bool dirty = false;
+    };
+
+    struct Pending {
+        std::string key;
+        std::shared_ptr<const std::string> data;
+        uint64_t version = 0;
+        AtomicFile::Temp temp;
+        bool ok = false;
+        std::string error;
+    };
+
+    std::filesystem::path root;
+    std::chrono::milliseconds window;
+    ErrorFn onError;
+    PhaseFn phaseHook;
+
+    std::mutex mtx;
+    std::condition_variable wake, idle;
+    std::map<std::string, Entry> entries; // Solo claves sucias o en vuelo
+    Stats stats;
+    bool stopping = false, workerExited = false;
+    uint64_t flushRequested = 0, flushServed = 0;
+    std::thread worker;
+
+    void FlushLoop() {
+        std::vector<Pending> batch;
+        std::unique_lock<std::mutex> lock(mtx);
+        while (true) {
+            uint64_t ticket = flushRequested;
+            bool last = stopping; // Visto aquí: lo sucio de antes del Stop entra en esta pasada
+            bool force = last || ticket > flushServed;
+            if (!force) {
+                // Espera hasta que venza el guardado sucio más antiguo
+                Clock::time_point due = Clock::time_point::max();
+                for (auto& kv : entries) if (kv.second.dirty && kv.second.since + window < due) due = kv.second.since + window;
+                if (Clock::now() < due) {
+                    if (due == Clock::time_point::max()) wake.wait(lock);
+                    else wake.wait_until(lock, due);
+                    continue;
+                }
+            }
+
+            Clock::time_point now = Clock::now();
+            batch.clear();
+            for (auto& kv : entries) {
+                Entry& e = kv.second;
+                if (!e.dirty || (!force && e.since + window > now)) continue;
+                e.dirty = false;
+                Pending p; p.key = kv.first; p.data = e.data; p.version = e.version;
+                batch.push_back(std::move(p));
+            }
+            if (!batch.empty()) {
+                lock.unlock();
+                uint64_t written = WriteBatch(batch);
+                lock.lock();
+                stats.batches++;
+                stats.bytes += written;
+                for (auto& p : batch) {
+                    if (p.ok) stats.commits++;
+                    auto it = entries.find(p.key);
+                    // Si llegó otro Put durante el volcado, la entrada sigue sucia con los datos nuevos
+                    if (it == entries.end() || it->second.version != p.version) continue;
+                    if (p.ok) entries.erase(it);
+                    else { it->second.dirty = true; it->second.since = Clock::now(); } // Reintento en la próxima ventana
+                }
+            }
+            if (ticket > flushServed) { flushServed = ticket; idle.notify_all(); }
+            if (last) break; // Una última pasada forzada y fuera
+        }
+        workerExited = true;
+        idle.notify_all();
+    }
+
+    /**
+     * Escribe un lote completo con un único paso de fsync por fase.
+     * @returns {uint64_t} Bytes confirmados en disco.
+     */
+    uint64_t WriteBatch(std::vector<Pending>& batch) {
+        uint64_t written = 0;
+        for (auto& p : batch) {
+            p.ok = AtomicFile::WriteTemp(PathOf(p.key), p.data->data(), p.data->size(), p.temp, p.error);
+        }
+        if (phaseHook) phaseHook(Phase::Written);
+        for (auto& p : batch) {
+            if (p.ok && !(p.ok = AtomicFile::Sync(p.temp, p.error))) AtomicFile::Abort(p.temp);
+        }
+        if (phaseHook) phaseHook(Phase::Synced);
+        std::vector<std::filesystem::path> dirs;
+        for (auto& p : batch) {
+            if (!p.ok || !(p.ok = AtomicFile::Commit(p.temp, p.error))) continue;
+            if (phaseHook) phaseHook(Phase::Renamed);
+            written += p.data->size();
+            std::filesystem::path dir = p.temp.target.parent_path();
+            bool seen = false;
+            for (auto& d : dirs) if (d == dir) { seen = true; break; }
+            if (!seen) dirs.push_back(dir);
+        }
+        for (auto& d : dirs) {
+            std::string err;
+            AtomicFile::SyncDir(d, err);
+        }
+        if (phaseHook) phaseHook(Phase::DirSynced);
+        if (onError) for (auto& p : batch) if (!p.ok) onError(p.key, p.error);
+        return written;
+    }
+};
@@ -3,7 +3,7 @@
 #include <wrl.h>
 
 // Módulos nativos
-#include "nativeWindow/Config.h"
+#include "core/Config.h"
 #include "nativeWindow/Discord.h"
 #include "nativeWindow/WebViewManager.h"
 
@@ -34,6 +34,7 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
             RECT bounds; GetClientRect(hWnd, &bounds); 
             controller->put_Bounds(bounds); 
         } 
+        WebViewManager::OnWindowState(wParam == SIZE_MINIMIZED);
         break;
     case WM_GETMINMAXINFO: { 
         MINMAXINFO* mmi = (MINMAXINFO*)lParam; 
@@ -42,12 +43,16 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
         return 0; 
     }
     case WM_DESTROY: 
+        WebViewManager::Shutdown();
         DiscordClient::Get().Shutdown(); 
         PostQuitMessage(0); 
         break;
     case WM_USER + 1: 
         controller = (ICoreWebView2Controller*)lParam; 
         break;
+    case WebViewManager::WM_BRIDGE_COMPLETION:
+        WebViewManager::DrainCompletions();
+        break;
     default: 
         return DefWindowProcW(hWnd, message, wParam, lParam);
     }
@@ -0,0 +1,302 @@
+#pragma once
+#include <windows.h>
+#include <wrl.h>
+#include <cwchar>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include "WebView2.h"
+#include "Utils.h"
+#include "../core/AssetPack.h"
+#include "../core/CompletionQueue.h"
+#include "../core/Http.h"
+#include "../core/MappedFile.h"
+#include "../core/Paths.h"
+#include "../core/TaskPool.h"
+
+using namespace Microsoft::WRL;
+
+/**
+ * @class AssetHost
+ * @description Sirve https://app.genesis/* desde el paquete de assets (.gpak) mapeado en memoria.
+ * Lo que no esté en el paquete (index.html, source/, mods) se sirve desde la carpeta del exe,
+ * también mapeado. Soporta Range (audio/vídeo) e If-None-Match con el hash del contenido.
+ * El hilo de UI solo lee la petición y toma un deferral: buscar, descomprimir (texturas .ktx2
+ * incluidas) y mapear se hace en el pool, y la respuesta vuelve por DrainCompletions.
+ */
+class AssetHost {
+public:
+    /**
+     * Abre el paquete. Sin paquete, el host sigue sirviendo la carpeta suelta.
+     */
+    static bool Open(const std::wstring& packPath) {
+        std::string err;
+        return Pack().Open(std::filesystem::path(packPath), &err);
+    }
+
+    static bool HasPack() { return Pack().IsOpen(); }
+
+    /**
+     * Lee un asset entero (del paquete si está, si no de la carpeta suelta bajo `rootDir`).
+     * Para lo que el host necesita antes de que cargue la página (ej: public/textures.json).
+     */
+    static bool ReadAsset(const std::string& path, const std::wstring& rootDir, std::string& out) {
+        if (Pack().Read(path, out)) return true;
+        std::filesystem::path file;
+        if (!Paths::ResolveUnder(std::filesystem::path(rootDir), std::filesystem::u8path(path), file)) return false;
+        MappedFile mapped;
+        if (!mapped.Open(file)) return false;
+        out.assign(mapped.Data(), (size_t)mapped.Size());
+        return true;
+    }
+
+    /**
+     * Instala el handler de peticiones para `host` (ej: L"app.genesis").
+     * @param {TaskPool} pool - Donde se preparan las respuestas.
+     * @param {std::function} wake - Despierta al hilo de UI para que llame a DrainCompletions.
+     */
+    static void Attach(ICoreWebView2Environment* env, ICoreWebView2* wv, const std::wstring& host, const std::wstring& rootDir,
+                       TaskPool& pool, std::function<void()> wake) {
+        Env() = env;
+        Root() = rootDir;
+        Prefix() = L"https://" + host + L"/";
+        Workers() = &pool;
+        Completions().SetWake(std::move(wake));
+        std::wstring filter = Prefix() + L"*";
+        wv->AddWebResourceRequestedFilter(filter.c_str(), COREWEBVIEW2_WEB_RESOURCE_CONTEXT_ALL);
+        wv->add_WebResourceRequested(Callback<ICoreWebView2WebResourceRequestedEventHandler>(
+            [](ICoreWebView2*, ICoreWebView2WebResourceRequestedEventArgs* args) -> HRESULT {
+                Serve(args);
+                return S_OK;
+            }).Get(), nullptr);
+    }
+
+    /**
+     * Entrega al WebView las respuestas preparadas en el pool y completa sus deferrals. Solo desde el hilo de UI.
+     */
+    static void DrainCompletions() {
+        Completions().Drain([](Reply& r) {
+            auto it = Waiting().find(r.ticket);
+            if (it == Waiting().end()) return;
+            Respond(it->second.args.Get(), r);
+            it->second.deferral->Complete();
+            Waiting().erase(it);
+        });
+    }
+
+    /**
+     * Suelta las peticiones que siguen esperando (al cerrar la ventana, antes de detener el pool).
+     */
+    static void Stop() {
+        Workers() = nullptr;
+        for (auto& kv : Waiting()) kv.second.deferral->Complete();
+        Waiting().clear();
+    }
+
+private:
+    /**
+     * Respuesta preparada fuera del hilo de UI; `owner` mantiene vivo `body`.
+     * Sin `handled` no se responde y WebView2 sigue su curso normal.
+     */
+    struct Reply {
+        uint64_t ticket = 0;
+        bool handled = false;
+        int status = 200;
+        const wchar_t* reason = L"OK";
+        const char* body = nullptr;
+        uint64_t length = 0;
+        std::shared_ptr<void> owner;
+        std::wstring etag;
+        uint64_t contentLength = 0;
+        bool withBody = false;
+        std::wstring mime = L"text/plain";
+        std::wstring extra;
+    };
+
+    /** Petición con deferral a la espera de su Reply. Solo se toca desde el hilo de UI. */
+    struct Waiter {
+        ComPtr<ICoreWebView2WebResourceRequestedEventArgs> args;
+        ComPtr<ICoreWebView2Deferral> deferral;
+    };
+
+    /**
+     * IStream de solo lectura sobre un bloque de memoria. `owner` mantiene vivo el bloque
+     * (un archivo suelto mapeado o un asset descomprimido); para el paquete basta con el mapeo global.
+     */
+    class MemoryStream : public RuntimeClass<RuntimeClassFlags<ClassicCom>, ChainInterfaces<IStream, ISequentialStream>> {
+    public:
+        MemoryStream(const char* data, uint64_t size, std::shared_ptr<void> owner) : data(data), size(size), owner(std::move(owner)) {}
+
+        STDMETHODIMP Read(void* pv, ULONG cb, ULONG* read) override {
+            uint64_t n = pos < size ? (size - pos < cb ? size - pos : cb) : 0;
+            if (n) memcpy(pv, data + pos, (size_t)n);
+            pos += n;
+            if (read) *read = (ULONG)n;
+            return n < cb ? S_FALSE : S_OK;
+        }
+        STDMETHODIMP Seek(LARGE_INTEGER move, DWORD origin, ULARGE_INTEGER* newPos) override {
+            int64_t basePos = origin == STREAM_SEEK_SET ? 0 : origin == STREAM_SEEK_CUR ? (int64_t)pos : (int64_t)size;
+            int64_t target = basePos + move.QuadPart;
+            if (target < 0) return STG_E_INVALIDFUNCTION;
+            pos = (uint64_t)target;
+            if (newPos) newPos->QuadPart = pos;
+            return S_OK;
+        }
+        STDMETHODIMP Stat(STATSTG* stat, DWORD) override {
+            if (!stat) return STG_E_INVALIDPOINTER;
+            ZeroMemory(stat, sizeof(*stat));
+            stat->type = STGTY_STREAM;
+            stat->cbSize.QuadPart = size;
+            return S_OK;
+        }
+        STDMETHODIMP Write(const void*, ULONG, ULONG*) override { return STG_E_ACCESSDENIED; }
+        STDMETHODIMP SetSize(ULARGE_INTEGER) override { return E_NOTIMPL; }
+        STDMETHODIMP CopyTo(IStream*, ULARGE_INTEGER, ULARGE_INTEGER*, ULARGE_INTEGER*) override { return E_NOTIMPL; }
+        STDMETHODIMP Commit(DWORD) override { return S_OK; }
+        STDMETHODIMP Revert() override { return E_NOTIMPL; }
+        STDMETHODIMP LockRegion(ULARGE_INTEGER, ULARGE_INTEGER, DWORD) override { return E_NOTIMPL; }
+        STDMETHODIMP UnlockRegion(ULARGE_INTEGER, ULARGE_INTEGER, DWORD) override { return E_NOTIMPL; }
+        STDMETHODIMP Clone(IStream**) override { return E_NOTIMPL; }
+
+    private:
+        const char* data;
+        uint64_t size;
+        uint64_t pos = 0;
+        std::shared_ptr<void> owner;
+    };
+
+    static AssetPack::Reader& Pack() { static AssetPack::Reader p; return p; }
+    static ComPtr<ICoreWebView2Environment>& Env() { static ComPtr<ICoreWebView2Environment> e; return e; }
+    static std::wstring& Root() { static std::wstring r; return r; }
+    static std::wstring& Prefix() { static std::wstring p; return p; }
+    static TaskPool*& Workers() { static TaskPool* p = nullptr; return p; }
+    static CompletionQueue<Reply>& Completions() { static CompletionQueue<Reply> q; return q; }
+    static std::unordered_map<uint64_t, Waiter>& Waiting() { static std::unordered_map<uint64_t, Waiter> w; return w; }
+    static uint64_t& NextTicket() { static uint64_t t = 1; return t; }
+
+    /**
+     * "https://app.genesis/public/a%20b.png?v=2" -> "public/a b.png" (UTF-8).
+     */
+    static bool PathFromUri(const std::wstring& uri, std::string& out) {
+        if (uri.compare(0, Prefix().size(), Prefix()) != 0) return false;
+        return Http::DecodeTarget(Utils::ToString(std::wstring_view(uri).substr(Prefix().size())), out);
+    }
+
+    static std::wstring GetHeader(ICoreWebView2HttpRequestHeaders* headers, const wchar_t* name) {
+        std::wstring value;
+        LPWSTR v = nullptr;
+        if (headers && SUCCEEDED(headers->GetHeader(name, &v)) && v) { value = v; CoTaskMemFree(v); }
+        return value;
+    }
+
+    /**
+     * Hilo de UI: lee lo que hace falta de la petición, toma un deferral y manda el resto al pool.
+     */
+    static void Serve(ICoreWebView2WebResourceRequestedEventArgs* args) {
+        ComPtr<ICoreWebView2WebResourceRequest> request;
+        if (FAILED(args->get_Request(&request))) return;
+        LPWSTR uriRaw = nullptr, methodRaw = nullptr;
+        request->get_Uri(&uriRaw);
+        request->get_Method(&methodRaw);
+        std::wstring uri = uriRaw ? uriRaw : L"", method = methodRaw ? methodRaw : L"GET";
+        if (uriRaw) CoTaskMemFree(uriRaw);
+        if (methodRaw) CoTaskMemFree(methodRaw);
+        if (method != L"GET" && method != L"HEAD") return;
+
+        std::string path;
+        if (!PathFromUri(uri, path)) return;
+        ComPtr<ICoreWebView2HttpRequestHeaders> reqHeaders;
+        request->get_Headers(&reqHeaders);
+        std::wstring ifNoneMatch = GetHeader(reqHeaders.Get(), L"If-None-Match");
+        std::string range = Utils::ToString(GetHeader(reqHeaders.Get(), L"Range"));
+        bool head = method == L"HEAD";
+
+        ComPtr<ICoreWebView2Deferral> deferral;
+        if (!Workers() || FAILED(args->GetDeferral(&deferral))) {
+            Respond(args, Prepare(path, head, ifNoneMatch, range));
+            return;
+        }
+        uint64_t ticket = NextTicket()++;
+        Waiting()[ticket] = Waiter{ args, deferral };
+        Workers()->Submit([ticket, path = std::move(path), head, ifNoneMatch = std::move(ifNoneMatch), range = std::move(range)] {
+            Reply r = Prepare(path, head, ifNoneMatch, range);
+            r.ticket = ticket;
+            Completions().Push(std::move(r));
+        });
+    }
+
+    /**
+     * Pool: busca el asset (paquete o carpeta suelta), lo descomprime o lo mapea y arma la respuesta.
+     */
+    static Reply Prepare(const std::string& path, bool head, const std::wstring& ifNoneMatch, const std::string& range) {
+        Reply r;
+        const char* data = nullptr;
+        uint64_t size = 0, tag = 0;
+        AssetPack::Asset asset;
+        if (Pack().Find(path, asset)) {
+            tag = asset.hash;
+            if (asset.codec == AssetPack::Stored) { data = asset.data; size = asset.size; }
+            else {
+                auto buf = std::make_shared<std::string>();
+                if (!AssetPack::Reader::Read(asset, *buf)) return r;
+                data = buf->data(); size = buf->size(); r.owner = buf;
+            }
+        } else {
+            // Fuera del paquete: archivo suelto bajo la carpeta del exe
+            std::filesystem::path file;
+            if (!Paths::ResolveUnder(std::filesystem::path(Root()), std::filesystem::u8path(path), file)) return r;
+            auto mapped = std::make_shared<MappedFile>();
+            if (!mapped->Open(file)) {
+                r.handled = true; r.status = 404; r.reason = L"Not Found";
+                return r;
+            }
+            std::error_code ec;
+            auto mtime = std::filesystem::last_write_time(file, ec).time_since_epoch().count();
+            data = mapped->Data(); size = mapped->Size(); r.owner = mapped;
+            tag = AssetPack::Hash64(&mtime, sizeof(mtime), AssetPack::Hash64(&size, sizeof(size)));
+        }
+
+        wchar_t etag[24];
+        swprintf_s(etag, L"\"%016llx\"", (unsigned long long)tag);
+        r.handled = true;
+        r.etag = etag;
+        if (ifNoneMatch == r.etag) {
+            r.status = 304; r.reason = L"Not Modified"; r.contentLength = size; r.owner.reset();
+            return r;
+        }
+
+        uint64_t first = 0, last = size ? size - 1 : 0;
+        bool partial = Http::ParseRange(range, size, first, last) == Http::Range::Partial;
+        r.length = partial ? last - first + 1 : size;
+        r.body = head ? nullptr : data + (partial ? first : 0);
+        r.status = partial ? 206 : 200;
+        r.reason = partial ? L"Partial Content" : L"OK";
+        r.contentLength = r.length;
+        r.withBody = true;
+        r.mime = Utils::ToWString(Http::MimeOf(path));
+        if (partial) r.extra = L"Content-Range: bytes " + std::to_wstring(first) + L"-" + std::to_wstring(last) + L"/" + std::to_wstring(size) + L"\r\n";
+        return r;
+    }
+
+    /**
+     * Hilo de UI: convierte la Reply en la respuesta del WebView.
+     */
+    static void Respond(ICoreWebView2WebResourceRequestedEventArgs* args, const Reply& r) {
+        if (!r.handled) return;
+        std::wstring headers = L"Access-Control-Allow-Origin: *\r\nCache-Control: no-cache\r\nAccept-Ranges: bytes\r\n";
+        if (!r.etag.empty()) headers += L"ETag: " + r.etag + L"\r\n";
+        if (r.withBody) {
+            headers += L"Content-Type: " + r.mime + L"\r\n";
+            headers += L"Content-Length: " + std::to_wstring(r.contentLength) + L"\r\n";
+        }
+        headers += r.extra;
+
+        ComPtr<IStream> stream;
+        if (r.body) stream = Make<MemoryStream>(r.body, r.length, r.owner);
+        ComPtr<ICoreWebView2WebResourceResponse> response;
+        if (SUCCEEDED(Env()->CreateWebResourceResponse(stream.Get(), r.status, r.reason, headers.c_str(), &response))) {
+            args->put_Response(response.Get());
+        }
+    }
+};
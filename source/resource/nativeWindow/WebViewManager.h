@@ -1,27 +1,74 @@
 #pragma once
 #include <windows.h>
 #include <wrl.h>
+#include <array>
+#include <ctime>
 #include <string>
 #include <psapi.h>
 #include <shellapi.h>
 #include "WebView2.h"
 #include "WebView2EnvironmentOptions.h"
-#include "Config.h"
+#include "../core/Config.h"
 #include "Utils.h"
 #include "Discord.h"
+#include "AssetHost.h"
+#include "../core/Rpc.h"
+#include "../core/RpcExecutor.h"
+#include "../core/FileStream.h"
+#include "../core/FramePacer.h"
+#include "../core/WriteBehindStore.h"
+#include "../core/Journal.h"
+#include "../core/ChartIndex.h"
+#include "../core/SongLibrary.h"
+#include "../core/AssetGraph.h"
+#include "../core/Search.h"
+#include "../core/DirTree.h"
+#include "../core/DirWatcher.h"
+#include "../core/Paths.h"
+#include "../core/Peaks.h"
+#include "../core/Onsets.h"
+#include "../core/Playback.h"
+#include "../core/Telemetry.h"
 
 using namespace Microsoft::WRL;
 
 class WebViewManager {
 public:
+    /** Mensaje de ventana con el que los workers despiertan al hilo de UI. */
+    static constexpr UINT WM_BRIDGE_COMPLETION = WM_APP + 1;
+
     static void Initialize(HWND hWnd, std::wstring exeDir, AppConfig config) {
+        BridgeContext& ctx = Context();
+        ctx.hWnd = hWnd; ctx.exeDir = exeDir; ctx.config = config;
+        RegisterRoutes();
+        Executor().Attach(Routes());
+
+        // Telemetría: tiempo de cada verbo del puente y muestreo de recursos del proceso
+        Perf().NameThread("ui");
+        for (size_t i = 0; i < Routes().Size(); i++) {
+            std::wstring_view verb = Routes().At(i).verb;
+            RouteSeries()[i] = Perf().Get("rpc." + Utils::ToString(verb));
+        }
+        Routes().SetObserver(OnRouteTimed);
+        Resources().Start(std::chrono::milliseconds(kSampleIntervalMs));
+
+        // Caché de carpetas del juego: solo guarda listados si el watcher está vigilando
+        Tree().SetRoot(fs::path(exeDir));
+        Tree().SetLive(Watcher().Start(fs::path(exeDir), OnFsChanges));
+
+        // Frecuencia del bucle de Phaser: la página la pide con pacerStart y recibe los cambios ("pacerHz")
+        Pacer().SetRate(config.fpsLimit > 0 ? config.fpsLimit : 60);
+        Pacer().SetIdleRate(config.fpsIdle);
+        Pacer().SetMinimizedRate(0);
+        Pacer().SetOnChange([](double) { PublishRate(); });
+
         auto options = Make<CoreWebView2EnvironmentOptions>();
         
         std::wstring flags = L"";
         
         // --- RENDIMIENTO SEGURO ---
         // Sin flags de desbloqueo = VSync Activo (60/144Hz visuales).
-        // Phaser corre a 300 FPS lógicos internamente.
+        // Phaser sigue con requestAnimationFrame y salta los frames que pasan de Pacer().Rate().
         
         flags += L"--use-angle=default "; 
         flags += L"--ignore-gpu-blocklist "; 
@@ -50,16 +97,25 @@ public:
                     if(!env) { MessageBoxW(hWnd, L"Error WebView2", L"Error", MB_OK); return S_FALSE; }
                     
                     env->CreateCoreWebView2Controller(hWnd, Callback<ICoreWebView2CreateCoreWebView2ControllerCompletedHandler>(
-                        [hWnd, exeDir, config](HRESULT, ICoreWebView2Controller* c) -> HRESULT {
+                        [hWnd, exeDir, config, env](HRESULT, ICoreWebView2Controller* c) -> HRESULT {
                             if (!c) return S_FALSE; 
                             c->AddRef();
                             SendMessage(hWnd, WM_USER + 1, 0, (LPARAM)c);
                             
                             RECT b; GetClientRect(hWnd, &b); c->put_Bounds(b);
                             ComPtr<ICoreWebView2> wv; c->get_CoreWebView2(&wv);
+                            Context().sender = wv.Get();
                             ComPtr<ICoreWebView2_3> wv3; wv.As(&wv3);
                             
-                            if (wv3) wv3->SetVirtualHostNameToFolderMapping(L"app.genesis", exeDir.c_str(), COREWEBVIEW2_HOST_RESOURCE_ACCESS_KIND_ALLOW);
+                            // Con paquete de assets, el host lo sirve desde memoria (y lo suelto como respaldo);
+                            // sin paquete, mapeo directo a la carpeta como siempre
+                            if (!config.assetPack.empty() && AssetHost::Open(exeDir + L"\\" + config.assetPack)) {
+                                AssetHost::Attach(env, wv.Get(), L"app.genesis", exeDir, Pool(), [] {
+                                    PostMessage(Context().hWnd, WM_BRIDGE_COMPLETION, 0, 0);
+                                });
+                            } else if (wv3) {
+                                wv3->SetVirtualHostNameToFolderMapping(L"app.genesis", exeDir.c_str(), COREWEBVIEW2_HOST_RESOURCE_ACCESS_KIND_ALLOW);
+                            }
 
                             ComPtr<ICoreWebView2Settings> settings; wv->get_Settings(&settings);
                             settings->put_IsScriptEnabled(TRUE); 
@@ -79,15 +135,30 @@ public:
                             std::wstring jsInject = L"window.__GENESIS_PATHS__ = { gameDir: '";
                             for(auto ch : exeDir) { jsInject += (ch == L'\\') ? L"\\\\" : std::wstring(1, ch); }
                             jsInject += L"' };";
+                            // Texturas comprimidas (ktxc): la página elige BC7/ETC2 según lo que soporte la GPU
+                            std::string textures;
+                            if (AssetHost::ReadAsset("public/textures.json", exeDir, textures)) {
+                                jsInject += L"\nwindow.__GENESIS_TEXTURES__ = " + Utils::ToWString(textures) + L";";
+                            }
                             
                             wv->AddScriptToExecuteOnDocumentCreated(jsInject.c_str(), nullptr);
+
+                            // Al navegar, las llamadas pendientes de la página anterior ya no tienen a quién responder
+                            wv->add_NavigationStarting(Callback<ICoreWebView2NavigationStartingEventHandler>(
+                                [](ICoreWebView2*, ICoreWebView2NavigationStartingEventArgs*) -> HRESULT {
+                                    PublishedRate() = -1;
+                                    Executor().CancelAll();
+                                    Streams().CloseAll();
+                                    return S_OK;
+                                }).Get(), nullptr);
                             
-                            // Callback de mensajes limpio (ya no busca 'fps:')
+                            // Puente RPC: el mensaje se despacha sobre el buffer de WebView2, sin copiarlo
                             wv->add_WebMessageReceived(Callback<ICoreWebView2WebMessageReceivedEventHandler>(
-                                [hWnd, exeDir, config](ICoreWebView2* sender, ICoreWebView2WebMessageReceivedEventArgs* args) -> HRESULT {
-                                    LPWSTR p; args->TryGetWebMessageAsString(&p);
-                                    std::wstring msg(p); CoTaskMemFree(p);
-                                    HandleWebMessage(hWnd, sender, msg, exeDir, config);
+                                [](ICoreWebView2* sender, ICoreWebView2WebMessageReceivedEventArgs* args) -> HRESULT {
+                                    LPWSTR p = nullptr;
+                                    if (FAILED(args->TryGetWebMessageAsString(&p)) || !p) return S_OK;
+                                    HandleWebMessage(sender, std::wstring_view(p));
+                                    CoTaskMemFree(p);
                                     return S_OK;
                                 }).Get(), nullptr);
 
@@ -98,74 +169,1137 @@ public:
                 }).Get());
     }
 
+    /**
+     * Entrega al WebView las respuestas de los handlers asíncronos. Llamado desde WndProc.
+     */
+    static void DrainCompletions() {
+        AssetHost::DrainCompletions();
+        ICoreWebView2* sender = Context().sender;
+        Executor().Drain([sender](const std::wstring& reply) {
+            if (sender) sender->PostWebMessageAsString(reply.c_str());
+        });
+    }
+
+    /**
+     * Minimizada, el bucle del juego se pausa (o va a la frecuencia de minimizada). Llamado en WM_SIZE.
+     */
+    static void OnWindowState(bool minimized) {
+        Pacer().SetMinimized(minimized);
+    }
+
+    /**
+     * Abandona las lecturas pendientes, deja terminar las escrituras en serie y solo entonces
+     * cierra diarios y store y detiene los workers. Llamado en WM_DESTROY.
+     */
+    static void Shutdown() {
+        Transport().Close();
+        Resources().Stop();
+        Watcher().Stop();
+        Executor().CancelAll(RpcMode::Pool);
+        AssetHost::Stop();
+        Streams().CloseAll();
+        // Un journalEdit encolado aún escribe en su diario: cerrar antes sería una carrera
+        Pool().WaitIdle();
+        Journals().CloseAll();
+        if (!StoreRoot().empty()) Store().Stop();
+        Pool().Shutdown();
+    }
+
 private:
-    static void HandleWebMessage(HWND hWnd, ICoreWebView2* sender, std::wstring msg, std::wstring exeDir, AppConfig config) {
-        // Se ha eliminado la lógica de FPS. Solo queda lo funcional.
-        if (msg.find(L"resize:") == 0) {
-            std::wstring d = msg.substr(7);
-            int w = std::stoi(d.substr(0, d.find(L",")));
-            int h = std::stoi(d.substr(d.find(L",") + 1));
-            SetWindowPos(hWnd, 0, 0, 0, w, h, SWP_NOMOVE | SWP_NOZORDER);
-        }
-        else if (msg == L"maximize") ShowWindow(hWnd, SW_MAXIMIZE);
-        else if (msg == L"minimize") ShowWindow(hWnd, SW_MINIMIZE);
-        else if (msg == L"close") PostMessage(hWnd, WM_CLOSE, 0, 0);
-        else if (msg.find(L"setTitle:") == 0) SetWindowTextW(hWnd, msg.substr(9).c_str());
-        else if (msg.find(L"saveFile:") == 0) {
-            std::wstring data = msg.substr(9);
-            size_t pipe = data.find(L"|");
-            if (pipe != std::wstring::npos) Utils::SaveToAppData(config.appID, data.substr(0, pipe), data.substr(pipe + 1));
-        }
-        else if (msg.find(L"loadFile:") == 0) {
-            std::wstring key = msg.substr(9);
-            std::wstring content = Utils::LoadFromAppData(config.appID, key + L".json");
-            std::wstring reply = L"fileLoaded:" + key + L"|" + content;
+    /** Máximo de peticiones asíncronas simultáneas; el resto recibe "busy". */
+    static constexpr size_t kMaxInFlight = 64;
+    /** Cada cuánto se muestrean RSS, CPU, hilos y handles. */
+    static constexpr int kSampleIntervalMs = 250;
+
+    /**
+     * @struct BridgeContext
+     * @description Estado compartido por los handlers del puente. Vive mientras viva la ventana.
+     */
+    struct BridgeContext {
+        HWND hWnd = NULL;
+        ICoreWebView2* sender = nullptr;
+        std::wstring exeDir;
+        AppConfig config;
+    };
+
+    using Dispatcher = RpcDispatcher<BridgeContext>;
+
+    static BridgeContext& Context() { static BridgeContext ctx; return ctx; }
+    static Dispatcher& Routes() { static Dispatcher d; return d; }
+
+    static TaskPool& Pool() {
+        // ShellExecute y los diálogos del shell necesitan COM en el hilo que los llama
+        static TaskPool pool(0,
+            [] { CoInitializeEx(NULL, COINIT_APARTMENTTHREADED | COINIT_DISABLE_OLE1DDE); Perf().NameThread("pool"); },
+            [] { CoUninitialize(); });
+        return pool;
+    }
+
+    static StreamRegistry& Streams() { static StreamRegistry s; return s; }
+    static FramePacer& Pacer() { static FramePacer p; return p; }
+    static ChartRegistry& Charts() { static ChartRegistry c; return c; }
+    /** Pirámides de forma de onda; la caché en disco va en AppData/<appID>/peaks. */
+    static Peaks::Registry& Waveforms() {
+        static Peaks::Registry r(Utils::AppDataPath(Context().config.appID, L"peaks"));
+        return r;
+    }
+
+    /** Onsets y curva de flujo por hash del .ogg; la caché en disco va en AppData/<appID>/onsets. */
+    static Onsets::Cache& Rhythm() {
+        static Onsets::Cache c(Utils::AppDataPath(Context().config.appID, L"onsets"));
+        return c;
+    }
+
+    /** PCM decodificado de los stems, compartido entre cargas (hasta 512 MB). */
+    static Playback::PcmCache& Stems() { static Playback::PcmCache c; return c; }
+
+    /**
+     * Reproductor de stems del editor. Su reloj es la posición autoritativa de la canción: se emite
+     * como "playerClock" cada 50 ms mientras suena y en cada cambio (ver AppendClock).
+     */
+    static Playback::Player& Transport() {
+        static Playback::Player& p = []() -> Playback::Player& {
+            static Playback::Player player(Stems());
+            player.SetListener([](const Playback::Player::Clock& c) {
+                std::wstring s;
+                AppendClock(s, c);
+                Executor().Emit(L"playerClock", s);
+            });
+            return player;
+        }();
+        return p;
+    }
+
+    /** Telemetría del proceso: series rpc.* (puente), page.* (la página) y contadores process.*. */
+    static Telemetry::Hub& Perf() { static Telemetry::Hub hub; return hub; }
+    static Telemetry::Sampler& Resources() { static Telemetry::Sampler s(Perf()); return s; }
+    static std::array<Telemetry::Hub::Series*, Dispatcher::kMaxRoutes>& RouteSeries() {
+        static std::array<Telemetry::Hub::Series*, Dispatcher::kMaxRoutes> series{};
+        return series;
+    }
+
+    /**
+     * Observador del despachador (hilo de UI o workers). En rutas asíncronas también registra
+     * la espera en cola en "rpc.queue".
+     */
+    static void OnRouteTimed(const Dispatcher::Route& r, uint64_t queuedNs, uint64_t startNs, uint64_t endNs) {
+        if (auto* s = RouteSeries()[Routes().IndexOf(r)]) Perf().Complete(*s, startNs, endNs);
+        if (startNs > queuedNs) {
+            static Telemetry::Hub::Series* queue = Perf().Get("rpc.queue");
+            if (queue) Perf().Complete(*queue, queuedNs, startNs);
+        }
+    }
+
+    static DirTreeCache& Tree() { static DirTreeCache t; return t; }
+
+    /** Índice de public/songs para el navegador de canciones; se guarda en AppData/<appID>/library.json. */
+    static fs::path LibraryPath() { return Utils::AppDataPath(Context().config.appID, L"library.json"); }
+    static SongLibrary::Index& Library() {
+        static SongLibrary::Index index = [] { SongLibrary::Index i; i.Load(LibraryPath()); return i; }();
+        return index;
+    }
+    /** Dependencias de cada canción; los JSON de datos se releen solo si el watcher ve que cambiaron. */
+    static AssetGraph::Graph& Assets() { static AssetGraph::Graph g; return g; }
+    static DirWatcher& Watcher() { static DirWatcher w; return w; }
+
+    /** Índice de trigramas de source/ y public/ para "search"; se guarda en AppData/<appID>/search.gsrx. */
+    static fs::path SearchIndexPath() { return Utils::AppDataPath(Context().config.appID, L"search.gsrx"); }
+    static Search::Index& SearchIndex() {
+        static Search::Index& index = []() -> Search::Index& {
+            static Search::Index i;
+            i.Load(SearchIndexPath());
+            return i;
+        }();
+        return index;
+    }
+
+    /** La página pidió recibir "fsChange" (fsWatch). */
+    static std::atomic<bool>& WatchEvents() { static std::atomic<bool> on{false}; return on; }
+
+    /**
+     * Lotes del watcher (desde su hilo): se aplican a la caché y, si la página lo pidió,
+     * se reenvían como evento "fsChange" con una línea "tipo\truta" por cambio
+     * (tipo: a = alta, r = baja, m = modificado, o = desbordamiento, hay que volver a listar).
+     */
+    static void OnFsChanges(std::vector<DirWatcher::Change>& changes) {
+        Tree().Apply(changes);
+        if (!WatchEvents()) return;
+        std::string lines;
+        for (const auto& c : changes) {
+            static const char kinds[] = { 'a', 'r', 'm', 'o' };
+            if (!lines.empty()) lines += '\n';
+            lines += kinds[(int)c.kind];
+            lines += '\t';
+            lines += c.path;
+        }
+        Executor().Emit(L"fsChange", Utils::ToWString(lines));
+    }
+
+    /** Carpeta de los guardados (AppData/<appID>); vacía si no se pudo resolver la carpeta de datos. */
+    static const fs::path& StoreRoot() {
+        static const fs::path root = Utils::AppDataPath(Context().config.appID, L"");
+        return root;
+    }
+
+    /**
+     * Sin carpeta de datos no se arranca el almacén: las claves acabarían relativas al directorio
+     * de trabajo. La ruta falla con "no data folder".
+     */
+    static bool StoreAvailable(std::wstring& out) {
+        if (!StoreRoot().empty()) return true;
+        out = L"no data folder";
+        return false;
+    }
+
+    /**
+     * Guardados de la página (AppData/<appID>). Los errores de volcado llegan como evento "storageError".
+     * Solo se usa tras comprobar StoreAvailable.
+     */
+    static WriteBehindStore& Store() {
+        static WriteBehindStore store(StoreRoot(),
+            std::chrono::milliseconds(Context().config.saveCoalesceMs > 0 ? Context().config.saveCoalesceMs : 0),
+            [](const std::string& key, const std::string& error) {
+                Executor().Emit(L"storageError", Utils::ToWString(key + "|" + error));
+            });
+        return store;
+    }
+
+    /**
+     * Diarios de edición del editor (AppData/<appID>/journal). Se fuerzan a disco con la misma
+     * ventana que los guardados diferidos.
+     */
+    static Journal::Store& Journals() {
+        static Journal::Store store(Utils::AppDataPath(Context().config.appID, L"journal"),
+            std::chrono::milliseconds(Context().config.saveCoalesceMs > 0 ? Context().config.saveCoalesceMs : 0));
+        return store;
+    }
+
+    static RpcExecutor<BridgeContext>& Executor() {
+        static RpcExecutor<BridgeContext> exec(Pool(), kMaxInFlight, [] {
+            PostMessage(Context().hWnd, WM_BRIDGE_COMPLETION, 0, 0);
+        });
+        return exec;
+    }
+
+    /**
+     * Registra los verbos del puente. Los prefijos legados mantienen el formato antiguo
+     * ("fileLoaded:clave|contenido", "dirListed:ruta|a|b"...) para mensajes sin sobre.
+     * Las rutas de disco y shell van al pool; las que tocan la ventana o el WebView, Inline.
+     */
+    static void RegisterRoutes() {
+        Dispatcher& d = Routes();
+        d.Register(L"resize", OnResize);
+        d.Register(L"maximize", OnMaximize);
+        d.Register(L"minimize", OnMinimize);
+        d.Register(L"close", OnClose);
+        d.Register(L"setTitle", OnSetTitle);
+        d.Register(L"saveFile", OnSaveFile); // Solo toca la caché sucia: un loadFile posterior ya la ve
+        d.Register(L"storageFlush", OnStorageFlush, {}, false, RpcMode::Serial);
+        d.Register(L"storageStats", OnStorageStats);
+        d.Register(L"loadFile", OnLoadFile, L"fileLoaded:", true, RpcMode::Pool);
+        d.Register(L"journalOpen", OnJournalOpen, {}, false, RpcMode::Serial);
+        d.Register(L"journalEdit", OnJournalEdit, {}, false, RpcMode::Serial);
+        d.Register(L"journalCommit", OnJournalCommit, {}, false, RpcMode::Serial);
+        d.Register(L"journalUndo", OnJournalUndo, {}, false, RpcMode::Serial);
+        d.Register(L"journalRedo", OnJournalRedo, {}, false, RpcMode::Serial);
+        d.Register(L"journalHistory", OnJournalHistory, {}, false, RpcMode::Serial);
+        d.Register(L"journalClose", OnJournalClose, {}, false, RpcMode::Serial);
+        d.Register(L"journalStats", OnJournalStats);
+        d.Register(L"loadStream", OnLoadStream, {}, false, RpcMode::Pool);
+        d.Register(L"streamRead", OnStreamRead, {}, false, RpcMode::Pool);
+        d.Register(L"streamClose", OnStreamClose);
+        d.Register(L"listDir", OnListDir, L"dirListed:", true, RpcMode::Pool);
+        d.Register(L"listTree", OnListTree, {}, false, RpcMode::Pool);
+        d.Register(L"fsWatch", OnFsWatch);
+        d.Register(L"openExternal", OnOpenExternal, {}, false, RpcMode::Pool);
+        d.Register(L"chartOpen", OnChartOpen, {}, false, RpcMode::Pool);
+        d.Register(L"chartNotes", OnChartNotes);
+        d.Register(L"chartDensity", OnChartDensity);
+        d.Register(L"chartClose", OnChartClose);
+        d.Register(L"libraryScan", OnLibraryScan, {}, false, RpcMode::Serial);
+        d.Register(L"songAssets", OnSongAssets, {}, false, RpcMode::Serial);
+        d.Register(L"search", OnSearch, {}, false, RpcMode::Pool);
+        d.Register(L"peaksOpen", OnPeaksOpen, {}, false, RpcMode::Pool);
+        d.Register(L"peaksTile", OnPeaksTile);
+        d.Register(L"peaksClose", OnPeaksClose);
+        d.Register(L"analyzeSong", OnAnalyzeSong, {}, false, RpcMode::Pool);
+        d.Register(L"playerLoad", OnPlayerLoad, {}, false, RpcMode::Pool);
+        d.Register(L"playerCtl", OnPlayerCtl);
+        d.Register(L"playerStats", OnPlayerStats);
+        d.Register(L"playerClose", OnPlayerClose);
+        d.Register(L"msgBox", OnMsgBox, L"dialogClosed");
+        d.Register(L"openFile", OnOpenFile, L"fileSelected:");
+        d.Register(L"getMemory", OnGetMemory, L"memInfo:");
+        d.Register(L"perfFrames", OnPerfFrames);
+        d.Register(L"perfStats", OnPerfStats);
+        d.Register(L"perfTrace", OnPerfTrace, {}, false, RpcMode::Pool);
+        d.Register(L"pacerStart", OnPacerStart);
+        d.Register(L"pacerStop", OnPacerStop);
+        d.Register(L"pacerScene", OnPacerScene);
+        d.Register(L"pacerRate", OnPacerRate);
+        d.Register(L"pacerIdle", OnPacerIdle);
+        d.Register(L"pacerStats", OnPacerStats);
+        d.Register(L"discord", OnDiscord);
+        d.Register(L"cancel", OnCancel);
+    }
+
+    /**
+     * Si GENESIS_RPC_TRACE apunta a un archivo, le añade cada mensaje recibido (ver RpcTrace) para
+     * reproducir la sesión con rpcbench --bench. Solo se usa desde el hilo de UI.
+     */
+    static void TraceMessage(std::wstring_view msg) {
+        static FILE* file = [] {
+            const wchar_t* path = _wgetenv(L"GENESIS_RPC_TRACE");
+            return path && *path ? _wfopen(path, L"ab") : nullptr;
+        }();
+        if (!file) return;
+        static std::string record;
+        record.clear();
+        RpcTrace::AppendRecord(record, Utils::ToString(msg));
+        fwrite(record.data(), 1, record.size(), file);
+        fflush(file);
+    }
+
+    static void HandleWebMessage(ICoreWebView2* sender, std::wstring_view msg) {
+        TraceMessage(msg);
+        BridgeContext& ctx = Context();
+        ctx.sender = sender;
+        Routes().Dispatch(ctx, msg, [sender](const std::wstring& reply) {
             sender->PostWebMessageAsString(reply.c_str());
+        });
+    }
+
+    // --- Handlers ---
+
+    static bool OnResize(BridgeContext& ctx, const RpcRequest& req, std::wstring& out) {
+        std::wstring_view d = req.payload;
+        int w = RpcCodec::ParseInt(RpcCodec::NextToken(d, L','), -1);
+        int h = RpcCodec::ParseInt(d, -1);
+        if (w <= 0 || h <= 0) { out = L"invalid size"; return false; }
+        SetWindowPos(ctx.hWnd, 0, 0, 0, w, h, SWP_NOMOVE | SWP_NOZORDER);
+        return true;
+    }
+
+    static bool OnMaximize(BridgeContext& ctx, const RpcRequest&, std::wstring&) { ShowWindow(ctx.hWnd, SW_MAXIMIZE); return true; }
+    static bool OnMinimize(BridgeContext& ctx, const RpcRequest&, std::wstring&) { ShowWindow(ctx.hWnd, SW_MINIMIZE); return true; }
+    static bool OnClose(BridgeContext& ctx, const RpcRequest&, std::wstring&) { PostMessage(ctx.hWnd, WM_CLOSE, 0, 0); return true; }
+
+    static bool OnSetTitle(BridgeContext& ctx, const RpcRequest& req, std::wstring&) {
+        SetWindowTextW(ctx.hWnd, std::wstring(req.payload).c_str());
+        return true;
+    }
+
+    /**
+     * Payload: "archivo|contenido". Va a la caché de escritura diferida; el disco se actualiza después.
+     */
+    static bool OnSaveFile(BridgeContext&, const RpcRequest& req, std::wstring& out) {
+        if (!StoreAvailable(out)) return false;
+        size_t pipe = req.payload.find(L'|');
+        if (pipe == std::wstring_view::npos) { out = L"missing key"; return false; }
+        std::string key = WriteBehindStore::PageKey(Utils::ToString(req.payload.substr(0, pipe)));
+        if (!Store().Put(key, Utils::ToString(req.payload.substr(pipe + 1)))) { out = L"invalid key"; return false; }
+        return true;
+    }
+
+    static bool OnLoadFile(BridgeContext&, const RpcRequest& req, std::wstring& out) {
+        if (!StoreAvailable(out)) return false;
+        std::string content;
+        if (Store().Get(WriteBehindStore::PageKey(Utils::ToString(req.payload)), content)) Utils::AppendWString(out, content);
+        return true;
+    }
+
+    static bool OnStorageFlush(BridgeContext&, const RpcRequest&, std::wstring&) {
+        if (!StoreRoot().empty()) Store().Flush();
+        std::string err;
+        Journals().Sync(err);
+        return true;
+    }
+
+    /** Respuesta: "guardados|absorbidos|archivosEscritos|lotes|bytes". */
+    static bool OnStorageStats(BridgeContext&, const RpcRequest&, std::wstring& out) {
+        WriteBehindStore::Stats st = StoreRoot().empty() ? WriteBehindStore::Stats() : Store().GetStats();
+        for (uint64_t v : { st.puts, st.coalesced, st.commits, st.batches, st.bytes }) {
+            if (!out.empty()) out += L'|';
+            RpcCodec::AppendNumber(out, v);
         }
-        else if (msg.find(L"listDir:") == 0) {
-            std::wstring relPath = msg.substr(8);
-            for (auto &c : relPath) if (c == L'/') c = L'\\';
-            std::wstring fullDir = exeDir + L"\\" + relPath;
-            std::wstring fileList = L"";
-            if (fs::exists(fullDir) && fs::is_directory(fullDir)) {
-                for (const auto & entry : fs::directory_iterator(fullDir)) {
-                    if (entry.is_regular_file()) {
-                        if (!fileList.empty()) fileList += L"|";
-                        fileList += entry.path().filename().wstring();
-                    }
+        return true;
+    }
+
+    // --- Diarios de edición ---
+    // Los offsets y longitudes que ve la página van en unidades UTF-16 (las de un string de JS);
+    // el diario trabaja en bytes UTF-8.
+
+    /** "rev|deshacer|rehacer" del documento. */
+    static void AppendJournalState(std::wstring& out, const Journal::Document& d) {
+        RpcCodec::AppendNumber(out, d.Rev()); out += L'|';
+        RpcCodec::AppendNumber(out, (uint64_t)d.UndoStack().size()); out += L'|';
+        RpcCodec::AppendNumber(out, (uint64_t)d.RedoStack().size());
+    }
+
+    /** Payload: clave. Respuesta: "rev|deshacer|rehacer|texto" (reconstruido desde el diario). */
+    static bool OnJournalOpen(BridgeContext&, const RpcRequest& req, std::wstring& out) {
+        std::string err;
+        bool ok = Journals().With(Utils::ToString(req.payload), err, [&](Journal::Log& log) {
+            AppendJournalState(out, log.Doc());
+            out += L'|';
+            Utils::AppendWString(out, log.Doc().Text());
+            return true;
+        });
+        if (!ok) out = Utils::ToWString(err);
+        return ok;
+    }
+
+    /**
+     * Un empalme hecho en la página. Payload: "clave|offset|quitar|etiqueta|texto".
+     * Respuesta: "rev|deshacer|rehacer". "stale edit" si el documento no es el que la página cree.
+     */
+    static bool OnJournalEdit(BridgeContext&, const RpcRequest& req, std::wstring& out) {
+        std::wstring_view rest = req.payload;
+        std::string key = Utils::ToString(RpcCodec::NextToken(rest));
+        int offset = RpcCodec::ParseInt(RpcCodec::NextToken(rest), -1);
+        int remove = RpcCodec::ParseInt(RpcCodec::NextToken(rest), -1);
+        std::string label = Utils::ToString(RpcCodec::NextToken(rest));
+        if (offset < 0 || remove < 0) { out = L"invalid range"; return false; }
+        std::string err;
+        bool ok = Journals().With(key, err, [&](Journal::Log& log) {
+            const std::string& text = log.Doc().Text();
+            size_t start = Utf::Utf8Offset<wchar_t>(text.data(), text.size(), (size_t)offset);
+            size_t end = start + Utf::Utf8Offset<wchar_t>(text.data() + start, text.size() - start, (size_t)remove);
+            Journal::Change c;
+            c.offset = start;
+            c.removed.assign(text, start, end - start);
+            Utils::AppendString(c.inserted, rest);
+            c.label = std::move(label);
+            if (!log.Apply(std::move(c), err)) return false;
+            AppendJournalState(out, log.Doc());
+            return true;
+        });
+        if (!ok) out = Utils::ToWString(err);
+        return ok;
+    }
+
+    /**
+     * El documento entero; el nativo calcula el empalme y solo escribe eso.
+     * Payload: "clave|etiqueta|texto". Respuesta: "rev|deshacer|rehacer".
+     */
+    static bool OnJournalCommit(BridgeContext&, const RpcRequest& req, std::wstring& out) {
+        std::wstring_view rest = req.payload;
+        std::string key = Utils::ToString(RpcCodec::NextToken(rest));
+        std::string label = Utils::ToString(RpcCodec::NextToken(rest));
+        std::string text = Utils::ToString(rest);
+        std::string err;
+        bool ok = Journals().With(key, err, [&](Journal::Log& log) {
+            if (!log.Commit(text, label, err)) return false;
+            AppendJournalState(out, log.Doc());
+            return true;
+        });
+        if (!ok) out = Utils::ToWString(err);
+        return ok;
+    }
+
+    /**
+     * Payload: clave. Respuesta: "rev|deshacer|rehacer|offset|quitar|texto", el empalme que la
+     * página tiene que repetir sobre su copia. "nothing to undo" / "nothing to redo" si no hay.
+     */
+    static bool JournalStep(const RpcRequest& req, std::wstring& out, bool redo) {
+        std::string err;
+        bool ok = Journals().With(Utils::ToString(req.payload), err, [&](Journal::Log& log) {
+            Journal::Change applied;
+            if (!(redo ? log.Redo(err, &applied) : log.Undo(err, &applied))) return false;
+            const std::string& text = log.Doc().Text();
+            AppendJournalState(out, log.Doc()); out += L'|';
+            RpcCodec::AppendNumber(out, (uint64_t)Utf::WideLength(text.data(), (size_t)applied.offset)); out += L'|';
+            RpcCodec::AppendNumber(out, (uint64_t)Utf::WideLength(applied.removed.data(), applied.removed.size())); out += L'|';
+            Utils::AppendWString(out, applied.inserted);
+            return true;
+        });
+        if (!ok) out = Utils::ToWString(err);
+        return ok;
+    }
+
+    static bool OnJournalUndo(BridgeContext&, const RpcRequest& req, std::wstring& out) { return JournalStep(req, out, false); }
+    static bool OnJournalRedo(BridgeContext&, const RpcRequest& req, std::wstring& out) { return JournalStep(req, out, true); }
+
+    /** Payload: clave. Respuesta: JSON {rev, undo: [etiquetas], redo: [etiquetas]}, del más antiguo al más reciente. */
+    static bool OnJournalHistory(BridgeContext&, const RpcRequest& req, std::wstring& out) {
+        std::string err, j;
+        bool ok = Journals().With(Utils::ToString(req.payload), err, [&](Journal::Log& log) {
+            const Journal::Document& d = log.Doc();
+            j += "{\"rev\":"; Json::AppendNumber(j, (double)d.Rev());
+            for (int r = 0; r < 2; r++) {
+                j += r ? "],\"redo\":[" : ",\"undo\":[";
+                bool first = true;
+                for (const Journal::Change& c : r ? d.RedoStack() : d.UndoStack()) {
+                    if (!first) j += ',';
+                    Json::AppendString(j, c.label);
+                    first = false;
                 }
             }
-            std::wstring reply = L"dirListed:" + relPath + L"|" + fileList;
-            sender->PostWebMessageAsString(reply.c_str());
+            j += "]}";
+            return true;
+        });
+        if (!ok) { out = Utils::ToWString(err); return false; }
+        Utils::AppendWString(out, j);
+        return true;
+    }
+
+    static bool OnJournalClose(BridgeContext&, const RpcRequest& req, std::wstring&) {
+        Journals().Close(Utils::ToString(req.payload));
+        return true;
+    }
+
+    /** Respuesta: "ediciones|deshechas|rehechas|compactaciones|bytesAñadidos|bytesCompactados|bytesRecuperados". */
+    static bool OnJournalStats(BridgeContext&, const RpcRequest&, std::wstring& out) {
+        Journal::Log::Stats st = Journals().GetStats();
+        for (uint64_t v : { st.edits, st.undos, st.redos, st.compactions, st.appended, st.compacted, st.recovered }) {
+            if (!out.empty()) out += L'|';
+            RpcCodec::AppendNumber(out, v);
         }
-        else if (msg.find(L"openExternal:") == 0) ShellExecuteW(NULL, L"open", msg.substr(13).c_str(), NULL, NULL, SW_SHOWNORMAL);
-        else if (msg.find(L"msgBox:") == 0) {
-            std::wstring data = msg.substr(7);
-            size_t p1 = data.find(L"|"); size_t p2 = data.find_last_of(L"|");
-            std::wstring title = data.substr(0, p1);
-            std::wstring body = data.substr(p1 + 1, p2 - p1 - 1);
-            int type = std::stoi(data.substr(p2 + 1));
-            MessageBoxW(hWnd, body.c_str(), title.c_str(), type);
-            sender->PostWebMessageAsString(L"dialogClosed");
-        }
-        else if (msg.find(L"openFile:") == 0) {
-            std::wstring res = Utils::OpenFileDialog(hWnd, msg.substr(9));
-            std::wstring reply = L"fileSelected:" + res;
-            sender->PostWebMessageAsString(reply.c_str());
+        return true;
+    }
+
+    /**
+     * Abre una carga en streaming. Payload: "clave|bytesPorBloque". Respuesta: "<streamId>|<bytesTotales>".
+     * Los bloques llegan después como eventos "chunk" a medida que la página pide créditos.
+     */
+    static bool OnLoadStream(BridgeContext&, const RpcRequest& req, std::wstring& out) {
+        std::wstring_view rest = req.payload;
+        std::string key = WriteBehindStore::PageKey(Utils::ToString(RpcCodec::NextToken(rest)));
+        int chunk = RpcCodec::ParseInt(rest, 0);
+        if (!WriteBehindStore::IsValidKey(key)) { out = L"invalid key"; return false; }
+        if (!StoreAvailable(out)) return false;
+        // El stream lee del disco: lo que siga en la caché sucia tiene que bajar antes
+        if (Store().IsDirty(key)) Store().Flush();
+        size_t total = 0;
+        uint32_t id = Streams().Open(Store().PathOf(key), chunk > 0 ? (size_t)chunk : 0, total);
+        if (!id) { out = L"not found"; return false; }
+        RpcCodec::AppendNumber(out, id); out += L'|'; RpcCodec::AppendNumber(out, total);
+        return true;
+    }
+
+    /**
+     * Entrega bloques de un stream. Payload: "<streamId>|<créditos>".
+     * Eventos: "chunk" ("<id>|texto"), "streamProgress" ("<id>|leídos|total") y "streamEnd" ("<id>").
+     */
+    static bool OnStreamRead(BridgeContext&, const RpcRequest& req, std::wstring& out) {
+        std::wstring_view rest = req.payload;
+        uint32_t id = (uint32_t)RpcCodec::ParseInt(RpcCodec::NextToken(rest));
+        int credits = RpcCodec::ParseInt(rest, 1);
+        bool found = Streams().Read(id, credits > 0 ? (size_t)credits : 1,
+            [](uint32_t sid, size_t done, size_t total, std::wstring&& chunk, bool last) {
+                Executor().Emit(L"chunk", std::move(chunk));
+                std::wstring progress;
+                RpcCodec::AppendNumber(progress, sid); progress += L'|';
+                RpcCodec::AppendNumber(progress, done); progress += L'|';
+                RpcCodec::AppendNumber(progress, total);
+                Executor().Emit(L"streamProgress", std::move(progress));
+                if (last) Executor().Emit(L"streamEnd", std::to_wstring(sid));
+            });
+        if (!found) { out = L"unknown stream"; return false; }
+        return true;
+    }
+
+    static bool OnStreamClose(BridgeContext&, const RpcRequest& req, std::wstring&) {
+        Streams().Close((uint32_t)RpcCodec::ParseInt(req.payload));
+        return true;
+    }
+
+    /**
+     * Formato legado: nombres de los archivos (sin carpetas) de una carpeta, separados por '|'.
+     */
+    static bool OnListDir(BridgeContext&, const RpcRequest& req, std::wstring& out) {
+        std::vector<DirTreeCache::Item> items;
+        if (!Tree().List(Utils::ToString(req.payload), false, {}, items, [&req] { return req.Cancelled(); })) {
+            return !req.Cancelled();
+        }
+        for (const auto& item : items) {
+            if (item.isDir) continue;
+            if (!out.empty()) out += L'|';
+            Utils::AppendWString(out, item.path);
+        }
+        return true;
+    }
+
+    /**
+     * Listado con metadatos. Payload: "ruta|recursivo(0/1)|glob".
+     * Respuesta: una línea por entrada, "d|f\ttamaño\tmtimeMs\trutaRelativa" (relativa a la carpeta pedida).
+     */
+    static bool OnListTree(BridgeContext&, const RpcRequest& req, std::wstring& out) {
+        std::wstring_view rest = req.payload;
+        std::string path = Utils::ToString(RpcCodec::NextToken(rest));
+        bool recursive = RpcCodec::ParseInt(RpcCodec::NextToken(rest), 0) != 0;
+        std::string glob = Utils::ToString(rest);
+        std::vector<DirTreeCache::Item> items;
+        if (!Tree().List(path, recursive, glob, items, [&req] { return req.Cancelled(); })) {
+            out = req.Cancelled() ? L"cancelled" : L"not found";
+            return false;
+        }
+        std::string lines;
+        for (const auto& item : items) {
+            if (!lines.empty()) lines += '\n';
+            lines += item.isDir ? 'd' : 'f';
+            lines += '\t'; lines += std::to_string(item.size);
+            lines += '\t'; lines += std::to_string(item.mtimeMs);
+            lines += '\t'; lines += item.path;
+        }
+        Utils::AppendWString(out, lines);
+        return true;
+    }
+
+    /** Payload: "1" para recibir eventos "fsChange", "0" para dejar de recibirlos. */
+    static bool OnFsWatch(BridgeContext&, const RpcRequest& req, std::wstring& out) {
+        WatchEvents() = RpcCodec::ParseInt(req.payload, 0) != 0;
+        out = Watcher().IsRunning() ? L"1" : L"0";
+        return true;
+    }
+
+    /**
+     * Abre un chart del juego. Payload: ruta relativa a la carpeta del exe.
+     * Respuesta (JSON): handle, número de notas, duración, bpm, velocidad, personajes y tipos de nota.
+     */
+    static bool OnChartOpen(BridgeContext& ctx, const RpcRequest& req, std::wstring& out) {
+        fs::path path;
+        if (!Paths::ResolveUnder(fs::path(ctx.exeDir), std::wstring(req.payload), path)) { out = L"invalid path"; return false; }
+        std::string err;
+        uint32_t handle = Charts().Open(path, &err);
+        auto chart = Charts().Get(handle);
+        if (!chart) { out = Utils::ToWString(err.empty() ? "cannot open" : err); return false; }
+        std::string j = "{\"handle\":" + std::to_string(handle) + ",\"notes\":" + std::to_string(chart->Count());
+        j += ",\"duration\":"; Json::AppendNumber(j, chart->Duration());
+        j += ",\"bpm\":"; Json::AppendNumber(j, chart->bpm);
+        j += ",\"speed\":"; Json::AppendNumber(j, chart->speed);
+        j += ",\"sections\":" + std::to_string(chart->sectionCount);
+        j += ",\"song\":"; Json::AppendString(j, chart->song);
+        j += ",\"player\":"; Json::AppendString(j, chart->player);
+        j += ",\"enemy\":"; Json::AppendString(j, chart->enemy);
+        j += ",\"gfVersion\":"; Json::AppendString(j, chart->gfVersion);
+        j += ",\"stage\":"; Json::AppendString(j, chart->stage);
+        j += ",\"noteSkin\":"; Json::AppendString(j, chart->noteSkin);
+        j += ",\"types\":[";
+        for (size_t i = 0; i < chart->types.size(); i++) { if (i) j += ','; Json::AppendString(j, chart->types[i]); }
+        j += "]}";
+        Utils::AppendWString(out, j);
+        return true;
+    }
+
+    /**
+     * Notas en [t0, t1). Payload: "handle|t0|t1|sostenidas(0/1)".
+     * Respuesta: "tiempo,carril,sostenida,tipo;..." (carril absoluto 0-7).
+     */
+    static bool OnChartNotes(BridgeContext&, const RpcRequest& req, std::wstring& out) {
+        std::wstring_view rest = req.payload;
+        auto chart = Charts().Get((uint32_t)RpcCodec::ParseInt(RpcCodec::NextToken(rest)));
+        if (!chart) { out = L"unknown chart"; return false; }
+        double t0 = RpcCodec::ParseDouble(RpcCodec::NextToken(rest));
+        double t1 = RpcCodec::ParseDouble(RpcCodec::NextToken(rest));
+        bool holds = RpcCodec::ParseInt(rest, 0) != 0;
+        auto range = chart->Range(t0, t1, holds);
+        for (size_t i = range.first; i < range.second; i++) {
+            if (holds && !chart->Overlaps(i, t0)) continue;
+            if (!out.empty()) out += L';';
+            RpcCodec::AppendDouble(out, chart->time[i]); out += L',';
+            RpcCodec::AppendNumber(out, chart->lane[i]); out += L',';
+            RpcCodec::AppendDouble(out, chart->sustain[i]); out += L',';
+            RpcCodec::AppendNumber(out, chart->type[i]);
+        }
+        return true;
+    }
+
+    /**
+     * Densidad de notas. Payload: "handle|t0|t1|cubetas|máscaraCarriles". Respuesta: "n,n,n...".
+     */
+    static bool OnChartDensity(BridgeContext&, const RpcRequest& req, std::wstring& out) {
+        std::wstring_view rest = req.payload;
+        auto chart = Charts().Get((uint32_t)RpcCodec::ParseInt(RpcCodec::NextToken(rest)));
+        if (!chart) { out = L"unknown chart"; return false; }
+        double t0 = RpcCodec::ParseDouble(RpcCodec::NextToken(rest));
+        double t1 = RpcCodec::ParseDouble(RpcCodec::NextToken(rest));
+        int buckets = RpcCodec::ParseInt(RpcCodec::NextToken(rest), 0);
+        int mask = RpcCodec::ParseInt(rest, 0xFF);
+        if (buckets <= 0 || buckets > 65536) { out = L"invalid bucket count"; return false; }
+        std::vector<uint32_t> counts;
+        chart->Density(t0, t1, (size_t)buckets, counts, (uint8_t)mask);
+        for (size_t i = 0; i < counts.size(); i++) { if (i) out += L','; RpcCodec::AppendNumber(out, counts[i]); }
+        return true;
+    }
+
+    static bool OnChartClose(BridgeContext&, const RpcRequest& req, std::wstring&) {
+        Charts().Close((uint32_t)RpcCodec::ParseInt(req.payload));
+        return true;
+    }
+
+    /**
+     * Pone al día el índice de public/songs (solo se parsea lo nuevo o modificado) y lo devuelve.
+     * Respuesta (JSON): {"files","parsed","reused","removed","ms","library":{...}} con el formato
+     * de SongLibrary::Index::ToJson.
+     */
+    static bool OnLibraryScan(BridgeContext&, const RpcRequest&, std::wstring& out) {
+        SongLibrary::ScanStats st;
+        if (!Library().Scan(Tree(), "public/songs", &Pool(), &st)) { out = L"not found"; return false; }
+        std::string j = "{\"files\":";
+        Json::AppendNumber(j, (double)st.files);
+        j += ",\"parsed\":"; Json::AppendNumber(j, (double)st.parsed);
+        j += ",\"reused\":"; Json::AppendNumber(j, (double)st.reused);
+        j += ",\"removed\":"; Json::AppendNumber(j, (double)st.removed);
+        j += ",\"ms\":"; Json::AppendNumber(j, st.ms);
+        std::string err;
+        if ((st.parsed || st.removed) && !Library().Save(LibraryPath(), err)) {
+            j += ",\"error\":"; Json::AppendString(j, err);
         }
-        else if (msg == L"getMemory") {
-            PROCESS_MEMORY_COUNTERS pmc;
-            if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) {
-                std::wstring reply = L"memInfo:" + std::to_wstring(pmc.WorkingSetSize);
-                sender->PostWebMessageAsString(reply.c_str());
+        j += ",\"library\":";
+        Library().ToJson(j);
+        j += '}';
+        Utils::AppendWString(out, j);
+        return true;
+    }
+
+    /**
+     * Manifiesto de precarga de una canción: payload "canción|dificultad" (dificultad vacía = normal).
+     * Respuesta (JSON): {"song","difficulty","isChart","bytes","missing","ms","assets":[{"path","kind",
+     * "priority","bytes","missing"}]} con las rutas relativas al exe. Payload vacío: el grafo de todas las
+     * canciones, {"charts","files","bytes","ms","missing":[...],"orphans":[{"path","bytes"}]}.
+     */
+    static bool OnSongAssets(BridgeContext&, const RpcRequest& req, std::wstring& out) {
+        std::wstring_view rest = req.payload;
+        std::string song = Utils::ToString(RpcCodec::NextToken(rest));
+        std::string difficulty = Utils::ToString(rest);
+        AssetGraph::Stats st;
+        std::string j;
+        if (song.empty()) {
+            AssetGraph::Report report;
+            Assets().Build(Tree(), report, &st);
+            AssetGraph::Graph::ToJson(report, j);
+        } else {
+            AssetGraph::Manifest m;
+            Assets().Resolve(Tree(), song, difficulty.empty() ? "normal" : difficulty, m, &st);
+            AssetGraph::Graph::ToJson(m, j);
+        }
+        j.pop_back();
+        j += ",\"ms\":"; Json::AppendNumber(j, st.ms);
+        j += '}';
+        Utils::AppendWString(out, j);
+        return true;
+    }
+
+    /**
+     * Busca en source/ y public/ (.json, .xml, .js, .css). Payload: "id|opciones|máximo|texto", con
+     * opciones "r" (regex) y "c" (distinguir mayúsculas). El índice se pone al día antes de buscar.
+     * Los resultados llegan mientras se encuentran como eventos "searchHits": "id" y una línea
+     * "ruta\tlínea\tcolumna\ttexto" por resultado. Respuesta (JSON) al terminar: {"files","candidates",
+     * "bytes","hits","truncated","indexed","ms"}.
+     */
+    static bool OnSearch(BridgeContext&, const RpcRequest& req, std::wstring& out) {
+        std::wstring_view rest = req.payload;
+        std::wstring id(RpcCodec::NextToken(rest));
+        std::wstring_view options = RpcCodec::NextToken(rest);
+        int max = RpcCodec::ParseInt(RpcCodec::NextToken(rest), 1000);
+        Search::Query q;
+        q.text = Utils::ToString(rest);
+        q.regex = options.find(L'r') != std::wstring_view::npos;
+        q.caseSensitive = options.find(L'c') != std::wstring_view::npos;
+        q.maxHits = max > 0 ? (size_t)max : 1000;
+        if (q.text.empty()) { out = L"empty query"; return false; }
+
+        Search::UpdateStats us;
+        std::string err;
+        if (SearchIndex().Update(Tree(), { "source", "public" }, &Pool(), &us)) SearchIndex().Save(SearchIndexPath(), err);
+        Search::QueryStats st;
+        bool ok = SearchIndex().Run(q, [&id](std::vector<Search::Hit>& hits) {
+            std::string lines;
+            for (const auto& h : hits) {
+                lines += '\n';
+                lines += h.path; lines += '\t';
+                lines += std::to_string(h.line); lines += '\t';
+                lines += std::to_string(h.column); lines += '\t';
+                lines += h.text;
             }
+            Executor().Emit(L"searchHits", id + Utils::ToWString(lines));
+        }, &Pool(), [&req] { return req.Cancelled(); }, &st, &err);
+        if (!ok) { out = Utils::ToWString("invalid regex: " + err); return false; }
+        if (req.Cancelled()) { out = L"cancelled"; return false; }
+
+        std::string j = "{\"files\":";
+        Json::AppendNumber(j, (double)st.files);
+        j += ",\"candidates\":"; Json::AppendNumber(j, (double)st.candidates);
+        j += ",\"bytes\":"; Json::AppendNumber(j, (double)st.bytes);
+        j += ",\"hits\":"; Json::AppendNumber(j, (double)st.hits);
+        j += ",\"truncated\":"; j += st.truncated ? "true" : "false";
+        j += ",\"indexed\":"; Json::AppendNumber(j, (double)us.indexed);
+        j += ",\"ms\":"; Json::AppendNumber(j, us.ms + st.ms);
+        j += '}';
+        Utils::AppendWString(out, j);
+        return true;
+    }
+
+    /**
+     * Abre la forma de onda de un .ogg (ruta relativa al exe). La primera vez decodifica y guarda la pirámide.
+     * Respuesta (JSON): handle, canales, sampleRate, muestras, muestras por cubeta del nivel 0 y cubetas por nivel.
+     */
+    static bool OnPeaksOpen(BridgeContext& ctx, const RpcRequest& req, std::wstring& out) {
+        fs::path path;
+        if (!Paths::ResolveUnder(fs::path(ctx.exeDir), std::wstring(req.payload), path)) { out = L"invalid path"; return false; }
+        std::string err;
+        uint32_t handle = Waveforms().Open(path, &err);
+        auto p = Waveforms().Get(handle);
+        if (!p) { out = Utils::ToWString(err.empty() ? "cannot open" : err); return false; }
+        std::string j = "{\"handle\":" + std::to_string(handle) + ",\"channels\":" + std::to_string(p->Channels());
+        j += ",\"sampleRate\":" + std::to_string(p->SampleRate()) + ",\"frames\":" + std::to_string(p->Frames());
+        j += ",\"baseBin\":" + std::to_string(p->BaseBin()) + ",\"levels\":[";
+        for (size_t l = 0; l < p->Levels(); l++) { if (l) j += ','; j += std::to_string(p->Bins(l)); }
+        j += "]}";
+        Utils::AppendWString(out, j);
+        return true;
+    }
+
+    /**
+     * Tramo visible de un nivel. Payload: "handle|nivel|primeraCubeta|cubetas".
+     * Respuesta: "primeraCubeta|cubetas|base64" con int16 LE min/max/rms por canal y cubeta.
+     */
+    static bool OnPeaksTile(BridgeContext&, const RpcRequest& req, std::wstring& out) {
+        std::wstring_view rest = req.payload;
+        auto p = Waveforms().Get((uint32_t)RpcCodec::ParseInt(RpcCodec::NextToken(rest)));
+        if (!p) { out = L"unknown waveform"; return false; }
+        int level = RpcCodec::ParseInt(RpcCodec::NextToken(rest), -1);
+        int start = RpcCodec::ParseInt(RpcCodec::NextToken(rest), -1);
+        int count = RpcCodec::ParseInt(rest, 0);
+        if (level < 0 || start < 0 || count <= 0 || count > 65536) { out = L"invalid range"; return false; }
+        uint32_t got = (uint32_t)count;
+        const char* data = p->Tile((size_t)level, (uint32_t)start, got);
+        RpcCodec::AppendNumber(out, (uint32_t)start); out += L'|';
+        RpcCodec::AppendNumber(out, got); out += L'|';
+        if (data) RpcCodec::AppendBase64(out, data, (size_t)got * p->Channels() * 6);
+        return true;
+    }
+
+    static bool OnPeaksClose(BridgeContext&, const RpcRequest& req, std::wstring&) {
+        Waveforms().Close((uint32_t)RpcCodec::ParseInt(req.payload));
+        return true;
+    }
+
+    /**
+     * BPM, fase y notas sugeridas de una canción. Payload: "carpeta|bpm|subdivisión" (carpeta relativa
+     * al exe, con song/Inst.ogg y las voces); bpm 0 = estimarlo de Inst.ogg, o de las voces si no hay.
+     * Cada .ogg se analiza una vez y se guarda por hash (ver Rhythm()).
+     * Respuesta (JSON): {"bpm","phaseMs","confidence","estimated","durationMs","stems":[{"role","file",
+     * "onsets":[[ms,fuerza],...],"notes":[[ms,carril,duración],...]}]}. Carriles 0-3 rival, 4-7 jugador;
+     * con un Voices.ogg mezclado ("voices") van en 0-3 y la página decide a quién son.
+     */
+    static bool OnAnalyzeSong(BridgeContext& ctx, const RpcRequest& req, std::wstring& out) {
+        std::wstring_view rest = req.payload;
+        fs::path dir;
+        if (!Paths::ResolveUnder(fs::path(ctx.exeDir), std::wstring(RpcCodec::NextToken(rest)), dir)) { out = L"invalid path"; return false; }
+        double bpm = RpcCodec::ParseDouble(RpcCodec::NextToken(rest));
+        int subdivision = RpcCodec::ParseInt(rest, 4);
+        if (!(bpm >= 0 && bpm <= 1000) || subdivision < 1 || subdivision > 64) { out = L"invalid arguments"; return false; }
+
+        struct Stem { const char* file; const char* role; int lane; };
+        static const Stem kStems[] = {
+            { "Voices-Player.ogg", "player", 4 },
+            { "Voices-Opponent.ogg", "opponent", 0 },
+            { "Voices.ogg", "voices", 0 },
+        };
+        std::error_code ec;
+        std::string err;
+        Onsets::Analysis inst;
+        bool haveInst = fs::is_regular_file(dir / "song" / "Inst.ogg", ec) && Rhythm().Get(dir / "song" / "Inst.ogg", inst, &err);
+        std::vector<std::pair<const Stem*, Onsets::Analysis>> voices;
+        for (const Stem& s : kStems) {
+            if (req.Cancelled()) { out = L"cancelled"; return false; }
+            fs::path p = dir / "song" / s.file;
+            if (!fs::is_regular_file(p, ec)) continue;
+            Onsets::Analysis a;
+            if (Rhythm().Get(p, a, &err)) voices.emplace_back(&s, std::move(a));
+        }
+        if (!haveInst && voices.empty()) { out = Utils::ToWString(err.empty() ? "no audio" : err); return false; }
+
+        const Onsets::Analysis& ref = haveInst ? inst : voices.front().second;
+        Onsets::Tempo tempo;
+        bool estimated = bpm <= 0;
+        if (estimated) tempo = Onsets::EstimateTempo(ref.curve);
+        else { tempo.bpm = bpm; tempo.phaseMs = Onsets::EstimatePhase(ref.curve, bpm); }
+
+        std::string j = "{\"bpm\":";
+        Json::AppendNumber(j, tempo.bpm);
+        j += ",\"phaseMs\":"; Json::AppendNumber(j, tempo.phaseMs);
+        j += ",\"confidence\":"; Json::AppendNumber(j, tempo.confidence);
+        j += ",\"estimated\":"; j += estimated ? "true" : "false";
+        j += ",\"durationMs\":"; Json::AppendNumber(j, ref.DurationMs());
+        j += ",\"stems\":[";
+        for (size_t i = 0; i < voices.size(); i++) {
+            const Stem& s = *voices[i].first;
+            const Onsets::Analysis& a = voices[i].second;
+            if (i) j += ',';
+            j += "{\"role\":"; Json::AppendString(j, s.role);
+            j += ",\"file\":"; Json::AppendString(j, s.file);
+            j += ",\"onsets\":[";
+            for (size_t k = 0; k < a.onsets.size(); k++) {
+                if (k) j += ',';
+                j += '['; Json::AppendNumber(j, a.onsets[k].timeMs);
+                j += ','; Json::AppendNumber(j, std::round(a.onsets[k].strength * 1000.0) / 1000.0); j += ']';
+            }
+            j += "],\"notes\":[";
+            auto notes = tempo.bpm > 0 ? Onsets::Suggest(a.onsets, tempo.bpm, tempo.phaseMs, subdivision) : std::vector<Onsets::Note>();
+            for (size_t k = 0; k < notes.size(); k++) {
+                if (k) j += ',';
+                j += '['; Json::AppendNumber(j, notes[k].timeMs);
+                j += ','; Json::AppendNumber(j, notes[k].lane + s.lane);
+                j += ','; Json::AppendNumber(j, notes[k].sustainMs); j += ']';
+            }
+            j += "]}";
+        }
+        j += "]}";
+        Utils::AppendWString(out, j);
+        return true;
+    }
+
+    /** "ms|velocidad|sonando|terminó" (booleanos 0/1). */
+    static void AppendClock(std::wstring& out, const Playback::Player::Clock& c) {
+        RpcCodec::AppendDouble(out, std::round(c.ms * 1000.0) / 1000.0); out += L'|';
+        RpcCodec::AppendDouble(out, c.speed); out += L'|';
+        out += c.playing ? L'1' : L'0'; out += L'|';
+        out += c.ended ? L'1' : L'0';
+    }
+
+    /**
+     * Carga los stems de una canción en el reproductor (parado en 0). Payload: carpeta relativa al
+     * exe, con song/Inst.ogg y las voces. Decodifica una vez; las siguientes cargas salen de Stems().
+     * Respuesta (JSON): {"durationMs","sampleRate","channels","decodeMs","stems":["Inst.ogg",...]}.
+     */
+    static bool OnPlayerLoad(BridgeContext& ctx, const RpcRequest& req, std::wstring& out) {
+        fs::path dir;
+        if (!Paths::ResolveUnder(fs::path(ctx.exeDir), std::wstring(req.payload), dir)) { out = L"invalid path"; return false; }
+        std::vector<fs::path> files;
+        std::error_code ec;
+        for (const char* f : { "Inst.ogg", "Voices.ogg", "Voices-Player.ogg", "Voices-Opponent.ogg" }) {
+            fs::path p = dir / "song" / f;
+            if (fs::is_regular_file(p, ec)) files.push_back(p);
+        }
+        if (files.empty()) { out = L"no audio"; return false; }
+        std::string err;
+        Playback::Player& player = Transport();
+        if (!player.Load(files, &err)) { out = Utils::ToWString(err); return false; }
+        if (req.Cancelled()) { out = L"cancelled"; return false; }
+
+        std::string j = "{\"durationMs\":";
+        Json::AppendNumber(j, player.DurationMs());
+        j += ",\"sampleRate\":"; Json::AppendNumber(j, player.Rate());
+        j += ",\"channels\":"; Json::AppendNumber(j, player.Channels());
+        j += ",\"decodeMs\":"; Json::AppendNumber(j, player.GetStats().decodeMs);
+        j += ",\"stems\":[";
+        for (size_t i = 0; i < player.StemCount(); i++) {
+            if (i) j += ',';
+            Json::AppendString(j, player.StemName(i));
+        }
+        j += "]}";
+        Utils::AppendWString(out, j);
+        return true;
+    }
+
+    /**
+     * Payload: "play", "pause", "seek|ms", "speed|x" (0,25 - 4), "gain|stem|volumen" o "" (solo
+     * consultar). Responde con el reloj tras el cambio (ver AppendClock).
+     */
+    static bool OnPlayerCtl(BridgeContext&, const RpcRequest& req, std::wstring& out) {
+        std::wstring_view rest = req.payload;
+        std::wstring_view cmd = RpcCodec::NextToken(rest);
+        Playback::Player& player = Transport();
+        std::string err;
+        if (cmd == L"play") {
+            if (!player.Play(&err)) { out = Utils::ToWString(err); return false; }
+        } else if (cmd == L"pause") {
+            player.Pause();
+        } else if (cmd == L"seek") {
+            double ms = RpcCodec::ParseDouble(rest);
+            if (!(ms >= 0)) { out = L"invalid position"; return false; }
+            player.Seek(ms);
+        } else if (cmd == L"speed") {
+            double speed = RpcCodec::ParseDouble(rest);
+            if (!(speed > 0)) { out = L"invalid speed"; return false; }
+            player.SetSpeed(speed);
+        } else if (cmd == L"gain") {
+            int stem = RpcCodec::ParseInt(RpcCodec::NextToken(rest), -1);
+            double gain = RpcCodec::ParseDouble(rest);
+            if (stem < 0 || !(gain >= 0 && gain <= 4)) { out = L"invalid gain"; return false; }
+            player.SetGain((size_t)stem, (float)gain);
+        } else if (!cmd.empty()) {
+            out = L"unknown command";
+            return false;
+        }
+        AppendClock(out, player.Now());
+        return true;
+    }
+
+    static bool OnPlayerStats(BridgeContext&, const RpcRequest&, std::wstring& out) {
+        Playback::Player& player = Transport();
+        Playback::Player::Stats s = player.GetStats();
+        out = player.Loaded() ? L"{\"loaded\":true" : L"{\"loaded\":false";
+        const std::pair<const wchar_t*, double> fields[] = {
+            { L"stems", (double)s.stems }, { L"frames", (double)s.frames }, { L"renderMs", s.renderMs },
+            { L"costMsPerSecond", s.CostPerSecond(player.Rate()) }, { L"underruns", (double)s.underruns },
+            { L"hops", (double)s.hops }, { L"searches", (double)s.searches }, { L"decodeMs", s.decodeMs },
+            { L"cacheBytes", (double)Stems().Bytes() } };
+        for (const auto& f : fields) {
+            out += L",\"";
+            out += f.first;
+            out += L"\":";
+            RpcCodec::AppendDouble(out, f.second);
+        }
+        out += L'}';
+        return true;
+    }
+
+    static bool OnPlayerClose(BridgeContext&, const RpcRequest&, std::wstring&) {
+        Transport().Close();
+        return true;
+    }
+
+    static bool OnOpenExternal(BridgeContext&, const RpcRequest& req, std::wstring&) {
+        ShellExecuteW(NULL, L"open", std::wstring(req.payload).c_str(), NULL, NULL, SW_SHOWNORMAL);
+        return true;
+    }
+
+    static bool OnMsgBox(BridgeContext& ctx, const RpcRequest& req, std::wstring&) {
+        std::wstring_view data = req.payload;
+        size_t p1 = data.find(L'|'); size_t p2 = data.find_last_of(L'|');
+        if (p1 == std::wstring_view::npos) p1 = p2 = data.size();
+        std::wstring title(data.substr(0, p1));
+        std::wstring body(p2 > p1 ? data.substr(p1 + 1, p2 - p1 - 1) : std::wstring_view());
+        int type = (p2 < data.size()) ? RpcCodec::ParseInt(data.substr(p2 + 1)) : MB_OK;
+        MessageBoxW(ctx.hWnd, body.c_str(), title.c_str(), type);
+        return true;
+    }
+
+    static bool OnOpenFile(BridgeContext& ctx, const RpcRequest& req, std::wstring& out) {
+        out = Utils::OpenFileDialog(ctx.hWnd, std::wstring(req.payload));
+        return true;
+    }
+
+    static bool OnGetMemory(BridgeContext&, const RpcRequest&, std::wstring& out) {
+        PROCESS_MEMORY_COUNTERS pmc;
+        if (!GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) { out = L"unavailable"; return false; }
+        RpcCodec::AppendNumber(out, pmc.WorkingSetSize);
+        return true;
+    }
+
+    /**
+     * Tiempos medidos en la página, en lote. Payload: "nombre|timeOrigin|inicio,duración,inicio,duración..."
+     * con los valores de performance.now() en ms. Van a la serie "page.<nombre>".
+     */
+    static bool OnPerfFrames(BridgeContext&, const RpcRequest& req, std::wstring& out) {
+        std::wstring_view rest = req.payload;
+        std::wstring_view name = RpcCodec::NextToken(rest);
+        if (name.empty() || name.size() > 32) { out = L"invalid name"; return false; }
+        for (wchar_t c : name) {
+            if (!iswalnum(c) && c != L'.' && c != L'_' && c != L'-') { out = L"invalid name"; return false; }
         }
-        else if (msg.find(L"discord:") == 0) {
-            std::wstring data = msg.substr(8);
-            size_t p = data.find(L"|");
-            std::string state = Utils::ToString(data.substr(0, p));
-            std::string details = (p != std::wstring::npos) ? Utils::ToString(data.substr(p + 1)) : "";
-            DiscordClient::Get().SetActivity(details, state, "fnf_icon", "Genesis Engine");
+        double origin = RpcCodec::ParseDouble(RpcCodec::NextToken(rest), -1);
+        if (origin < 0) { out = L"invalid origin"; return false; }
+        Telemetry::Hub::Series* s = Perf().Get("page." + Utils::ToString(name));
+        if (!s) { out = L"too many series"; return false; }
+        while (!rest.empty()) {
+            double start = RpcCodec::ParseDouble(RpcCodec::NextToken(rest, L','), -1);
+            double dur = RpcCodec::ParseDouble(RpcCodec::NextToken(rest, L','), -1);
+            if (start < 0 || dur < 0) continue;
+            uint64_t at = Perf().FromEpochMs(origin + start);
+            Perf().Complete(*s, at, at + (uint64_t)(dur * 1e6), Telemetry::Hub::kPageThread);
         }
+        return true;
+    }
+
+    /** Respuesta: JSON con percentiles (ms) de cada serie y la última muestra de recursos. */
+    static bool OnPerfStats(BridgeContext&, const RpcRequest&, std::wstring& out) {
+        Telemetry::ResourceSample s = Resources().Latest();
+        Utils::AppendWString(out, Perf().StatsJson(&s));
+        return true;
+    }
+
+    /**
+     * Vuelca lo retenido como trace de Chrome en AppData/<appID>/traces. Respuesta: ruta del archivo.
+     */
+    static bool OnPerfTrace(BridgeContext& ctx, const RpcRequest&, std::wstring& out) {
+        std::string json, err;
+        Perf().WriteTrace(json);
+        fs::path path = Utils::AppDataPath(ctx.config.appID, L"traces") / ("trace-" + std::to_string(std::time(nullptr)) + ".json");
+        if (!AtomicFile::Write(path, json, err)) { out = Utils::ToWString(err); return false; }
+        out = path.wstring();
+        return true;
+    }
+
+    /** Última frecuencia avisada a la página; -1 = la página no la ha pedido (sin pacerStart). */
+    static int& PublishedRate() { static int hz = -1; return hz; }
+
+    /**
+     * Avisa a la página ("pacerHz", frecuencia) si la frecuencia efectiva cambió: escena, reposo,
+     * ventana minimizada o fpsLimit (FramePacer::SetOnChange). Solo desde el hilo de UI.
+     */
+    static void PublishRate() {
+        if (PublishedRate() < 0) return;
+        int hz = (int)Pacer().Rate();
+        if (hz == PublishedRate()) return;
+        PublishedRate() = hz;
+        Executor().Emit(L"pacerHz", std::to_wstring(hz));
+    }
+
+    /**
+     * La página limita su bucle de requestAnimationFrame a la frecuencia efectiva; desde aquí se
+     * le avisa de cada cambio ("pacerHz"). Respuesta: frecuencia actual (0 = en pausa).
+     */
+    static bool OnPacerStart(BridgeContext&, const RpcRequest&, std::wstring& out) {
+        PublishedRate() = (int)Pacer().Rate();
+        out = std::to_wstring(PublishedRate());
+        return true;
+    }
+
+    static bool OnPacerStop(BridgeContext&, const RpcRequest&, std::wstring&) {
+        PublishedRate() = -1;
+        return true;
+    }
+
+    /** Payload: clave de la escena que se está mostrando. */
+    static bool OnPacerScene(BridgeContext&, const RpcRequest& req, std::wstring&) {
+        Pacer().SetScene(Utils::ToString(req.payload));
+        return true;
+    }
+
+    /** Payload: "escena|hz". Sin escena cambia la base (fpsLimit); hz 0 quita el ajuste de la escena. */
+    static bool OnPacerRate(BridgeContext&, const RpcRequest& req, std::wstring& out) {
+        std::wstring_view rest = req.payload;
+        std::wstring_view scene = RpcCodec::NextToken(rest);
+        double hz = RpcCodec::ParseDouble(RpcCodec::NextToken(rest), -1);
+        if (hz < 0 || (scene.empty() && hz == 0)) { out = L"invalid rate"; return false; }
+        if (scene.empty()) Pacer().SetRate(hz);
+        else Pacer().SetSceneRate(Utils::ToString(scene), hz);
+        out = std::to_wstring((int)Pacer().Rate());
+        return true;
+    }
+
+    /** Payload: "1" sin entrada del usuario (baja a fpsIdle), "0" al volver. */
+    static bool OnPacerIdle(BridgeContext&, const RpcRequest& req, std::wstring&) {
+        Pacer().SetIdle(req.payload == L"1");
+        return true;
+    }
+
+    /** Respuesta: JSON con la frecuencia efectiva; los tiempos de los frames los mide la página. */
+    static bool OnPacerStats(BridgeContext&, const RpcRequest&, std::wstring& out) {
+        out = PublishedRate() >= 0 ? L"{\"running\":true,\"hz\":" : L"{\"running\":false,\"hz\":";
+        RpcCodec::AppendDouble(out, Pacer().Rate());
+        out += L'}';
+        return true;
+    }
+
+    /** Payload: ids separados por comas de llamadas cuyo resultado ya no interesa. */
+    static bool OnCancel(BridgeContext&, const RpcRequest& req, std::wstring&) {
+        std::wstring_view rest = req.payload;
+        while (!rest.empty()) Executor().Cancel((uint32_t)RpcCodec::ParseInt(RpcCodec::NextToken(rest, L',')));
+        return true;
+    }
+
+    static bool OnDiscord(BridgeContext&, const RpcRequest& req, std::wstring&) {
+        std::wstring_view data = req.payload;
+        size_t p = data.find(L'|');
+        std::string state = Utils::ToString(data.substr(0, p));
+        std::string details = (p != std::wstring_view::npos) ? Utils::ToString(data.substr(p + 1)) : "";
+        DiscordClient::Get().SetActivity(details, state, "fnf_icon", "Genesis Engine");
+        return true;
     }
 };
\ No newline at end of file
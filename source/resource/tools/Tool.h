@@ -0,0 +1,67 @@
+#pragma once
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+/**
+ * @namespace Tool
+ * @description Lo que comparten las herramientas de source/resource/tools: el recuento de
+ * comprobaciones de --verify, la medida de tiempos y los archivos de los árboles sintéticos.
+ * Las herramientas son portables: compilan con MSVC (compile.bat) o con cualquier compilador C++17.
+ *
+ * --verify devuelve 0 si todas las comprobaciones pasan y 1 si alguna falla, que es lo que
+ * espera CTest (ver add_test en CMakeLists.txt).
+ */
+namespace Tool {
+
+    using Clock = std::chrono::steady_clock;
+
+    /** Comprobaciones fallidas en esta ejecución. */
+    inline int failures = 0;
+
+    /** Imprime "[ OK ] qué" o "[FAIL] qué" y cuenta el fallo. */
+    inline void Check(bool ok, const char* what) {
+        std::printf("  [%s] %s\n", ok ? " OK " : "FAIL", what);
+        if (!ok) failures++;
+    }
+
+    inline double Ms(Clock::duration d) { return std::chrono::duration<double, std::milli>(d).count(); }
+    inline double Seconds(Clock::duration d) { return std::chrono::duration<double>(d).count(); }
+
+    /** Escribe (o reemplaza) un archivo creando sus carpetas. */
+    inline void WriteFile(const std::filesystem::path& p, const std::string& data) {
+        std::filesystem::create_directories(p.parent_path());
+        std::ofstream f(p, std::ios::binary | std::ios::trunc);
+        f.write(data.data(), (std::streamsize)data.size());
+    }
+
+    /**
+     * Raíz del proyecto (la carpeta que contiene public/) a partir del argumento de --verify o --bench:
+     * vale la raíz, public/ o cualquier carpeta dentro de public/ (public/songs...); vacío = directorio actual.
+     * Si no es ninguna de esas, imprime el error y devuelve una ruta vacía (el llamador sale con 2).
+     */
+    inline std::filesystem::path ProjectRoot(const std::string& arg, const char* tool) {
+        namespace fs = std::filesystem;
+        std::error_code ec;
+        fs::path dir = fs::weakly_canonical(fs::u8path(arg.empty() ? "." : arg), ec);
+        if (!ec && fs::is_directory(dir, ec)) {
+            if (fs::is_directory(dir / "public", ec)) return dir;
+            for (fs::path d = dir; d.has_relative_path(); d = d.parent_path()) {
+                if (d.filename() == "public") return d.parent_path();
+            }
+        }
+        std::fprintf(stderr, "%s: '%s' no es la raíz del proyecto (la carpeta que contiene public/) ni una carpeta dentro de public/\n",
+                     tool, arg.c_str());
+        return {};
+    }
+
+    /** Carpeta nueva en el directorio temporal: "<prefijo>-<reloj>". El llamador la borra. */
+    inline std::filesystem::path MakeTempDir(const std::string& prefix) {
+        std::error_code ec;
+        std::filesystem::path dir = std::filesystem::temp_directory_path(ec) / (prefix + "-" + std::to_string(std::chrono::system_clock::now().time_since_epoch().count()));
+        std::filesystem::create_directories(dir, ec);
+        return dir;
+    }
+}
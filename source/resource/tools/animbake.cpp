@@ -0,0 +1,449 @@
+/**
+ * animbake - Horneado de líneas de tiempo de Adobe Animate.
+ * Convierte los Animation.json de los texture atlas en tablas .ganm (ver core/Animate.h): para cada
+ * frame, los sprites a dibujar con su matriz y su color finales, sin símbolos que resolver.
+ *
+ * Uso:
+ *   animbake <Animation.json> [salida.ganm]
+ *   animbake --dir <carpeta> [--force]          Hornea todos los Animation.json de dentro y escribe
+ *                                               <carpeta>/animations.json con la lista (la lee
+ *                                               funkin/API/animateLoader.js)
+ *   animbake --verify [carpeta|archivo]         Casos sintéticos (bucles, FF, clips, color, STI,
+ *                                               ciclos) y, con ruta, cada frame horneado contra la
+ *                                               evaluación directa del JSON
+ *   animbake --bench <carpeta> [iteraciones]    Frames resueltos por segundo: JSON, horneado y tabla
+ */
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "../core/Animate.h"
+#include "../core/AtomicFile.h"
+#include "Tool.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+    using namespace Tool;
+
+    /**
+     * Evaluación de referencia: recorre el JSON tal cual en cada frame, como haría un reproductor
+     * sin hornear (búsqueda lineal de keyframes, símbolos por nombre, todo en doble precisión).
+     */
+    class Reference {
+    public:
+        struct Draw {
+            std::string sprite;
+            Animate::Matrix m;
+            Animate::Color color;
+        };
+
+        bool Open(std::string_view text, std::string& err) {
+            if (!Json::Parse(text, doc, &err)) return false;
+            for (const auto& s : doc["SD"]["S"].Items()) symbols[s["SN"].Str()] = &s["TL"];
+            return true;
+        }
+
+        uint32_t Length() const { return Length(doc["AN"]["TL"]); }
+
+        std::vector<Draw> Frame(uint32_t frame) const {
+            std::vector<Draw> out;
+            Animate::Matrix m;
+            Animate::Color color;
+            if (const Json::Value& sti = doc["AN"]["STI"]["SI"]; sti.IsObject()) {
+                m = Animate::Detail::ReadMatrix(sti["M3D"]);
+                if (sti["C"].IsObject()) color = Animate::Detail::ReadColor(sti["C"]);
+            }
+            Walk(doc["AN"]["TL"], frame, m, color, 0, out);
+            return out;
+        }
+
+    private:
+        Json::Value doc;
+        std::unordered_map<std::string, const Json::Value*> symbols;
+
+        static uint32_t Length(const Json::Value& tl) {
+            int n = 0;
+            for (const auto& l : tl["L"].Items()) for (const auto& fr : l["FR"].Items()) n = std::max(n, fr["I"].Int() + fr["DU"].Int());
+            return (uint32_t)n;
+        }
+
+        void Walk(const Json::Value& tl, uint32_t frame, const Animate::Matrix& m, const Animate::Color& color, int depth, std::vector<Draw>& out) const {
+            if (depth > Animate::kMaxDepth) return;
+            const auto& layers = tl["L"].Items();
+            for (size_t li = layers.size(); li-- > 0;) {
+                for (const auto& fr : layers[li]["FR"].Items()) {
+                    int start = fr["I"].Int(), dur = fr["DU"].Int();
+                    if ((int)frame < start || (int)frame >= start + dur) continue;
+                    for (const auto& e : fr["E"].Items()) {
+                        if (e["ASI"].IsObject()) {
+                            out.push_back({ e["ASI"]["N"].Str(), m.Then(Animate::Detail::ReadMatrix(e["ASI"]["M3D"])), color });
+                            continue;
+                        }
+                        const Json::Value& si = e["SI"];
+                        auto it = symbols.find(si["SN"].Str());
+                        if (it == symbols.end()) continue;
+                        int len = (int)Length(*it->second);
+                        if (len == 0) continue;
+                        int local = (int)frame - start, ff = si["FF"].Int(), child;
+                        const std::string& lp = si["LP"].Str();
+                        if (si["ST"].Str() == "MC") child = local % len;
+                        else if (lp == "PO") child = std::min(ff + local, len - 1);
+                        else if (lp == "SF") child = std::min(ff, len - 1);
+                        else child = (ff + local) % len;
+                        Animate::Color c = si["C"].IsObject() ? color.Then(Animate::Detail::ReadColor(si["C"])) : color;
+                        Walk(*it->second, (uint32_t)child, m.Then(Animate::Detail::ReadMatrix(si["M3D"])), c, depth + 1, out);
+                    }
+                    break;
+                }
+            }
+        }
+    };
+
+    bool Near(double a, double b, double tol) { return std::fabs(a - b) <= tol * (1 + std::fabs(b)); }
+
+    /**
+     * Cada frame de la tabla contra la referencia: mismos sprites en el mismo orden, matrices a
+     * precisión de float y colores iguales.
+     */
+    bool Compare(const Reference& ref, const Animate::View& v, std::string& err, double* worstPx = nullptr) {
+        if (v.FrameCount() != ref.Length()) { err = "frame count " + std::to_string(v.FrameCount()) + " != " + std::to_string(ref.Length()); return false; }
+        double worst = 0;
+        for (uint32_t f = 0; f < v.FrameCount(); f++) {
+            auto want = ref.Frame(f);
+            Animate::List l = v.FrameList(f);
+            if (l.count != want.size()) { err = "frame " + std::to_string(f) + ": " + std::to_string(l.count) + " draws, expected " + std::to_string(want.size()); return false; }
+            for (uint32_t i = 0; i < l.count; i++) {
+                Animate::PackedDraw d = v.GetDraw(l.first + i);
+                const auto& w = want[i];
+                std::string where = "frame " + std::to_string(f) + " draw " + std::to_string(i);
+                if (v.SpriteName(d.sprite) != w.sprite) { err = where + ": sprite " + std::string(v.SpriteName(d.sprite)) + " != " + w.sprite; return false; }
+                if (!Near(d.a, w.m.a, 1e-5) || !Near(d.b, w.m.b, 1e-5) || !Near(d.c, w.m.c, 1e-5) || !Near(d.d, w.m.d, 1e-5)
+                    || !Near(d.tx, w.m.tx, 1e-6) || !Near(d.ty, w.m.ty, 1e-6)) { err = where + ": matrix"; return false; }
+                worst = std::max({ worst, std::fabs(d.tx - w.m.tx), std::fabs(d.ty - w.m.ty) });
+                Animate::Color c = v.GetColor(d.color);
+                for (int k = 0; k < 4; k++) {
+                    if (!Near(c.mul[k], w.color.mul[k], 1e-6) || !Near(c.off[k], w.color.off[k], 1e-6)) { err = where + ": color"; return false; }
+                }
+            }
+        }
+        if (worstPx) *worstPx = worst;
+        return true;
+    }
+
+    bool BakeText(const std::string& text, Animate::Document& doc, Animate::Table& t, std::string& bin, std::string& err) {
+        return Animate::Parse(text, doc, &err) && Animate::Bake(doc, t, &err) && Animate::Write(t, bin, &err);
+    }
+
+    // --- Casos sintéticos ---
+
+    /** Un keyframe con un solo elemento, en JSON. */
+    std::string Key(int start, int dur, const std::string& element) {
+        return "{\"I\":" + std::to_string(start) + ",\"DU\":" + std::to_string(dur) + ",\"E\":[" + element + "]}";
+    }
+
+    std::string Sprite(const std::string& name, double tx, double ty) {
+        return "{\"ASI\":{\"N\":\"" + name + "\",\"M3D\":[1,0,0,0,0,1,0,0,0,0,1,0," + std::to_string(tx) + "," + std::to_string(ty) + ",0,1]}}";
+    }
+
+    std::string Instance(const std::string& symbol, const std::string& type, const std::string& loop, int ff,
+        double a, double b, double c, double d, double tx, double ty, const std::string& color = std::string()) {
+        std::string s = "{\"SI\":{\"SN\":\"" + symbol + "\",\"IN\":\"\",\"ST\":\"" + type + "\"";
+        if (type != "MC") s += ",\"FF\":" + std::to_string(ff) + ",\"LP\":\"" + loop + "\"";
+        s += ",\"TRP\":{\"x\":0,\"y\":0},\"M3D\":[" + std::to_string(a) + "," + std::to_string(b) + ",0,0," + std::to_string(c) + ","
+            + std::to_string(d) + ",0,0,0,0,1,0," + std::to_string(tx) + "," + std::to_string(ty) + ",0,1]";
+        if (!color.empty()) s += ",\"C\":" + color;
+        return s + "}}";
+    }
+
+    /**
+     * "count": 4 frames; el frame k muestra el sprite "dk" en (k, 0).
+     * "pair": dos capas; la de arriba ("top") tapa a "count" desplazado.
+     */
+    std::string SyntheticDoc(const std::string& mainLayers, const std::string& sti = std::string()) {
+        std::string count = "{\"SN\":\"count\",\"TL\":{\"L\":[{\"LN\":\"a\",\"FR\":[";
+        for (int k = 0; k < 4; k++) count += (k ? "," : "") + Key(k, 1, Sprite("d" + std::to_string(k), k, 0));
+        count += "]}]}}";
+        std::string pair = "{\"SN\":\"pair\",\"TL\":{\"L\":[{\"LN\":\"top\",\"FR\":[" + Key(0, 2, Sprite("top", 0, 0)) + "]},"
+            "{\"LN\":\"bottom\",\"FR\":[" + Key(0, 2, Instance("count", "G", "LP", 1, 1, 0, 0, 1, 100, 0)) + "]}]}}";
+        std::string loopA = "{\"SN\":\"loopA\",\"TL\":{\"L\":[{\"LN\":\"x\",\"FR\":[" + Key(0, 1, Instance("loopB", "G", "LP", 0, 1, 0, 0, 1, 0, 0)) + "]}]}}";
+        std::string loopB = "{\"SN\":\"loopB\",\"TL\":{\"L\":[{\"LN\":\"x\",\"FR\":[" + Key(0, 1, Instance("loopA", "G", "LP", 0, 1, 0, 0, 1, 0, 0)) + "]}]}}";
+        return "{\"AN\":{\"N\":\"t\",\"SN\":\"main\"" + (sti.empty() ? std::string() : ",\"STI\":" + sti) + ",\"TL\":{\"L\":[" + mainLayers + "]}},"
+            "\"SD\":{\"S\":[" + count + "," + pair + "," + loopA + "," + loopB + "]},\"MD\":{\"FRT\":30}}";
+    }
+
+    /** Hornea y devuelve, por frame, "sprite@tx,ty" separados por espacios. */
+    std::vector<std::string> BakeFrames(const std::string& json, std::string* failed = nullptr, Animate::Table* table = nullptr) {
+        Animate::Document doc;
+        Animate::Table t;
+        std::string bin, err;
+        std::vector<std::string> out;
+        if (!BakeText(json, doc, t, bin, err)) { if (failed) *failed = err; return out; }
+        Animate::View v;
+        if (!v.Open(bin.data(), bin.size(), &err)) { if (failed) *failed = err; return out; }
+        for (uint32_t f = 0; f < v.FrameCount(); f++) {
+            std::string s;
+            Animate::List l = v.FrameList(f);
+            for (uint32_t i = 0; i < l.count; i++) {
+                Animate::PackedDraw d = v.GetDraw(l.first + i);
+                char buf[96];
+                std::snprintf(buf, sizeof(buf), "%s%s@%g,%g", s.empty() ? "" : " ", std::string(v.SpriteName(d.sprite)).c_str(), d.tx, d.ty);
+                s += buf;
+            }
+            out.push_back(s);
+        }
+        if (table) *table = t;
+        return out;
+    }
+
+    std::string Join(const std::vector<std::string>& v) {
+        std::string s;
+        for (const auto& x : v) s += "[" + x + "]";
+        return s;
+    }
+
+    void VerifySynthetic() {
+        std::printf("casos sintéticos\n");
+        auto layer = [](const std::string& keys) { return "{\"LN\":\"l\",\"FR\":[" + keys + "]}"; };
+        auto expect = [](const std::vector<std::string>& got, const std::string& want, const char* what) {
+            bool ok = Join(got) == want;
+            Check(ok, what);
+            if (!ok) std::printf("         %s\n         esperado %s\n", Join(got).c_str(), want.c_str());
+        };
+
+        expect(BakeFrames(SyntheticDoc(layer(Key(0, 6, Instance("count", "G", "LP", 2, 1, 0, 0, 1, 0, 0))))),
+            "[d2@2,0][d3@3,0][d0@0,0][d1@1,0][d2@2,0][d3@3,0]", "gráfico en bucle desde FF 2");
+        expect(BakeFrames(SyntheticDoc(layer(Key(0, 5, Instance("count", "G", "PO", 1, 1, 0, 0, 1, 0, 0))))),
+            "[d1@1,0][d2@2,0][d3@3,0][d3@3,0][d3@3,0]", "una vez (PO): se queda en el último");
+        expect(BakeFrames(SyntheticDoc(layer(Key(0, 3, Instance("count", "G", "SF", 3, 1, 0, 0, 1, 0, 0))))),
+            "[d3@3,0][d3@3,0][d3@3,0]", "frame fijo (SF)");
+        expect(BakeFrames(SyntheticDoc(layer(Key(0, 2, Sprite("x", 0, 0)) + "," + Key(2, 5, Instance("count", "MC", "", 0, 1, 0, 0, 1, 0, 0))))),
+            "[x@0,0][x@0,0][d0@0,0][d1@1,0][d2@2,0][d3@3,0][d0@0,0]", "clip: bucle desde 0 al empezar su keyframe");
+        expect(BakeFrames(SyntheticDoc(layer(Key(0, 1, Instance("pair", "G", "LP", 0, 2, 0, 0, 2, 10, 20))))),
+            "[d1@212,20 top@10,20]", "capas de abajo arriba y matrices compuestas (escala 2 + traslación)");
+        expect(BakeFrames(SyntheticDoc(layer(Key(0, 1, Instance("count", "G", "SF", 1, 0, 1, -1, 0, 5, 0))))),
+            "[d1@5,1]", "rotación de 90 grados");
+        expect(BakeFrames(SyntheticDoc(layer(Key(0, 1, Sprite("a", 0, 0))) + "," + layer(Key(1, 1, Sprite("b", 0, 0))))),
+            "[a@0,0][b@0,0]", "frames con capas vacías");
+        expect(BakeFrames(SyntheticDoc(layer(Key(0, 1, Sprite("a", 0, 0))),
+            "{\"SI\":{\"SN\":\"main\",\"ST\":\"G\",\"M3D\":[1,0,0,0,0,1,0,0,0,0,1,0,960,540,0,1]}}")),
+            "[a@960,540]", "instancia de escena (STI)");
+
+        Animate::Table t;
+        BakeFrames(SyntheticDoc(layer(Key(0, 1, Instance("count", "G", "SF", 0, 1, 0, 0, 1, 0, 0,
+            "{\"M\":\"T\",\"TC\":\"#FF8000\",\"TM\":0.5}"))) + "," + layer(Key(0, 1, Instance("count", "G", "SF", 1, 1, 0, 0, 1, 0, 0,
+            "{\"M\":\"CA\",\"AM\":0.25}")))), nullptr, &t);
+        bool tint = false, alpha = false;
+        for (const auto& c : t.colors) {
+            tint |= c.mul[0] == 0.5f && c.off[0] == 127.5f && c.off[1] == 64.0f && c.off[2] == 0.0f && c.mul[3] == 1.0f;
+            alpha |= c.mul[0] == 1.0f && c.mul[3] == 0.25f && c.off[3] == 0.0f;
+        }
+        Check(t.colors.size() == 3 && tint && alpha, "tinte y alfa en la tabla de colores (la 0 es la identidad)");
+
+        std::string err;
+        BakeFrames(SyntheticDoc(layer(Key(0, 1, Instance("loopA", "G", "LP", 0, 1, 0, 0, 1, 0, 0)))), &err);
+        Check(!err.empty(), "símbolos que se contienen a sí mismos: error en vez de colgarse");
+
+        auto frames = BakeFrames(SyntheticDoc(layer(Key(0, 40, Sprite("a", 0, 0)) + "," + Key(40, 1, Sprite("b", 0, 0)))), nullptr, &t);
+        Check(frames.size() == 41 && t.lists.size() == 2 && t.draws.size() == 2, "frames iguales comparten lista");
+
+        Animate::Document doc;
+        Animate::Table labelled;
+        std::string bin;
+        std::string json = SyntheticDoc("{\"LN\":\"labels\",\"FR\":[{\"I\":0,\"DU\":3,\"N\":\"intro\",\"E\":[]},{\"I\":3,\"DU\":2,\"N\":\"loop\",\"E\":[]}]},"
+            + layer(Key(0, 5, Sprite("a", 0, 0))));
+        Animate::View v;
+        bool ok = BakeText(json, doc, labelled, bin, err) && v.Open(bin.data(), bin.size());
+        int64_t loop = ok ? v.FindLabel("loop") : -1;
+        Check(ok && v.LabelCount() == 2 && loop == 1 && v.GetLabel(1).first == 3 && v.GetLabel(1).count == 2 && v.FindLabel("nope") < 0 && v.Fps() == 30,
+            "etiquetas de la línea principal y fps");
+
+        bool rejects = !v.Open(bin.data(), bin.size() - 1) && !v.Open("GATL", 4);
+        std::string corrupt = bin;
+        corrupt[Animate::kHeaderSize] = (char)0x7F;   // Lista del frame 0 fuera de rango
+        rejects &= !v.Open(corrupt.data(), corrupt.size());
+        Check(rejects, "rechaza binarios truncados o corruptos");
+    }
+
+    std::vector<fs::path> Collect(const fs::path& dir) {
+        std::vector<fs::path> files;
+        std::error_code ec;
+        for (auto it = fs::recursive_directory_iterator(dir, ec); !ec && it != fs::recursive_directory_iterator(); it.increment(ec)) {
+            if (it->is_regular_file(ec) && it->path().filename() == "Animation.json") files.push_back(it->path());
+        }
+        std::sort(files.begin(), files.end());
+        return files;
+    }
+
+    /**
+     * Hornea cada archivo y compara todos sus frames con la referencia.
+     */
+    void VerifyFiles(const fs::path& target) {
+        std::error_code ec;
+        std::vector<fs::path> files = fs::is_directory(target, ec) ? Collect(target) : std::vector<fs::path>{ target };
+        std::printf("%s\n", target.u8string().c_str());
+        std::printf("  %-26s %7s %7s %8s %9s %10s %12s\n", "archivo", "frames", "listas", "dibujos", "JSON KB", "ganm KB", "máx px");
+        size_t ok = 0;
+        for (const auto& in : files) {
+            std::string text, bin, err;
+            Animate::Document doc;
+            Animate::Table t, back;
+            Reference ref;
+            Animate::View v;
+            double worst = 0;
+            std::string name = in.parent_path().filename().u8string();
+            bool good = AtomicFile::ReadAll(in, text) && BakeText(text, doc, t, bin, err) && Animate::Read(bin.data(), bin.size(), back, &err)
+                && v.Open(bin.data(), bin.size(), &err) && ref.Open(text, err) && Compare(ref, v, err, &worst);
+            if (good && (back.frames != t.frames || back.draws.size() != t.draws.size() || back.sprites != t.sprites || back.colors.size() != t.colors.size()
+                || std::memcmp(back.draws.data(), t.draws.data(), t.draws.size() * sizeof(Animate::PackedDraw)) != 0)) {
+                good = false;
+                err = "round trip mismatch";
+            }
+            if (!good) { std::printf("  %-26s FAIL: %s\n", name.c_str(), err.c_str()); failures++; continue; }
+            ok++;
+            std::printf("  %-26s %7zu %7zu %8zu %9.1f %10.1f %12.6f\n", name.c_str(), t.frames.size(), t.lists.size(), t.draws.size(),
+                text.size() / 1024.0, bin.size() / 1024.0, worst);
+        }
+        Check(ok == files.size() && !files.empty(), "cada frame horneado = evaluación directa del JSON (sprites, matrices, colores)");
+    }
+
+    int Verify(const fs::path& target) {
+        VerifySynthetic();
+        if (!target.empty()) VerifyFiles(target);
+        std::printf(failures ? "\n%d fallos\n" : "\ntodo OK\n", failures);
+        return failures ? 1 : 0;
+    }
+
+    int Bench(const fs::path& dir, int iterations) {
+        using Clock = std::chrono::steady_clock;
+        auto ms = [](Clock::duration d) { return std::chrono::duration<double, std::milli>(d).count(); };
+        auto files = Collect(dir);
+        if (files.empty()) { std::fprintf(stderr, "animbake: no hay Animation.json en %s\n", dir.u8string().c_str()); return 1; }
+        std::printf("animbake bench: %zu archivos, %d iteraciones (frames resueltos por segundo)\n", files.size(), iterations);
+        std::printf("  %-26s %7s %12s %12s %12s %10s\n", "archivo", "frames", "JSON", "horneado", "tabla", "hornear ms");
+        double sink = 0;
+        double totalFrames = 0, totalRef = 0, totalView = 0;
+        for (const auto& in : files) {
+            std::string text, bin, err;
+            Animate::Document doc;
+            Animate::Table t;
+            Reference ref;
+            if (!AtomicFile::ReadAll(in, text) || !ref.Open(text, err) || !BakeText(text, doc, t, bin, err)) continue;
+            uint32_t frames = (uint32_t)t.frames.size();
+
+            // Referencia: el árbol recorrido en cada frame (JSON ya parseado)
+            auto t0 = Clock::now();
+            for (int n = 0; n < iterations; n++) for (uint32_t f = 0; f < frames; f++) sink += ref.Frame(f).size();
+            double refMs = ms(Clock::now() - t0);
+
+            // Hornear entero desde el documento ya indexado (Baker con memoria)
+            t0 = Clock::now();
+            for (int n = 0; n < iterations; n++) { Animate::Table tt; Animate::Bake(doc, tt); sink += tt.draws.size(); }
+            double bakeMs = ms(Clock::now() - t0) / iterations;
+
+            // Tabla: buscar el frame y leer sus dibujos
+            Animate::View v;
+            v.Open(bin.data(), bin.size());
+            t0 = Clock::now();
+            for (int n = 0; n < iterations * 20; n++) {
+                for (uint32_t f = 0; f < frames; f++) {
+                    Animate::List l = v.FrameList(f);
+                    for (uint32_t i = 0; i < l.count; i++) { Animate::PackedDraw d = v.GetDraw(l.first + i); sink += d.tx; }
+                }
+            }
+            double viewMs = ms(Clock::now() - t0) / 20;
+
+            double fr = (double)frames * iterations;
+            totalFrames += fr; totalRef += refMs; totalView += viewMs;
+            std::printf("  %-26s %7u %12.0f %12.0f %12.0f %10.2f\n", in.parent_path().filename().u8string().c_str(), frames,
+                fr / (refMs / 1000.0), frames / (bakeMs / 1000.0), fr / (viewMs / 1000.0), bakeMs);
+        }
+        std::printf("  total: JSON %.0f frames/s, tabla %.0f frames/s (%.0fx)\n", totalFrames / (totalRef / 1000.0), totalFrames / (totalView / 1000.0),
+            totalView > 0 ? totalRef / totalView : 0.0);
+        return sink != 0 ? 0 : 1;
+    }
+
+    fs::path OutputOf(const fs::path& in) { fs::path out = in; return out.replace_extension(".ganm"); }
+
+    bool IsUpToDate(const fs::path& in, const fs::path& out) {
+        std::error_code ec;
+        auto tin = fs::last_write_time(in, ec);
+        if (ec) return false;
+        auto tout = fs::last_write_time(out, ec);
+        return !ec && tout >= tin;
+    }
+
+    /**
+     * Hornea un Animation.json.
+     * @returns {int} 0 = escrito, 1 = error, 2 = ya estaba al día.
+     */
+    int BakeOne(const fs::path& in, const fs::path& out, bool force) {
+        if (!force && IsUpToDate(in, out)) return 2;
+        std::string text, bin, err;
+        Animate::Document doc;
+        Animate::Table t;
+        if (!AtomicFile::ReadAll(in, text)) err = "cannot read";
+        if (!err.empty() || !BakeText(text, doc, t, bin, err) || !AtomicFile::Write(out, bin, err)) {
+            std::fprintf(stderr, "[ERROR] %s: %s\n", in.u8string().c_str(), err.c_str());
+            return 1;
+        }
+        if (doc.missing) std::fprintf(stderr, "[AVISO] %s: %zu instancias de símbolos que no existen\n", in.u8string().c_str(), doc.missing);
+        return 0;
+    }
+
+    int BakeDir(const fs::path& dir, bool force) {
+        size_t written = 0, skipped = 0, failed = 0;
+        std::string manifest = "{\"version\":1,\"animations\":[";
+        bool first = true;
+        for (const auto& in : Collect(dir)) {
+            int r = BakeOne(in, OutputOf(in), force);
+            if (r == 1) { failed++; continue; }
+            (r == 0 ? written : skipped)++;
+            if (!first) manifest += ',';
+            first = false;
+            Json::AppendString(manifest, in.lexically_relative(dir).generic_u8string());
+        }
+        manifest += "]}";
+        std::string err;
+        if (!AtomicFile::Write(dir / "animations.json", manifest, err)) {
+            std::fprintf(stderr, "[ERROR] animations.json: %s\n", err.c_str());
+            return 1;
+        }
+        std::printf("animbake: %zu horneados, %zu al dia, %zu con error\n", written, skipped, failed);
+        return failed ? 1 : 0;
+    }
+
+    void Usage() {
+        std::fprintf(stderr,
+            "Uso:\n"
+            "  animbake <Animation.json> [salida.ganm]\n"
+            "  animbake --dir <carpeta> [--force]\n"
+            "  animbake --verify [carpeta|archivo]\n"
+            "  animbake --bench <carpeta> [iteraciones]\n");
+    }
+
+    int Run(const std::vector<fs::path>& args) {
+        if (args.empty()) { Usage(); return 1; }
+        std::string cmd = args[0].u8string();
+        if (cmd == "--dir" && args.size() >= 2) return BakeDir(args[1], args.size() >= 3 && args[2] == "--force");
+        if (cmd == "--verify") return Verify(args.size() >= 2 ? args[1] : fs::path());
+        if (cmd == "--bench" && args.size() >= 2) {
+            int iterations = args.size() >= 3 ? std::max(1, std::atoi(args[2].u8string().c_str())) : 5;
+            return Bench(args[1], iterations);
+        }
+        if (cmd.rfind("--", 0) == 0) { Usage(); return 1; }
+        return BakeOne(args[0], args.size() >= 2 ? args[1] : OutputOf(args[0]), true) == 1 ? 1 : 0;
+    }
+}
+
+#ifdef _WIN32
+int wmain(int argc, wchar_t** argv) { return Run(std::vector<fs::path>(argv + 1, argv + argc)); }
+#else
+int main(int argc, char** argv) { return Run(std::vector<fs::path>(argv + 1, argv + argc)); }
+#endif
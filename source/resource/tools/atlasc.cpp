@@ -0,0 +1,228 @@
+/**
+ * atlasc - Compilador de atlas.
+ * Convierte los Sparrow .xml y los spritemap*.json de Adobe Animate en tablas binarias .gatl
+ * (ver core/Atlas.h) que la página carga sin parsear texto.
+ *
+ * Uso:
+ *   atlasc <atlas.xml|spritemap.json> [salida.gatl]
+ *   atlasc --dir <carpeta> [--force] [--verify]   Compila todo lo que haya dentro y escribe
+ *                                                 <carpeta>/atlases.json con la lista
+ *   atlasc --verify <carpeta|archivo>             Ida y vuelta texto -> binario -> tabla
+ *   atlasc --bench <carpeta> [iteraciones]        Compara el parseo de texto con el binario
+ */
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include "../core/Atlas.h"
+#include "../core/AtomicFile.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+    enum class Kind { None, Sparrow, Spritemap };
+
+    Kind KindOf(const fs::path& p) {
+        std::string ext = p.extension().u8string();
+        for (auto& c : ext) c = (char)std::tolower((unsigned char)c);
+        if (ext == ".xml") return Kind::Sparrow;
+        if (ext == ".json" && p.stem().u8string().rfind("spritemap", 0) == 0) return Kind::Spritemap;
+        return Kind::None;
+    }
+
+    bool ParseText(const fs::path& path, Atlas::Table& out, std::string& err) {
+        std::string text;
+        if (!AtomicFile::ReadAll(path, text)) { err = "cannot read"; return false; }
+        return KindOf(path) == Kind::Spritemap ? Atlas::ParseSpritemap(text, out, &err) : Atlas::ParseSparrow(text, out, &err);
+    }
+
+    bool SameFrame(const Atlas::Frame& a, const Atlas::Frame& b) {
+        return a.name == b.name && a.x == b.x && a.y == b.y && a.w == b.w && a.h == b.h && a.frameX == b.frameX
+            && a.frameY == b.frameY && a.frameW == b.frameW && a.frameH == b.frameH && a.rotated == b.rotated
+            && a.trimmed == b.trimmed && a.anim == b.anim;
+    }
+
+    /**
+     * Comprueba que el binario reproduce la tabla y que la búsqueda por hash encuentra cada frame.
+     */
+    bool Verify(const Atlas::Table& t, const std::string& bin, std::string& err) {
+        Atlas::Table back;
+        if (!Atlas::Read(bin.data(), bin.size(), back, &err)) return false;
+        if (back.image != t.image) { err = "image mismatch"; return false; }
+        if (back.frames.size() != t.frames.size() || back.anims.size() != t.anims.size()) { err = "count mismatch"; return false; }
+        for (size_t i = 0; i < t.frames.size(); i++) {
+            if (!SameFrame(back.frames[i], t.frames[i])) { err = "frame mismatch: " + t.frames[i].name; return false; }
+        }
+        for (size_t i = 0; i < t.anims.size(); i++) {
+            const Atlas::Anim& a = t.anims[i];
+            const Atlas::Anim& b = back.anims[i];
+            if (a.prefix != b.prefix || a.first != b.first || a.count != b.count) { err = "animation mismatch: " + a.prefix; return false; }
+        }
+        Atlas::View view;
+        view.Open(bin.data(), bin.size());
+        for (size_t i = 0; i < t.frames.size(); i++) {
+            int64_t found = view.Find(t.frames[i].name);
+            if (found < 0 || view.FrameName((uint32_t)found) != t.frames[i].name) { err = "lookup failed: " + t.frames[i].name; return false; }
+        }
+        if (view.Find("\x01missing") >= 0) { err = "lookup false positive"; return false; }
+        return true;
+    }
+
+    fs::path OutputOf(const fs::path& in) { fs::path out = in; return out.replace_extension(".gatl"); }
+
+    bool IsUpToDate(const fs::path& in, const fs::path& out) {
+        std::error_code ec;
+        auto tin = fs::last_write_time(in, ec);
+        if (ec) return false;
+        auto tout = fs::last_write_time(out, ec);
+        return !ec && tout >= tin;
+    }
+
+    /**
+     * Compila un atlas.
+     * @returns {int} 0 = escrito, 1 = error, 2 = ya estaba al día.
+     */
+    int CompileOne(const fs::path& in, const fs::path& out, bool force, bool verify) {
+        if (!force && IsUpToDate(in, out)) return 2;
+        Atlas::Table t;
+        std::string err, bin;
+        if (!ParseText(in, t, err) || !Atlas::Write(t, bin, &err) || (verify && !Verify(t, bin, err))
+            || !AtomicFile::Write(out, bin, err)) {
+            std::fprintf(stderr, "[ERROR] %s: %s\n", in.u8string().c_str(), err.c_str());
+            return 1;
+        }
+        return 0;
+    }
+
+    std::vector<fs::path> Collect(const fs::path& dir) {
+        std::vector<fs::path> files;
+        std::error_code ec;
+        for (auto it = fs::recursive_directory_iterator(dir, ec); !ec && it != fs::recursive_directory_iterator(); it.increment(ec)) {
+            if (it->is_regular_file(ec) && KindOf(it->path()) != Kind::None) files.push_back(it->path());
+        }
+        std::sort(files.begin(), files.end());
+        return files;
+    }
+
+    int CompileDir(const fs::path& dir, bool force, bool verify) {
+        size_t written = 0, skipped = 0, failed = 0;
+        std::string manifest = "{\"version\":1,\"atlases\":[";
+        bool first = true;
+        for (const auto& in : Collect(dir)) {
+            int r = CompileOne(in, OutputOf(in), force, verify);
+            if (r == 1) { failed++; continue; }
+            (r == 0 ? written : skipped)++;
+            if (!first) manifest += ',';
+            first = false;
+            std::string rel = in.lexically_relative(dir).generic_u8string();
+            Json::AppendString(manifest, rel);
+        }
+        manifest += "]}";
+        std::string err;
+        if (!AtomicFile::Write(dir / "atlases.json", manifest, err)) {
+            std::fprintf(stderr, "[ERROR] atlases.json: %s\n", err.c_str());
+            return 1;
+        }
+        std::printf("atlasc: %zu compilados, %zu al dia, %zu con error\n", written, skipped, failed);
+        return failed ? 1 : 0;
+    }
+
+    int VerifyPath(const fs::path& target) {
+        std::vector<fs::path> files = fs::is_directory(target) ? Collect(target) : std::vector<fs::path>{ target };
+        size_t failed = 0;
+        for (const auto& in : files) {
+            Atlas::Table t;
+            std::string err, bin;
+            if (!ParseText(in, t, err) || !Atlas::Write(t, bin, &err) || !Verify(t, bin, err)) {
+                std::fprintf(stderr, "[FAIL] %s: %s\n", in.u8string().c_str(), err.c_str());
+                failed++;
+            }
+        }
+        std::printf("atlasc: %zu atlas verificados, %zu fallos\n", files.size(), failed);
+        return failed ? 1 : 0;
+    }
+
+    int Bench(const fs::path& dir, int iterations) {
+        using Clock = std::chrono::steady_clock;
+        std::vector<std::string> texts, bins;
+        std::vector<Kind> kinds;
+        size_t textBytes = 0, binBytes = 0, frames = 0;
+        for (const auto& in : Collect(dir)) {
+            std::string text, bin, err;
+            Atlas::Table t;
+            if (!AtomicFile::ReadAll(in, text) || !ParseText(in, t, err) || !Atlas::Write(t, bin, &err)) continue;
+            textBytes += text.size(); binBytes += bin.size(); frames += t.frames.size();
+            kinds.push_back(KindOf(in));
+            texts.push_back(std::move(text));
+            bins.push_back(std::move(bin));
+        }
+        if (texts.empty()) { std::fprintf(stderr, "atlasc: no hay atlas en %s\n", dir.u8string().c_str()); return 1; }
+
+        auto ms = [](Clock::duration d) { return std::chrono::duration<double, std::milli>(d).count(); };
+        size_t sink = 0;
+        Atlas::Table t;
+
+        auto t0 = Clock::now();
+        for (int n = 0; n < iterations; n++) {
+            for (size_t i = 0; i < texts.size(); i++) {
+                if (kinds[i] == Kind::Spritemap) Atlas::ParseSpritemap(texts[i], t); else Atlas::ParseSparrow(texts[i], t);
+                sink += t.frames.size();
+            }
+        }
+        auto t1 = Clock::now();
+        for (int n = 0; n < iterations; n++) {
+            for (const auto& b : bins) { Atlas::Read(b.data(), b.size(), t); sink += t.frames.size(); }
+        }
+        auto t2 = Clock::now();
+        for (int n = 0; n < iterations; n++) {
+            for (const auto& b : bins) { Atlas::View v; v.Open(b.data(), b.size()); sink += v.FrameCount(); }
+        }
+        auto t3 = Clock::now();
+
+        double text = ms(t1 - t0) / iterations, read = ms(t2 - t1) / iterations, view = ms(t3 - t2) / iterations;
+        std::printf("atlasc bench: %zu atlas, %zu frames, %d iteraciones\n", texts.size(), frames, iterations);
+        std::printf("  texto   %8.2f MB  %8.2f ms/pasada\n", textBytes / 1048576.0, text);
+        std::printf("  binario %8.2f MB  %8.2f ms/pasada (decodificado)  %.1fx\n", binBytes / 1048576.0, read, read > 0 ? text / read : 0.0);
+        std::printf("  vista   %8s     %8.2f ms/pasada (sin copiar)\n", "", view);
+        return sink ? 0 : 1;
+    }
+
+    void Usage() {
+        std::fprintf(stderr,
+            "Uso:\n"
+            "  atlasc <atlas.xml|spritemap.json> [salida.gatl]\n"
+            "  atlasc --dir <carpeta> [--force] [--verify]\n"
+            "  atlasc --verify <carpeta|archivo>\n"
+            "  atlasc --bench <carpeta> [iteraciones]\n");
+    }
+
+    int Run(const std::vector<fs::path>& args) {
+        if (args.empty()) { Usage(); return 1; }
+        std::string cmd = args[0].u8string();
+        if (cmd == "--dir" && args.size() >= 2) {
+            bool force = false, verify = false;
+            for (size_t i = 2; i < args.size(); i++) {
+                if (args[i] == "--force") force = true;
+                else if (args[i] == "--verify") verify = true;
+            }
+            return CompileDir(args[1], force, verify);
+        }
+        if (cmd == "--verify" && args.size() >= 2) return VerifyPath(args[1]);
+        if (cmd == "--bench" && args.size() >= 2) {
+            int iterations = args.size() >= 3 ? std::max(1, std::atoi(args[2].u8string().c_str())) : 20;
+            return Bench(args[1], iterations);
+        }
+        if (cmd.rfind("--", 0) == 0 || KindOf(args[0]) == Kind::None) { Usage(); return 1; }
+        return CompileOne(args[0], args.size() >= 2 ? args[1] : OutputOf(args[0]), true, true) == 1 ? 1 : 0;
+    }
+}
+
+#ifdef _WIN32
+int wmain(int argc, wchar_t** argv) { return Run(std::vector<fs::path>(argv + 1, argv + argc)); }
+#else
+int main(int argc, char** argv) { return Run(std::vector<fs::path>(argv + 1, argv + argc)); }
+#endif
@@ -0,0 +1,725 @@
+/**
+ * atlaspack - Reempaquetador de texturas (recorte de bordes transparentes + MaxRects).
+ * Junta las texturas pequeñas de cada escenario en pocos atlas y reempaqueta los spritesheets,
+ * para que la página haga menos peticiones, decodificaciones y cambios de textura.
+ *
+ * Uso:
+ *   atlaspack --stages <public> [--max N] [--padding N]
+ *       Por cada data/stages/<id>.json junta sus "image" y "spritesheet" de images/stages/<id>
+ *       en <id>-atlas<N>.png/.xml (frames "<namePath>/<frame>" o "<namePath>") y añade
+ *       "atlas": "<id>-atlas<N>" a esos elementos del JSON. Los originales no se tocan.
+ *   atlaspack --sheets <carpeta> <salida> [--max N] [--padding N]
+ *       Reempaqueta cada Sparrow (.xml + .png) y spritemap*.json de la carpeta (recursivo) y
+ *       escribe en <salida>, con la misma ruta relativa, solo los que bajan de peso: la carpeta
+ *       de origen no se toca y <salida> se puede copiar encima de ella.
+ *   atlaspack --verify [public]
+ *       Pruebas sintéticas (PNG, MaxRects, --stages y --sheets); con una carpeta public,
+ *       además decodifica todos sus PNG y ejecuta --stages sobre una copia.
+ *
+ * Antes de escribir, cada textura nueva se vuelve a decodificar y cada frame original se
+ * compara píxel a píxel con el que se ve desde el atlas (AtlasPacker::Verify).
+ * compile.bat lo ejecuta sobre la copia de public de la build (--sheets lee de public y escribe
+ * en la copia), antes de atlasc.
+ */
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "../core/AtlasPacker.h"
+#include "../core/AtomicFile.h"
+#include "../core/Json.h"
+#include "Tool.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+    using namespace Tool;
+
+    struct Report {
+        uint64_t texturesBefore = 0, texturesAfter = 0;
+        uint64_t bytesBefore = 0, bytesAfter = 0;
+        uint64_t pixelsBefore = 0, pixelsAfter = 0;   // Memoria de GPU (RGBA)
+        uint64_t frames = 0, unique = 0;
+
+        void Add(const Report& o) {
+            texturesBefore += o.texturesBefore; texturesAfter += o.texturesAfter;
+            bytesBefore += o.bytesBefore; bytesAfter += o.bytesAfter;
+            pixelsBefore += o.pixelsBefore; pixelsAfter += o.pixelsAfter;
+            frames += o.frames; unique += o.unique;
+        }
+
+        void Print(const char* what) const {
+            std::printf("%s: %llu -> %llu texturas, %.2f -> %.2f MB de PNG, %.1f -> %.1f MB de GPU, %llu frames (%llu distintos)\n", what,
+                (unsigned long long)texturesBefore, (unsigned long long)texturesAfter, bytesBefore / 1048576.0, bytesAfter / 1048576.0,
+                pixelsBefore * 4 / 1048576.0, pixelsAfter * 4 / 1048576.0, (unsigned long long)frames, (unsigned long long)unique);
+        }
+    };
+
+    uint64_t FileSize(const fs::path& p) {
+        std::error_code ec;
+        uint64_t n = fs::file_size(p, ec);
+        return ec ? 0 : n;
+    }
+
+    bool LoadPng(const fs::path& path, Png::Image& img, std::string& err) {
+        std::string data;
+        if (!AtomicFile::ReadAll(path, data)) { err = "cannot read"; return false; }
+        return Png::Decode(data.data(), data.size(), img, &err);
+    }
+
+    /** Un frame con toda la imagen, para los "image" de los escenarios. */
+    Atlas::Table WholeImage(const Png::Image& img) {
+        Atlas::Table t;
+        Atlas::Frame f;
+        f.w = (int32_t)img.width; f.h = (int32_t)img.height;
+        t.frames.push_back(f);
+        Atlas::Group(t);
+        return t;
+    }
+
+    /**
+     * Codifica la textura y comprueba, sobre el PNG ya decodificado, que cada fuente se ve igual.
+     */
+    bool EncodeChecked(const AtlasPacker::Sheet& sheet, const std::vector<AtlasPacker::Source>& sources, std::string& png, std::string& err) {
+        png.clear();
+        Png::Encode(sheet.image, png);
+        Png::Image back;
+        if (!Png::Decode(png.data(), png.size(), back, &err)) { err = "re-decode: " + err; return false; }
+        if (back.width != sheet.image.width || back.height != sheet.image.height || back.rgba != sheet.image.rgba) { err = "png round trip differs"; return false; }
+        for (size_t s : sheet.sources) {
+            if (!AtlasPacker::Verify(sources[s], back, sheet.table, &err)) return false;
+        }
+        return true;
+    }
+
+    // --- Escenarios ---
+
+    struct StageItem {
+        std::string type, namePath;
+        bool pixel = false;
+    };
+
+    /** Mismo recorrido que StageElements._traverseStageData (grupos y envoltorios de una clave). */
+    void CollectItems(const Json::Value& list, std::vector<StageItem>& out) {
+        for (const auto& node : list.Items()) {
+            const Json::Value* item = &node;
+            if (!node.Has("type") && node.Size() == 1) item = &node.Members()[0].second;
+            const std::string& type = (*item)["type"].Str();
+            if (type == "group") { CollectItems((*item)["children"], out); continue; }
+            if (type != "image" && type != "spritesheet") continue;
+            StageItem it;
+            it.type = type;
+            it.namePath = (*item)["namePath"].Str();
+            it.pixel = (*item)["isPixel"].Bool(false);
+            if (!it.namePath.empty()) out.push_back(std::move(it));
+        }
+    }
+
+    /**
+     * Añade (o reemplaza) `"atlas": "<atlas>"` tras cada `"namePath": "<clave>"` de `atlasOf`,
+     * sin reformatear el resto del JSON.
+     */
+    std::string RewriteStage(const std::string& text, const std::unordered_map<std::string, std::string>& atlasOf) {
+        auto ws = [&](size_t p) { while (p < text.size() && (text[p] == ' ' || text[p] == '\t' || text[p] == '\r' || text[p] == '\n')) p++; return p; };
+        auto str = [&](size_t p, std::string& value) -> size_t {
+            // Cadena sin escapes raros (los namePath son nombres de archivo)
+            if (p >= text.size() || text[p] != '"') return std::string::npos;
+            size_t end = p + 1;
+            while (end < text.size() && text[end] != '"') { if (text[end] == '\\') end++; end++; }
+            if (end >= text.size()) return std::string::npos;
+            value = text.substr(p + 1, end - p - 1);
+            return end + 1;
+        };
+        std::string out;
+        out.reserve(text.size() + atlasOf.size() * 32);
+        size_t pos = 0;
+        for (;;) {
+            size_t key = text.find("\"namePath\"", pos);
+            if (key == std::string::npos) break;
+            std::string name;
+            size_t colon = ws(key + 10);
+            size_t end = colon < text.size() && text[colon] == ':' ? str(ws(colon + 1), name) : std::string::npos;
+            if (end == std::string::npos) { out.append(text, pos, key + 10 - pos); pos = key + 10; continue; }
+            out.append(text, pos, end - pos);
+            pos = end;
+            // Un "atlas" de una pasada anterior se sustituye
+            size_t comma = ws(end);
+            if (comma < text.size() && text[comma] == ',') {
+                size_t k = ws(comma + 1);
+                std::string prevKey, prevValue;
+                size_t kEnd = str(k, prevKey);
+                if (kEnd != std::string::npos && prevKey == "atlas") {
+                    size_t c2 = ws(kEnd);
+                    size_t vEnd = c2 < text.size() && text[c2] == ':' ? str(ws(c2 + 1), prevValue) : std::string::npos;
+                    if (vEnd != std::string::npos) pos = vEnd;
+                }
+            }
+            auto it = atlasOf.find(name);
+            if (it == atlasOf.end()) continue;
+            out += ", \"atlas\": ";
+            Json::AppendString(out, it->second);
+        }
+        out.append(text, pos, std::string::npos);
+        return out;
+    }
+
+    bool PackStage(const fs::path& pub, const fs::path& stageJson, const AtlasPacker::Options& opt, Report& report) {
+        std::string id = stageJson.stem().u8string(), text, err;
+        Json::Value doc;
+        if (!AtomicFile::ReadAll(stageJson, text) || !Json::Parse(text, doc, &err)) {
+            std::fprintf(stderr, "[ERROR] %s: %s\n", stageJson.u8string().c_str(), err.empty() ? "cannot read" : err.c_str());
+            return false;
+        }
+        std::vector<StageItem> items;
+        CollectItems(doc["stage"], items);
+
+        // Una fuente por namePath; los de pixel art (filtro NEAREST para toda la textura) y los que
+        // se usan a la vez como imagen y como spritesheet se quedan fuera
+        fs::path dir = pub / "images" / "stages" / fs::u8path(id);
+        std::unordered_map<std::string, std::string> typeOf;
+        std::unordered_set<std::string> excluded;
+        std::vector<std::string> names;
+        for (const auto& it : items) {
+            auto found = typeOf.find(it.namePath);
+            if (found == typeOf.end()) { typeOf.emplace(it.namePath, it.type); names.push_back(it.namePath); }
+            else if (found->second != it.type) excluded.insert(it.namePath);
+            if (it.pixel) excluded.insert(it.namePath);
+        }
+
+        Report r;
+        std::vector<AtlasPacker::Source> sources;
+        std::vector<uint64_t> sourceBytes;
+        for (const auto& name : names) {
+            fs::path png = dir / fs::u8path(name + ".png");
+            if (!fs::is_regular_file(png)) continue;
+            uint64_t bytes = FileSize(png);
+            r.texturesBefore++;
+            r.bytesBefore += bytes;
+            AtlasPacker::Source src;
+            std::string why;
+            bool ok = !excluded.count(name) && LoadPng(png, src.image, why);
+            if (ok) r.pixelsBefore += (uint64_t)src.image.width * src.image.height;
+            if (ok && typeOf[name] == "spritesheet") {
+                std::string xml;
+                ok = AtomicFile::ReadAll(dir / fs::u8path(name + ".xml"), xml) && Atlas::ParseSparrow(xml, src.table, &why);
+            } else if (ok) {
+                src.table = WholeImage(src.image);
+            }
+            if (!ok) {
+                // Se queda como textura suelta
+                r.texturesAfter++;
+                r.bytesAfter += bytes;
+                if (!why.empty()) std::fprintf(stderr, "  [SKIP] %s/%s: %s\n", id.c_str(), name.c_str(), why.c_str());
+                continue;
+            }
+            src.prefix = name;
+            sources.push_back(std::move(src));
+            sourceBytes.push_back(bytes);
+        }
+
+        std::vector<AtlasPacker::Sheet> sheets;
+        std::vector<size_t> skipped;
+        AtlasPacker::Pack(sources, opt, sheets, skipped);
+        for (size_t s : skipped) {
+            r.texturesAfter++;
+            r.bytesAfter += sourceBytes[s];
+            r.pixelsAfter += (uint64_t)sources[s].image.width * sources[s].image.height;
+        }
+
+        std::unordered_map<std::string, std::string> atlasOf;
+        int written = 0;
+        for (auto& sheet : sheets) {
+            std::string atlas = id + "-atlas" + std::to_string(written);
+            sheet.table.image = atlas + ".png";
+            std::string png, xml;
+            uint64_t original = 0, originalPixels = 0;
+            for (size_t s : sheet.sources) { original += sourceBytes[s]; originalPixels += (uint64_t)sources[s].image.width * sources[s].image.height; }
+            bool ok = EncodeChecked(sheet, sources, png, err);
+            // Una sola fuente que no baja de peso no compensa: se queda como estaba
+            if (ok && sheet.sources.size() == 1 && png.size() >= original) ok = false, err.clear();
+            if (ok) {
+                Atlas::WriteSparrow(sheet.table, xml);
+                ok = AtomicFile::Write(dir / fs::u8path(atlas + ".png"), png, err) && AtomicFile::Write(dir / fs::u8path(atlas + ".xml"), xml, err);
+            }
+            if (!ok) {
+                if (!err.empty()) std::fprintf(stderr, "  [ERROR] %s: %s\n", atlas.c_str(), err.c_str());
+                r.texturesAfter += sheet.sources.size();
+                r.bytesAfter += original;
+                r.pixelsAfter += originalPixels;
+                continue;
+            }
+            for (size_t s : sheet.sources) atlasOf[sources[s].prefix] = atlas;
+            r.texturesAfter++;
+            r.bytesAfter += png.size();
+            r.pixelsAfter += (uint64_t)sheet.image.width * sheet.image.height;
+            r.frames += sheet.frames;
+            r.unique += sheet.unique;
+            written++;
+        }
+
+        std::string rewritten = RewriteStage(text, atlasOf);
+        Json::Value check;
+        if (!Json::Parse(rewritten, check, &err)) {
+            std::fprintf(stderr, "[ERROR] %s: el JSON reescrito no es válido (%s)\n", stageJson.u8string().c_str(), err.c_str());
+            return false;
+        }
+        if (rewritten != text && !AtomicFile::Write(stageJson, rewritten, err)) {
+            std::fprintf(stderr, "[ERROR] %s: %s\n", stageJson.u8string().c_str(), err.c_str());
+            return false;
+        }
+        r.Print(("  " + id).c_str());
+        report.Add(r);
+        return true;
+    }
+
+    int PackStages(const fs::path& pub, const AtlasPacker::Options& opt, Report* out = nullptr) {
+        std::vector<fs::path> stages;
+        std::error_code ec;
+        for (auto it = fs::directory_iterator(pub / "data" / "stages", ec); !ec && it != fs::directory_iterator(); it.increment(ec)) {
+            if (it->is_regular_file(ec) && it->path().extension() == ".json") stages.push_back(it->path());
+        }
+        std::sort(stages.begin(), stages.end());
+        if (stages.empty()) { std::fprintf(stderr, "atlaspack: no hay escenarios en %s\n", (pub / "data" / "stages").u8string().c_str()); return 1; }
+        Report total;
+        size_t failed = 0;
+        for (const auto& s : stages) if (!PackStage(pub, s, opt, total)) failed++;
+        total.Print("atlaspack --stages");
+        if (out) *out = total;
+        return failed ? 1 : 0;
+    }
+
+    // --- Spritesheets ---
+
+    /**
+     * Reempaqueta un Sparrow o spritemap en `outAtlas` (y el PNG a su lado). La imagen y el atlas
+     * conservan sus nombres.
+     * @returns {int} 0 = escrito, 1 = error, 2 = no baja de peso (no se escribe nada).
+     */
+    int PackSheet(const fs::path& atlasPath, const fs::path& outAtlas, const AtlasPacker::Options& base, Report& r, std::string& note) {
+        std::string text, err;
+        AtlasPacker::Source src;
+        bool spritemap = atlasPath.extension() == ".json";
+        if (!AtomicFile::ReadAll(atlasPath, text)) { note = "cannot read"; return 1; }
+        if (!(spritemap ? Atlas::ParseSpritemap(text, src.table, &err) : Atlas::ParseSparrow(text, src.table, &err))) { note = err; return 1; }
+        // La página carga <nombre>.png junto al atlas, diga lo que diga imagePath
+        fs::path png = atlasPath;
+        png.replace_extension(".png");
+        uint64_t bytes = FileSize(png);
+        r.texturesBefore++; r.texturesAfter++;
+        r.bytesBefore += bytes;
+        if (!LoadPng(png, src.image, err)) { r.bytesAfter += bytes; note = err; return 2; }
+        r.pixelsBefore += (uint64_t)src.image.width * src.image.height;
+
+        AtlasPacker::Options opt = base;
+        opt.trim = !spritemap;
+        // Nunca más limitado que la textura original (hay personajes de 8192 de ancho)
+        opt.maxSize = std::max({ opt.maxSize, (int)src.image.width, (int)src.image.height });
+        std::vector<AtlasPacker::Source> sources;
+        sources.push_back(std::move(src));
+        std::vector<AtlasPacker::Sheet> sheets;
+        std::vector<size_t> skipped;
+        AtlasPacker::Pack(sources, opt, sheets, skipped);
+        auto keep = [&](const std::string& why) {
+            r.bytesAfter += bytes;
+            r.pixelsAfter += (uint64_t)sources[0].image.width * sources[0].image.height;
+            note = why;
+            return 2;
+        };
+        if (sheets.size() != 1) return keep("frames rotados o fuera de la imagen");
+        AtlasPacker::Sheet& sheet = sheets[0];
+        sheet.table.image = png.filename().u8string();
+        std::string out, atlas;
+        if (!EncodeChecked(sheet, sources, out, err)) { note = err; keep(""); return 1; }
+        if (out.size() >= bytes) {
+            char why[96];
+            std::snprintf(why, sizeof(why), "no baja de peso (%.2f -> %.2f MB, %ux%u -> %ux%u)", bytes / 1048576.0, out.size() / 1048576.0,
+                sources[0].image.width, sources[0].image.height, sheet.image.width, sheet.image.height);
+            return keep(why);
+        }
+        if (spritemap) Atlas::WriteSpritemap(sheet.table, (int)sheet.image.width, (int)sheet.image.height, atlas);
+        else Atlas::WriteSparrow(sheet.table, atlas);
+        fs::path outPng = outAtlas;
+        outPng.replace_extension(".png");
+        std::error_code ec;
+        fs::create_directories(outAtlas.parent_path(), ec);
+        if (!AtomicFile::Write(outPng, out, err) || !AtomicFile::Write(outAtlas, atlas, err)) { note = err; keep(""); return 1; }
+        r.bytesAfter += out.size();
+        r.pixelsAfter += (uint64_t)sheet.image.width * sheet.image.height;
+        r.frames += sheet.frames;
+        r.unique += sheet.unique;
+        return 0;
+    }
+
+    int PackSheets(const fs::path& dir, const fs::path& outDir, const AtlasPacker::Options& opt, Report* out = nullptr) {
+        std::vector<fs::path> files;
+        std::error_code ec;
+        for (auto it = fs::recursive_directory_iterator(dir, ec); !ec && it != fs::recursive_directory_iterator(); it.increment(ec)) {
+            if (!it->is_regular_file(ec)) continue;
+            std::string ext = it->path().extension().u8string(), stem = it->path().stem().u8string();
+            if (ext == ".xml" || (ext == ".json" && stem.rfind("spritemap", 0) == 0)) files.push_back(it->path());
+        }
+        std::sort(files.begin(), files.end());
+
+        // Un archivo por hilo: la compresión es lo que más tarda
+        Report total;
+        std::mutex mtx;
+        std::atomic<size_t> next{0};
+        size_t failed = 0;
+        auto work = [&] {
+            for (size_t i; (i = next.fetch_add(1)) < files.size();) {
+                Report r;
+                std::string note;
+                fs::path rel = files[i].lexically_relative(dir);
+                int res = PackSheet(files[i], outDir / rel, opt, r, note);
+                std::lock_guard<std::mutex> lock(mtx);
+                total.Add(r);
+                std::string name = rel.generic_u8string();
+                if (res == 1) { failed++; std::fprintf(stderr, "  [ERROR] %s: %s\n", name.c_str(), note.c_str()); }
+                else if (res == 2) std::printf("  [ = ] %s: %s\n", name.c_str(), note.c_str());
+                else std::printf("  [ OK ] %s: %.2f -> %.2f MB\n", name.c_str(), r.bytesBefore / 1048576.0, r.bytesAfter / 1048576.0);
+            }
+        };
+        size_t threads = std::max<size_t>(1, std::min<size_t>(std::thread::hardware_concurrency(), files.size()));
+        std::vector<std::thread> pool;
+        for (size_t t = 1; t < threads; t++) pool.emplace_back(work);
+        work();
+        for (auto& t : pool) t.join();
+        total.Print("atlaspack --sheets");
+        if (out) *out = total;
+        return failed ? 1 : 0;
+    }
+
+    // --- Verificación ---
+
+    uint32_t Rand(uint32_t& s) { s ^= s << 13; s ^= s >> 17; s ^= s << 5; return s; }
+
+    /** Sprite sintético: fondo transparente con un óvalo de color en (cx, cy). */
+    void Blob(Png::Image& img, int x0, int y0, int w, int h, int cx, int cy, int rx, int ry, uint32_t seed) {
+        for (int y = 0; y < h; y++) {
+            for (int x = 0; x < w; x++) {
+                double dx = (double)(x - cx) / rx, dy = (double)(y - cy) / ry;
+                uint8_t* p = img.Row((uint32_t)(y0 + y)) + (size_t)(x0 + x) * 4;
+                if (dx * dx + dy * dy > 1.0) { p[0] = 255; p[1] = 255; p[2] = 255; p[3] = 0; continue; }
+                p[0] = (uint8_t)(seed * 37 + x * 3); p[1] = (uint8_t)(seed * 11 + y * 5); p[2] = (uint8_t)(x ^ y); p[3] = (uint8_t)(128 + (x + y) % 128);
+            }
+        }
+    }
+
+    bool WritePng(const fs::path& p, const Png::Image& img) {
+        std::string png, err;
+        Png::Encode(img, png);
+        fs::create_directories(p.parent_path());
+        return AtomicFile::Write(p, png, err);
+    }
+
+    bool WriteText(const fs::path& p, const std::string& text) {
+        std::string err;
+        fs::create_directories(p.parent_path());
+        return AtomicFile::Write(p, text, err);
+    }
+
+    void VerifyPng() {
+        uint32_t seed = 12345;
+        bool ok = true;
+        for (int round = 0; round < 40 && ok; round++) {
+            Png::Image img;
+            uint32_t w = 1 + Rand(seed) % 300, h = 1 + Rand(seed) % 200;
+            img.Resize(w, h);
+            int mode = round % 4;
+            for (size_t i = 0; i < img.rgba.size(); i++) {
+                if (mode == 0) img.rgba[i] = (uint8_t)Rand(seed);                         // Ruido: no comprime
+                else if (mode == 1) img.rgba[i] = (uint8_t)((i / 4) % 7 * 40);            // Pocos colores: paleta
+                else if (mode == 2) img.rgba[i] = (uint8_t)(i / 4 / w + (i % 4) * 50);    // Degradado: filtros
+                else img.rgba[i] = (uint8_t)((i / 4 % w) < w / 2 ? 0 : Rand(seed));       // Mitad vacía
+            }
+            std::string png, err;
+            Png::Encode(img, png);
+            Png::Image back;
+            ok = Png::Decode(png.data(), png.size(), back, &err) && back.width == w && back.height == h && back.rgba == img.rgba;
+        }
+        Check(ok, "PNG: codificar y decodificar devuelve los mismos píxeles (RGBA y paleta)");
+
+        Png::Image flat;
+        flat.Resize(1024, 1024);
+        std::fill(flat.rgba.begin(), flat.rgba.end(), 0);
+        std::string png;
+        Png::Encode(flat, png);
+        Check(png.size() < 2048, "PNG: una textura vacía de 1024x1024 ocupa menos de 2 KB");
+
+        std::string bad = png;
+        bad[bad.size() / 2] ^= 0x55;
+        Png::Image dummy;
+        std::string err;
+        Check(!Png::Decode(bad.data(), bad.size(), dummy, &err), "PNG: un byte cambiado se detecta (CRC)");
+    }
+
+    void VerifyMaxRects() {
+        uint32_t seed = 99;
+        bool ok = true;
+        for (int round = 0; round < 20 && ok; round++) {
+            MaxRects::Bin bin(512, 512);
+            std::vector<MaxRects::Rect> placed;
+            for (int i = 0; i < 200; i++) {
+                MaxRects::Rect r;
+                if (!bin.Insert(4 + Rand(seed) % 60, 4 + Rand(seed) % 60, r)) continue;
+                if (r.x < 0 || r.y < 0 || r.x + r.w > 512 || r.y + r.h > 512) ok = false;
+                for (const auto& o : placed) if (o.Overlaps(r)) ok = false;
+                placed.push_back(r);
+            }
+            ok = ok && placed.size() > 60;
+        }
+        Check(ok, "MaxRects: sin solapes ni salidas del borde, más de 60 piezas en 512x512");
+    }
+
+    /**
+     * Escenario sintético: imágenes sueltas, un Sparrow con frames repetidos, recortados y vacíos,
+     * uno de pixel art, uno rotado (se quedan fuera) y los dos estilos de nodo del JSON.
+     */
+    void VerifyStages(const fs::path& root) {
+        fs::path pub = root / "public", dir = pub / "images" / "stages" / "test";
+        Png::Image sky, tree, sheet, pixel;
+        sky.Resize(300, 200);
+        for (uint32_t y = 0; y < 200; y++) for (uint32_t x = 0; x < 300; x++) {
+            uint8_t* p = sky.Row(y) + x * 4; p[0] = (uint8_t)x; p[1] = (uint8_t)y; p[2] = 200; p[3] = 255;
+        }
+        tree.Resize(256, 256);
+        Blob(tree, 0, 0, 256, 256, 120, 140, 50, 60, 1);
+        sheet.Resize(512, 256);
+        for (int i = 0; i < 4; i++) Blob(sheet, i * 128, 0, 128, 128, 64 + i * 5, 70, 20 + i * 6, 30, 2 + i);
+        Blob(sheet, 0, 128, 128, 128, 64, 64, 30, 30, 2);   // Mismos píxeles que ninguno: otra posición
+        std::string xml =
+            "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n<TextureAtlas imagePath=\"dancer.png\">\n"
+            "\t<SubTexture name=\"idle0000\" x=\"0\" y=\"0\" width=\"128\" height=\"128\"/>\n"
+            "\t<SubTexture name=\"idle0001\" x=\"128\" y=\"0\" width=\"128\" height=\"128\"/>\n"
+            "\t<SubTexture name=\"idle0002\" x=\"0\" y=\"0\" width=\"128\" height=\"128\"/>\n"
+            "\t<SubTexture name=\"dance0000\" x=\"256\" y=\"0\" width=\"128\" height=\"128\" frameX=\"-10\" frameY=\"-4\" frameWidth=\"150\" frameHeight=\"140\"/>\n"
+            "\t<SubTexture name=\"dance0001\" x=\"384\" y=\"0\" width=\"128\" height=\"128\" frameX=\"0\" frameY=\"0\" frameWidth=\"128\" frameHeight=\"128\"/>\n"
+            "\t<SubTexture name=\"dance0002\" x=\"0\" y=\"128\" width=\"128\" height=\"128\"/>\n"
+            "\t<SubTexture name=\"empty0000\" x=\"200\" y=\"200\" width=\"40\" height=\"40\"/>\n"
+            "</TextureAtlas>\n";
+        pixel.Resize(64, 64);
+        Blob(pixel, 0, 0, 64, 64, 32, 32, 20, 20, 9);
+        std::string rotXml =
+            "<TextureAtlas imagePath=\"rot.png\"><SubTexture name=\"a0000\" x=\"0\" y=\"0\" width=\"32\" height=\"16\" rotated=\"true\"/></TextureAtlas>";
+        std::string stage =
+            "{\n  \"stage\": [\n"
+            "    { \"type\": \"image\", \"namePath\": \"sky\", \"position\": [0, 0] },\n"
+            "    { \"type\": \"group\", \"children\": [\n"
+            "      { \"type\": \"image\", \"namePath\": \"tree\", \"position\": [10, 10] },\n"
+            "      { \"type\": \"spritesheet\", \"namePath\": \"dancer\", \"atlas\": \"old\", \"position\": [1, 2] }\n"
+            "    ] },\n"
+            "    { \"dancer2\": { \"type\": \"spritesheet\", \"namePath\": \"dancer\", \"position\": [5, 2] } },\n"
+            "    { \"type\": \"image\", \"namePath\": \"pixel\", \"isPixel\": true },\n"
+            "    { \"type\": \"spritesheet\", \"namePath\": \"rot\" },\n"
+            "    { \"bf\": { \"type\": \"character\", \"position\": [0, 0] } }\n"
+            "  ]\n}\n";
+        bool setup = WritePng(dir / "sky.png", sky) && WritePng(dir / "tree.png", tree) && WritePng(dir / "dancer.png", sheet)
+            && WriteText(dir / "dancer.xml", xml) && WritePng(dir / "pixel.png", pixel) && WritePng(dir / "rot.png", pixel)
+            && WriteText(dir / "rot.xml", rotXml) && WriteText(pub / "data" / "stages" / "test.json", stage);
+        Check(setup, "escenario sintético escrito");
+
+        AtlasPacker::Options opt;
+        opt.maxSize = 1024;
+        Report rep;
+        Check(PackStages(pub, opt, &rep) == 0, "--stages termina sin errores");
+        Check(rep.texturesBefore == 5 && rep.texturesAfter == 3, "5 texturas -> 3 (un atlas + pixel art + rotado)");
+
+        std::string text, err, atlasXml, atlasPng;
+        Json::Value doc;
+        bool parsed = AtomicFile::ReadAll(pub / "data" / "stages" / "test.json", text) && Json::Parse(text, doc, &err);
+        const Json::Value& list = doc["stage"];
+        bool rewritten = parsed && list[0]["atlas"].Str() == "test-atlas0" && list[1]["children"][0]["atlas"].Str() == "test-atlas0"
+            && list[1]["children"][1]["atlas"].Str() == "test-atlas0" && list[2]["dancer2"]["atlas"].Str() == "test-atlas0"
+            && list[3]["atlas"].IsNull() && list[4]["atlas"].IsNull() && list[1]["children"][1]["position"][1].Int() == 2;
+        Check(rewritten, "JSON: \"atlas\" en sky, tree y las dos copias de dancer; el \"atlas\" viejo se sustituye");
+        Check(text.find("\"atlas\": \"old\"") == std::string::npos && text.find("\"position\": [5, 2]") != std::string::npos, "JSON: el resto del texto queda igual");
+
+        // Lo escrito en disco, leído desde cero
+        Atlas::Table table;
+        Png::Image atlas;
+        bool loaded = AtomicFile::ReadAll(dir / "test-atlas0.xml", atlasXml) && Atlas::ParseSparrow(atlasXml, table, &err)
+            && LoadPng(dir / "test-atlas0.png", atlas, err) && table.image == "test-atlas0.png";
+        Check(loaded, "atlas escrito (PNG + XML)");
+        bool identical = loaded;
+        AtlasPacker::Source s;
+        s.prefix = "sky"; s.image = sky; s.table = WholeImage(sky);
+        identical = identical && AtlasPacker::Verify(s, atlas, table, &err);
+        s.prefix = "tree"; s.image = tree; s.table = WholeImage(tree);
+        identical = identical && AtlasPacker::Verify(s, atlas, table, &err);
+        s.prefix = "dancer"; s.image = sheet; Atlas::ParseSparrow(xml, s.table);
+        identical = identical && AtlasPacker::Verify(s, atlas, table, &err);
+        Check(identical, "cada frame original se ve igual desde el atlas (recortes, repetidos y vacíos)");
+        if (!identical) std::printf("         %s\n", err.c_str());
+
+        auto find = [&](const char* name) -> const Atlas::Frame* {
+            for (const auto& f : table.frames) if (f.name == name) return &f;
+            return nullptr;
+        };
+        const Atlas::Frame* tr = find("tree");
+        const Atlas::Frame* i0 = find("dancer/idle0000");
+        const Atlas::Frame* i2 = find("dancer/idle0002");
+        const Atlas::Frame* d0 = find("dancer/dance0000");
+        bool trimmed = tr && tr->trimmed && tr->w <= 101 && tr->frameW == 256 && tr->frameX < 0
+            && i0 && i2 && i0->x == i2->x && i0->y == i2->y && d0 && d0->frameW == 150 && d0->frameX < -10;
+        Check(trimmed, "bordes recortados, frames repetidos comparten sitio, recortes previos se suman");
+
+        std::string again = text;
+        Check(PackStages(pub, opt) == 0 && AtomicFile::ReadAll(pub / "data" / "stages" / "test.json", again) && again == text,
+              "segunda pasada: mismo JSON (idempotente)");
+    }
+
+    void VerifySheets(const fs::path& root) {
+        fs::path dir = root / "characters";
+        Png::Image img;
+        img.Resize(1024, 512);
+        std::string xml = "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n<TextureAtlas imagePath=\"guy.png\">\n";
+        for (int i = 0; i < 8; i++) {
+            int x = (i % 4) * 256, y = (i / 4) * 256;
+            Blob(img, x, y, 256, 256, 128, 128, 40 + (i % 3) * 10, 60, 20 + i % 3);
+            char line[200];
+            std::snprintf(line, sizeof(line), "\t<SubTexture name=\"idle%04d\" x=\"%d\" y=\"%d\" width=\"256\" height=\"256\"/>\n", i, x, y);
+            xml += line;
+        }
+        xml += "</TextureAtlas>\n";
+        Png::Image map;
+        map.Resize(300, 100);
+        Blob(map, 0, 0, 100, 100, 50, 50, 40, 40, 7);
+        Blob(map, 100, 0, 100, 100, 50, 50, 30, 40, 8);
+        uint32_t seed = 7;   // Un sprite viejo que ya no se usa: ruido que no comprime
+        for (uint32_t y = 0; y < 100; y++) for (uint32_t x = 200; x < 300; x++) for (int c = 0; c < 4; c++) map.Row(y)[x * 4 + c] = (uint8_t)Rand(seed);
+        std::string spritemap =
+            "\xEF\xBB\xBF{\"ATLAS\": {\"SPRITES\":[\n"
+            "{\"SPRITE\" : {\"name\": \"0000\",\"x\":0,\"y\":0,\"w\":100,\"h\":100,\"rotated\": false}},\n"
+            "{\"SPRITE\" : {\"name\": \"0001\",\"x\":100,\"y\":0,\"w\":100,\"h\":100,\"rotated\": false}}\n"
+            "]},\n\"meta\": {\"app\": \"Adobe Animate\",\"image\": \"spritemap1.png\",\"size\": {\"w\":300,\"h\":100},\"resolution\": \"1\"}}\n";
+        // Un frame que ocupa toda la imagen y no comprime: reempaquetado no baja de peso
+        Png::Image tight;
+        tight.Resize(64, 64);
+        for (size_t i = 0; i < tight.rgba.size(); i++) tight.rgba[i] = i % 4 == 3 ? 255 : (uint8_t)Rand(seed);
+        std::string tightXml = "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n<TextureAtlas imagePath=\"tight.png\">\n"
+            "\t<SubTexture name=\"tight0000\" x=\"0\" y=\"0\" width=\"64\" height=\"64\"/>\n</TextureAtlas>\n";
+        bool setup = WritePng(dir / "guy.png", img) && WriteText(dir / "guy.xml", xml)
+            && WritePng(dir / "anim" / "spritemap1.png", map) && WriteText(dir / "anim" / "spritemap1.json", spritemap)
+            && WritePng(dir / "tight.png", tight) && WriteText(dir / "tight.xml", tightXml);
+        Check(setup, "spritesheets sintéticos escritos");
+        std::string guyPng, guyXml;
+        AtomicFile::ReadAll(dir / "guy.png", guyPng);
+        AtomicFile::ReadAll(dir / "guy.xml", guyXml);
+
+        Report rep;
+        AtlasPacker::Options opt;
+        fs::path outDir = root / "characters-out";
+        Check(PackSheets(dir, outDir, opt, &rep) == 0, "--sheets termina sin errores");
+        std::string text, err;
+        AtomicFile::ReadAll(dir / "guy.png", text);
+        bool untouched = text == guyPng;
+        AtomicFile::ReadAll(dir / "guy.xml", text);
+        Check(untouched && text == guyXml, "la carpeta de origen no se toca");
+        Check(!fs::exists(outDir / "tight.png") && !fs::exists(outDir / "tight.xml"), "lo que no baja de peso no se escribe en la salida");
+        Check(rep.bytesAfter < rep.bytesBefore, "la salida pesa menos que los originales");
+
+        Atlas::Table table, mapTable;
+        Png::Image packed, packedMap;
+        bool ok = AtomicFile::ReadAll(outDir / "guy.xml", text) && Atlas::ParseSparrow(text, table, &err) && LoadPng(outDir / "guy.png", packed, err);
+        AtlasPacker::Source s;
+        s.image = img; Atlas::ParseSparrow(xml, s.table);
+        Check(ok && FileSize(outDir / "guy.png") < guyPng.size() && packed.width * packed.height < img.width * img.height && table.image == "guy.png"
+              && AtlasPacker::Verify(s, packed, table, &err), "Sparrow reempaquetado en la salida: más pequeño y frames idénticos");
+
+        ok = AtomicFile::ReadAll(outDir / "anim" / "spritemap1.json", text) && Atlas::ParseSpritemap(text, mapTable, &err) && LoadPng(outDir / "anim" / "spritemap1.png", packedMap, err);
+        AtlasPacker::Source m;
+        m.image = map; Atlas::ParseSpritemap(spritemap, m.table);
+        bool untrimmed = ok;
+        for (const auto& f : mapTable.frames) untrimmed = untrimmed && !f.trimmed && f.w == 100 && f.h == 100;
+        Check(untrimmed && packedMap.width * packedMap.height < map.width * map.height && mapTable.image == "spritemap1.png"
+              && AtlasPacker::Verify(m, packedMap, mapTable, &err), "spritemap: sin recorte (Animate coloca por la esquina), sprites idénticos");
+    }
+
+    /** Decodifica todos los PNG de `pub` y ejecuta --stages sobre una copia de escenarios. */
+    void VerifyReal(const fs::path& pub, const fs::path& root) {
+        size_t total = 0, failed = 0, notPng = 0;
+        uint64_t bytes = 0;
+        auto t0 = Clock::now();
+        std::error_code ec;
+        for (auto it = fs::recursive_directory_iterator(pub, ec); !ec && it != fs::recursive_directory_iterator(); it.increment(ec)) {
+            if (!it->is_regular_file(ec) || it->path().extension() != ".png") continue;
+            std::string data, err;
+            Png::Image img;
+            total++;
+            if (!AtomicFile::ReadAll(it->path(), data)) { failed++; continue; }
+            bytes += data.size();
+            if (Png::Decode(data.data(), data.size(), img, &err)) continue;
+            if (err == "not a png") { notPng++; continue; }   // WebP con extensión .png
+            failed++;
+            std::printf("         %s: %s\n", it->path().u8string().c_str(), err.c_str());
+        }
+        double secs = std::chrono::duration<double>(Clock::now() - t0).count();
+        std::printf("\n%s: %zu PNG (%.1f MB) en %.1f s, %zu no son PNG\n", pub.u8string().c_str(), total, bytes / 1048576.0, secs, notPng);
+        Check(failed == 0, "todos los PNG reales se decodifican");
+
+        fs::path copy = root / "real";
+        fs::create_directories(copy / "images", ec);
+        fs::create_directories(copy / "data", ec);
+        fs::copy(pub / "data" / "stages", copy / "data" / "stages", fs::copy_options::recursive, ec);
+        fs::copy(pub / "images" / "stages", copy / "images" / "stages", fs::copy_options::recursive, ec);
+        Report rep;
+        AtlasPacker::Options opt;
+        Check(!ec && PackStages(copy, opt, &rep) == 0, "--stages sobre la copia de los escenarios reales");
+        Check(rep.texturesAfter < rep.texturesBefore, "los escenarios reales cargan menos texturas");
+    }
+
+    int Verify(const fs::path& real) {
+        std::printf("atlaspack --verify\n");
+        fs::path root = fs::temp_directory_path() / ("atlaspack-" + std::to_string(Clock::now().time_since_epoch().count()));
+        VerifyPng();
+        VerifyMaxRects();
+        VerifyStages(root / "synthetic");
+        VerifySheets(root / "synthetic");
+        if (!real.empty()) VerifyReal(real, root);
+        std::error_code ec;
+        fs::remove_all(root, ec);
+        std::printf(failures ? "\n%d fallos\n" : "\ntodo OK\n", failures);
+        return failures ? 1 : 0;
+    }
+
+    void Usage() {
+        std::fprintf(stderr,
+            "Uso:\n"
+            "  atlaspack --stages <public> [--max N] [--padding N]\n"
+            "  atlaspack --sheets <carpeta> <salida> [--max N] [--padding N]\n"
+            "  atlaspack --verify [public]\n");
+    }
+
+    int Run(const std::vector<fs::path>& args) {
+        if (args.empty()) { Usage(); return 1; }
+        std::string cmd = args[0].u8string();
+        if (cmd == "--verify") return Verify(args.size() >= 2 ? args[1] : fs::path());
+        size_t first = cmd == "--sheets" ? 3 : 2;
+        if ((cmd != "--stages" && cmd != "--sheets") || args.size() < first) { Usage(); return 1; }
+        AtlasPacker::Options opt;
+        for (size_t i = first; i + 1 < args.size(); i += 2) {
+            int v = std::atoi(args[i + 1].u8string().c_str());
+            if (args[i] == "--max" && v >= 64) opt.maxSize = std::min(v, 16384);
+            else if (args[i] == "--padding" && v >= 0) opt.padding = std::min(v, 16);
+        }
+        auto t0 = Clock::now();
+        int res = cmd == "--stages" ? PackStages(args[1], opt) : PackSheets(args[1], args[2], opt);
+        std::printf("  %.1f s\n", std::chrono::duration<double>(Clock::now() - t0).count());
+        return res;
+    }
+}
+
+#ifdef _WIN32
+int wmain(int argc, wchar_t** argv) { return Run(std::vector<fs::path>(argv + 1, argv + argc)); }
+#else
+int main(int argc, char** argv) { return Run(std::vector<fs::path>(argv + 1, argv + argc)); }
+#endif
@@ -0,0 +1,303 @@
+/**
+ * chartbench - Comprueba y mide el índice de charts (core/ChartIndex.h).
+ *
+ * Uso:
+ *   chartbench --verify [raíz]      Duración con sostenidas, handles con referencias, reindexado al
+ *                                   cambiar el archivo, consultas frente a recorrido completo; con una
+ *                                   raíz, lo mismo sobre cada chart de public/songs
+ *   chartbench --bench [raíz]       Cada chart de public/songs: tiempo de indexado, Open reutilizado y
+ *                                   consultas por ventana con índice frente a recorrer todas las notas
+ *
+ * La raíz es la carpeta que contiene public/ (por defecto el directorio actual); también valen
+ * public/ o public/songs, como en el resto de herramientas (Tool::ProjectRoot).
+ */
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../core/ChartIndex.h"
+#include "../core/Utf.h"
+#include "Tool.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+    using namespace Tool;
+
+    /** Chart Psych aleatorio: secciones de 16 pasos, notas de los dos lados, sostenidas y tipos. */
+    std::string RandomChart(std::mt19937_64& rng, int sections, double bpm = 150) {
+        double step = 60000.0 / bpm / 4;
+        std::string j = "{\"song\":{\"song\":\"Prueba\",\"bpm\":" + std::to_string((int)bpm) + ",\"speed\":2.1,\"notes\":[";
+        for (int s = 0; s < sections; s++) {
+            if (s) j += ',';
+            j += "{\"mustHitSection\":"; j += (rng() % 2) ? "true" : "false";
+            j += ",\"sectionNotes\":[";
+            int n = (int)(rng() % 12);
+            for (int i = 0; i < n; i++) {
+                if (i) j += ',';
+                double t = (s * 16 + (double)(rng() % 16)) * step;
+                double sus = rng() % 4 == 0 ? (double)(rng() % 4000) : 0.0;
+                j += "[" + std::to_string(t) + "," + std::to_string(rng() % 8) + "," + std::to_string(sus);
+                if (rng() % 10 == 0) j += ",\"Hey!\"";
+                j += "]";
+            }
+            j += "]}";
+        }
+        return j + "]}}";
+    }
+
+    /** Compara Range/Overlaps/Density con recorrer todas las notas, en ventanas aleatorias. */
+    bool QueriesMatch(const ChartIndex& c, std::mt19937_64& rng, int windows) {
+        double end = c.Duration() + 1000;
+        for (int w = 0; w < windows; w++) {
+            double t0 = std::uniform_real_distribution<double>(-1000, end)(rng);
+            double t1 = t0 + std::uniform_real_distribution<double>(0, 8000)(rng);
+            for (bool holds : { false, true }) {
+                std::vector<size_t> got, want;
+                auto r = c.Range(t0, t1, holds);
+                for (size_t i = r.first; i < r.second; i++) if (!holds || c.Overlaps(i, t0)) got.push_back(i);
+                for (size_t i = 0; i < c.Count(); i++) {
+                    bool starts = c.time[i] >= t0 && c.time[i] < t1;
+                    bool sounding = c.time[i] < t0 && c.time[i] + c.sustain[i] >= t0;
+                    if (starts || (holds && sounding)) want.push_back(i);
+                }
+                if (got != want) return false;
+            }
+            std::vector<uint32_t> buckets;
+            c.Density(t0, t1, 32, buckets, 0xF0);
+            uint64_t sum = 0, player = 0;
+            for (uint32_t b : buckets) sum += b;
+            for (size_t i = 0; i < c.Count(); i++) if (c.time[i] >= t0 && c.time[i] < t1 && c.lane[i] >= 4) player++;
+            if (t1 > t0 && sum != player) return false;
+        }
+        return true;
+    }
+
+    double BruteDuration(const ChartIndex& c) {
+        double d = 0;
+        for (size_t i = 0; i < c.Count(); i++) d = std::max(d, c.time[i] + (double)c.sustain[i]);
+        return d;
+    }
+
+    std::vector<fs::path> Charts(const fs::path& root) {
+        std::vector<fs::path> out;
+        std::error_code ec;
+        for (auto& song : fs::directory_iterator(root / "public" / "songs", ec)) {
+            for (auto& f : fs::directory_iterator(song.path() / "charts", ec)) {
+                if (f.path().extension() == ".json") out.push_back(f.path());
+            }
+        }
+        std::sort(out.begin(), out.end());
+        return out;
+    }
+
+    void VerifyIndex() {
+        std::printf("índice\n");
+        ChartIndex c;
+        bool ok = c.Parse("{\"song\":{\"notes\":[{\"mustHitSection\":true,\"sectionNotes\":[[0,0,5000],[1000,1,0],[1200,5,100]]}]}}");
+        Check(ok && c.Duration() == 5000, "Duration: la sostenida larga del principio acaba después de la última nota");
+        ok = c.Parse("{\"song\":{\"notes\":[]}}");
+        Check(ok && c.Duration() == 0 && c.Count() == 0, "chart sin notas: duración 0");
+        ok = c.Parse("{\"song\":{\"notes\":[{\"sectionNotes\":[[3000,2,0],[500,0,0]]}]}}");
+        Check(ok && c.Duration() == 3000 && c.time.front() == 500, "notas desordenadas: se ordenan y la duración es la de la última");
+
+        std::mt19937_64 rng(5);
+        bool all = true, dur = true;
+        for (int i = 0; i < 30; i++) {
+            ChartIndex r;
+            all &= r.Parse(RandomChart(rng, 40 + (int)(rng() % 200)));
+            dur &= r.Duration() == BruteDuration(r);
+            all &= QueriesMatch(r, rng, 200);
+        }
+        Check(dur, "30 charts aleatorios: Duration = máx(time + sustain)");
+        Check(all, "Range / Overlaps / Density iguales que recorrer todas las notas");
+    }
+
+    void VerifyRegistry(const fs::path& dir) {
+        std::printf("handles\n");
+        std::mt19937_64 rng(9);
+        fs::path p = dir / "songs" / "prueba" / "prueba-hard.json";
+        WriteFile(p, RandomChart(rng, 50));
+        ChartRegistry reg;
+        uint32_t a = reg.Open(p), b = reg.Open(dir / "songs" / "prueba" / "." / "prueba-hard.json");
+        Check(a != 0 && a == b && reg.OpenCount() == 1, "el mismo archivo abierto dos veces: mismo handle, un solo índice");
+        reg.Close(a);
+        Check(reg.Get(b) != nullptr, "tras el primer Close el otro que lo abrió sigue viéndolo");
+        reg.Close(b);
+        Check(reg.Get(a) == nullptr && reg.OpenCount() == 0, "con el último Close se libera");
+        reg.Close(a); // De más: no hace nada
+        Check(reg.Open(dir / "no-existe.json") == 0, "archivo que no existe: handle 0");
+
+        uint32_t v1 = reg.Open(p);
+        size_t count1 = reg.Get(v1)->Count();
+        WriteFile(p, RandomChart(rng, 80));
+        uint32_t v2 = reg.Open(p);
+        Check(v2 != v1 && reg.Get(v2) && reg.Get(v2)->Count() != count1, "el archivo cambió de tamaño: Open lo reindexa con otro handle");
+        Check(reg.Get(v1) && reg.Get(v1)->Count() == count1, "el handle viejo sigue con su versión hasta cerrarlo");
+        reg.Close(v1);
+        uint32_t v3 = reg.Open(p);
+        Check(v3 == v2 && reg.OpenCount() == 1, "cerrar el viejo no afecta al nuevo; abrir otra vez reutiliza el nuevo");
+        reg.Close(v2); reg.Close(v3);
+
+        // Mismo tamaño, otro contenido: solo cambia la fecha
+        std::string before = "{\"song\":{\"notes\":[{\"sectionNotes\":[[1000,1,0]]}]}}";
+        std::string after = "{\"song\":{\"notes\":[{\"sectionNotes\":[[2000,1,0]]}]}}";
+        WriteFile(p, before);
+        uint32_t s1 = reg.Open(p);
+        WriteFile(p, after);
+        std::error_code ec;
+        fs::last_write_time(p, fs::last_write_time(p, ec) + std::chrono::seconds(2), ec);
+        uint32_t s2 = reg.Open(p);
+        Check(s2 != s1 && reg.Get(s2) && reg.Get(s2)->time.front() == 2000, "mismo tamaño y otra fecha: también se reindexa");
+        reg.Close(s1); reg.Close(s2);
+        Check(reg.OpenCount() == 0, "todo cerrado");
+
+        // Open y Close desde varios hilos: las referencias cuadran
+        WriteFile(p, RandomChart(rng, 100));
+        std::atomic<int> bad{ 0 };
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 6; t++) {
+            threads.emplace_back([&] {
+                for (int i = 0; i < 300; i++) {
+                    uint32_t h = reg.Open(p);
+                    if (!h || !reg.Get(h)) bad++;
+                    std::this_thread::yield();
+                    if (!reg.Get(h)) bad++;
+                    reg.Close(h);
+                }
+            });
+        }
+        for (auto& t : threads) t.join();
+        Check(bad == 0 && reg.OpenCount() == 0, "6 hilos abriendo y cerrando el mismo chart: nadie pierde su handle, nada queda abierto");
+    }
+
+    void VerifyData(const fs::path& root) {
+        std::vector<fs::path> charts = Charts(root);
+        std::printf("charts de %s (%zu)\n", (root / "public" / "songs").u8string().c_str(), charts.size());
+        std::mt19937_64 rng(3);
+        size_t parsed = 0, notes = 0, longer = 0;
+        bool dur = true, queries = true;
+        std::vector<std::string> failed;
+        for (const fs::path& p : charts) {
+            ChartIndex c;
+            std::string err;
+            if (!c.Load(p, &err)) { failed.push_back(p.filename().u8string() + ": " + err); continue; }
+            parsed++;
+            notes += c.Count();
+            dur &= c.Duration() == BruteDuration(c);
+            if (c.Count() && c.Duration() > c.time.back() + c.sustain.back()) longer++;
+            queries &= QueriesMatch(c, rng, 50);
+        }
+        for (const auto& f : failed) std::printf("  (sin indexar) %s\n", f.c_str());
+        char what[160];
+        std::snprintf(what, sizeof(what), "%zu charts, %zu notas indexadas", parsed, notes);
+        Check(!charts.empty() && parsed > 0, what);
+        std::snprintf(what, sizeof(what), "Duration = máx(time + sustain) en todos (%zu acaban en una sostenida anterior a la última nota)", longer);
+        Check(dur, what);
+        Check(queries, "consultas iguales que recorrer todas las notas en todos los charts");
+    }
+
+    int Verify(const std::string& rootArg) {
+        fs::path root;
+        if (!rootArg.empty() && (root = ProjectRoot(rootArg, "chartbench")).empty()) return 2;
+        fs::path dir = MakeTempDir("chartbench");
+        VerifyIndex();
+        VerifyRegistry(dir);
+        if (!root.empty()) VerifyData(root);
+        std::error_code ec;
+        fs::remove_all(dir, ec);
+        std::printf(failures ? "\n%d fallos\n" : "\ntodo bien\n", failures);
+        return failures ? 1 : 0;
+    }
+
+    int Bench(const std::string& rootArg) {
+        fs::path root = ProjectRoot(rootArg, "chartbench");
+        if (root.empty()) return 2;
+        std::vector<fs::path> charts = Charts(root);
+        if (charts.empty()) { std::fprintf(stderr, "chartbench: no hay charts en %s\n", (root / "public" / "songs").u8string().c_str()); return 2; }
+        std::printf("chartbench: %zu charts de %s\n\n", charts.size(), (root / "public" / "songs").u8string().c_str());
+
+        ChartRegistry reg;
+        std::vector<uint32_t> handles;
+        uintmax_t bytes = 0;
+        size_t notes = 0;
+        auto t0 = Clock::now();
+        for (const fs::path& p : charts) {
+            uint32_t h = reg.Open(p);
+            if (!h) continue;
+            handles.push_back(h);
+            notes += reg.Get(h)->Count();
+            std::error_code ec;
+            bytes += fs::file_size(p, ec);
+        }
+        auto index = Clock::now() - t0;
+        std::printf("  indexar todos                 %8.1f ms   %zu charts, %zu notas, %.1f MB/s\n",
+                    Ms(index), handles.size(), notes, bytes / 1048576.0 / Seconds(index));
+
+        t0 = Clock::now();
+        int rounds = 20;
+        for (int r = 0; r < rounds; r++) for (const fs::path& p : charts) reg.Close(reg.Open(p));
+        std::printf("  Open reutilizado (stat)       %8.2f us   por Open\n", Ms(Clock::now() - t0) * 1000 / (rounds * charts.size()));
+
+        // Ventanas de 2 s recorriendo cada canción como lo haría el editor
+        std::mt19937_64 rng(1);
+        size_t queries = 0, found = 0, scanned = 0;
+        Clock::duration indexed{}, linear{};
+        for (uint32_t h : handles) {
+            auto c = reg.Get(h);
+            for (double t = 0; t < c->Duration(); t += 500) {
+                auto a = Clock::now();
+                auto range = c->Range(t, t + 2000, true);
+                for (size_t i = range.first; i < range.second; i++) found += c->Overlaps(i, t);
+                auto b = Clock::now();
+                for (size_t i = 0; i < c->Count(); i++) {
+                    scanned += (c->time[i] >= t && c->time[i] < t + 2000) || (c->time[i] < t && c->time[i] + c->sustain[i] >= t);
+                }
+                linear += Clock::now() - b;
+                indexed += b - a;
+                queries++;
+            }
+        }
+        std::printf("  ventana de 2 s con índice     %8.3f us   por consulta (%zu consultas)\n", Ms(indexed) * 1000 / queries, queries);
+        std::printf("  ventana de 2 s recorriendo    %8.3f us   por consulta\n", Ms(linear) * 1000 / queries);
+        if (found != scanned) std::printf("  (!) el índice devolvió %zu notas y el recorrido %zu\n", found, scanned);
+
+        double maxLate = 0;
+        std::string which;
+        for (uint32_t h : handles) {
+            auto c = reg.Get(h);
+            if (!c->Count()) continue;
+            double late = c->Duration() - (c->time.back() + c->sustain.back());
+            if (late > maxLate) { maxLate = late; which = c->song; }
+        }
+        if (maxLate > 0) std::printf("  Duration: hasta %.0f ms más que time.back() + sustain.back() (%s)\n", maxLate, which.c_str());
+        for (uint32_t h : handles) reg.Close(h);
+        return 0;
+    }
+
+    int Run(const std::vector<std::string>& args) {
+        if (!args.empty() && args[0] == "--verify") return Verify(args.size() >= 2 ? args[1] : "");
+        if (!args.empty() && args[0] == "--bench") return Bench(args.size() >= 2 ? args[1] : "");
+        std::fprintf(stderr, "uso: chartbench --verify [raíz] | --bench [raíz]\n");
+        return 2;
+    }
+}
+
+#ifdef _WIN32
+int wmain(int argc, wchar_t** argv) {
+    std::vector<std::string> args;
+    for (int i = 1; i < argc; i++) args.push_back(Utf::ToUtf8(argv[i]));
+    return Run(args);
+}
+#else
+int main(int argc, char** argv) {
+    return Run(std::vector<std::string>(argv + 1, argv + argc));
+}
+#endif
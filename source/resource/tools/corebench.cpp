@@ -0,0 +1,433 @@
+/**
+ * corebench - Micro-benchmarks del núcleo portable (config, UTF, despacho RPC, AppData).
+ *
+ * Uso:
+ *   corebench --verify                                     Comprueba que lo medido hace lo que debe
+ *   corebench --bench [--json <archivo|->] [--filter <texto>] [--min-ms <ms>]
+ *
+ * Cada caso se repite en 5 rondas de al menos min-ms/5 ms (por defecto 500 ms en total) y se
+ * informa la mediana y la mejor ronda en ns/op. Con --json el resultado queda en un archivo
+ * (o en stdout con "-") para seguir regresiones entre builds; el build (tipo, LTO, PGO) va en
+ * la cabecera. El despacho replica la tabla de verbos de WebViewManager: las rutas que tocan
+ * la ventana son stubs, saveFile/loadFile/storageStats usan un WriteBehindStore real.
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <vector>
+#include "../core/AtomicFile.h"
+#include "../core/Config.h"
+#include "../core/Json.h"
+#include "../core/Rpc.h"
+#include "../core/Utils.h"
+#include "../core/WriteBehindStore.h"
+#include "Tool.h"
+
+#ifndef GENESIS_BUILD_TYPE
+#define GENESIS_BUILD_TYPE "unknown"
+#endif
+#ifndef GENESIS_BUILD_FLAGS
+#define GENESIS_BUILD_FLAGS ""
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+
+    using namespace Tool;
+
+    /** Evita que el optimizador descarte el trabajo medido. */
+    volatile size_t sink = 0;
+
+    const char* kConfigJson = R"({
+  "title": "FNF: Genesis Engine",
+  "version": "1.0.0",
+  "appID": "com.genesis.engine",
+  "author": "ImBritex",
+
+  "width": 1280,
+  "height": 720,
+  "minWidth": 800,
+  "minHeight": 600,
+  "icon": "icons/icon.ico",
+  "backgroundColor": "#000000",
+
+  "startMaximized": false,
+  "resizable": true,
+  "fullscreen": false,
+  "frame": true,
+  "alwaysOnTop": false,
+
+  "singleInstance": true,
+  "hardwareAcceleration": true,
+  "devTools": true,
+  "fpsLimit": 60,
+  "saveCoalesceMs": 250,
+  "assetPack": "assets.gpak"
+})";
+
+    /** Texto de prueba: ASCII puro o mezclado (latín, CJK y emoji, como nombres de canciones y charts). */
+    std::string MakeText(size_t bytes, bool mixed) {
+        static const char* kPieces[] = { "Bopeebo ", "canción ", "ñandú ", "テスト ", "歌曲 ", "\xF0\x9F\x8E\xB5 " };
+        std::string s;
+        size_t i = 0;
+        while (mixed && s.size() + std::char_traits<char>::length(kPieces[i % 6]) <= bytes) s += kPieces[i++ % 6];
+        while (s.size() < bytes) s += (char)('a' + (i++ % 26)); // relleno ASCII: sin secuencias cortadas
+        return s;
+    }
+
+    // --- Tabla de despacho equivalente a la de WebViewManager ---
+
+    struct BenchContext {
+        WriteBehindStore* store = nullptr;
+        std::wstring title;
+        int width = 0, height = 0;
+    };
+
+    using Dispatcher = RpcDispatcher<BenchContext>;
+
+    bool OnStub(BenchContext&, const RpcRequest&, std::wstring&) { return true; }
+
+    bool OnResize(BenchContext& ctx, const RpcRequest& req, std::wstring& out) {
+        std::wstring_view d = req.payload;
+        int w = RpcCodec::ParseInt(RpcCodec::NextToken(d, L','), -1);
+        int h = RpcCodec::ParseInt(d, -1);
+        if (w <= 0 || h <= 0) { out = L"invalid size"; return false; }
+        ctx.width = w; ctx.height = h;
+        return true;
+    }
+
+    bool OnSetTitle(BenchContext& ctx, const RpcRequest& req, std::wstring&) {
+        ctx.title.assign(req.payload.data(), req.payload.size());
+        return true;
+    }
+
+    bool OnSaveFile(BenchContext& ctx, const RpcRequest& req, std::wstring& out) {
+        size_t pipe = req.payload.find(L'|');
+        if (pipe == std::wstring_view::npos) { out = L"missing key"; return false; }
+        std::string key = WriteBehindStore::PageKey(Utils::ToString(req.payload.substr(0, pipe)));
+        if (!ctx.store->Put(key, Utils::ToString(req.payload.substr(pipe + 1)))) { out = L"invalid key"; return false; }
+        return true;
+    }
+
+    bool OnLoadFile(BenchContext& ctx, const RpcRequest& req, std::wstring& out) {
+        std::string content;
+        if (ctx.store->Get(WriteBehindStore::PageKey(Utils::ToString(req.payload)), content)) Utils::AppendWString(out, content);
+        return true;
+    }
+
+    bool OnStorageStats(BenchContext& ctx, const RpcRequest&, std::wstring& out) {
+        WriteBehindStore::Stats st = ctx.store->GetStats();
+        for (uint64_t v : { st.puts, st.coalesced, st.commits, st.batches, st.bytes }) {
+            if (!out.empty()) out += L'|';
+            RpcCodec::AppendNumber(out, v);
+        }
+        return true;
+    }
+
+    /** Sin ejecutor: todas las rutas corren Inline, así se mide el handler junto con el despacho. */
+    void RegisterRoutes(Dispatcher& d) {
+        d.Register(L"resize", OnResize);
+        d.Register(L"maximize", OnStub);
+        d.Register(L"minimize", OnStub);
+        d.Register(L"close", OnStub);
+        d.Register(L"setTitle", OnSetTitle);
+        d.Register(L"saveFile", OnSaveFile);
+        d.Register(L"storageFlush", OnStub, {}, false, RpcMode::Serial);
+        d.Register(L"storageStats", OnStorageStats);
+        d.Register(L"loadFile", OnLoadFile, L"fileLoaded:", true, RpcMode::Pool);
+        for (const wchar_t* verb : { L"loadStream", L"streamRead", L"streamClose", L"listDir", L"listTree", L"fsWatch",
+                                     L"openExternal", L"chartOpen", L"chartNotes", L"chartDensity", L"chartClose",
+                                     L"peaksOpen", L"peaksTile", L"peaksClose", L"msgBox", L"openFile", L"getMemory",
+                                     L"perfFrames", L"perfStats", L"perfTrace", L"discord", L"cancel" })
+            d.Register(verb, OnStub);
+    }
+
+    std::wstring Envelope(const std::vector<std::pair<std::wstring, std::wstring>>& frames) {
+        std::wstring msg(RpcCodec::kMagic);
+        uint32_t id = 1;
+        for (const auto& f : frames) RpcCodec::AppendFrame(msg, id++, f.first, f.second);
+        return msg;
+    }
+
+    void SetAppDataOverride(const fs::path& dir) {
+#ifdef _WIN32
+        _wputenv_s(L"GENESIS_APPDATA", dir.wstring().c_str());
+#else
+        setenv("GENESIS_APPDATA", dir.string().c_str(), 1);
+#endif
+    }
+
+    // --- Verificación ---
+
+    int Verify() {
+        std::printf("config\n");
+        {
+            AppConfig c;
+            Check(ConfigLoader::Parse(kConfigJson, c), "parsea windowConfig.json");
+            Check(c.title == L"FNF: Genesis Engine" && c.icon == L"icons/icon.ico" && c.appID == L"com.genesis.engine", "cadenas");
+            Check(c.width == 1280 && c.height == 720 && c.minWidth == 800 && c.minHeight == 600, "dimensiones");
+            Check(c.fpsLimit == 60 && c.saveCoalesceMs == 250 && c.assetPack == L"assets.gpak", "fps, coalescencia y paquete");
+            Check(!c.startMaximized && c.resizable && !c.fullscreen && c.frame && !c.alwaysOnTop && c.singleInstance && c.devTools, "booleanos");
+
+            AppConfig d;
+            ConfigLoader::Parse(R"({"title":"","assetPack":"","width":"ancho","frame":1})", d);
+            Check(d.title == L"Genesis Engine" && d.assetPack.empty() && d.width == 1280 && d.frame, "vacíos y tipos erróneos conservan el defecto (assetPack vacío = carpeta)");
+            Check(!ConfigLoader::Parse("{ roto", d) && d.title == L"Genesis Engine", "JSON roto no cambia nada");
+
+            fs::path dir = MakeTempDir("corebench");
+            AppConfig missing = ConfigLoader::Load(dir);
+            Check(missing.fpsLimit == 300 && missing.title == L"Genesis Engine", "sin archivo: valores por defecto");
+            std::string err;
+            AtomicFile::Write(dir / "windowConfig.json", kConfigJson, err);
+            Check(ConfigLoader::Load(dir).fpsLimit == 60, "Load lee <exeDir>/windowConfig.json");
+            std::error_code ec; fs::remove_all(dir, ec);
+        }
+
+        std::printf("utf\n");
+        {
+            std::string mixed = MakeText(4096, true);
+            Check(Utils::ToString(Utils::ToWString(mixed)) == mixed, "ida y vuelta UTF-8 -> wide -> UTF-8");
+            Check(Utils::ToWString("ñ\xF0\x9F\x8E\xB5") == std::wstring(L"ñ") + (sizeof(wchar_t) == 2 ? std::wstring(L"\xD83C\xDFB5") : std::wstring(1, (wchar_t)0x1F3B5)), "BMP y plano astral");
+            Check(Utils::ToWString("a\xFF" "b") == L"a\xFFFD" L"b", "bytes inválidos -> U+FFFD");
+            Check(Utils::ToWString("").empty() && Utils::ToString(L"").empty(), "vacíos");
+        }
+
+        std::printf("rpc\n");
+        {
+            fs::path dir = MakeTempDir("corebench");
+            WriteBehindStore store(dir, std::chrono::milliseconds(50));
+            BenchContext ctx; ctx.store = &store;
+            Dispatcher d;
+            RegisterRoutes(d);
+            std::wstring last;
+            auto post = [&last](const std::wstring& reply) { last = reply; };
+
+            last.clear();
+            d.Dispatch(ctx, L"setTitle:Hola", post);
+            Check(ctx.title == L"Hola" && last.empty(), "legado sin respuesta");
+            d.Dispatch(ctx, Envelope({ { L"resize", L"800,600" }, { L"resize", L"x" }, { L"nope", L"" } }), post);
+            Check(ctx.width == 800 && ctx.height == 600, "sobre: handler ejecutado");
+            Check(last == L"#1|1|ok|0|2|err|12|invalid size3|err|18|unknown verb: nope", "sobre: una respuesta agrupada");
+            d.Dispatch(ctx, Envelope({ { L"saveFile", L"song.json|{\"bpm\":150}" } }), post);
+            last.clear();
+            d.Dispatch(ctx, L"loadFile:song", post);
+            Check(last == L"fileLoaded:song|{\"bpm\":150}", "saveFile + loadFile legado (caché sucia)");
+            store.Flush();
+            std::string disk;
+            Check(AtomicFile::ReadAll(dir / "song.json", disk) && disk == "{\"bpm\":150}", "el volcado llega a disco");
+            store.Stop();
+            std::error_code ec; fs::remove_all(dir, ec);
+        }
+
+        std::printf("appdata\n");
+        {
+            fs::path dir = MakeTempDir("corebench");
+            SetAppDataOverride(dir);
+            Check(Utils::AppDataPath(L"com.genesis.test", L"a.json") == dir / L"com.genesis.test" / L"a.json", "GENESIS_APPDATA sustituye la carpeta de datos");
+            std::wstring content = Utils::ToWString(MakeText(10000, true));
+            Check(Utils::SaveToAppData(L"com.genesis.test", L"a.json", content), "SaveToAppData crea la carpeta");
+            Check(Utils::LoadFromAppData(L"com.genesis.test", L"a.json") == content, "LoadFromAppData devuelve lo guardado");
+            Check(Utils::LoadFromAppData(L"com.genesis.test", L"missing.json").empty(), "archivo ausente -> vacío");
+            std::error_code ec; fs::remove_all(dir, ec);
+        }
+
+        std::printf(failures ? "\n%d fallos\n" : "\ntodo bien\n", failures);
+        return failures ? 1 : 0;
+    }
+
+    // --- Benchmarks ---
+
+    struct Result {
+        std::string name;
+        double medianNs = 0, bestNs = 0;
+        uint64_t iterations = 0;
+        size_t bytesPerOp = 0;
+    };
+
+    struct Runner {
+        std::string filter;
+        double minMs = 500;
+        std::vector<Result> results;
+
+        /**
+         * Mide `fn` (una operación por llamada). Calibra el tamaño del lote para que cada
+         * ronda dure al menos minMs/5 y se queda con la mediana de 5 rondas.
+         */
+        void Run(const std::string& name, size_t bytesPerOp, const std::function<void()>& fn) {
+            if (!filter.empty() && name.find(filter) == std::string::npos) return;
+            const int kRounds = 5;
+            double roundNs = minMs * 1e6 / kRounds;
+            uint64_t batch = 1;
+            while (true) {
+                auto t0 = Clock::now();
+                for (uint64_t i = 0; i < batch; i++) fn();
+                double ns = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - t0).count();
+                if (ns >= roundNs / 10 || batch >= (1ull << 30)) { batch = std::max<uint64_t>(1, (uint64_t)(batch * roundNs / std::max(ns, 1.0))); break; }
+                batch *= 10;
+            }
+            std::vector<double> perOp;
+            for (int r = 0; r < kRounds; r++) {
+                auto t0 = Clock::now();
+                for (uint64_t i = 0; i < batch; i++) fn();
+                perOp.push_back((double)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - t0).count() / batch);
+            }
+            std::sort(perOp.begin(), perOp.end());
+            Result res{ name, perOp[kRounds / 2], perOp[0], batch * kRounds, bytesPerOp };
+            if (bytesPerOp) std::fprintf(stderr, "  %-32s %12.1f ns/op  (mejor %10.1f)  %8.1f MB/s\n", name.c_str(), res.medianNs, res.bestNs, bytesPerOp / res.medianNs * 1e3);
+            else std::fprintf(stderr, "  %-32s %12.1f ns/op  (mejor %10.1f)\n", name.c_str(), res.medianNs, res.bestNs);
+            results.push_back(std::move(res));
+        }
+    };
+
+    std::string CompilerName() {
+#if defined(__clang__)
+        return "clang " __clang_version__;
+#elif defined(__GNUC__)
+        return "gcc " __VERSION__;
+#elif defined(_MSC_VER)
+        return "msvc " + std::to_string(_MSC_FULL_VER);
+#else
+        return "unknown";
+#endif
+    }
+
+    std::string ToJson(const Runner& runner) {
+        std::string j = "{\"schema\":1,\"tool\":\"corebench\",\"timestamp\":";
+        Json::AppendNumber(j, (double)std::time(nullptr));
+        j += ",\"build\":{\"compiler\":"; Json::AppendString(j, CompilerName());
+        j += ",\"type\":"; Json::AppendString(j, GENESIS_BUILD_TYPE);
+        j += ",\"flags\":"; Json::AppendString(j, GENESIS_BUILD_FLAGS);
+        j += "},\"results\":[";
+        for (size_t i = 0; i < runner.results.size(); i++) {
+            const Result& r = runner.results[i];
+            if (i) j += ',';
+            j += "\n{\"name\":"; Json::AppendString(j, r.name);
+            j += ",\"ns_per_op\":"; Json::AppendNumber(j, r.medianNs);
+            j += ",\"best_ns_per_op\":"; Json::AppendNumber(j, r.bestNs);
+            j += ",\"iterations\":"; Json::AppendNumber(j, (double)r.iterations);
+            j += ",\"bytes_per_op\":"; Json::AppendNumber(j, (double)r.bytesPerOp);
+            j += '}';
+        }
+        j += "\n]}\n";
+        return j;
+    }
+
+    int Bench(const std::vector<std::string>& args) {
+        Runner runner;
+        std::string jsonOut;
+        for (size_t i = 0; i + 1 < args.size(); i++) {
+            if (args[i] == "--json") jsonOut = args[++i];
+            else if (args[i] == "--filter") runner.filter = args[++i];
+            else if (args[i] == "--min-ms") runner.minMs = std::max(1.0, std::atof(args[++i].c_str()));
+        }
+        std::fprintf(stderr, "corebench (%s, %s%s%s)\n", CompilerName().c_str(), GENESIS_BUILD_TYPE, *GENESIS_BUILD_FLAGS ? " " : "", GENESIS_BUILD_FLAGS);
+        fs::path dir = MakeTempDir("corebench");
+
+        // Config
+        runner.Run("config.parse", std::char_traits<char>::length(kConfigJson), [] {
+            AppConfig c; ConfigLoader::Parse(kConfigJson, c); sink = sink + (size_t)c.fpsLimit;
+        });
+        {
+            std::string err;
+            AtomicFile::Write(dir / "windowConfig.json", kConfigJson, err);
+            runner.Run("config.load", std::char_traits<char>::length(kConfigJson), [&dir] { sink = sink + (size_t)ConfigLoader::Load(dir).width; });
+        }
+
+        // UTF
+        for (bool mixed : { false, true }) {
+            for (size_t size : { (size_t)64, (size_t)4096, (size_t)65536 }) {
+                std::string narrow = MakeText(size, mixed);
+                std::wstring wide = Utils::ToWString(narrow);
+                std::string suffix = std::string(mixed ? ".mixed." : ".ascii.") + std::to_string(size);
+                runner.Run("utf.towstring" + suffix, narrow.size(), [&narrow] { sink = sink + Utils::ToWString(narrow).size(); });
+                runner.Run("utf.tostring" + suffix, narrow.size(), [&wide] { sink = sink + Utils::ToString(wide).size(); });
+#ifdef _WIN32
+                runner.Run("utf.towstring.win32" + suffix, narrow.size(), [&narrow] {
+                    int n = MultiByteToWideChar(CP_UTF8, 0, narrow.data(), (int)narrow.size(), NULL, 0);
+                    std::wstring w(n, 0);
+                    MultiByteToWideChar(CP_UTF8, 0, narrow.data(), (int)narrow.size(), &w[0], n);
+                    sink = sink + w.size();
+                });
+                runner.Run("utf.tostring.win32" + suffix, narrow.size(), [&wide] {
+                    int n = WideCharToMultiByte(CP_UTF8, 0, wide.data(), (int)wide.size(), NULL, 0, NULL, NULL);
+                    std::string s(n, 0);
+                    WideCharToMultiByte(CP_UTF8, 0, wide.data(), (int)wide.size(), &s[0], n, NULL, NULL);
+                    sink = sink + s.size();
+                });
+#endif
+            }
+        }
+
+        // Despacho
+        {
+            // Ventana de coalescencia larga: el volcado a disco no entra en la medida del despacho
+            WriteBehindStore store(dir / "store", std::chrono::milliseconds(60000));
+            BenchContext ctx; ctx.store = &store;
+            Dispatcher d;
+            RegisterRoutes(d);
+            size_t replies = 0;
+            auto post = [&replies](const std::wstring& reply) { replies += reply.size(); };
+
+            std::wstring legacy = L"setTitle:FNF: Genesis Engine - Week 1";
+            std::wstring one = Envelope({ { L"resize", L"1280,720" } });
+            std::wstring eight = Envelope({ { L"resize", L"1280,720" }, { L"setTitle", L"Editor" }, { L"storageStats", L"" },
+                                            { L"perfFrames", L"main|0|1,2,3" }, { L"chartNotes", L"1|0|1000" }, { L"peaksTile", L"1|0|0" },
+                                            { L"discord", L"Editando|Bopeebo" }, { L"maximize", L"" } });
+            std::wstring body = Utils::ToWString(MakeText(4096, true));
+            std::wstring save = Envelope({ { L"saveFile", L"song.json|" + body } });
+            std::wstring load = L"loadFile:song";
+
+            runner.Run("rpc.legacy", legacy.size() * sizeof(wchar_t), [&] { d.Dispatch(ctx, legacy, post); });
+            runner.Run("rpc.envelope.1", one.size() * sizeof(wchar_t), [&] { d.Dispatch(ctx, one, post); });
+            runner.Run("rpc.envelope.8", eight.size() * sizeof(wchar_t), [&] { d.Dispatch(ctx, eight, post); });
+            runner.Run("rpc.savefile.4k", save.size() * sizeof(wchar_t), [&] { d.Dispatch(ctx, save, post); });
+            runner.Run("rpc.loadfile.4k", body.size() * sizeof(wchar_t), [&] { d.Dispatch(ctx, load, post); });
+            sink = sink + replies;
+            store.Stop();
+        }
+
+        // AppData
+        SetAppDataOverride(dir / "appdata");
+        for (size_t size : { (size_t)4096, (size_t)262144 }) {
+            std::wstring content = Utils::ToWString(MakeText(size, true));
+            std::string suffix = "." + std::to_string(size / 1024) + "k";
+            runner.Run("file.save" + suffix, size, [&content] { sink = sink + Utils::SaveToAppData(L"com.genesis.bench", L"save.json", content); });
+            runner.Run("file.load" + suffix, size, [] { sink = sink + Utils::LoadFromAppData(L"com.genesis.bench", L"save.json").size(); });
+        }
+
+        std::error_code ec; fs::remove_all(dir, ec);
+
+        if (jsonOut.empty()) return 0;
+        std::string json = ToJson(runner);
+        if (jsonOut == "-") { std::fwrite(json.data(), 1, json.size(), stdout); return 0; }
+        std::string err;
+        if (!AtomicFile::Write(fs::u8path(jsonOut), json, err)) { std::fprintf(stderr, "no se pudo escribir %s: %s\n", jsonOut.c_str(), err.c_str()); return 1; }
+        std::fprintf(stderr, "resultados en %s\n", jsonOut.c_str());
+        return 0;
+    }
+
+    int Run(const std::vector<std::string>& args) {
+        if (!args.empty() && args[0] == "--verify") return Verify();
+        if (!args.empty() && args[0] == "--bench") return Bench(std::vector<std::string>(args.begin() + 1, args.end()));
+        std::fprintf(stderr, "uso: corebench --verify | --bench [--json <archivo|->] [--filter <texto>] [--min-ms <ms>]\n");
+        return 2;
+    }
+}
+
+#ifdef _WIN32
+int wmain(int argc, wchar_t** argv) {
+    std::vector<std::string> args;
+    for (int i = 1; i < argc; i++) args.push_back(Utils::ToString(argv[i]));
+    return Run(args);
+}
+#else
+int main(int argc, char** argv) {
+    return Run(std::vector<std::string>(argv + 1, argv + argc));
+}
+#endif
@@ -0,0 +1,323 @@
+/**
+ * dirbench - Banco de pruebas de la caché de carpetas (core/DirTree.h) y del watcher (core/DirWatcher.h).
+ * Genera un árbol sintético, compara recorrer el disco con listar desde la caché y comprueba que,
+ * después de crear/modificar/borrar/mover archivos y carpetas, la caché coincide con el disco.
+ *
+ * Uso:
+ *   dirbench [--files N] [--keep] [carpeta]   Por defecto 100000 archivos en una carpeta temporal
+ *   dirbench --verify [carpeta]               Solo coherencia (árbol pequeño); código de salida != 0 si falla
+ */
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../core/DirTree.h"
+#include "../core/DirWatcher.h"
+#include "Tool.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+    using namespace Tool;
+
+    void Touch(const fs::path& p, size_t bytes) {
+        std::ofstream f(p, std::ios::binary | std::ios::trunc);
+        std::string data(bytes, 'x');
+        f.write(data.data(), (std::streamsize)data.size());
+    }
+
+    /**
+     * 100 carpetas x 10 subcarpetas x (files / 1000) archivos, parecido a public/images.
+     */
+    void Generate(const fs::path& root, size_t files) {
+        size_t perLeaf = std::max<size_t>(1, files / 1000);
+        for (int a = 0; a < 100; a++) {
+            for (int b = 0; b < 10; b++) {
+                fs::path dir = root / ("group" + std::to_string(a)) / ("set" + std::to_string(b));
+                fs::create_directories(dir);
+                for (size_t f = 0; f < perLeaf; f++) Touch(dir / ("sprite" + std::to_string(f) + (f % 3 ? ".png" : ".xml")), f % 7);
+            }
+        }
+    }
+
+    /** Lo que haría listDir sin caché: recorrer el disco pidiendo tamaño y fecha de cada archivo. */
+    size_t WalkDisk(const fs::path& dir, std::vector<DirTreeCache::Item>& out) {
+        std::error_code ec;
+        for (auto it = fs::recursive_directory_iterator(dir, ec); !ec && it != fs::recursive_directory_iterator(); it.increment(ec)) {
+            DirTreeCache::Item item;
+            item.path = it->path().lexically_relative(dir).generic_u8string();
+            item.isDir = it->is_directory(ec);
+            item.size = item.isDir ? 0 : it->file_size(ec);
+            item.mtimeMs = std::chrono::duration_cast<std::chrono::milliseconds>(it->last_write_time(ec).time_since_epoch()).count();
+            out.push_back(std::move(item));
+        }
+        return out.size();
+    }
+
+    /**
+     * Aplica los lotes del watcher a la caché y avisa a quien espera por una ruta concreta.
+     */
+    struct Sink {
+        DirTreeCache& cache;
+        std::mutex mtx;
+        std::condition_variable cv;
+        uint64_t batches = 0, events = 0, overflows = 0;
+        std::string waitingFor;
+        bool seen = false;
+
+        explicit Sink(DirTreeCache& c) : cache(c) {}
+
+        void operator()(std::vector<DirWatcher::Change>& changes) {
+            cache.Apply(changes);
+            std::lock_guard<std::mutex> lock(mtx);
+            batches++;
+            events += changes.size();
+            for (const auto& c : changes) {
+                if (c.kind == DirWatcher::Kind::Overflow) overflows++;
+                if (!waitingFor.empty() && c.path == waitingFor) seen = true;
+            }
+            cv.notify_all();
+        }
+
+        void Expect(const std::string& path) {
+            std::lock_guard<std::mutex> lock(mtx);
+            waitingFor = path; seen = false;
+        }
+
+        bool Wait(std::chrono::milliseconds timeout) {
+            std::unique_lock<std::mutex> lock(mtx);
+            return cv.wait_for(lock, timeout, [&] { return seen; });
+        }
+
+        /** Espera a que el watcher deje de entregar lotes. */
+        void Quiesce(std::chrono::milliseconds quiet) {
+            std::unique_lock<std::mutex> lock(mtx);
+            uint64_t last;
+            do { last = batches; cv.wait_for(lock, quiet); } while (batches != last);
+        }
+    };
+
+    /**
+     * Compara la caché con una lectura directa del disco (tamaño y tipo; la fecha solo en archivos).
+     */
+    bool Coherent(DirTreeCache& cache, const fs::path& root, std::string& why) {
+        std::vector<DirTreeCache::Item> cached, disk;
+        if (!cache.List("", true, "", cached)) { why = "list failed"; return false; }
+        DirTreeCache fresh(root);
+        fresh.List("", true, "", disk);
+        if (cached.size() != disk.size()) { why = "count " + std::to_string(cached.size()) + " vs " + std::to_string(disk.size()); return false; }
+        for (size_t i = 0; i < disk.size(); i++) {
+            const auto& a = cached[i];
+            const auto& b = disk[i];
+            if (a.path != b.path || a.isDir != b.isDir || a.size != b.size || (!a.isDir && a.mtimeMs != b.mtimeMs)) {
+                why = "entry " + b.path + " (cache: " + a.path + ")";
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * Ráfaga de cambios aleatorios sobre el árbol: altas, escrituras, bajas, renombrados y carpetas movidas.
+     */
+    void Churn(const fs::path& root, int ops, std::mt19937& rng) {
+        std::error_code ec;
+        std::vector<fs::path> files, dirs;
+        for (auto it = fs::recursive_directory_iterator(root, ec); !ec && it != fs::recursive_directory_iterator(); it.increment(ec)) {
+            (it->is_directory(ec) ? dirs : files).push_back(it->path());
+        }
+        if (dirs.empty()) dirs.push_back(root);
+        auto pick = [&](std::vector<fs::path>& v) -> fs::path { return v.empty() ? fs::path() : v[rng() % v.size()]; };
+        for (int i = 0; i < ops; i++) {
+            switch (rng() % 6) {
+            case 0: { fs::path d = pick(dirs); Touch(d / ("new" + std::to_string(rng() % 100000) + ".png"), rng() % 64); break; }
+            case 1: { fs::path f = pick(files); if (!f.empty() && fs::exists(f, ec)) Touch(f, 100 + rng() % 64); break; }
+            case 2: { fs::path f = pick(files); if (!f.empty()) fs::remove(f, ec); break; }
+            case 3: { fs::path f = pick(files); if (!f.empty() && fs::exists(f, ec)) fs::rename(f, pick(dirs) / ("moved" + std::to_string(rng() % 100000) + ".json"), ec); break; }
+            case 4: {
+                fs::path d = pick(dirs) / ("dir" + std::to_string(rng() % 100000));
+                fs::create_directories(d / "inner", ec);
+                Touch(d / "a.txt", 3); Touch(d / "inner" / "b.txt", 5);
+                break;
+            }
+            case 5: {
+                // Mover una carpeta con contenido (no la raíz ni dentro de sí misma)
+                fs::path d = pick(dirs);
+                if (d == root || !fs::exists(d, ec)) break;
+                fs::path to = root / ("tree" + std::to_string(rng() % 100000));
+                fs::rename(d, to, ec);
+                break;
+            }
+            }
+        }
+    }
+
+    /**
+     * Get desde varios hilos a la vez: cada llamada cuenta como acierto o como lectura, ninguna se pierde.
+     */
+    bool CountersExact(const fs::path& root, std::string& why) {
+        DirTreeCache cache(root);
+        cache.SetLive(true);
+        std::vector<std::string> rels;
+        for (auto& e : fs::directory_iterator(root)) {
+            if (e.is_directory()) rels.push_back(e.path().filename().u8string());
+        }
+        rels.push_back("");
+        const unsigned threads = 8, calls = 20000;
+        std::vector<std::thread> pool;
+        for (unsigned t = 0; t < threads; t++) {
+            pool.emplace_back([&, t] {
+                for (unsigned i = 0; i < calls; i++) cache.Get(rels[(i + t) % rels.size()]);
+            });
+        }
+        for (auto& th : pool) th.join();
+        auto s = cache.GetStats();
+        uint64_t total = (uint64_t)threads * calls;
+        if (s.hits + s.scans == total) return true;
+        why = "aciertos + lecturas = " + std::to_string(s.hits + s.scans) + ", llamadas = " + std::to_string(total);
+        return false;
+    }
+
+    int Verify(const fs::path& root, bool generate) {
+        if (generate) Generate(root, 2000);
+        DirTreeCache cache(root);
+        Sink sink(cache);
+        DirWatcher watcher;
+        if (!watcher.Start(root, [&](std::vector<DirWatcher::Change>& c) { sink(c); })) { std::fprintf(stderr, "[ERROR] no se pudo vigilar %s\n", root.u8string().c_str()); return 1; }
+        cache.SetLive(true);
+        std::mt19937 rng(1234);
+        std::string why;
+        int failed = 0;
+        std::vector<DirTreeCache::Item> warm;
+        cache.List("", true, "", warm);
+        for (int round = 0; round < 20; round++) {
+            Churn(root, 50, rng);
+            sink.Quiesce(std::chrono::milliseconds(200));
+            if (!Coherent(cache, root, why)) { std::fprintf(stderr, "[FAIL] ronda %d: %s\n", round, why.c_str()); failed++; }
+        }
+        watcher.Stop();
+        if (!CountersExact(root, why)) { std::fprintf(stderr, "[FAIL] contadores con 8 hilos: %s\n", why.c_str()); failed++; }
+        auto s = cache.GetStats();
+        std::printf("dirbench verify: 20 rondas, %d fallos (%llu lotes, %llu eventos, %llu desbordamientos, %llu parches, %llu descartes)\n",
+            failed, (unsigned long long)sink.batches, (unsigned long long)sink.events, (unsigned long long)sink.overflows,
+            (unsigned long long)s.patches, (unsigned long long)s.drops);
+        return failed ? 1 : 0;
+    }
+
+    int Bench(const fs::path& root, size_t files, bool generate) {
+        if (generate) {
+            auto g0 = Clock::now();
+            Generate(root, files);
+            std::printf("dirbench: arbol generado en %.0f ms\n", Ms(Clock::now() - g0));
+        }
+        std::vector<DirTreeCache::Item> items;
+
+        auto t0 = Clock::now();
+        size_t walked = WalkDisk(root, items);
+        double walk = Ms(Clock::now() - t0);
+
+        DirTreeCache cache(root);
+        Sink sink(cache);
+        DirWatcher watcher;
+        auto w0 = Clock::now();
+        bool watching = watcher.Start(root, [&](std::vector<DirWatcher::Change>& c) { sink(c); });
+        double watchSetup = Ms(Clock::now() - w0);
+        cache.SetLive(watching);
+
+        items.clear();
+        auto c0 = Clock::now();
+        cache.List("", true, "", items);
+        double first = Ms(Clock::now() - c0);
+
+        const int repeats = 20;
+        auto r0 = Clock::now();
+        for (int i = 0; i < repeats; i++) { items.clear(); cache.List("", true, "", items); }
+        double repeat = Ms(Clock::now() - r0) / repeats;
+
+        // Una sola carpeta, como al navegar en el editor
+        std::string leaf = "group42/set7";
+        const int leafRepeats = 2000;
+        std::vector<DirTreeCache::Item> one;
+        auto l0 = Clock::now();
+        for (int i = 0; i < leafRepeats; i++) {
+            one.clear();
+            std::error_code ec;
+            for (const auto& e : fs::directory_iterator(root / leaf, ec)) one.push_back({ e.path().filename().u8string(), false, e.file_size(ec), 0 });
+        }
+        double leafDisk = Ms(Clock::now() - l0) * 1000.0 / leafRepeats;
+        auto l1 = Clock::now();
+        for (int i = 0; i < leafRepeats; i++) { one.clear(); cache.List(leaf, false, "*.png", one); }
+        double leafCache = Ms(Clock::now() - l1) * 1000.0 / leafRepeats;
+
+        std::printf("dirbench: %zu entradas, watcher %s (%.0f ms en montar)\n", walked, watching ? "activo" : "NO disponible", watchSetup);
+        std::printf("  disco recursivo        %9.2f ms\n", walk);
+        std::printf("  cache primera vez      %9.2f ms\n", first);
+        std::printf("  cache repetido         %9.2f ms  (%.0fx)\n", repeat, repeat > 0 ? walk / repeat : 0.0);
+        std::printf("  una carpeta: disco %.1f us, cache+glob %.1f us\n", leafDisk, leafCache);
+
+        if (watching) {
+            // Latencia: escribir un archivo -> lote aplicado en la caché
+            std::vector<double> lat;
+            for (int i = 0; i < 50; i++) {
+                std::string rel = leaf + "/latency" + std::to_string(i) + ".png";
+                sink.Expect(rel);
+                auto e0 = Clock::now();
+                Touch(root / fs::u8path(rel), 10);
+                if (sink.Wait(std::chrono::milliseconds(2000))) lat.push_back(Ms(Clock::now() - e0));
+            }
+            std::sort(lat.begin(), lat.end());
+            if (!lat.empty()) std::printf("  evento -> cache        p50 %.2f ms  p99 %.2f ms  (%zu/50)\n", lat[lat.size() / 2], lat[std::min(lat.size() - 1, lat.size() * 99 / 100)], lat.size());
+
+            std::mt19937 rng(42);
+            Churn(root, 500, rng);
+            sink.Quiesce(std::chrono::milliseconds(200));
+            std::string why;
+            bool ok = Coherent(cache, root, why);
+            auto s = cache.GetStats();
+            std::printf("  tras 500 cambios: %s%s  (%llu escaneos, %llu aciertos, %llu parches, %llu descartes)\n", ok ? "coherente" : "INCOHERENTE: ",
+                ok ? "" : why.c_str(), (unsigned long long)s.scans, (unsigned long long)s.hits, (unsigned long long)s.patches, (unsigned long long)s.drops);
+            watcher.Stop();
+            if (!ok) return 1;
+        }
+        return 0;
+    }
+
+    fs::path TempTree() {
+        fs::path p = fs::temp_directory_path() / ("dirbench-" + std::to_string(std::random_device{}()));
+        fs::create_directories(p);
+        return p;
+    }
+
+    int Run(const std::vector<fs::path>& args) {
+        bool verify = false, keep = false;
+        size_t files = 100000;
+        fs::path root;
+        for (size_t i = 0; i < args.size(); i++) {
+            std::string a = args[i].u8string();
+            if (a == "--verify") verify = true;
+            else if (a == "--keep") keep = true;
+            else if (a == "--files" && i + 1 < args.size()) files = (size_t)std::max(1000, std::atoi(args[++i].u8string().c_str()));
+            else if (a.rfind("--", 0) == 0) { std::fprintf(stderr, "Uso: dirbench [--files N] [--keep] [carpeta] | --verify [carpeta]\n"); return 1; }
+            else root = args[i];
+        }
+        bool generate = root.empty();
+        if (generate) root = TempTree();
+        int rc = verify ? Verify(root, generate) : Bench(root, files, generate);
+        if (generate && !keep) { std::error_code ec; fs::remove_all(root, ec); }
+        return rc;
+    }
+}
+
+#ifdef _WIN32
+int wmain(int argc, wchar_t** argv) { return Run(std::vector<fs::path>(argv + 1, argv + argc)); }
+#else
+int main(int argc, char** argv) { return Run(std::vector<fs::path>(argv + 1, argv + argc)); }
+#endif
@@ -0,0 +1,415 @@
+/**
+ * discordbench - Prueba el cliente de Rich Presence (core/DiscordIpc.h) contra un Discord falso
+ * que escucha en un socket Unix `discord-ipc-0` dentro de una carpeta temporal ($XDG_RUNTIME_DIR).
+ *
+ * Uso:
+ *   discordbench --verify        Reposo sin despertares, límite de envíos, PING/PONG, errores y reconexión
+ *   discordbench --bench [N]     Latencia de N actualizaciones seguidas (sin límite) y coste de generar el JSON
+ *
+ * Solo POSIX: el servidor de prueba usa sockets Unix.
+ */
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../core/DiscordIpc.h"
+#include "Tool.h"
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+#ifndef _WIN32
+namespace {
+
+    using namespace Tool;
+
+    /** Transporte sobre un descriptor ya aceptado, para reutilizar ReadFrame/WriteFrame en el servidor. */
+    class FdTransport : public DiscordIpc::Transport {
+    public:
+        explicit FdTransport(int fd) : fd(fd) {}
+        ~FdTransport() override { Close(); }
+        bool Connect() override { return fd >= 0; }
+        void Close() override { if (fd >= 0) { ::close(fd); fd = -1; } }
+        void Abort() override { if (fd >= 0) ::shutdown(fd, SHUT_RDWR); }
+        bool IsOpen() const override { return fd >= 0; }
+        bool Write(const void* data, size_t n) override { return ::send(fd, data, n, MSG_NOSIGNAL) == (ssize_t)n; }
+        DiscordIpc::IoResult Read(void* data, size_t n, int timeoutMs) override {
+            char* p = (char*)data;
+            while (n > 0) {
+                pollfd pfd = { fd, POLLIN, 0 };
+                int r = ::poll(&pfd, 1, timeoutMs);
+                if (r == 0) return DiscordIpc::IoResult::Timeout;
+                ssize_t got = r > 0 ? ::recv(fd, p, n, 0) : -1;
+                if (got <= 0) return DiscordIpc::IoResult::Closed;
+                p += got; n -= (size_t)got;
+            }
+            return DiscordIpc::IoResult::Ok;
+        }
+    private:
+        int fd;
+    };
+
+    /**
+     * @class FakeDiscord
+     * @description Servidor mínimo: contesta READY al handshake y confirma cada SET_ACTIVITY con su nonce.
+     * Puede mandar un PING antes de cada respuesta, contestar con ERROR o cortar la conexión.
+     */
+    class FakeDiscord {
+    public:
+        struct Received { Clock::time_point at; std::string details, state, raw; };
+
+        std::atomic<bool> pingFirst{false};
+        std::atomic<bool> replyError{false};
+        std::atomic<bool> mute{false};
+        std::atomic<int> pongs{0};
+        std::atomic<int> handshakes{0};
+
+        explicit FakeDiscord(fs::path dir) : path((dir / "discord-ipc-0").string()) {}
+        ~FakeDiscord() { Stop(); }
+
+        bool Start() {
+            Stop();
+            ::unlink(path.c_str());
+            listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+            sockaddr_un addr = {};
+            addr.sun_family = AF_UNIX;
+            std::snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", path.c_str());
+            if (listener < 0 || ::bind(listener, (sockaddr*)&addr, sizeof(addr)) != 0 || ::listen(listener, 4) != 0) return false;
+            running = true;
+            thread = std::thread(&FakeDiscord::Serve, this);
+            return true;
+        }
+
+        /** Cierra el socket de escucha y la conexión activa, como si Discord se hubiera cerrado. */
+        void Stop() {
+            if (!running.exchange(false)) return;
+            ::shutdown(listener, SHUT_RDWR);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (conn) conn->Abort();
+            }
+            thread.join();
+            ::close(listener);
+            listener = -1;
+            ::unlink(path.c_str());
+        }
+
+        std::vector<Received> Log() {
+            std::lock_guard<std::mutex> lock(mutex);
+            return log;
+        }
+
+        void ClearLog() {
+            std::lock_guard<std::mutex> lock(mutex);
+            log.clear();
+        }
+
+        /** Espera hasta que llegue un SET_ACTIVITY con ese state. */
+        bool WaitFor(const std::string& state, std::chrono::milliseconds timeout, Clock::time_point* at = nullptr) {
+            std::unique_lock<std::mutex> lock(mutex);
+            return arrived.wait_for(lock, timeout, [&] {
+                for (const auto& r : log) if (r.state == state) { if (at) *at = r.at; return true; }
+                return false;
+            });
+        }
+
+    private:
+        std::string path;
+        int listener = -1;
+        std::atomic<bool> running{false};
+        std::thread thread;
+        std::mutex mutex;
+        std::condition_variable arrived;
+        std::vector<Received> log;
+        std::unique_ptr<FdTransport> conn;
+
+        void Serve() {
+            while (running) {
+                int fd = ::accept(listener, nullptr, nullptr);
+                if (fd < 0) return;
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    conn = std::make_unique<FdTransport>(fd);
+                }
+                Session(*conn);
+                std::lock_guard<std::mutex> lock(mutex);
+                conn.reset();
+            }
+        }
+
+        void Session(FdTransport& t) {
+            uint32_t op = 0;
+            std::string json;
+            while (running && DiscordIpc::ReadFrame(t, op, json, 200) != DiscordIpc::IoResult::Closed) {
+                if (json.empty()) continue;
+                Json::Value v;
+                Json::Parse(json, v);
+                if (op == DiscordIpc::Pong) { pongs++; json.clear(); continue; }
+                if (op == DiscordIpc::Handshake) {
+                    handshakes++;
+                    DiscordIpc::WriteFrame(t, DiscordIpc::Frame, "{\"cmd\":\"DISPATCH\",\"data\":{\"v\":1},\"evt\":\"READY\",\"nonce\":null}");
+                    json.clear();
+                    continue;
+                }
+                if (op == DiscordIpc::Frame && v["cmd"].Str() == "SET_ACTIVITY") {
+                    const auto& act = v["args"]["activity"];
+                    {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        log.push_back({ Clock::now(), act["details"].Str(), act["state"].Str(), json });
+                    }
+                    arrived.notify_all();
+                    if (mute) { json.clear(); continue; }
+                    if (pingFirst) DiscordIpc::WriteFrame(t, DiscordIpc::Ping, "{\"ping\":1}");
+                    std::string reply = replyError
+                        ? "{\"cmd\":\"SET_ACTIVITY\",\"data\":{\"code\":4000,\"message\":\"bad activity\"},\"evt\":\"ERROR\",\"nonce\":"
+                        : "{\"cmd\":\"SET_ACTIVITY\",\"data\":{},\"evt\":null,\"nonce\":";
+                    Json::AppendString(reply, v["nonce"].Str());
+                    reply += '}';
+                    DiscordIpc::WriteFrame(t, DiscordIpc::Frame, reply);
+                }
+                json.clear();
+            }
+        }
+    };
+
+    struct TempDir {
+        fs::path path;
+        TempDir() {
+            path = fs::temp_directory_path() / ("discordbench-" + std::to_string(::getpid()));
+            fs::create_directories(path);
+            ::setenv("XDG_RUNTIME_DIR", path.c_str(), 1);
+        }
+        ~TempDir() { std::error_code ec; fs::remove_all(path, ec); }
+    };
+
+    DiscordIpc::Options TestOptions() {
+        DiscordIpc::Options o;
+        o.clientId = "1353177735031423028";
+        o.pid = (uint32_t)::getpid();
+        o.startTime = 1700000000;
+        o.buttons = { { "Ver Proyecto", "https://github.com/IamBritex/FNF-Genesis-Engine" } };
+        o.backoffMin = std::chrono::milliseconds(50);
+        o.backoffMax = std::chrono::milliseconds(400);
+        o.replyTimeoutMs = 1000;
+        return o;
+    }
+
+    DiscordIpc::Activity Act(const std::string& state, const std::string& details = "Freeplay") {
+        return { details, state, "fnf_icon", "Genesis Engine" };
+    }
+
+    bool WaitConnected(DiscordIpc::Client& c, std::chrono::milliseconds timeout) {
+        auto end = Clock::now() + timeout;
+        while (!c.IsConnected() && Clock::now() < end) std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        return c.IsConnected();
+    }
+
+    /** Espera a que las estadísticas del cliente cumplan `pred` (el hilo las actualiza tras leer la respuesta). */
+    template <typename Pred>
+    bool WaitStats(DiscordIpc::Client& c, Pred pred, std::chrono::milliseconds timeout) {
+        auto end = Clock::now() + timeout;
+        while (!pred(c.GetStats()) && Clock::now() < end) std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        return pred(c.GetStats());
+    }
+
+    int Verify() {
+        TempDir tmp;
+        FakeDiscord server(tmp.path);
+        if (!server.Start()) { std::fprintf(stderr, "discordbench: no se pudo abrir el socket en %s\n", tmp.path.c_str()); return 1; }
+
+        std::printf("discordbench --verify (%s)\n", tmp.path.c_str());
+        {
+            // Reposo: conectado y sin cambios, el hilo no debe despertarse
+            DiscordIpc::Client c(DiscordIpc::MakeDefaultTransport(), TestOptions());
+            c.Start();
+            Check(WaitConnected(c, std::chrono::seconds(2)), "handshake con READY");
+            uint64_t before = c.GetStats().wakeups;
+            std::this_thread::sleep_for(std::chrono::seconds(2));
+            uint64_t idle = c.GetStats().wakeups - before;
+            std::printf("         despertares en 2 s de reposo: %llu (el bucle anterior: 4)\n", (unsigned long long)idle);
+            Check(idle == 0, "sin despertares en reposo");
+
+            // Escapes y latencia de una actualización aislada
+            auto t0 = Clock::now();
+            c.SetActivity(Act("Week 1 \"Bopeebo\"\n", "Jugando\\Story"));
+            Clock::time_point at;
+            Check(server.WaitFor("Week 1 \"Bopeebo\"\n", std::chrono::seconds(2), &at), "SET_ACTIVITY recibido con comillas, \\ y salto de línea");
+            auto log = server.Log();
+            Check(!log.empty() && log.back().details == "Jugando\\Story", "details intacto");
+            std::printf("         latencia SetActivity -> servidor: %.3f ms\n", Ms(at - t0));
+
+            // Repetir el mismo estado no gasta envíos (una vez confirmado el primero)
+            WaitStats(c, [](const DiscordIpc::Stats& s) { return s.sent == 1; }, std::chrono::seconds(2));
+            c.SetActivity(Act("Week 1 \"Bopeebo\"\n", "Jugando\\Story"));
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            Check(server.Log().size() == 1 && c.GetStats().unchanged == 1, "estado repetido ignorado");
+
+            // PING antes de la respuesta
+            server.pingFirst = true;
+            c.SetActivity(Act("ping"));
+            server.WaitFor("ping", std::chrono::seconds(2));
+            WaitStats(c, [](const DiscordIpc::Stats& s) { return s.pings == 1 && s.sent == 2; }, std::chrono::seconds(2));
+            Check(server.pongs == 1 && c.GetStats().pings == 1 && c.IsConnected(), "PING contestado con PONG");
+            server.pingFirst = false;
+
+            // Respuesta de error: se cuenta, pero la conexión sigue
+            server.replyError = true;
+            c.SetActivity(Act("rechazado"));
+            server.WaitFor("rechazado", std::chrono::seconds(2));
+            WaitStats(c, [](const DiscordIpc::Stats& s) { return s.errors == 1; }, std::chrono::seconds(2));
+            auto st = c.GetStats();
+            Check(st.errors == 1 && st.lastError == "bad activity" && c.IsConnected(), "evt ERROR registrado sin desconectar");
+            server.replyError = false;
+            c.Stop();
+        }
+        {
+            // Ráfaga: 200 cambios seguidos con un límite de 5 cada 400 ms
+            server.ClearLog();
+            auto o = TestOptions();
+            o.rateWindow = std::chrono::milliseconds(400);
+            DiscordIpc::Client c(DiscordIpc::MakeDefaultTransport(), o);
+            c.Start();
+            WaitConnected(c, std::chrono::seconds(2));
+            auto t0 = Clock::now();
+            for (int i = 0; i < 200; i++) {
+                c.SetActivity(Act("burst " + std::to_string(i)));
+                std::this_thread::sleep_for(std::chrono::microseconds(500));
+            }
+            Check(server.WaitFor("burst 199", std::chrono::seconds(3)), "el último estado de la ráfaga llega");
+            double elapsed = Ms(Clock::now() - t0);
+            WaitStats(c, [&](const DiscordIpc::Stats& s) { return s.sent == server.Log().size(); }, std::chrono::seconds(2));
+            auto log = server.Log();
+            bool withinLimit = true;
+            for (size_t i = 5; i < log.size(); i++) withinLimit = withinLimit && Ms(log[i].at - log[i - 5].at) >= 400 - 5;
+            auto st = c.GetStats();
+            std::printf("         %zu envíos para 200 cambios en %.0f ms (%llu fundidos)\n", log.size(), elapsed, (unsigned long long)st.coalesced);
+            Check(withinLimit, "nunca más de 5 envíos por ventana");
+            Check(log.back().state == "burst 199" && st.sent == log.size(), "cada envío confirmado y el último es el más reciente");
+            c.Stop();
+        }
+        {
+            // Discord se cierra y vuelve: se reintenta con espera creciente y se reenvía el estado vigente
+            DiscordIpc::Client c(DiscordIpc::MakeDefaultTransport(), TestOptions());
+            c.Start();
+            WaitConnected(c, std::chrono::seconds(2));
+            c.SetActivity(Act("antes"));
+            server.WaitFor("antes", std::chrono::seconds(2));
+            server.Stop();
+            server.ClearLog();
+            c.SetActivity(Act("durante"));
+            std::this_thread::sleep_for(std::chrono::milliseconds(700));
+            auto st = c.GetStats();
+            std::printf("         %llu intentos fallidos en 700 ms (backoff 50..400 ms)\n", (unsigned long long)st.failedConnects);
+            Check(st.disconnects >= 1 && st.failedConnects >= 2 && st.failedConnects <= 6, "reintentos con espera exponencial");
+            c.SetActivity(Act("después"));
+            auto t0 = Clock::now();
+            server.Start();
+            Clock::time_point at;
+            Check(server.WaitFor("después", std::chrono::seconds(2), &at), "reconecta y envía el último estado");
+            std::printf("         reconexión + envío: %.0f ms tras volver el servidor\n", Ms(at - t0));
+            Check(server.Log().size() == 1, "los estados intermedios no se reenvían");
+            c.Stop();
+        }
+        {
+            // Sin Discord: nada que enviar = un único intento y luego dormir
+            server.Stop();
+            DiscordIpc::Client c(DiscordIpc::MakeDefaultTransport(), TestOptions());
+            c.Start();
+            std::this_thread::sleep_for(std::chrono::milliseconds(500));
+            auto st = c.GetStats();
+            Check(st.failedConnects == 1 && st.wakeups == 0, "sin servidor ni actividad no reintenta en bucle");
+            c.Stop();
+        }
+        {
+            // Stop no espera al plazo de respuesta si el servidor está colgado
+            server.Start();
+            server.mute = true;
+            DiscordIpc::Client c(DiscordIpc::MakeDefaultTransport(), TestOptions());
+            c.Start();
+            WaitConnected(c, std::chrono::seconds(2));
+            c.SetActivity(Act("colgado"));
+            server.WaitFor("colgado", std::chrono::seconds(2));
+            auto t0 = Clock::now();
+            c.Stop();
+            Check(Ms(Clock::now() - t0) < 200, "Stop inmediato");
+        }
+        std::printf("discordbench: %d fallos\n", failures);
+        return failures ? 1 : 0;
+    }
+
+    int Bench(int n) {
+        TempDir tmp;
+        FakeDiscord server(tmp.path);
+        if (!server.Start()) return 1;
+        auto o = TestOptions();
+        o.rateLimit = 1 << 30;
+        DiscordIpc::Client c(DiscordIpc::MakeDefaultTransport(), o);
+        c.Start();
+        WaitConnected(c, std::chrono::seconds(2));
+
+        std::vector<double> lat;
+        lat.reserve(n);
+        auto b0 = Clock::now();
+        for (int i = 0; i < n; i++) {
+            std::string s = "song " + std::to_string(i);
+            auto t0 = Clock::now();
+            c.SetActivity(Act(s));
+            Clock::time_point at;
+            if (!server.WaitFor(s, std::chrono::seconds(2), &at)) { std::fprintf(stderr, "discordbench: se perdió %s\n", s.c_str()); return 1; }
+            lat.push_back(Ms(at - t0));
+        }
+        double total = Ms(Clock::now() - b0);
+        std::sort(lat.begin(), lat.end());
+        auto st = c.GetStats();
+        c.Stop();
+
+        DiscordIpc::Client payloadOnly(std::make_unique<DiscordIpc::SocketTransport>(), TestOptions());
+        auto act = Act("Week 7 - Stress (Hard)", "Jugando en Freeplay");
+        size_t bytes = 0;
+        const int reps = 200000;
+        auto p0 = Clock::now();
+        for (int i = 0; i < reps; i++) bytes += payloadOnly.BuildPayload(act, (uint64_t)i).size();
+        double perPayload = Ms(Clock::now() - p0) * 1e6 / reps;
+
+        std::printf("discordbench: %d actualizaciones en %.0f ms (%.0f/s)\n", n, total, n * 1000.0 / total);
+        std::printf("  latencia SetActivity -> servidor  p50 %.3f ms  p99 %.3f ms  max %.3f ms\n",
+            lat[lat.size() / 2], lat[lat.size() * 99 / 100], lat.back());
+        std::printf("  despertares del hilo: %llu (%.2f por envío)\n", (unsigned long long)st.wakeups, (double)st.wakeups / std::max<uint64_t>(1, st.sent));
+        std::printf("  JSON de SET_ACTIVITY: %.0f ns, %zu bytes\n", perPayload, bytes / reps);
+        return 0;
+    }
+
+    void Usage() {
+        std::fprintf(stderr,
+            "Uso:\n"
+            "  discordbench --verify\n"
+            "  discordbench --bench [N]\n");
+    }
+
+    int Run(const std::vector<std::string>& args) {
+        if (!args.empty() && args[0] == "--verify") return Verify();
+        if (!args.empty() && args[0] == "--bench") return Bench(args.size() >= 2 ? std::max(1, std::atoi(args[1].c_str())) : 2000);
+        Usage();
+        return 1;
+    }
+}
+
+int main(int argc, char** argv) { return Run(std::vector<std::string>(argv + 1, argv + argc)); }
+#else
+int wmain() {
+    std::fprintf(stderr, "discordbench: el servidor de prueba necesita sockets Unix\n");
+    return 1;
+}
+#endif
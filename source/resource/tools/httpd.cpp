@@ -0,0 +1,475 @@
+/**
+ * httpd - Servidor de desarrollo nativo (core/HttpServer.h). Sirve la carpeta del juego con
+ * keep-alive, Range, revalidación por ETag / Last-Modified y hermanos .br / .gz precomprimidos;
+ * en Linux sustituye a server.bat (python -m http.server) y a source/resource/server.js.
+ *
+ * Uso:
+ *   httpd [carpeta] [--port N] [--host IP] [--threads N] [--log]
+ *       Por defecto la carpeta actual en 127.0.0.1:8080 (como server.bat); --host 0.0.0.0 la
+ *       abre a la red local.
+ *   httpd --verify                            Servidor en un puerto libre sobre una carpeta temporal
+ *   httpd --bench [ruta] [conexiones] [segundos] [--target host:puerto] [--range a-b]
+ *       Carga con conexiones keep-alive: peticiones/s, MB/s y latencia p50 / p99. Sin --target
+ *       arranca su propio servidor sobre la carpeta actual; con --target mide otro servidor
+ *       (server.js, python -m http.server) con la misma carga.
+ *
+ * Solo Linux: el servidor usa epoll y sendfile.
+ */
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../core/Http.h"
+#include "../core/HttpServer.h"
+#include "Tool.h"
+
+namespace fs = std::filesystem;
+
+#if defined(__linux__)
+#include <csignal>
+
+namespace {
+
+    using namespace Tool;
+
+    struct Response {
+        int status = 0;
+        std::string head, body;
+        bool close = false;
+
+        /** Valor de una cabecera (sin distinguir mayúsculas); vacío si no está. */
+        std::string Header(const std::string& name) const {
+            for (size_t at = head.find("\r\n"); at != std::string::npos && at + 2 < head.size(); at = head.find("\r\n", at + 2)) {
+                size_t colon = head.find(':', at);
+                size_t end = head.find("\r\n", at + 2);
+                if (colon == std::string::npos || colon > end || colon - at - 2 != name.size()) continue;
+                bool eq = true;
+                for (size_t i = 0; i < name.size() && eq; i++) eq = std::tolower((unsigned char)head[at + 2 + i]) == std::tolower((unsigned char)name[i]);
+                if (!eq) continue;
+                size_t v = colon + 1;
+                while (v < end && head[v] == ' ') v++;
+                return head.substr(v, end - v);
+            }
+            return "";
+        }
+    };
+
+    /** Cliente HTTP/1.1 bloqueante mínimo: Content-Length, chunked o hasta cerrar. */
+    class Client {
+    public:
+        ~Client() { Close(); }
+
+        bool Connect(const std::string& host, uint16_t port) {
+            Close();
+            fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+            if (fd < 0) return false;
+            timeval tv{ 5, 0 };
+            setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+            int one = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            sockaddr_in addr{};
+            addr.sin_family = AF_INET;
+            addr.sin_port = htons(port);
+            inet_pton(AF_INET, host.c_str(), &addr.sin_addr);
+            if (::connect(fd, (sockaddr*)&addr, sizeof(addr)) < 0) { Close(); return false; }
+            buf.clear();
+            return true;
+        }
+
+        void Close() { if (fd >= 0) { ::close(fd); fd = -1; } }
+        bool IsOpen() const { return fd >= 0; }
+
+        bool Send(const std::string& data) {
+            size_t at = 0;
+            while (at < data.size()) {
+                ssize_t n = ::send(fd, data.data() + at, data.size() - at, MSG_NOSIGNAL);
+                if (n <= 0) return false;
+                at += (size_t)n;
+            }
+            return true;
+        }
+
+        /** Lee una respuesta. `head`: la petición fue HEAD (sin cuerpo aunque haya Content-Length). */
+        bool Read(Response& r, bool head = false) {
+            r = Response();
+            size_t end;
+            while ((end = buf.find("\r\n\r\n")) == std::string::npos) if (!Fill()) return false;
+            r.head = buf.substr(0, end + 2);
+            buf.erase(0, end + 4);
+            if (r.head.compare(0, 5, "HTTP/") != 0 || r.head.size() < 12) return false;
+            r.status = std::atoi(r.head.c_str() + 9);
+            std::string connection = r.Header("Connection");
+            for (auto& c : connection) c = (char)std::tolower((unsigned char)c);
+            bool http10 = r.head.compare(0, 8, "HTTP/1.0") == 0;
+            r.close = connection.find("close") != std::string::npos || (http10 && connection.find("keep-alive") == std::string::npos);
+            if (head || r.status == 304 || r.status == 204 || r.status < 200) return true;
+
+            std::string te = r.Header("Transfer-Encoding"), cl = r.Header("Content-Length");
+            if (te.find("chunked") != std::string::npos) {
+                for (;;) {
+                    size_t eol;
+                    while ((eol = buf.find("\r\n")) == std::string::npos) if (!Fill()) return false;
+                    size_t n = std::strtoul(buf.c_str(), nullptr, 16);
+                    buf.erase(0, eol + 2);
+                    while (buf.size() < n + 2) if (!Fill()) return false;
+                    r.body.append(buf, 0, n);
+                    buf.erase(0, n + 2);
+                    if (n == 0) return true;
+                }
+            }
+            if (!cl.empty()) {
+                size_t n = std::strtoull(cl.c_str(), nullptr, 10);
+                while (buf.size() < n) if (!Fill()) return false;
+                r.body = buf.substr(0, n);
+                buf.erase(0, n);
+                return true;
+            }
+            while (Fill()) {}
+            r.body.swap(buf);
+            r.close = true;
+            return true;
+        }
+
+        /** true si el servidor cerró la conexión (lee hasta EOF o timeout). */
+        bool ServerClosed() {
+            char c;
+            return ::recv(fd, &c, 1, 0) == 0;
+        }
+
+    private:
+        int fd = -1;
+        std::string buf;
+
+        bool Fill() {
+            char tmp[65536];
+            ssize_t n = ::recv(fd, tmp, sizeof(tmp), 0);
+            if (n <= 0) return false;
+            buf.append(tmp, (size_t)n);
+            return true;
+        }
+    };
+
+    std::string Get(const std::string& path, const std::string& extra = "", const char* method = "GET") {
+        return std::string(method) + " " + path + " HTTP/1.1\r\nHost: localhost\r\n" + extra + "\r\n";
+    }
+
+    /** Una petición en una conexión nueva. */
+    Response Fetch(uint16_t port, const std::string& request, bool head = false) {
+        Client c;
+        Response r;
+        if (c.Connect("127.0.0.1", port) && c.Send(request)) c.Read(r, head);
+        return r;
+    }
+
+    std::string Noise(size_t n, uint32_t seed) {
+        std::string s(n, '\0');
+        for (size_t i = 0; i < n; i++) { seed = seed * 1664525u + 1013904223u; s[i] = (char)(seed >> 24); }
+        return s;
+    }
+
+    int Verify() {
+        std::printf("httpd verify\n");
+        {
+            int64_t t;
+            Check(Http::FormatDate(784111777) == "Sun, 06 Nov 1994 08:49:37 GMT" && Http::ParseDate("Sun, 06 Nov 1994 08:49:37 GMT", t) && t == 784111777,
+                "fechas HTTP (IMF-fixdate) de ida y vuelta");
+            uint64_t a = 0, b = 0;
+            Check(Http::ParseRange("bytes=0-", 10, a, b) == Http::Range::Partial && a == 0 && b == 9 &&
+                Http::ParseRange("bytes=-3", 10, a, b) == Http::Range::Partial && a == 7 && b == 9 &&
+                Http::ParseRange("bytes=5-100", 10, a, b) == Http::Range::Partial && b == 9 &&
+                Http::ParseRange("bytes=10-", 10, a, b) == Http::Range::Unsatisfiable &&
+                Http::ParseRange("bytes=1-2,4-5", 10, a, b) == Http::Range::Full &&
+                Http::ParseRange("items=1-2", 10, a, b) == Http::Range::Full, "Range: abierto, sufijo, recorte, 416 y multirango ignorado");
+            Check(Http::AcceptsEncoding("gzip, deflate, br", "br") && !Http::AcceptsEncoding("gzip, br;q=0", "br") &&
+                Http::AcceptsEncoding("br;q=0.5", "br") && !Http::AcceptsEncoding("gzip", "br"), "Accept-Encoding con q");
+            Check(Http::EtagMatches("\"a\", W/\"b\"", "\"b\"") && Http::EtagMatches("*", "\"x\"") && !Http::EtagMatches("\"a\"", "\"b\""),
+                "If-None-Match: lista, W/ y *");
+        }
+
+        fs::path dir = fs::temp_directory_path() / "genesis-httpd-verify";
+        std::error_code ec;
+        fs::remove_all(dir, ec);
+        fs::path root = dir / "root";
+        const std::string big = Noise(3 * 1024 * 1024 + 123, 7);
+        WriteFile(root / "index.html", "<html>hola</html>");
+        WriteFile(root / "public" / "a b.txt", "con espacio");
+        WriteFile(root / "public" / "songs" / "test" / "Inst.ogg", big);
+        WriteFile(root / "public" / "sub" / "index.html", "sub");
+        WriteFile(root / "public" / "empty.json", "");
+        WriteFile(root / "source" / "app.js", "console.log('app');");
+        WriteFile(root / "source" / "app.js.gz", "GZ");
+        WriteFile(root / "source" / "app.js.br", "BR");
+        WriteFile(root / "source" / "old.js", "nuevo");
+        WriteFile(root / "source" / "old.js.gz", "viejo");
+        fs::last_write_time(root / "source" / "old.js.gz", fs::last_write_time(root / "source" / "old.js") - std::chrono::hours(1));
+        fs::last_write_time(root / "source" / "app.js.gz", fs::last_write_time(root / "source" / "app.js") + std::chrono::seconds(1));
+        fs::last_write_time(root / "source" / "app.js.br", fs::last_write_time(root / "source" / "app.js") + std::chrono::seconds(1));
+        WriteFile(dir / "outside.txt", "secreto");
+
+        HttpServer server;
+        HttpServer::Options opt;
+        opt.root = root;
+        opt.port = 0;
+        opt.threads = 2;
+        std::string err;
+        if (!server.Start(opt, &err)) {
+            std::fprintf(stderr, "[ERROR] %s\n", err.c_str());
+            return 1;
+        }
+        uint16_t port = server.Port();
+
+        Response r = Fetch(port, Get("/"));
+        Check(r.status == 200 && r.body == "<html>hola</html>" && r.Header("Content-Type") == "text/html; charset=utf-8", "GET / sirve index.html");
+        r = Fetch(port, Get("/public/a%20b.txt?v=2"));
+        Check(r.status == 200 && r.body == "con espacio", "%XX y query en la ruta");
+        r = Fetch(port, Get("/public/songs/test/Inst.ogg"));
+        Check(r.status == 200 && r.body == big && r.Header("Content-Type") == "audio/ogg", "archivo de 3 MB entero por sendfile");
+        r = Fetch(port, Get("/public/empty.json"));
+        Check(r.status == 200 && r.body.empty() && r.Header("Content-Length") == "0", "archivo vacío");
+
+        {
+            // Tres peticiones encadenadas en un solo envío, una conexión
+            uint64_t before = server.GetStats().connections;
+            Client c;
+            Response a, b, d;
+            bool ok = c.Connect("127.0.0.1", port) && c.Send(Get("/") + Get("/public/a%20b.txt", "", "HEAD") + Get("/public/sub/")) &&
+                c.Read(a) && c.Read(b, true) && c.Read(d);
+            Check(ok && a.body == "<html>hola</html>" && b.status == 200 && b.body.empty() && b.Header("Content-Length") == "11" && d.body == "sub" &&
+                server.GetStats().connections == before + 1, "keep-alive con pipelining (GET, HEAD sin cuerpo, GET)");
+        }
+
+        size_t n = big.size();
+        r = Fetch(port, Get("/public/songs/test/Inst.ogg", "Range: bytes=100-199\r\n"));
+        Check(r.status == 206 && r.body == big.substr(100, 100) && r.Header("Content-Range") == "bytes 100-199/" + std::to_string(n), "Range a-b -> 206");
+        r = Fetch(port, Get("/public/songs/test/Inst.ogg", "Range: bytes=-10\r\n"));
+        Check(r.status == 206 && r.body == big.substr(n - 10), "Range de sufijo");
+        r = Fetch(port, Get("/public/songs/test/Inst.ogg", "Range: bytes=" + std::to_string(n - 5) + "-\r\n"));
+        Check(r.status == 206 && r.body == big.substr(n - 5), "Range abierto");
+        r = Fetch(port, Get("/public/songs/test/Inst.ogg", "Range: bytes=" + std::to_string(n) + "-\r\n"));
+        Check(r.status == 416 && r.Header("Content-Range") == "bytes */" + std::to_string(n), "Range fuera del archivo -> 416");
+
+        r = Fetch(port, Get("/public/a%20b.txt"));
+        std::string etag = r.Header("ETag"), modified = r.Header("Last-Modified");
+        Response r304 = Fetch(port, Get("/public/a%20b.txt", "If-None-Match: " + etag + "\r\n"));
+        Check(!etag.empty() && r304.status == 304 && r304.body.empty() && r304.Header("ETag") == etag, "If-None-Match -> 304");
+        r304 = Fetch(port, Get("/public/a%20b.txt", "If-Modified-Since: " + modified + "\r\n"));
+        Check(r304.status == 304, "If-Modified-Since -> 304");
+        r = Fetch(port, Get("/public/songs/test/Inst.ogg", "Range: bytes=0-9\r\nIf-Range: \"otro\"\r\n"));
+        Check(r.status == 200 && r.body.size() == n, "If-Range que no coincide -> archivo entero");
+        WriteFile(root / "public" / "a b.txt", "con espacio, cambiado");
+        r = Fetch(port, Get("/public/a%20b.txt", "If-None-Match: " + etag + "\r\n"));
+        Check(r.status == 200 && r.body == "con espacio, cambiado" && r.Header("ETag") != etag, "archivo cambiado -> 200 con ETag nuevo");
+
+        r = Fetch(port, Get("/source/app.js", "Accept-Encoding: gzip, deflate, br\r\n"));
+        Check(r.body == "BR" && r.Header("Content-Encoding") == "br" && r.Header("Vary") == "Accept-Encoding" &&
+            r.Header("Content-Type") == "text/javascript; charset=utf-8", "hermano .br precomprimido");
+        r = Fetch(port, Get("/source/app.js", "Accept-Encoding: gzip\r\n"));
+        Check(r.body == "GZ" && r.Header("Content-Encoding") == "gzip", "hermano .gz si no acepta br");
+        r = Fetch(port, Get("/source/app.js"));
+        Check(r.body == "console.log('app');" && r.Header("Content-Encoding").empty() && r.Header("Vary") == "Accept-Encoding", "sin Accept-Encoding -> original");
+        r = Fetch(port, Get("/source/app.js", "Accept-Encoding: br\r\nRange: bytes=0-6\r\n"));
+        Check(r.status == 206 && r.body == "console" && r.Header("Content-Encoding").empty(), "Range siempre sobre el original");
+        r = Fetch(port, Get("/source/old.js", "Accept-Encoding: gzip\r\n"));
+        Check(r.body == "nuevo" && r.Header("Content-Encoding").empty(), ".gz más antiguo que el original se ignora");
+
+        Check(Fetch(port, Get("/../outside.txt")).status == 404 && Fetch(port, Get("/%2e%2e/outside.txt")).status == 404 &&
+            Fetch(port, Get("/public/..%2F..%2Foutside.txt")).status == 404, "no se sale de la raíz (.., %2e%2e, %2F)");
+        Check(Fetch(port, Get("/public/%00x")).status == 400 && Fetch(port, Get("/public/%zz")).status == 400, "%00 y %XX inválido -> 400");
+        r = Fetch(port, Get("/public/sub"));
+        Check(r.status == 301 && r.Header("Location") == "/public/sub/", "carpeta sin / -> 301");
+        Check(Fetch(port, Get("/no-existe.png")).status == 404, "404");
+        r = Fetch(port, Get("/", "", "POST"));
+        Check(r.status == 405 && r.Header("Allow") == "GET, HEAD", "POST -> 405");
+
+        {
+            Client c;
+            Response bad;
+            Check(c.Connect("127.0.0.1", port) && c.Send("HOLA\r\n\r\n") && c.Read(bad) && bad.status == 400 && bad.close && c.ServerClosed(),
+                "petición mal formada -> 400 y cierre");
+            Check(Fetch(port, Get("/", "X-Relleno: " + std::string(20000, 'x') + "\r\n")).status == 431, "cabeceras enormes -> 431");
+            Check(Fetch(port, "GET / HTTP/2.0\r\n\r\n").status == 505, "HTTP/2.0 en texto -> 505");
+            Response closeResp;
+            Check(c.Connect("127.0.0.1", port) && c.Send(Get("/", "Connection: close\r\n")) && c.Read(closeResp) && closeResp.close && c.ServerClosed(),
+                "Connection: close cierra tras responder");
+            Check(c.Connect("127.0.0.1", port) && c.Send("GET / HTTP/1.0\r\n\r\n") && c.Read(closeResp) && closeResp.close && c.ServerClosed(),
+                "HTTP/1.0 sin keep-alive cierra");
+        }
+
+        {
+            // Muchas conexiones a la vez, cada una con varias peticiones
+            const int threads = 64, each = 40;
+            std::atomic<int> ok{ 0 };
+            std::vector<std::thread> pool;
+            for (int t = 0; t < threads; t++) {
+                pool.emplace_back([&, t] {
+                    Client c;
+                    if (!c.Connect("127.0.0.1", port)) return;
+                    for (int i = 0; i < each; i++) {
+                        Response resp;
+                        std::string range = "Range: bytes=" + std::to_string(t * 1000 + i) + "-" + std::to_string(t * 1000 + i + 99) + "\r\n";
+                        if (c.Send(Get("/public/songs/test/Inst.ogg", range)) && c.Read(resp) && resp.status == 206 &&
+                            resp.body == big.substr((size_t)(t * 1000 + i), 100)) ok++;
+                    }
+                });
+            }
+            for (auto& th : pool) th.join();
+            Check(ok == threads * each, "64 conexiones x 40 peticiones con Range, todas correctas");
+        }
+
+        server.Stop();
+        fs::remove_all(dir, ec);
+        std::printf(failures ? "%d fallos\n" : "todo OK\n", failures);
+        return failures ? 1 : 0;
+    }
+
+    struct Load {
+        uint64_t requests = 0, bytes = 0, errors = 0, reconnects = 0;
+        std::vector<double> latencies;
+    };
+
+    /** `connections` clientes keep-alive pidiendo `path` sin pausa durante `seconds`. */
+    Load RunLoad(const std::string& host, uint16_t port, const std::string& path, int connections, double seconds, const std::string& range) {
+        std::vector<Load> parts((size_t)connections);
+        std::vector<std::thread> pool;
+        auto deadline = Clock::now() + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+        std::string request = Get(path, range.empty() ? "" : "Range: bytes=" + range + "\r\n");
+        for (int t = 0; t < connections; t++) {
+            pool.emplace_back([&, t] {
+                Load& l = parts[(size_t)t];
+                Client c;
+                while (Clock::now() < deadline) {
+                    if (!c.IsOpen()) {
+                        if (!c.Connect(host, port)) { l.errors++; std::this_thread::sleep_for(std::chrono::milliseconds(10)); continue; }
+                        l.reconnects++;
+                    }
+                    auto t0 = Clock::now();
+                    Response r;
+                    if (!c.Send(request) || !c.Read(r) || (r.status != 200 && r.status != 206)) { l.errors++; c.Close(); continue; }
+                    l.latencies.push_back(Ms(Clock::now() - t0));
+                    l.requests++;
+                    l.bytes += r.body.size();
+                    if (r.close) c.Close();
+                }
+            });
+        }
+        for (auto& th : pool) th.join();
+        Load total;
+        for (auto& l : parts) {
+            total.requests += l.requests; total.bytes += l.bytes; total.errors += l.errors; total.reconnects += l.reconnects;
+            total.latencies.insert(total.latencies.end(), l.latencies.begin(), l.latencies.end());
+        }
+        std::sort(total.latencies.begin(), total.latencies.end());
+        return total;
+    }
+
+    int Bench(const std::vector<std::string>& args) {
+        std::string path = "/index.html", target, range;
+        int connections = 32;
+        double seconds = 5;
+        int positional = 0;
+        for (size_t i = 0; i < args.size(); i++) {
+            if (args[i] == "--target" && i + 1 < args.size()) target = args[++i];
+            else if (args[i] == "--range" && i + 1 < args.size()) range = args[++i];
+            else if (positional == 0) { path = args[i]; positional++; }
+            else if (positional == 1) { connections = std::max(1, std::atoi(args[i].c_str())); positional++; }
+            else if (positional == 2) { seconds = std::max(0.5, std::atof(args[i].c_str())); positional++; }
+        }
+
+        HttpServer server;
+        std::string host = "127.0.0.1";
+        uint16_t port = 0;
+        if (target.empty()) {
+            HttpServer::Options opt;
+            opt.root = fs::current_path();
+            opt.port = 0;
+            std::string err;
+            if (!server.Start(opt, &err)) { std::fprintf(stderr, "[ERROR] %s\n", err.c_str()); return 1; }
+            port = server.Port();
+        } else {
+            size_t colon = target.rfind(':');
+            if (colon == std::string::npos) { std::fprintf(stderr, "[ERROR] --target espera host:puerto\n"); return 1; }
+            host = target.substr(0, colon);
+            if (host == "localhost") host = "127.0.0.1";
+            port = (uint16_t)std::atoi(target.c_str() + colon + 1);
+        }
+
+        std::printf("httpd bench: %s%s%s, %d conexiones, %.1f s, servidor %s:%u%s\n", path.c_str(), range.empty() ? "" : " bytes=", range.c_str(),
+            connections, seconds, host.c_str(), port, target.empty() ? " (httpd)" : "");
+        Load l = RunLoad(host, port, path, connections, seconds, range);
+        if (l.latencies.empty()) { std::fprintf(stderr, "[ERROR] ninguna petición respondida (%llu errores)\n", (unsigned long long)l.errors); return 1; }
+        auto pct = [&](double p) { return l.latencies[std::min(l.latencies.size() - 1, (size_t)(l.latencies.size() * p))]; };
+        std::printf("  %.0f peticiones/s  %.1f MB/s  latencia p50 %.3f ms  p99 %.3f ms  max %.3f ms\n",
+            l.requests / seconds, l.bytes / seconds / 1048576.0, pct(0.50), pct(0.99), l.latencies.back());
+        std::printf("  %llu peticiones, %llu conexiones abiertas, %llu errores\n",
+            (unsigned long long)l.requests, (unsigned long long)l.reconnects, (unsigned long long)l.errors);
+        return l.errors ? 1 : 0;
+    }
+
+    int Serve(const std::vector<std::string>& args) {
+        HttpServer::Options opt;
+        for (size_t i = 0; i < args.size(); i++) {
+            const std::string& a = args[i];
+            bool hasValue = i + 1 < args.size();
+            if (a == "--port" && hasValue) opt.port = (uint16_t)std::atoi(args[++i].c_str());
+            else if (a == "--host" && hasValue) opt.host = args[++i];
+            else if (a == "--threads" && hasValue) opt.threads = (size_t)std::max(1, std::atoi(args[++i].c_str()));
+            else if (a == "--log") opt.log = true;
+            else if (a.compare(0, 2, "--") != 0) opt.root = a;
+            else return -1;
+        }
+        if (!fs::is_directory(opt.root)) { std::fprintf(stderr, "[ERROR] %s no es una carpeta\n", opt.root.string().c_str()); return 1; }
+
+        // Bloquea SIGINT/SIGTERM en todos los hilos y los espera aquí para parar limpio
+        sigset_t set;
+        sigemptyset(&set);
+        sigaddset(&set, SIGINT);
+        sigaddset(&set, SIGTERM);
+        pthread_sigmask(SIG_BLOCK, &set, nullptr);
+
+        HttpServer server;
+        std::string err;
+        if (!server.Start(opt, &err)) { std::fprintf(stderr, "[ERROR] %s\n", err.c_str()); return 1; }
+        std::printf("httpd: sirviendo %s en http://%s:%u/ (Ctrl+C para salir)\n", fs::absolute(opt.root).lexically_normal().string().c_str(), opt.host.c_str(), server.Port());
+        std::fflush(stdout);
+        int sig = 0;
+        sigwait(&set, &sig);
+        server.Stop();
+        auto st = server.GetStats();
+        std::printf("httpd: %llu peticiones, %llu conexiones, %.1f MB enviados, %llu 304, %llu 206, %llu precomprimidas\n",
+            (unsigned long long)st.requests, (unsigned long long)st.connections, st.bytes / 1048576.0,
+            (unsigned long long)st.notModified, (unsigned long long)st.partial, (unsigned long long)st.precompressed);
+        return 0;
+    }
+
+    void Usage() {
+        std::fprintf(stderr,
+            "Uso:\n"
+            "  httpd [carpeta] [--port N] [--host IP] [--threads N] [--log]\n"
+            "  httpd --verify\n"
+            "  httpd --bench [ruta] [conexiones] [segundos] [--target host:puerto] [--range a-b]\n");
+    }
+
+    int Run(const std::vector<std::string>& args) {
+        if (!args.empty() && args[0] == "--verify") return Verify();
+        if (!args.empty() && args[0] == "--bench") return Bench(std::vector<std::string>(args.begin() + 1, args.end()));
+        if (!args.empty() && (args[0] == "--help" || args[0] == "-h")) { Usage(); return 1; }
+        int r = Serve(args);
+        if (r < 0) { Usage(); return 1; }
+        return r;
+    }
+}
+
+int main(int argc, char** argv) { return Run(std::vector<std::string>(argv + 1, argv + argc)); }
+#else
+int wmain() {
+    std::fprintf(stderr, "httpd: el servidor usa epoll y sendfile (Linux); en Windows usa server.bat o la app\n");
+    return 1;
+}
+#endif
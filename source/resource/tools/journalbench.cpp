@@ -0,0 +1,450 @@
+/**
+ * journalbench - Comprueba y mide el diario de ediciones (core/Journal.h).
+ *
+ * Uso:
+ *   journalbench --verify [operaciones] [semilla]   Modelo de referencia, reapertura, recuperación tras
+ *                                                  truncar el archivo en cada byte y tras corromperlo
+ *   journalbench --bench [ediciones]               Bytes escritos y tiempo por edición: diario frente a
+ *                                                  reescribir el documento entero (AtomicFile::Write)
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+#include "../core/AtomicFile.h"
+#include "../core/Journal.h"
+#include "../core/Utf.h"
+#include "Tool.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+    using namespace Tool;
+
+    /** Texto aleatorio con ASCII, 2, 3 y 4 bytes por code point. */
+    std::string RandomText(std::mt19937_64& rng, size_t codePoints) {
+        static const char* kPieces[] = { "a", "b", "{", "\"", "1", ",", "ñ", "é", "音", "符", "😀" };
+        std::string s;
+        for (size_t i = 0; i < codePoints; i++) s += kPieces[rng() % 11];
+        return s;
+    }
+
+    /** Offset aleatorio en frontera de code point. */
+    size_t Boundary(std::mt19937_64& rng, const std::string& s) {
+        size_t at = s.empty() ? 0 : rng() % (s.size() + 1);
+        while (at < s.size() && ((unsigned char)s[at] & 0xC0) == 0x80) at++;
+        return at;
+    }
+
+    // --- Modelo de referencia: textos completos, sin empalmes ---
+
+    struct Model {
+        std::string text;
+        uint64_t rev = 0;
+        std::vector<std::pair<std::string, std::string>> undo, redo; // (antes, después)
+
+        void Set(std::string next) {
+            undo.emplace_back(text, next);
+            if (undo.size() > Journal::kHistoryLimit) undo.erase(undo.begin());
+            redo.clear();
+            text = std::move(next);
+            rev++;
+        }
+        bool Undo() {
+            if (undo.empty()) return false;
+            text = undo.back().first;
+            redo.push_back(undo.back()); undo.pop_back();
+            rev++;
+            return true;
+        }
+        bool Redo() {
+            if (redo.empty()) return false;
+            text = redo.back().second;
+            undo.push_back(redo.back()); redo.pop_back();
+            if (undo.size() > Journal::kHistoryLimit) undo.erase(undo.begin());
+            rev++;
+            return true;
+        }
+    };
+
+    bool Same(const Journal::Document& d, const Model& m) {
+        return d.Text() == m.text && d.Rev() == m.rev && d.UndoStack().size() == m.undo.size() && d.RedoStack().size() == m.redo.size();
+    }
+
+    /** Estado esperado tras cada operación y tamaño del archivo en ese momento. */
+    struct Point {
+        uint64_t size;
+        std::string text;
+        uint64_t rev;
+        size_t undo, redo;
+    };
+
+    bool WriteRaw(const fs::path& p, const std::string& data) {
+        std::string err;
+        return AtomicFile::Write(p, data, err);
+    }
+
+    // --- Verificación ---
+
+    bool Offsets(std::mt19937_64& rng) {
+        for (int iter = 0; iter < 200; iter++) {
+            std::string s = RandomText(rng, rng() % 64);
+            for (size_t i = 0; i <= s.size(); i++) {
+                if (i < s.size() && ((unsigned char)s[i] & 0xC0) == 0x80) continue;
+                size_t u16 = Utf::WideLength<char16_t>(s.data(), i);
+                size_t u32 = Utf::WideLength<char32_t>(s.data(), i);
+                if (Utf::Utf8Offset<char16_t>(s.data(), s.size(), u16) != i) return false;
+                if (Utf::Utf8Offset<char32_t>(s.data(), s.size(), u32) != i) return false;
+            }
+            // Media pareja de sustitutos: se queda antes del emoji
+            if (Utf::Utf8Offset<char16_t>("a\xF0\x9F\x98\x80", 5, 2) != 1) return false;
+            if (Utf::Utf8Offset<char16_t>(s.data(), s.size(), SIZE_MAX) != s.size()) return false;
+        }
+        return true;
+    }
+
+    bool Diffs(std::mt19937_64& rng) {
+        for (int iter = 0; iter < 5000; iter++) {
+            std::string a = RandomText(rng, rng() % 40), b = a;
+            size_t at = Boundary(rng, b), end = Boundary(rng, b);
+            if (end < at) std::swap(at, end);
+            b.replace(at, end - at, RandomText(rng, rng() % 6));
+            Journal::Change c = Journal::Diff(a, b);
+            std::string applied = a;
+            if (c.offset > a.size() || a.compare((size_t)c.offset, c.removed.size(), c.removed) != 0) return false;
+            applied.replace((size_t)c.offset, c.removed.size(), c.inserted);
+            if (applied != b) return false;
+            if (!Utf::IsValidUtf8(c.removed.data(), c.removed.size()) || !Utf::IsValidUtf8(c.inserted.data(), c.inserted.size())) return false;
+            if (a == b && (!c.removed.empty() || !c.inserted.empty())) return false;
+        }
+        return true;
+    }
+
+    /**
+     * Operaciones aleatorias contra el modelo; cada tanto se cierra y se reabre desde disco.
+     */
+    bool RandomOps(const fs::path& dir, std::mt19937_64& rng, uint64_t ops, uint64_t& reopens) {
+        fs::path path = dir / "model.gjnl";
+        Journal::Log log;
+        Model model;
+        std::string err;
+        if (!log.Open(path, err)) return false;
+        for (uint64_t i = 0; i < ops; i++) {
+            int op = (int)(rng() % 10);
+            if (op < 5) {
+                std::string next = model.text;
+                size_t at = Boundary(rng, next), end = Boundary(rng, next);
+                if (end < at) std::swap(at, end);
+                if (end - at > 64) end = at;
+                next.replace(at, end - at, RandomText(rng, rng() % 8));
+                bool changed = false;
+                if (!log.Commit(next, "edit", err, &changed)) return false;
+                if (changed) model.Set(next);
+            } else if (op < 7) {
+                bool ok = log.Undo(err);
+                if (ok != model.Undo()) return false;
+            } else if (op < 9) {
+                Journal::Change applied;
+                std::string before = log.Doc().Text();
+                bool ok = log.Redo(err, &applied);
+                if (ok != model.Redo()) return false;
+                if (ok) {
+                    before.replace((size_t)applied.offset, applied.removed.size(), applied.inserted);
+                    if (before != model.text) return false;
+                }
+            } else if (rng() % 2) {
+                if (!log.Compact(err)) return false;
+            } else {
+                log.Close();
+                if (!log.Open(path, err) || log.GetStats().recovered != 0) return false;
+                reopens++;
+            }
+            if (!Same(log.Doc(), model)) return false;
+        }
+        log.Close();
+        Journal::Log again;
+        return again.Open(path, err) && Same(again.Doc(), model);
+    }
+
+    /**
+     * Un diario con instantánea + historial y una cola de ediciones; se trunca en cada byte
+     * y se comprueba que la reapertura da el estado de la última operación completa.
+     */
+    bool Truncation(const fs::path& dir, std::mt19937_64& rng, uint64_t& cuts) {
+        fs::path path = dir / "trunc.gjnl", copy = dir / "cut.gjnl";
+        std::string err;
+        std::vector<Point> points;
+        {
+            Journal::Log log;
+            if (!log.Open(path, err)) return false;
+            std::string text;
+            for (int i = 0; i < 30; i++) {
+                text.insert(Boundary(rng, text), RandomText(rng, 6));
+                if (!log.Commit(text, "a", err)) return false;
+            }
+            for (int i = 0; i < 5; i++) log.Undo(err);
+            if (!log.Compact(err)) return false;
+            points.push_back({ log.Size(), log.Doc().Text(), log.Doc().Rev(), log.Doc().UndoStack().size(), log.Doc().RedoStack().size() });
+            text = log.Doc().Text();
+            for (int i = 0; i < 40; i++) {
+                int op = (int)(rng() % 6);
+                if (op == 0) log.Undo(err);
+                else if (op == 1) log.Redo(err);
+                else {
+                    size_t at = Boundary(rng, text), end = Boundary(rng, text);
+                    if (end < at) std::swap(at, end);
+                    Journal::Change c;
+                    c.offset = at;
+                    c.removed = text.substr(at, std::min<size_t>(end - at, 12));
+                    c.inserted = RandomText(rng, rng() % 5);
+                    c.label = "nota";
+                    if (!log.Apply(c, err)) return false;
+                }
+                text = log.Doc().Text();
+                if (log.Size() != points.back().size)
+                    points.push_back({ log.Size(), text, log.Doc().Rev(), log.Doc().UndoStack().size(), log.Doc().RedoStack().size() });
+            }
+            log.Close();
+        }
+
+        std::string full;
+        if (!AtomicFile::ReadAll(path, full) || full.size() != points.back().size) return false;
+        uint64_t base = points.front().size;
+        uint64_t snapshotEnd = Journal::kHeaderSize + Journal::kRecordHeader + Journal::Detail::Get32((const unsigned char*)full.data() + Journal::kHeaderSize);
+        for (size_t cut = 0; cut <= full.size(); cut++) {
+            if (!WriteRaw(copy, full.substr(0, cut))) return false;
+            Journal::Log log;
+            if (!log.Open(copy, err)) return false;
+            const Journal::Document& d = log.Doc();
+            if (cut < snapshotEnd) {
+                // La instantánea se escribe con rename atómico; si aun así faltara, el diario vuelve a empezar
+                if (!d.Text().empty() || d.Rev() != 0) return false;
+            } else if (cut < base) {
+                // Instantánea entera e historial a medias: el texto está, parte del deshacer no
+                if (d.Text() != points.front().text || d.Rev() != points.front().rev || d.UndoStack().size() > points.front().undo) return false;
+            } else {
+                const Point* expect = &points.front();
+                for (const Point& p : points) if (p.size <= cut) expect = &p;
+                if (d.Text() != expect->text || d.Rev() != expect->rev || d.UndoStack().size() != expect->undo || d.RedoStack().size() != expect->redo) return false;
+                if (log.GetStats().recovered != cut - expect->size) return false;
+            }
+            // Lo recuperado tiene que seguir siendo un diario válido al que se puede añadir
+            Journal::Change c;
+            c.offset = 0; c.inserted = "x";
+            if (!log.Apply(c, err)) return false;
+            std::string text = d.Text();
+            uint64_t rev = d.Rev();
+            log.Close();
+            Journal::Log again;
+            if (!again.Open(copy, err) || again.Doc().Text() != text || again.Doc().Rev() != rev || again.GetStats().recovered != 0) return false;
+            cuts++;
+        }
+        return true;
+    }
+
+    /** Un byte cambiado en un registro de la cola corta la reconstrucción justo antes de él. */
+    bool Corruption(const fs::path& dir) {
+        fs::path path = dir / "corrupt.gjnl";
+        std::string err;
+        std::vector<Point> points;
+        {
+            Journal::Log log;
+            if (!log.Open(path, err)) return false;
+            points.push_back({ log.Size(), "", 0, 0, 0 });
+            for (int i = 0; i < 10; i++) {
+                if (!log.Commit(log.Doc().Text() + "nota" + std::to_string(i) + ",", "", err)) return false;
+                points.push_back({ log.Size(), log.Doc().Text(), log.Doc().Rev(), 0, 0 });
+            }
+            log.Close();
+        }
+        std::string full;
+        if (!AtomicFile::ReadAll(path, full)) return false;
+        for (size_t r = 1; r < points.size(); r++) {
+            std::string bad = full;
+            size_t at = (size_t)points[r - 1].size + Journal::kRecordHeader + 3;
+            bad[at] ^= 0x20;
+            fs::path p = dir / "flipped.gjnl";
+            if (!WriteRaw(p, bad)) return false;
+            Journal::Log log;
+            if (!log.Open(p, err) || log.Doc().Text() != points[r - 1].text || log.Size() != points[r - 1].size) return false;
+        }
+        // Un archivo que no es un diario no se toca
+        fs::path other = dir / "other.gjnl";
+        if (!WriteRaw(other, "{\"not\":\"a journal\"}")) return false;
+        Journal::Log log;
+        std::string before, after;
+        AtomicFile::ReadAll(other, before);
+        bool refused = !log.Open(other, err);
+        AtomicFile::ReadAll(other, after);
+        return refused && before == after;
+    }
+
+    /** El historial de deshacer/rehacer sobrevive a la compactación y a la reapertura por el Store. */
+    bool HistoryAcrossStore(const fs::path& dir) {
+        std::string err;
+        std::string text;
+        {
+            Journal::Store store(dir / "store");
+            for (int i = 0; i < 20; i++) {
+                if (!store.With("charts/bopeebo", err, [&](Journal::Log& log) { return log.Commit(log.Doc().Text() + "[" + std::to_string(i) + "]", "nota", err); })) return false;
+            }
+            for (int i = 0; i < 4; i++) store.With("charts/bopeebo", err, [&](Journal::Log& log) { return log.Undo(err); });
+            store.With("charts/bopeebo", err, [&](Journal::Log& log) { text = log.Doc().Text(); return log.Compact(err); });
+            if (store.With("../escape", err, [](Journal::Log&) { return true; })) return false;
+            Journal::Log::Stats st = store.GetStats();
+            if (st.edits != 20 || st.undos != 4) return false;
+        }
+        Journal::Store store(dir / "store");
+        bool ok = store.With("charts/bopeebo", err, [&](Journal::Log& log) {
+            const Journal::Document& d = log.Doc();
+            if (d.Text() != text || d.UndoStack().size() != 16 || d.RedoStack().size() != 4) return false;
+            if (d.UndoStack().back().label != "nota") return false;
+            for (int i = 0; i < 4; i++) if (!log.Redo(err)) return false;
+            return log.Doc().Text().size() > text.size() && !log.Redo(err) && err == "nothing to redo";
+        });
+        return ok;
+    }
+
+    int Verify(uint64_t ops, uint64_t seed) {
+        fs::path dir = MakeTempDir("journalbench");
+        std::mt19937_64 rng(seed);
+        uint64_t reopens = 0, cuts = 0;
+        std::printf("journalbench --verify (%llu operaciones, semilla %llu)\n", (unsigned long long)ops, (unsigned long long)seed);
+        Check(Offsets(rng), "Utf8Offset es el inverso de WideLength (UTF-16 y UTF-32)");
+        Check(Diffs(rng), "Diff: empalme mínimo sin cortar secuencias UTF-8");
+        Check(RandomOps(dir, rng, ops, reopens), "ediciones, deshacer, rehacer, compactar y reabrir = modelo de referencia");
+        Check(Truncation(dir, rng, cuts), "truncado en cada byte: se recupera la última operación completa y se puede seguir");
+        Check(Corruption(dir), "byte corrompido: se recupera hasta el registro anterior; un archivo ajeno no se toca");
+        Check(HistoryAcrossStore(dir), "historial tras compactar y reabrir (Store)");
+        std::printf("  %llu reaperturas, %llu cortes\n", (unsigned long long)reopens, (unsigned long long)cuts);
+        std::error_code ec;
+        fs::remove_all(dir, ec);
+        std::printf(failures ? "\n%d fallos\n" : "\ntodo OK\n", failures);
+        return failures ? 1 : 0;
+    }
+
+    // --- Benchmark ---
+
+    /**
+     * Chart con el formato de Psych Engine de unos `bytes`; los tiempos tienen ancho fijo, así que
+     * editar una nota es reemplazar 9 bytes en un offset conocido.
+     */
+    std::string MakeChart(size_t bytes, std::vector<size_t>& noteAt) {
+        std::string s = "{\"song\":{\"song\":\"Bench\",\"bpm\":150,\"speed\":2.4,\"notes\":[";
+        char buf[64];
+        for (int section = 0; s.size() < bytes; section++) {
+            if (section) s += ',';
+            s += "{\"mustHitSection\":";
+            s += section % 2 ? "true" : "false";
+            s += ",\"sectionNotes\":[";
+            for (int n = 0; n < 16; n++) {
+                if (n) s += ',';
+                s += '[';
+                noteAt.push_back(s.size());
+                std::snprintf(buf, sizeof(buf), "%09.2f,%d,0]", section * 1600.0 + n * 100.0, n % 8);
+                s += buf;
+            }
+            s += "]}";
+        }
+        s += "]}}";
+        return s;
+    }
+
+    void BenchSize(const fs::path& dir, size_t bytes, size_t edits) {
+        std::vector<size_t> noteAt;
+        std::string chart = MakeChart(bytes, noteAt);
+        std::mt19937_64 rng(7);
+        char buf[16];
+        auto nextTime = [&]() {
+            std::snprintf(buf, sizeof(buf), "%09.2f", (double)(rng() % 100000000) / 100.0);
+            return std::string(buf, 9);
+        };
+        std::string err;
+
+        // Reescribir todo en cada guardado (lo que hacía saveFile)
+        size_t rewrites = std::max<size_t>(8, std::min(edits, (size_t)(64u << 20) / chart.size()));
+        std::string doc = chart;
+        auto t0 = Clock::now();
+        for (size_t i = 0; i < rewrites; i++) {
+            size_t at = noteAt[rng() % noteAt.size()];
+            doc.replace(at, 9, nextTime());
+            AtomicFile::Write(dir / "full.json", doc, err);
+        }
+        double fullUs = std::chrono::duration<double, std::micro>(Clock::now() - t0).count() / rewrites;
+
+        // Diario: la página manda el empalme (Apply) o el texto entero (Commit, con Diff en nativo)
+        for (int mode = 0; mode < 2; mode++) {
+            fs::path path = dir / (mode ? "commit.gjnl" : "apply.gjnl");
+            Journal::Log log;
+            log.Open(path, err);
+            log.Commit(chart, "", err);
+            log.Compact(err);
+            Journal::Log::Stats before = log.GetStats();
+            doc = chart;
+            t0 = Clock::now();
+            for (size_t i = 0; i < edits; i++) {
+                size_t at = noteAt[rng() % noteAt.size()];
+                std::string t = nextTime();
+                if (mode == 0) {
+                    Journal::Change c;
+                    c.offset = at; c.removed = doc.substr(at, 9); c.inserted = t; c.label = "nota";
+                    log.Apply(std::move(c), err);
+                    doc.replace(at, 9, t);
+                } else {
+                    doc.replace(at, 9, t);
+                    log.Commit(doc, "nota", err);
+                }
+                log.Sync(err);
+            }
+            double us = std::chrono::duration<double, std::micro>(Clock::now() - t0).count() / edits;
+            Journal::Log::Stats st = log.GetStats();
+            double perEdit = (double)((st.appended - before.appended) + (st.compacted - before.compacted)) / edits;
+            if (mode == 0) {
+                std::printf("  %8zu KB  reescribir %10.0f B/edición %9.1f us   |", chart.size() >> 10, (double)chart.size(), fullUs);
+                std::printf("  diario (empalme) %7.1f B/edición %7.1f us, %llu compactaciones  x%.0f menos bytes\n",
+                            perEdit, us, (unsigned long long)(st.compactions - before.compactions), chart.size() / perEdit);
+            } else {
+                std::printf("  %8s     %32s   |  diario (texto)   %7.1f B/edición %7.1f us (Diff incluido)\n", "", "", perEdit, us);
+            }
+            if (log.Doc().Text() != doc) std::printf("  (!) el diario no coincide con el documento\n");
+            log.Close();
+        }
+    }
+
+    int Bench(size_t edits) {
+        fs::path dir = MakeTempDir("journalbench");
+        std::printf("journalbench: %zu ediciones de una nota por tamaño, fsync en cada guardado\n", edits);
+        for (size_t kb : { 64, 1024, 8192 }) BenchSize(dir, kb << 10, edits);
+        std::error_code ec;
+        fs::remove_all(dir, ec);
+        return 0;
+    }
+
+    int Run(const std::vector<std::string>& args) {
+        if (!args.empty() && args[0] == "--verify") {
+            uint64_t ops = args.size() >= 2 ? std::strtoull(args[1].c_str(), nullptr, 10) : 3000;
+            uint64_t seed = args.size() >= 3 ? std::strtoull(args[2].c_str(), nullptr, 10) : 12345;
+            return Verify(ops, seed);
+        }
+        if (!args.empty() && args[0] == "--bench") return Bench(args.size() >= 2 ? (size_t)std::max(1, std::atoi(args[1].c_str())) : 2000);
+        std::fprintf(stderr, "uso: journalbench --verify [operaciones] [semilla] | --bench [ediciones]\n");
+        return 2;
+    }
+}
+
+#ifdef _WIN32
+int wmain(int argc, wchar_t** argv) {
+    std::vector<std::string> args;
+    for (int i = 1; i < argc; i++) args.push_back(Utf::ToUtf8(argv[i]));
+    return Run(args);
+}
+#else
+int main(int argc, char** argv) {
+    return Run(std::vector<std::string>(argv + 1, argv + argc));
+}
+#endif
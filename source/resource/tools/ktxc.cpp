@@ -0,0 +1,475 @@
+/**
+ * ktxc - Texturas comprimidas para la GPU (BC7 / ETC2) en contenedor KTX2.
+ * Un PNG en RGBA8 ocupa 4 bytes por píxel en la memoria de vídeo; BC7 y ETC2 ocupan 1. Para las
+ * texturas grandes (atlas de personajes, spritemaps, escenarios) es lo que deja cargar una
+ * canción en gráficas integradas sin quedarse sin memoria.
+ *
+ * Uso:
+ *   ktxc <imagen.png> [--formats bc7,etc2]         Escribe <imagen>.bc7.ktx2 / .etc2.ktx2 al lado
+ *   ktxc --dir <public> [--formats bc7,etc2] [--min-pixels N] [--min-psnr dB] [--force]
+ *       Comprime los PNG de atlas (con .xml o spritemap*.json al lado) de al menos N píxeles
+ *       (1048576 por defecto) y escribe <public>/textures.json con lo que hay de cada uno.
+ *       Si la calidad baja de --min-psnr (36 dB BC7, 30 dB ETC2 por defecto) ese formato se
+ *       descarta y la página sigue con el PNG.
+ *   ktxc --verify [public]                            PSNR, ida y vuelta KTX2 y SSE2 vs escalar
+ *   ktxc --bench [imagen.png] [hilos]                 Megapíxeles por segundo por formato
+ *
+ * La página (atlasLoader.js) elige el formato que admita la GPU (EXT_texture_compression_bptc o
+ * WEBGL_compressed_texture_etc) y, si no hay ninguno, el PNG. El host pasa textures.json a la
+ * página al arrancar.
+ */
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include "../core/AtomicFile.h"
+#include "../core/BlockTexture.h"
+#include "../core/Json.h"
+#include "../core/Ktx2.h"
+#include "Tool.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+    using namespace Tool;
+
+    using Clock = std::chrono::steady_clock;
+    using BlockTexture::Format;
+
+    struct Options {
+        std::vector<Format> formats{ Format::BC7, Format::ETC2 };
+        uint64_t minPixels = 1048576;
+        double minPsnr[2] = { 36.0, 30.0 };   // Por formato (BC7, ETC2)
+        bool force = false;
+    };
+
+    fs::path OutputOf(const fs::path& png, Format f) {
+        fs::path out = png;
+        return out.replace_extension(std::string(".") + BlockTexture::Name(f) + ".ktx2");
+    }
+
+    bool IsUpToDate(const fs::path& in, const fs::path& out) {
+        std::error_code ec;
+        auto tin = fs::last_write_time(in, ec);
+        if (ec) return false;
+        auto tout = fs::last_write_time(out, ec);
+        return !ec && tout >= tin;
+    }
+
+    bool LoadPng(const fs::path& path, Png::Image& img, std::string& err) {
+        std::string data;
+        if (!AtomicFile::ReadAll(path, data)) { err = "cannot read"; return false; }
+        return Png::Decode(data.data(), data.size(), img, &err);
+    }
+
+    /**
+     * Lo que se sube a la GPU: alfa premultiplicado y tamaño múltiplo de 4 (WebGL lo exige a
+     * BC7). El relleno es transparente, así que los frames del atlas no cambian.
+     */
+    Png::Image Prepare(const Png::Image& src) {
+        Png::Image img;
+        img.Resize(BlockTexture::Blocks(src.width) * 4, BlockTexture::Blocks(src.height) * 4);
+        for (uint32_t y = 0; y < src.height; y++) std::memcpy(img.Row(y), src.Row(y), (size_t)src.width * 4);
+        BlockTexture::Premultiply(img);
+        return img;
+    }
+
+    struct Result {
+        double psnr = 0, ms = 0;
+        size_t bytes = 0;
+        bool written = false;
+    };
+
+    /**
+     * Codifica un formato, lo vuelve a decodificar para medir la calidad y lo escribe si pasa.
+     */
+    bool EncodeOne(const Png::Image& img, Format f, double minPsnr, const fs::path& out, TaskPool* pool, Result& r, std::string& err) {
+        auto t0 = Clock::now();
+        Ktx2::Texture tex;
+        tex.format = f;
+        tex.width = img.width;
+        tex.height = img.height;
+        BlockTexture::Encode(img, f, tex.blocks, pool);
+        r.ms = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+
+        Png::Image back;
+        if (!BlockTexture::Decode(tex.blocks, img.width, img.height, f, back)) { err = "decode failed"; return false; }
+        r.psnr = BlockTexture::Psnr(img, back);
+        if (r.psnr < minPsnr) {
+            std::error_code ec;
+            fs::remove(out, ec);   // Uno viejo de otra pasada ya no vale
+            return true;
+        }
+        std::string file;
+        Ktx2::Write(tex, true, file);
+        Ktx2::Texture check;
+        if (!Ktx2::Read(file.data(), file.size(), check, &err) || check.blocks != tex.blocks) { err = "ktx2 round trip: " + err; return false; }
+        if (!AtomicFile::Write(out, file, err)) return false;
+        r.bytes = file.size();
+        r.written = true;
+        return true;
+    }
+
+    /** Un KTX2 ya escrito y al día (para no recomprimir en cada build). */
+    bool ReadExisting(const fs::path& out, size_t& bytes) {
+        std::error_code ec;
+        uintmax_t n = fs::file_size(out, ec);
+        if (ec || n < 80) return false;
+        bytes = (size_t)n;
+        return true;
+    }
+
+    bool HasAtlas(const fs::path& png) {
+        std::error_code ec;
+        fs::path xml = png;
+        if (fs::is_regular_file(xml.replace_extension(".xml"), ec)) return true;
+        fs::path json = png;
+        std::string stem = png.stem().u8string();
+        return stem.rfind("spritemap", 0) == 0 && fs::is_regular_file(json.replace_extension(".json"), ec);
+    }
+
+    int CompileDir(const fs::path& dir, const Options& opt) {
+        std::vector<fs::path> files;
+        std::error_code ec;
+        for (auto it = fs::recursive_directory_iterator(dir / "images", ec); !ec && it != fs::recursive_directory_iterator(); it.increment(ec)) {
+            if (it->is_regular_file(ec) && it->path().extension() == ".png" && HasAtlas(it->path())) files.push_back(it->path());
+        }
+        std::sort(files.begin(), files.end());
+
+        TaskPool pool;
+        size_t written = 0, reused = 0, small = 0, failed = 0;
+        uint64_t rgbaBytes = 0, gpuBytes = 0, pngBytes = 0, diskBytes[2] = { 0, 0 };
+        std::string manifest = "{\"version\":1,\"textures\":{";
+        bool firstEntry = true;
+        auto t0 = Clock::now();
+        for (const auto& png : files) {
+            std::string rel = png.lexically_relative(dir).generic_u8string(), err;
+            Png::Image src;
+            std::vector<Format> done;
+            std::vector<size_t> sizes;
+            bool pending = opt.force;
+            for (Format f : opt.formats) pending = pending || !IsUpToDate(png, OutputOf(png, f));
+            if (!pending) {
+                // Todo al día: basta con leer las cabeceras
+                for (Format f : opt.formats) {
+                    size_t bytes = 0;
+                    if (ReadExisting(OutputOf(png, f), bytes)) { done.push_back(f); sizes.push_back(bytes); }
+                }
+                if (!done.empty()) reused++;
+            } else {
+                if (!LoadPng(png, src, err)) {
+                    // WebP con extensión .png y similares: se quedan como están
+                    std::printf("  [ = ] %s: %s\n", rel.c_str(), err.c_str());
+                    continue;
+                }
+                if ((uint64_t)src.width * src.height < opt.minPixels) { small++; continue; }
+                Png::Image img = Prepare(src);
+                for (Format f : opt.formats) {
+                    Result r;
+                    if (!EncodeOne(img, f, opt.minPsnr[(int)f], OutputOf(png, f), &pool, r, err)) {
+                        std::fprintf(stderr, "[ERROR] %s (%s): %s\n", rel.c_str(), BlockTexture::Name(f), err.c_str());
+                        failed++;
+                        continue;
+                    }
+                    std::printf("  [%s] %s %s: %ux%u, %.2f dB, %.0f ms, %.2f MB\n", r.written ? " OK " : " = ", rel.c_str(), BlockTexture::Name(f),
+                        src.width, src.height, r.psnr, r.ms, r.bytes / 1048576.0);
+                    if (r.written) { done.push_back(f); sizes.push_back(r.bytes); }
+                }
+                if (!done.empty()) written++;
+            }
+            if (done.empty()) continue;
+
+            uint32_t w = 0, h = 0;
+            if (src.width) { w = src.width; h = src.height; }
+            else {
+                // Ancho y alto del PNG sin decodificarlo (IHDR)
+                std::string data;
+                if (AtomicFile::ReadAll(png, data) && data.size() >= 24) {
+                    w = Png::Detail::Get32((const uint8_t*)data.data() + 16);
+                    h = Png::Detail::Get32((const uint8_t*)data.data() + 20);
+                }
+            }
+            rgbaBytes += (uint64_t)w * h * 4;
+            gpuBytes += (uint64_t)BlockTexture::Blocks(w) * BlockTexture::Blocks(h) * BlockTexture::kBlockBytes;
+            pngBytes += fs::file_size(png, ec);
+            if (!firstEntry) manifest += ',';
+            firstEntry = false;
+            Json::AppendString(manifest, rel);
+            manifest += ":{\"width\":"; Json::AppendNumber(manifest, w);
+            manifest += ",\"height\":"; Json::AppendNumber(manifest, h);
+            for (size_t i = 0; i < done.size(); i++) {
+                manifest += ',';
+                Json::AppendString(manifest, BlockTexture::Name(done[i]));
+                manifest += ':';
+                Json::AppendNumber(manifest, (double)sizes[i]);
+                diskBytes[(int)done[i]] += sizes[i];
+            }
+            manifest += '}';
+        }
+        manifest += "}}";
+        std::string err;
+        if (!AtomicFile::Write(dir / "textures.json", manifest, err)) {
+            std::fprintf(stderr, "[ERROR] textures.json: %s\n", err.c_str());
+            return 1;
+        }
+        double secs = std::chrono::duration<double>(Clock::now() - t0).count();
+        std::printf("ktxc: %zu comprimidas, %zu al dia, %zu pequeñas, %zu con error (%.1f s, %zu hilos)\n", written, reused, small, failed, secs, pool.Size());
+        std::printf("  GPU: %.1f MB en RGBA8 -> %.1f MB comprimidas\n", rgbaBytes / 1048576.0, gpuBytes / 1048576.0);
+        std::printf("  disco: PNG %.1f MB, bc7 %.1f MB, etc2 %.1f MB\n", pngBytes / 1048576.0, diskBytes[0] / 1048576.0, diskBytes[1] / 1048576.0);
+        return failed ? 1 : 0;
+    }
+
+    int CompileFile(const fs::path& png, const Options& opt) {
+        Png::Image src;
+        std::string err;
+        if (!LoadPng(png, src, err)) { std::fprintf(stderr, "[ERROR] %s: %s\n", png.u8string().c_str(), err.c_str()); return 1; }
+        Png::Image img = Prepare(src);
+        TaskPool pool;
+        int failed = 0;
+        for (Format f : opt.formats) {
+            Result r;
+            if (!EncodeOne(img, f, 0.0, OutputOf(png, f), &pool, r, err)) { std::fprintf(stderr, "[ERROR] %s: %s\n", BlockTexture::Name(f), err.c_str()); failed++; continue; }
+            std::printf("%s: %.2f dB, %.0f ms, %.2f MB -> %s\n", BlockTexture::Name(f), r.psnr, r.ms, r.bytes / 1048576.0, OutputOf(png, f).u8string().c_str());
+        }
+        return failed ? 1 : 0;
+    }
+
+    // --- Verificación ---
+
+    uint32_t Rand(uint32_t& s) { s ^= s << 13; s ^= s >> 17; s ^= s << 5; return s; }
+
+    /** Degradados suaves + bordes de sprite con alfa, como los atlas del juego. */
+    Png::Image Synthetic(uint32_t w, uint32_t h, uint32_t seed) {
+        Png::Image img;
+        img.Resize(w, h);
+        for (uint32_t y = 0; y < h; y++) {
+            for (uint32_t x = 0; x < w; x++) {
+                uint8_t* p = img.Row(y) + (size_t)x * 4;
+                double dx = (x % 128) - 64.0, dy = (y % 128) - 64.0;
+                double r = std::sqrt(dx * dx + dy * dy);
+                int a = r < 50 ? 255 : (r < 56 ? (int)((56 - r) * 42) : 0);
+                p[0] = (uint8_t)(x * 255 / std::max(1u, w - 1));
+                p[1] = (uint8_t)(y * 255 / std::max(1u, h - 1));
+                p[2] = (uint8_t)(128 + 100 * std::sin((x + y + seed) * 0.05));
+                p[3] = (uint8_t)a;
+            }
+        }
+        BlockTexture::Premultiply(img);
+        return img;
+    }
+
+    void VerifySynthetic() {
+        Png::Image img = Synthetic(256, 256, 1);
+        TaskPool pool(4);
+        for (Format f : { Format::BC7, Format::ETC2 }) {
+            std::vector<uint8_t> single, multi;
+            BlockTexture::Encode(img, f, single);
+            BlockTexture::Encode(img, f, multi, &pool);
+            Check(single == multi, (std::string(BlockTexture::Name(f)) + ": el resultado no depende de los hilos").c_str());
+            Png::Image back;
+            bool decoded = BlockTexture::Decode(single, img.width, img.height, f, back);
+            double psnr = decoded ? BlockTexture::Psnr(img, back) : 0.0;
+            std::printf("         %s: %.2f dB\n", BlockTexture::Name(f), psnr);
+            double need = f == Format::BC7 ? 40.0 : 32.0;
+            Check(decoded && psnr >= need, (std::string(BlockTexture::Name(f)) + ": PSNR >= " + std::to_string((int)need) + " dB en degradados con alfa").c_str());
+
+            // Bloques planos (fondo transparente, color sólido): exactos
+            Png::Image flat;
+            flat.Resize(8, 8);
+            for (uint32_t y = 0; y < 8; y++) for (uint32_t x = 0; x < 8; x++) {
+                uint8_t* p = flat.Row(y) + x * 4;
+                if (x >= 4) { p[0] = 200; p[1] = 40; p[2] = 90; p[3] = 255; }
+            }
+            std::vector<uint8_t> blocks;
+            BlockTexture::Encode(flat, f, blocks);
+            Png::Image flatBack;
+            bool exact = BlockTexture::Decode(blocks, 8, 8, f, flatBack) && flatBack.Row(0)[3] == 0 && flatBack.Row(0)[0] == 0;
+            int worst = 0;
+            for (size_t i = 0; i < flat.rgba.size(); i++) worst = std::max(worst, std::abs((int)flat.rgba[i] - (int)flatBack.rgba[i]));
+            Check(exact && worst <= (f == Format::BC7 ? 1 : 4), (std::string(BlockTexture::Name(f)) + ": transparente exacto, color sólido casi exacto").c_str());
+
+            // Ida y vuelta KTX2, con y sin zlib
+            Ktx2::Texture tex, back1, back2;
+            tex.format = f; tex.width = img.width; tex.height = img.height; tex.blocks = single;
+            std::string raw, z, err;
+            Ktx2::Write(tex, false, raw);
+            Ktx2::Write(tex, true, z);
+            bool round = Ktx2::Read(raw.data(), raw.size(), back1, &err) && Ktx2::Read(z.data(), z.size(), back2, &err)
+                && back1.blocks == single && back2.blocks == single && back2.format == f && back2.width == 256 && z.size() < raw.size();
+            Check(round, (std::string(BlockTexture::Name(f)) + ": KTX2 ida y vuelta (sin comprimir y zlib)").c_str());
+            Check(Ktx2::Detail::Get32((const uint8_t*)raw.data() + 80) % 16 == 0 && Ktx2::Detail::Get32((const uint8_t*)raw.data() + 48) % 4 == 0,
+                (std::string(BlockTexture::Name(f)) + ": KTX2 con DFD y nivel alineados").c_str());
+        }
+
+        // Tamaños que no son múltiplo de 4: se repite el borde
+        Png::Image odd = Synthetic(37, 13, 2);
+        std::vector<uint8_t> blocks;
+        BlockTexture::Encode(odd, Format::BC7, blocks);
+        Png::Image back;
+        Check(blocks.size() == 10 * 4 * 16 && BlockTexture::Decode(blocks, 37, 13, Format::BC7, back) && BlockTexture::Psnr(odd, back) > 38.0,
+              "bc7: imágenes de 37x13 (bloques parciales)");
+
+        // La búsqueda de índices vectorizada da lo mismo que la fuerza bruta
+        uint32_t seed = 7;
+        bool same = true;
+        for (int n = 0; n < 2000 && same; n++) {
+            uint8_t px[16][4];
+            int e0[4], e1[4];
+            for (int k = 0; k < 16; k++) for (int c = 0; c < 4; c++) px[k][c] = (uint8_t)Rand(seed);
+            for (int c = 0; c < 4; c++) { e0[c] = (int)(Rand(seed) & 255); e1[c] = (int)(Rand(seed) & 255); }
+            uint8_t idx[16];
+            uint32_t err = BlockTexture::Detail::AssignBc7(px, e0, e1, idx);
+            uint32_t ref = 0;
+            for (int k = 0; k < 16; k++) {
+                uint32_t best = UINT32_MAX;
+                uint8_t bi = 0;
+                for (int i = 0; i < 16; i++) {
+                    uint32_t e = 0;
+                    for (int c = 0; c < 4; c++) {
+                        int v = ((64 - BlockTexture::Detail::kWeights4[i]) * e0[c] + BlockTexture::Detail::kWeights4[i] * e1[c] + 32) >> 6;
+                        e += (uint32_t)((px[k][c] - v) * (px[k][c] - v));
+                    }
+                    if (e < best) { best = e; bi = (uint8_t)i; }
+                }
+                ref += best;
+                same = same && idx[k] == bi;
+            }
+            same = same && ref == err;
+        }
+#if defined(GENESIS_BC_SSE2)
+        Check(same, "bc7: índices SSE2 iguales a la búsqueda escalar");
+#else
+        Check(same, "bc7: índices (sin SSE2) iguales a la búsqueda de referencia");
+#endif
+    }
+
+    /** PSNR de los PNG de atlas reales más grandes. */
+    void VerifyReal(const fs::path& pub) {
+        std::vector<std::pair<uintmax_t, fs::path>> files;
+        std::error_code ec;
+        for (auto it = fs::recursive_directory_iterator(pub / "images", ec); !ec && it != fs::recursive_directory_iterator(); it.increment(ec)) {
+            if (it->is_regular_file(ec) && it->path().extension() == ".png" && HasAtlas(it->path())) files.push_back({ it->file_size(ec), it->path() });
+        }
+        std::sort(files.begin(), files.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+        if (files.size() > 6) files.resize(6);
+        TaskPool pool;
+        double worst[2] = { 99.0, 99.0 };
+        size_t tested = 0;
+        for (const auto& [size, png] : files) {
+            Png::Image src;
+            std::string err;
+            if (!LoadPng(png, src, err)) continue;
+            Png::Image img = Prepare(src);
+            tested++;
+            for (Format f : { Format::BC7, Format::ETC2 }) {
+                std::vector<uint8_t> blocks;
+                auto t0 = Clock::now();
+                BlockTexture::Encode(img, f, blocks, &pool);
+                double ms = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+                Png::Image back;
+                double psnr = BlockTexture::Decode(blocks, img.width, img.height, f, back) ? BlockTexture::Psnr(img, back) : 0.0;
+                worst[(int)f] = std::min(worst[(int)f], psnr);
+                std::printf("         %-60s %-4s %ux%u %.2f dB %.0f ms\n", png.lexically_relative(pub).generic_u8string().c_str(), BlockTexture::Name(f),
+                    src.width, src.height, psnr, ms);
+            }
+        }
+        Check(tested > 0 && worst[0] >= 36.0, "bc7: >= 36 dB en los atlas reales más grandes");
+        Check(tested > 0 && worst[1] >= 30.0, "etc2: >= 30 dB en los atlas reales más grandes");
+    }
+
+    int Verify(const fs::path& real) {
+        std::printf("ktxc --verify\n");
+        VerifySynthetic();
+        if (!real.empty()) VerifyReal(real);
+        std::printf(failures ? "\n%d fallos\n" : "\ntodo OK\n", failures);
+        return failures ? 1 : 0;
+    }
+
+    int Bench(const fs::path& png, size_t threads) {
+        Png::Image img;
+        std::string err;
+        if (png.empty()) img = Synthetic(2048, 2048, 3);
+        else if (!LoadPng(png, img, err)) { std::fprintf(stderr, "ktxc: %s: %s\n", png.u8string().c_str(), err.c_str()); return 1; }
+        else img = Prepare(img);
+        TaskPool pool(threads);
+        double mpix = (double)img.width * img.height / 1e6;
+        std::printf("ktxc bench: %ux%u (%.1f MP), %zu hilos en el pool\n", img.width, img.height, mpix, pool.Size());
+        for (Format f : { Format::BC7, Format::ETC2 }) {
+            std::vector<uint8_t> blocks;
+            auto t0 = Clock::now();
+            BlockTexture::Encode(img, f, blocks);
+            auto t1 = Clock::now();
+            BlockTexture::Encode(img, f, blocks, &pool);
+            auto t2 = Clock::now();
+            double one = std::chrono::duration<double>(t1 - t0).count(), many = std::chrono::duration<double>(t2 - t1).count();
+            Png::Image back;
+            double psnr = BlockTexture::Decode(blocks, img.width, img.height, f, back) ? BlockTexture::Psnr(img, back) : 0.0;
+            std::printf("  %-4s 1 hilo %7.2f MP/s   pool %7.2f MP/s   %.2f dB\n", BlockTexture::Name(f), mpix / one, mpix / many, psnr);
+        }
+        return 0;
+    }
+
+    bool ParseFormats(const std::string& list, std::vector<Format>& out) {
+        out.clear();
+        size_t pos = 0;
+        while (pos <= list.size()) {
+            size_t end = list.find(',', pos);
+            std::string name = list.substr(pos, end == std::string::npos ? std::string::npos : end - pos);
+            if (name == "bc7") out.push_back(Format::BC7);
+            else if (name == "etc2") out.push_back(Format::ETC2);
+            else return false;
+            if (end == std::string::npos) break;
+            pos = end + 1;
+        }
+        return !out.empty();
+    }
+
+    void Usage() {
+        std::fprintf(stderr,
+            "Uso:\n"
+            "  ktxc <imagen.png> [--formats bc7,etc2]\n"
+            "  ktxc --dir <public> [--formats bc7,etc2] [--min-pixels N] [--min-psnr dB] [--force]\n"
+            "  ktxc --verify [public]\n"
+            "  ktxc --bench [imagen.png] [hilos]\n");
+    }
+
+    int Run(const std::vector<fs::path>& args) {
+        if (args.empty()) { Usage(); return 1; }
+        std::string cmd = args[0].u8string();
+        if (cmd == "--verify") return Verify(args.size() >= 2 ? args[1] : fs::path());
+        if (cmd == "--bench") {
+            fs::path png = args.size() >= 2 ? args[1] : fs::path();
+            size_t threads = args.size() >= 3 ? (size_t)std::atoi(args[2].u8string().c_str()) : 0;
+            return Bench(png, threads);
+        }
+
+        Options opt;
+        fs::path target;
+        bool dir = false;
+        for (size_t i = 0; i < args.size(); i++) {
+            std::string a = args[i].u8string();
+            bool hasValue = i + 1 < args.size();
+            if (a == "--dir" && hasValue) { dir = true; target = args[++i]; }
+            else if (a == "--force") opt.force = true;
+            else if (a == "--formats" && hasValue) { if (!ParseFormats(args[++i].u8string(), opt.formats)) { Usage(); return 1; } }
+            else if (a == "--min-pixels" && hasValue) opt.minPixels = (uint64_t)std::atoll(args[++i].u8string().c_str());
+            else if (a == "--min-psnr" && hasValue) opt.minPsnr[0] = opt.minPsnr[1] = std::atof(args[++i].u8string().c_str());
+            else if (target.empty()) target = args[i];
+            else { Usage(); return 1; }
+        }
+        if (target.empty()) { Usage(); return 1; }
+        return dir ? CompileDir(target, opt) : CompileFile(target, opt);
+    }
+}
+
+#ifdef _WIN32
+int wmain(int argc, wchar_t** argv) { return Run(std::vector<fs::path>(argv + 1, argv + argc)); }
+#else
+int main(int argc, char** argv) { return Run(std::vector<fs::path>(argv + 1, argv + argc)); }
+#endif
@@ -0,0 +1,256 @@
+/**
+ * librarybench - Comprueba y mide el índice de canciones (core/SongLibrary.h).
+ *
+ * Uso:
+ *   librarybench --verify [raíz]               Biblioteca sintética (nombres irregulares, Events.json,
+ *                                              stems); si se indica una raíz, también revisa su public/songs
+ *   librarybench --bench [raíz] [hilos]        Escaneo en frío (1 hilo y pool), en caliente y desde el
+ *                                              índice guardado
+ *
+ * La raíz es la carpeta que contiene public/ (por defecto el directorio actual); también valen
+ * public/ o public/songs, como en el resto de herramientas (Tool::ProjectRoot).
+ */
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "../core/SongLibrary.h"
+#include "../core/TaskPool.h"
+#include "../core/Utf.h"
+#include "Tool.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+    using namespace Tool;
+
+    /** Chart con `notes` notas por sección en carriles 0..7 alternos; la mitad de secciones mustHit. */
+    std::string MakeChart(const std::string& name, int sections, int notes, bool wrapped) {
+        std::string body = "{\"song\":\"" + name + "\",\"bpm\":150,\"speed\":2.5,\"player1\":\"bf\",\"player2\":\"dad\",\"notes\":[";
+        for (int s = 0; s < sections; s++) {
+            if (s) body += ',';
+            body += "{\"mustHitSection\":" + std::string(s % 2 ? "true" : "false") + ",\"sectionNotes\":[";
+            for (int n = 0; n < notes; n++) {
+                if (n) body += ',';
+                body += "[" + std::to_string(s * 1600 + n * 100) + "," + std::to_string(n % 8) + ",0]";
+            }
+            body += "]}";
+        }
+        body += "]}";
+        return wrapped ? "{\"song\":" + body + "}" : body;
+    }
+
+    /** Ogg mínimo: página con la cabecera de identificación y una última página con el granule. */
+    std::string MakeOgg(int channels, uint32_t rate, uint64_t frames) {
+        auto page = [](uint8_t flags, uint64_t granule, uint32_t seq, const std::string& packet) {
+            std::string p = "OggS";
+            p += '\0'; p += (char)flags;
+            for (int i = 0; i < 8; i++) p += (char)((granule >> (8 * i)) & 0xFF);
+            for (int i = 0; i < 4; i++) p += (char)((0x1234u >> (8 * i)) & 0xFF);
+            for (int i = 0; i < 4; i++) p += (char)((seq >> (8 * i)) & 0xFF);
+            p.append(4, '\0');
+            p += (char)(packet.empty() ? 0 : 1);
+            if (!packet.empty()) p += (char)packet.size();
+            return p + packet;
+        };
+        std::string id(30, '\0');
+        id[0] = 1; id.replace(1, 6, "vorbis");
+        id[11] = (char)channels;
+        for (int i = 0; i < 4; i++) id[12 + i] = (char)((rate >> (8 * i)) & 0xFF);
+        id[28] = (char)0xB8; id[29] = 1;
+        return page(2, 0, 0, id) + page(4, frames, 1, "");
+    }
+
+    std::string ToJson(const SongLibrary::Index& index) { std::string j; index.ToJson(j); return j; }
+
+    const SongLibrary::Song* Find(const SongLibrary::Index& index, const std::string& id) {
+        for (const auto& s : index.Songs()) if (s.id == id) return &s;
+        return nullptr;
+    }
+
+    bool Synthetic(const fs::path& root) {
+        fs::path songs = root / "public" / "songs";
+        WriteFile(songs / "Darnell" / "charts" / "darnell.json", MakeChart("Darnell", 4, 8, false));
+        WriteFile(songs / "Darnell" / "charts" / "darnell-easy.json", MakeChart("Darnell", 2, 4, false));
+        WriteFile(songs / "Darnell" / "charts" / "Darnell-hard.json", MakeChart("Darnell", 4, 16, true));
+        WriteFile(songs / "Darnell" / "song" / "Inst.ogg", MakeOgg(2, 48000, 48000 * 90));
+        WriteFile(songs / "Spookeez" / "charts" / "Spookeez.json", MakeChart("Spookeez", 3, 8, true));
+        WriteFile(songs / "Spookeez" / "charts" / "Spookeez-erect.json", MakeChart("Spookeez", 3, 8, true));
+        WriteFile(songs / "Spookeez" / "charts" / "Events.json", "{\"events\":[{\"time\":0,\"script\":\"bgHalloween\"}]}");
+        WriteFile(songs / "Spookeez" / "charts" / "spooky.json", "{\"stage\":[{\"type\":\"spritesheet\"}]}");
+        WriteFile(songs / "Spookeez" / "song" / "Inst.ogg", MakeOgg(2, 44100, 44100 * 60));
+        WriteFile(songs / "Spookeez" / "song" / "Voices.ogg", MakeOgg(1, 44100, 44100 * 61));
+        WriteFile(songs / "Spookeez" / "song" / "notes.txt", "no es audio");
+        WriteFile(songs / "Test" / "song" / "Voices-Player.ogg", "no es un ogg");
+
+        DirTreeCache tree(root);
+        SongLibrary::Index index;
+        SongLibrary::ScanStats st;
+        bool ok = index.Scan(tree, "public/songs", nullptr, &st);
+        Check(ok && index.Songs().size() == 3 && st.files == 11 && st.parsed == 11, "escaneo inicial: 3 canciones, 11 archivos leídos");
+
+        const SongLibrary::Song* darnell = Find(index, "Darnell");
+        bool diffs = darnell && darnell->charts.size() == 3 && darnell->charts[0].difficulty == "easy"
+            && darnell->charts[1].difficulty == "normal" && darnell->charts[2].difficulty == "hard"
+            && darnell->charts[2].file == "Darnell-hard.json";
+        Check(diffs, "dificultades con mayúsculas irregulares (darnell.json, darnell-easy, Darnell-hard)");
+
+        // Secciones alternas: la 0 (mustHit false) deja 0-3 en el oponente; la 1 los invierte
+        bool lanes = darnell && darnell->charts[1].notes == 32 && darnell->charts[1].sections == 4 && darnell->charts[1].bpm == 150;
+        if (lanes) for (int l = 0; l < 8; l++) lanes = lanes && darnell->charts[1].lanes[l] == 4;
+        Check(lanes, "notas, secciones, BPM y notas por carril");
+
+        const SongLibrary::Song* spook = Find(index, "Spookeez");
+        bool extras = spook && spook->charts.size() == 2 && spook->charts[1].difficulty == "erect" && spook->extras.size() == 2
+            && spook->extras[0].file == "Events.json" && spook->stems.size() == 2;
+        Check(extras, "Events.json y stage como extras, no como dificultades");
+        bool stems = spook && spook->stems[0].ok && spook->stems[0].rate == 44100 && spook->stems[0].channels == 2
+            && spook->stems[0].seconds == 60.0 && spook->stems[1].file == "Voices.ogg" && spook->stems[1].seconds == 61.0;
+        const SongLibrary::Song* test = Find(index, "Test");
+        Check(stems && test && test->stems.size() == 1 && !test->stems[0].ok, "cabeceras de audio: canales, frecuencia, duración; un .ogg roto queda marcado");
+        std::string j = ToJson(index);
+        Check(j.find("\"events\":true") != std::string::npos && j.find("\"seconds\":61") != std::string::npos, "JSON: eventos y duración de la canción (el stem más largo)");
+
+        // Incremental
+        std::string before = j;
+        index.Scan(tree, "public/songs", nullptr, &st);
+        Check(st.parsed == 0 && st.reused == 11 && ToJson(index) == before, "segundo escaneo: nada que parsear, mismo resultado");
+        WriteFile(songs / "Spookeez" / "charts" / "Spookeez.json", MakeChart("Spookeez", 5, 8, true));
+        fs::remove(songs / "Darnell" / "charts" / "darnell-easy.json");
+        index.Scan(tree, "public/songs", nullptr, &st);
+        spook = Find(index, "Spookeez");
+        darnell = Find(index, "Darnell");
+        Check(st.parsed == 1 && st.removed == 1 && spook && spook->charts[0].notes == 40 && darnell && darnell->charts.size() == 2,
+              "un chart modificado se vuelve a leer y uno borrado desaparece");
+
+        // Persistencia
+        std::string err;
+        fs::path saved = root / "library.json";
+        SongLibrary::Index loaded;
+        bool roundTrip = index.Save(saved, err) && loaded.Load(saved) && ToJson(loaded) == ToJson(index);
+        loaded.Scan(tree, "public/songs", nullptr, &st);
+        Check(roundTrip && st.parsed == 0 && ToJson(loaded) == ToJson(index), "índice guardado y recargado: el primer escaneo no parsea nada");
+
+        // Paralelo = secuencial
+        TaskPool pool(4);
+        SongLibrary::Index parallel;
+        parallel.Scan(tree, "public/songs", &pool, &st);
+        Check(st.parsed == 10 && ToJson(parallel) == ToJson(index), "escaneo en el pool = escaneo en un hilo");
+        return failures == 0;
+    }
+
+    void Real(const fs::path& root) {
+        DirTreeCache tree(root);
+        SongLibrary::Index index;
+        SongLibrary::ScanStats st;
+        bool ok = index.Scan(tree, "public/songs", nullptr, &st);
+        size_t charts = 0, stems = 0, badStems = 0, empty = 0;
+        for (const auto& s : index.Songs()) {
+            charts += s.charts.size();
+            stems += s.stems.size();
+            if (s.charts.empty()) empty++;
+            for (const auto& m : s.stems) if (!m.ok) badStems++;
+        }
+        std::printf("\n%s: %zu canciones, %zu charts, %zu stems\n", (root / "public" / "songs").generic_u8string().c_str(), index.Songs().size(), charts, stems);
+        Check(ok && !index.Songs().empty(), "la carpeta se escanea");
+        Check(empty == 0, "todas las canciones tienen al menos un chart");
+        Check(badStems == 0, "todas las cabeceras de audio se leen");
+    }
+
+    int Verify(const std::string& real) {
+        fs::path project;
+        if (!real.empty() && (project = ProjectRoot(real, "librarybench")).empty()) return 2;
+        std::printf("librarybench --verify\n");
+        fs::path root = fs::temp_directory_path() / ("librarybench-" + std::to_string(std::chrono::system_clock::now().time_since_epoch().count()));
+        Synthetic(root);
+        std::error_code ec;
+        fs::remove_all(root, ec);
+        if (!project.empty()) Real(project);
+        std::printf(failures ? "\n%d fallos\n" : "\ntodo OK\n", failures);
+        return failures ? 1 : 0;
+    }
+
+    // --- Benchmark ---
+
+    int Bench(const std::string& arg, size_t threads) {
+        fs::path root = ProjectRoot(arg, "librarybench");
+        if (root.empty()) return 2;
+        const std::string dir = "public/songs";
+        DirTreeCache tree(root);
+        TaskPool pool(threads);
+        SongLibrary::ScanStats st;
+        const int reps = 5;
+        std::printf("librarybench: %s (%zu hilos en el pool, mejor de %d)\n", (root / dir).generic_u8string().c_str(), pool.Size(), reps);
+
+        auto best = [&](auto&& fn) {
+            double b = 1e300;
+            for (int r = 0; r < reps; r++) { auto t0 = Clock::now(); fn(); b = std::min(b, Ms(Clock::now() - t0)); }
+            return b;
+        };
+
+        // Lo que hace hoy la página: listar y parsear cada .json entero
+        size_t parsedBytes = 0;
+        double naive = best([&] {
+            std::vector<DirTreeCache::Item> items;
+            tree.List(dir, true, "*/charts/*.json", items);
+            parsedBytes = 0;
+            for (const auto& item : items) {
+                std::string text;
+                Json::Value doc;
+                AtomicFile::ReadAll(root / dir / fs::u8path(item.path), text);
+                Json::Parse(text, doc);
+                parsedBytes += text.size();
+            }
+        });
+        double cold1 = best([&] { SongLibrary::Index index; index.Scan(tree, dir, nullptr, &st); });
+        size_t files = st.files;
+        double coldPool = best([&] { SongLibrary::Index index; index.Scan(tree, dir, &pool, &st); });
+
+        SongLibrary::Index index;
+        index.Scan(tree, dir, &pool);
+        double warm = best([&] { index.Scan(tree, dir, &pool, &st); });
+        uint64_t reparsed = st.parsed;
+
+        fs::path saved = fs::temp_directory_path() / "librarybench-index.json";
+        std::string err, json;
+        index.Save(saved, err);
+        double fromDisk = best([&] { SongLibrary::Index loaded; loaded.Load(saved); loaded.Scan(tree, dir, &pool, &st); });
+        double query = best([&] { json.clear(); index.ToJson(json); });
+        std::error_code ec;
+        fs::remove(saved, ec);
+
+        std::printf("  %zu archivos, %.1f MB de JSON de charts\n", files, parsedBytes / 1048576.0);
+        std::printf("  %-44s %9.2f ms\n", "página hoy (listar + parsear cada chart)", naive);
+        std::printf("  %-44s %9.2f ms\n", "índice en frío, 1 hilo", cold1);
+        std::printf("  %-44s %9.2f ms  (x%.1f)\n", "índice en frío, pool", coldPool, cold1 / coldPool);
+        std::printf("  %-44s %9.2f ms  (%llu reparseados)\n", "reescaneo sin cambios", warm, (unsigned long long)reparsed);
+        std::printf("  %-44s %9.2f ms  (%llu reparseados)\n", "arranque: índice guardado + reescaneo", fromDisk, (unsigned long long)st.parsed);
+        std::printf("  %-44s %9.3f ms  (%zu KB)\n", "consulta (JSON para la página)", query, json.size() >> 10);
+        return 0;
+    }
+
+    int Run(const std::vector<std::string>& args) {
+        if (!args.empty() && args[0] == "--verify") return Verify(args.size() >= 2 ? args[1] : "");
+        if (!args.empty() && args[0] == "--bench") {
+            return Bench(args.size() >= 2 ? args[1] : "", args.size() >= 3 ? (size_t)std::max(0, std::atoi(args[2].c_str())) : 0);
+        }
+        std::fprintf(stderr, "uso: librarybench --verify [raíz] | --bench [raíz] [hilos]\n");
+        return 2;
+    }
+}
+
+#ifdef _WIN32
+int wmain(int argc, wchar_t** argv) {
+    std::vector<std::string> args;
+    for (int i = 1; i < argc; i++) args.push_back(Utf::ToUtf8(argv[i]));
+    return Run(args);
+}
+#else
+int main(int argc, char** argv) {
+    return Run(std::vector<std::string>(argv + 1, argv + argc));
+}
+#endif
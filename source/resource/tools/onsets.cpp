@@ -0,0 +1,417 @@
+/**
+ * onsets - Análisis de ritmo de las canciones (ver core/Onsets.h): BPM, fase y notas sugeridas.
+ *
+ * Uso:
+ *   onsets <carpeta de canción> [bpm] [subdivisión]   Tempo de Inst.ogg y sugerencias por pista de voz
+ *   onsets --verify [carpeta de canciones]            FFT contra DFT y SIMD contra escalar, señal sintética
+ *                                                     y precisión contra los charts hechos a mano
+ *   onsets --bench <carpeta de canciones> [hilos]     Segundos de audio analizados por segundo
+ */
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../core/ChartIndex.h"
+#include "../core/Onsets.h"
+#include "Tool.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+    using namespace Tool;
+
+    std::string Lower(std::string s) {
+        for (auto& c : s) c = (char)std::tolower((unsigned char)c);
+        return s;
+    }
+
+    /** Pista de una canción: archivo y, para comparar, qué carriles del chart le tocan. */
+    struct Stem {
+        fs::path path;
+        const char* role;
+        int laneFrom, laneTo;
+    };
+
+    std::vector<Stem> StemsOf(const fs::path& songDir) {
+        static const struct { const char* file; const char* role; int from, to; } kStems[] = {
+            { "Voices-Player.ogg", "player", 4, 7 },
+            { "Voices-Opponent.ogg", "opponent", 0, 3 },
+            { "Voices.ogg", "voices", 0, 7 },
+        };
+        std::vector<Stem> out;
+        std::error_code ec;
+        for (const auto& s : kStems) {
+            fs::path p = songDir / "song" / s.file;
+            if (fs::is_regular_file(p, ec)) out.push_back({ p, s.role, s.from, s.to });
+        }
+        return out;
+    }
+
+    /** Chart base de la canción: charts/<Nombre>.json, sin distinguir mayúsculas. */
+    fs::path ChartOf(const fs::path& songDir) {
+        std::error_code ec;
+        std::string want = Lower(songDir.filename().u8string()) + ".json";
+        for (auto it = fs::directory_iterator(songDir / "charts", ec); !ec && it != fs::directory_iterator(); it.increment(ec)) {
+            if (Lower(it->path().filename().u8string()) == want) return it->path();
+        }
+        return {};
+    }
+
+    bool Analyze(const fs::path& ogg, Onsets::Analysis& out, std::string& err) {
+        MappedFile src;
+        if (!src.Open(ogg)) { err = "cannot read"; return false; }
+        return Onsets::Build(src.Data(), src.Size(), 0, out, &err);
+    }
+
+    /** Emparejamiento uno a uno dentro de ±tol (ms) de dos listas ordenadas. */
+    size_t Matches(const std::vector<double>& ref, const std::vector<double>& got, double tol) {
+        size_t j = 0, hits = 0;
+        for (double r : ref) {
+            while (j < got.size() && got[j] < r - tol) j++;
+            if (j < got.size() && got[j] <= r + tol) { hits++; j++; }
+        }
+        return hits;
+    }
+
+    /** Distancia (ms) entre una fase y la rejilla que empieza en 0. */
+    double PhaseError(double phaseMs, double bpm) {
+        double beat = 60000.0 / bpm, d = std::fmod(phaseMs, beat);
+        if (d < 0) d += beat;
+        return std::min(d, beat - d);
+    }
+
+    // --- Comprobaciones ---
+
+    void VerifyFft() {
+        std::printf("fft\n");
+        std::mt19937 rng(7);
+        std::uniform_real_distribution<float> u(-1.0f, 1.0f);
+        double worst = 0, simdWorst = 0;
+        for (size_t n = 8; n <= 2048; n *= 2) {
+            std::vector<float> x(n);
+            for (auto& v : x) v = u(rng);
+            Onsets::RealFft f;
+            f.Init(n);
+            std::vector<float> fast(n / 2 + 1), slow(n / 2 + 1);
+            f.Magnitudes(x.data(), fast.data(), true);
+            f.Magnitudes(x.data(), slow.data(), false);
+            for (size_t k = 0; k <= n / 2; k++) {
+                double re = 0, im = 0;
+                for (size_t i = 0; i < n; i++) {
+                    double a = -2.0 * Onsets::Detail::kPi * (double)(k * i % n) / (double)n;
+                    re += x[i] * std::cos(a); im += x[i] * std::sin(a);
+                }
+                double ref = std::sqrt(re * re + im * im);
+                worst = std::max(worst, std::fabs(fast[k] - ref) / std::sqrt((double)n));
+                simdWorst = std::max(simdWorst, (double)std::fabs(fast[k] - slow[k]));
+            }
+        }
+        Check(worst < 1e-5, "magnitudes iguales a la DFT directa (8 a 2048 puntos)");
+        Check(simdWorst < 1e-4, "SIMD igual que escalar");
+    }
+
+    /**
+     * Canción sintética: bombo en cada pulso (128 BPM, primer pulso a 137 ms) y una "voz" de tonos
+     * en semicorcheas elegidas, con una nota repetida, subidas y una nota larga.
+     */
+    void VerifySynthetic() {
+        std::printf("señal sintética\n");
+        const uint32_t rate = 44100;
+        const double bpm = 128, phase = 137, beat = 60000.0 / bpm, step = beat / 4;
+        const double seconds = 40;
+        size_t n = (size_t)(seconds * rate);
+        std::vector<float> drums(n, 0.0f), voice(n, 0.0f);
+        std::mt19937 rng(3);
+        std::normal_distribution<float> noise(0.0f, 1.0f);
+        for (double t = phase; t < seconds * 1000; t += beat) {
+            size_t at = (size_t)(t * rate / 1000);
+            for (size_t i = 0; i < 4000 && at + i < n; i++) {
+                float env = std::exp(-(float)i / 600.0f);
+                drums[at + i] += 0.6f * env * (std::sin(2.0f * 3.14159265f * 60.0f * i / rate) + 0.3f * noise(rng));
+            }
+        }
+        // (paso en la rejilla, semitonos sobre La 220, pasos de duración)
+        struct Tone { int slot; int semis; int len; };
+        std::vector<Tone> tones;
+        for (int bar = 0; bar < 18; bar++) {
+            int base = 16 * bar;
+            tones.push_back({ base + 0, 0, 2 });
+            tones.push_back({ base + 2, 0, 2 });    // Repetida
+            tones.push_back({ base + 4, 4, 2 });
+            tones.push_back({ base + 6, 7, 2 });
+            tones.push_back({ base + 8, 12, 6 });   // Larga
+        }
+        std::vector<double> expected;
+        for (const Tone& tn : tones) {
+            double t0 = phase + tn.slot * step;
+            if (t0 >= seconds * 1000 - 1000) break;
+            expected.push_back(t0);
+            double hz = 220.0 * std::pow(2.0, tn.semis / 12.0);
+            size_t at = (size_t)(t0 * rate / 1000), len = (size_t)(tn.len * step * rate / 1000) - rate / 50;
+            for (size_t i = 0; i < len && at + i < n; i++) {
+                float env = std::min(1.0f, (float)i / 200.0f) * std::min(1.0f, (float)(len - i) / 400.0f);
+                double ph = 2.0 * 3.14159265358979 * hz * (double)i / rate;
+                voice[at + i] += 0.3f * env * (float)(std::sin(ph) + 0.5 * std::sin(2 * ph) + 0.25 * std::sin(3 * ph));
+            }
+        }
+
+        auto analyze = [&](const std::vector<float>& mono) {
+            Onsets::Analyzer a(2, rate);
+            std::vector<float> left(mono), right(mono);
+            // Tramos de tamaño irregular, como los entrega el decodificador
+            for (size_t at = 0, k = 0; at < n; k++) {
+                size_t len = std::min(n - at, (size_t)(700 + (k * 977) % 1500));
+                const float* ch[2] = { left.data() + at, right.data() + at };
+                a.Push(ch, len);
+                at += len;
+            }
+            return a.Finish(42);
+        };
+
+        Onsets::Analysis inst = analyze(drums);
+        Check(inst.curve.size() == (size_t)(seconds * Onsets::kFps) + 1, "100 frames por segundo");
+        Onsets::Tempo tempo = Onsets::EstimateTempo(inst.curve);
+        std::printf("         %.2f BPM, fase %.1f ms, confianza %.2f\n", tempo.bpm, tempo.phaseMs, tempo.confidence);
+        Check(std::fabs(tempo.bpm - bpm) < 0.01, "BPM del bombo");
+        Check(std::fabs(tempo.phaseMs - phase) <= 15, "fase del primer pulso (±15 ms)");
+
+        Onsets::Analysis vox = analyze(voice);
+        std::vector<double> got;
+        for (const auto& o : vox.onsets) got.push_back(o.timeMs);
+        size_t hits = Matches(expected, got, 20);
+        std::printf("         %zu onsets de %zu notas, %zu a ±20 ms\n", got.size(), expected.size(), hits);
+        Check(hits == expected.size() && got.size() == expected.size(), "un onset por nota, a ±20 ms");
+
+        std::vector<Onsets::Note> notes = Onsets::Suggest(vox.onsets, bpm, phase, 4);
+        bool onGrid = notes.size() == expected.size();
+        for (size_t i = 0; onGrid && i < notes.size(); i++) onGrid = std::fabs(notes[i].timeMs - expected[i]) < 0.5;
+        Check(onGrid, "cuantizadas caen en la casilla de cada nota");
+        bool lanes = onGrid;
+        bool sustains = onGrid;
+        for (size_t i = 0; onGrid && i + 5 <= notes.size(); i += 5) {
+            lanes = lanes && notes[i + 1].lane == notes[i].lane;            // Repetida: mismo carril
+            lanes = lanes && notes[i + 2].lane != notes[i + 1].lane;        // Sube: cambia
+            lanes = lanes && notes[i + 3].lane != notes[i + 2].lane;
+            sustains = sustains && notes[i].sustainMs == 0 && notes[i + 4].sustainMs >= 3 * step - 1;
+        }
+        Check(lanes, "nota repetida repite carril; al subir cambia");
+        Check(sustains, "nota larga con duración, cortas sin ella");
+
+        std::string bytes = Onsets::Serialize(vox);
+        Onsets::Analysis back;
+        bool same = Onsets::Parse(bytes.data(), bytes.size(), back, 42) && back.onsets.size() == vox.onsets.size()
+            && back.curve.size() == vox.curve.size() && back.frames == vox.frames;
+        for (size_t i = 0; same && i < back.onsets.size(); i++) same = back.onsets[i].timeMs == vox.onsets[i].timeMs;
+        Check(same, "serializa y vuelve a leer igual");
+        Check(!Onsets::Parse(bytes.data(), bytes.size(), back, 43), "rechaza un .gons de otro audio");
+        Check(!Onsets::Parse(bytes.data(), bytes.size() - 1, back), "rechaza un .gons truncado");
+    }
+
+    /**
+     * Contra los charts del juego: BPM y fase de Inst.ogg (los charts empiezan en un pulso), y
+     * onsets de cada voz contra las notas de sus carriles. La fase se da por buena a ±60 ms: el
+     * audio de las primeras semanas viene de MP3 y trae ~50 ms de relleno que el chart no
+     * compensa; la fase que se mide es la del audio, que es la que hay que oír. Los
+     * charters no ponen una nota por sílaba, así que esto mide cuánto ahorran las sugerencias,
+     * no un acierto exacto.
+     */
+    void VerifySongs(const fs::path& root) {
+        std::printf("charts de %s\n", root.u8string().c_str());
+        std::error_code ec;
+        std::vector<fs::path> songs;
+        for (auto it = fs::directory_iterator(root, ec); !ec && it != fs::directory_iterator(); it.increment(ec)) {
+            if (it->is_directory(ec)) songs.push_back(it->path());
+        }
+        std::sort(songs.begin(), songs.end());
+        int tempoSongs = 0, exact = 0, related = 0, phaseOk = 0;
+        double refTotal = 0, gotTotal = 0, hitTotal = 0, gridHits = 0;
+        std::printf("  %-20s %6s %8s %7s %9s  %-8s %6s %6s %5s %5s %5s\n", "canción", "chart", "BPM", "conf", "fase ms", "pista", "notas", "onsets", "prec", "recall", "F1");
+        for (const fs::path& dir : songs) {
+            fs::path chartPath = ChartOf(dir);
+            ChartIndex chart;
+            if (chartPath.empty() || !chart.Load(chartPath) || chart.bpm <= 0 || chart.Count() == 0) continue;
+            std::string name = dir.filename().u8string();
+            Onsets::Tempo tempo;
+            std::string err;
+            Onsets::Analysis inst;
+            bool haveInst = Analyze(dir / "song" / "Inst.ogg", inst, err);
+            if (haveInst) {
+                tempo = Onsets::EstimateTempo(inst.curve);
+                tempoSongs++;
+                double ratio = tempo.bpm / chart.bpm;
+                bool isExact = std::fabs(tempo.bpm - chart.bpm) <= 0.5;
+                exact += isExact;
+                // Nivel métrico equivocado: el doble, la mitad o el 3:2 de un compás ternario
+                for (double m : { 2.0, 0.5, 1.5, 2.0 / 3.0 }) {
+                    if (!isExact && std::fabs(ratio - m) < 0.005 * m) { related++; break; }
+                }
+                if (isExact && PhaseError(tempo.phaseMs, chart.bpm) <= 60) phaseOk++;
+            }
+            for (const Stem& s : StemsOf(dir)) {
+                Onsets::Analysis vox;
+                if (!Analyze(s.path, vox, err)) continue;
+                std::vector<double> ref, got;
+                for (size_t i = 0; i < chart.Count(); i++) {
+                    if (chart.lane[i] < s.laneFrom || chart.lane[i] > s.laneTo) continue;
+                    if (ref.empty() || chart.time[i] - ref.back() > 1) ref.push_back(chart.time[i]);
+                }
+                std::sort(ref.begin(), ref.end());
+                ref.erase(std::unique(ref.begin(), ref.end(), [](double a, double b) { return b - a <= 1; }), ref.end());
+                for (const auto& o : vox.onsets) got.push_back(o.timeMs);
+                size_t hits = Matches(ref, got, 70);
+                // Sugerencias con el BPM del chart: casilla exacta
+                std::vector<double> grid;
+                for (const auto& nt : Onsets::Suggest(vox.onsets, chart.bpm, 0, 4)) grid.push_back(nt.timeMs);
+                gridHits += (double)Matches(ref, grid, 60000.0 / chart.bpm / 8);
+                double p = got.empty() ? 0 : (double)hits / got.size(), r = ref.empty() ? 0 : (double)hits / ref.size();
+                std::printf("  %-20s %6.1f %8.2f %7.2f %9.1f  %-8s %6zu %6zu %5.2f %5.2f %5.2f\n", name.c_str(), chart.bpm,
+                    tempo.bpm, tempo.confidence, haveInst ? PhaseError(tempo.phaseMs, chart.bpm) : -1.0, s.role,
+                    ref.size(), got.size(), p, r, p + r > 0 ? 2 * p * r / (p + r) : 0.0);
+                refTotal += ref.size(); gotTotal += got.size(); hitTotal += hits;
+                name.clear();
+            }
+            if (!name.empty() && haveInst) {
+                std::printf("  %-20s %6.1f %8.2f %7.2f %9.1f  -\n", name.c_str(), chart.bpm, tempo.bpm, tempo.confidence,
+                    PhaseError(tempo.phaseMs, chart.bpm));
+            }
+        }
+        if (tempoSongs == 0) { std::printf("  (sin canciones con chart e Inst.ogg)\n"); return; }
+        double p = hitTotal / std::max(1.0, gotTotal), r = hitTotal / std::max(1.0, refTotal), f1 = 2 * p * r / std::max(1e-9, p + r);
+        std::printf("  BPM exacto (±0,5) %d/%d, doble, mitad o 3:2 %d; fase a ±60 ms %d/%d\n", exact, tempoSongs, related, phaseOk, exact);
+        std::printf("  onsets a ±70 ms: precisión %.2f, recall %.2f, F1 %.2f; en la casilla de 1/16: %.2f de las notas\n",
+            p, r, f1, gridHits / std::max(1.0, refTotal));
+        Check(exact >= (tempoSongs * 3) / 4, "BPM exacto en al menos 3/4 de las canciones");
+        Check(exact + related >= tempoSongs - 2, "BPM exacto o de otro nivel métrico en casi todas");
+        Check(phaseOk >= (exact * 3) / 4, "fase a ±60 ms del chart cuando el BPM es exacto");
+        Check(f1 >= 0.7, "F1 de onsets >= 0,7");
+        Check(gridHits >= 0.7 * refTotal, "al menos el 70% de las notas tiene sugerencia en su casilla");
+    }
+
+    int Verify(const fs::path& songs) {
+        VerifyFft();
+        VerifySynthetic();
+        std::error_code ec;
+        if (!songs.empty() && fs::is_directory(songs, ec)) VerifySongs(songs);
+        std::printf(failures ? "\n%d fallos\n" : "\ntodo OK\n", failures);
+        return failures ? 1 : 0;
+    }
+
+    int Bench(const fs::path& root, unsigned threads) {
+        std::vector<fs::path> files;
+        std::error_code ec;
+        for (auto it = fs::recursive_directory_iterator(root, ec); !ec && it != fs::recursive_directory_iterator(); it.increment(ec)) {
+            if (it->is_regular_file(ec) && Lower(it->path().extension().u8string()) == ".ogg") files.push_back(it->path());
+        }
+        std::sort(files.begin(), files.end());
+        if (files.empty()) { std::fprintf(stderr, "onsets: no hay .ogg en %s\n", root.u8string().c_str()); return 1; }
+        struct Job { MappedFile src; double audio = 0, decode = 0, analyze = 0; bool ok = false; };
+        std::vector<Job> jobs(files.size());
+        for (size_t i = 0; i < files.size(); i++) jobs[i].src.Open(files[i]);
+
+        auto run = [&](Job& j) {
+            Vorbis::Decoder dec;
+            if (!dec.Open(j.src.Data(), j.src.Size())) return;
+            Onsets::Analyzer a(dec.Channels(), dec.SampleRate());
+            Clock::duration inAnalysis{};
+            auto t0 = Clock::now();
+            uint64_t frames = dec.Decode([&](const float* const* pcm, size_t n) {
+                auto a0 = Clock::now();
+                a.Push(pcm, n);
+                inAnalysis += Clock::now() - a0;
+            });
+            auto a0 = Clock::now();
+            Onsets::Analysis out = a.Finish(0);
+            Onsets::EstimateTempo(out.curve);
+            Onsets::Suggest(out.onsets, 120, 0, 4);
+            inAnalysis += Clock::now() - a0;
+            double total = Seconds(Clock::now() - t0);
+            j.analyze = Seconds(inAnalysis);
+            j.decode = total - j.analyze;
+            j.audio = (double)frames / dec.SampleRate();
+            j.ok = true;
+        };
+
+        auto s0 = Clock::now();
+        for (auto& j : jobs) run(j);
+        double serial = Seconds(Clock::now() - s0);
+        double audio = 0, decode = 0, analyze = 0, longest = 0;
+        size_t ok = 0;
+        for (auto& j : jobs) {
+            if (!j.ok) continue;
+            ok++; audio += j.audio; decode += j.decode; analyze += j.analyze;
+            longest = std::max(longest, j.decode + j.analyze);
+        }
+
+        std::atomic<size_t> next{0};
+        std::vector<std::thread> pool;
+        auto p0 = Clock::now();
+        for (unsigned t = 0; t < threads; t++) pool.emplace_back([&] { for (size_t i; (i = next++) < jobs.size(); ) run(jobs[i]); });
+        for (auto& t : pool) t.join();
+        double parallel = Seconds(Clock::now() - p0);
+
+        std::printf("onsets bench: %zu/%zu archivos, %.1f min de audio\n", ok, files.size(), audio / 60.0);
+        std::printf("  1 hilo      %8.2f s  -> %7.0f s de audio/s\n", serial, audio / serial);
+        std::printf("    decodificar %6.2f s  (%7.0f s/s)\n", decode, audio / decode);
+        std::printf("    analizar    %6.2f s  (%7.0f s/s: FFT, flujo, onsets, tempo, sugerencias)\n", analyze, audio / std::max(analyze, 1e-9));
+        std::printf("  pista más lenta: %.2f s\n", longest);
+        std::printf("  %u hilos    %8.2f s  -> %7.0f s de audio/s\n", threads, parallel, audio / parallel);
+        return ok == files.size() ? 0 : 1;
+    }
+
+    int Show(const fs::path& songDir, double bpm, int subdivision) {
+        std::string err;
+        Onsets::Analysis inst;
+        Onsets::Tempo tempo;
+        if (Analyze(songDir / "song" / "Inst.ogg", inst, err)) tempo = Onsets::EstimateTempo(inst.curve);
+        if (bpm > 0) { tempo.bpm = bpm; tempo.phaseMs = Onsets::EstimatePhase(inst.curve, bpm); }
+        std::printf("%s: %.2f BPM, fase %.1f ms, confianza %.2f\n", songDir.filename().u8string().c_str(), tempo.bpm, tempo.phaseMs, tempo.confidence);
+        auto stems = StemsOf(songDir);
+        if (stems.empty()) { std::fprintf(stderr, "onsets: no hay voces en %s/song\n", songDir.u8string().c_str()); return 1; }
+        for (const Stem& s : stems) {
+            Onsets::Analysis vox;
+            if (!Analyze(s.path, vox, err)) { std::fprintf(stderr, "[ERROR] %s: %s\n", s.path.u8string().c_str(), err.c_str()); continue; }
+            auto notes = Onsets::Suggest(vox.onsets, tempo.bpm, tempo.phaseMs, subdivision);
+            std::printf("  %-8s %zu onsets -> %zu notas\n", s.role, vox.onsets.size(), notes.size());
+            for (size_t i = 0; i < std::min<size_t>(notes.size(), 12); i++) {
+                std::printf("    %9.1f ms  carril %d  %6.1f ms\n", notes[i].timeMs, notes[i].lane, notes[i].sustainMs);
+            }
+        }
+        return 0;
+    }
+
+    void Usage() {
+        std::fprintf(stderr,
+            "Uso:\n"
+            "  onsets <carpeta de canción> [bpm] [subdivisión]\n"
+            "  onsets --verify [carpeta de canciones]\n"
+            "  onsets --bench <carpeta de canciones> [hilos]\n");
+    }
+
+    int Run(const std::vector<fs::path>& args) {
+        if (args.empty()) { Usage(); return 1; }
+        std::string cmd = args[0].u8string();
+        if (cmd == "--verify") return Verify(args.size() >= 2 ? args[1] : fs::path());
+        if (cmd == "--bench" && args.size() >= 2) {
+            unsigned threads = args.size() >= 3 ? (unsigned)std::max(1, std::atoi(args[2].u8string().c_str())) : std::max(1u, std::thread::hardware_concurrency());
+            return Bench(args[1], threads);
+        }
+        if (cmd.rfind("--", 0) == 0) { Usage(); return 1; }
+        double bpm = args.size() >= 2 ? std::atof(args[1].u8string().c_str()) : 0;
+        int subdivision = args.size() >= 3 ? std::max(1, std::atoi(args[2].u8string().c_str())) : 4;
+        return Show(args[0], bpm, subdivision);
+    }
+}
+
+#ifdef _WIN32
+int wmain(int argc, wchar_t** argv) { return Run(std::vector<fs::path>(argv + 1, argv + argc)); }
+#else
+int main(int argc, char** argv) { return Run(std::vector<fs::path>(argv + 1, argv + argc)); }
+#endif
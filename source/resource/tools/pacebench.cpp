@@ -0,0 +1,195 @@
+/**
+ * pacebench - Comprueba y mide la frecuencia del bucle y el limitador de frames (core/FramePacer.h).
+ *
+ * Uso:
+ *   pacebench --verify                     Prioridad de frecuencias, avisos de cambio y limitador sobre
+ *                                          vsync sintético (60 / 144 / 240 Hz con jitter, pausas, parones)
+ *   pacebench --bench [segundos]           Frames por segundo y error del intervalo (p50 / p99 / máx) para
+ *                                          cada pantalla y límite, y ns por frame del limitador
+ *
+ * Todo va con tiempos sintéticos: los resultados no dependen de la carga de la máquina.
+ */
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "../core/FramePacer.h"
+#include "../core/Utf.h"
+#include "Tool.h"
+
+namespace {
+
+    using namespace Tool;
+
+    bool Near(double v, double want, double tolerance) { return std::fabs(v - want) <= tolerance; }
+
+    struct Run {
+        double fps = 0;
+        double p50Ms = 0, p99Ms = 0, maxMs = 0;  // |intervalo - periodo|
+        double meanMs = 0;
+        FramePacer::Gate::Stats stats;
+    };
+
+    /**
+     * Pasa `seconds` de requestAnimationFrame a `displayHz` por un limitador a `limitHz`. Cada marca
+     * es la de su vsync más un jitter uniforme de ±jitterMs (sin acumular, como los de la pantalla).
+     */
+    Run Simulate(double displayHz, double limitHz, double seconds, double jitterMs, uint32_t seed = 12345) {
+        FramePacer::Gate gate;
+        gate.SetRate(limitHz);
+        double t = 0, last = 0, period = limitHz > 0 ? 1000.0 / limitHz : 1000.0 / displayHz;
+        std::vector<double> errors;
+        double sum = 0;
+        uint64_t n = (uint64_t)(displayHz * seconds);
+        for (uint64_t i = 0; i < n; i++) {
+            seed = seed * 1664525u + 1013904223u;
+            t = 1000 + (double)i * 1000.0 / displayHz + ((double)(seed >> 8) / 16777216.0 - 0.5) * 2 * jitterMs;
+            if (!gate.Admit(t)) continue;
+            if (last > 0) { errors.push_back(std::fabs(t - last - period)); sum += t - last; }
+            last = t;
+        }
+        Run r;
+        r.stats = gate.GetStats();
+        r.fps = r.stats.frames / seconds;
+        if (!errors.empty()) {
+            r.meanMs = sum / errors.size();
+            std::sort(errors.begin(), errors.end());
+            r.p50Ms = errors[errors.size() / 2];
+            r.p99Ms = errors[std::min(errors.size() - 1, errors.size() * 99 / 100)];
+            r.maxMs = errors.back();
+        }
+        return r;
+    }
+
+    int Verify() {
+        std::printf("frecuencia efectiva\n");
+        {
+            FramePacer p;
+            p.SetRate(60);
+            Check(p.Rate() == 60, "base = fpsLimit");
+            p.SetSceneRate("PlayScene", 144);
+            p.SetScene("MainMenuScene");
+            Check(p.Rate() == 60, "escena sin ajuste propio usa la base");
+            p.SetScene("PlayScene");
+            Check(p.Rate() == 144, "escena con ajuste propio");
+            p.SetIdleRate(30);
+            p.SetIdle(true);
+            Check(p.Rate() == 30, "en reposo baja al tope de reposo");
+            p.SetSceneRate("PlayScene", 20);
+            Check(p.Rate() == 20, "el tope de reposo no sube una escena más lenta");
+            p.SetMinimized(true);
+            Check(p.Rate() == 0, "minimizada sin frecuencia propia = en pausa");
+            p.SetMinimizedRate(5);
+            Check(p.Rate() == 5, "minimizada con frecuencia propia");
+            p.SetMinimized(false);
+            p.SetIdle(false);
+            p.SetSceneRate("PlayScene", 0);
+            Check(p.Rate() == 60, "quitar el ajuste de la escena vuelve a la base");
+            p.SetRate(5000);
+            Check(p.Rate() == 1000, "frecuencia limitada a 1000 Hz");
+        }
+
+        std::printf("avisos de cambio\n");
+        {
+            FramePacer p;
+            p.SetRate(60);
+            std::vector<double> seen;
+            p.SetOnChange([&](double hz) { seen.push_back(hz); });
+            p.SetScene("PlayScene");
+            p.SetIdleRate(30);
+            Check(seen.empty(), "sin cambio de la frecuencia efectiva no hay aviso");
+            p.SetIdle(true);
+            p.SetMinimized(true);
+            p.SetMinimized(false);
+            p.SetIdle(false);
+            Check(seen == std::vector<double>{ 30, 0, 30, 60 }, "un aviso por cambio, con la frecuencia nueva");
+        }
+
+        std::printf("limitador sobre vsync sintético (±0,5 ms de jitter)\n");
+        {
+            Run r = Simulate(60, 60, 20, 0.5);
+            Check(r.stats.skipped == 0 && Near(r.fps, 60, 0.1), "60 Hz en pantalla de 60 Hz: ningún frame saltado");
+            r = Simulate(144, 144, 20, 0.5);
+            Check(r.stats.skipped == 0, "144 Hz en pantalla de 144 Hz: ningún frame saltado");
+            r = Simulate(144, 60, 20, 0.5);
+            Check(Near(r.fps, 60, 0.2) && Near(r.meanMs, 1000.0 / 60, 0.05), "60 Hz en pantalla de 144 Hz: 60 de media");
+            Check(r.maxMs < 1000.0 / 144 + 1.0, "  cada intervalo a menos de un refresco del periodo");
+            r = Simulate(240, 60, 20, 0.5);
+            Check(Near(r.fps, 60, 0.2), "60 Hz en pantalla de 240 Hz");
+            r = Simulate(60, 30, 20, 0.5);
+            Check(Near(r.fps, 30, 0.1) && r.maxMs < 1.5, "30 Hz en pantalla de 60 Hz: uno de cada dos, sin saltos de más");
+            r = Simulate(59.94, 60, 60, 0.5);
+            Check(r.stats.skipped == 0, "pantalla de 59,94 Hz con límite de 60: ninguno saltado");
+            r = Simulate(60.05, 60, 60, 0.5);
+            Check(r.stats.skipped >= 1 && r.stats.skipped <= 4 && Near(r.fps, 60, 0.05), "pantalla de 60,05 Hz con límite de 60: solo los que sobran");
+            r = Simulate(60, 300, 20, 0.5);
+            Check(r.stats.skipped == 0, "límite por encima del refresco: van todos");
+            r = Simulate(60, 0, 5, 0.5);
+            Check(r.stats.frames == 0 && r.stats.skipped == 300, "en pausa no pasa ninguno");
+            Check(Near(r.stats.refreshMs, 1000.0 / 60, 0.2), "el refresco estimado sigue al vsync");
+        }
+
+        std::printf("cambios y parones\n");
+        {
+            FramePacer::Gate g;
+            g.SetRate(60);
+            double t = 0;
+            for (int i = 0; i < 60; i++) g.Admit(t += 1000.0 / 144);
+            uint64_t before = g.GetStats().frames;
+            g.SetRate(30);
+            for (int i = 0; i < 144; i++) g.Admit(t += 1000.0 / 144);
+            Check(Near((double)(g.GetStats().frames - before), 30, 1), "cambio a 30 Hz en marcha: ~30 frames en 1 s");
+
+            // Pestaña oculta 2 s: al volver no hay ráfaga para recuperar los plazos perdidos
+            t += 2000;
+            before = g.GetStats().frames;
+            for (int i = 0; i < 10; i++) g.Admit(t += 1000.0 / 144);
+            uint64_t got = g.GetStats().frames - before;
+            Check(got >= 1 && got <= 3, "tras un parón de 2 s sigue a 30 Hz, sin ráfaga");
+        }
+
+        std::printf(failures ? "\n%d fallos\n" : "\ntodo OK\n", failures);
+        return failures ? 1 : 0;
+    }
+
+    int Bench(double seconds) {
+        std::printf("%.0f s de vsync sintético por fila, ±0,5 ms de jitter; error = |intervalo - periodo| en ms\n", seconds);
+        std::printf("  %9s %7s %8s %7s %7s %7s %9s\n", "pantalla", "límite", "frames/s", "p50", "p99", "máx", "medio ms");
+        const double pairs[][2] = { { 59.94, 60 }, { 60, 60 }, { 60, 30 }, { 144, 60 }, { 144, 144 }, { 165, 120 }, { 240, 60 }, { 240, 144 } };
+        for (const auto& pr : pairs) {
+            Run r = Simulate(pr[0], pr[1], seconds, 0.5);
+            std::printf("  %6.2f Hz %4.0f Hz %8.1f %7.2f %7.2f %7.2f %9.3f\n", pr[0], pr[1], r.fps, r.p50Ms, r.p99Ms, r.maxMs, r.meanMs);
+        }
+        FramePacer::Gate g;
+        g.SetRate(60);
+        const uint64_t n = 20000000;
+        uint64_t passed = 0;
+        auto t0 = Clock::now();
+        for (uint64_t i = 0; i < n; i++) passed += g.Admit((double)i * (1000.0 / 144));
+        double ns = Ms(Clock::now() - t0) * 1e6 / n;
+        std::printf("\n  Admit: %.1f ns por frame (%llu de %llu pasaron)\n", ns, (unsigned long long)passed, (unsigned long long)n);
+        return 0;
+    }
+
+    int Run(const std::vector<std::string>& args) {
+        if (!args.empty() && args[0] == "--verify") return Verify();
+        if (!args.empty() && args[0] == "--bench") return Bench(args.size() >= 2 ? std::max(1.0, std::atof(args[1].c_str())) : 60.0);
+        std::fprintf(stderr, "uso: pacebench --verify | --bench [segundos]\n");
+        return 2;
+    }
+}
+
+#ifdef _WIN32
+int wmain(int argc, wchar_t** argv) {
+    std::vector<std::string> args;
+    for (int i = 1; i < argc; i++) args.push_back(Utf::ToUtf8(argv[i]));
+    return Run(args);
+}
+#else
+int main(int argc, char** argv) {
+    return Run(std::vector<std::string>(argv + 1, argv + argc));
+}
+#endif
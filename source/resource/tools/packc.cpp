@@ -0,0 +1,201 @@
+/**
+ * packc - Empaquetador de assets.
+ * Junta carpetas del juego en un único .gpak (ver core/AssetPack.h) que el host sirve desde
+ * memoria mapeada en lugar de abrir cada archivo suelto.
+ *
+ * Uso:
+ *   packc <carpetaJuego> <salida.gpak> [subcarpeta ...]   Por defecto empaqueta "public"
+ *   packc --list <paquete.gpak>
+ *   packc --verify <paquete.gpak> <carpetaJuego>          Cada entrada contra su archivo suelto
+ *   packc --bench <paquete.gpak> <carpetaJuego> [iteraciones]
+ *                                                         Latencia en frío/caliente paquete vs sueltos
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include "../core/AssetPack.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+    double MB(uint64_t bytes) { return bytes / 1048576.0; }
+
+    /**
+     * Saca un archivo de la caché de páginas para medir en frío.
+     * En Windows no hay equivalente sin privilegios: ahí "frío" es la primera lectura del proceso.
+     */
+    void Evict(const fs::path& path) {
+#ifndef _WIN32
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return;
+        ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        ::close(fd);
+#else
+        (void)path;
+#endif
+    }
+
+    int Pack(const fs::path& gameDir, const fs::path& out, std::vector<std::string> dirs) {
+        if (dirs.empty()) dirs.push_back("public");
+        AssetPack::Writer w;
+        std::string err;
+        if (!w.Open(out, &err)) { std::fprintf(stderr, "[ERROR] %s\n", err.c_str()); return 1; }
+        for (const auto& d : dirs) {
+            if (!w.AddDirectory(gameDir / fs::u8path(d), AssetPack::Normalize(d), &err)) {
+                std::fprintf(stderr, "[ERROR] %s: %s\n", d.c_str(), err.c_str());
+                return 1;
+            }
+        }
+        if (!w.Finish(&err)) { std::fprintf(stderr, "[ERROR] %s\n", err.c_str()); return 1; }
+        const auto& s = w.GetStats();
+        std::printf("packc: %llu archivos, %llu contenidos distintos\n", (unsigned long long)s.files, (unsigned long long)s.blobs);
+        std::printf("  sueltos      %9.2f MB\n", MB(s.rawBytes));
+        std::printf("  sin repetir  %9.2f MB  (-%.2f MB por duplicados)\n", MB(s.uniqueBytes), MB(s.rawBytes - s.uniqueBytes));
+        std::printf("  en paquete   %9.2f MB  (-%.2f MB por compresion)\n", MB(s.storedBytes), MB(s.uniqueBytes - s.storedBytes));
+        return 0;
+    }
+
+    int List(const fs::path& pack) {
+        AssetPack::Reader r;
+        std::string err;
+        if (!r.Open(pack, &err)) { std::fprintf(stderr, "[ERROR] %s\n", err.c_str()); return 1; }
+        for (uint32_t i = 0; i < r.EntryCount(); i++) {
+            AssetPack::Asset a = r.EntryAsset(i);
+            std::printf("%10llu %10llu %c %016llx %.*s\n", (unsigned long long)a.size, (unsigned long long)a.stored,
+                a.codec == AssetPack::Compressed ? 'z' : '-', (unsigned long long)a.hash, (int)r.Path(i).size(), r.Path(i).data());
+        }
+        return 0;
+    }
+
+    int Verify(const fs::path& pack, const fs::path& gameDir) {
+        AssetPack::Reader r;
+        std::string err, packed, loose;
+        if (!r.Open(pack, &err)) { std::fprintf(stderr, "[ERROR] %s\n", err.c_str()); return 1; }
+        size_t failed = 0;
+        for (uint32_t i = 0; i < r.EntryCount(); i++) {
+            std::string path(r.Path(i));
+            AssetPack::Asset a;
+            bool ok = r.Find(path, a) && AssetPack::Reader::Read(a, packed) && AtomicFile::ReadAll(gameDir / fs::u8path(path), loose) && packed == loose
+                && AssetPack::Hash64(packed.data(), packed.size()) == a.hash;
+            if (!ok) { std::fprintf(stderr, "[FAIL] %s\n", path.c_str()); failed++; }
+        }
+        AssetPack::Asset missing;
+        if (r.Find("public/\x01no-existe", missing)) { std::fprintf(stderr, "[FAIL] busqueda con falso positivo\n"); failed++; }
+        std::printf("packc: %u entradas verificadas, %zu fallos\n", r.EntryCount(), failed);
+        return failed ? 1 : 0;
+    }
+
+    struct Timing {
+        std::vector<double> us;
+        double total = 0;
+        void Add(double v) { us.push_back(v); total += v; }
+        double Pct(double p) {
+            if (us.empty()) return 0;
+            std::sort(us.begin(), us.end());
+            return us[std::min(us.size() - 1, (size_t)(p * us.size()))];
+        }
+    };
+
+    void Report(const char* label, Timing& t) {
+        double mean = t.us.empty() ? 0 : t.total / t.us.size();
+        std::printf("  %-16s total %9.2f ms  media %8.1f us  p50 %8.1f us  p99 %8.1f us\n", label, t.total / 1000.0, mean, t.Pct(0.5), t.Pct(0.99));
+    }
+
+    int Bench(const fs::path& pack, const fs::path& gameDir, int iterations) {
+        using Clock = std::chrono::steady_clock;
+        auto us = [](Clock::duration d) { return std::chrono::duration<double, std::micro>(d).count(); };
+        std::vector<std::string> paths;
+        uint64_t logical = 0, unique = 0;
+        {
+            AssetPack::Reader r;
+            std::string err;
+            if (!r.Open(pack, &err)) { std::fprintf(stderr, "[ERROR] %s\n", err.c_str()); return 1; }
+            std::unordered_set<const char*> seen;
+            for (uint32_t i = 0; i < r.EntryCount(); i++) {
+                paths.emplace_back(r.Path(i));
+                AssetPack::Asset a = r.EntryAsset(i);
+                logical += a.size;
+                if (seen.insert(a.data).second) unique += a.size;
+            }
+        }
+        std::string buf;
+        size_t sink = 0;
+
+        // Sueltos: abrir + leer cada archivo
+        Timing looseCold, looseWarm, packCold, packWarm;
+        for (const auto& p : paths) Evict(gameDir / fs::u8path(p));
+        for (const auto& p : paths) {
+            auto t0 = Clock::now();
+            AtomicFile::ReadAll(gameDir / fs::u8path(p), buf);
+            looseCold.Add(us(Clock::now() - t0)); sink += buf.size();
+        }
+        for (int n = 0; n < iterations; n++) {
+            for (const auto& p : paths) {
+                auto t0 = Clock::now();
+                AtomicFile::ReadAll(gameDir / fs::u8path(p), buf);
+                looseWarm.Add(us(Clock::now() - t0)); sink += buf.size();
+            }
+        }
+
+        // Paquete: búsqueda en el índice + copia (o descompresión) desde la memoria mapeada
+        Evict(pack);
+        auto open0 = Clock::now();
+        AssetPack::Reader r;
+        r.Open(pack);
+        double openUs = us(Clock::now() - open0);
+        for (const auto& p : paths) {
+            auto t0 = Clock::now();
+            r.Read(p, buf);
+            packCold.Add(us(Clock::now() - t0)); sink += buf.size();
+        }
+        for (int n = 0; n < iterations; n++) {
+            for (const auto& p : paths) {
+                auto t0 = Clock::now();
+                r.Read(p, buf);
+                packWarm.Add(us(Clock::now() - t0)); sink += buf.size();
+            }
+        }
+
+        std::printf("packc bench: %zu assets, %d iteraciones en caliente\n", paths.size(), iterations);
+        Report("sueltos frio", looseCold);
+        Report("paquete frio", packCold);
+        std::printf("  %-16s %9.2f ms\n", "abrir paquete", openUs / 1000.0);
+        Report("sueltos caliente", looseWarm);
+        Report("paquete caliente", packWarm);
+        std::printf("  disco: sueltos %.2f MB, paquete %.2f MB, ahorro por duplicados %.2f MB (%.1f%%)\n",
+            MB(logical), MB(r.FileSize()), MB(logical - unique), logical ? 100.0 * (logical - unique) / logical : 0.0);
+        return sink ? 0 : 1;
+    }
+
+    void Usage() {
+        std::fprintf(stderr,
+            "Uso:\n"
+            "  packc <carpetaJuego> <salida.gpak> [subcarpeta ...]\n"
+            "  packc --list <paquete.gpak>\n"
+            "  packc --verify <paquete.gpak> <carpetaJuego>\n"
+            "  packc --bench <paquete.gpak> <carpetaJuego> [iteraciones]\n");
+    }
+
+    int Run(const std::vector<fs::path>& args) {
+        if (args.empty()) { Usage(); return 1; }
+        std::string cmd = args[0].u8string();
+        if (cmd == "--list" && args.size() >= 2) return List(args[1]);
+        if (cmd == "--verify" && args.size() >= 3) return Verify(args[1], args[2]);
+        if (cmd == "--bench" && args.size() >= 3) return Bench(args[1], args[2], args.size() >= 4 ? std::max(1, std::atoi(args[3].u8string().c_str())) : 5);
+        if (cmd.rfind("--", 0) == 0 || args.size() < 2) { Usage(); return 1; }
+        std::vector<std::string> dirs;
+        for (size_t i = 2; i < args.size(); i++) dirs.push_back(args[i].u8string());
+        return Pack(args[0], args[1], dirs);
+    }
+}
+
+#ifdef _WIN32
+int wmain(int argc, wchar_t** argv) { return Run(std::vector<fs::path>(argv + 1, argv + argc)); }
+#else
+int main(int argc, char** argv) { return Run(std::vector<fs::path>(argv + 1, argv + argc)); }
+#endif
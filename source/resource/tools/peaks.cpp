@@ -0,0 +1,199 @@
+/**
+ * peaks - Pirámides de forma de onda (ver core/Peaks.h) para los .ogg de las canciones.
+ *
+ * Uso:
+ *   peaks <audio.ogg> [salida.gpks]             Decodifica y guarda la pirámide
+ *   peaks --verify <carpeta|archivo>            Comprueba niveles, serialización y SIMD vs escalar
+ *   peaks --bench <carpeta> [hilos]             Decodifica todos los .ogg y mide segundos de audio por segundo
+ */
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../core/Peaks.h"
+#include "Tool.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+    using namespace Tool;
+
+    std::vector<fs::path> Collect(const fs::path& root) {
+        std::vector<fs::path> out;
+        std::error_code ec;
+        if (fs::is_regular_file(root, ec)) { out.push_back(root); return out; }
+        for (auto it = fs::recursive_directory_iterator(root, ec); !ec && it != fs::recursive_directory_iterator(); it.increment(ec)) {
+            std::string ext = it->path().extension().u8string();
+            for (auto& c : ext) c = (char)std::tolower((unsigned char)c);
+            if (it->is_regular_file(ec) && ext == ".ogg") out.push_back(it->path());
+        }
+        std::sort(out.begin(), out.end());
+        return out;
+    }
+
+    int BuildOne(const fs::path& in, fs::path out) {
+        if (out.empty()) out = fs::path(in).replace_extension(".gpks");
+        MappedFile src;
+        if (!src.Open(in)) { std::fprintf(stderr, "[ERROR] no se pudo leer %s\n", in.u8string().c_str()); return 1; }
+        std::string bytes, err;
+        if (!Peaks::Build(src.Data(), src.Size(), AssetPack::Hash64(src.Data(), src.Size()), bytes, &err)
+            || !AtomicFile::Write(out, bytes, err)) {
+            std::fprintf(stderr, "[ERROR] %s: %s\n", in.u8string().c_str(), err.c_str());
+            return 1;
+        }
+        Peaks::Pyramid p;
+        p.Parse(bytes.data(), bytes.size());
+        std::printf("%s: %d canales, %u Hz, %.2f s, %zu niveles, %zu bytes\n", out.u8string().c_str(), p.Channels(), p.SampleRate(),
+            (double)p.Frames() / p.SampleRate(), p.Levels(), bytes.size());
+        return 0;
+    }
+
+    /**
+     * Cada cubeta de un nivel debe ser la unión de sus dos hijas (min/max exactos, RMS dentro del redondeo),
+     * y la reducción SIMD tiene que dar lo mismo que la escalar.
+     */
+    bool VerifyOne(const fs::path& in, std::string& why) {
+        MappedFile src;
+        if (!src.Open(in)) { why = "cannot read"; return false; }
+        Vorbis::Decoder dec;
+        if (!dec.Open(src.Data(), src.Size(), &why)) return false;
+        Peaks::Builder b(dec.Channels(), dec.SampleRate());
+        double simdError = 0;
+        bool minmaxOk = true;
+        dec.Decode([&](const float* const* pcm, size_t frames) {
+            b.Push(pcm, frames);
+            for (int c = 0; c < dec.Channels(); c++) {
+                Peaks::Bin fast = Peaks::Reduce(pcm[c], frames), slow;
+                slow.min = slow.max = pcm[c][0];
+                for (size_t i = 0; i < frames; i++) {
+                    slow.min = std::min(slow.min, pcm[c][i]); slow.max = std::max(slow.max, pcm[c][i]);
+                    slow.sumSq += (double)pcm[c][i] * pcm[c][i];
+                }
+                minmaxOk = minmaxOk && fast.min == slow.min && fast.max == slow.max;
+                simdError = std::max(simdError, std::fabs(fast.sumSq - slow.sumSq) / std::max(1e-9, slow.sumSq));
+            }
+        });
+        if (!minmaxOk || simdError > 1e-4) { why = "simd reduction mismatch"; return false; }
+        uint64_t hash = AssetPack::Hash64(src.Data(), src.Size());
+        std::string bytes = b.Finish(hash);
+        Peaks::Pyramid p;
+        if (!p.Parse(bytes.data(), bytes.size(), hash)) { why = "cannot parse"; return false; }
+        if (dec.Frames() >= 0 && p.Frames() > (uint64_t)dec.Frames()) { why = "more frames than granule"; return false; }
+        uint64_t expectBins = (p.Frames() + Peaks::kBaseBin - 1) / Peaks::kBaseBin;
+        if (p.Bins(0) != expectBins || p.Bins(p.Levels() - 1) != 1) { why = "bad level sizes"; return false; }
+        for (size_t l = 1; l < p.Levels(); l++) {
+            for (uint32_t i = 0; i < p.Bins(l); i++) {
+                for (int c = 0; c < p.Channels(); c++) {
+                    uint32_t a = 2 * i, z = std::min(2 * i + 1, p.Bins(l - 1) - 1);
+                    int16_t mn = std::min(p.Value(l - 1, a, c, 0), p.Value(l - 1, z, c, 0));
+                    int16_t mx = std::max(p.Value(l - 1, a, c, 1), p.Value(l - 1, z, c, 1));
+                    int16_t hiRms = std::max(p.Value(l - 1, a, c, 2), p.Value(l - 1, z, c, 2));
+                    if (p.Value(l, i, c, 0) != mn || p.Value(l, i, c, 1) != mx || p.Value(l, i, c, 2) > hiRms + 1) {
+                        why = "level " + std::to_string(l) + " bin " + std::to_string(i) + " is not the union of its children";
+                        return false;
+                    }
+                }
+            }
+        }
+        uint32_t count = 1u << 20;
+        if (!p.Tile(0, 0, count) || count != p.Bins(0) || p.Tile(0, p.Bins(0), count)) { why = "bad tile range"; return false; }
+        return true;
+    }
+
+    int Verify(const fs::path& root) {
+        auto files = Collect(root);
+        size_t failed = 0;
+        for (const auto& f : files) {
+            std::string why;
+            if (!VerifyOne(f, why)) { std::fprintf(stderr, "[FAIL] %s: %s\n", f.u8string().c_str(), why.c_str()); failed++; }
+        }
+        std::printf("peaks: %zu archivos verificados, %zu fallos\n", files.size(), failed);
+        return failed || files.empty() ? 1 : 0;
+    }
+
+    int Bench(const fs::path& root, unsigned threads) {
+        auto files = Collect(root);
+        if (files.empty()) { std::fprintf(stderr, "peaks: no hay .ogg en %s\n", root.u8string().c_str()); return 1; }
+        struct Job { MappedFile src; double audio = 0, decode = 0, reduce = 0; size_t bytes = 0; bool ok = false; };
+        std::vector<Job> jobs(files.size());
+        uint64_t inputBytes = 0;
+        for (size_t i = 0; i < files.size(); i++) { jobs[i].src.Open(files[i]); inputBytes += jobs[i].src.Size(); }
+
+        auto run = [&](Job& j) {
+            Vorbis::Decoder dec;
+            if (!dec.Open(j.src.Data(), j.src.Size())) return;
+            Peaks::Builder b(dec.Channels(), dec.SampleRate());
+            Clock::duration inReduce{};
+            auto t0 = Clock::now();
+            uint64_t frames = dec.Decode([&](const float* const* pcm, size_t n) {
+                auto r0 = Clock::now();
+                b.Push(pcm, n);
+                inReduce += Clock::now() - r0;
+            });
+            auto r0 = Clock::now();
+            j.bytes = b.Finish(0).size();
+            inReduce += Clock::now() - r0;
+            double total = Seconds(Clock::now() - t0);
+            j.reduce = Seconds(inReduce);
+            j.decode = total - j.reduce;
+            j.audio = (double)frames / dec.SampleRate();
+            j.ok = true;
+        };
+
+        // Un hilo: coste real por archivo
+        auto s0 = Clock::now();
+        for (auto& j : jobs) run(j);
+        double serial = Seconds(Clock::now() - s0);
+        double audio = 0, decode = 0, reduce = 0;
+        size_t out = 0, ok = 0;
+        for (auto& j : jobs) { if (!j.ok) continue; ok++; audio += j.audio; decode += j.decode; reduce += j.reduce; out += j.bytes; }
+
+        // Varios hilos: una canción por hilo, como al abrir el editor con varias pistas
+        std::atomic<size_t> next{0};
+        std::vector<std::thread> pool;
+        auto p0 = Clock::now();
+        for (unsigned t = 0; t < threads; t++) pool.emplace_back([&] { for (size_t i; (i = next++) < jobs.size(); ) run(jobs[i]); });
+        for (auto& t : pool) t.join();
+        double parallel = Seconds(Clock::now() - p0);
+
+        std::printf("peaks bench: %zu/%zu archivos, %.1f min de audio, %.2f MB de ogg\n", ok, files.size(), audio / 60.0, inputBytes / 1048576.0);
+        std::printf("  1 hilo      %8.2f s  -> %7.0f s de audio/s\n", serial, audio / serial);
+        std::printf("    decodificar %6.2f s  (%7.0f s/s)\n", decode, audio / decode);
+        std::printf("    piramide    %6.2f s  (%7.0f s/s)\n", reduce, audio / std::max(reduce, 1e-9));
+        std::printf("  %u hilos    %8.2f s  -> %7.0f s de audio/s\n", threads, parallel, audio / parallel);
+        std::printf("  cache en disco: %.2f MB (%.1f%% del ogg)\n", out / 1048576.0, 100.0 * out / std::max<uint64_t>(1, inputBytes));
+        return ok == files.size() ? 0 : 1;
+    }
+
+    void Usage() {
+        std::fprintf(stderr,
+            "Uso:\n"
+            "  peaks <audio.ogg> [salida.gpks]\n"
+            "  peaks --verify <carpeta|archivo>\n"
+            "  peaks --bench <carpeta> [hilos]\n");
+    }
+
+    int Run(const std::vector<fs::path>& args) {
+        if (args.empty()) { Usage(); return 1; }
+        std::string cmd = args[0].u8string();
+        if (cmd == "--verify" && args.size() >= 2) return Verify(args[1]);
+        if (cmd == "--bench" && args.size() >= 2) {
+            unsigned threads = args.size() >= 3 ? (unsigned)std::max(1, std::atoi(args[2].u8string().c_str())) : std::max(1u, std::thread::hardware_concurrency());
+            return Bench(args[1], threads);
+        }
+        if (cmd.rfind("--", 0) == 0) { Usage(); return 1; }
+        return BuildOne(args[0], args.size() >= 2 ? args[1] : fs::path());
+    }
+}
+
+#ifdef _WIN32
+int wmain(int argc, wchar_t** argv) { return Run(std::vector<fs::path>(argv + 1, argv + argc)); }
+#else
+int main(int argc, char** argv) { return Run(std::vector<fs::path>(argv + 1, argv + argc)); }
+#endif
@@ -0,0 +1,611 @@
+/**
+ * poolbench - Pruebas de estrés y latencias del ejecutor del puente (core/TaskPool.h,
+ * core/CompletionQueue.h, core/RpcExecutor.h).
+ *
+ * Uso:
+ *   poolbench --verify [rondas]       Submit desde varios hilos (anidado, robo, excepciones, ganchos),
+ *                                     SerialQueue en orden y sin solaparse, CompletionQueue sin
+ *                                     despertares perdidos, RpcExecutor con cancelaciones, "busy" y
+ *                                     CancelAll, y Shutdown mientras otros hilos siguen encolando
+ *   poolbench --bench [muestras]      Latencia p50 / p99 de Submit -> inicio, de la ida y vuelta de
+ *                                     una petición Pool / Serial y tiempo del hilo de UI por mensaje
+ *                                     (handler en el hilo frente a diferido)
+ *
+ * El hilo principal hace de hilo de UI: espera el aviso de la CompletionQueue y drena.
+ */
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <random>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../core/CompletionQueue.h"
+#include "../core/Rpc.h"
+#include "../core/RpcExecutor.h"
+#include "../core/TaskPool.h"
+#include "Tool.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+    using namespace Tool;
+
+    /** Hace de hilo de UI: el aviso de la cola (PostMessage en la app) despierta a quien espera. */
+    struct UiThread {
+        std::mutex mtx;
+        std::condition_variable cv;
+        bool woken = false;
+        std::atomic<uint64_t> wakes{ 0 };
+
+        void Wake() {
+            wakes.fetch_add(1, std::memory_order_relaxed);
+            { std::lock_guard<std::mutex> lock(mtx); woken = true; }
+            cv.notify_one();
+        }
+
+        /** @returns {bool} false si no hubo aviso en `timeout`. */
+        bool Wait(std::chrono::milliseconds timeout) {
+            std::unique_lock<std::mutex> lock(mtx);
+            bool ok = cv.wait_for(lock, timeout, [this] { return woken; });
+            woken = false;
+            return ok;
+        }
+    };
+
+    bool WaitFor(const std::function<bool()>& done, std::chrono::milliseconds timeout) {
+        auto end = Clock::now() + timeout;
+        while (!done()) {
+            if (Clock::now() > end) return false;
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+        return true;
+    }
+
+    // --- TaskPool ---
+
+    void VerifyPool() {
+        std::printf("TaskPool\n");
+        {
+            TaskPool pool(4);
+            const int producers = 4, perProducer = 50000;
+            std::atomic<int> ran{ 0 };
+            std::vector<std::thread> threads;
+            for (int p = 0; p < producers; p++) {
+                threads.emplace_back([&] {
+                    for (int i = 0; i < perProducer; i++) {
+                        if (i % 10 == 0) pool.Submit([&] { ran++; pool.Submit([&] { ran++; }); });
+                        else pool.Submit([&] { ran++; });
+                    }
+                });
+            }
+            for (auto& t : threads) t.join();
+            int expected = producers * perProducer + producers * perProducer / 10;
+            Check(WaitFor([&] { return ran.load() == expected; }, std::chrono::seconds(60)), "Submit desde 4 hilos y desde los workers: se ejecuta todo una vez");
+        }
+        {
+            TaskPool pool(4);
+            std::mutex m;
+            std::set<std::thread::id> who;
+            std::atomic<int> done{ 0 };
+            // Todo cae en la cola de un worker: los demás solo lo ejecutan si roban
+            pool.Submit([&] {
+                for (int i = 0; i < 64; i++) pool.Submit([&] {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+                    { std::lock_guard<std::mutex> lock(m); who.insert(std::this_thread::get_id()); }
+                    done++;
+                });
+            });
+            bool all = WaitFor([&] { return done.load() == 64; }, std::chrono::seconds(30));
+            Check(all && who.size() > 1, "el trabajo encolado en un worker lo roban los demás");
+        }
+        {
+            std::atomic<int> started{ 0 }, exited{ 0 }, ran{ 0 };
+            {
+                TaskPool pool(3, [&] { started++; }, [&] { exited++; });
+                for (int i = 0; i < 100; i++) pool.Submit([&, i] { if (i % 3 == 0) throw 1; ran++; });
+                WaitFor([&] { return ran.load() == 66; }, std::chrono::seconds(10));
+            }
+            Check(ran == 66, "una tarea que lanza no tumba al worker");
+            Check(started == 3 && exited == 3, "onStart / onExit una vez por hilo");
+        }
+        {
+            // WaitIdle cuenta también lo que encolan las propias tareas y las SerialQueue
+            TaskPool pool(4);
+            SerialQueue serial(pool);
+            std::atomic<int> ran{ 0 };
+            for (int i = 0; i < 200; i++) {
+                pool.Submit([&] {
+                    std::this_thread::sleep_for(std::chrono::microseconds(50));
+                    pool.Submit([&] { serial.Submit([&] { std::this_thread::sleep_for(std::chrono::microseconds(20)); ran++; }); ran++; });
+                    ran++;
+                });
+            }
+            pool.WaitIdle();
+            int atIdle = ran.load();
+            pool.WaitIdle(); // Sin nada pendiente vuelve enseguida
+            pool.Shutdown();
+            pool.WaitIdle(); // Ni después de Shutdown se queda esperando
+            Check(atIdle == 600, "WaitIdle espera a las tareas anidadas y a las de SerialQueue");
+        }
+        {
+            // Shutdown mientras otros hilos siguen encolando (también desde dentro del pool)
+            bool ok = true;
+            for (int round = 0; round < 40 && ok; round++) {
+                std::atomic<bool> stop{ false };
+                std::atomic<uint64_t> submitted{ 0 }, ran{ 0 };
+                auto pool = std::make_unique<TaskPool>(4);
+                std::vector<std::thread> producers;
+                for (int p = 0; p < 3; p++) {
+                    producers.emplace_back([&] {
+                        while (!stop.load()) {
+                            submitted++;
+                            pool->Submit([&] { ran++; if (ran % 7 == 0) { submitted++; pool->Submit([&] { ran++; }); } });
+                        }
+                    });
+                }
+                std::this_thread::sleep_for(std::chrono::microseconds(500 + round * 50));
+                auto t0 = Clock::now();
+                pool->Shutdown();
+                double ms = Ms(Clock::now() - t0);
+                stop = true;
+                for (auto& t : producers) t.join();
+                pool->Shutdown(); // Idempotente
+                ok = ran.load() <= submitted.load() && ms < 5000;
+                pool.reset(); // Lo que quedó en cola se descarta sin ejecutarse
+            }
+            Check(ok, "Shutdown con Submit concurrente: termina, no ejecuta de más (40 rondas)");
+        }
+    }
+
+    // --- SerialQueue ---
+
+    void VerifySerial() {
+        std::printf("SerialQueue\n");
+        TaskPool pool(4);
+        SerialQueue serial(pool);
+        const int producers = 4, perProducer = 5000;
+        std::atomic<int> active{ 0 }, done{ 0 };
+        std::atomic<bool> overlap{ false };
+        std::vector<std::vector<int>> seen(producers);
+        std::vector<std::thread> threads;
+        for (int p = 0; p < producers; p++) {
+            threads.emplace_back([&, p] {
+                for (int i = 0; i < perProducer; i++) {
+                    serial.Submit([&, p, i] {
+                        if (active.fetch_add(1) != 0) overlap = true;
+                        seen[p].push_back(i); // Sin cerrojo: solo es seguro si de verdad va de una en una
+                        if (i % 1000 == 0) std::this_thread::yield();
+                        active.fetch_sub(1);
+                        done++;
+                    });
+                }
+            });
+        }
+        for (auto& t : threads) t.join();
+        bool all = WaitFor([&] { return done.load() == producers * perProducer; }, std::chrono::seconds(60));
+        bool ordered = true;
+        for (const auto& v : seen) {
+            ordered = ordered && (int)v.size() == perProducer;
+            for (size_t i = 1; ordered && i < v.size(); i++) ordered = v[i] == v[i - 1] + 1;
+        }
+        Check(all && !overlap, "nunca dos tareas a la vez");
+        Check(ordered, "FIFO por productor");
+        pool.Shutdown();
+    }
+
+    // --- CompletionQueue ---
+
+    void VerifyCompletions() {
+        std::printf("CompletionQueue\n");
+        UiThread ui;
+        CompletionQueue<uint64_t> queue([&ui] { ui.Wake(); });
+        const uint64_t producers = 4, perProducer = 100000, total = producers * perProducer;
+        std::vector<std::thread> threads;
+        for (uint64_t p = 0; p < producers; p++) {
+            threads.emplace_back([&, p] {
+                for (uint64_t i = 0; i < perProducer; i++) {
+                    queue.Push((p << 32) | i);
+                    if (i % 5000 == 0) std::this_thread::sleep_for(std::chrono::microseconds(100));
+                }
+            });
+        }
+        std::vector<uint64_t> next(producers, 0);
+        uint64_t received = 0, drains = 0;
+        bool ordered = true, lost = false;
+        while (received < total) {
+            // Solo se drena con aviso: si uno se pierde, esto se queda esperando
+            if (!ui.Wait(std::chrono::seconds(5))) { lost = true; break; }
+            drains++;
+            received += queue.Drain([&](uint64_t& v) {
+                uint64_t p = v >> 32;
+                ordered = ordered && (v & 0xFFFFFFFF) == next[p];
+                next[p] = (v & 0xFFFFFFFF) + 1;
+            });
+        }
+        for (auto& t : threads) t.join();
+        std::printf("  %llu elementos, %llu avisos, %llu drenados\n", (unsigned long long)received, (unsigned long long)ui.wakes.load(), (unsigned long long)drains);
+        Check(!lost && received == total, "4 productores, un consumidor: todo llega sin despertares perdidos");
+        Check(ordered, "orden FIFO por productor");
+        Check(ui.wakes.load() <= drains + 1 && ui.wakes.load() < total / 10, "un aviso por paso de vacía a no vacía, no uno por elemento");
+        Check(queue.Drain([](uint64_t&) {}) == 0, "vacía al terminar");
+    }
+
+    // --- RpcExecutor ---
+
+    struct ExecCtx {
+        std::atomic<int> serialActive{ 0 };
+        std::atomic<bool> serialOverlap{ false };
+        std::mutex orderMutex;
+        std::vector<uint32_t> serialOrder;
+        std::atomic<int> abandoned{ 0 };
+    };
+
+    using ExecDispatcher = RpcDispatcher<ExecCtx>;
+
+    /** Trabaja entre 0 y 300 µs según el id; si la cancelan, lo deja. */
+    bool OnWork(ExecCtx& ctx, const RpcRequest& req, std::wstring& out) {
+        auto end = Clock::now() + std::chrono::microseconds((req.id * 2654435761u) % 300);
+        while (Clock::now() < end) {
+            if (req.Cancelled()) { ctx.abandoned++; return false; }
+            std::this_thread::yield();
+        }
+        out.assign(req.payload.data(), req.payload.size());
+        return true;
+    }
+
+    bool OnWrite(ExecCtx& ctx, const RpcRequest& req, std::wstring& out) {
+        if (ctx.serialActive.fetch_add(1) != 0) ctx.serialOverlap = true;
+        { std::lock_guard<std::mutex> lock(ctx.orderMutex); ctx.serialOrder.push_back(req.id); }
+        std::this_thread::sleep_for(std::chrono::microseconds(req.id % 50));
+        ctx.serialActive.fetch_sub(1);
+        out.assign(req.payload.data(), req.payload.size());
+        return true;
+    }
+
+    bool OnSlow(ExecCtx& ctx, const RpcRequest& req, std::wstring&) {
+        for (int i = 0; i < 200; i++) {
+            if (req.Cancelled()) { ctx.abandoned++; return false; }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return true;
+    }
+
+    struct Replies {
+        std::map<uint32_t, int> count;
+        std::map<uint32_t, std::wstring> payload;
+        std::set<uint32_t> busy;
+
+        void Parse(const std::wstring& msg) {
+            std::wstring_view rest = std::wstring_view(msg).substr(RpcCodec::kMagic.size());
+            RpcRequest r;
+            while (RpcCodec::NextFrame(rest, r)) {
+                if (r.id == 0) continue;
+                if (r.verb == RpcCodec::kErr && r.payload == L"busy") { busy.insert(r.id); continue; }
+                count[r.id]++;
+                payload[r.id] = std::wstring(r.payload);
+            }
+        }
+    };
+
+    void VerifyExecutor(int rounds) {
+        std::printf("RpcExecutor\n");
+        {
+            TaskPool pool(4);
+            UiThread ui;
+            ExecCtx ctx;
+            ExecDispatcher d;
+            d.Register(L"work", OnWork, {}, false, RpcMode::Pool);
+            d.Register(L"write", OnWrite, {}, false, RpcMode::Serial);
+            RpcExecutor<ExecCtx> exec(pool, 48, [&ui] { ui.Wake(); });
+            exec.Attach(d);
+
+            Replies replies;
+            auto post = [&replies](const std::wstring& r) { replies.Parse(r); };
+            std::mt19937 rng(12345);
+            std::set<uint32_t> sent, cancelled;
+            std::vector<uint32_t> serialSent;
+            uint32_t id = 1;
+            for (int round = 0; round < rounds; round++) {
+                std::wstring msg(RpcCodec::kMagic);
+                int frames = 1 + (int)(rng() % 24);
+                for (int f = 0; f < frames; f++, id++) {
+                    bool serial = rng() % 4 == 0;
+                    RpcCodec::AppendFrame(msg, id, serial ? L"write" : L"work", std::to_wstring(id));
+                    sent.insert(id);
+                    if (serial) serialSent.push_back(id);
+                }
+                d.Dispatch(ctx, msg, post);
+                // La página aborta algunas llamadas: unas aún en cola, otras ya corriendo o ya terminadas
+                for (int c = 0; c < 3 && id > 1; c++) {
+                    uint32_t victim = 1 + rng() % (id - 1);
+                    if (replies.count.count(victim) || replies.busy.count(victim)) continue;
+                    exec.Cancel(victim);
+                    cancelled.insert(victim);
+                }
+                if (ui.Wait(std::chrono::milliseconds(rng() % 3))) exec.Drain(post);
+                // Casi siempre se drena antes de llenarse; a veces no, y la siguiente ráfaga recibe "busy"
+                if (rng() % 8) while (exec.InFlight() > 24 && ui.Wait(std::chrono::milliseconds(50))) exec.Drain(post);
+            }
+            bool settled = WaitFor([&] { exec.Drain(post); return exec.InFlight() == 0; }, std::chrono::seconds(60));
+            pool.Shutdown();
+
+            bool once = true, payloads = true, noCancelled = true, complete = true;
+            for (uint32_t i : sent) {
+                auto it = replies.count.find(i);
+                bool answered = it != replies.count.end();
+                if (answered && it->second != 1) once = false;
+                if (answered && replies.payload[i] != std::to_wstring(i)) payloads = false;
+                if (cancelled.count(i) && answered) noCancelled = false;
+                if (!cancelled.count(i) && !replies.busy.count(i) && !answered) complete = false;
+            }
+            std::vector<uint32_t> ran;
+            { std::lock_guard<std::mutex> lock(ctx.orderMutex); ran = ctx.serialOrder; }
+            bool serialOrdered = std::is_sorted(ran.begin(), ran.end()) && std::includes(serialSent.begin(), serialSent.end(), ran.begin(), ran.end());
+            std::printf("  %zu peticiones, %zu canceladas, %zu \"busy\", %d abandonadas a medias, %llu avisos\n", sent.size(), cancelled.size(),
+                        replies.busy.size(), ctx.abandoned.load(), (unsigned long long)ui.wakes.load());
+            Check(settled, "sin peticiones colgadas: InFlight vuelve a 0");
+            Check(once && payloads, "cada petición responde una sola vez y con su payload");
+            Check(complete && noCancelled, "las no canceladas responden; las canceladas nunca");
+            Check(!replies.busy.empty(), "por encima de maxInFlight se responde \"busy\"");
+            Check(serialOrdered && !ctx.serialOverlap, "las rutas Serial corren de una en una y en orden de llegada");
+        }
+        {
+            TaskPool pool(2);
+            UiThread ui;
+            ExecCtx ctx;
+            ExecDispatcher d;
+            d.Register(L"slow", OnSlow, {}, false, RpcMode::Pool);
+            RpcExecutor<ExecCtx> exec(pool, 16, [&ui] { ui.Wake(); });
+            exec.Attach(d);
+            Replies replies;
+            auto post = [&replies](const std::wstring& r) { replies.Parse(r); };
+            std::wstring msg(RpcCodec::kMagic);
+            for (uint32_t i = 1; i <= 16; i++) RpcCodec::AppendFrame(msg, i, L"slow", L"");
+            d.Dispatch(ctx, msg, post);
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            exec.Emit(L"evento", L"a");
+            auto t0 = Clock::now();
+            exec.CancelAll();
+            bool settled = WaitFor([&] { exec.Drain(post); return exec.InFlight() == 0; }, std::chrono::seconds(10));
+            double ms = Ms(Clock::now() - t0);
+            pool.Shutdown();
+            std::printf("  CancelAll con 16 peticiones de 200 ms en 2 hilos: %.1f ms\n", ms);
+            Check(settled && replies.count.empty() && ctx.abandoned.load() >= 1 && ms < 1000,
+                  "CancelAll: las que corren lo dejan, las encoladas no arrancan, nadie responde");
+        }
+        {
+            // Orden de cierre del puente: se abandonan las lecturas, terminan las escrituras en
+            // serie y solo después se cierra lo que escriben (los diarios)
+            bool ok = true;
+            int abandoned = 0;
+            for (int round = 0; round < 20 && ok; round++) {
+                TaskPool pool(3);
+                UiThread ui;
+                ExecCtx ctx;
+                ExecDispatcher d;
+                d.Register(L"work", OnWork, {}, false, RpcMode::Pool);
+                d.Register(L"write", OnWrite, {}, false, RpcMode::Serial);
+                RpcExecutor<ExecCtx> exec(pool, 1000, [&ui] { ui.Wake(); });
+                exec.Attach(d);
+                Replies replies;
+                auto post = [&replies](const std::wstring& r) { replies.Parse(r); };
+                std::wstring msg(RpcCodec::kMagic);
+                uint32_t writes = 0;
+                for (uint32_t i = 1; i <= 200; i++) {
+                    RpcCodec::AppendFrame(msg, i, i % 3 ? L"work" : L"write", L"x");
+                    if (i % 3 == 0) writes++;
+                }
+                d.Dispatch(ctx, msg, post);
+                std::this_thread::sleep_for(std::chrono::microseconds(100 * round));
+                exec.CancelAll(RpcMode::Pool);
+                pool.WaitIdle();
+                size_t written;
+                { std::lock_guard<std::mutex> lock(ctx.orderMutex); written = ctx.serialOrder.size(); }
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                { std::lock_guard<std::mutex> lock(ctx.orderMutex); ok = written == writes && ctx.serialOrder.size() == written; }
+                pool.Shutdown();
+                abandoned += ctx.abandoned.load();
+            }
+            char what[160];
+            std::snprintf(what, sizeof(what), "CancelAll(Pool) + WaitIdle: todas las escrituras Serial terminan antes de cerrar y ninguna después (%d lecturas abandonadas)", abandoned);
+            Check(ok, what);
+        }
+        {
+            // Shutdown del pool con el ejecutor ocupado y la UI aún encolando
+            bool ok = true;
+            for (int round = 0; round < 20 && ok; round++) {
+                TaskPool pool(3);
+                UiThread ui;
+                ExecCtx ctx;
+                ExecDispatcher d;
+                d.Register(L"work", OnWork, {}, false, RpcMode::Pool);
+                d.Register(L"write", OnWrite, {}, false, RpcMode::Serial);
+                RpcExecutor<ExecCtx> exec(pool, 1000, [&ui] { ui.Wake(); });
+                exec.Attach(d);
+                Replies replies;
+                auto post = [&replies](const std::wstring& r) { replies.Parse(r); };
+                std::wstring msg(RpcCodec::kMagic);
+                for (uint32_t i = 1; i <= 200; i++) RpcCodec::AppendFrame(msg, i, i % 3 ? L"work" : L"write", L"x");
+                d.Dispatch(ctx, msg, post);
+                std::this_thread::sleep_for(std::chrono::microseconds(200 * round));
+                exec.CancelAll();
+                auto t0 = Clock::now();
+                pool.Shutdown();
+                ok = Ms(Clock::now() - t0) < 5000;
+                exec.Drain(post);
+                d.Dispatch(ctx, msg, post); // Tras Shutdown se acepta, pero ya no corre nada
+                for (const auto& kv : replies.count) ok = ok && kv.second == 1 && kv.first >= 1 && kv.first <= 200;
+            }
+            Check(ok, "Shutdown con peticiones en vuelo: termina y no responde nada dos veces (20 rondas)");
+        }
+    }
+
+    int Verify(int rounds) {
+        std::printf("poolbench --verify (%u núcleos)\n", std::thread::hardware_concurrency());
+        VerifyPool();
+        VerifySerial();
+        VerifyCompletions();
+        VerifyExecutor(rounds);
+        std::printf(failures ? "\n%d fallos\n" : "\ntodo bien\n", failures);
+        return failures ? 1 : 0;
+    }
+
+    // --- Benchmarks ---
+
+    struct Percentiles { double p50 = 0, p99 = 0, max = 0; };
+
+    Percentiles Summarize(std::vector<double>& us) {
+        Percentiles p;
+        if (us.empty()) return p;
+        std::sort(us.begin(), us.end());
+        p.p50 = us[us.size() / 2];
+        p.p99 = us[std::min(us.size() - 1, us.size() * 99 / 100)];
+        p.max = us.back();
+        return p;
+    }
+
+    void Print(const char* what, std::vector<double>& us) {
+        Percentiles p = Summarize(us);
+        std::printf("  %-44s %9.1f %9.1f %9.1f\n", what, p.p50, p.p99, p.max);
+    }
+
+    double Us(Clock::duration d) { return std::chrono::duration<double, std::micro>(d).count(); }
+
+    struct BenchCtx { fs::path dir; };
+
+    bool OnNoop(BenchCtx&, const RpcRequest&, std::wstring&) { return true; }
+
+    /** Lo que hacía listDir en el hilo de UI: recorrer la carpeta y juntar nombres. */
+    bool OnList(BenchCtx& ctx, const RpcRequest&, std::wstring& out) {
+        std::error_code ec;
+        for (const auto& e : fs::directory_iterator(ctx.dir, ec)) {
+            if (!out.empty()) out += L'|';
+            out += e.path().filename().wstring();
+        }
+        return true;
+    }
+
+    int Bench(int samples) {
+        std::printf("poolbench --bench (%d muestras, %u núcleos)\n\n", samples, std::thread::hardware_concurrency());
+        std::printf("  %-44s %9s %9s %9s\n", "µs", "p50", "p99", "máx");
+
+        {
+            TaskPool pool(4);
+            std::vector<double> us;
+            for (int i = 0; i < samples; i++) {
+                std::atomic<bool> done{ false };
+                Clock::time_point started;
+                auto t0 = Clock::now();
+                pool.Submit([&] { started = Clock::now(); done = true; });
+                while (!done.load()) std::this_thread::yield();
+                us.push_back(Us(started - t0));
+            }
+            Print("TaskPool: Submit -> inicio (pool en reposo)", us);
+        }
+
+        fs::path dir = MakeTempDir("poolbench");
+        for (int i = 0; i < 2000; i++) WriteFile(dir / ("chart-" + std::to_string(i) + ".json"), "{}");
+        BenchCtx ctx{ dir };
+
+        for (RpcMode mode : { RpcMode::Pool, RpcMode::Serial }) {
+            TaskPool pool(4);
+            UiThread ui;
+            RpcDispatcher<BenchCtx> d;
+            d.Register(L"noop", OnNoop, {}, false, mode);
+            RpcExecutor<BenchCtx> exec(pool, 64, [&ui] { ui.Wake(); });
+            exec.Attach(d);
+            std::vector<double> single, burst;
+            size_t got = 0;
+            auto post = [&got](const std::wstring& r) {
+                std::wstring_view rest = std::wstring_view(r).substr(RpcCodec::kMagic.size());
+                RpcRequest q;
+                while (RpcCodec::NextFrame(rest, q)) got++;
+            };
+            for (int i = 0; i < samples; i++) {
+                got = 0;
+                auto t0 = Clock::now();
+                d.Dispatch(ctx, L"#1|1|noop|0|", post);
+                while (got < 1) if (ui.Wait(std::chrono::seconds(5))) exec.Drain(post); else break;
+                single.push_back(Us(Clock::now() - t0));
+            }
+            std::wstring msg(RpcCodec::kMagic);
+            for (uint32_t i = 1; i <= 32; i++) RpcCodec::AppendFrame(msg, i, L"noop", L"");
+            for (int i = 0; i < samples / 32 + 1; i++) {
+                got = 0;
+                auto t0 = Clock::now();
+                d.Dispatch(ctx, msg, post);
+                while (got < 32) if (ui.Wait(std::chrono::seconds(5))) exec.Drain(post); else break;
+                burst.push_back(Us(Clock::now() - t0));
+            }
+            pool.Shutdown();
+            bool serial = mode == RpcMode::Serial;
+            Print(serial ? "ida y vuelta Serial, 1 petición" : "ida y vuelta Pool, 1 petición", single);
+            Print(serial ? "ida y vuelta Serial, ráfaga de 32 (la última)" : "ida y vuelta Pool, ráfaga de 32 (la última)", burst);
+        }
+
+        {
+            std::vector<double> inlineUs, deferredUs;
+            RpcDispatcher<BenchCtx> inl;
+            inl.Register(L"listDir", OnList);
+            auto ignore = [](const std::wstring&) {};
+            int n = std::max(50, samples / 20);
+            for (int i = 0; i < n; i++) {
+                auto t0 = Clock::now();
+                inl.Dispatch(ctx, L"#1|1|listDir|0|", ignore);
+                inlineUs.push_back(Us(Clock::now() - t0));
+            }
+
+            TaskPool pool(4);
+            UiThread ui;
+            RpcDispatcher<BenchCtx> d;
+            d.Register(L"listDir", OnList, {}, false, RpcMode::Pool);
+            RpcExecutor<BenchCtx> exec(pool, 64, [&ui] { ui.Wake(); });
+            exec.Attach(d);
+            size_t got = 0;
+            auto post = [&got](const std::wstring&) { got++; };
+            for (int i = 0; i < n; i++) {
+                auto t0 = Clock::now();
+                d.Dispatch(ctx, L"#1|1|listDir|0|", post);
+                deferredUs.push_back(Us(Clock::now() - t0));
+                got = 0;
+                while (!got) if (ui.Wait(std::chrono::seconds(5))) exec.Drain(post); else break;
+            }
+            pool.Shutdown();
+            std::printf("\n  hilo de UI por mensaje (listDir de 2000 archivos)\n");
+            Print("handler en el hilo de UI (antes)", inlineUs);
+            Print("diferido al pool (solo copiar y encolar)", deferredUs);
+        }
+
+        std::error_code ec;
+        fs::remove_all(dir, ec);
+        return 0;
+    }
+
+    int Run(const std::vector<std::string>& args) {
+        if (!args.empty() && args[0] == "--verify") return Verify(args.size() >= 2 ? std::max(1, std::atoi(args[1].c_str())) : 400);
+        if (!args.empty() && args[0] == "--bench") return Bench(args.size() >= 2 ? std::max(100, std::atoi(args[1].c_str())) : 20000);
+        std::fprintf(stderr, "uso: poolbench --verify [rondas] | --bench [muestras]\n");
+        return 2;
+    }
+}
+
+#ifdef _WIN32
+int wmain(int argc, wchar_t** argv) {
+    std::vector<std::string> args;
+    for (int i = 1; i < argc; i++) args.push_back(fs::path(argv[i]).u8string());
+    return Run(args);
+}
+#else
+int main(int argc, char** argv) {
+    return Run(std::vector<std::string>(argv + 1, argv + argc));
+}
+#endif
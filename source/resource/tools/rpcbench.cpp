@@ -0,0 +1,455 @@
+/**
+ * rpcbench - Comprueba y mide el protocolo del puente JS <-> nativo (core/Rpc.h).
+ *
+ * Uso:
+ *   rpcbench --verify                        Códec (números, frames, frames rotos, legado, base64),
+ *                                            números JSON, tabla de rutas y despacho sin reservas
+ *   rpcbench --bench [traza] [rondas]        Reproduce una traza (ver RpcTrace; la app la graba con
+ *                                            GENESIS_RPC_TRACE=<archivo>) con el despacho por tabla y
+ *                                            con la cadena de prefijos de antes. Sin traza, una sesión
+ *                                            sintética del editor (ráfagas de saveFile/listDir/getMemory)
+ *   rpcbench --record <salida> [ráfagas]     Escribe esa sesión sintética como traza
+ */
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <limits>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "../core/AtomicFile.h"
+#include "../core/Json.h"
+#include "../core/Rpc.h"
+#include "../core/Utils.h"
+#include "Tool.h"
+
+namespace fs = std::filesystem;
+
+// Cuenta las reservas del proceso para comprobar que el despacho no reserva por mensaje.
+// new y delete van a malloc/free por pares; GCC no lo ve al inlinear el delete con tamaño.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+static std::atomic<uint64_t> allocations{ 0 };
+
+void* operator new(size_t n) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+namespace {
+
+    using namespace Tool;
+
+    /** Evita que el optimizador descarte el trabajo medido. */
+    volatile size_t sink = 0;
+
+    // --- Rutas de prueba: mismos verbos que WebViewManager, handlers sin efectos ---
+
+    struct Ctx {
+        std::wstring file, list;
+        uint64_t calls = 0;
+    };
+
+    using Dispatcher = RpcDispatcher<Ctx>;
+
+    bool OnEcho(Ctx& ctx, const RpcRequest& req, std::wstring& out) { ctx.calls++; out.assign(req.payload.data(), req.payload.size()); return true; }
+    bool OnStub(Ctx& ctx, const RpcRequest&, std::wstring&) { ctx.calls++; return true; }
+    bool OnThrow(Ctx&, const RpcRequest&, std::wstring&) { throw std::runtime_error("x"); }
+    bool OnLoadFile(Ctx& ctx, const RpcRequest&, std::wstring& out) { ctx.calls++; out += ctx.file; return true; }
+    bool OnListDir(Ctx& ctx, const RpcRequest&, std::wstring& out) { ctx.calls++; out += ctx.list; return true; }
+    bool OnGetMemory(Ctx& ctx, const RpcRequest&, std::wstring& out) { ctx.calls++; RpcCodec::AppendNumber(out, 734003200); return true; }
+
+    bool OnSaveFile(Ctx& ctx, const RpcRequest& req, std::wstring& out) {
+        ctx.calls++;
+        if (req.payload.find(L'|') == std::wstring_view::npos) { out = L"missing key"; return false; }
+        return true;
+    }
+
+    const wchar_t* kStubVerbs[] = {
+        L"resize", L"maximize", L"minimize", L"close", L"setTitle", L"storageFlush", L"storageStats", L"journalOpen",
+        L"journalEdit", L"journalUndo", L"journalRedo", L"loadStream", L"streamRead", L"streamClose", L"listTree",
+        L"fsWatch", L"openExternal", L"chartOpen", L"chartNotes", L"chartDensity", L"chartClose", L"libraryScan",
+        L"songAssets", L"search", L"peaksOpen", L"peaksTile", L"peaksClose", L"playerCtl", L"msgBox", L"openFile",
+        L"perfFrames", L"perfStats", L"pacerStart", L"frameAck", L"discord", L"cancel",
+    };
+
+    void RegisterRoutes(Dispatcher& d) {
+        d.Register(L"saveFile", OnSaveFile);
+        d.Register(L"loadFile", OnLoadFile, L"fileLoaded:", true);
+        d.Register(L"listDir", OnListDir, L"dirListed:", true);
+        d.Register(L"getMemory", OnGetMemory, L"memInfo:");
+        for (const wchar_t* verb : kStubVerbs) d.Register(verb, OnStub);
+    }
+
+    std::wstring Envelope(const std::vector<std::pair<std::wstring, std::wstring>>& frames, uint32_t firstId = 1) {
+        std::wstring msg(RpcCodec::kMagic);
+        uint32_t id = firstId;
+        for (const auto& f : frames) RpcCodec::AppendFrame(msg, id++, f.first, f.second);
+        return msg;
+    }
+
+    std::wstring Reply(Dispatcher& d, Ctx& ctx, std::wstring_view msg, size_t* processed = nullptr) {
+        std::wstring last;
+        size_t n = d.Dispatch(ctx, msg, [&last](const std::wstring& r) { last = r; });
+        if (processed) *processed = n;
+        return last;
+    }
+
+    std::wstring Number(uint64_t v) { std::wstring s; RpcCodec::AppendNumber(s, v); return s; }
+    std::wstring Double(double v) { std::wstring s; RpcCodec::AppendDouble(s, v); return s; }
+    std::string JsonNumber(double v) { std::string s; Json::AppendNumber(s, v); return s; }
+
+    std::wstring Base64(const char* s) {
+        std::wstring out;
+        RpcCodec::AppendBase64(out, s, std::char_traits<char>::length(s));
+        return out;
+    }
+
+    bool Read(std::wstring_view s, uint64_t expect, std::wstring_view restAfter, uint64_t max = UINT64_MAX) {
+        uint64_t v = 0;
+        return RpcCodec::ReadNumber(s, v, L'|', max) && v == expect && s == restAfter;
+    }
+
+    bool Rejects(std::wstring_view s, uint64_t max = UINT64_MAX) {
+        uint64_t v = 0;
+        std::wstring_view before = s;
+        return !RpcCodec::ReadNumber(s, v, L'|', max) && s == before;
+    }
+
+    // --- Verificación ---
+
+    int Verify() {
+        std::printf("rpcbench --verify\n");
+
+        std::printf("números\n");
+        {
+            Check(Read(L"123|x", 123, L"x") && Read(L"0|", 0, L""), "decimal hasta el separador");
+            Check(Rejects(L"|x") && Rejects(L"12") && Rejects(L"12,3|") && Rejects(L""), "sin dígitos, sin separador u otro carácter");
+            Check(Read(L"4294967295|", 4294967295u, L"", UINT32_MAX) && Rejects(L"4294967296|", UINT32_MAX), "tope de 32 bits (ids)");
+            Check(Read(L"18446744073709551615|", UINT64_MAX, L"") && Rejects(L"18446744073709551616|"), "tope de 64 bits");
+            Check(Rejects(L"99999999999999999999999|") && Rejects(L"99999999999999999999999|", UINT32_MAX), "un id enorme se rechaza en vez de dar la vuelta");
+            Check(Number(0) == L"0" && Number(UINT64_MAX) == L"18446744073709551615", "AppendNumber");
+            Check(RpcCodec::ParseInt(L" -12") == -12 && RpcCodec::ParseInt(L"+7") == 7 && RpcCodec::ParseInt(L"abc", 5) == 5, "ParseInt");
+            Check(RpcCodec::ParseDouble(L"10378.3779") == 10378.3779 && RpcCodec::ParseDouble(L"x", 1.5) == 1.5, "ParseDouble");
+            Check(Double(42) == L"42" && Double(-3) == L"-3" && Double(0.5) == L"0.5" && Double(-0.0) == L"0", "AppendDouble enteros y fracciones");
+            Check(Double(1e300) == L"1e+300" && Double(-9.5e18) == L"-9.5e+18" && Double(9e15) == L"9e+15", "AppendDouble fuera de rango de int64 (sin cast)");
+            Check(Double(std::numeric_limits<double>::quiet_NaN()) == L"nan" && Double(std::numeric_limits<double>::infinity()) == L"inf", "AppendDouble NaN e infinito");
+            Check(JsonNumber(3) == "3" && JsonNumber(-2.5) == "-2.5" && JsonNumber(1e300) == "1e+300" && JsonNumber(-1e19) == "-1e+19",
+                  "Json::AppendNumber comprueba el rango antes del cast");
+            Check(JsonNumber(std::nan("")) == "null" && JsonNumber(-std::numeric_limits<double>::infinity()) == "null", "Json::AppendNumber NaN / inf -> null");
+            Check(Base64("").empty() && Base64("f") == L"Zg==" && Base64("fo") == L"Zm8=" && Base64("foo") == L"Zm9v" && Base64("foobar") == L"Zm9vYmFy",
+                  "base64 (RFC 4648)");
+        }
+
+        std::printf("frames\n");
+        {
+            std::wstring msg;
+            RpcCodec::AppendEnvelope(msg, 7, L"loadFile", L"a|b#1|c");
+            RpcCodec::AppendFrame(msg, 0, L"frameAck", L"");
+            std::wstring_view rest = std::wstring_view(msg).substr(RpcCodec::kMagic.size());
+            RpcRequest a, b, c;
+            bool ok = RpcCodec::NextFrame(rest, a) && RpcCodec::NextFrame(rest, b);
+            bool malformed = true;
+            Check(ok && !RpcCodec::NextFrame(rest, c, &malformed) && !malformed, "dos frames y fin limpio");
+            Check(a.id == 7 && a.verb == L"loadFile" && a.payload == L"a|b#1|c" && b.id == 0 && b.verb == L"frameAck" && b.payload.empty(),
+                  "el payload con '|' y '#1|' se respeta por longitud");
+
+            std::wstring repeated = L"#1|1|x|1|a#1|#1|2|y|0|";
+            rest = std::wstring_view(repeated).substr(3);
+            ok = RpcCodec::NextFrame(rest, a) && RpcCodec::NextFrame(rest, b) && !RpcCodec::NextFrame(rest, c, &malformed) && !malformed;
+            Check(ok && a.id == 1 && b.id == 2 && b.verb == L"y", "cabecera repetida entre frames");
+
+            RpcRequest legacy = RpcCodec::ParseLegacy(L"loadFile:a:b");
+            RpcRequest bare = RpcCodec::ParseLegacy(L"getMemory");
+            Check(legacy.legacy && legacy.verb == L"loadFile" && legacy.payload == L"a:b" && bare.verb == L"getMemory" && bare.payload.empty(),
+                  "legado \"verbo:payload\" y \"verbo\"");
+
+            std::string trace;
+            RpcTrace::AppendRecord(trace, "#1|1|saveFile|5|a|b\nc");
+            RpcTrace::AppendRecord(trace, "");
+            RpcTrace::AppendRecord(trace, "getMemory");
+            std::string_view tr = trace, m1, m2, m3, m4;
+            ok = RpcTrace::NextRecord(tr, m1) && RpcTrace::NextRecord(tr, m2) && RpcTrace::NextRecord(tr, m3) && !RpcTrace::NextRecord(tr, m4);
+            Check(ok && m1 == "#1|1|saveFile|5|a|b\nc" && m2.empty() && m3 == "getMemory", "trazas: ida y vuelta con saltos de línea");
+            std::string_view cut = std::string_view(trace).substr(0, trace.size() - 3);
+            int n = 0;
+            while (RpcTrace::NextRecord(cut, m4)) n++;
+            Check(n == 2, "trazas: un registro truncado no se lee");
+        }
+
+        std::printf("frames rotos\n");
+        {
+            Ctx ctx;
+            Dispatcher d;
+            d.Register(L"echo", OnEcho);
+            Check(Reply(d, ctx, L"#1|1|echo|99|abc") == L"#1|1|err|15|malformed frame", "longitud de más: \"err\" para su id");
+            Check(Reply(d, ctx, L"#1|1|echo|99|abc#1|2|echo|2|hi") == L"#1|1|err|15|malformed frame2|ok|2|hi",
+                  "el siguiente frame con cabecera sigue recibiendo respuesta");
+            Check(Reply(d, ctx, L"#1|5||1|a#1|6|echo|x|a#1|7|echo") == L"#1|5|err|15|malformed frame6|err|15|malformed frame7|err|15|malformed frame",
+                  "sin verbo, longitud no numérica y frame truncado");
+            Check(Reply(d, ctx, L"#1|99999999999999999999999|echo|1|a#1|3|echo|1|b") == L"#1|3|ok|1|b", "id que desborda: sin respuesta, el resto sí");
+            size_t processed = 9;
+            Check(Reply(d, ctx, L"#1|4294967296|echo|1|a", &processed).empty() && processed == 0, "id de más de 32 bits: se descarta");
+            Check(Reply(d, ctx, L"#1|1|echo|1|ajunk") == L"#1|1|ok|1|a", "basura al final sin id: se ignora");
+            Check(Reply(d, ctx, L"#1|1|echo|1|a2|echo|1|b") == L"#1|1|ok|1|a2|ok|1|b", "frames seguidos sin cabecera (formato original)");
+        }
+
+        std::printf("despacho\n");
+        {
+            Ctx ctx; ctx.file = L"{\"bpm\":150}";
+            Dispatcher d;
+            Check(d.Register(L"zeta", OnStub) && d.Register(L"alpha", OnEcho) && d.Register(L"mid", OnThrow) && !d.Register(L"alpha", OnStub),
+                  "registro desordenado; duplicados rechazados");
+            Check(d.Find(L"alpha") && d.Find(L"mid") && d.Find(L"zeta") && !d.Find(L"beta") && d.At(0).verb == L"alpha" && d.At(2).verb == L"zeta",
+                  "tabla ordenada y búsqueda binaria");
+            Dispatcher full;
+            size_t registered = 0;
+            std::vector<std::wstring> names;
+            for (size_t i = 0; i < Dispatcher::kMaxRoutes + 2; i++) names.push_back(L"v" + std::to_wstring(1000 + i));
+            for (const auto& n : names) registered += full.Register(n, OnStub);
+            Check(registered == Dispatcher::kMaxRoutes, "como mucho kMaxRoutes rutas");
+
+            Check(Reply(d, ctx, Envelope({ { L"alpha", L"hola" }, { L"nope", L"" }, { L"mid", L"" } })) ==
+                  L"#1|1|ok|4|hola2|err|18|unknown verb: nope3|err|9|exception", "una respuesta agrupada: ok, verbo desconocido y excepción");
+            std::wstring none = L"sin llamar";
+            size_t processed = 0;
+            d.Dispatch(ctx, L"#1|0|alpha|1|a0|zeta|0|", [&none](const std::wstring& r) { none = r; });
+            Check(none == L"sin llamar", "id 0 sin respuesta: no se publica nada");
+            Check(Reply(d, ctx, L"", &processed).empty() && processed == 0, "mensaje vacío");
+
+            Dispatcher legacy;
+            RegisterRoutes(legacy);
+            Check(Reply(legacy, ctx, L"loadFile:song") == L"fileLoaded:song|{\"bpm\":150}" && Reply(legacy, ctx, L"getMemory") == L"memInfo:734003200",
+                  "respuestas legadas (con y sin eco)");
+            Check(Reply(legacy, ctx, L"setTitle:Hola").empty(), "legado sin respuesta");
+
+            Dispatcher deferred;
+            deferred.Register(L"ok", OnEcho, {}, false, RpcMode::Pool);
+            deferred.Register(L"no", OnEcho, {}, false, RpcMode::Serial);
+            deferred.Register(L"now", OnEcho);
+            std::vector<uint32_t> handed;
+            deferred.SetDefer([&handed](Ctx&, const Dispatcher::Route& r, const RpcRequest& req, std::wstring& err) {
+                if (r.verb == L"no") { err = L"busy"; return false; }
+                handed.push_back(req.id);
+                return true;
+            });
+            Check(Reply(deferred, ctx, Envelope({ { L"ok", L"a" }, { L"no", L"b" }, { L"now", L"c" } })) == L"#1|2|err|4|busy3|ok|1|c" &&
+                  handed == std::vector<uint32_t>{ 1 }, "diferidas: aceptada sin respuesta, rechazada con motivo, Inline en el acto");
+
+            static int observed = 0;
+            observed = 0;
+            d.SetObserver([](const Dispatcher::Route& r, uint64_t q, uint64_t s, uint64_t e) { if (r.verb == L"alpha" && q == s && e >= s) observed++; });
+            Reply(d, ctx, Envelope({ { L"alpha", L"" }, { L"alpha", L"" } }));
+            d.SetObserver(nullptr);
+            Check(observed == 2, "observador por handler Inline");
+        }
+
+        std::printf("reservas\n");
+        {
+            Ctx ctx; ctx.file = std::wstring(2048, L'x'); ctx.list = L"a.json|b.json|c.json";
+            Dispatcher d;
+            RegisterRoutes(d);
+            std::wstring batch = Envelope({ { L"saveFile", L"autosave.json|" + std::wstring(4096, L'n') }, { L"listDir", L"public/songs" },
+                                            { L"getMemory", L"" }, { L"loadFile", L"autosave" }, { L"nope", L"" }, { L"frameAck", L"12" } });
+            batch += L"#1|9|listDir|99|roto";
+            std::wstring legacyMsg = L"loadFile:autosave";
+            size_t bytes = 0;
+            auto post = [&bytes](const std::wstring& r) { bytes += r.size(); };
+            for (int i = 0; i < 3; i++) { d.Dispatch(ctx, batch, post); d.Dispatch(ctx, legacyMsg, post); } // Calienta los buffers
+            uint64_t before = allocations.load();
+            for (int i = 0; i < 1000; i++) { d.Dispatch(ctx, batch, post); d.Dispatch(ctx, legacyMsg, post); }
+            uint64_t count = allocations.load() - before;
+            std::printf("  %llu reservas en 2000 mensajes\n", (unsigned long long)count);
+            Check(count == 0, "en régimen estable el despacho no reserva memoria por mensaje");
+        }
+
+        std::printf(failures ? "\n%d fallos\n" : "\ntodo bien\n", failures);
+        return failures ? 1 : 0;
+    }
+
+    // --- Trazas ---
+
+    /** Sesión del editor: ráfagas de autoguardado, listados, memoria y consultas al chart, más algún legado. */
+    std::vector<std::wstring> SyntheticSession(size_t bursts) {
+        std::vector<std::wstring> msgs;
+        std::wstring chart = L"chart-autosave.json|{\"song\":{\"song\":\"Darnell\",\"bpm\":155,\"notes\":[" + std::wstring(3000, L'0') + L"]}}";
+        uint32_t id = 1;
+        for (size_t b = 0; b < bursts; b++) {
+            std::vector<std::pair<std::wstring, std::wstring>> frames;
+            frames.push_back({ L"saveFile", chart });
+            frames.push_back({ L"saveFile", L"settings.json|{\"volume\":0.8,\"downscroll\":false}" });
+            frames.push_back({ L"listDir", L"public/songs/Darnell/charts" });
+            frames.push_back({ L"getMemory", L"" });
+            if (b % 4 == 0) frames.push_back({ L"loadFile", L"chart-autosave" });
+            if (b % 2 == 0) frames.push_back({ L"chartNotes", L"1|" + std::to_wstring(b * 250) + L"|" + std::to_wstring(b * 250 + 4000) });
+            std::wstring msg(RpcCodec::kMagic);
+            for (size_t i = 0; i < frames.size(); i++) {
+                if (i) msg += RpcCodec::kMagic;
+                RpcCodec::AppendFrame(msg, id++, frames[i].first, frames[i].second);
+            }
+            msgs.push_back(std::move(msg));
+            msgs.push_back(L"#1|0|frameAck|" + std::to_wstring(std::to_wstring(b).size()) + L"|" + std::to_wstring(b));
+            if (b % 8 == 0) msgs.push_back(L"setTitle:Genesis - Darnell *");
+        }
+        return msgs;
+    }
+
+    bool LoadTrace(const fs::path& path, std::vector<std::wstring>& msgs) {
+        std::string data;
+        if (!AtomicFile::ReadAll(path, data)) return false;
+        std::string_view rest = data, msg;
+        while (RpcTrace::NextRecord(rest, msg)) msgs.push_back(Utils::ToWString(msg));
+        return rest.empty();
+    }
+
+    /**
+     * Referencia: el HandleWebMessage de antes. Cadena de msg.find(L"prefijo:") == 0 con copias por
+     * substr, una respuesta (una copia de la cadena) por llamada y un mensaje por llamada.
+     */
+    struct Baseline {
+        std::wstring file, list, posted;
+        size_t posts = 0;
+
+        void Post(const std::wstring& reply) { posted = reply.c_str(); posts++; } // PostWebMessageAsString copia la cadena
+
+        void Handle(std::wstring msg) {
+            if (msg.find(L"resize:") == 0) {
+                std::wstring dims = msg.substr(7);
+                sink += (size_t)std::stoi(dims.substr(0, dims.find(L","))) + (size_t)std::stoi(dims.substr(dims.find(L",") + 1));
+            }
+            else if (msg == L"maximize" || msg == L"minimize" || msg == L"close") sink++;
+            else if (msg.find(L"setTitle:") == 0) sink += msg.substr(9).size();
+            else if (msg.find(L"saveFile:") == 0) {
+                std::wstring data = msg.substr(9);
+                size_t pipe = data.find(L"|");
+                if (pipe != std::wstring::npos) sink += data.substr(0, pipe).size() + data.substr(pipe + 1).size();
+            }
+            else if (msg.find(L"loadFile:") == 0) {
+                std::wstring key = msg.substr(9);
+                std::wstring content = file;
+                Post(L"fileLoaded:" + key + L"|" + content);
+            }
+            else if (msg.find(L"listDir:") == 0) {
+                std::wstring relPath = msg.substr(8);
+                for (auto& c : relPath) if (c == L'/') c = L'\\';
+                Post(L"dirListed:" + relPath + L"|" + list);
+            }
+            else if (msg.find(L"openExternal:") == 0) sink += msg.substr(13).size();
+            else if (msg.find(L"msgBox:") == 0) Post(L"dialogClosed");
+            else if (msg.find(L"openFile:") == 0) Post(L"fileSelected:" + msg.substr(9));
+            else if (msg == L"getMemory") Post(L"memInfo:" + std::to_wstring(734003200));
+            else if (msg.find(L"discord:") == 0) sink += Utils::ToString(msg.substr(8)).size();
+        }
+    };
+
+    /** Cada llamada de la traza como el mensaje legado que habría mandado la página antes. */
+    std::vector<std::wstring> AsLegacy(const std::vector<std::wstring>& msgs, size_t& frames) {
+        std::vector<std::wstring> out;
+        frames = 0;
+        for (const auto& m : msgs) {
+            if (!RpcCodec::IsEnvelope(m)) { out.push_back(m); frames++; continue; }
+            std::wstring_view rest = std::wstring_view(m).substr(RpcCodec::kMagic.size());
+            RpcRequest req;
+            bool malformed = false;
+            while (RpcCodec::NextFrame(rest, req, &malformed) || malformed) {
+                if (malformed) continue;
+                frames++;
+                std::wstring legacy(req.verb);
+                if (!req.payload.empty() || legacy != L"getMemory") { legacy += L':'; legacy.append(req.payload.data(), req.payload.size()); }
+                out.push_back(std::move(legacy));
+            }
+        }
+        return out;
+    }
+
+    int Record(const fs::path& out, size_t bursts) {
+        std::string data;
+        for (const auto& m : SyntheticSession(bursts)) RpcTrace::AppendRecord(data, Utils::ToString(m));
+        std::string err;
+        if (!AtomicFile::Write(out, data, err)) { std::fprintf(stderr, "%s: %s\n", out.u8string().c_str(), err.c_str()); return 1; }
+        std::printf("%s: %zu bytes\n", out.u8string().c_str(), data.size());
+        return 0;
+    }
+
+    int Bench(const fs::path& trace, int rounds) {
+        std::vector<std::wstring> msgs;
+        if (trace.empty()) msgs = SyntheticSession(2000);
+        else if (!LoadTrace(trace, msgs)) { std::fprintf(stderr, "%s: no es una traza válida\n", trace.u8string().c_str()); return 1; }
+        size_t frames = 0, chars = 0;
+        std::vector<std::wstring> legacy = AsLegacy(msgs, frames);
+        for (const auto& m : msgs) chars += m.size();
+        std::printf("rpcbench --bench: %s, %zu mensajes, %zu llamadas, %.1f MB\n", trace.empty() ? "sesión sintética" : trace.u8string().c_str(),
+                    msgs.size(), frames, chars * sizeof(wchar_t) / 1048576.0);
+
+        Ctx ctx; ctx.file = std::wstring(2048, L'x'); ctx.list = L"Darnell.json|Darnell-easy.json|Darnell-hard.json|Events.json";
+        Dispatcher d;
+        RegisterRoutes(d);
+
+        auto best = [rounds](auto&& fn) {
+            double b = 1e300;
+            for (int r = 0; r < rounds; r++) { auto t0 = Clock::now(); fn(); b = std::min(b, Ms(Clock::now() - t0)); }
+            return b;
+        };
+
+        size_t posts = 0, replyChars = 0;
+        auto post = [&posts, &replyChars](const std::wstring& r) { posts++; replyChars += r.size(); };
+        for (const auto& m : msgs) d.Dispatch(ctx, m, post); // Calienta
+        uint64_t allocBefore = allocations.load();
+        posts = replyChars = 0;
+        double table = best([&] { for (const auto& m : msgs) d.Dispatch(ctx, m, post); });
+        uint64_t tableAllocs = (allocations.load() - allocBefore) / (uint64_t)rounds;
+        size_t tablePosts = posts / (size_t)rounds;
+
+        Baseline base; base.file = ctx.file; base.list = ctx.list;
+        allocBefore = allocations.load();
+        double chain = best([&] { for (const auto& m : legacy) base.Handle(m); }); // Por valor, como antes
+        uint64_t chainAllocs = (allocations.load() - allocBefore) / (uint64_t)rounds;
+        size_t chainPosts = base.posts / (size_t)rounds;
+
+        std::printf("\n  %-28s %10s %12s %12s %12s\n", "", "ms", "ns/llamada", "mensajes", "reservas");
+        std::printf("  %-28s %10.2f %12.0f %12zu %12llu\n", "tabla + sobre agrupado", table, table * 1e6 / frames, msgs.size() + tablePosts,
+                    (unsigned long long)tableAllocs);
+        std::printf("  %-28s %10.2f %12.0f %12zu %12llu\n", "cadena de prefijos (antes)", chain, chain * 1e6 / frames, legacy.size() + chainPosts,
+                    (unsigned long long)chainAllocs);
+        std::printf("\n  %.1fx más rápido; %.2f reservas por mensaje frente a %.2f\n", chain / table, (double)tableAllocs / msgs.size(),
+                    (double)chainAllocs / legacy.size());
+        sink += replyChars;
+        return 0;
+    }
+
+    void Usage() {
+        std::fprintf(stderr,
+            "Uso:\n"
+            "  rpcbench --verify\n"
+            "  rpcbench --bench [traza] [rondas]\n"
+            "  rpcbench --record <salida> [ráfagas]\n");
+    }
+
+    int Run(const std::vector<fs::path>& args) {
+        if (args.empty()) { Usage(); return 1; }
+        std::string cmd = args[0].u8string();
+        if (cmd == "--verify") return Verify();
+        if (cmd == "--bench") {
+            fs::path trace = args.size() >= 2 && args[1].u8string() != "-" ? args[1] : fs::path();
+            return Bench(trace, args.size() >= 3 ? std::max(1, std::atoi(args[2].u8string().c_str())) : 5);
+        }
+        if (cmd == "--record" && args.size() >= 2) return Record(args[1], args.size() >= 3 ? (size_t)std::max(1, std::atoi(args[2].u8string().c_str())) : 2000);
+        Usage();
+        return 1;
+    }
+}
+
+#ifdef _WIN32
+int wmain(int argc, wchar_t** argv) { return Run(std::vector<fs::path>(argv + 1, argv + argc)); }
+#else
+int main(int argc, char** argv) { return Run(std::vector<fs::path>(argv + 1, argv + argc)); }
+#endif
@@ -0,0 +1,230 @@
+/**
+ * savebench - Comprueba y mide los guardados de la página (core/WriteBehindStore.h, core/AtomicFile.h).
+ *
+ * Uso:
+ *   savebench --verify          Mata el proceso que escribe tras escribir los temporales, tras el fsync,
+ *                               entre renames y tras el fsync del directorio; cada archivo tiene que
+ *                               quedar entero en su versión vieja o en la nueva, y el siguiente guardado
+ *                               tiene que funcionar
+ *   savebench --bench [KB]      Guardados/s: AtomicFile::Write uno a uno, Put + Flush por guardado,
+ *                               lotes de 16 claves por Flush y autoguardado con coalescencia (64 KB)
+ *
+ * El corte es un kill del proceso, no un apagón: lo que no llegó a fsync sigue en la caché del
+ * sistema, así que aquí se comprueba el orden de los pasos, no que el disco cumpla el fsync.
+ */
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include "../core/AtomicFile.h"
+#include "../core/Utf.h"
+#include "../core/WriteBehindStore.h"
+#include "Tool.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+    using namespace Tool;
+    using Phase = WriteBehindStore::Phase;
+
+    constexpr int kKeys = 4;
+    std::string self; // Ruta de este ejecutable: --verify se relanza a sí mismo para cada corte
+
+    std::string KeyOf(int i) { return "saves/k" + std::to_string(i) + ".json"; }
+
+    /** Contenido de la versión `v` de la clave `i`: cabecera, tamaño variable y relleno comprobable. */
+    std::string Version(int v, int i) {
+        size_t size = 32 * 1024 + ((size_t)v * 7919 + (size_t)i * 104729) % (256 * 1024);
+        std::string s = "v=" + std::to_string(v) + ";k=" + std::to_string(i) + ";n=" + std::to_string(size) + ";";
+        s.resize(size, (char)('a' + (v + i) % 26));
+        return s;
+    }
+
+    /**
+     * Versión que hay en disco: 0 si no existe, -1 si está a medias o no es ninguna versión.
+     */
+    int VersionOnDisk(const fs::path& root, int i) {
+        std::string data;
+        if (!AtomicFile::ReadAll(root / KeyOf(i), data)) return 0;
+        int v = 0, k = -1;
+        if (std::sscanf(data.c_str(), "v=%d;k=%d;", &v, &k) != 2 || k != i || v <= 0) return -1;
+        return data == Version(v, i) ? v : -1;
+    }
+
+    size_t TempFiles(const fs::path& root) {
+        size_t n = 0;
+        std::error_code ec;
+        for (auto& e : fs::recursive_directory_iterator(root, ec)) {
+            if (e.path().extension() == ".tmp") n++;
+        }
+        return n;
+    }
+
+    [[noreturn]] void Die() {
+#ifdef _WIN32
+        TerminateProcess(GetCurrentProcess(), 9);
+#else
+        std::raise(SIGKILL);
+#endif
+        std::abort();
+    }
+
+    /**
+     * Proceso hijo: guarda las kKeys claves en `rounds` volcados y se mata en la fase `phase`
+     * del último (en Renamed, tras el rename número `nth`).
+     */
+    int CrashChild(const fs::path& root, int phase, int rounds, int nth) {
+        WriteBehindStore store(root, std::chrono::hours(1));
+        int round = 0, renames = 0;
+        store.SetPhaseHook([&](Phase p) {
+            if (round != rounds || (int)p != phase) return;
+            if (p == Phase::Renamed && ++renames < nth) return;
+            Die();
+        });
+        for (round = 1; round <= rounds; round++) {
+            for (int i = 0; i < kKeys; i++) store.Put(KeyOf(i), Version(round, i));
+            store.Flush();
+        }
+        store.Stop();
+        WriteFile(root / "completed", "");
+        return 3;
+    }
+
+    int Spawn(const std::string& args) {
+        std::fflush(stdout);
+        std::string cmd = "\"" + self + "\" " + args;
+#ifdef _WIN32
+        cmd = "\"" + cmd + "\""; // cmd /c quita el primer par de comillas
+        return _wsystem(Utf::ToWide(cmd).c_str());
+#else
+        return std::system(("exec 2>/dev/null; " + cmd).c_str()); // Sin el "Killed" del shell
+#endif
+    }
+
+    int Verify() {
+        std::printf("savebench --verify: un kill en cada paso del volcado, %d claves por lote\n", kKeys);
+        fs::path dir = MakeTempDir("savebench");
+        static const char* kPhaseNames[] = { "temporales escritos", "temporales sincronizados", "rename", "directorio sincronizado" };
+        for (int phase = 0; phase < 4; phase++) {
+            std::vector<int> nths = phase == (int)Phase::Renamed ? std::vector<int>{ 1, 2, kKeys } : std::vector<int>{ 0 };
+            for (int rounds : { 1, 2, 5 }) {
+                for (int nth : nths) {
+                    fs::path root = dir / ("p" + std::to_string(phase) + "-r" + std::to_string(rounds) + "-n" + std::to_string(nth));
+                    fs::create_directories(root);
+                    Spawn("--crash-child \"" + root.u8string() + "\" " + std::to_string(phase) + " " + std::to_string(rounds) + " " + std::to_string(nth));
+
+                    bool killed = !fs::exists(root / "completed");
+                    bool intact = true, expected = true;
+                    for (int i = 0; i < kKeys; i++) {
+                        int v = VersionOnDisk(root, i);
+                        intact &= v >= 0;
+                        bool isNew = phase == (int)Phase::DirSynced || (phase == (int)Phase::Renamed && i < nth);
+                        expected &= v == (isNew ? rounds : rounds - 1);
+                    }
+                    size_t temps = TempFiles(root);
+                    bool tempsOk = phase == (int)Phase::Renamed ? temps == (size_t)(kKeys - nth)
+                                 : phase == (int)Phase::DirSynced ? temps == 0 : temps == (size_t)kKeys;
+
+                    // Tras el corte: el siguiente proceso guarda encima sin problema
+                    {
+                        WriteBehindStore store(root, std::chrono::milliseconds(0));
+                        for (int i = 0; i < kKeys; i++) store.Put(KeyOf(i), Version(1000, i));
+                        store.Stop();
+                    }
+                    bool recovered = TempFiles(root) == 0;
+                    for (int i = 0; i < kKeys; i++) recovered &= VersionOnDisk(root, i) == 1000;
+
+                    char what[200];
+                    std::snprintf(what, sizeof(what), "kill tras %s%s (volcado %d): ningún archivo a medias, cada uno viejo o nuevo como toca",
+                                  kPhaseNames[phase], phase == (int)Phase::Renamed ? (" " + std::to_string(nth)).c_str() : "", rounds);
+                    Check(killed && intact && expected, what);
+                    if (!tempsOk) Check(false, "  los temporales que quedan son los de las claves sin renombrar");
+                    if (!recovered) Check(false, "  el siguiente guardado reemplaza el archivo y limpia el temporal");
+                }
+            }
+        }
+        std::error_code ec;
+        fs::remove_all(dir, ec);
+        std::printf(failures ? "\n%d fallos\n" : "\ntodo bien\n", failures);
+        return failures ? 1 : 0;
+    }
+
+    void Report(const char* what, size_t saves, Clock::duration d, const char* note = "") {
+        std::printf("  %-44s %10.0f guardados/s %8.3f ms/guardado  %s\n", what, saves / Seconds(d), Ms(d) / saves, note);
+    }
+
+    int Bench(size_t kb) {
+        fs::path dir = MakeTempDir("savebench");
+        std::string data(kb * 1024, 'x');
+        std::printf("savebench: guardados de %zu KB\n\n", kb);
+        {
+            size_t n = 200;
+            std::string err;
+            auto t0 = Clock::now();
+            for (size_t i = 0; i < n; i++) AtomicFile::Write(dir / "a" / "save.json", data, err);
+            Report("AtomicFile::Write (fsync x2 por guardado)", n, Clock::now() - t0);
+        }
+        {
+            size_t n = 200;
+            WriteBehindStore store(dir / "b", std::chrono::milliseconds(0));
+            auto t0 = Clock::now();
+            for (size_t i = 0; i < n; i++) { store.Put("save.json", data); store.Flush(); }
+            Report("Put + Flush por guardado", n, Clock::now() - t0);
+        }
+        {
+            size_t lots = 50, keys = 16;
+            WriteBehindStore store(dir / "c", std::chrono::hours(1));
+            auto t0 = Clock::now();
+            for (size_t l = 0; l < lots; l++) {
+                for (size_t k = 0; k < keys; k++) store.Put("k" + std::to_string(k) + ".json", data);
+                store.Flush();
+            }
+            Report("lotes de 16 claves por Flush", lots * keys, Clock::now() - t0, "(un fsync de directorio por lote)");
+        }
+        {
+            size_t n = 20000;
+            WriteBehindStore store(dir / "d", std::chrono::milliseconds(50));
+            auto t0 = Clock::now();
+            for (size_t i = 0; i < n; i++) store.Put("k" + std::to_string(i % 8) + ".json", data);
+            auto put = Clock::now() - t0;
+            store.Stop();
+            auto total = Clock::now() - t0;
+            WriteBehindStore::Stats st = store.GetStats();
+            char note[96];
+            std::snprintf(note, sizeof(note), "(%llu escritos a disco, %.1f ms hasta Stop)", (unsigned long long)st.commits, Ms(total));
+            Report("autoguardado: Put, ventana de 50 ms, 8 claves", n, put, note);
+        }
+        std::error_code ec;
+        fs::remove_all(dir, ec);
+        return 0;
+    }
+
+    int Run(const std::vector<std::string>& args) {
+        if (args.size() == 5 && args[0] == "--crash-child") {
+            return CrashChild(fs::u8path(args[1]), std::atoi(args[2].c_str()), std::atoi(args[3].c_str()), std::atoi(args[4].c_str()));
+        }
+        if (!args.empty() && args[0] == "--verify") return Verify();
+        if (!args.empty() && args[0] == "--bench") return Bench(args.size() >= 2 ? (size_t)std::max(1, std::atoi(args[1].c_str())) : 64);
+        std::fprintf(stderr, "uso: savebench --verify | --bench [KB por guardado]\n");
+        return 2;
+    }
+}
+
+#ifdef _WIN32
+int wmain(int argc, wchar_t** argv) {
+    std::vector<std::string> args;
+    for (int i = 1; i < argc; i++) args.push_back(Utf::ToUtf8(argv[i]));
+    self = Utf::ToUtf8(argv[0]);
+    return Run(args);
+}
+#else
+int main(int argc, char** argv) {
+    self = argv[0];
+    return Run(std::vector<std::string>(argv + 1, argv + argc));
+}
+#endif
@@ -0,0 +1,283 @@
+/**
+ * searchbench - Comprueba y mide la búsqueda con índice de trigramas (core/Search.h).
+ *
+ * Uso:
+ *   searchbench --verify [raíz]                Tramos obligatorios de regex, árbol sintético (literal,
+ *                                              regex, mayúsculas, líneas largas, cambios, índice
+ *                                              guardado); si se indica una raíz, compara índice y
+ *                                              recorrido completo en sus carpetas source/ y public/
+ *   searchbench --bench [raíz] [hilos]         Índice en frío, en caliente y desde disco; cada consulta
+ *                                              con índice frente al recorrido completo en paralelo
+ *
+ * La raíz es la carpeta que contiene source/ y public/ (por defecto el directorio actual); también
+ * valen public/ o una carpeta dentro de public/, como en el resto de herramientas (Tool::ProjectRoot).
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "../core/Search.h"
+#include "../core/TaskPool.h"
+#include "../core/Utf.h"
+#include "Tool.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+    using namespace Tool;
+
+    const std::vector<std::string> kRoots = { "source", "public" };
+
+    /** Resultados como "ruta:línea:columna", ordenados. */
+    std::vector<std::string> Find(const Search::Index& index, const Search::Query& q, TaskPool* pool = nullptr,
+                                  Search::QueryStats* st = nullptr, bool* ok = nullptr) {
+        std::vector<std::string> out;
+        bool valid = index.Run(q, [&](std::vector<Search::Hit>& hits) {
+            for (const auto& h : hits) out.push_back(h.path + ":" + std::to_string(h.line) + ":" + std::to_string(h.column));
+        }, pool, nullptr, st);
+        if (ok) *ok = valid;
+        std::sort(out.begin(), out.end());
+        return out;
+    }
+
+    Search::Query Literal(const std::string& text, bool caseSensitive = false) {
+        Search::Query q;
+        q.text = text;
+        q.caseSensitive = caseSensitive;
+        return q;
+    }
+
+    Search::Query Regex(const std::string& text, bool caseSensitive = false) {
+        Search::Query q = Literal(text, caseSensitive);
+        q.regex = true;
+        return q;
+    }
+
+    Search::Query All(Search::Query q) { q.scanAll = true; return q; }
+
+    void Literals() {
+        std::printf("\ntramos obligatorios de regex\n");
+        struct Case { const char* re; bool ok; std::vector<std::string> lits; };
+        const Case cases[] = {
+            { "altAnimation", true, { "altAnimation" } },
+            { "\"script\":\\s*\"bg\\w+\"", true, { "\"script\":", "\"bg" } },
+            { "namePath\\.png", true, { "namePath.png" } },
+            { "colou?r", true, { "colo" } },
+            { "abc(def)?ghi", true, { "abc", "ghi" } },
+            { "foo|bar", false, {} },
+            { "(foo|bar)baz", true, { "baz" } },
+            { "[abc]+xyz[^)]*end", true, { "xyz", "end" } },
+            { "ab+cd", true, {} },
+            { "abc+de", true, { "abc" } },
+            { "\\x41BCD", true, { "BCD" } },
+            { "x{2,3}yyy", true, { "yyy" } },
+        };
+        bool all = true;
+        for (const Case& c : cases) {
+            std::vector<std::string> lits;
+            bool ok = Search::RequiredLiterals(c.re, lits);
+            if (ok != c.ok || lits != c.lits) { all = false; std::printf("    %s\n", c.re); }
+        }
+        auto branches = Search::Branches("a|b(c|d)|[|]e|f\\|g");
+        all = all && branches.size() == 4 && branches[1] == "b(c|d)" && branches[2] == "[|]e" && branches[3] == "f\\|g";
+        Check(all, "literales, clases, grupos, cuantificadores, escapes y alternancia");
+    }
+
+    void Synthetic(const fs::path& root) {
+        std::printf("\nárbol sintético\n");
+        WriteFile(root / "source/funkin/a.js", "export function altAnimation() {\n  return 'HEY';\n}\n");
+        WriteFile(root / "source/funkin/b.js", "// nada que ver\nconst hey = 1;\r\n");
+        WriteFile(root / "source/funkin/style.css", ".Hey { color: red; }\n");
+        WriteFile(root / "source/funkin/notes.txt", "altAnimation no se indexa\n");
+        WriteFile(root / "public/data/stages/town.json", "{\"stage\":[{\"namePath\":\"sky\"},{\"namePath\":\"tree\"}]}\n");
+        WriteFile(root / "public/songs/A/charts/Events.json", "{\"events\":[\n{\"script\":\"altAnimation\"},\n{\"script\":\"bgFlash\"}\n]}\n");
+        WriteFile(root / "public/images/x.xml", "<SubTexture name=\"idle0000\"/>\n<SubTexture name=\"HEY0001\"/>\n");
+        std::string longLine(3 * Search::kLongLine, 'x');
+        longLine.replace(100, 5, "bgOne");
+        longLine.replace(Search::kLongLine - 2, 5, "bgTwo");     // Cruza el primer corte
+        longLine.replace(2 * Search::kLongLine + 500, 5, "bgSix");
+        WriteFile(root / "public/data/long.json", longLine + "\n");
+
+        DirTreeCache tree(root);
+        Search::Index index;
+        Search::UpdateStats us;
+        index.Update(tree, kRoots, nullptr, &us);
+        Check(us.files == 7 && us.indexed == 7 && index.Files() == 7, "7 archivos de texto indexados (.txt no)");
+
+        Search::QueryStats st;
+        auto r = Find(index, Literal("altanimation"), nullptr, &st);
+        std::vector<std::string> expected = { "public/songs/A/charts/Events.json:2:12", "source/funkin/a.js:1:17" };
+        Check(r == expected && st.candidates == 2, "literal sin distinguir mayúsculas: solo se leen 2 archivos");
+        Check(Find(index, Literal("altanimation", true)).empty() && Find(index, Literal("altAnimation", true)).size() == 2,
+              "literal distinguiendo mayúsculas");
+        r = Find(index, Literal("hey"), nullptr, &st);
+        Check(r.size() == 4 && st.candidates == 4, "\"hey\" en .js, .css y .xml (con \\r\\n)");
+
+        r = Find(index, Regex("\"script\":\"bg\\w+\""), nullptr, &st);
+        Check(r == std::vector<std::string>{ "public/songs/A/charts/Events.json:3:2" } && st.candidates == 1, "regex con tramos obligatorios");
+        r = Find(index, Regex("bg(One|Two|Six)"));
+        Check(r.size() == 3 && r == Find(index, All(Regex("bg(One|Two|Six)"))), "línea larga: coincidencias en cada tramo, también en un corte");
+        r = Find(index, Regex("sky|bgFlash"), nullptr, &st);
+        Check(r.size() == 2 && st.candidates == 2, "alternancia de primer nivel: unión de los candidatos de cada rama");
+        Find(index, Regex("sky|t.ee"), nullptr, &st);
+        Check(st.candidates == 7, "una rama sin literales: se leen todos");
+        Check(Find(index, Literal("ey"), nullptr, &st).size() == 4 && st.candidates == 7, "menos de 3 caracteres: se leen todos");
+        bool valid = true;
+        Find(index, Regex("(abc"), nullptr, nullptr, &valid);
+        Check(!valid, "regex inválida: error");
+
+        Search::Query capped = Literal("x");
+        capped.maxHits = 2;
+        Find(index, capped, nullptr, &st);
+        Check(st.hits == 2 && st.truncated, "maxHits corta la búsqueda");
+
+        // Cambios: uno editado, uno nuevo, uno borrado
+        WriteFile(root / "source/funkin/b.js", "// ahora sí: altAnimation\n");
+        WriteFile(root / "source/funkin/c.js", "altAnimation();\n");
+        fs::remove(root / "public/data/stages/town.json");
+        index.Update(tree, kRoots, nullptr, &us);
+        Check(us.indexed == 2 && us.reused == 5 && us.removed == 1 && us.files == 7, "actualización: solo se releen los 2 cambiados");
+        r = Find(index, Literal("altAnimation"));
+        Check(r.size() == 4 && Find(index, Literal("namePath")).empty(), "los cambios aparecen en las búsquedas");
+
+        fs::path saved = root / "index.gsrx";
+        std::string err;
+        Search::Index loaded;
+        bool roundTrip = index.Save(saved, err) && loaded.Load(saved);
+        loaded.Update(tree, kRoots, nullptr, &us);
+        Check(roundTrip && us.indexed == 0 && us.reused == 7 && Find(loaded, Literal("altAnimation")) == r, "índice guardado y recargado");
+        WriteFile(saved, "GSRX basura");
+        Check(!loaded.Load(saved), "un índice truncado se ignora");
+
+        TaskPool pool(4);
+        bool same = true;
+        for (const auto& q : { Literal("altAnimation"), Literal("hey"), Regex("bg\\w{3}"), Regex("^\\s*return") }) {
+            same = same && Find(index, q, &pool) == Find(index, q) && Find(index, All(q), &pool) == Find(index, q);
+        }
+        Check(same, "en el pool = en un hilo = sin índice");
+    }
+
+    void Real(const fs::path& root) {
+        DirTreeCache tree(root);
+        TaskPool pool;
+        Search::Index index;
+        Search::UpdateStats us;
+        index.Update(tree, kRoots, &pool, &us);
+        std::printf("\n%s: %llu archivos indexados (%.1f ms)\n", root.generic_u8string().c_str(), (unsigned long long)us.files, us.ms);
+        const Search::Query queries[] = {
+            Literal("altAnimation"), Literal("namePath"), Literal("rpcCall"), Literal("SubTexture name=\"BF idle"),
+            Literal("Voices-Player", true), Regex("\"script\"\\s*:\\s*\"\\w+\""), Regex("scene\\.load\\.(image|json)"),
+            Regex("class \\w+ extends"), Regex("TODO|FIXME"),
+        };
+        size_t mismatched = 0, narrowed = 0;
+        for (const auto& q : queries) {
+            Search::QueryStats st;
+            Search::Query a = q, b = All(q);
+            a.maxHits = b.maxHits = (size_t)-1;
+            auto withIndex = Find(index, a, &pool, &st);
+            if (withIndex != Find(index, b, &pool)) { mismatched++; std::printf("    distinto: %s\n", q.text.c_str()); }
+            if (st.candidates < st.files) narrowed++;
+        }
+        Check(us.files > 0, "las carpetas se indexan");
+        Check(mismatched == 0, "cada consulta da lo mismo con índice que recorriendo todo");
+        Check(narrowed >= 7, "el índice descarta archivos en las consultas con literales");
+    }
+
+    int Verify(const std::string& real) {
+        fs::path project;
+        if (!real.empty() && (project = ProjectRoot(real, "searchbench")).empty()) return 2;
+        std::printf("searchbench --verify\n");
+        Literals();
+        fs::path root = fs::temp_directory_path() / ("searchbench-" + std::to_string(std::chrono::system_clock::now().time_since_epoch().count()));
+        Synthetic(root);
+        std::error_code ec;
+        fs::remove_all(root, ec);
+        if (!project.empty()) Real(project);
+        std::printf(failures ? "\n%d fallos\n" : "\ntodo OK\n", failures);
+        return failures ? 1 : 0;
+    }
+
+    // --- Benchmark ---
+
+    int Bench(const std::string& arg, size_t threads) {
+        fs::path root = ProjectRoot(arg, "searchbench");
+        if (root.empty()) return 2;
+        TaskPool pool(threads);
+        const int reps = 5;
+        std::printf("searchbench: %s (%zu hilos en el pool, mejor de %d)\n", root.generic_u8string().c_str(), pool.Size(), reps);
+        auto best = [&](auto&& fn) {
+            double b = 1e300;
+            for (int r = 0; r < reps; r++) { auto t0 = Clock::now(); fn(); b = std::min(b, Ms(Clock::now() - t0)); }
+            return b;
+        };
+
+        DirTreeCache tree(root);
+        tree.SetLive(true);
+        Search::UpdateStats us;
+        double cold1 = best([&] { Search::Index i; i.Update(tree, kRoots, nullptr, &us); });
+        double coldPool = best([&] { Search::Index i; i.Update(tree, kRoots, &pool, &us); });
+        Search::Index index;
+        index.Update(tree, kRoots, &pool);
+        double warm = best([&] { index.Update(tree, kRoots, &pool, &us); });
+        uint64_t reindexed = us.indexed;
+        fs::path saved = fs::temp_directory_path() / "searchbench-index.gsrx";
+        std::string err;
+        index.Save(saved, err);
+        double fromDisk = best([&] { Search::Index i; i.Load(saved); i.Update(tree, kRoots, &pool, &us); });
+        std::error_code ec;
+        uint64_t diskBytes = fs::file_size(saved, ec);
+        fs::remove(saved, ec);
+
+        std::printf("  %llu archivos, %llu trigramas, índice en disco %.1f MB\n", (unsigned long long)us.files,
+                    (unsigned long long)index.Grams(), diskBytes / 1048576.0);
+        std::printf("  %-44s %9.2f ms\n", "índice en frío, 1 hilo", cold1);
+        std::printf("  %-44s %9.2f ms  (x%.1f)\n", "índice en frío, pool", coldPool, cold1 / coldPool);
+        std::printf("  %-44s %9.2f ms  (%llu releídos)\n", "actualización sin cambios", warm, (unsigned long long)reindexed);
+        std::printf("  %-44s %9.2f ms  (%llu releídos)\n", "arranque: índice guardado + actualización", fromDisk, (unsigned long long)us.indexed);
+
+        const Search::Query queries[] = {
+            Literal("altAnimation"), Literal("namePath"), Literal("rpcCall"), Literal("SubTexture name=\"BF idle"),
+            Regex("\"script\"\\s*:\\s*\"\\w+\""), Regex("scene\\.load\\.(image|json)"), Regex("TODO|FIXME"),
+        };
+        std::printf("\n  %-36s %8s %10s %12s %8s\n", "consulta", "leídos", "índice ms", "recorrido ms", "x");
+        for (const auto& q : queries) {
+            Search::Query a = q, b = All(q);
+            a.maxHits = b.maxHits = (size_t)-1;
+            Search::QueryStats st;
+            auto noop = [](std::vector<Search::Hit>&) {};
+            double indexed = best([&] { index.Run(a, noop, &pool, nullptr, &st); });
+            uint64_t read = st.candidates, hits = st.hits;
+            double scan = best([&] { index.Run(b, noop, &pool, nullptr, &st); });
+            std::string label = (q.regex ? "/" + q.text + "/" : q.text).substr(0, 34);
+            std::printf("  %-36s %3llu/%-4llu %10.3f %12.3f %8.1f  (%llu resultados)\n", label.c_str(), (unsigned long long)read,
+                        (unsigned long long)st.files, indexed, scan, scan / indexed, (unsigned long long)hits);
+        }
+        return 0;
+    }
+
+    int Run(const std::vector<std::string>& args) {
+        if (!args.empty() && args[0] == "--verify") return Verify(args.size() >= 2 ? args[1] : "");
+        if (!args.empty() && args[0] == "--bench") {
+            return Bench(args.size() >= 2 ? args[1] : "", args.size() >= 3 ? (size_t)std::max(0, std::atoi(args[2].c_str())) : 0);
+        }
+        std::fprintf(stderr, "uso: searchbench --verify [raíz] | --bench [raíz] [hilos]\n");
+        return 2;
+    }
+}
+
+#ifdef _WIN32
+int wmain(int argc, wchar_t** argv) {
+    std::vector<std::string> args;
+    for (int i = 1; i < argc; i++) args.push_back(Utf::ToUtf8(argv[i]));
+    return Run(args);
+}
+#else
+int main(int argc, char** argv) {
+    return Run(std::vector<std::string>(argv + 1, argv + argc));
+}
+#endif
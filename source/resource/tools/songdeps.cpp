@@ -0,0 +1,279 @@
+/**
+ * songdeps - Grafo de dependencias de las canciones (core/AssetGraph.h).
+ *
+ * Uso:
+ *   songdeps <canción> [dificultad]          Manifiesto de precarga (JSON) de una canción
+ *   songdeps --report                        Lo que falta y lo que ninguna canción usa
+ *   songdeps --verify [raíz]                 Árbol sintético (faltantes, huérfanos, grupos, atlas
+ *                                            compartidos, cambios); si se indica una raíz, también la revisa
+ *   songdeps --bench [raíz]                  Grafo completo en frío y en caliente, una canción y su JSON
+ *
+ * La raíz es la carpeta que contiene public/ (por defecto el directorio actual); también valen
+ * public/ o public/songs, como en el resto de herramientas (Tool::ProjectRoot).
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "../core/AssetGraph.h"
+#include "../core/Utf.h"
+#include "Tool.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+    using namespace Tool;
+
+    std::string Chart(const std::string& stage, bool needsVoices, const std::string& gf = "gf") {
+        return "{\"song\":{\"song\":\"Alpha\",\"bpm\":120,\"player\":\"bf\",\"enemy\":\"dad\",\"gfVersion\":\"" + gf +
+               "\",\"stage\":\"" + stage + "\",\"needsVoices\":" + (needsVoices ? "true" : "false") + ",\"notes\":[]}}";
+    }
+
+    std::string Character(const std::string& image, const std::string& icon) {
+        return "{\"image\":\"" + image + "\",\"healthicon\":\"" + icon + "\",\"animations\":[]}";
+    }
+
+    const AssetGraph::Node* FindNode(const AssetGraph::Manifest& m, const std::string& path) {
+        for (const auto& n : m.nodes) if (n.path == path) return &n;
+        return nullptr;
+    }
+
+    std::vector<std::string> Missing(const AssetGraph::Manifest& m) {
+        std::vector<std::string> out;
+        for (const auto& n : m.nodes) if (n.missing) out.push_back(n.path);
+        std::sort(out.begin(), out.end());
+        return out;
+    }
+
+    void Synthetic(const fs::path& root) {
+        std::printf("\nárbol sintético\n");
+        fs::path pub = root / "public";
+        WriteFile(pub / "songs/Alpha/charts/Alpha.json", Chart("town", false));
+        WriteFile(pub / "songs/Alpha/charts/alpha-hard.json", Chart("nowhere", false, ""));
+        WriteFile(pub / "songs/Alpha/charts/Events.json", "{\"events\":[]}");
+        WriteFile(pub / "songs/Alpha/charts/notes.json", "{\"comentario\":\"no es un chart\"}");
+        WriteFile(pub / "songs/Alpha/song/Inst.ogg", std::string(4000, 'i'));
+        WriteFile(pub / "songs/Alpha/song/Voices.ogg", std::string(3000, 'v'));
+        WriteFile(pub / "songs/Beta/charts/Beta.json", Chart("stage", true));
+        WriteFile(pub / "songs/Beta/song/Inst.ogg", std::string(100, 'i'));
+        WriteFile(pub / "songs/Beta/song/Voices-Player.ogg", std::string(100, 'p'));
+        WriteFile(pub / "songs/Beta/song/Voices.ogg", std::string(100, 'v'));
+
+        WriteFile(pub / "data/stages/town.json",
+            "{\"stage\":[{\"type\":\"image\",\"namePath\":\"sky\"},{\"type\":\"spritesheet\",\"namePath\":\"crowd\"},"
+            "{\"trees\":{\"type\":\"group\",\"children\":[{\"type\":\"image\",\"namePath\":\"tree\",\"atlas\":\"shared\"},"
+            "{\"type\":\"group\",\"children\":[{\"type\":\"image\",\"namePath\":\"bush\",\"atlas\":\"shared\"}]}]}},"
+            "{\"player\":{\"type\":\"character\"}},{\"enemy\":{\"type\":\"character\"}}]}");
+        WriteFile(pub / "data/stages/stage.json", "{\"stage\":[{\"type\":\"image\",\"namePath\":\"floor\"}]}");
+        WriteFile(pub / "data/characters/bf.json", Character("characters/BF", "bf"));
+        WriteFile(pub / "data/characters/dad.json", Character("characters/DAD", "dad"));
+        WriteFile(pub / "data/characters/unused.json", Character("characters/OLD", "old"));
+        WriteFile(pub / "data/noteSkins/Funkin.json",
+            "{\"asset\":\"Funkin\",\"strumline\":{\"image\":\"noteStrumline\"},\"notes\":{\"image\":\"notes\"},\"sustain\":{\"image\":\"NOTE_hold_assets\"}}");
+
+        for (const char* n : { "noteStrumline", "notes", "NOTE_hold_assets" }) {
+            WriteFile(pub / "images/noteSkins/Funkin" / (std::string(n) + ".png"), std::string(500, 'p'));
+            WriteFile(pub / "images/noteSkins/Funkin" / (std::string(n) + ".xml"), "<TextureAtlas/>");
+        }
+        WriteFile(pub / "images/characters/BF.png", std::string(2000, 'p'));
+        WriteFile(pub / "images/characters/BF.xml", "<TextureAtlas/>");
+        WriteFile(pub / "images/characters/DAD.png", std::string(2000, 'p'));   // Sin DAD.xml
+        WriteFile(pub / "images/characters/OLD.png", std::string(10, 'p'));
+        WriteFile(pub / "images/characters/OLD.xml", "<TextureAtlas/>");
+        WriteFile(pub / "images/characters/icons/bf.png", std::string(64, 'p')); // Sin dad.png
+        WriteFile(pub / "images/characters/icons/face.png", std::string(64, 'p'));
+        WriteFile(pub / "images/stages/town/sky.png", std::string(1234, 'p'));
+        WriteFile(pub / "images/stages/town/crowd.png", std::string(50, 'p'));
+        WriteFile(pub / "images/stages/town/crowd.xml", "<TextureAtlas/>");
+        WriteFile(pub / "images/stages/town/shared.png", std::string(700, 'p'));
+        WriteFile(pub / "images/stages/town/shared.xml", "<TextureAtlas/>");
+        WriteFile(pub / "images/stages/town/shared.gatl", std::string(30, 'g'));
+        WriteFile(pub / "images/stages/town/tree.png", std::string(20, 'p'));   // Fuente del atlas compartido
+        WriteFile(pub / "images/stages/stage/floor.png", std::string(300, 'p'));
+
+        DirTreeCache tree(root);
+        AssetGraph::Graph graph;
+        AssetGraph::Manifest m;
+        AssetGraph::Stats st;
+        graph.Resolve(tree, "Alpha", "normal", m, &st);
+
+        bool ordered = m.isChart && !m.nodes.empty() && m.nodes[0].path == "public/songs/Alpha/charts/Alpha.json";
+        for (size_t i = 1; i < m.nodes.size(); i++) ordered = ordered && m.nodes[i - 1].priority <= m.nodes[i].priority;
+        Check(ordered && st.parsed == 7, "el chart primero, prioridades en orden; 7 JSON de datos leídos");
+
+        const AssetGraph::Node* sky = FindNode(m, "public/images/stages/town/sky.png");
+        const AssetGraph::Node* inst = FindNode(m, "public/songs/Alpha/song/Inst.ogg");
+        uint64_t sum = 0;
+        for (const auto& n : m.nodes) if (!n.missing) sum += n.bytes;
+        Check(sky && sky->bytes == 1234 && sky->priority == 2 && inst && inst->bytes == 4000 && inst->priority == 3 && sum == m.bytes,
+              "tamaños de cada archivo y total del manifiesto");
+
+        Check(FindNode(m, "public/images/stages/town/crowd.xml") && FindNode(m, "public/images/stages/town/shared.gatl") &&
+              !FindNode(m, "public/images/stages/town/tree.png") && !FindNode(m, "public/images/stages/town/bush.png") &&
+              FindNode(m, "public/images/stages/stage/floor.png") == nullptr,
+              "spritesheets, grupos anidados y atlas compartido (una vez, con su .gatl)");
+
+        std::vector<std::string> expected = {
+            "public/data/characters/gf.json", "public/images/characters/DAD.xml", "public/images/characters/icons/dad.png",
+        };
+        Check(Missing(m) == expected && m.missing == 3 && FindNode(m, "public/images/characters/icons/face.png"),
+              "faltan gf.json, DAD.xml y el icono de dad (que cae a face.png)");
+        Check(FindNode(m, "public/songs/Alpha/charts/Events.json") && FindNode(m, "public/songs/Alpha/song/Voices.ogg") &&
+              FindNode(m, "public/data/stages/stage.json"), "Events.json, voces y stage.json de reserva");
+
+        AssetGraph::Manifest hard;
+        graph.Resolve(tree, "Alpha", "hard", hard, &st);
+        expected = { "public/data/stages/nowhere.json", "public/images/characters/DAD.xml", "public/images/characters/icons/dad.png" };
+        Check(hard.isChart && hard.nodes[0].path == "public/songs/Alpha/charts/alpha-hard.json" && Missing(hard) == expected &&
+              FindNode(hard, "public/images/stages/stage/floor.png") && !FindNode(hard, "public/images/stages/town/sky.png"),
+              "alpha-hard.json sin distinguir mayúsculas; stage inexistente cae a stage.json");
+        Check(st.parsed == 1 && st.reused == 5, "segunda canción: solo se parsea su chart");
+
+        AssetGraph::Manifest beta;
+        graph.Resolve(tree, "Beta", "normal", beta);
+        Check(Missing(beta).size() == 3 && FindNode(beta, "public/songs/Beta/song/Voices-Player.ogg") &&
+              !FindNode(beta, "public/songs/Beta/song/Voices-Opponent.ogg") && !FindNode(beta, "public/songs/Beta/song/Voices.ogg"),
+              "needsVoices: Voices-Player/-Opponent si existen, sin marcar faltantes");
+
+        AssetGraph::Manifest none;
+        graph.Resolve(tree, "Alpha", "erect", none);
+        Check(!none.isChart && none.nodes.size() == 1 && none.nodes[0].missing, "dificultad inexistente: solo el chart, marcado");
+
+        AssetGraph::Report report;
+        graph.Build(tree, report, &st);
+        std::vector<std::string> orphans;
+        for (const auto& o : report.orphans) orphans.push_back(o.path);
+        std::sort(orphans.begin(), orphans.end());
+        expected = {
+            "public/data/characters/unused.json", "public/images/characters/OLD.png", "public/images/characters/OLD.xml",
+            "public/images/stages/town/tree.png", "public/songs/Alpha/charts/notes.json", "public/songs/Beta/song/Voices.ogg",
+        };
+        Check(report.manifests.size() == 3 && orphans == expected, "grafo completo: 3 charts; huérfanos exactos (.gatl no cuenta)");
+        Check(report.missing.size() == 4 && st.parsed == 0, "faltantes únicos entre canciones; todo desde la caché");
+
+        // Cambios: otro atlas para bf, sin stage town
+        WriteFile(pub / "data/characters/bf.json", Character("characters/BF2", "bf"));
+        fs::remove(pub / "data/stages/town.json");
+        graph.Resolve(tree, "Alpha", "normal", m, &st);
+        Check(st.parsed == 1 && FindNode(m, "public/images/characters/BF2.png") && FindNode(m, "public/images/characters/BF2.png")->missing &&
+              FindNode(m, "public/images/stages/stage/floor.png") && FindNode(m, "public/data/stages/town.json")->missing,
+              "tras editar bf.json y borrar town.json: se reparsea solo bf.json");
+
+        std::string j;
+        AssetGraph::Graph::ToJson(m, j);
+        Json::Value doc;
+        Check(Json::Parse(j, doc) && doc["assets"].Size() == m.nodes.size() && doc["assets"][0]["kind"].Str() == "chart" &&
+              doc["missing"].Int() == (int)m.missing, "JSON del manifiesto");
+    }
+
+    void Real(const fs::path& root) {
+        DirTreeCache tree(root);
+        AssetGraph::Graph graph;
+        AssetGraph::Report report;
+        AssetGraph::Stats st;
+        graph.Build(tree, report, &st);
+        SongLibrary::Index index;
+        index.Scan(tree, "public/songs");
+        size_t charts = 0;
+        for (const auto& s : index.Songs()) charts += s.charts.size();
+        std::printf("\n%s: %zu charts, %.1f MB alcanzables, %zu faltantes, %zu huérfanos (%.1f ms)\n",
+                    root.generic_u8string().c_str(), report.manifests.size(), report.bytes / 1048576.0,
+                    report.missing.size(), report.orphans.size(), st.ms);
+        for (const auto& n : report.missing) std::printf("    falta %s\n", n.path.c_str());
+        Check(!report.manifests.empty() && report.manifests.size() == charts, "cada chart del índice de canciones tiene su manifiesto");
+    }
+
+    int Verify(const std::string& real) {
+        fs::path project;
+        if (!real.empty() && (project = ProjectRoot(real, "songdeps")).empty()) return 2;
+        std::printf("songdeps --verify\n");
+        fs::path root = fs::temp_directory_path() / ("songdeps-" + std::to_string(std::chrono::system_clock::now().time_since_epoch().count()));
+        Synthetic(root);
+        std::error_code ec;
+        fs::remove_all(root, ec);
+        if (!project.empty()) Real(project);
+        std::printf(failures ? "\n%d fallos\n" : "\ntodo OK\n", failures);
+        return failures ? 1 : 0;
+    }
+
+    // --- Benchmark ---
+
+    int Bench(const std::string& arg) {
+        fs::path root = ProjectRoot(arg, "songdeps");
+        if (root.empty()) return 2;
+        const int reps = 5;
+        std::printf("songdeps: %s (mejor de %d)\n", root.generic_u8string().c_str(), reps);
+        auto best = [&](auto&& fn) {
+            double b = 1e300;
+            for (int r = 0; r < reps; r++) { auto t0 = Clock::now(); fn(); b = std::min(b, Ms(Clock::now() - t0)); }
+            return b;
+        };
+
+        AssetGraph::Report report;
+        AssetGraph::Stats st;
+        // En frío: sin caché de carpetas ni de JSON (como el primer arranque)
+        double cold = best([&] { DirTreeCache tree(root); AssetGraph::Graph graph; graph.Build(tree, report, &st); });
+        uint64_t parsed = st.parsed;
+
+        // En caliente: carpetas en caché (watcher activo) y JSON ya leídos
+        DirTreeCache tree(root);
+        tree.SetLive(true);
+        AssetGraph::Graph graph;
+        graph.Build(tree, report);
+        double warm = best([&] { graph.Build(tree, report, &st); });
+        uint64_t reparsed = st.parsed;
+
+        AssetGraph::Manifest m;
+        std::string song = report.manifests.empty() ? "" : report.manifests[0].song;
+        std::string diff = report.manifests.empty() ? "" : report.manifests[0].difficulty;
+        double one = best([&] { graph.Resolve(tree, song, diff, m); });
+        std::string json;
+        double query = best([&] { json.clear(); AssetGraph::Graph::ToJson(m, json); });
+
+        std::printf("  %zu charts, %llu archivos alcanzables (%.1f MB), %zu huérfanos\n", report.manifests.size(),
+                    (unsigned long long)report.files, report.bytes / 1048576.0, report.orphans.size());
+        std::printf("  %-40s %9.2f ms  (%llu JSON leídos)\n", "grafo completo en frío", cold, (unsigned long long)parsed);
+        std::printf("  %-40s %9.2f ms  (%llu reparseados)\n", "grafo completo en caliente", warm, (unsigned long long)reparsed);
+        std::printf("  %-40s %9.3f ms  (%s %s, %zu archivos)\n", "una canción en caliente", one, song.c_str(), diff.c_str(), m.nodes.size());
+        std::printf("  %-40s %9.3f ms  (%zu KB)\n", "JSON del manifiesto", query, json.size() >> 10);
+        return 0;
+    }
+
+    int Run(const std::vector<std::string>& args) {
+        if (!args.empty() && args[0] == "--verify") return Verify(args.size() >= 2 ? args[1] : "");
+        if (!args.empty() && args[0] == "--bench") return Bench(args.size() >= 2 ? args[1] : "");
+        DirTreeCache tree(fs::current_path());
+        AssetGraph::Graph graph;
+        std::string j;
+        if (!args.empty() && args[0] == "--report") {
+            AssetGraph::Report report;
+            graph.Build(tree, report);
+            AssetGraph::Graph::ToJson(report, j);
+        } else if (!args.empty() && args[0][0] != '-') {
+            AssetGraph::Manifest m;
+            graph.Resolve(tree, args[0], args.size() >= 2 ? args[1] : "normal", m);
+            AssetGraph::Graph::ToJson(m, j);
+        } else {
+            std::fprintf(stderr, "uso: songdeps <canción> [dificultad] | --report | --verify [raíz] | --bench [raíz]\n");
+            return 2;
+        }
+        std::printf("%s\n", j.c_str());
+        return 0;
+    }
+}
+
+#ifdef _WIN32
+int wmain(int argc, wchar_t** argv) {
+    std::vector<std::string> args;
+    for (int i = 1; i < argc; i++) args.push_back(Utf::ToUtf8(argv[i]));
+    return Run(args);
+}
+#else
+int main(int argc, char** argv) {
+    return Run(std::vector<std::string>(argv + 1, argv + argc));
+}
+#endif
@@ -0,0 +1,347 @@
+/**
+ * streambench - Comprueba y mide las cargas en streaming (core/FileStream.h).
+ *
+ * Uso:
+ *   streambench --verify              Bloques (fronteras UTF-8, BOM, límites de tamaño), créditos,
+ *                                     Close durante un Read y leer justo después de guardar
+ *   streambench --bench [MB] [KB]     Tiempo hasta el primer bloque, MB/s y RSS máxima: stream
+ *                                     frente a leer y convertir el archivo entero (64 MB, 256 KB)
+ */
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../core/AtomicFile.h"
+#include "../core/FileStream.h"
+#include "../core/Telemetry.h"
+#include "../core/Utf.h"
+#include "../core/WriteBehindStore.h"
+#include "Tool.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+    using namespace Tool;
+
+    /** Texto aleatorio con ASCII, 2, 3 y 4 bytes por code point. */
+    std::string RandomText(std::mt19937_64& rng, size_t bytes) {
+        static const char* kPieces[] = { "a", "b", "{", "\"", "1", ",", "\n", "ñ", "é", "音", "符", "😀" };
+        std::string s;
+        s.reserve(bytes + 4);
+        while (s.size() < bytes) s += kPieces[rng() % 12];
+        return s;
+    }
+
+    /** Quita la cabecera "<id>|" de un bloque. */
+    std::wstring_view Body(const std::wstring& chunk) {
+        size_t pipe = chunk.find(L'|');
+        return pipe == std::wstring::npos ? std::wstring_view() : std::wstring_view(chunk).substr(pipe + 1);
+    }
+
+    struct Received {
+        std::wstring text;
+        size_t chunks = 0;
+        size_t maxSourceBytes = 0; // Mayor salto de "leídos" entre dos bloques
+        size_t lastDone = 0;
+        bool ended = false;
+        bool headersOk = true;
+    };
+
+    /** Lee un stream entero pidiendo `credits` bloques cada vez. */
+    bool Drain(StreamRegistry& reg, uint32_t id, size_t credits, Received& r) {
+        for (int guard = 0; !r.ended && guard < 1000000; guard++) {
+            size_t before = r.chunks;
+            bool found = reg.Read(id, credits, [&](uint32_t sid, size_t done, size_t, std::wstring&& chunk, bool last) {
+                r.headersOk &= sid == id && chunk.compare(0, std::to_wstring(id).size() + 1, std::to_wstring(id) + L'|') == 0;
+                r.text += Body(chunk);
+                r.maxSourceBytes = std::max(r.maxSourceBytes, done - r.lastDone);
+                r.lastDone = done;
+                r.chunks++;
+                r.ended |= last;
+            });
+            if (!found) return false;
+            if (r.chunks - before > credits) return false;
+        }
+        return r.ended;
+    }
+
+    void VerifyChunks(const fs::path& dir) {
+        std::printf("bloques\n");
+        std::mt19937_64 rng(7);
+        StreamRegistry reg;
+        for (size_t chunk : { (size_t)4096, (size_t)5000, (size_t)65536 }) {
+            std::string text = RandomText(rng, 300000);
+            fs::path p = dir / "chunks.json";
+            WriteFile(p, text);
+            size_t total = 0;
+            uint32_t id = reg.Open(p, chunk, total);
+            Received r;
+            bool ok = id && Drain(reg, id, 3, r);
+            char what[160];
+            std::snprintf(what, sizeof(what), "%zu B por bloque: el texto llega entero y sin partir code points (%zu bloques)", chunk, r.chunks);
+            Check(ok && total == text.size() && r.text == Utf::ToWide(text), what);
+            std::snprintf(what, sizeof(what), "%zu B por bloque: ningún bloque pasa del tamaño pedido", chunk);
+            Check(r.maxSourceBytes <= chunk && r.chunks >= text.size() / chunk, what);
+            Check(r.headersOk, "cada bloque empieza por \"<id>|\"");
+            Check(reg.OpenCount() == 0 && !reg.Read(id, 1, [](uint32_t, size_t, size_t, std::wstring&&, bool) {}), "el stream se cierra solo tras el último bloque");
+        }
+
+        WriteFile(dir / "bom.json", "\xEF\xBB\xBF{\"a\":\"ñ\"}");
+        size_t total = 0;
+        Received r;
+        uint32_t id = reg.Open(dir / "bom.json", 0, total);
+        Check(id && Drain(reg, id, 1, r) && r.text == L"{\"a\":\"ñ\"}" && r.chunks == 1, "el BOM no llega a la página");
+
+        WriteFile(dir / "empty.json", "");
+        Received e;
+        id = reg.Open(dir / "empty.json", 0, total);
+        Check(id && total == 0 && Drain(reg, id, 1, e) && e.text.empty() && e.chunks == 1, "archivo vacío: un bloque vacío y fin");
+
+        Check(reg.Open(dir / "no-existe.json", 0, total) == 0, "archivo que no existe: id 0");
+
+        std::string big = RandomText(rng, 64 * 1024);
+        WriteFile(dir / "clamp.json", big);
+        Received c;
+        id = reg.Open(dir / "clamp.json", 1, total);
+        Check(id && Drain(reg, id, 100, c) && c.maxSourceBytes <= StreamRegistry::kMinChunk && c.chunks >= big.size() / StreamRegistry::kMinChunk,
+              "bloque pedido por debajo del mínimo: se usa kMinChunk");
+    }
+
+    void VerifyCredits(const fs::path& dir) {
+        std::printf("créditos\n");
+        std::mt19937_64 rng(11);
+        StreamRegistry reg;
+        std::string text = RandomText(rng, 100 * 1024);
+        WriteFile(dir / "credits.json", text);
+        size_t total = 0;
+        uint32_t id = reg.Open(dir / "credits.json", 4096, total);
+        size_t emitted = 0;
+        auto count = [&](uint32_t, size_t, size_t, std::wstring&&, bool) { emitted++; };
+        bool ok = reg.Read(id, 3, count) && emitted == 3;
+        ok &= reg.Read(id, 1, count) && emitted == 4;
+        Check(ok, "Read(n) produce exactamente n bloques");
+        Check(reg.OpenCount() == 1, "sin créditos no se produce nada y el stream sigue abierto");
+        ok = reg.Read(id, 0, count) && emitted == 4;
+        Check(ok, "Read(0) no produce nada");
+        reg.Read(id, 1000, count);
+        Check(emitted < 1000 && reg.OpenCount() == 0, "créditos de sobra: se para en el último bloque");
+
+        // Varios hilos leyendo el mismo stream: ningún bloque se repite ni se pierde
+        id = reg.Open(dir / "credits.json", 4096, total);
+        std::mutex m;
+        std::vector<std::pair<size_t, std::wstring>> parts;
+        std::vector<std::thread> readers;
+        for (int t = 0; t < 4; t++) {
+            readers.emplace_back([&] {
+                while (reg.Read(id, 1, [&](uint32_t, size_t done, size_t, std::wstring&& chunk, bool) {
+                    std::lock_guard<std::mutex> lock(m);
+                    parts.emplace_back(done, std::wstring(Body(chunk)));
+                })) {}
+            });
+        }
+        for (auto& t : readers) t.join();
+        std::sort(parts.begin(), parts.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+        std::wstring joined;
+        for (auto& p : parts) joined += p.second;
+        Check(joined == Utf::ToWide(text), "4 hilos leyendo el mismo stream: bloques en orden, sin repetir ni perder");
+    }
+
+    void VerifyClose(const fs::path& dir) {
+        std::printf("Close durante Read\n");
+        std::mt19937_64 rng(13);
+        std::string text = RandomText(rng, 1 << 20);
+        WriteFile(dir / "close.json", text);
+        int cut = 0, rounds = 50;
+        bool gone = true;
+        for (int round = 0; round < rounds; round++) {
+            StreamRegistry reg;
+            size_t total = 0;
+            uint32_t id = reg.Open(dir / "close.json", 4096, total);
+            std::atomic<size_t> emitted{0};
+            std::atomic<bool> started{false};
+            std::thread reader([&] {
+                reg.Read(id, 1000, [&](uint32_t, size_t, size_t, std::wstring&&, bool) {
+                    started = true;
+                    emitted++;
+                    std::this_thread::sleep_for(std::chrono::microseconds(200));
+                });
+            });
+            while (!started) std::this_thread::yield();
+            if (round % 2) reg.Close(id); else reg.CloseAll();
+            size_t atClose = emitted;
+            reader.join();
+            if (emitted <= atClose + 1 && emitted < 256) cut++;
+            gone &= !reg.Read(id, 1, [](uint32_t, size_t, size_t, std::wstring&&, bool) {});
+        }
+        Check(cut == rounds, "Close/CloseAll durante un Read: como mucho termina el bloque en curso");
+        Check(gone, "tras el Close el id ya no existe");
+
+        // Cerrar y abrir sin parar mientras otros hilos leen
+        StreamRegistry reg;
+        std::atomic<bool> stop{false};
+        std::atomic<uint32_t> last{0};
+        std::atomic<size_t> chunks{0};
+        std::vector<std::thread> readers;
+        for (int t = 0; t < 3; t++) {
+            readers.emplace_back([&] {
+                while (!stop) reg.Read(last.load(), 2, [&](uint32_t, size_t, size_t, std::wstring&&, bool) { chunks++; });
+            });
+        }
+        auto until = Clock::now() + std::chrono::milliseconds(300);
+        size_t opened = 0;
+        while (Clock::now() < until) {
+            size_t total = 0;
+            uint32_t id = reg.Open(dir / "close.json", 4096, total);
+            last = id;
+            opened++;
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+            reg.Close(id);
+        }
+        stop = true;
+        for (auto& t : readers) t.join();
+        char what[120];
+        std::snprintf(what, sizeof(what), "%zu aperturas y cierres con 3 lectores a la vez: sin streams colgados", opened);
+        Check(reg.OpenCount() == 0 && chunks > 0, what);
+    }
+
+    /** Lo mismo que hace el puente en saveFile y loadStream (WebViewManager.h). */
+    void VerifySaveThenStream(const fs::path& dir) {
+        std::printf("guardar y leer en streaming\n");
+        WriteBehindStore store(dir / "store", std::chrono::seconds(30));
+        StreamRegistry reg;
+        auto stream = [&](const std::string& pageKey, std::wstring& text) {
+            std::string key = WriteBehindStore::PageKey(pageKey);
+            if (!WriteBehindStore::IsValidKey(key)) return false;
+            if (store.IsDirty(key)) store.Flush();
+            size_t total = 0;
+            uint32_t id = reg.Open(store.PathOf(key), 0, total);
+            Received r;
+            if (!id || !Drain(reg, id, 4, r)) return false;
+            text = std::move(r.text);
+            return true;
+        };
+
+        Check(WriteBehindStore::PageKey("song") == "song.json" && WriteBehindStore::PageKey("song.json") == "song.json",
+              "PageKey: \"song\" y \"song.json\" son la misma clave");
+        store.Put(WriteBehindStore::PageKey("charts/bopeebo.json"), "{\"v\":1}");
+        std::wstring text;
+        Check(stream("charts/bopeebo", text) && text == L"{\"v\":1}", "recién guardado (ventana de 30 s): el stream ve el contenido nuevo");
+        store.Put(WriteBehindStore::PageKey("charts/bopeebo.json"), "{\"v\":2,\"ñ\":\"😀\"}");
+        Check(stream("charts/bopeebo", text) && text == L"{\"v\":2,\"ñ\":\"😀\"}", "segundo guardado de la misma clave: el stream no lee la versión vieja");
+        Check(!store.IsDirty("charts/bopeebo.json"), "tras el stream la clave ya no está sucia");
+
+        bool rejected = true;
+        for (const char* bad : { "../fuera", "../../etc/passwd", "/abs", "a/../../b", "" }) {
+            rejected &= !stream(bad, text);
+        }
+        Check(rejected, "claves con \"..\", absolutas o vacías: rechazadas");
+        Check(!fs::exists(dir / "fuera.json"), "nada se lee ni se escribe fuera de la carpeta del store");
+        store.Stop();
+    }
+
+    int Verify() {
+        fs::path dir = MakeTempDir("streambench");
+        VerifyChunks(dir);
+        VerifyCredits(dir);
+        VerifyClose(dir);
+        VerifySaveThenStream(dir);
+        std::error_code ec;
+        fs::remove_all(dir, ec);
+        std::printf(failures ? "\n%d fallos\n" : "\ntodo bien\n", failures);
+        return failures ? 1 : 0;
+    }
+
+    double Rss() {
+        Telemetry::ResourceSample s;
+        return Telemetry::SampleProcess(s) ? s.rssBytes / 1048576.0 : 0;
+    }
+
+    int Bench(size_t mb, size_t chunkKb) {
+        fs::path dir = MakeTempDir("streambench");
+        std::mt19937_64 rng(1);
+        fs::path p = dir / "big.json";
+        {
+            std::string text = RandomText(rng, mb << 20);
+            WriteFile(p, text);
+        }
+        std::printf("streambench: %zu MB de UTF-8 mixto, bloques de %zu KB\n\n", mb, chunkKb);
+        std::printf("  %-34s %10s %10s %12s\n", "", "1er bloque", "MB/s", "RSS máx (MB)");
+
+        // Stream primero: la RSS solo se mide por muestra, pero el montículo ya no vuelve a bajar
+        double base = Rss(), peak = base;
+        size_t bytes = 0;
+        std::vector<double> ttfb;
+        Clock::duration elapsed{};
+        for (int run = 0; run < 3; run++) {
+            StreamRegistry reg;
+            auto t0 = Clock::now();
+            bool first = true;
+            size_t total = 0;
+            uint32_t id = reg.Open(p, chunkKb << 10, total);
+            bool ended = false;
+            while (id && !ended) {
+                reg.Read(id, 4, [&](uint32_t, size_t done, size_t, std::wstring&& chunk, bool last) {
+                    if (first) { ttfb.push_back(Ms(Clock::now() - t0)); first = false; }
+                    bytes = done;
+                    ended = last;
+                    if (done % (4 << 20) < (chunkKb << 10)) peak = std::max(peak, Rss());
+                    (void)chunk;
+                });
+            }
+            elapsed += Clock::now() - t0;
+        }
+        std::sort(ttfb.begin(), ttfb.end());
+        std::printf("  %-34s %8.2f ms %10.0f %12.1f\n", "stream (FileStream)", ttfb[1], 3 * bytes / 1048576.0 / Seconds(elapsed), peak - base);
+
+        std::vector<double> whole;
+        double wpeak = base;
+        elapsed = {};
+        for (int run = 0; run < 3; run++) {
+            auto t0 = Clock::now();
+            std::string raw;
+            AtomicFile::ReadAll(p, raw);
+            std::wstring text;
+            Utf::AppendUtf8ToWide(text, raw);
+            whole.push_back(Ms(Clock::now() - t0));
+            elapsed += Clock::now() - t0;
+            wpeak = std::max(wpeak, Rss());
+        }
+        std::sort(whole.begin(), whole.end());
+        std::printf("  %-34s %8.2f ms %10.0f %12.1f\n", "archivo entero (ReadAll + UTF-16)", whole[1], 3 * bytes / 1048576.0 / Seconds(elapsed), wpeak - base);
+        std::printf("\n  (mediana de 3; RSS máx = pico sobre la RSS de partida, muestreada cada 4 MB)\n");
+
+        std::error_code ec;
+        fs::remove_all(dir, ec);
+        return 0;
+    }
+
+    int Run(const std::vector<std::string>& args) {
+        if (!args.empty() && args[0] == "--verify") return Verify();
+        if (!args.empty() && args[0] == "--bench") {
+            size_t mb = args.size() >= 2 ? (size_t)std::max(1, std::atoi(args[1].c_str())) : 64;
+            size_t kb = args.size() >= 3 ? (size_t)std::max(4, std::atoi(args[2].c_str())) : 256;
+            return Bench(mb, kb);
+        }
+        std::fprintf(stderr, "uso: streambench --verify | --bench [MB] [KB por bloque]\n");
+        return 2;
+    }
+}
+
+#ifdef _WIN32
+int wmain(int argc, wchar_t** argv) {
+    std::vector<std::string> args;
+    for (int i = 1; i < argc; i++) args.push_back(Utf::ToUtf8(argv[i]));
+    return Run(args);
+}
+#else
+int main(int argc, char** argv) {
+    return Run(std::vector<std::string>(argv + 1, argv + argc));
+}
+#endif
@@ -0,0 +1,354 @@
+/**
+ * tracebench - Comprueba y mide la telemetría (core/Telemetry.h).
+ *
+ * Uso:
+ *   tracebench --verify              Histogramas, anillo concurrente, muestreo, observador RPC y export a trace JSON
+ *   tracebench --bench [hilos]       Coste por evento grabado (histograma, anillo, Scope) y del export
+ *   tracebench --demo <salida.json>  Escribe un trace de ejemplo para abrir en chrome://tracing o Perfetto
+ */
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../core/AtomicFile.h"
+#include "../core/Rpc.h"
+#include "../core/RpcExecutor.h"
+#include "../core/Telemetry.h"
+#include "Tool.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+    using namespace Tool;
+
+    bool VerifyBuckets() {
+        uint64_t prevLow = 0;
+        for (size_t i = 0; i < Telemetry::Histogram::kBuckets; i++) {
+            uint64_t w, low = Telemetry::Histogram::LowerBound(i, &w);
+            if (i && low <= prevLow) return false;
+            if (Telemetry::Histogram::IndexOf(low) != i || Telemetry::Histogram::IndexOf(low + w - 1) != i) return false;
+            if (low >= Telemetry::Histogram::kSub && (double)w / low > 1.0 / Telemetry::Histogram::kHalf + 1e-12) return false;
+            prevLow = low;
+        }
+        return true;
+    }
+
+    /** Percentiles del histograma frente a los exactos (ordenando) con tiempos de frame realistas. */
+    double PercentileError() {
+        std::mt19937_64 rng(7);
+        std::lognormal_distribution<double> frame(std::log(8.3e6), 0.35);
+        std::vector<uint64_t> values(1000000);
+        Telemetry::Histogram h;
+        for (auto& v : values) { v = (uint64_t)frame(rng); h.Record(v); }
+        std::sort(values.begin(), values.end());
+        double worst = 0;
+        for (double q : { 0.01, 0.1, 0.5, 0.9, 0.99, 0.999, 1.0 }) {
+            uint64_t exact = values[(size_t)std::max(0.0, std::ceil(q * values.size()) - 1)];
+            worst = std::max(worst, std::fabs((double)h.Percentile(q) - (double)exact) / (double)exact);
+        }
+        return worst;
+    }
+
+    bool ConcurrentRecord(unsigned threads) {
+        Telemetry::Histogram h;
+        const uint64_t perThread = 500000;
+        std::vector<std::thread> pool;
+        for (unsigned t = 0; t < threads; t++)
+            pool.emplace_back([&, t] { for (uint64_t i = 1; i <= perThread; i++) h.Record(i * (t + 1)); });
+        for (auto& t : pool) t.join();
+        uint64_t expectSum = 0;
+        for (unsigned t = 0; t < threads; t++) expectSum += (t + 1) * perThread * (perThread + 1) / 2;
+        return h.Count() == perThread * threads && h.Min() == 1 && h.Max() == perThread * threads
+            && std::fabs(h.Mean() * h.Count() - (double)expectSum) < 1.0 + expectSum * 1e-12;
+    }
+
+    bool RingKeepsNewest() {
+        Telemetry::EventRing ring(4096);
+        for (uint64_t i = 0; i < 100000; i++) {
+            Telemetry::Event e;
+            e.ts = i; e.dur = i * 3; e.name = (uint32_t)(i % 17);
+            ring.Push(e);
+        }
+        std::vector<Telemetry::Event> out;
+        if (ring.Snapshot(out) != 0 || out.size() != 4096) return false;
+        for (size_t i = 0; i < out.size(); i++) {
+            uint64_t idx = 100000 - 4096 + i;
+            if (out[i].ts != idx || out[i].dur != idx * 3 || out[i].name != idx % 17) return false;
+        }
+        return true;
+    }
+
+    /**
+     * Varios productores mientras otro hilo hace Snapshot: ningún evento puede salir mezclado.
+     * Cada evento lleva en dur un valor derivado de ts, tid y name.
+     */
+    bool RingTornReads(unsigned writers, size_t& seen, size_t& skipped) {
+        Telemetry::EventRing ring(1024);
+        std::atomic<bool> stop{false};
+        std::vector<std::thread> pool;
+        for (unsigned t = 0; t < writers; t++)
+            pool.emplace_back([&, t] {
+                for (uint64_t i = 0; !stop.load(std::memory_order_relaxed); i++) {
+                    Telemetry::Event e;
+                    e.ts = i; e.tid = t + 2; e.name = (uint32_t)(i & 0xFFFF);
+                    e.dur = (i * 0x9E3779B97F4A7C15ull) ^ e.tid ^ ((uint64_t)e.name << 40);
+                    ring.Push(e);
+                }
+            });
+        bool ok = true;
+        seen = skipped = 0;
+        auto end = Clock::now() + std::chrono::milliseconds(400);
+        std::vector<Telemetry::Event> out;
+        while (Clock::now() < end) {
+            out.clear();
+            skipped += ring.Snapshot(out);
+            seen += out.size();
+            for (const auto& e : out)
+                ok = ok && e.dur == ((e.ts * 0x9E3779B97F4A7C15ull) ^ e.tid ^ ((uint64_t)e.name << 40)) && e.name == (e.ts & 0xFFFF);
+        }
+        stop = true;
+        for (auto& t : pool) t.join();
+        return ok;
+    }
+
+    struct Ctx {};
+
+    Telemetry::Hub* observed = nullptr;
+    Telemetry::Hub::Series* rpcSeries[RpcDispatcher<Ctx>::kMaxRoutes] = {};
+    RpcDispatcher<Ctx>* observedRoutes = nullptr;
+
+    void Observe(const RpcDispatcher<Ctx>::Route& r, uint64_t, uint64_t start, uint64_t end) {
+        if (auto* s = rpcSeries[observedRoutes->IndexOf(r)]) observed->Complete(*s, start, end);
+    }
+
+    bool VerifyRpcObserver(Telemetry::Hub& hub) {
+        RpcDispatcher<Ctx> d;
+        d.Register(L"echo", [](Ctx&, const RpcRequest& req, std::wstring& out) { out.assign(req.payload); return true; });
+        d.Register(L"slow", [](Ctx&, const RpcRequest&, std::wstring&) { std::this_thread::sleep_for(std::chrono::milliseconds(2)); return true; }, {}, false, RpcMode::Pool);
+        observed = &hub;
+        observedRoutes = &d;
+        rpcSeries[d.IndexOf(*d.Find(L"echo"))] = hub.Get("rpc.echo");
+        rpcSeries[d.IndexOf(*d.Find(L"slow"))] = hub.Get("rpc.slow");
+        d.SetObserver(Observe);
+
+        TaskPool pool(2);
+        std::atomic<int> woken{0};
+        RpcExecutor<Ctx> exec(pool, 8, [&] { woken++; });
+        exec.Attach(d);
+        Ctx ctx;
+        d.Dispatch(ctx, L"#1|1|echo|2|hi2|slow|0|", [](const std::wstring&) {});
+        auto end = Clock::now() + std::chrono::seconds(2);
+        while (woken == 0 && Clock::now() < end) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        pool.Shutdown();
+        auto* slow = hub.Get("rpc.slow");
+        return hub.Get("rpc.echo")->hist.Count() == 1 && slow->hist.Count() == 1 && slow->hist.Min() >= 2000000;
+    }
+
+    bool VerifyTrace(Telemetry::Hub& hub, std::string& why) {
+        hub.NameThread("main");
+        auto* frame = hub.Get("page.frame");
+        auto* load = hub.Get("native.load");
+        uint32_t mark = hub.Intern("native.mark \"quoted\"");
+        double epochNow = (double)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count() / 1000.0;
+        for (int i = 0; i < 10; i++) {
+            uint64_t at = hub.FromEpochMs(epochNow + i * 16.6);
+            hub.Complete(*frame, at, at + (uint64_t)(16.6e6 + i * 1e5), Telemetry::Hub::kPageThread);
+        }
+        { Telemetry::Scope s(hub, load); std::this_thread::sleep_for(std::chrono::milliseconds(1)); }
+        hub.Instant(mark);
+        hub.Counter(hub.Intern("process.rssMB"), 123.5);
+
+        std::string out;
+        hub.WriteTrace(out);
+        Json::Value v;
+        std::string err;
+        if (!Json::Parse(out, v, &err)) { why = "invalid json: " + err; return false; }
+        const auto& events = v["traceEvents"];
+        int complete = 0, counters = 0, instants = 0, pageFrames = 0;
+        bool namedMain = false, namedPage = false;
+        double lastTs = -1;
+        for (const auto& e : events.Items()) {
+            std::string ph = e["ph"].Str();
+            if (ph == "M") {
+                namedMain = namedMain || e["args"]["name"].Str() == "main";
+                namedPage = namedPage || (e["args"]["name"].Str() == "page" && e["tid"].Int() == 1);
+                continue;
+            }
+            double ts = e["ts"].Num(-1);
+            if (ts < lastTs) { why = "events out of order"; return false; }
+            lastTs = ts;
+            if (ph == "X") {
+                complete++;
+                if (e["name"].Str() == "page.frame") {
+                    pageFrames++;
+                    if (e["cat"].Str() != "page" || e["dur"].Num() < 16600) { why = "bad page frame"; return false; }
+                }
+            }
+            if (ph == "C") counters += e["args"]["value"].Num() == 123.5;
+            if (ph == "i") instants += e["name"].Str() == "native.mark \"quoted\"";
+        }
+        if (pageFrames != 10 || complete < 11 || counters != 1 || instants != 1) { why = "missing events"; return false; }
+        if (!namedMain || !namedPage) { why = "missing thread names"; return false; }
+        const auto& summary = v["otherData"]["series"]["page.frame"];
+        if (summary["count"].Int() != 10 || summary["p50"].Num() < 16.6 || summary["max"].Num() > 17.6) { why = "bad summary"; return false; }
+        Json::Value stats;
+        Telemetry::ResourceSample s;
+        Telemetry::SampleProcess(s);
+        if (!Json::Parse(hub.StatsJson(&s), stats) || stats["series"]["native.load"]["count"].Int() != 1 || stats["process"]["threads"].Int() < 1) {
+            why = "bad stats json";
+            return false;
+        }
+        return true;
+    }
+
+    int Verify() {
+        std::printf("tracebench --verify\n");
+        Check(VerifyBuckets(), "cubetas contiguas, monótonas y con ancho <= 1/64 del valor");
+        double err = PercentileError();
+        std::printf("         error máximo de percentil: %.3f%%\n", err * 100);
+        Check(err <= 1.0 / 64, "percentiles dentro del 1.6% de los exactos");
+        Check(ConcurrentRecord(4), "4 hilos grabando: cuenta, suma, mínimo y máximo exactos");
+        Check(RingKeepsNewest(), "el anillo conserva los últimos N en orden");
+        size_t seen, skipped;
+        Check(RingTornReads(3, seen, skipped), "snapshots concurrentes sin eventos mezclados");
+        std::printf("         %zu eventos leídos, %zu descartados por estar en escritura\n", seen, skipped);
+
+        Telemetry::Hub hub;
+        {
+            Telemetry::Sampler sampler(hub);
+            sampler.Start(std::chrono::milliseconds(20));
+            std::vector<char> burn(64 << 20, 1); // Fuerza RSS y algo de CPU
+            volatile uint64_t acc = 0;
+            // Hasta que una muestra vea el trabajo (con la CPU repartida entre otras pruebas tarda más)
+            auto start = Clock::now(), end = start + std::chrono::seconds(3);
+            Telemetry::ResourceSample s;
+            do {
+                for (size_t i = 0; i < burn.size(); i += 4096) acc = acc + burn[i];
+                s = sampler.Latest();
+            } while (Clock::now() < end && (Clock::now() - start < std::chrono::milliseconds(150) || !(s.ok && s.cpuPercent > 10)));
+            std::printf("         rss %.1f MB, cpu %.0f%%, %u hilos, %u handles (%llu muestras)\n",
+                s.rssBytes / 1048576.0, s.cpuPercent, s.threads, s.handles, (unsigned long long)sampler.Samples());
+            Check(s.ok && s.rssBytes >= (64u << 20) && s.threads >= 2 && s.handles >= 3 && s.cpuPercent > 10, "muestras de RSS, CPU, hilos y handles");
+            auto t0 = Clock::now();
+            sampler.Stop();
+            Check(std::chrono::duration<double, std::milli>(Clock::now() - t0).count() < 15, "Stop del muestreo sin esperar al tick");
+            Check(sampler.Samples() >= 3, "el muestreo corre en su intervalo");
+        }
+        Check(VerifyRpcObserver(hub), "observador RPC: rutas Inline y Pool medidas");
+        std::string why;
+        bool traceOk = VerifyTrace(hub, why);
+        if (!traceOk) std::fprintf(stderr, "  trace: %s\n", why.c_str());
+        Check(traceOk, "trace JSON válido: hilos, fases, orden, marcas de la página y resúmenes");
+        std::printf("tracebench: %d fallos\n", failures);
+        return failures ? 1 : 0;
+    }
+
+    template <typename Fn>
+    double NsPerOp(unsigned threads, uint64_t perThread, Fn fn) {
+        std::vector<std::thread> pool;
+        std::atomic<unsigned> ready{0};
+        std::atomic<bool> go{false};
+        for (unsigned t = 0; t < threads; t++)
+            pool.emplace_back([&, t] {
+                ready++;
+                while (!go) std::this_thread::yield();
+                for (uint64_t i = 0; i < perThread; i++) fn(t, i);
+            });
+        while (ready < threads) std::this_thread::yield();
+        auto t0 = Clock::now();
+        go = true;
+        for (auto& t : pool) t.join();
+        return std::chrono::duration<double, std::nano>(Clock::now() - t0).count() / (double)(perThread * threads) * threads;
+    }
+
+    int Bench(unsigned threads) {
+        const uint64_t n = 4000000;
+        Telemetry::Hub hub(1u << 16);
+        auto* series = hub.Get("bench.scope");
+        Telemetry::Histogram h;
+        std::printf("tracebench: ns por evento (1 hilo / %u hilos, por hilo)\n", threads);
+        for (unsigned t : { 1u, threads }) {
+            double now = NsPerOp(t, n, [](unsigned, uint64_t) { volatile uint64_t x = Telemetry::NowNs(); (void)x; });
+            double rec = NsPerOp(t, n, [&](unsigned, uint64_t i) { h.Record(i * 977 + 1000); });
+            double push = NsPerOp(t, n, [&](unsigned tid, uint64_t i) { hub.Complete(*series, i, i + 100, tid); });
+            double scope = NsPerOp(t, n, [&](unsigned, uint64_t) { Telemetry::Scope s(hub, series); });
+            std::printf("  %u hilo(s): NowNs %.1f  Histogram::Record %.1f  Complete %.1f  Scope %.1f\n", t, now, rec, push, scope);
+        }
+        auto p0 = Clock::now();
+        volatile uint64_t sink = 0;
+        for (int i = 0; i < 1000; i++) sink = sink + h.Percentile(0.99);
+        double pct = std::chrono::duration<double, std::micro>(Clock::now() - p0).count() / 1000;
+
+        std::string trace;
+        auto e0 = Clock::now();
+        hub.WriteTrace(trace);
+        double exportMs = std::chrono::duration<double, std::milli>(Clock::now() - e0).count();
+
+        Telemetry::ResourceSample s;
+        auto s0 = Clock::now();
+        for (int i = 0; i < 200; i++) Telemetry::SampleProcess(s);
+        double sampleUs = std::chrono::duration<double, std::micro>(Clock::now() - s0).count() / 200;
+
+        std::printf("  Percentile: %.1f us   SampleProcess: %.1f us\n", pct, sampleUs);
+        std::printf("  WriteTrace: %zu eventos -> %.2f MB en %.1f ms\n", hub.Ring().Capacity(), trace.size() / 1048576.0, exportMs);
+        return 0;
+    }
+
+    int Demo(const fs::path& out) {
+        Telemetry::Hub hub;
+        Telemetry::Sampler sampler(hub);
+        sampler.Start(std::chrono::milliseconds(10));
+        hub.NameThread("main");
+        auto* frame = hub.Get("page.frame");
+        auto* work = hub.Get("native.work");
+        double epoch = (double)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count() / 1000.0;
+        for (int i = 0; i < 60; i++) {
+            double dur = i % 20 == 19 ? 48.0 : 16.6;
+            uint64_t at = hub.FromEpochMs(epoch + i * 16.6);
+            hub.Complete(*frame, at, at + (uint64_t)(dur * 1e6), Telemetry::Hub::kPageThread);
+            Telemetry::Scope s(hub, work);
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+        sampler.Stop();
+        std::string json, err;
+        hub.WriteTrace(json);
+        if (!AtomicFile::Write(out, json, err)) { std::fprintf(stderr, "tracebench: %s\n", err.c_str()); return 1; }
+        std::printf("%s: %zu bytes\n", out.u8string().c_str(), json.size());
+        return 0;
+    }
+
+    void Usage() {
+        std::fprintf(stderr,
+            "Uso:\n"
+            "  tracebench --verify\n"
+            "  tracebench --bench [hilos]\n"
+            "  tracebench --demo <salida.json>\n");
+    }
+
+    int Run(const std::vector<fs::path>& args) {
+        if (args.empty()) { Usage(); return 1; }
+        std::string cmd = args[0].u8string();
+        if (cmd == "--verify") return Verify();
+        if (cmd == "--bench") {
+            unsigned threads = args.size() >= 2 ? (unsigned)std::max(1, std::atoi(args[1].u8string().c_str())) : std::max(2u, std::thread::hardware_concurrency());
+            return Bench(threads);
+        }
+        if (cmd == "--demo" && args.size() >= 2) return Demo(args[1]);
+        Usage();
+        return 1;
+    }
+}
+
+#ifdef _WIN32
+int wmain(int argc, wchar_t** argv) { return Run(std::vector<fs::path>(argv + 1, argv + argc)); }
+#else
+int main(int argc, char** argv) { return Run(std::vector<fs::path>(argv + 1, argv + argc)); }
+#endif
@@ -0,0 +1,370 @@
+/**
+ * utfbench - Comprueba y mide el transcodificador UTF-8 <-> UTF-16/UTF-32 (core/Utf.h).
+ *
+ * Uso:
+ *   utfbench --verify [iteraciones] [semilla]   Casos conocidos y fuzzing contra una implementación de referencia
+ *   utfbench --bench [MB]                       MB/s por dirección y tipo de texto, frente a la referencia
+ *
+ * La ruta UTF-16 (la de Windows) se prueba con char16_t, así que todo corre también en Linux.
+ * Compilar con -DGENESIS_UTF_SCALAR prueba la ruta escalar y con -mavx2 la de AVX2.
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+#include "../core/Utf.h"
+#include "Tool.h"
+
+namespace {
+
+    using namespace Tool;
+
+    // --- Referencia: code point a code point, sin atajos ---
+
+    namespace Ref {
+
+        /** Decodificador según la tabla 3-7 de Unicode; misma política de avance que Utf::DecodeUtf8. */
+        char32_t Decode(const unsigned char* s, size_t n, size_t& i, bool& valid) {
+            unsigned char c = s[i];
+            valid = true;
+            if (c < 0x80) { i++; return c; }
+            int len = 0;
+            unsigned char lo = 0x80, hi = 0xBF;
+            if (c >= 0xC2 && c <= 0xDF) len = 2;
+            else if (c == 0xE0) { len = 3; lo = 0xA0; }
+            else if (c >= 0xE1 && c <= 0xEC) len = 3;
+            else if (c == 0xED) { len = 3; hi = 0x9F; }
+            else if (c >= 0xEE && c <= 0xEF) len = 3;
+            else if (c == 0xF0) { len = 4; lo = 0x90; }
+            else if (c >= 0xF1 && c <= 0xF3) len = 4;
+            else if (c == 0xF4) { len = 4; hi = 0x8F; }
+            valid = false;
+            if (len == 0 || i + len > n) { i++; return Utf::kReplacement; }
+            // Una continuación que falla corta la secuencia ahí; fuera de rango consume la secuencia entera
+            for (int k = 1; k < len; k++)
+                if ((s[i + k] & 0xC0) != 0x80) { i += k; return Utf::kReplacement; }
+            bool inRange = s[i + 1] >= lo && s[i + 1] <= hi;
+            char32_t cp = c & (0x7F >> len);
+            for (int k = 1; k < len; k++) cp = (cp << 6) | (s[i + k] & 0x3F);
+            i += len;
+            if (!inRange) return Utf::kReplacement;
+            valid = true;
+            return cp;
+        }
+
+        template <typename W>
+        std::basic_string<W> ToWide(const std::string& s, bool* allValid = nullptr) {
+            std::basic_string<W> out;
+            const unsigned char* u = (const unsigned char*)s.data();
+            size_t i = 0;
+            bool ok = true;
+            while (i < s.size()) {
+                bool valid;
+                char32_t cp = Decode(u, s.size(), i, valid);
+                ok = ok && valid;
+                if (sizeof(W) == 2 && cp >= 0x10000) {
+                    out += (W)(0xD800 + ((cp - 0x10000) >> 10));
+                    out += (W)(0xDC00 + ((cp - 0x10000) & 0x3FF));
+                } else {
+                    out += (W)cp;
+                }
+            }
+            if (allValid) *allValid = ok;
+            return out;
+        }
+
+        template <typename W>
+        std::string ToUtf8(const std::basic_string<W>& w) {
+            std::string out;
+            for (size_t i = 0; i < w.size(); i++) {
+                uint32_t cp = (uint32_t)w[i];
+                if (sizeof(W) == 2) {
+                    cp &= 0xFFFF;
+                    if (cp >= 0xD800 && cp <= 0xDBFF && i + 1 < w.size() && (uint16_t)w[i + 1] >= 0xDC00 && (uint16_t)w[i + 1] <= 0xDFFF)
+                        cp = 0x10000 + ((cp - 0xD800) << 10) + ((uint16_t)w[++i] - 0xDC00);
+                }
+                if ((cp >= 0xD800 && cp <= 0xDFFF) || cp > 0x10FFFF) cp = Utf::kReplacement;
+                if (cp < 0x80) out += (char)cp;
+                else if (cp < 0x800) { out += (char)(0xC0 | (cp >> 6)); out += (char)(0x80 | (cp & 0x3F)); }
+                else if (cp < 0x10000) { out += (char)(0xE0 | (cp >> 12)); out += (char)(0x80 | ((cp >> 6) & 0x3F)); out += (char)(0x80 | (cp & 0x3F)); }
+                else { out += (char)(0xF0 | (cp >> 18)); out += (char)(0x80 | ((cp >> 12) & 0x3F)); out += (char)(0x80 | ((cp >> 6) & 0x3F)); out += (char)(0x80 | (cp & 0x3F)); }
+            }
+            return out;
+        }
+    }
+
+    // --- Generadores ---
+
+    void PutUtf8(std::string& s, char32_t cp) {
+        if (cp < 0x80) s += (char)cp;
+        else if (cp < 0x800) { s += (char)(0xC0 | (cp >> 6)); s += (char)(0x80 | (cp & 0x3F)); }
+        else if (cp < 0x10000) { s += (char)(0xE0 | (cp >> 12)); s += (char)(0x80 | ((cp >> 6) & 0x3F)); s += (char)(0x80 | (cp & 0x3F)); }
+        else { s += (char)(0xF0 | (cp >> 18)); s += (char)(0x80 | ((cp >> 12) & 0x3F)); s += (char)(0x80 | ((cp >> 6) & 0x3F)); s += (char)(0x80 | (cp & 0x3F)); }
+    }
+
+    /** Code point válido repartido entre los cuatro tamaños (sin sustitutos). */
+    char32_t RandomScalar(std::mt19937_64& rng) {
+        switch (rng() % 4) {
+            case 0: return (char32_t)(rng() % 0x80);
+            case 1: return (char32_t)(0x80 + rng() % (0x800 - 0x80));
+            case 2: { char32_t cp = (char32_t)(0x800 + rng() % (0x10000 - 0x800)); return (cp >= 0xD800 && cp <= 0xDFFF) ? 0xFFFD : cp; }
+            default: return (char32_t)(0x10000 + rng() % (0x110000 - 0x10000));
+        }
+    }
+
+    /**
+     * UTF-8 con tramos ASCII de longitud variable (para cruzar los bloques de 16/32 bytes),
+     * texto multibyte válido y, si `broken`, basura: bytes sueltos, secuencias cortadas,
+     * formas largas, sustitutos codificados y valores por encima de U+10FFFF.
+     */
+    std::string RandomUtf8(std::mt19937_64& rng, size_t target, bool broken) {
+        std::string s;
+        while (s.size() < target) {
+            unsigned kind = (unsigned)(rng() % (broken ? 10 : 6));
+            if (kind < 3) {
+                size_t run = (size_t)(rng() % 48);
+                for (size_t k = 0; k < run; k++) s += (char)(0x20 + rng() % 0x5F);
+            } else if (kind < 6) {
+                size_t run = 1 + (size_t)(rng() % 8);
+                for (size_t k = 0; k < run; k++) PutUtf8(s, RandomScalar(rng));
+            } else if (kind == 6) {
+                s += (char)(0x80 + rng() % 0x80);
+            } else if (kind == 7) {
+                std::string seq; PutUtf8(seq, 0x80 + (char32_t)(rng() % 0x10FF80));
+                if (seq.size() > 1) seq.resize(1 + rng() % (seq.size() - 1));
+                s += seq;
+            } else if (kind == 8) {
+                static const char* kBad[] = { "\xC0\xAF", "\xC1\xBF", "\xE0\x80\xAF", "\xE0\x9F\xBF", "\xED\xA0\x80", "\xED\xBF\xBF",
+                                              "\xF0\x80\x80\xAF", "\xF0\x8F\xBF\xBF", "\xF4\x90\x80\x80", "\xF5\x80\x80\x80", "\xFE", "\xFF" };
+                s += kBad[rng() % 12];
+            } else {
+                s += (char)(rng() & 0xFF);
+            }
+        }
+        return s;
+    }
+
+    /** Unidades UTF-16/UTF-32 con ASCII, BMP, pares de sustitutos, sustitutos sueltos y (UTF-32) valores fuera de rango. */
+    template <typename W>
+    std::basic_string<W> RandomWide(std::mt19937_64& rng, size_t target) {
+        std::basic_string<W> w;
+        while (w.size() < target) {
+            unsigned kind = (unsigned)(rng() % 8);
+            if (kind < 3) {
+                size_t run = (size_t)(rng() % 40);
+                for (size_t k = 0; k < run; k++) w += (W)(0x20 + rng() % 0x5F);
+            } else if (kind < 6) {
+                char32_t cp = RandomScalar(rng);
+                if (sizeof(W) == 2 && cp >= 0x10000) { w += (W)(0xD800 + ((cp - 0x10000) >> 10)); w += (W)(0xDC00 + ((cp - 0x10000) & 0x3FF)); }
+                else w += (W)cp;
+            } else if (kind == 6) {
+                w += (W)(0xD800 + rng() % 0x800);
+            } else if (sizeof(W) == 4) {
+                static const uint32_t kOut[] = { 0x110000, 0x7FFFFFFF, 0x80000000, 0xFFFFFFFF };
+                w += (W)kOut[rng() % 4];
+            } else {
+                w += (W)(rng() & 0xFFFF);
+            }
+        }
+        return w;
+    }
+
+    // --- Comprobaciones ---
+
+    template <typename W>
+    bool SameAsReference(const std::string& s) {
+        bool valid;
+        std::basic_string<W> ref = Ref::ToWide<W>(s, &valid);
+        if (Utf::WideLength<W>(s.data(), s.size()) != ref.size()) return false;
+        if (Utf::IsValidUtf8(s.data(), s.size()) != valid) return false;
+        std::basic_string<W> raw(ref.size() + 1, (W)0x7777);
+        if (Utf::Utf8ToWide(s.data(), s.size(), &raw[0]) != ref.size() || raw.compare(0, ref.size(), ref) != 0 || raw.back() != (W)0x7777) return false;
+        std::basic_string<W> appended(3, (W)'x');
+        Utf::AppendUtf8ToWide(appended, s.data(), s.size());
+        if (appended.compare(0, 3, std::basic_string<W>(3, (W)'x')) != 0 || appended.compare(3, std::basic_string<W>::npos, ref) != 0) return false;
+        return !valid || Utf::ToUtf8(std::wstring(Utf::ToWide(s))) == s;
+    }
+
+    template <typename W>
+    bool WideSameAsReference(const std::basic_string<W>& w) {
+        std::string ref = Ref::ToUtf8(w);
+        if (Utf::Utf8Length(w.data(), w.size()) != ref.size()) return false;
+        std::string raw(ref.size() + 1, '#');
+        if (Utf::WideToUtf8(w.data(), w.size(), &raw[0]) != ref.size() || raw.compare(0, ref.size(), ref) != 0 || raw.back() != '#') return false;
+        std::string appended = "ab";
+        Utf::AppendWideToUtf8(appended, w.data(), w.size());
+        return appended == "ab" + ref;
+    }
+
+    bool KnownVectors() {
+        struct Case { const char* utf8; size_t n; std::u16string utf16; bool valid; };
+        const Case cases[] = {
+            { "", 0, u"", true },
+            { "abc", 3, u"abc", true },
+            { "\xC3\xB1", 2, u"ñ", true },
+            { "\xE2\x82\xAC", 3, u"€", true },
+            { "\xEF\xBF\xBD", 3, u"�", true },                         // U+FFFD legítimo
+            { "\xF0\x9F\x8E\xB5", 4, u"\U0001F3B5", true },
+            { "\xF4\x8F\xBF\xBF", 4, u"\U0010FFFF", true },
+            { "a\xFF" "b", 3, u"a�b", false },
+            { "\xC0\xAF", 2, u"��", false },                      // C0 nunca es inicio
+            { "\xE0\x80\xAF", 3, u"�", false },                        // forma larga de 3 bytes
+            { "\xED\xA0\x80", 3, u"�", false },                        // sustituto codificado
+            { "\xF4\x90\x80\x80", 4, u"�", false },                    // > U+10FFFF
+            { "\xE2\x82", 2, u"��", false },                      // cortada al final
+            { "\xE2\x82x", 3, u"�x", false },                         // cortada en medio
+            { "\xF0\x9F\x8E", 3, u"���", false },
+        };
+        for (const Case& c : cases) {
+            std::string s(c.utf8, c.n);
+            std::u16string got;
+            Utf::AppendUtf8ToWide(got, s.data(), s.size());
+            if (got != c.utf16 || Utf::IsValidUtf8(s.data(), s.size()) != c.valid || Ref::ToWide<char16_t>(s) != c.utf16) {
+                std::printf("    caso \"%s\" no coincide\n", s.c_str());
+                return false;
+            }
+        }
+        // Sustitutos sueltos y pares invertidos hacia UTF-8
+        std::u16string lone = u"a";
+        lone += (char16_t)0xDC00; lone += (char16_t)0xD800; lone += u"b";
+        std::string enc; Utf::AppendWideToUtf8(enc, lone.data(), lone.size());
+        return enc == "a\xEF\xBF\xBD\xEF\xBF\xBD" "b";
+    }
+
+    /** Cada longitud y cada desalineación del puntero de entrada, para cubrir las colas de los bloques. */
+    bool Boundaries() {
+        std::string base;
+        for (int i = 0; i < 80; i++) base += (char)('a' + i % 26);
+        for (size_t len = 0; len <= 70; len++) {
+            for (size_t off = 0; off < 8; off++) {
+                for (size_t pos = 0; pos <= len; pos += 5) {
+                    std::string s = base.substr(off, len);
+                    s.insert(std::min(pos, s.size()), "\xC3\xB1\xF0\x9F\x8E\xB5");
+                    std::string shifted = std::string(off, 'z') + s;
+                    std::string view(shifted.data() + off, s.size());
+                    if (!SameAsReference<char16_t>(view) || !SameAsReference<char32_t>(view)) return false;
+                    std::u16string w16 = Ref::ToWide<char16_t>(view);
+                    std::u32string w32 = Ref::ToWide<char32_t>(view);
+                    if (!WideSameAsReference(w16) || !WideSameAsReference(w32)) return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    int Verify(uint64_t iterations, uint64_t seed) {
+        std::printf("casos conocidos\n");
+        Check(KnownVectors(), "secuencias válidas, inválidas y cortadas");
+        Check(Boundaries(), "todas las longitudes 0..70 y desalineaciones 0..7");
+
+        std::printf("fuzzing (%llu iteraciones, semilla %llu)\n", (unsigned long long)iterations, (unsigned long long)seed);
+        std::mt19937_64 rng(seed);
+        uint64_t bad8 = 0, bad16 = 0, bad32 = 0, badW16 = 0, badW32 = 0, firstBad = UINT64_MAX;
+        for (uint64_t it = 0; it < iterations; it++) {
+            size_t size = (size_t)(rng() % (it % 16 == 0 ? 4096 : 200));
+            std::string s = RandomUtf8(rng, size, it % 3 != 0);
+            uint64_t before = bad8 + bad16 + bad32 + badW16 + badW32;
+            bad16 += !SameAsReference<char16_t>(s);
+            bad32 += !SameAsReference<char32_t>(s);
+            bad8 += !SameAsReference<wchar_t>(s);
+            badW16 += !WideSameAsReference(RandomWide<char16_t>(rng, size));
+            badW32 += !WideSameAsReference(RandomWide<char32_t>(rng, size));
+            if (firstBad == UINT64_MAX && bad8 + bad16 + bad32 + badW16 + badW32 != before) firstBad = it;
+        }
+        if (firstBad != UINT64_MAX) std::printf("    primera diferencia en la iteración %llu\n", (unsigned long long)firstBad);
+        Check(bad16 == 0, "UTF-8 -> UTF-16 (longitud, conversión, append, validación)");
+        Check(bad32 == 0, "UTF-8 -> UTF-32");
+        Check(bad8 == 0, "UTF-8 -> wchar_t e ida y vuelta");
+        Check(badW16 == 0, "UTF-16 -> UTF-8 (sustitutos sueltos incluidos)");
+        Check(badW32 == 0, "UTF-32 -> UTF-8 (valores fuera de Unicode incluidos)");
+
+#if defined(GENESIS_UTF_AVX2)
+        std::printf("\nruta: AVX2\n");
+#elif defined(GENESIS_UTF_SSE2)
+        std::printf("\nruta: SSE2\n");
+#else
+        std::printf("\nruta: escalar\n");
+#endif
+        std::printf(failures ? "%d fallos\n" : "todo bien\n", failures);
+        return failures ? 1 : 0;
+    }
+
+    // --- Benchmark ---
+
+    template <typename Fn>
+    double MBps(size_t bytes, size_t totalBytes, Fn&& fn) {
+        size_t reps = std::max<size_t>(1, totalBytes / std::max<size_t>(bytes, 1));
+        fn(); // calentamiento
+        auto t0 = Clock::now();
+        for (size_t r = 0; r < reps; r++) fn();
+        double s = std::chrono::duration<double>(Clock::now() - t0).count();
+        return (double)bytes * reps / s / 1e6;
+    }
+
+    template <typename W>
+    void BenchText(const char* label, const std::string& text, size_t total) {
+        std::basic_string<W> wide = Ref::ToWide<W>(text);
+        std::basic_string<W> wbuf;
+        std::string nbuf;
+        size_t sink = 0;
+        double refTo = MBps(text.size(), total, [&] { sink += Ref::ToWide<W>(text).size(); });
+        double newTo = MBps(text.size(), total, [&] { wbuf.clear(); Utf::AppendUtf8ToWide(wbuf, text.data(), text.size()); sink += wbuf.size(); });
+        double refFrom = MBps(text.size(), total, [&] { sink += Ref::ToUtf8(wide).size(); });
+        double newFrom = MBps(text.size(), total, [&] { nbuf.clear(); Utf::AppendWideToUtf8(nbuf, wide.data(), wide.size()); sink += nbuf.size(); });
+        double len = MBps(text.size(), total, [&] { sink += Utf::WideLength<W>(text.data(), text.size()); });
+        std::printf("  %-22s %-6s a wide %8.0f MB/s (ref %6.0f, x%4.1f)   a UTF-8 %8.0f MB/s (ref %6.0f, x%4.1f)   WideLength %8.0f MB/s\n",
+                    label, sizeof(W) == 2 ? "UTF-16" : "UTF-32", newTo, refTo, newTo / refTo, newFrom, refFrom, newFrom / refFrom, len);
+        if (sink == 42) std::printf(" ");
+    }
+
+    int Bench(size_t megabytes) {
+        size_t total = megabytes << 20;
+        std::mt19937_64 rng(1);
+        std::string ascii, spanish, cjk;
+        while (ascii.size() < (1u << 20)) ascii += "{\"time\":1234.5,\"lane\":2,\"length\":0,\"type\":\"note\"},";
+        static const char* kWords[] = { "canción ", "ritmo ", "acción ", "pequeño ", "semana ", "él ", "mañana " };
+        while (spanish.size() < (1u << 20)) spanish += kWords[rng() % 7];
+        while (cjk.size() < (1u << 20)) PutUtf8(cjk, 0x4E00 + (char32_t)(rng() % 0x5000));
+        std::printf("utfbench: %zu MB por caso, payloads de 1 MB (ruta %s)\n", megabytes,
+#if defined(GENESIS_UTF_AVX2)
+                    "AVX2"
+#elif defined(GENESIS_UTF_SSE2)
+                    "SSE2"
+#else
+                    "escalar"
+#endif
+        );
+        for (auto* text : { &ascii, &spanish, &cjk }) {
+            const char* label = text == &ascii ? "JSON ASCII" : text == &spanish ? "español" : "CJK";
+            BenchText<char16_t>(label, *text, total);
+            BenchText<char32_t>(label, *text, total);
+        }
+        return 0;
+    }
+
+    int Run(const std::vector<std::string>& args) {
+        if (!args.empty() && args[0] == "--verify") {
+            uint64_t iterations = args.size() >= 2 ? std::strtoull(args[1].c_str(), nullptr, 10) : 20000;
+            uint64_t seed = args.size() >= 3 ? std::strtoull(args[2].c_str(), nullptr, 10) : 12345;
+            return Verify(iterations, seed);
+        }
+        if (!args.empty() && args[0] == "--bench") return Bench(args.size() >= 2 ? (size_t)std::max(1, std::atoi(args[1].c_str())) : 256);
+        std::fprintf(stderr, "uso: utfbench --verify [iteraciones] [semilla] | --bench [MB]\n");
+        return 2;
+    }
+}
+
+#ifdef _WIN32
+int wmain(int argc, wchar_t** argv) {
+    std::vector<std::string> args;
+    for (int i = 1; i < argc; i++) args.push_back(Utf::ToUtf8(argv[i]));
+    return Run(args);
+}
+#else
+int main(int argc, char** argv) {
+    return Run(std::vector<std::string>(argv + 1, argv + argc));
+}
+#endif